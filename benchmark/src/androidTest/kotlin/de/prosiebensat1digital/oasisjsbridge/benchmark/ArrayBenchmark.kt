@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge.benchmark
+
+import androidx.benchmark.junit4.BenchmarkRule
+import androidx.benchmark.junit4.measureRepeated
+import de.prosiebensat1digital.oasisjsbridge.JsBridge
+import de.prosiebensat1digital.oasisjsbridge.JsValue
+import org.junit.After
+import org.junit.Before
+import org.junit.Rule
+import org.junit.Test
+import org.junit.runner.RunWith
+import org.junit.runners.Parameterized
+
+// Conversion of primitive arrays in both directions
+@RunWith(Parameterized::class)
+class ArrayBenchmark(private val arrayType: String, private val size: Int) {
+    companion object {
+        @JvmStatic
+        @Parameterized.Parameters(name = "{0}Array[{1}]")
+        fun parameters(): List<Array<Any>> {
+            return listOf("Boolean", "Byte", "Short", "Int", "Long", "Float", "Double").flatMap { arrayType ->
+                listOf(1_000, 1_000_000).map { size -> arrayOf<Any>(arrayType, size) }
+            }
+        }
+    }
+
+    @get:Rule
+    val benchmarkRule = BenchmarkRule()
+
+    private lateinit var jsBridge: JsBridge
+
+    @Before
+    fun setUp() {
+        jsBridge = createBenchmarkJsBridge()
+
+        val jsElement = if (arrayType == "Boolean") "i % 2 == 0" else "i % 100"
+        jsBridge.evaluateBlocking<Unit>("globalThis.benchArray = ${jsArrayOf(size, jsElement)};")
+    }
+
+    @After
+    fun tearDown() {
+        jsBridge.release()
+    }
+
+    @Test
+    fun jsToJava() {
+        val javaClass = when (arrayType) {
+            "Boolean" -> BooleanArray::class.java
+            "Byte" -> ByteArray::class.java
+            "Short" -> ShortArray::class.java
+            "Int" -> IntArray::class.java
+            "Long" -> LongArray::class.java
+            "Float" -> FloatArray::class.java
+            else -> DoubleArray::class.java
+        }
+
+        benchmarkRule.measureRepeated {
+            jsBridge.evaluateBlocking("benchArray", javaClass)
+        }
+    }
+
+    @Test
+    fun javaToJs() {
+        val jsLength = JsValue.newFunction(jsBridge, "a", "return a.length;")
+
+        val call: () -> Int = when (arrayType) {
+            "Boolean" -> {
+                val array = BooleanArray(size) { it % 2 == 0 }
+                val f = jsLength.createJavaToJsBlockingProxyFunction1<BooleanArray, Int>()
+                ({ f(array) })
+            }
+            "Byte" -> {
+                val array = ByteArray(size) { (it % 100).toByte() }
+                val f = jsLength.createJavaToJsBlockingProxyFunction1<ByteArray, Int>()
+                ({ f(array) })
+            }
+            "Short" -> {
+                val array = ShortArray(size) { (it % 100).toShort() }
+                val f = jsLength.createJavaToJsBlockingProxyFunction1<ShortArray, Int>()
+                ({ f(array) })
+            }
+            "Int" -> {
+                val array = IntArray(size) { it % 100 }
+                val f = jsLength.createJavaToJsBlockingProxyFunction1<IntArray, Int>()
+                ({ f(array) })
+            }
+            "Long" -> {
+                val array = LongArray(size) { it % 100L }
+                val f = jsLength.createJavaToJsBlockingProxyFunction1<LongArray, Int>()
+                ({ f(array) })
+            }
+            "Float" -> {
+                val array = FloatArray(size) { it % 100f }
+                val f = jsLength.createJavaToJsBlockingProxyFunction1<FloatArray, Int>()
+                ({ f(array) })
+            }
+            else -> {
+                val array = DoubleArray(size) { it % 100.0 }
+                val f = jsLength.createJavaToJsBlockingProxyFunction1<DoubleArray, Int>()
+                ({ f(array) })
+            }
+        }
+
+        benchmarkRule.measureRepeated {
+            call()
+        }
+    }
+}
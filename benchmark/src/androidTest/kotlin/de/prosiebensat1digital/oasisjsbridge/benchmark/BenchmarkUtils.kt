@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge.benchmark
+
+import androidx.test.platform.app.InstrumentationRegistry
+import de.prosiebensat1digital.oasisjsbridge.JsBridge
+import de.prosiebensat1digital.oasisjsbridge.JsBridgeConfig
+
+// Create a JsBridge with the standard config (including the Promise polyfill for Duktape)
+internal fun createBenchmarkJsBridge(): JsBridge {
+    val context = InstrumentationRegistry.getInstrumentation().targetContext
+    return JsBridge(JsBridgeConfig.standardConfig("benchmark"), context)
+}
+
+// JS expression creating an array with the given size, e.g.: jsArrayOf(3, "i * 2") -> [0, 2, 4]
+// Note: using a loop because Duktape does not support all the ES6 array methods
+internal fun jsArrayOf(size: Int, element: String): String {
+    return "(function() { var a = []; for (var i = 0; i < $size; i++) a.push($element); return a; })()"
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge.benchmark
+
+import androidx.benchmark.junit4.BenchmarkRule
+import androidx.benchmark.junit4.measureRepeated
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import de.prosiebensat1digital.oasisjsbridge.JavaToJsInterface
+import de.prosiebensat1digital.oasisjsbridge.JsBridge
+import de.prosiebensat1digital.oasisjsbridge.JsValue
+import de.prosiebensat1digital.oasisjsbridge.JsonObjectWrapper
+import org.junit.After
+import org.junit.Before
+import org.junit.Rule
+import org.junit.Test
+import org.junit.runner.RunWith
+
+// Java -> JS calls with different argument counts and Java -> JS interface registration
+@RunWith(AndroidJUnit4::class)
+class CallBenchmark {
+    interface ArgsJsApi : JavaToJsInterface {
+        fun args0(): Int
+        fun args4(a1: Int, a2: Int, a3: Int, a4: Int): Int
+        fun args16(
+            a1: Int, a2: Int, a3: Int, a4: Int, a5: Int, a6: Int, a7: Int, a8: Int,
+            a9: Int, a10: Int, a11: Int, a12: Int, a13: Int, a14: Int, a15: Int, a16: Int,
+        ): Int
+        fun jsonRoundTrip(json: JsonObjectWrapper): JsonObjectWrapper
+    }
+
+    interface LargeJsApi : JavaToJsInterface {
+        fun method00(a: Int): Int
+        fun method01(a: Int): Int
+        fun method02(a: Int): Int
+        fun method03(a: Int): Int
+        fun method04(a: Int): Int
+        fun method05(a: Int): Int
+        fun method06(a: Int): Int
+        fun method07(a: Int): Int
+        fun method08(a: Int): Int
+        fun method09(a: Int): Int
+        fun method10(a: Int): Int
+        fun method11(a: Int): Int
+        fun method12(a: Int): Int
+        fun method13(a: Int): Int
+        fun method14(a: Int): Int
+        fun method15(a: Int): Int
+        fun method16(a: Int): Int
+        fun method17(a: Int): Int
+        fun method18(a: Int): Int
+        fun method19(a: Int): Int
+        fun method20(a: Int): Int
+        fun method21(a: Int): Int
+        fun method22(a: Int): Int
+        fun method23(a: Int): Int
+        fun method24(a: Int): Int
+        fun method25(a: Int): Int
+        fun method26(a: Int): Int
+        fun method27(a: Int): Int
+        fun method28(a: Int): Int
+        fun method29(a: Int): Int
+        fun method30(a: Int): Int
+        fun method31(a: Int): Int
+    }
+
+    @get:Rule
+    val benchmarkRule = BenchmarkRule()
+
+    private lateinit var jsBridge: JsBridge
+    private lateinit var argsJsApi: ArgsJsApi
+
+    @Before
+    fun setUp() {
+        jsBridge = createBenchmarkJsBridge()
+
+        argsJsApi = JsValue(jsBridge, """({
+            args0: function() { return 0; },
+            args4: function(a1, a2, a3, a4) { return a1 + a4; },
+            args16: function(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16) { return a1 + a16; },
+            jsonRoundTrip: function(json) { return json; }
+        })""").createJavaToJsProxyBlocking(check = true)
+    }
+
+    @After
+    fun tearDown() {
+        jsBridge.release()
+    }
+
+    @Test
+    fun callJsLambda0() {
+        val jsLambda = JsValue.newFunction(jsBridge, "return 0;")
+            .createJavaToJsBlockingProxyFunction0<Int>()
+
+        benchmarkRule.measureRepeated {
+            jsLambda()
+        }
+    }
+
+    @Test
+    fun callJsLambda4() {
+        val jsLambda = JsValue.newFunction(jsBridge, "a1", "a2", "a3", "a4", "return a1 + a4;")
+            .createJavaToJsBlockingProxyFunction4<Int, Int, Int, Int, Int>()
+
+        benchmarkRule.measureRepeated {
+            jsLambda(1, 2, 3, 4)
+        }
+    }
+
+    @Test
+    fun callJsMethod0() = benchmarkRule.measureRepeated {
+        argsJsApi.args0()
+    }
+
+    @Test
+    fun callJsMethod4() = benchmarkRule.measureRepeated {
+        argsJsApi.args4(1, 2, 3, 4)
+    }
+
+    @Test
+    fun callJsMethod16() = benchmarkRule.measureRepeated {
+        argsJsApi.args16(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16)
+    }
+
+    @Test
+    fun jsonObjectWrapperRoundTrip() {
+        val json = JsonObjectWrapper("""{"key1": 1, "key2": "value2", "key3": [1, 2, 3], "key4": {"a": true}}""")
+
+        benchmarkRule.measureRepeated {
+            argsJsApi.jsonRoundTrip(json)
+        }
+    }
+
+    @Test
+    fun registerLargeJavaToJsInterface() {
+        val jsObject = JsValue(jsBridge, """(function() {
+            var o = {};
+            for (var i = 0; i < 32; i++) o["method" + (i < 10 ? "0" : "") + i] = function(a) { return a; };
+            return o;
+        })()""")
+
+        benchmarkRule.measureRepeated {
+            jsObject.createJavaToJsProxyBlocking<LargeJsApi>(check = true)
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge.benchmark
+
+import androidx.benchmark.junit4.BenchmarkRule
+import androidx.benchmark.junit4.measureRepeated
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import de.prosiebensat1digital.oasisjsbridge.JsBridge
+import de.prosiebensat1digital.oasisjsbridge.JsonObjectWrapper
+import kotlinx.coroutines.Deferred
+import kotlinx.coroutines.runBlocking
+import org.junit.After
+import org.junit.Before
+import org.junit.Rule
+import org.junit.Test
+import org.junit.runner.RunWith
+
+// Evaluation of JS code returning values of different types
+@RunWith(AndroidJUnit4::class)
+class EvaluateBenchmark {
+    @get:Rule
+    val benchmarkRule = BenchmarkRule()
+
+    private lateinit var jsBridge: JsBridge
+
+    @Before
+    fun setUp() {
+        jsBridge = createBenchmarkJsBridge()
+        jsBridge.evaluateBlocking<Unit>("""globalThis.benchJson = { key1: 1, key2: "value2", key3: [1, 2, 3], key4: { a: true } };""")
+    }
+
+    @After
+    fun tearDown() {
+        jsBridge.release()
+    }
+
+    @Test
+    fun evaluateUnit() = benchmarkRule.measureRepeated {
+        jsBridge.evaluateBlocking<Unit>("undefined")
+    }
+
+    @Test
+    fun evaluateInt() = benchmarkRule.measureRepeated {
+        jsBridge.evaluateBlocking<Int>("42")
+    }
+
+    @Test
+    fun evaluateDouble() = benchmarkRule.measureRepeated {
+        jsBridge.evaluateBlocking<Double>("4.2")
+    }
+
+    @Test
+    fun evaluateBoolean() = benchmarkRule.measureRepeated {
+        jsBridge.evaluateBlocking<Boolean>("true")
+    }
+
+    @Test
+    fun evaluateString() = benchmarkRule.measureRepeated {
+        jsBridge.evaluateBlocking<String>("'hello'")
+    }
+
+    @Test
+    fun evaluateJsonObjectWrapper() = benchmarkRule.measureRepeated {
+        jsBridge.evaluateBlocking<JsonObjectWrapper>("benchJson")
+    }
+
+    @Test
+    fun evaluateDeferred() = benchmarkRule.measureRepeated {
+        val deferred: Deferred<Int> = jsBridge.evaluateBlocking("Promise.resolve(42)")
+        runBlocking { deferred.await() }
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge.benchmark
+
+import androidx.benchmark.junit4.BenchmarkRule
+import androidx.benchmark.junit4.measureRepeated
+import de.prosiebensat1digital.oasisjsbridge.JsBridge
+import de.prosiebensat1digital.oasisjsbridge.JsValue
+import org.junit.After
+import org.junit.Before
+import org.junit.Rule
+import org.junit.Test
+import org.junit.runner.RunWith
+import org.junit.runners.Parameterized
+
+// Conversion of ASCII and non-ASCII strings in both directions
+@RunWith(Parameterized::class)
+class StringBenchmark(private val charset: String, private val length: Int) {
+    companion object {
+        @JvmStatic
+        @Parameterized.Parameters(name = "{0}[{1}]")
+        fun parameters(): List<Array<Any>> {
+            return listOf("ascii", "nonAscii").flatMap { charset ->
+                listOf(16, 1_024, 1_048_576).map { length -> arrayOf<Any>(charset, length) }
+            }
+        }
+    }
+
+    @get:Rule
+    val benchmarkRule = BenchmarkRule()
+
+    private lateinit var jsBridge: JsBridge
+    private lateinit var string: String
+
+    @Before
+    fun setUp() {
+        jsBridge = createBenchmarkJsBridge()
+
+        // Non-ASCII: mix of 2-byte, 3-byte and 4-byte (surrogate pair) UTF-8 sequences
+        val pattern = if (charset == "ascii") "abcdefgh" else "äöü€漢字😀x"
+        string = pattern.repeat(length / pattern.length + 1).substring(0, length)
+
+        JsValue.fromJavaValue(jsBridge, string).assignToGlobal("benchString")
+    }
+
+    @After
+    fun tearDown() {
+        jsBridge.release()
+    }
+
+    @Test
+    fun jsToJava() = benchmarkRule.measureRepeated {
+        jsBridge.evaluateBlocking<String>("benchString")
+    }
+
+    @Test
+    fun javaToJs() {
+        val jsLength = JsValue.newFunction(jsBridge, "s", "return s.length;")
+            .createJavaToJsBlockingProxyFunction1<String, Int>()
+
+        benchmarkRule.measureRepeated {
+            jsLength(string)
+        }
+    }
+}
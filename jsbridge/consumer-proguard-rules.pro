@@ -23,3 +23,6 @@
 # OKHTTP
 -dontwarn okhttp3.**
 
+# kotlinx.serialization is an optional dependency (see SerializableCodec)
+-dontwarn kotlinx.serialization.**
+
@@ -15,6 +15,7 @@
  */
 package de.prosiebensat1digital.oasisjsbridge
 
+import android.content.ComponentCallbacks2
 import android.content.Context
 import android.util.Log
 import androidx.test.platform.app.InstrumentationRegistry
@@ -22,15 +23,35 @@ import io.mockk.Ordering
 import io.mockk.every
 import io.mockk.mockk
 import io.mockk.verify
+import java.io.File
+import java.nio.ByteBuffer
+import java.util.concurrent.atomic.AtomicInteger
 import kotlinx.coroutines.*
+import kotlinx.coroutines.flow.asFlow
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.flow.map
+import kotlinx.coroutines.flow.onCompletion
+import kotlinx.coroutines.flow.take
+import kotlinx.coroutines.flow.toList
+import kotlinx.serialization.Serializable
+import okhttp3.MediaType.Companion.toMediaTypeOrNull
 import okhttp3.OkHttpClient
+import okhttp3.Protocol
+import okhttp3.Response
+import okhttp3.ResponseBody.Companion.asResponseBody
+import okio.Buffer
+import okio.ForwardingSource
+import okio.buffer
+import org.json.JSONObject
 import org.junit.After
 import org.junit.Assert.assertArrayEquals
 import org.junit.Assert.fail
+import org.junit.AfterClass
 import org.junit.Before
 import org.junit.BeforeClass
 import org.junit.Test
 import timber.log.Timber
+import kotlin.system.measureTimeMillis
 import kotlin.test.*
 
 interface TestJavaApiInterface : JsToJavaInterface {
@@ -95,25 +116,1066 @@ class JsBridgeTest {
         fun setUpClass() {
             Timber.plant(Timber.DebugTree())
         }
+
+        // PGO training run: the tests (including the benchmarks) are the representative workload
+        @AfterClass
+        @JvmStatic
+        fun tearDownClass() {
+            if (!BuildConfig.HAS_PGO_INSTRUMENTATION) return
+
+            val context = InstrumentationRegistry.getInstrumentation().context
+            val profileFile = File(context.filesDir, "jsbridge-${BuildConfig.FLAVOR}.profraw")
+            if (JsBridge.writeNativeProfile(profileFile.absolutePath)) {
+                Timber.i("Native profile written to ${profileFile.absolutePath}")
+            }
+        }
+    }
+
+    @Before
+    fun setUp() {
+        errors = mutableListOf()
+        unhandledPromiseErrors = mutableListOf()
+    }
+
+    @After
+    fun cleanUp() {
+        jsBridge?.let {
+            runBlocking {
+                waitForDone(it)
+                jsBridge?.release()
+                waitForDone(it)
+            }
+        }
+
+        printErrors()
+    }
+
+    @Test
+    fun testJsBridgePool() {
+        // GIVEN
+        val config = JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            xhrConfig.okHttpClient = okHttpClient
+        }
+        val subject = JsBridgePool(config, context, 1) { jsBridge ->
+            jsBridge.evaluate<Unit>("globalThis.warmValue = 42;")
+        }
+
+        // WHEN
+        val jsBridge1 = subject.acquireBlocking()
+        val jsBridge2 = subject.acquireBlocking()
+        val warmValue1: Int = jsBridge1.evaluateBlocking("warmValue")
+        val warmValue2: Int = jsBridge2.evaluateBlocking("warmValue")
+
+        jsBridge1.release()
+        jsBridge2.release()
+        subject.release()
+
+        // THEN
+        assertNotSame(jsBridge1, jsBridge2)
+        assertEquals(42, warmValue1)
+        assertEquals(42, warmValue2)
+        assertFailsWith<IllegalStateException> {
+            subject.acquireBlocking()
+        }
+    }
+
+    @Test
+    fun testJsBridgeWorkerPool() {
+        // GIVEN
+        val config = JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            xhrConfig.okHttpClient = okHttpClient
+        }
+        val subject = JsBridgeWorkerPool(config, context, 3) { jsBridge ->
+            jsBridge.evaluate<Unit>("globalThis.square = function(x) { return x * x; };")
+        }
+
+        // WHEN
+        val jsThreadNames = java.util.Collections.synchronizedSet(mutableSetOf<String>())
+        val results = runBlocking {
+            subject.map((1..30).toList()) { jsBridge, i ->
+                jsThreadNames.add(Thread.currentThread().name)
+                jsBridge.evaluate<Int>("square($i)")
+            }
+        }
+        subject.release()
+
+        // THEN
+        assertEquals((1..30).map { it * it }, results)
+        assertTrue(jsThreadNames.size in 1..3)
+        assertFailsWith<IllegalStateException> {
+            runBlocking { subject.run { 0 } }
+        }
+    }
+
+    @Test
+    fun testPostMessage() {
+        if (BuildConfig.FLAVOR == "duktape") {
+            // JS messages are only supported on QuickJS
+            return
+        }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val target = createAndSetUpJsBridge()
+
+        // WHEN
+        val (received, sharedValue) = runBlocking {
+            val jsValue = JsValue(subject, """(function() {
+                var o = { a: 1, nested: { b: "two" }, shared: new Int32Array(new SharedArrayBuffer(4)) };
+                o.self = o;
+                globalThis.sourceShared = o.shared;
+                return o;
+            })()""")
+            val receivedJsValue = subject.postMessage(jsValue, target)
+
+            val received = target.evaluate<String>("""(function(o) {
+                o.shared[0] = 42;
+                return o.a + "," + o.nested.b + "," + (o.self === o);
+            })($receivedJsValue)""")
+            received to subject.evaluate<Int>("sourceShared[0]")
+        }
+        subject.release()
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertEquals("1,two,true", received)
+        assertEquals(42, sharedValue)
+    }
+
+    @Test
+    fun testJsSharedBuffer() {
+        if (BuildConfig.FLAVOR == "duktape") {
+            // Shared buffers are only supported on QuickJS
+            return
+        }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        var invalidNotifyError: String? = null
+        val (jsNotifyCount, jsResult) = runBlocking {
+            val sharedBuffer = subject.newJsSharedBuffer(16)
+            subject.evaluate<Unit>("""(function(sab) {
+                var samples = new Int32Array(sab);
+                sab.onnotify = function() {
+                    samples[1] = samples[0] * 2;
+                    sab.notify();
+                };
+                globalThis.samples = samples;
+            })(${sharedBuffer.jsValue})""")
+            invalidNotifyError = subject.evaluate<String>("""
+                |try { ${sharedBuffer.jsValue}.notify.call(new ArrayBuffer(8)); "no error" } catch (e) { e.name }""".trimMargin())
+
+            // Kotlin -> JS: coalesced notifications
+            sharedBuffer.byteBuffer.putInt(0, 21)
+            repeat(10) { sharedBuffer.notifyJs() }
+
+            // JS -> Kotlin
+            val jsNotifyCount = withContext(Dispatchers.IO) {
+                sharedBuffer.awaitJsNotify(0, 5000L)
+            }
+            val jsResult = sharedBuffer.byteBuffer.getInt(4)
+            sharedBuffer.release()
+
+            jsNotifyCount to jsResult
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertTrue(jsNotifyCount >= 1)
+        assertEquals(42, jsResult)
+        assertEquals("TypeError", invalidNotifyError)
+        assertEquals(42, subject.evaluateBlocking<Int>("samples[1]"))
+    }
+
+    @Test
+    fun testSharedJsRuntime() {
+        // GIVEN
+        val owner = createAndSetUpJsBridge()
+        val subject = createAndSetUpJsBridge(sharedRuntimeWith = owner)
+
+        // WHEN
+        val (ownerResult, subjectResult) = runBlocking {
+            owner.evaluate<Unit>("globalThis.isolated = 'owner'; globalThis.ownerOnly = 1;")
+            subject.evaluate<Unit>("globalThis.isolated = 'subject';")
+
+            // (promise jobs of both contexts are queued in the shared runtime)
+            owner.evaluate<String>("Promise.resolve(isolated)") to subject.evaluate<String>("Promise.resolve(isolated + ':' + typeof ownerOnly)")
+        }
+
+        // Releasing the owner first: the runtime is kept alive by the other context
+        owner.release()
+        val subjectResultAfterRelease = runBlocking { subject.evaluate<String>("isolated") }
+        subject.release()
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertEquals("owner", ownerResult)
+        assertEquals("subject:undefined", subjectResult)
+        assertEquals("subject", subjectResultAfterRelease)
+    }
+
+    @Test
+    fun testSnapshot() {
+        if (BuildConfig.FLAVOR == "duktape") {
+            // JS snapshots are only supported on QuickJS
+            return
+        }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val snapshotFile = File(context.cacheDir, "testSnapshot.bin").apply { delete() }
+
+        // WHEN
+        runBlocking {
+            val jsValue = JsValue(subject, """(function() {
+                var o = { a: 1, list: [ "two", new Date(3) ] };
+                o.self = o;
+                return o;
+            })()""")
+            subject.writeSnapshot(jsValue, snapshotFile)
+        }
+        subject.release()
+
+        val restoredSubject = createAndSetUpJsBridge()
+        val restored = runBlocking {
+            val restoredJsValue = restoredSubject.readSnapshot(snapshotFile)
+            restoredSubject.evaluate<String>("""(function(o) {
+                return o.a + "," + o.list[0] + "," + o.list[1].getTime() + "," + (o.self === o);
+            })($restoredJsValue)""")
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertEquals("1,two,3,true", restored)
+    }
+
+    @Test
+    fun testWorker() {
+        if (BuildConfig.FLAVOR == "duktape") {
+            // Workers are only supported on QuickJS
+            return
+        }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            xhrConfig.okHttpClient = okHttpClient
+            workerConfig.enabled = true
+            workerConfig.scriptLoader = { url ->
+                assertEquals("square.js", url)
+                "onmessage = function(e) { postMessage({ input: e.data.value, output: e.data.value * e.data.value }); };"
+            }
+        })
+        val workerResult = CompletableDeferred<String>()
+        JsValue.createJsToJavaProxyFunction1(subject) { result: String -> workerResult.complete(result) }
+            .assignToGlobal("onWorkerResult")
+
+        // WHEN
+        subject.evaluateUnsync("""
+            var worker = new Worker("square.js");
+            worker.onmessage = function(e) {
+                onWorkerResult(e.data.input + "^2=" + e.data.output);
+                worker.terminate();
+            };
+            worker.postMessage({ value: 12 });
+        """.trimIndent())
+
+        val result = runBlocking { withTimeout(5000) { workerResult.await() } }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertEquals("12^2=144", result)
+    }
+
+    @Test
+    fun testJsEngineConfig() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            xhrConfig.okHttpClient = okHttpClient
+            jsEngineConfig.memoryLimit = 16L * 1024 * 1024
+            jsEngineConfig.gcThreshold = 4L * 1024 * 1024
+        })
+
+        // WHEN
+        val smallArrayLength: Int = subject.evaluateBlocking("new Array(1000).fill(1).length")
+        val jsException: JsException = assertFailsWith {
+            subject.evaluateBlocking<Unit>("globalThis.tooBig = new Array(64 * 1024 * 1024).fill(1);")
+        }
+        subject.runGc()
+
+        // THEN
+        assertEquals(1000, smallArrayLength)
+        val expectedMessage = if (BuildConfig.FLAVOR == "duktape") "alloc failed" else "out of memory"
+        assertEquals(true, jsException.message?.contains(expectedMessage))
+    }
+
+    @Test
+    fun testRegExpCache() {
+        if (BuildConfig.FLAVOR == "duktape") {
+            return
+        }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            xhrConfig.okHttpClient = okHttpClient
+            jsEngineConfig.regExpCacheSize = 2
+        })
+
+        // WHEN
+        // More patterns than cached entries and the same pattern with different flags
+        val result: String = subject.evaluateBlocking("""
+            var matches = [];
+            for (var i = 0; i < 10; i++) {
+              var name = "key" + (i % 3);
+              var text = "KEY0 key1 key2";
+              matches.push(text.replace(new RegExp(name, "g"), "x"));
+              matches.push(text.replace(new RegExp(name, "gi"), "y"));
+            }
+            try { new RegExp("("); } catch (e) { matches.push(e.name); }
+            matches.slice(0, 6).concat(matches.slice(-1)).join(",");
+        """)
+
+        // THEN
+        assertEquals("KEY0 key1 key2,y key1 key2,KEY0 x key2,KEY0 y key2,KEY0 key1 x,KEY0 key1 y,SyntaxError", result)
+    }
+
+    @Test
+    fun testLatin1StringBuiltins() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val text = "Hello World \u00c0\u00c9\u00ee \u00df\u00ff\u00b5 abcdefghijklmnopqrstuvwxyz0123456789"
+
+        // WHEN
+        val lowerCase: String = subject.evaluateBlocking("\"$text\".toLowerCase()")
+        val upperCase: String = subject.evaluateBlocking("\"$text\".toUpperCase()")
+        val trimmed: String = subject.evaluateBlocking("\" \\t\\u00a0$text\\n \".trim()")
+        val index: Int = subject.evaluateBlocking("\"$text\".indexOf(\"xyz0\")")
+        val includes: Boolean = subject.evaluateBlocking("\"$text\".includes(\"World \\u00e0\")")
+
+        // THEN
+        assertEquals(text.lowercase(), lowerCase)
+        assertEquals(text.uppercase(), upperCase)
+        assertEquals(text, trimmed)
+        assertEquals(text.indexOf("xyz0"), index)
+        assertFalse(includes)
+    }
+
+    @Test
+    fun testJsExecutionTimeout() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            xhrConfig.okHttpClient = okHttpClient
+            jsEngineConfig.executionTimeoutMs = 200
+        })
+
+        // WHEN
+        assertFailsWith<JsException> {
+            subject.evaluateBlocking<Unit>("try { while (true) {} } catch (e) {} while (true) {}")
+        }
+        val result: Int = subject.evaluateBlocking("1 + 2")
+
+        // THEN
+        assertEquals(3, result)
+        val timeoutError = errors.filterIsInstance<JsBridgeError.JsExecutionTimeoutError>().single()
+        assertEquals(200L, timeoutError.timeoutMs)
+    }
+
+    @Test
+    fun testJsThreadScheduling() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            xhrConfig.okHttpClient = okHttpClient
+            jsEngineConfig.jsThreadNiceValue = 5
+            jsEngineConfig.jsThreadCpuAffinityMask = 1L  // CPU 0 only
+        })
+        JsValue.createJsToJavaProxyFunction0<Int>(subject) {
+            android.os.Process.getThreadPriority(android.os.Process.myTid())
+        }.assignToGlobal("getJsThreadPriority")
+
+        // WHEN
+        val initialPriority: Int = subject.evaluateBlocking("getJsThreadPriority()")
+        runBlocking { subject.setJsThreadScheduling(niceValue = 10) }
+        val updatedPriority: Int = subject.evaluateBlocking("getJsThreadPriority()")
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertEquals(5, initialPriority)
+        assertEquals(10, updatedPriority)
+    }
+
+    @Test
+    fun testCallPriorities() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val order = java.util.Collections.synchronizedList(mutableListOf<String>())
+        val jsThreadBlocked = java.util.concurrent.CountDownLatch(1)
+        val jsThreadReleased = java.util.concurrent.CountDownLatch(1)
+
+        // WHEN
+        runBlocking {
+            subject.evaluate<Unit>("undefined")  // wait until the extensions are installed
+            subject.launch {
+                jsThreadBlocked.countDown()
+                jsThreadReleased.await()
+            }
+            jsThreadBlocked.await()
+            subject.launch(JsCallPriority.Background) { order += "background" }
+            subject.launch(JsCallPriority.Default) { order += "default" }
+            subject.launch(JsCallPriority.Interactive) { order += "interactive" }
+            jsThreadReleased.countDown()
+            withContext(JsCallPriority.Background) { subject.evaluate<Unit>("undefined") }
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertEquals(listOf("interactive", "default", "background"), order.toList())
+    }
+
+    @Test
+    fun testJsEnginePoolAllocator() {
+        listOf(true, false).forEach { poolAllocator ->
+            // GIVEN
+            val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+                xhrConfig.okHttpClient = okHttpClient
+                jsEngineConfig.poolAllocator = poolAllocator
+            })
+
+            // WHEN
+            val js = """
+                |var objects = [];
+                |for (var i = 0; i < 10000; i++) {
+                |  objects.push({ index: i, name: "object" + i, values: [i, i * 2] });
+                |}
+                |objects = objects.filter(function(o) { return o.index % 2 === 0; });
+                |var s = "";
+                |for (var i = 0; i < 1000; i++) { s += i; }
+                |objects.length + ":" + objects[4999].name + ":" + s.length
+                """.trimMargin()
+            val result: String = subject.evaluateBlocking(js)
+            val heapSizeBefore = runBlocking { subject.getJsHeapSize() }
+            subject.evaluateBlocking<Unit>("objects = null;")
+            subject.runGc()
+            val heapSizeAfter = runBlocking { subject.getJsHeapSize() }
+            subject.release()
+
+            // THEN
+            assertEquals("5000:object9998:2890", result)
+            if (poolAllocator || BuildConfig.FLAVOR == "quickjs") {
+                assertTrue(heapSizeAfter in 1 until heapSizeBefore)
+            } else {
+                assertEquals(-1L, heapSizeAfter)
+            }
+        }
+    }
+
+    @Test
+    fun testDeferredBatchCompletion() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val deferreds = List(50) { CompletableDeferred<Int>() }
+        JsValue.createJsToJavaProxyFunction1<Int, Deferred<Int>>(subject) { deferreds[it] }
+            .assignToGlobal("getDeferredValue")
+
+        // WHEN
+        val sum = runBlocking {
+            val sumDeferred = subject.evaluate<Deferred<Int>>("""
+                |var promises = [];
+                |for (var i = 0; i < 50; i++) promises.push(getDeferredValue(i));
+                |Promise.all(promises).then(function(values) {
+                |  return values.reduce(function(a, b) { return a + b; }, 0);
+                |});
+                """.trimMargin())
+
+            // Complete all the deferreds at once
+            deferreds.forEachIndexed { i, deferred -> deferred.complete(i) }
+            sumDeferred.await()
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertEquals((0 until 50).sum(), sum)
+    }
+
+    @Test
+    fun testDeferredPromiseMemoryUsage() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val deferred = CompletableDeferred<Int>()
+        JsValue.createJsToJavaProxyFunction0<Deferred<Int>>(subject) { deferred }
+            .assignToGlobal("getDeferredValue")
+
+        // WHEN
+        val (memoryUsageBefore, memoryUsagePending, memoryUsageAfter) = runBlocking {
+            val memoryUsageBefore = subject.getMemoryUsage()
+            subject.evaluate<Unit>("getDeferredValue().then(function(v) { globalThis.deferredValue = v; });")
+            val memoryUsagePending = subject.getMemoryUsage()
+            deferred.complete(42)
+            assertEquals(42, subject.evaluate<Deferred<Int>>("getDeferredValue()").await())
+            val memoryUsageAfter = subject.getMemoryUsage()
+            Triple(memoryUsageBefore, memoryUsagePending, memoryUsageAfter)
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertEquals(42, subject.evaluateBlocking<Int>("deferredValue"))
+        assertEquals(memoryUsageBefore.jsValueCount + 1, memoryUsagePending.jsValueCount)
+        assertEquals(memoryUsageBefore.jsValueCount, memoryUsageAfter.jsValueCount)
+    }
+
+    @Test
+    fun testNeverSettledPromisesToDeferred() {
+        if (BuildConfig.FLAVOR == "duktape") { return }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.bareConfig().apply {
+            jvmConfig.maxJniGlobalRefs = 200
+        })
+
+        // WHEN
+        val (memoryUsageBefore, memoryUsageAfter) = runBlocking {
+            val memoryUsageBefore = subject.getMemoryUsage()
+            repeat(2000) {
+                // The Java Deferred is held by the reaction handlers of the (dropped) promise
+                subject.evaluate<Deferred<Int>>("new Promise(function() {})")
+            }
+            memoryUsageBefore to subject.getMemoryUsage()
+        }
+
+        // THEN
+        assertTrue(memoryUsageAfter.jniGlobalRefCount < memoryUsageBefore.jniGlobalRefCount + 1000)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testSettledPromiseToDeferred() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val (fulfilledDeferred, rejectedDeferred, pendingDeferred) = runBlocking {
+            Triple(
+                subject.evaluate<Deferred<Int>>("Promise.resolve(42)"),
+                subject.evaluate<Deferred<Int>>("Promise.reject(new Error('settled error'))"),
+                subject.evaluate<Deferred<Int>>("new Promise(function(resolve) { globalThis.resolvePending = resolve; })")
+            )
+        }
+        subject.evaluateUnsync("resolvePending(43)")
+
+        // THEN
+        runBlocking {
+            assertEquals(42, fulfilledDeferred.await())
+            val jsException: JsException = assertFailsWith { rejectedDeferred.await() }
+            assertEquals("settled error", jsException.jsonValue?.toPayloadObject()?.getString("message"))
+            assertEquals(43, pendingDeferred.await())
+        }
+    }
+
+    @Test
+    fun testAwaitedPromises() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val fulfilledValue: Int = runBlocking { subject.evaluate("Promise.resolve(1)") }
+        val nestedValue: Int = runBlocking {
+            subject.evaluate("new Promise(function(resolve) { resolve(Promise.resolve(2).then(function(v) { return Promise.resolve(v + 1); })); })")
+        }
+        val plainValue: String = runBlocking { subject.evaluate("'not a promise'") }
+        val jsException: JsException = assertFailsWith {
+            runBlocking { subject.evaluate<Int>("Promise.resolve().then(function() { throw new Error('awaited error'); })") }
+        }
+
+        // THEN
+        assertEquals(1, fulfilledValue)
+        assertEquals(3, nestedValue)
+        assertEquals("not a promise", plainValue)
+        assertEquals("awaited error", jsException.jsonValue?.toPayloadObject()?.getString("message"))
+    }
+
+    @Test
+    fun testPromiseQueueBudget() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            promiseConfig.maxJobsPerTick = 1
+        })
+
+        // WHEN
+        val hasPendingJobs = runBlocking(subject.coroutineContext) {
+            subject.evaluate<Unit>("""
+                |globalThis.steps = 0;
+                |Promise.resolve()
+                |  .then(function() { steps++; })
+                |  .then(function() { steps++; })
+                |  .then(function() { steps++; });
+                |""".trimMargin())
+            subject.hasPendingPromiseJobs()
+        }
+        val result = runBlocking {
+            subject.evaluate<Int>("Promise.resolve(1).then(function(v) { return v + 1; }).then(function(v) { return v + steps; })")
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertTrue(hasPendingJobs)
+        assertEquals(5, result)
+    }
+
+    @Test
+    fun testPromiseCombinators() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val result = runBlocking {
+            subject.evaluate<String>("""
+                |var order = [];
+                |Promise.resolve().then(function() { order.push(1); return Promise.resolve(3); }).then(function(v) { order.push(v); });
+                |Promise.resolve().then(function() { order.push(2); }).then(function() {}).then(function() {}).then(function() { order.push(4); });
+                |Promise.all([
+                |  Promise.all([1, Promise.resolve(2), { then: function(resolve) { resolve(3); } }]),
+                |  Promise.allSettled([Promise.resolve("a"), Promise.reject("b")]),
+                |  Promise.any([Promise.reject(1), Promise.resolve("any")]),
+                |  Promise.any([Promise.reject(1)]).catch(function(e) { return e.name + ":" + e.errors; }),
+                |  Promise.race([new Promise(function() {}), Promise.resolve("race")]),
+                |  Promise.reject("finally").finally(function() { order.push("f"); }).catch(function(e) { return e; })
+                |]).then(function(values) { return JSON.stringify(values) + " " + order.join(","); })
+                |""".trimMargin())
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertEquals(
+            """[[1,2,3],[{"status":"fulfilled","value":"a"},{"status":"rejected","reason":"b"}],"any","AggregateError:1","race","finally"] 1,2,f,3,4""",
+            result
+        )
+    }
+
+    @Test
+    fun testGetMemoryUsage() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val (memoryUsageBefore, memoryUsageWithValues, memoryUsageAfter) = runBlocking {
+            val memoryUsageBefore = subject.getMemoryUsage()
+            val jsValue: JsValue = subject.evaluate("({ a: 1 })")
+            val javaFunction = JsValue.createJsToJavaProxyFunction1(subject) { s: String -> s.length }
+            val memoryUsageWithValues = subject.getMemoryUsage()
+            jsValue.release()
+            val memoryUsageAfter = subject.getMemoryUsage()
+            javaFunction.hold()
+            Triple(memoryUsageBefore, memoryUsageWithValues, memoryUsageAfter)
+        }
+
+        // THEN
+        assertEquals(memoryUsageBefore.jsValueCount + 1, memoryUsageWithValues.jsValueCount)
+        assertEquals(memoryUsageBefore.jsValueCount, memoryUsageAfter.jsValueCount)
+        assertTrue(memoryUsageWithValues.cppWrapperCount > memoryUsageBefore.cppWrapperCount)
+        assertTrue(memoryUsageWithValues.heapSize > 0)
+        if (BuildConfig.FLAVOR == "quickjs") {
+            assertTrue(memoryUsageWithValues.objectCount > 0)
+            assertTrue(memoryUsageWithValues.stringCount > 0)
+            assertTrue(memoryUsageWithValues.atomCount > 0)
+        } else {
+            assertEquals(-1L, memoryUsageWithValues.objectCount)
+        }
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testJniGlobalRefLimit() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.bareConfig().apply {
+            jvmConfig.maxJniGlobalRefs = 200
+        })
+        val callbackRegistry: TestJsCallbackRegistry = JsValue(subject, """({
+            |  addCallback: function(cb) {}
+            |})""".trimMargin()
+        ).createJavaToJsProxy()
+
+        // WHEN
+        val memoryUsageBefore = runBlocking { subject.getMemoryUsage() }
+        val values = mutableListOf<Int>()
+        repeat(2000) { i ->
+            // Each lambda is wrapped into a new JS function holding a JNI global ref
+            callbackRegistry.addCallback { values.add(i) }
+        }
+        val memoryUsageAfter = runBlocking { subject.getMemoryUsage() }
+
+        // THEN
+        assertTrue(memoryUsageBefore.jniGlobalRefCount > 0)
+        assertTrue(memoryUsageBefore.jniGlobalRefCount >= memoryUsageBefore.javaRefCount)
+        assertTrue(memoryUsageAfter.jniGlobalRefCount < memoryUsageBefore.jniGlobalRefCount + 1000)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testStartupMetrics() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val (metricsBefore, metricsAfter) = runBlocking {
+            subject.evaluate<Unit>("undefined")  // wait until the extensions are installed
+            val metricsBefore = subject.startupMetrics
+            subject.evaluateFileContent("var startupMetricsTest = 1;", "startupMetricsTest.js")
+            subject.evaluateFileContent("var startupMetricsTest = 2;", "startupMetricsTest2.js")
+            Pair(metricsBefore, subject.startupMetrics)
+        }
+
+        // THEN
+        assertTrue(metricsBefore.contextCreationNs > 0)
+        assertTrue(metricsBefore.engineCreationNs > 0)
+        assertTrue(metricsBefore.jniCacheCreationNs > 0)
+        assertTrue(metricsBefore.engineCreationNs + metricsBefore.jniCacheCreationNs + metricsBefore.bridgeSetupNs <= metricsBefore.contextCreationNs)
+        assertTrue(metricsBefore.extensionInstallationNs.getValue("SetTimeout") > 0)
+        assertTrue(metricsBefore.extensionInstallationNs.containsKey("Console"))
+        assertEquals(-1L, metricsBefore.firstFileEvaluationNs)
+        assertTrue(metricsAfter.firstFileEvaluationNs > 0)
+        assertEquals(metricsBefore.contextCreationNs, metricsAfter.contextCreationNs)
+        assertTrue(errors.isEmpty())
     }
 
-    @Before
-    fun setUp() {
-        errors = mutableListOf()
-        unhandledPromiseErrors = mutableListOf()
+    @Test
+    fun testCallTracing() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            xhrConfig.okHttpClient = okHttpClient
+            callTracingConfig.enabled = true
+        })
+
+        // WHEN
+        val (stats, statsAfterReset) = runBlocking {
+            val javaFunction = JsValue.createJsToJavaProxyFunction1(subject) { s: String -> s.length }
+            repeat(3) {
+                assertEquals(4, subject.evaluate<Int>("$javaFunction('test')"))
+            }
+            val stats = subject.getCallTraceStats()
+            subject.resetCallTraceStats()
+            val statsAfterReset = subject.getCallTraceStats()
+            Pair(stats, statsAfterReset)
+        }
+
+        // THEN
+        val evaluateStats = stats.first { it.name == "jniEvaluateString" }
+        assertTrue(evaluateStats.callCount >= 3)
+        assertTrue(evaluateStats.total.totalDurationNs > 0)
+        assertTrue(evaluateStats.total.p50Ns in 1..evaluateStats.total.p99Ns)
+
+        val javaMethodStats = stats.filter { it.name.startsWith("JavaMethod ") }.maxByOrNull { it.callCount }!!
+        assertTrue(javaMethodStats.callCount >= 3)
+        assertTrue(javaMethodStats.jniUpcall.totalDurationNs > 0)
+        assertTrue(javaMethodStats.conversion.totalDurationNs > 0)
+        assertTrue(javaMethodStats.total.totalDurationNs >= javaMethodStats.jniUpcall.totalDurationNs)
+
+        assertTrue(statsAfterReset.isEmpty())
+        assertTrue(errors.isEmpty())
     }
 
-    @After
-    fun cleanUp() {
-        jsBridge?.let {
-            runBlocking {
-                waitForDone(it)
-                jsBridge?.release()
-                waitForDone(it)
+    @Test
+    fun testDirectCallsFromJsThread() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val result = runBlocking {
+            // Blocking calls from Java code called by JS must not be dispatched (deadlock)
+            val javaFunction = JsValue.createJsToJavaProxyFunction1(subject) { s: String ->
+                val jsLambda: (String) -> Int = subject.evaluateBlocking("(function(x) { return x.length; })")
+                subject.evaluateBlocking<Int>("${'$'}{s.length} * 10") + jsLambda(s)
             }
+            subject.evaluate<Int>("$javaFunction('test')")
         }
 
-        printErrors()
+        // THEN
+        assertEquals(44, result)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testIdleGc() {
+        // GIVEN
+        val config = JsBridgeConfig.bareConfig().apply {
+            jsEngineConfig.gcThreshold = 64L * 1024 * 1024
+            jsEngineConfig.idleGcDelayMs = 50L
+        }
+        val subject = createAndSetUpJsBridge(config)
+
+        // WHEN
+        val (heapSizeBusy, heapSizeIdle) = runBlocking {
+            // Cyclic garbage which is only freed by the GC
+            subject.evaluate<Unit>("""
+                for (var i = 0; i < 10000; i++) { var o = { payload: "item" + i }; o.self = o; }
+            """.trimIndent())
+            val heapSizeBusy = subject.getJsHeapSize()
+            delay(500L)
+            val heapSizeIdle = subject.getJsHeapSize()
+            Pair(heapSizeBusy, heapSizeIdle)
+        }
+
+        // THEN
+        assertTrue(heapSizeIdle < heapSizeBusy)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testOnMemoryPressure() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val keptJsValue = JsValue(subject, "({ a: 1 })")
+        val releasedJsValues = (1..1000).map { JsValue(subject, "({ b: $it })") }
+
+        // WHEN
+        val (memoryUsageBefore, memoryUsageAfter, result) = runBlocking {
+            releasedJsValues.forEach { it.release() }
+            val memoryUsageBefore = subject.getMemoryUsage()
+            subject.onMemoryPressure(ComponentCallbacks2.TRIM_MEMORY_COMPLETE)
+            val memoryUsageAfter = subject.getMemoryUsage()
+            val newJsValue = JsValue(subject, "({ c: 2 })")
+            val result: Int = subject.evaluate("$keptJsValue.a + $newJsValue.c")
+            Triple(memoryUsageBefore, memoryUsageAfter, result)
+        }
+
+        // THEN
+        assertEquals(memoryUsageBefore.jsValueCount, memoryUsageAfter.jsValueCount)
+        assertTrue(memoryUsageAfter.heapSize <= memoryUsageBefore.heapSize)
+        assertEquals(3, result)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testCompactHeap() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val javaApi = object: BatchJavaApi {
+            override fun getValue() = 42
+        }
+        val javaApiJsValue = subject.registerJsToJavaInterface(BatchJavaApi::class, javaApi)
+        // (the deleted properties leave unused slots in the property table)
+        val jsValue = JsValue(subject, """(function() {
+            var o = {};
+            for (var i = 0; i < 1000; i++) o["p" + i] = i;
+            for (var i = 100; i < 1000; i++) delete o["p" + i];
+            return o;
+        })()""")
+
+        // WHEN
+        val (reclaimedSize, result) = runBlocking {
+            subject.evaluate<Unit>("""
+                globalThis.compactedObject = $jsValue;
+                globalThis.getterCallCount = 0;
+                Object.defineProperty(globalThis, "countingGetter", { get: function() { return ++getterCallCount; }, configurable: true });
+                Object.defineProperty(globalThis, "throwingGetter", { get: function() { throw new Error("getter called"); }, configurable: true });
+            """.trimIndent())
+            val reclaimedSize = subject.compactHeap()
+            val result: Int = subject.evaluate("compactedObject.p99 + $javaApiJsValue.getValue() + getterCallCount")
+            reclaimedSize to result
+        }
+
+        // THEN
+        if (BuildConfig.FLAVOR == "duktape") {
+            // With the (default) pool allocator
+            assertTrue(reclaimedSize > 0L)
+        } else {
+            assertEquals(0L, reclaimedSize)
+        }
+        assertEquals(141, result)
+
+        // Hold the JS value whose associated JS name is used in string evaluation
+        javaApiJsValue.hold()
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testJsProfiler() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val profileFile = File(context.cacheDir, "testJsProfiler.cpuprofile").apply { delete() }
+
+        // WHEN
+        runBlocking {
+            subject.startJsProfiler(samplingIntervalUs = 500L)
+            subject.evaluate<Unit>("""
+                function hotFunction() {
+                  var x = 0;
+                  for (var i = 0; i < 1000; i++) x += Math.sqrt(i);
+                  return x;
+                }
+                var start = Date.now();
+                while (Date.now() - start < 300) hotFunction();
+            """.trimIndent())
+            subject.stopJsProfiler(profileFile)
+        }
+
+        // THEN
+        val profile = JSONObject(profileFile.readText())
+        val nodes = profile.getJSONArray("nodes")
+        val functionNames = (0 until nodes.length()).map {
+            nodes.getJSONObject(it).getJSONObject("callFrame").getString("functionName")
+        }
+        assertEquals("(root)", functionNames.first())
+        assertTrue(functionNames.contains("hotFunction"))
+        assertTrue(profile.getJSONArray("samples").length() > 0)
+        assertEquals(profile.getJSONArray("samples").length(), profile.getJSONArray("timeDeltas").length())
+        assertTrue(profile.getLong("endTime") >= profile.getLong("startTime"))
+
+        profileFile.delete()
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testTrafficRecording() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val replayBridge = createAndSetUpJsBridge()
+        val recordingFile = File(context.cacheDir, "testTrafficRecording.jsbt").apply { delete() }
+        JsValue.createJsToJavaProxyFunction3<String, Int, Array<Int>, Unit>(subject) { _, _, _ -> }
+            .assignToGlobal("recordedJavaFunction")
+
+        // WHEN
+        val replayDurationNs = runBlocking {
+            subject.evaluate<Unit>("undefined")  // wait until the extensions are installed
+            subject.startTrafficRecording()
+            subject.evaluate<Unit>("recordedJavaFunction('abc', 42, [1, 2, 3])")
+            subject.stopTrafficRecording(recordingFile)
+            JsTrafficReplayer(replayBridge).replay(JsTrafficRecording.read(recordingFile))
+        }
+
+        // THEN
+        val recording = JsTrafficRecording.read(recordingFile)
+        assertFalse(recording.isTruncated)
+        val evaluateCall = recording.calls.first { it.type == JsTrafficRecording.CallType.EvaluateString }
+        assertEquals(0, evaluateCall.depth)
+        assertEquals(listOf(JsTrafficRecording.Value(JsTrafficRecording.ValueType.String, 42)), evaluateCall.arguments)
+        val javaCall = recording.calls.first { it.type == JsTrafficRecording.CallType.JavaMethod }
+        assertEquals(1, javaCall.depth)
+        assertEquals(listOf(JsTrafficRecording.ValueType.String, JsTrafficRecording.ValueType.Number, JsTrafficRecording.ValueType.Array), javaCall.arguments.map { it.type })
+        assertEquals(listOf(3, 0, 3), javaCall.arguments.map { it.size })
+        assertTrue(javaCall.startTimeUs >= evaluateCall.startTimeUs)
+        assertTrue(replayDurationNs > 0)
+
+        recordingFile.delete()
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testJsHeapSnapshot() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val snapshotFile = File(context.cacheDir, "testJsHeapSnapshot.heapsnapshot").apply { delete() }
+
+        // WHEN
+        val jsValue = JsValue(subject, """
+            function LeakingObject() { this.payload = [1, 2, 3]; }
+            new LeakingObject()
+        """.trimIndent())
+        runBlocking {
+            subject.writeJsHeapSnapshot(snapshotFile)
+        }
+
+        // THEN
+        val snapshot = JSONObject(snapshotFile.readText())
+        val meta = snapshot.getJSONObject("snapshot").getJSONObject("meta")
+        val nodeFieldCount = meta.getJSONArray("node_fields").length()
+        val nodes = snapshot.getJSONArray("nodes")
+        val strings = snapshot.getJSONArray("strings")
+        val stringList = (0 until strings.length()).map { strings.getString(it) }
+        assertEquals(0, nodes.length() % nodeFieldCount)
+        assertEquals(nodes.length() / nodeFieldCount, snapshot.getJSONObject("snapshot").getInt("node_count"))
+        assertTrue(stringList.contains("LeakingObject"))
+        if (BuildConfig.FLAVOR == "quickjs") {
+            assertTrue(stringList.contains("(JsBridge JsValue table)"))
+        }
+
+        jsValue.release()
+        snapshotFile.delete()
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testConversionStats() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val (stats, statsAfterReset) = runBlocking {
+            val javaFunction = JsValue.createJsToJavaProxyFunction1(subject) { s: String -> s.length }
+            assertEquals(4, subject.evaluate<Int>("$javaFunction('test')"))
+            val stats = subject.getConversionStats()
+            subject.resetConversionStats()
+            val statsAfterReset = subject.getConversionStats()
+            Pair(stats, statsAfterReset)
+        }
+
+        // THEN
+        assertTrue(statsAfterReset.isEmpty())
+        if (!BuildConfig.HAS_CONVERSION_STATS) {
+            assertTrue(stats.isEmpty())
+            return
+        }
+
+        val stringStats = stats.first { it.typeName == "String" }
+        assertTrue(stringStats.jsToJavaCount >= 1)
+        assertTrue(stringStats.jsToJavaBytes >= 4)
+        val intStats = stats.first { it.typeName == "Int" }
+        assertTrue(intStats.jsToJavaCount + intStats.javaToJsCount >= 2)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testAllocationBounds() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val iterations = 100
+
+        // Upper bounds per operation (native allocations, JNI local refs, JNI global refs)
+        // Note: to be lowered when the allocations of a fast path are reduced
+        val maxNativeAllocations = 32L
+        val maxJniLocalRefs = 16L
+        val maxJniGlobalRefs = 1L
+
+        val sum: suspend (Int, Int) -> Int = JsValue.newFunction(subject, "a", "b", "return a + b;")
+        val identity: suspend (JsValue) -> JsValue = JsValue.newFunction(subject, "v", "return v;")
+        val reverse: suspend (IntArray) -> IntArray = JsValue.newFunction(subject, "a", "return a.reverse();")
+        val javaFunction = JsValue.createJsToJavaProxyFunction1(subject) { s: String -> s.length }
+        val callJavaFunction: suspend () -> Int = JsValue.newFunction(subject, "return $javaFunction('test');")
+        val jsValue = JsValue(subject, "({ key: 'value' })")
+        val intArray = IntArray(16) { it }
+
+        // WHEN
+        val statsByOperation = runBlocking {
+            // Counters of the given operation repeated "iterations" times (after a warm-up call
+            // which creates the cached types and method IDs)
+            suspend fun measure(operation: suspend () -> Unit): JsAllocationStats? {
+                operation()
+                val before = subject.getAllocationStats() ?: return null
+                repeat(iterations) { operation() }
+                val after = subject.getAllocationStats() ?: return null
+                return after - before
+            }
+
+            mapOf(
+                "callJsLambda (Int, Int)" to measure { sum(1, 2) },
+                "JavaMethod::invoke (String)" to measure { callJavaFunction() },
+                "JsValue" to measure { identity(jsValue) },
+                "IntArray" to measure { reverse(intArray) },
+            )
+        }
+
+        // THEN
+        statsByOperation.forEach { (operation, stats) ->
+            if (!BuildConfig.HAS_ALLOCATION_STATS) {
+                assertNull(stats)
+                return@forEach
+            }
+
+            assertNotNull(stats)
+            assertTrue(stats.nativeAllocations <= maxNativeAllocations * iterations, "$operation: $stats")
+            assertTrue(stats.jniLocalRefs <= maxJniLocalRefs * iterations, "$operation: $stats")
+            assertTrue(stats.jniGlobalRefs <= maxJniGlobalRefs * iterations, "$operation: $stats")
+        }
+        assertTrue(errors.isEmpty())
     }
 
     @Test
@@ -165,6 +1227,25 @@ class JsBridgeTest {
         verify { jsToJavaFunctionMock(eq("testString")) }
     }
 
+    @Test
+    fun testEvaluateBlockingScalars() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // THEN
+        assertEquals(2, subject.evaluateBlocking("1.5+1", Int::class.java))
+        assertEquals(2.5, subject.evaluateBlocking("1.5+1", Double::class.java))
+        assertEquals(true, subject.evaluateBlocking("1 < 2", Boolean::class.java))
+        assertEquals("1.5+1", subject.evaluateBlocking("\"1.5+1\"", String::class.java))
+
+        // Same types via the generic path
+        assertEquals(2, subject.evaluateBlocking("1.5+1", Int::class.javaObjectType))
+        assertEquals(2.5, subject.evaluateBlocking("1.5+1", Double::class.javaObjectType))
+
+        val exception: JsException = assertFailsWith { subject.evaluateBlocking("throw new Error('scalar error')", Int::class.java) }
+        assertEquals(true, exception.message?.contains("scalar error"))
+    }
+
     @Test
     fun testEvaluate() {
         // GIVEN
@@ -243,6 +1324,7 @@ class JsBridgeTest {
             assertArrayEquals(arrayOf(1.0, 2.2, 3.8), subject.evaluate<Array<Double>>("""[1.0, 2.2, 3.8]"""))  // Array<Double>
             assertTrue(subject.evaluate<FloatArray>("""[1.0, 2.2, 3.8]""").contentEquals(floatArrayOf(1.0f, 2.2f, 3.8f)))  // FloatArray
             assertArrayEquals(arrayOf(1.0f, 2.2f, 3.8f), subject.evaluate<Array<Float>>("""[1.0, 2.2, 3.8]"""))  // Array<Float>
+            assertArrayEquals(intArrayOf(1, 2, 3), subject.evaluate("""var a = [1, 2]; Object.defineProperty(a, 2, { get: function() { return 3; }, enumerable: true }); a"""))  // IntArray (not a fast array)
 
             // 2D-Arrays
             assertArrayEquals(arrayOf(arrayOf(1, 2), arrayOf(3, 4)), subject.evaluate<Array<Array<Int>>>("""[[1, 2], [3, 4]]"""))  // Array<Array<Int>>
@@ -260,12 +1342,285 @@ class JsBridgeTest {
             // Array of (any) objects
             assertArrayEquals(arrayOf(1.0, "hello", null), subject.evaluate<Array<Any>>("""[1.0, "hello", null]"""))  // Array<Any?>
 
-            // JSON
-            assertEquals(
-                JsonObjectWrapper("key1" to 1, "key2" to "value2").toPayload(),
-                subject.evaluate<JsonObjectWrapper>("({key1: 1, key2: \"value2\"})").toPayload()
-            )
+            // JSON
+            assertEquals(
+                JsonObjectWrapper("key1" to 1, "key2" to "value2").toPayload(),
+                subject.evaluate<JsonObjectWrapper>("({key1: 1, key2: \"value2\"})").toPayload()
+            )
+        }
+    }
+
+    @Test
+    fun testEvaluateJsonObjectWrapperWithErrors() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val (payload, undefinedJson) = runBlocking {
+            val json = subject.evaluate<JsonObjectWrapper>("""({
+                key1: 1,
+                error: new TypeError("test error"),
+                nested: { errors: [new Error("nested error")] }
+            })""")
+            val undefinedJson = subject.evaluate<JsonObjectWrapper>("undefined")
+            Pair(json.toPayloadObject(), undefinedJson)
+        }
+
+        // THEN
+        assertEquals(1, payload?.getInt("key1"))
+        assertEquals("test error", payload?.getObject("error")?.getString("message"))
+        assertEquals("nested error", payload?.getString(arrayOf("nested", "errors", 0, "message")))
+        assertEquals(JsonObjectWrapper.Undefined.jsonString, undefinedJson.jsonString)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testJsonObjectWrapperParsing() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val longText = "0123456789abcdef".repeat(64)
+        val jsonObject = JsonObjectWrapper("""{
+            "name": "Café 😀",
+            "long": "$longText",
+            "escaped": "a\nb\t\"c\" A\/😀"
+        }""")
+
+        // WHEN
+        val jsJsonObject = JsValue.fromJavaValue(subject, jsonObject)
+        val result: String = subject.evaluateBlocking("[$jsJsonObject.name, $jsJsonObject.long.length, $jsJsonObject.escaped].join('|')")
+        val invalidEscapeError: String = subject.evaluateBlocking("""
+            try { JSON.parse('"invalid \\x41 escape"'); "" } catch (e) { e.name; }
+        """)
+
+        // THEN
+        assertEquals("Café 😀|${longText.length}|a\nb\t\"c\" A/😀", result)
+        assertEquals("SyntaxError", invalidEscapeError)
+    }
+
+    @Test
+    fun testPayloadParameters() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val (payloadObject, payloadArray, payload, nullPayloadObject, javaResult, jsResult) = runBlocking {
+            val payloadObject: PayloadObject = subject.evaluate("""({
+                int: 1, double: 2.5, string: "täst €😀", latin1: "café", bool: true, nothing: null,
+                undefinedValue: undefined, func: function() {}, nested: { array: [1, "two", undefined] }
+            })""")
+            val payloadArray: PayloadArray = subject.evaluate("""[1, "two", { three: 3 }]""")
+            val payload: Payload = subject.evaluate(""""primitive"""")
+            val nullPayloadObject: PayloadObject? = subject.evaluate("null")
+
+            val javaFunction = JsValue.createJsToJavaProxyFunction1(subject) { p: PayloadObject ->
+                payloadObjectOf("sum" to (p.getInt("a") ?: 0) + (p.getInt("b") ?: 0), "echo" to p.getString("s"), "name" to "café")
+            }
+            val javaResult: PayloadObject = subject.evaluate("""$javaFunction({ a: 1, b: 2, s: "é€" })""")
+            val jsResult: String = subject.evaluate("""(function(r) { return r.sum + ":" + r.echo + ":" + r.name; })($javaFunction({ a: 3, b: 4 }))""")
+            javaFunction.hold()
+
+            PayloadTestResults(payloadObject, payloadArray, payload, nullPayloadObject, javaResult, jsResult)
+        }
+
+        // THEN
+        assertEquals(1, payloadObject.getInt("int"))
+        assertEquals(2.5, payloadObject.getDouble("double"))
+        assertEquals("täst €😀", payloadObject.getString("string"))
+        assertEquals("café", payloadObject.getString("latin1"))
+        assertEquals(true, payloadObject.getBoolean("bool"))
+        assertTrue(payloadObject.isNull("nothing"))
+        assertTrue(payloadObject.isUndefined("undefinedValue"))
+        assertTrue(payloadObject.isUndefined("func"))
+        assertEquals(listOf(1, "two", null), payloadObject.getArray(arrayOf("nested", "array"))?.toList())
+        assertEquals(3, payloadArray.count)
+        assertEquals(3, (payloadArray.array[2] as PayloadObject).getInt("three"))
+        assertEquals(PayloadString("primitive"), payload)
+        assertNull(nullPayloadObject)
+        assertEquals(3, javaResult.getInt("sum"))
+        assertEquals("é€", javaResult.getString("echo"))
+        assertEquals("7:null:café", jsResult)
+        assertTrue(errors.isEmpty())
+    }
+
+    private data class PayloadTestResults(
+        val payloadObject: PayloadObject,
+        val payloadArray: PayloadArray,
+        val payload: Payload,
+        val nullPayloadObject: PayloadObject?,
+        val javaResult: PayloadObject,
+        val jsResult: String,
+    )
+
+    @Serializable
+    enum class SerializableKind { SMALL, LARGE }
+
+    @Serializable
+    data class SerializableItem(val id: Int, val name: String, val tags: List<String> = emptyList(), val score: Double? = null)
+
+    @Serializable
+    data class SerializableBox(val items: List<SerializableItem>, val counts: Map<String, Int>, val kind: SerializableKind)
+
+    @Test
+    fun testEvaluatePayloadAsync() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val (payloadObject, payloadArray, nullPayload, wrapperPayload) = runBlocking {
+            val payloadObject = subject.evaluatePayloadAsync("""({
+                int: 1, double: -2.5e1, string: "täst €😀\n", bool: false, nothing: null, nested: { array: [1, "two"] }
+            })""").await() as PayloadObject
+            val payloadArray = subject.evaluatePayloadAsync("[1, [], {}]").await() as PayloadArray
+            val nullPayload = subject.evaluatePayloadAsync("null").await()
+            val wrapperPayload = JsonObjectWrapper("key" to "value").toPayloadAsync().await()
+            listOf(payloadObject, payloadArray, nullPayload, wrapperPayload)
+        }
+
+        // THEN
+        payloadObject as PayloadObject
+        assertEquals(1, payloadObject.getInt("int"))
+        assertEquals(-25.0, payloadObject.getDouble("double"))
+        assertEquals("täst €😀\n", payloadObject.getString("string"))
+        assertEquals(false, payloadObject.getBoolean("bool"))
+        assertTrue(payloadObject.isNull("nothing"))
+        assertEquals("two", payloadObject.getObject("nested")?.getArray("array")?.getString(1))
+        assertEquals(3, (payloadArray as PayloadArray).count)
+        assertNull(nullPayload)
+        assertEquals("value", (wrapperPayload as PayloadObject).getString("key"))
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testSerializableParameters() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val (box, jsResult) = runBlocking {
+            val box: SerializableBox = subject.evaluate("""({
+                items: [{ id: 1, name: "one", tags: ["a", "b"], unknown: { x: [1, 2] } }, { id: 2, name: "zwei €", score: 2.5 }],
+                counts: { a: 1, b: 2 }, kind: "LARGE"
+            })""")
+
+            val javaFunction = JsValue.createJsToJavaProxyFunction1(subject) { b: SerializableBox ->
+                b.copy(items = b.items + SerializableItem(3, "drei", score = 0.5), kind = SerializableKind.SMALL)
+            }
+            val jsResult: String = subject.evaluate("""(function(b) {
+                return b.items.map(function(i) { return i.id + i.name + i.tags.length + ":" + i.score; }).join(",")
+                    + "|" + b.counts.a + b.counts.b + b.kind + "|" + Object.keys(b.items[2]).join(",");
+            })($javaFunction({ items: [{ id: 1, name: "one" }], counts: { a: 4, b: 5 }, kind: "LARGE" }))""")
+            javaFunction.hold()
+
+            box to jsResult
+        }
+
+        // THEN
+        assertEquals(SerializableBox(
+            items = listOf(SerializableItem(1, "one", listOf("a", "b")), SerializableItem(2, "zwei €", score = 2.5)),
+            counts = mapOf("a" to 1, "b" to 2),
+            kind = SerializableKind.LARGE,
+        ), box)
+        assertEquals("1one0:null,3drei0:0.5|45SMALL|id,name,tags,score", jsResult)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testJsObjectView() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val results = runBlocking {
+            val view: JsObjectView = subject.evaluate("""({
+                name: "manifest", version: 3, ratio: 0.5, enabled: true,
+                items: [{ id: 1 }, { id: 2, tags: ["a", "b"] }],
+                nested: { key: "value" }
+            })""")
+
+            val items = view.getObject("items")
+            listOf(
+                view.getString("name"),
+                view.getInt("version"),
+                view.getDouble("ratio"),
+                view.getBoolean("enabled"),
+                view.getString("missing"),
+                items?.getLength(),
+                items?.getObject(1)?.getInt("id"),
+                items?.getObject(1)?.get<List<String>>("tags"),
+                view.get<PayloadObject>("nested"),
+                view.getObject("nested")?.getString("key"),
+            )
+        }
+
+        // THEN
+        assertEquals(
+            listOf("manifest", 3, 0.5, true, null, 2, 2, listOf("a", "b"), payloadObjectOf("key" to "value"), "value"),
+            results
+        )
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testJsValueNativePropertyAccess() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val results = runBlocking {
+            val counter = JsValue(subject, """({
+                count: 1, items: [10, 20],
+                add: function(n, label) { this.count += n; return label + this.count; }
+            })""")
+            counter.set("count", 5)
+            counter.set("name", "counter")
+            val items: JsObjectView = counter.get("items")
+            items.set(1, 25.5)
+
+            listOf(
+                counter.callMethod<String>("add", 2, "count: "),
+                counter.get<Int>("count"),
+                counter.get<String>("name"),
+                items.get<Double>(1),
+                counter.typeOf(),
+                counter.get<JsValue>("add").typeOf(),
+            )
+        }
+
+        // THEN
+        assertEquals(listOf("count: 7", 7, "counter", 25.5, "object", "function"), results)
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testJsValueFromJson() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val json = """{"key": "välue €", "array": [1, 2.5, null, true]}"""
+        val largeJson = (0 until 100_000).joinToString(",", "[", "]") { """{"id":$it}""" }
+
+        // WHEN
+        val (fromStream, fromHeapBuffer, fromDirectBuffer, largeLength) = runBlocking {
+            val fromStream = JsValue.fromJson(subject, json.byteInputStream())
+            val fromHeapBuffer = JsValue.fromJson(subject, ByteBuffer.wrap(json.toByteArray()))
+            val directBuffer = ByteBuffer.allocateDirect(json.length * 3).put(json.toByteArray()).apply { flip() }
+            val fromDirectBuffer = JsValue.fromJson(subject, directBuffer)
+            val largeValue = JsValue.fromJson(subject, largeJson.byteInputStream())
+
+            listOf(
+                fromStream.evaluate<PayloadObject>(),
+                fromHeapBuffer.evaluate<PayloadObject>(),
+                fromDirectBuffer.evaluate<PayloadObject>(),
+                subject.evaluate<Int>("$largeValue.length"),
+            ).also { largeValue.hold() }
         }
+
+        // THEN
+        val expectedPayload = payloadObjectOf("key" to "välue €", "array" to listOf(1, 2.5, null, true))
+        assertEquals(expectedPayload, fromStream)
+        assertEquals(expectedPayload, fromHeapBuffer)
+        assertEquals(expectedPayload, fromDirectBuffer)
+        assertEquals(100_000, largeLength)
+        assertTrue(errors.isEmpty())
     }
 
     @Test
@@ -445,6 +1800,242 @@ class JsBridgeTest {
         assertEquals("testString", ret)
     }
 
+    @Test
+    fun testEvaluateBytecode() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val content = """javaFunctionMock("bytecodeString");"""
+
+        runBlocking {
+            val bytecode = subject.evaluateFileContentToBytecode(content, "file.js")
+            subject.evaluateBytecode(bytecode, "file.js")
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        verify(exactly = 2) { jsToJavaFunctionMock(eq("bytecodeString")) }
+    }
+
+    @Test
+    fun testEvaluateBytecodeGlobalDeclarations() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val content = """var bytecodeGlobalVar = 42; function bytecodeGlobalFunction() { return "fromBytecode"; }"""
+
+        val (globalVar, globalFunctionResult) = runBlocking {
+            val bytecode = subject.evaluateFileContentToBytecode(content, "file.js")
+            subject.evaluate<Unit>("bytecodeGlobalVar = 0; bytecodeGlobalFunction = null;")
+            subject.evaluateBytecode(bytecode, "file.js")
+            subject.evaluate<Int>("bytecodeGlobalVar") to subject.evaluate<String>("bytecodeGlobalFunction()")
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertEquals(42, globalVar)
+        assertEquals("fromBytecode", globalFunctionResult)
+    }
+
+    @Test
+    fun testEvaluateLz4Bytecode() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // LZ4 frame with a literal-only compressed block followed by an uncompressed block
+        fun lz4Frame(data: ByteArray): ByteArray {
+            val out = java.io.ByteArrayOutputStream()
+            fun writeLE32(v: Int) = (0 until 4).forEach { out.write(v ushr (8 * it)) }
+
+            val half = data.size / 2
+            val compressedBlock = java.io.ByteArrayOutputStream().apply {
+                write(minOf(half, 15) shl 4)
+                if (half >= 15) {
+                    var extra = half - 15
+                    while (extra >= 255) { write(255); extra -= 255 }
+                    write(extra)
+                }
+                write(data, 0, half)
+            }.toByteArray()
+
+            writeLE32(0x184D2204)
+            out.write(0x60)  // version 01, independent blocks
+            out.write(0x70)  // 4 MB blocks
+            out.write(0)  // header checksum (not verified)
+            writeLE32(compressedBlock.size)
+            out.write(compressedBlock)
+            writeLE32((data.size - half) or Int.MIN_VALUE)
+            out.write(data, half, data.size - half)
+            writeLE32(0)  // end mark
+            return out.toByteArray()
+        }
+
+        // WHEN
+        val content = """javaFunctionMock("lz4BytecodeString");"""
+
+        runBlocking {
+            val bytecode = subject.evaluateFileContentToBytecode(content, "file.js")
+            subject.evaluateBytecode(lz4Frame(bytecode), "file.js")
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        verify(exactly = 2) { jsToJavaFunctionMock(eq("lz4BytecodeString")) }
+    }
+
+    @Test
+    fun testEvaluateLz4BytecodeAsset() {
+        if (BuildConfig.FLAVOR == "duktape") {
+            // The Duktape bytecode depends on the build configuration (no portable asset)
+            return
+        }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        runBlocking {
+            // androidTest asset file "lz4_bytecode_quickjs.jsbc.lz4":
+            // - QuickJS bytecode (107 KB) compressed with "lz4 -9 -BD -B4" (2 linked 64 KB blocks
+            // with overlapping matches and matches referencing the previous block)
+            // - source:
+            // var total = 0;
+            // function repeated0(value) { var result = value * 1 + 0; return result; }
+            // total += repeated0(0);
+            // ... (up to repeated1199, multiplying by i % 7 + 1 and adding i)
+            // javaFunctionMock("lz4BytecodeAsset:" + total);
+            subject.evaluateLocalBytecodeFile(context, "bytecode/lz4_bytecode_quickjs.jsbc.lz4")
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        verify(exactly = 1) { jsToJavaFunctionMock(eq("lz4BytecodeAsset:3594602")) }
+    }
+
+    @Test
+    fun testPrecompileFileContents() {
+        if (BuildConfig.FLAVOR == "duktape") {
+            // Parallel precompilation is only supported on QuickJS
+            return
+        }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val contents = (1..10).associate { i -> "file$i.js" to """javaFunctionMock("precompiled$i");""" }
+
+        runBlocking {
+            val bytecodes = subject.precompileFileContents(contents, threadCount = 4)
+            assertEquals(contents.keys, bytecodes.keys)
+            bytecodes.forEach { (filename, bytecode) -> subject.evaluateBytecode(bytecode, filename) }
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        (1..10).forEach { i -> verify(exactly = 1) { jsToJavaFunctionMock(eq("precompiled$i")) } }
+    }
+
+    @Test
+    fun testPrecompileModules() {
+        if (BuildConfig.FLAVOR == "duktape") {
+            // ES6 modules are not supported on Duktape
+            return
+        }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val ret = runBlocking {
+            val bytecodes = subject.precompileFileContents(mapOf(
+                "main.js" to """import * as bird from "bird.js"; export default function main() { return "Name: " + bird.getName() };""",
+                "bird.js" to "export function getName() { return 'BIRD' };"
+            ), JsBridge.JsFileEvaluationType.Module)
+            subject.registerJsModules(bytecodes, isBytecode = true)
+
+            subject.evaluateFileContent("""
+                    import main from "main.js"
+                    globalThis.entryPoint = function() {
+                        return main();
+                    }
+                """.trimIndent(), "precompiledModules", JsBridge.JsFileEvaluationType.Module)
+            subject.evaluate<String>("globalThis.entryPoint()")
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertEquals("Name: BIRD", ret)
+    }
+
+    @Test
+    fun testPrecompileFileContentsError() {
+        if (BuildConfig.FLAVOR == "duktape") {
+            // Parallel precompilation is only supported on QuickJS
+            return
+        }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val error: JsBridgeError.JsFileEvaluationError = assertFailsWith {
+            runBlocking {
+                subject.precompileFileContents(mapOf("valid.js" to "var a = 1;", "invalid.js" to "var = ;"))
+            }
+        }
+
+        // THEN
+        assertEquals("invalid.js", error.fileName)
+        assertTrue(error.cause is JsException)
+    }
+
+    @Test
+    fun testEvaluateInvalidBytecode() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val error: JsBridgeError.JsFileEvaluationError = assertFailsWith {
+            runBlocking {
+                subject.evaluateBytecode(byteArrayOf(1, 2, 3, 4, 5, 6, 7, 8, 9), "invalid.js")
+            }
+        }
+
+        // THEN
+        assertTrue(error.cause is IllegalArgumentException)
+    }
+
+    @Test
+    fun testEvaluateFileContentWithBytecodeCache() {
+        // GIVEN
+        val cacheDirectory = File(context.cacheDir, "testBytecodeCache").apply { deleteRecursively() }
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            xhrConfig.okHttpClient = okHttpClient
+            bytecodeCacheConfig.enabled = true
+            bytecodeCacheConfig.directory = cacheDirectory
+        })
+
+        // WHEN
+        val content = """javaFunctionMock("cachedFileContentString");"""
+
+        runBlocking {
+            subject.evaluateFileContent(content, "file.js")
+        }
+        val cachedFiles = cacheDirectory.listFiles()?.toList()
+        runBlocking {
+            subject.evaluateFileContent(content, "file.js")
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertEquals(1, cachedFiles?.size)
+        verify(exactly = 2) { jsToJavaFunctionMock(eq("cachedFileContentString")) }
+        cacheDirectory.deleteRecursively()
+    }
+
     @Test
     fun testEvaluateFileContentUnsync() {
         // GIVEN
@@ -596,6 +2187,60 @@ class JsBridgeTest {
         assertEquals("non-existing.js", rootCause.fileName)
     }
 
+    @Test
+    fun testRegisterJsModules() {
+        if (BuildConfig.FLAVOR == "duktape") {
+            // ES6 modules are not supported on Duktape
+            return
+        }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val normalizedNames = mutableListOf<String>()
+
+        // WHEN
+        subject.registerJsModules(mapOf(
+            "main.js" to """
+                import * as eagle from "animals/eagle.js";
+                export default function main() { return "Eagle name: " + eagle.getName() };
+            """.trimIndent().toByteArray(),
+            "animals/eagle.js" to """
+                import * as bird from "./bird.js"
+                export function getName() { return "EAGLE as a " + bird.getName() };
+            """.trimIndent().toByteArray(),
+            "animals/bird.js" to "export function getName() { return 'BIRD' };".toByteArray()
+        ))
+        subject.setJsModuleNameNormalizer { baseModuleName, moduleName ->
+            normalizedNames.add("$baseModuleName|$moduleName")
+            if (moduleName.startsWith("./")) {
+                baseModuleName.substringBeforeLast('/', "") + moduleName.removePrefix(".")
+            } else {
+                moduleName
+            }
+        }
+
+        val ret = runBlocking {
+            subject.evaluateFileContent("""
+                    import main from "main.js"
+                    globalThis.entryPoint = function() {
+                        return main();
+                    }
+                """.trimIndent(), "moduleRegistry", JsBridge.JsFileEvaluationType.Module)
+
+            // Same import from the same base module => memoized normalized name
+            subject.evaluateFileContent("""
+                    import main from "main.js"
+                """.trimIndent(), "moduleRegistry", JsBridge.JsFileEvaluationType.Module)
+
+            subject.evaluate<String>("globalThis.entryPoint()");
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertEquals("Eagle name: EAGLE as a BIRD", ret)
+        assertEquals(listOf("moduleRegistry|main.js", "main.js|animals/eagle.js", "animals/eagle.js|./bird.js"), normalizedNames)
+    }
+
     @Test
     fun testJsValue() {
         // GIVEN
@@ -710,6 +2355,109 @@ class JsBridgeTest {
         assertTrue(errors.isEmpty())
     }
 
+    @Test
+    fun testJsValueFromJs() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val (objectValue, functionValue) = runBlocking {
+            val objectValue: JsValue = subject.evaluate("({ a: 1, b: 'two' })")
+            val functionValue: JsValue = subject.evaluate("(function(obj) { return obj.a + obj.b; })")
+            Pair(objectValue, functionValue)
+        }
+        val function = functionValue.createJavaToJsBlockingProxyFunction1<JsValue, String>()
+
+        // THEN
+        runBlocking {
+            // JsValue -> JS (via native handle)
+            assertEquals("1two", function(objectValue))
+
+            // JsValue -> JS (via associated JS name)
+            assertEquals("1two", subject.evaluate<String>("$functionValue($objectValue)"))
+            assertEquals(1, subject.evaluate<Int>("$objectValue.a"))
+        }
+
+        assertEquals(objectValue, objectValue)
+        assertNotEquals(objectValue, functionValue)
+
+        objectValue.release()
+        functionValue.release()
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testJsValueBatchRelease() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val jsValues = (1..100).map { JsValue(subject, "({ index: $it })") }
+        val jsNames = jsValues.map { it.toString() }
+        runBlocking {
+            assertEquals(100, subject.evaluate<Int>("${jsNames.last()}.index"))
+        }
+
+        // WHEN
+        jsValues.forEach { it.release() }
+
+        // THEN
+        runBlocking {
+            // Releases are processed in the JS thread before the next evaluation
+            jsNames.forEach { jsName ->
+                assertEquals("undefined", subject.evaluate<String>("typeof $jsName"))
+            }
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testPostJsCommands() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        subject.evaluateUnsync("globalThis.postedSum = 0; function addToSum(a, b) { postedSum += a + b; }")
+
+        // WHEN
+        val threads = (1..4).map {
+            Thread {
+                repeat(100) { subject.postJsFunctionCall("addToSum", "[1, 2]") }
+            }
+        }
+        threads.forEach { it.start() }
+        threads.forEach { it.join() }
+        subject.postJsValueAssignment("postedValue", "postedSum * 2")
+        subject.postJsValueDeletion("postedSum")
+
+        // THEN
+        runBlocking {
+            assertEquals(2400, subject.evaluate<Int>("postedValue"))
+            assertEquals("undefined", subject.evaluate<String>("typeof postedSum"))
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testLazyJsExceptionJsonValue() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        val jsException: JsException = assertFailsWith {
+            subject.evaluateBlocking<Unit>("""throw {message: "Lazy error", hint: 1};""")
+        }
+        var jsonValueFromJsThread: String? = null
+        runBlocking {
+            withContext(subject.coroutineContext) {
+                jsonValueFromJsThread = jsException.jsonValue
+            }
+        }
+
+        // THEN
+        assertEquals("""{message: "Lazy error", hint: 1}""".toPayload(), jsException.jsonValue?.toPayload())
+        assertEquals(jsException.jsonValue, jsonValueFromJsThread)
+    }
+
     @Test
     fun testGenericJavaObject() {
         // GIVEN
@@ -748,6 +2496,29 @@ class JsBridgeTest {
         }
     }
 
+    @Test
+    fun testGenericJavaObjectIdentity() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val javaObject = object : Any() {}
+        val otherJavaObject = object : Any() {}
+
+        // WHEN
+        val jsJavaObject1 = JsValue.fromJavaValue(subject, JavaObjectWrapper(javaObject))
+        val jsJavaObject2 = JsValue.fromJavaValue(subject, JavaObjectWrapper(javaObject))
+        val jsOtherJavaObject = JsValue.fromJavaValue(subject, JavaObjectWrapper(otherJavaObject))
+
+        // THEN
+        runBlocking {
+            if (BuildConfig.FLAVOR == "quickjs") {
+                assertTrue(subject.evaluate<Boolean>("$jsJavaObject1 === $jsJavaObject2"))
+            }
+            assertFalse(subject.evaluate<Boolean>("$jsJavaObject1 === $jsOtherJavaObject"))
+            assertSame(javaObject, jsJavaObject2.evaluate<Any?>())
+            assertSame(otherJavaObject, jsOtherJavaObject.evaluate<Any?>())
+        }
+    }
+
     @Test
     fun testUnhandledPromiseRejection() {
         // GIVEN
@@ -890,6 +2661,42 @@ class JsBridgeTest {
         assertEquals("Kotlin exception", jsException.cause?.message)
     }
 
+    @Test
+    fun testJavaExceptionMessageIsLazy() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val getMessageCount = AtomicInteger(0)
+        class NotFoundException : Exception() {
+            override val message: String
+                get() = "Not found #${getMessageCount.incrementAndGet()}"
+        }
+        val findJava = JsValue.createJsToJavaProxyFunction0<Unit>(subject) { throw NotFoundException() }
+
+        // WHEN
+        val (countAfterDiscard, messages) = runBlocking {
+            subject.evaluate<Unit>("""
+                for (var i = 0; i < 10; i++) {
+                  try { $findJava(); } catch (e) {}
+                }
+            """.trimIndent())
+            val countAfterDiscard = getMessageCount.get()
+            val messages: String = subject.evaluate("""
+                try {
+                  $findJava();
+                } catch (e) {
+                  e.message + "|" + e.message + "|" + (e instanceof Error) + "|" + String(e)
+                }
+            """.trimIndent())
+            Pair(countAfterDiscard, messages)
+        }
+        findJava.hold()
+
+        // THEN
+        assertEquals(0, countAfterDiscard)
+        assertEquals("Not found #1|Not found #1|true|Error: Not found #1", messages)
+        assertTrue(errors.isEmpty())
+    }
+
     @Test
     fun testNullPointerException() {
         // GIVEN
@@ -954,6 +2761,16 @@ class JsBridgeTest {
             val jsString = JsValue.fromJavaValue(subject, "javaString")
             assertEquals("javaString", jsString.evaluate())
 
+            val jsUnicodeString = JsValue.fromJavaValue(subject, "\u00e0\u4e2d\uD83D\uDE00")  // Latin-1, BMP and supplementary characters
+            assertEquals("\u00e0\u4e2d\uD83D\uDE00", jsUnicodeString.evaluate())
+            assertEquals(4, subject.evaluate<Int>("$jsUnicodeString.length"))
+            assertEquals("\u00e0\uD83D\uDE00", subject.evaluate<String>("'\\u00e0' + '\\uD83D\\uDE00'"))
+
+            val jsNulString = JsValue.fromJavaValue(subject, "a\u0000b")  // U+0000 is C0 80 in modified UTF-8
+            assertEquals("a\u0000b", jsNulString.evaluate())
+            assertEquals(0, subject.evaluate<Int>("$jsNulString.charCodeAt(1)"))
+            assertEquals("a\u0000b", subject.evaluate<String>("'a\\u0000b'"))
+
             val jsByte = JsValue.fromJavaValue(subject, 5.toByte())
             val jsNullableByte = JsValue.fromJavaValue<Byte?>(subject, 5)
             val jsNullByte = JsValue.fromJavaValue<Byte?>(subject, null)
@@ -1043,6 +2860,127 @@ class JsBridgeTest {
         }
     }
 
+    @Test
+    fun testLargeListConversions() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val count = 100_000
+        val javaList = (0 until count).map { "item$it" }
+
+        // THEN
+        runBlocking {
+            // Java -> JS -> Java (several local frame chunks)
+            val jsList = JsValue.fromJavaValue(subject, javaList)
+            assertEquals(count, subject.evaluate<Int>("$jsList.length"))
+            assertEquals(javaList, jsList.evaluate<List<String>>())
+
+            val jsArray: Array<String> = subject.evaluate("Array.from({ length: $count }, function(_, i) { return 'item' + i; })")
+            assertEquals(javaList, jsArray.toList())
+
+            // (non-string elements are converted one by one on both engines)
+            val javaIntList = (0 until count).toList()
+            val jsIntList = JsValue.fromJavaValue(subject, javaIntList)
+            assertEquals(javaIntList, jsIntList.evaluate<List<Int>>())
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testStringArrayBulkConversions() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val strings = listOf("a", null, "", "äöü €", "\uD83D\uDE00", "last")
+
+        // THEN
+        runBlocking {
+            // Java -> JS -> Java (packed strings with null, Latin-1 and surrogate pairs)
+            val jsList = JsValue.fromJavaValue(subject, strings)
+            assertEquals("a,,,äöü €,\uD83D\uDE00,last", subject.evaluate<String>("$jsList.join()"))
+            assertEquals(strings, jsList.evaluate<List<String?>>())
+
+            val jsArray = JsValue.fromJavaValue(subject, strings.toTypedArray())
+            assertEquals("string,object", subject.evaluate<String>("typeof $jsArray[0] + ',' + typeof $jsArray[1]"))
+            assertEquals(strings, jsArray.evaluate<Array<String?>>().toList())
+
+            // Non-string elements are converted element-wise
+            assertArrayEquals(arrayOf("1", "a", "true"), subject.evaluate<Array<String>>("""[1, "a", true]"""))
+            assertEquals(listOf("1", "a"), subject.evaluate<List<String>>("""[1, "a"]"""))
+
+            // Sparse (non-fast) arrays
+            assertEquals(listOf("a", null, "c"), subject.evaluate<List<String?>>("""var a = ["a"]; a[2] = "c"; a"""))
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testMapConversions() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val javaMap = mapOf("b" to 2, "a" to 1, "c €" to 3)
+
+        // THEN
+        runBlocking {
+            // Java -> JS -> Java (keeping the key order)
+            val jsMap = JsValue.fromJavaValue(subject, javaMap)
+            assertEquals("b,a,c €", subject.evaluate<String>("Object.keys($jsMap).join()"))
+            val roundTripMap: Map<String, Int> = jsMap.evaluate()
+            assertEquals(javaMap.toList(), roundTripMap.toList())
+
+            val nestedMap: Map<String, List<String>?> = subject.evaluate("""({ x: ["a", "b"], y: null })""")
+            assertEquals(mapOf("x" to listOf("a", "b"), "y" to null), nestedMap)
+
+            val anyMap: Map<String, Any?> = subject.evaluate("""({ s: "string", n: 1.5, b: true })""")
+            assertEquals(mapOf("s" to "string", "n" to 1.5, "b" to true), anyMap)
+
+            // Map keys are always own data properties (no inherited __proto__ setter)
+            val protoKeyMap = JsValue.fromJavaValue(subject, mapOf("__proto__" to 1, "x" to 2))
+            assertEquals("__proto__,x", subject.evaluate<String>("Object.keys($protoKeyMap).join()"))
+            assertTrue(subject.evaluate<Boolean>("Object.getPrototypeOf($protoKeyMap) === Object.prototype"))
+        }
+
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testMixedNumberArrayConversions() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val js = "[1, 2.5, -3, 4.0, 5, 6.75, 7, -8.5, 9]"
+
+        // THEN
+        runBlocking {
+            assertEquals(listOf(1, 2, -3, 4, 5, 6, 7, -8, 9), subject.evaluate<IntArray>(js).toList())
+            assertEquals(listOf(1L, 2L, -3L, 4L, 5L, 6L, 7L, -8L, 9L), subject.evaluate<LongArray>(js).toList())
+            assertEquals(listOf(1.0f, 2.5f, -3.0f, 4.0f, 5.0f, 6.75f, 7.0f, -8.5f, 9.0f), subject.evaluate<FloatArray>(js).toList())
+            assertEquals(listOf(1.0, 2.5, -3.0, 4.0, 5.0, 6.75, 7.0, -8.5, 9.0), subject.evaluate<DoubleArray>(js).toList())
+        }
+    }
+
+    @Test
+    fun testOutOfRangeNumberArrayConversions() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val js = "[3e9, -3e9, 1e20, -1e20, NaN, 2.5, 2147483648, -2147483649, 1, 3e9]"
+
+        // THEN
+        runBlocking {
+            // Saturating conversions (also with the bulk conversion of fast arrays)
+            assertEquals(
+                listOf(Int.MAX_VALUE, Int.MIN_VALUE, Int.MAX_VALUE, Int.MIN_VALUE, 0, 2, Int.MAX_VALUE, Int.MIN_VALUE, 1, Int.MAX_VALUE),
+                subject.evaluate<IntArray>(js).toList()
+            )
+
+            if (BuildConfig.FLAVOR == "quickjs") {
+                assertEquals(
+                    listOf(3_000_000_000L, -3_000_000_000L, Long.MAX_VALUE, Long.MIN_VALUE, 0L, 2L, 2_147_483_648L, -2_147_483_649L, 1L, 3_000_000_000L),
+                    subject.evaluate<LongArray>(js).toList()
+                )
+            }
+        }
+    }
+
     @Test
     fun testConversionErrors() {
         // GIVEN
@@ -1213,6 +3151,47 @@ class JsBridgeTest {
         }
     }
 
+    @Test
+    fun arrayBenchmark() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val sumJavaFuncJsValue = JsValue.createJsToJavaProxyFunction1(subject) { values: DoubleArray ->
+            values.sum()
+        }
+        val js = "Array.from({ length: 1000 }, function(_, i) { return i * 0.5; })"
+
+        runBlocking {
+            delay(500)
+
+            // JS -> Java (fast array read path)
+            Timber.i("Executing JS array -> DoubleArray conversions...")
+            val readDurationMs = measureTimeMillis {
+                for (i in 0 until ITERATION_COUNT) {
+                    val values: DoubleArray = subject.evaluate(js)
+                    assertEquals(1000, values.size)
+                }
+            }
+            Timber.i("-> $ITERATION_COUNT iterations in ${readDurationMs}ms")
+
+            // JS -> Java method arguments
+            Timber.i("Executing Java function calls with array arguments...")
+            val callDurationMs = measureTimeMillis {
+                val sum: Double = subject.evaluate("""
+                    |var values = $js;
+                    |var sum = 0;
+                    |for (var i = 0; i < $ITERATION_COUNT; ++i) {
+                    |  sum = $sumJavaFuncJsValue(values);
+                    |}
+                    |sum;
+                    |""".trimMargin())
+                assertEquals(249750.0, sum)
+            }
+            Timber.i("-> $ITERATION_COUNT iterations in ${callDurationMs}ms")
+
+            sumJavaFuncJsValue.hold()
+        }
+    }
+
     interface StressJsApi: JavaToJsInterface {
         fun registerCallback(cb: (Int) -> Unit)
         fun start()
@@ -1326,6 +3305,218 @@ class JsBridgeTest {
         subject.release()
     }
 
+    interface BatchJavaApi: JsToJavaInterface {
+        fun getValue(): Int
+    }
+
+    interface BatchJsApi: JavaToJsInterface {
+        fun getValue(): Deferred<Int>
+    }
+
+    @Test
+    fun testBatchedRegistration() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val count = 20
+        val javaApis = List(count) { i ->
+            object: BatchJavaApi {
+                override fun getValue() = i
+            }
+        }
+        val jsValues = List(count) { i -> JsValue(subject, "({ getValue: function() { return $i; } })") }
+
+        // WHEN
+        val javaApiJsValues = JsValue.createJsToJavaProxies(subject, javaApis.map { BatchJavaApi::class to it })
+        val jsApis = runBlocking {
+            JsValue.createJavaToJsProxies(subject, jsValues.map { it to BatchJsApi::class }, true)
+        }
+
+        // THEN
+        javaApiJsValues.forEachIndexed { i, javaApiJsValue ->
+            assertEquals(i, subject.evaluateBlocking<Int>("$javaApiJsValue.getValue()"))
+        }
+        runBlocking {
+            jsApis.forEachIndexed { i, jsApi ->
+                assertEquals(i, (jsApi as BatchJsApi).getValue().await())
+            }
+        }
+
+        // Hold the JS values whose associated JS name is used in string evaluation
+        javaApiJsValues.forEach { it.hold() }
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testAsyncIteratorFlow() {
+        if (BuildConfig.FLAVOR == "duktape") {
+            // No async generators on Duktape
+            return
+        }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val count = 1000
+        subject.evaluateBlocking<Unit>("""
+            |globalThis.isClosed = false;
+            |globalThis.generateValues = async function*(count) {
+            |  try {
+            |    for (var i = 0; i < count; ++i) {
+            |      yield i * 2;
+            |    }
+            |  } finally {
+            |    globalThis.isClosed = true;
+            |  }
+            |};""".trimMargin())
+
+        // WHEN
+        val values = runBlocking {
+            JsValue(subject, "generateValues($count)").toFlow<Int>(batchSize = 64).toList()
+        }
+        subject.evaluateBlocking<Unit>("globalThis.isClosed = false;")
+        val firstValues = runBlocking {
+            JsValue(subject, "generateValues($count)").toFlow<Int>(batchSize = 4).take(10).toList()
+        }
+
+        // THEN
+        assertEquals(List(count) { it * 2 }, values)
+        assertEquals(List(10) { it * 2 }, firstValues)
+        assertTrue(subject.evaluateBlocking<Boolean>("globalThis.isClosed"))
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testFlowAsyncIterable() {
+        if (BuildConfig.FLAVOR == "duktape") {
+            // No "for await" on Duktape
+            return
+        }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val count = 1000
+        val completion = CompletableDeferred<Throwable?>()
+        val infiniteFlow = flow {
+            var i = 0
+            while (true) emit(i++)
+        }.onCompletion { completion.complete(it) }
+        val sumValues: suspend (JsValue, Int) -> Int = JsValue.newFunction(subject, "iterable", "maxCount", """
+            |return (async function() {
+            |  var sum = 0;
+            |  var valueCount = 0;
+            |  for await (var value of iterable) {
+            |    sum += value;
+            |    if (++valueCount === maxCount) break;
+            |  }
+            |  return sum;
+            |})();""".trimMargin())
+
+        // WHEN
+        val sum = runBlocking {
+            sumValues(JsValue.fromFlow(subject, (0 until count).asFlow().map { it * 2 }, batchSize = 100), -1)
+        }
+        val firstSum = runBlocking {
+            sumValues(JsValue.fromFlow(subject, infiniteFlow, batchSize = 8), 10)
+        }
+
+        // THEN
+        assertEquals(List(count) { it * 2 }.sum(), sum)
+        assertEquals(45, firstSum)
+        runBlocking {
+            // The flow collection is cancelled on "break"
+            assertTrue(withTimeout(5000L) { completion.await() } is CancellationException)
+        }
+        assertTrue(errors.isEmpty())
+    }
+
+    interface TestCallbackRegistry: JsToJavaInterface {
+        fun addCallback(cb: (Int) -> Unit)
+    }
+
+    @Test
+    fun testSameJsCallbackGivenTwice() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val callbacks = mutableListOf<(Int) -> Unit>()
+        val callbackRegistry = object: TestCallbackRegistry {
+            override fun addCallback(cb: (Int) -> Unit) {
+                callbacks.add(cb)
+            }
+        }
+        val callbackRegistryJsValue = JsValue.createJsToJavaProxy(subject, callbackRegistry)
+
+        // WHEN
+        subject.evaluateBlocking<Unit>("""
+            |var cb = function(i) {};
+            |$callbackRegistryJsValue.addCallback(cb);
+            |$callbackRegistryJsValue.addCallback(cb);
+            |$callbackRegistryJsValue.addCallback(function(i) {});""".trimMargin())
+
+        // THEN
+        assertEquals(3, callbacks.size)
+        if (BuildConfig.FLAVOR == "quickjs") {
+            assertSame(callbacks[0], callbacks[1])
+        }
+        assertNotSame(callbacks[0], callbacks[2])
+
+        callbackRegistryJsValue.hold()
+    }
+
+    interface TestJsCallbackRegistry: JavaToJsInterface {
+        fun addCallback(cb: (Int) -> Unit)
+    }
+
+    @Test
+    fun testSameJavaLambdaGivenTwice() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val jsCallbacks = JsValue(subject, "[]")
+        val callbackRegistry: TestJsCallbackRegistry = JsValue(subject, """({
+            |  addCallback: function(cb) {
+            |    $jsCallbacks.push(cb);
+            |  }
+            |})""".trimMargin()
+        ).createJavaToJsProxy()
+        val javaCb: (Int) -> Unit = {}
+
+        // WHEN
+        callbackRegistry.addCallback(javaCb)
+        callbackRegistry.addCallback(javaCb)
+        callbackRegistry.addCallback {}
+
+        // THEN
+        runBlocking {
+            assertEquals(3, subject.evaluate<Int>("$jsCallbacks.length"))
+            if (BuildConfig.FLAVOR == "quickjs") {
+                assertTrue(subject.evaluate<Boolean>("$jsCallbacks[0] === $jsCallbacks[1]"))
+            }
+            assertFalse(subject.evaluate<Boolean>("$jsCallbacks[0] === $jsCallbacks[2]"))
+        }
+
+        jsCallbacks.hold()
+    }
+
+    @Test
+    fun testJsFunctionsWithSameSource() {
+        // GIVEN
+        val subject1 = createAndSetUpJsBridge()
+        val subject2 = createAndSetUpJsBridge()
+
+        // WHEN
+        // Same sources (whose compiled bytecode is shared) in both JsBridge instances
+        val results = listOf(subject1, subject2, subject1).map { subject ->
+            val calcSum: suspend (Int, Int) -> Int = JsValue.newFunction(subject, "a", "b", "return a + b;")
+                .createJavaToJsProxyFunction2()
+            val calcProduct: suspend (Int, Int) -> Int = JsValue(subject, "(function(a, b) { return a * b; })")
+                .createJavaToJsProxyFunction2()
+            runBlocking { calcSum(3, 4) to calcProduct(3, 4) }
+        }
+
+        // THEN
+        assertEquals(List(3) { 7 to 12 }, results)
+        assertTrue(errors.isEmpty())
+        subject1.release()  // (subject2 is released in cleanUp)
+    }
+
     @Test
     fun testMapJsFunctionToJava() {
         // GIVEN
@@ -1390,6 +3581,15 @@ class JsBridgeTest {
             val sum = calcSum(3, 4)
             assertEquals(7, sum)
 
+            // Call JS function calcSum() for a batch of arguments
+            val calcSumBatch: suspend (List<Pair<Int, Int>>) -> List<Int> = calcSumJsValue.createJavaToJsBatchProxyFunction2()
+            assertEquals(listOf(3, 7, 11), calcSumBatch(listOf(1 to 2, 3 to 4, 5 to 6)))
+            assertEquals(listOf(), calcSumBatch(listOf()))
+
+            // Call JS function getPromise() for a batch of arguments
+            val getPromiseBatch: suspend (List<String>) -> List<String> = getPromiseJsValue.createJavaToJsBatchProxyFunction1()
+            assertEquals(listOf("Hello a!", "Hello b!"), getPromiseBatch(listOf("a", "b")))
+
             // Call JS function calcSumFromAnonymousFunction(3, 4)
             val sumFromAnonymousFunction = calcSumFromAnonymousFunction(3, 4)
             assertEquals(7, sumFromAnonymousFunction)
@@ -1451,6 +3651,7 @@ class JsBridgeTest {
             val toUpperCaseJava =
                 JsValue.createJsToJavaProxyFunction1(subject) { s: String -> s.toUpperCase() }
             val calcSumJava = JsValue.createJsToJavaProxyFunction2(subject) { a: Int, b: Int -> a + b }
+            val scaleJava = JsValue.createJsToJavaProxyFunction2(subject) { a: Int, b: Double -> a * b }
             val setCustomTimeout: (() -> Unit, Long) -> Unit = { cb, msecs ->
                 GlobalScope.launch(Dispatchers.Main) {
                     delay(msecs)
@@ -1468,6 +3669,7 @@ class JsBridgeTest {
                 subject.evaluateBlocking("""$toUpperCaseJava("test string")""")
             )
             assertEquals(15, subject.evaluateBlocking("$calcSumJava(7, 8)"))
+            assertEquals(7.5, subject.evaluateBlocking("$scaleJava(3, 2.5)"))
 
             subject.evaluate<Unit>(
                 """
@@ -1526,10 +3728,90 @@ class JsBridgeTest {
 
         runBlocking {
             // WHEN
-            val result = transposeJs(matrix)
+            val result = transposeJs(matrix)
+
+            // THEN
+            assertArrayEquals(expected, result)
+        }
+    }
+
+    @Test
+    fun testLargeArraysFromJava() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        val describeJs: suspend (Array<String>, List<Int>, IntArray) -> String = JsValue.newFunction(subject, "strings", "ints", "primitives", """
+            |strings.push("pushed");
+            |return strings.length + ":" + strings[9999] + ":" + strings[10000] + "/" +
+            |  ints.length + ":" + ints[4999] + "/" + primitives.length + ":" + Array.isArray(primitives);
+            |""".trimMargin()
+        ).createJavaToJsProxyFunction3()
+
+        runBlocking {
+            // WHEN
+            val description = describeJs(Array(10000) { "s$it" }, List(5000) { it }, IntArray(0))
+
+            // THEN
+            assertEquals("10001:s9999:pushed/5000:4999/0:true", description)
+        }
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testStringCache() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            jvmConfig.stringCacheSize = 4
+        })
+
+        val describeJs: suspend (String, String) -> String = JsValue.newFunction(subject, "a", "b", """
+            |return a + ":" + a.length + "/" + b.length;
+            |""".trimMargin()
+        ).createJavaToJsProxyFunction2()
+
+        runBlocking {
+            // WHEN
+            val longString = "x".repeat(100)
+            val descriptions = (1..10).map { describeJs("event${it % 3}", "\u00e9\ud83d\ude00") }
+            val longDescription = describeJs(longString, "")
+            val emptyDescription = describeJs("", "")
+
+            // THEN
+            assertEquals((1..10).map { "event${it % 3}:6/3" }, descriptions)
+            assertEquals("$longString:100/0", longDescription)
+            assertEquals(":0/0", emptyDescription)
+        }
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testTypedArrays() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            jvmConfig.typedArrays = true
+        })
+
+        val describeJs: suspend (IntArray) -> String = JsValue.newFunction(subject, "a", """
+            |return a.constructor.name + ":" + Array.prototype.join.call(a, ",");
+            |""".trimMargin()
+        ).createJavaToJsProxyFunction1()
+
+        runBlocking {
+            // WHEN
+            val description = describeJs(intArrayOf(1, 2, 3))
+            val intArray: IntArray = subject.evaluate("new Int32Array([4, 5, 6])")
+            val byteArray: ByteArray = subject.evaluate("new Int8Array([1, -2, 3])")
+            val doubleArray: DoubleArray = subject.evaluate("new Float64Array([1.5, 2.5])")
+            val jsIntArray = JsValue.fromJavaValue(subject, intArrayOf(7, 8, 9))
+            val isInt32Array: Boolean = subject.evaluate("$jsIntArray instanceof Int32Array")
 
             // THEN
-            assertArrayEquals(expected, result)
+            assertEquals("Int32Array:1,2,3", description)
+            assertArrayEquals(intArrayOf(4, 5, 6), intArray)
+            assertArrayEquals(byteArrayOf(1, -2, 3), byteArray)
+            assertTrue(doubleArray.contentEquals(doubleArrayOf(1.5, 2.5)))
+            assertTrue(isInt32Array)
+            assertArrayEquals(intArrayOf(7, 8, 9), jsIntArray.evaluate<IntArray>())
         }
     }
 
@@ -1954,6 +4236,113 @@ class JsBridgeTest {
         }
     }
 
+    @Test
+    fun testRegisterJavaToJsInterfaceAfterGlobalReassignment() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val jsApiValue = JsValue(subject, """({
+          jsMethodReturningFulfilledPromise: function(msg) {
+            return "original " + msg;
+          }
+        });""")
+        val jsApi: TestJsApiInterface = jsApiValue.createJavaToJsProxy()
+        val jsLambda: suspend (String) -> String = JsValue(subject, "(function(msg) { return 'lambda ' + msg; })")
+            .createJavaToJsProxyFunction1()
+
+        runBlocking {
+            assertEquals("original 1", jsApi.jsMethodReturningFulfilledPromise("1").await())
+            assertEquals("lambda 1", jsLambda("1"))
+        }
+
+        // WHEN
+        // Replace the global JS variable: the registered JS object must still be called
+        subject.evaluateBlocking<Unit>("""globalThis["${jsApiValue.associatedJsName}"] = {};""")
+
+        // THEN
+        runBlocking {
+            assertEquals("original 2", jsApi.jsMethodReturningFulfilledPromise("2").await())
+            assertEquals("lambda 2", jsLambda("2"))
+        }
+        assertTrue(errors.isEmpty())
+    }
+
+    interface TestJsStubApi : JavaToJsInterface {
+        fun add(a: Int, b: Int): Int
+        fun addAsync(a: Int, b: Int): Deferred<Int>
+        suspend fun addSuspending(a: Int, b: Int): Int
+        fun log(msg: String)
+    }
+
+    // Hand-written stub (instead of a java.lang.reflect.Proxy)
+    class TestJsStubApiStub(private val caller: JsBridge.JavaToJsCaller) : TestJsStubApi {
+        private val addIndex = caller.methodIndex(TestJsStubApi::class.java.getMethod("add", Int::class.java, Int::class.java))
+        private val addAsyncIndex = caller.methodIndex("addAsync")
+        private val addSuspendingIndex = caller.methodIndex("addSuspending")
+        private val logIndex = caller.methodIndex("log")
+
+        override fun add(a: Int, b: Int) = caller.callBlocking(addIndex, a, b) as Int
+        @Suppress("UNCHECKED_CAST")
+        override fun addAsync(a: Int, b: Int) = caller.callAsync(addAsyncIndex, a, b) as Deferred<Int>
+        override suspend fun addSuspending(a: Int, b: Int) = caller.callSuspending(addSuspendingIndex, a, b) as Int
+        override fun log(msg: String) = caller.call(logIndex, msg)
+    }
+
+    @Test
+    fun testJavaToJsStub() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val jsApiValue = JsValue(subject, """({
+          add: function(a, b) { return a + b; },
+          addAsync: function(a, b) { return Promise.resolve(a + b); },
+          addSuspending: function(a, b) { return Promise.resolve(a + b); },
+          log: function(msg) { globalThis.loggedMsg = msg; }
+        });""")
+
+        // WHEN
+        val jsApi = jsApiValue.createJavaToJsStub(TestJsStubApi::class.java, true) { TestJsStubApiStub(it) }
+
+        // THEN
+        runBlocking {
+            assertEquals(3, jsApi.add(1, 2))
+            assertEquals(7, jsApi.addAsync(3, 4).await())
+            assertEquals(11, jsApi.addSuspending(5, 6))
+            jsApi.log("hello")
+            assertEquals("hello", subject.evaluate<String>("globalThis.loggedMsg"))
+        }
+        assertFailsWith<IllegalArgumentException> {
+            jsApiValue.createJavaToJsStub(TestJsStubApi::class.java) { it.methodIndex("unknown"); TestJsStubApiStub(it) }
+        }
+        assertFailsWith<IllegalArgumentException> {
+            jsApiValue.createJavaToJsStub(TestJsStubApi::class.java) { it.methodIndex(Any::class.java.getMethod("hashCode")); TestJsStubApiStub(it) }
+        }
+        assertTrue(errors.isEmpty())
+    }
+
+    interface TestJsPrimitiveApi : JavaToJsInterface {
+        fun describe(b: Boolean, i: Int, l: Long, f: Float, d: Double, s: Short, by: Byte): String
+        fun describeNullable(i: Int?, d: Double?): String
+    }
+
+    @Test
+    fun testJavaToJsPrimitiveArguments() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+        val jsApi: TestJsPrimitiveApi = JsValue(subject, """({
+          describe: function() { return Array.prototype.join.call(arguments, ","); },
+          describeNullable: function(i, d) { return i + "," + d; }
+        });""").createJavaToJsProxy()
+
+        // WHEN
+        // (the arguments of describe() are given to the native side as a single long[])
+        val result = jsApi.describe(true, -42, 1L shl 40, 1.5f, -0.25, 7, -8)
+        val nullableResult = jsApi.describeNullable(null, 2.5)
+
+        // THEN
+        assertEquals("true,-42,1099511627776,1.5,-0.25,7,-8", result)
+        assertEquals("null,2.5", nullableResult)
+        assertTrue(errors.isEmpty())
+    }
+
     @Test
     fun testRegisterJavaToJsInterfaceFromPromise() {
         // GIVEN
@@ -2015,6 +4404,32 @@ class JsBridgeTest {
         jsBridge = null  // avoid another release() in cleanUp()
     }
 
+    @Test
+    fun testBuiltInExtensionsFromCachedBytecode() {
+        // GIVEN
+        val firstJsBridge = createAndSetUpJsBridge()
+        val firstTypes = runBlocking {
+            firstJsBridge.evaluate<String>("[typeof setTimeout, typeof XMLHttpRequest].join()")
+        }
+        firstJsBridge.release()
+
+        // WHEN
+        // The extension scripts are loaded from the bytecode compiled for the first instance
+        val subject = createAndSetUpJsBridge()
+        val types = runBlocking {
+            subject.evaluate<String>("[typeof setTimeout, typeof XMLHttpRequest].join()")
+        }
+        val timeoutResult = runBlocking {
+            subject.evaluate<String>("new Promise(function(resolve) { setTimeout(function() { resolve('done'); }, 10); })")
+        }
+
+        // THEN
+        assertTrue(errors.isEmpty())
+        assertEquals("function,function", firstTypes)
+        assertEquals(firstTypes, types)
+        assertEquals("done", timeoutResult)
+    }
+
     @Test
     @Feature_SetTimeout
     fun testSetTimeout() {
@@ -2238,6 +4653,33 @@ class JsBridgeTest {
         assertTrue(errors.isEmpty())
     }
 
+    @Test
+    @Feature_SetTimeout
+    fun testManyTimers() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        // WHEN
+        subject.evaluateUnsync("""
+            |globalThis.timerOrder = [];
+            |for (var i = 0; i < 300; i++) {
+            |  (function(i) {
+            |    var id = setTimeout(function() { timerOrder.push(i); }, (2 - i % 3) * 20);
+            |    if (i % 10 == 0) clearTimeout(id);
+            |  })(i);
+            |}
+        """.trimMargin())
+        runBlocking { delay(500) }
+        val timerOrder: List<Int> = subject.evaluateBlocking("timerOrder")
+
+        // THEN
+        val expectedOrder = (0 until 300)
+            .filter { it % 10 != 0 }
+            .sortedBy { 2 - it % 3 }  // stable: same deadline => creation order
+        assertEquals(expectedOrder, timerOrder)
+        assertTrue(errors.isEmpty())
+    }
+
     @Test
     @Feature_SetTimeout
     fun testSetAndClearInterval() {
@@ -2728,6 +5170,189 @@ class JsBridgeTest {
         assertTrue(errors.isEmpty())
     }
 
+    @Test
+    fun testXmlHttpRequest_arrayBuffer() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        val url = "https://test.url/api/binary"
+        val responseText = "0123456789".repeat(10000)
+        httpInterceptor.mockRequest(url, responseText)
+
+        // WHEN
+        val js = """
+            var req = new XMLHttpRequest();
+            var lastLoaded = 0;
+            req.open("GET", "$url");
+            req.responseType = "arraybuffer";
+            req.onprogress = function(e) { lastLoaded = e.loaded; }
+            req.onload = function() {
+              var bytes = new Uint8Array(req.response);
+              javaFunctionMock("length: " + req.response.byteLength);
+              javaFunctionMock("bytes: " + bytes[0] + "," + bytes[9] + "," + bytes[bytes.length - 1]);
+              javaFunctionMock("progress: " + (lastLoaded > 0 && lastLoaded <= bytes.length));
+            }
+            req.onerror = function() { javaFunctionMock("XHR error: " + req.responseText); }
+            req.send();
+            """
+        subject.evaluateUnsync(js)
+
+        // THEN
+        // Note: mockk verify with ordering currently has some issues on API < 24
+        if (android.os.Build.VERSION.SDK_INT >= 24) {
+            verify(timeout = 2000, ordering = Ordering.SEQUENCE) {
+                jsToJavaFunctionMock(eq("length: 100000"))
+                jsToJavaFunctionMock(eq("bytes: 48,57,57"))
+                jsToJavaFunctionMock(eq("progress: true"))
+            }
+        }
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testXmlHttpRequest_charsets() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge()
+
+        val utf8Url = "https://test.url/api/utf8"
+        val latin1Url = "https://test.url/api/latin1"
+        val bomUrl = "https://test.url/api/bom"
+        httpInterceptor.mockRequest(utf8Url, "h\u00e9llo \ud83d\ude00", contentType = "text/plain")
+        httpInterceptor.mockRequest(latin1Url, "h\u00e9llo", contentType = "text/plain; charset=ISO-8859-1")
+        httpInterceptor.mockRequest(bomUrl, "\ufeff{\"key\": \"\ud83d\ude00\"}", contentType = "application/json")
+
+        // WHEN
+        val js = """
+            function get(url, responseType, cb) {
+              var req = new XMLHttpRequest();
+              req.open("GET", url);
+              req.responseType = responseType;
+              req.onload = function() { cb(req.response); }
+              req.onerror = function() { javaFunctionMock("XHR error: " + req.responseText); }
+              req.send();
+            }
+            get("$utf8Url", "text", function(text) {
+              javaFunctionMock("utf8: " + text.length + "," + text.charCodeAt(1) + "," + text.charCodeAt(6) + "," + text.charCodeAt(7));
+              get("$latin1Url", "text", function(text) {
+                javaFunctionMock("latin1: " + text.length + "," + text.charCodeAt(1));
+                get("$bomUrl", "json", function(json) {
+                  javaFunctionMock("bom: " + json.key.length + "," + json.key.charCodeAt(0));
+                });
+              });
+            });
+            """
+        subject.evaluateUnsync(js)
+
+        // THEN
+        // Note: mockk verify with ordering currently has some issues on API < 24
+        if (android.os.Build.VERSION.SDK_INT >= 24) {
+            verify(timeout = 2000, ordering = Ordering.SEQUENCE) {
+                jsToJavaFunctionMock(eq("utf8: 8,233,55357,56832"))
+                jsToJavaFunctionMock(eq("latin1: 5,233"))
+                jsToJavaFunctionMock(eq("bom: 2,55357"))
+            }
+        }
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testFetch() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            xhrConfig.okHttpClient = okHttpClient
+            fetchConfig.enabled = true
+        })
+
+        val url = "https://test.url/api/fetch"
+        val responseText = """{"testKey1": "testValue1", "testKey2": [1, 2, 3]}"""
+        val responseHeaders = """{"testResponseHeaderKey": "testResponseHeaderValue"}"""
+        httpInterceptor.mockRequest(url, responseText, responseHeaders)
+
+        // WHEN
+        val js = """
+            fetch("$url", { headers: { "testRequestHeaderKey": "testRequestHeaderValue" } })
+              .then(function(response) {
+                javaFunctionMock("status: " + response.status + " " + response.ok);
+                javaFunctionMock("header: " + response.headers.get("TestResponseHeaderKey"));
+                return response.json();
+              })
+              .then(function(json) {
+                javaFunctionMock("json: " + json.testKey1 + " " + json.testKey2.length);
+              })
+              .catch(function(e) {
+                javaFunctionMock("fetch error: " + e);
+              });
+            """
+        subject.evaluateUnsync(js)
+
+        // THEN
+        // Note: mockk verify with ordering currently has some issues on API < 24
+        if (android.os.Build.VERSION.SDK_INT >= 24) {
+            verify(timeout = 2000, ordering = Ordering.SEQUENCE) {
+                jsToJavaFunctionMock(eq("status: 200 true"))
+                jsToJavaFunctionMock(eq("header: testResponseHeaderValue"))
+                jsToJavaFunctionMock(eq("json: testValue1 3"))
+            }
+        }
+        assertTrue(errors.isEmpty())
+    }
+
+    @Test
+    fun testFetch_unreadBodies() {
+        // GIVEN
+        val closedBodyCount = AtomicInteger(0)
+        val countingOkHttpClient = OkHttpClient.Builder().addInterceptor { chain ->
+            val isLarge = chain.request().url.encodedPath.endsWith("/large")
+            val bodyText = if (isLarge) "0123456789".repeat(10000) else "small"
+            val source = object : ForwardingSource(Buffer().writeUtf8(bodyText)) {
+                override fun close() {
+                    closedBodyCount.incrementAndGet()
+                    super.close()
+                }
+            }.buffer()
+            Response.Builder()
+                .request(chain.request())
+                .protocol(Protocol.HTTP_1_1)
+                .code(200)
+                .message("OK")
+                .body(source.asResponseBody("text/plain".toMediaTypeOrNull(), bodyText.length.toLong()))
+                .build()
+        }.build()
+
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            xhrConfig.okHttpClient = okHttpClient
+            fetchConfig.enabled = true
+            fetchConfig.okHttpClient = countingOkHttpClient
+            fetchConfig.unreadBodyTimeoutMs = 200L
+        })
+
+        // WHEN
+        val count = 10
+        val js = """
+            var urls = [];
+            for (var i = 0; i < $count; i++) {
+              urls.push("https://test.url/api/" + i + "/small", "https://test.url/api/" + i + "/large");
+            }
+            Promise.all(urls.map(function(url) { return fetch(url); }))
+              .then(function(responses) {
+                javaFunctionMock("statuses: " + responses.every(function(response) { return response.ok; }));
+                setTimeout(function() {
+                  responses[1].text()
+                    .then(function() { javaFunctionMock("unexpected body"); })
+                    .catch(function(e) { javaFunctionMock("released: " + (e !== undefined)); });
+                }, 500);
+              });
+            """
+        subject.evaluateUnsync(js)
+
+        // THEN
+        verify(timeout = 2000) { jsToJavaFunctionMock(eq("statuses: true")) }
+        verify(timeout = 2000) { jsToJavaFunctionMock(eq("released: true")) }
+        verify(inverse = true) { jsToJavaFunctionMock(eq("unexpected body")) }
+        assertEquals(2 * count, closedBodyCount.get())
+        assertTrue(errors.isEmpty())
+    }
+
     @Test
     fun testConsole_asString() {
         // GIVEN
@@ -2836,6 +5461,49 @@ class JsBridgeTest {
         assertTrue(errors.isEmpty())
     }
 
+    @Test
+    fun testConsole_minPriorityAndRingBuffer() {
+        // GIVEN
+        var hasMessage = false
+        val config = JsBridgeConfig.bareConfig().apply {
+            consoleConfig.enabled = true
+            consoleConfig.mode = JsBridgeConfig.ConsoleConfig.Mode.AsString
+            consoleConfig.minPriority = Log.INFO
+            consoleConfig.ringBufferSize = 2
+            consoleConfig.appendMessage = { _, _ ->
+                hasMessage = true
+            }
+        }
+        val subject = JsBridge(config, context)
+        jsBridge = subject
+
+        // WHEN
+        val js = """
+            var converted = false;
+            var obj = { toString: function() { converted = true; return "obj"; } };
+            console.debug("dropped", obj);
+            console.log("dropped", obj);
+            var convertedWhenDropped = converted;
+            console.info("first info", 1);
+            console.warn("warning", obj);
+            console.error("error");
+            convertedWhenDropped;
+            """
+        val convertedWhenDropped: Boolean = runBlocking { subject.evaluate(js) }
+        val messages = runBlocking { subject.drainConsoleMessages() }
+        val drainedAgain = runBlocking { subject.drainConsoleMessages() }
+
+        // THEN
+        assertFalse(hasMessage)
+        assertFalse(convertedWhenDropped)
+        assertEquals(listOf(
+            Log.WARN to "warning obj",
+            Log.ERROR to "error"
+        ), messages)
+        assertTrue(drainedAgain.isEmpty())
+        assertTrue(errors.isEmpty())
+    }
+
     @Test
     fun testLocalStorage() {
         // GIVEN
@@ -2884,6 +5552,29 @@ class JsBridgeTest {
         assertNull(result3)
         assertTrue(errors.isEmpty())
     }
+
+    @Test
+    fun testLocalStorageItems() {
+        // GIVEN
+        val subject1 = createAndSetUpJsBridge()
+        val subject2 = createAndSetUpJsBridge()
+
+        // WHEN
+        val result1 = subject1.evaluateBlocking<String>("""
+            localStorage.clear();
+            localStorage.setItem("number", 42);
+            localStorage.setItem("removed", "value");
+            localStorage.removeItem("removed");
+            [localStorage.length, localStorage.key(0), typeof localStorage.getItem("number"), localStorage.getItem("removed")].join(",");
+            """)
+        val result2 = subject2.evaluateBlocking<String>("""localStorage.getItem("number");""")
+
+        // THEN
+        assertEquals("1,number,string,", result1)
+        assertEquals("42", result2)
+        assertTrue(errors.isEmpty())
+    }
+
     data class EmbeddedObject(val a: Int, val b: String)
 
     @Test
@@ -2927,6 +5618,124 @@ class JsBridgeTest {
         }
     }
 
+    interface LazyJsToJavaInterface : JsToJavaInterface {
+        fun ping(): String
+        fun add(a: Int, b: Int): Int
+    }
+
+    @Test
+    fun testJsToJavaProxyWithLazyMethods() {
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            jvmConfig.lazyJavaObjectMethods = true
+        })
+        val javaObject = object : LazyJsToJavaInterface {
+            override fun ping() = "pong"
+            override fun add(a: Int, b: Int) = a + b
+        }
+        val jsToJavaProxy = JsValue.createJsToJavaProxy(subject, javaObject)
+
+        // WHEN
+        val methodNames: String = subject.evaluateBlocking("Object.keys($jsToJavaProxy).sort().join(',')")
+        val pingResult: String = subject.evaluateBlocking("$jsToJavaProxy.ping()")
+        val addResult: Int = subject.evaluateBlocking("$jsToJavaProxy.add(2, 3)")
+        val isSameFunction: Boolean = subject.evaluateBlocking("$jsToJavaProxy.add === $jsToJavaProxy.add")
+        val objectBack: JsToJavaProxy<LazyJsToJavaInterface> = jsToJavaProxy.evaluateBlocking()
+
+        // THEN
+        assertEquals("add,ping", methodNames)
+        assertEquals("pong", pingResult)
+        assertEquals(5, addResult)
+        assertTrue(isSameFunction)
+        assertSame(javaObject, objectBack.obj)
+
+        runBlocking {
+            waitForDone(subject)
+        }
+    }
+
+    @Test
+    fun testJsToJavaProxiesSharingPrototype() {
+        if (BuildConfig.FLAVOR == "duktape") { return }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            jvmConfig.sharedJavaObjectPrototypes = true
+        })
+        val javaObject1 = object : LazyJsToJavaInterface {
+            override fun ping() = "pong1"
+            override fun add(a: Int, b: Int) = a + b
+        }
+        val javaObject2 = object : LazyJsToJavaInterface {
+            override fun ping() = "pong2"
+            override fun add(a: Int, b: Int) = a * b
+        }
+        val jsToJavaProxy1 = JsValue.createJsToJavaProxy(subject, javaObject1)
+        val jsToJavaProxy2 = JsValue.createJsToJavaProxy(subject, javaObject2)
+        val otherJavaObject = object : BatchJavaApi {
+            override fun getValue() = 42
+        }
+        val otherJsToJavaProxy = JsValue.createJsToJavaProxy(subject, otherJavaObject)
+
+        // WHEN
+        val isSamePrototype: Boolean = subject.evaluateBlocking("Object.getPrototypeOf($jsToJavaProxy1) === Object.getPrototypeOf($jsToJavaProxy2)")
+        val isSameFunction: Boolean = subject.evaluateBlocking("$jsToJavaProxy1.ping === $jsToJavaProxy2.ping")
+        val pingResults: String = subject.evaluateBlocking("$jsToJavaProxy1.ping() + ',' + $jsToJavaProxy2.ping()")
+        val addResult: Int = subject.evaluateBlocking("$jsToJavaProxy2.add.call($jsToJavaProxy1, 2, 3)")
+        val detachedCallError: String = subject.evaluateBlocking("""
+            |var ping = $jsToJavaProxy1.ping;
+            |try { ping(); "no error" } catch (e) { e.name }""".trimMargin())
+        val otherObjectCallError: String = subject.evaluateBlocking("""
+            |try { $jsToJavaProxy1.add.call($otherJsToJavaProxy, 2, 3); "no error" } catch (e) { e.name }""".trimMargin())
+        val objectBack: JsToJavaProxy<LazyJsToJavaInterface> = jsToJavaProxy2.evaluateBlocking()
+
+        // THEN
+        assertTrue(isSamePrototype)
+        assertTrue(isSameFunction)
+        assertEquals("pong1,pong2", pingResults)
+        assertEquals(5, addResult)
+        assertEquals("TypeError", detachedCallError)
+        assertEquals("TypeError", otherObjectCallError)
+        assertSame(javaObject2, objectBack.obj)
+
+        runBlocking {
+            waitForDone(subject)
+        }
+    }
+
+    @Test
+    fun testJsToJavaProxyWithLightMethods() {
+        if (BuildConfig.FLAVOR == "quickjs") { return }
+
+        // GIVEN
+        val subject = createAndSetUpJsBridge(JsBridgeConfig.standardConfig(NAMESPACE).apply {
+            jvmConfig.lightJavaObjectMethods = true
+        })
+        val javaObject = object : LazyJsToJavaInterface {
+            override fun ping() = "pong"
+            override fun add(a: Int, b: Int) = a + b
+        }
+        val jsToJavaProxy = JsValue.createJsToJavaProxy(subject, javaObject)
+
+        // WHEN
+        val methodNames: String = subject.evaluateBlocking("Object.keys($jsToJavaProxy).sort().join(',')")
+        val pingResult: String = subject.evaluateBlocking("$jsToJavaProxy.ping()")
+        val addResult: Int = subject.evaluateBlocking("$jsToJavaProxy.add.call($jsToJavaProxy, 2, 3)")
+        val detachedCallError: String = subject.evaluateBlocking("""
+            |var add = $jsToJavaProxy.add;
+            |try { add(2, 3); "no error" } catch (e) { e.name }""".trimMargin())
+
+        // THEN
+        assertEquals("add,ping", methodNames)
+        assertEquals("pong", pingResult)
+        assertEquals(5, addResult)
+        assertEquals("TypeError", detachedCallError)
+
+        runBlocking {
+            waitForDone(subject)
+        }
+    }
+
     // JsExpectations
     // ---
 
@@ -3026,9 +5835,10 @@ class JsBridgeTest {
         config: JsBridgeConfig = JsBridgeConfig.standardConfig(NAMESPACE).apply {
             xhrConfig.okHttpClient = okHttpClient
         },
+        sharedRuntimeWith: JsBridge? = null,
     ): JsBridge {
 
-        return JsBridge(config, context).also { jsBridge ->
+        return JsBridge(config, context, sharedRuntimeWith).also { jsBridge ->
             this@JsBridgeTest.jsBridge = jsBridge
 
             jsBridge.registerErrorListener(createErrorListener())
@@ -30,11 +30,12 @@ class TestHttpInterceptor : Interceptor {
         url: String,
         responseText: String,
         responseHeadersJson: String = "{}",
-        delayMsecs: Long? = null
+        delayMsecs: Long? = null,
+        contentType: String = "application/json"
     ) {
         val request = Request.Builder().url(url).build()
         val protocol = Protocol.HTTP_1_1
-        val responseBody = responseText.toResponseBody("application/json".toMediaTypeOrNull())
+        val responseBody = responseText.toResponseBody(contentType.toMediaTypeOrNull())
         val responseHeaders = Headers.Builder().also { headersBuilder ->
             JSONObject(responseHeadersJson).let { headersObject ->
                 headersObject.keys().forEach { key ->
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// fetch() with minimal Headers and Response classes: the requests are performed by OkHttp and the
+// body is converted natively when it is consumed via text(), json() or arrayBuffer() (see
+// FetchExtension.kt).
+(function() {
+  var fetchJava = FetchExtension_fetch_java;
+  var readBodyJava = FetchExtension_readBody_java;
+
+  // Headers
+  // ---
+
+  var Headers = function(init) {
+    this._entries = [];  // [lowercase name, value] arrays
+
+    if (!init) return;
+
+    var that = this;
+    if (init instanceof Headers) {
+      init.forEach(function(value, name) { that.append(name, value); });
+    } else if (Array.isArray(init)) {
+      init.forEach(function(keyValue) { that.append(keyValue[0], keyValue[1]); });
+    } else {
+      Object.keys(init).forEach(function(name) { that.append(name, init[name]); });
+    }
+  };
+
+  Headers.prototype.append = function(name, value) {
+    this._entries.push([String(name).toLowerCase(), String(value)]);
+  };
+
+  Headers.prototype.delete = function(name) {
+    name = String(name).toLowerCase();
+    this._entries = this._entries.filter(function(entry) { return entry[0] !== name; });
+  };
+
+  Headers.prototype.get = function(name) {
+    name = String(name).toLowerCase();
+    var values = [];
+    this._entries.forEach(function(entry) {
+      if (entry[0] === name) values.push(entry[1]);
+    });
+    return values.length > 0 ? values.join(", ") : null;
+  };
+
+  Headers.prototype.has = function(name) {
+    return this.get(name) !== null;
+  };
+
+  Headers.prototype.set = function(name, value) {
+    this.delete(name);
+    this.append(name, value);
+  };
+
+  Headers.prototype.forEach = function(callback, thisArg) {
+    var that = this;
+    this._entries.forEach(function(entry) { callback.call(thisArg, entry[1], entry[0], that); });
+  };
+
+
+  // Response
+  // ---
+
+  // responseInfo: [responseId, status, statusText, url, rawHeaders, redirected] (responseId 0: empty
+  // body)
+  var Response = function(responseInfo) {
+    this._responseId = responseInfo[0];
+    this.status = responseInfo[1];
+    this.statusText = responseInfo[2];
+    this.url = responseInfo[3];
+    this.ok = this.status >= 200 && this.status < 300;
+    this.redirected = responseInfo[5];
+    this.type = "basic";
+    this.bodyUsed = false;
+    this.headers = new Headers();
+
+    // rawHeaders: "key: value\r\n" lines
+    var lines = responseInfo[4].split("\r\n");
+    for (var i = 0; i < lines.length; i++) {
+      var separatorIndex = lines[i].indexOf(": ");
+      if (separatorIndex < 0) continue;
+      this.headers.append(lines[i].substring(0, separatorIndex), lines[i].substring(separatorIndex + 2));
+    }
+  };
+
+  // type: "arraybuffer", "json" or "text"
+  Response.prototype._consumeBody = function(type) {
+    if (this.bodyUsed) {
+      return Promise.reject(new TypeError("Body has already been consumed"));
+    }
+    this.bodyUsed = true;
+
+    if (this._responseId === 0) {
+      switch (type) {
+        case "arraybuffer": return Promise.resolve(new ArrayBuffer(0));
+        case "json": return Promise.reject(new SyntaxError("Unexpected end of JSON input"));
+        default: return Promise.resolve("");
+      }
+    }
+
+    return readBodyJava(this._responseId, type);
+  };
+
+  Response.prototype.arrayBuffer = function() {
+    return this._consumeBody("arraybuffer");
+  };
+
+  Response.prototype.json = function() {
+    return this._consumeBody("json");
+  };
+
+  Response.prototype.text = function() {
+    return this._consumeBody("text");
+  };
+
+
+  // fetch()
+  // ---
+
+  function fetch(input, init) {
+    init = init || {};
+
+    var isRequestObject = typeof input === "object" && input !== null;
+    var url = isRequestObject ? input.url : String(input);
+    var method = String(init.method || (isRequestObject && input.method) || "GET").toUpperCase();
+    var headers = new Headers(init.headers || (isRequestObject && input.headers) || null);
+
+    var textBody = null;
+    var binaryBody = null;
+    var body = init.body;
+    if (body instanceof ArrayBuffer) {
+      binaryBody = new Uint8Array(body);
+    } else if (ArrayBuffer.isView(body)) {
+      binaryBody = new Uint8Array(body.buffer, body.byteOffset, body.byteLength);
+    } else if (body !== undefined && body !== null) {
+      textBody = String(body);
+      if (!headers.has("content-type")) {
+        headers.set("content-type", "text/plain;charset=UTF-8");
+      }
+    }
+
+    // Headers are given as a flat [key1, value1, key2, value2, ...] array
+    var flatHeaders = [];
+    headers.forEach(function(value, name) { flatHeaders.push(name, value); });
+
+    return fetchJava(method, url, flatHeaders, textBody, binaryBody).then(function(responseInfo) {
+      return new Response(responseInfo);
+    });
+  }
+
+  globalThis.Headers = Headers;
+  globalThis.Response = Response;
+  globalThis.fetch = fetch;
+}());
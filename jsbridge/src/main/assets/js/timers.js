@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// setTimeout() and setInterval() timers ordered by deadline in a min-heap: all the due callbacks
+// run in a single JS-thread slice and Kotlin is only woken up for the next deadline (see
+// SetTimeoutExtension.kt).
+(function() {
+  var scheduleJava = SetTimeoutExtension_schedule_java;
+  var TIMEOUT_MAX = Math.pow(2, 31) - 1;
+
+  var heap = [];  // timers ordered by deadline (then by id)
+  var activeTimers = {};  // id -> timer
+  var lastId = 0;
+  var scheduledDeadline = Infinity;  // deadline of the pending Kotlin wake-up
+
+  function isBefore(a, b) {
+    return a.deadline < b.deadline || (a.deadline === b.deadline && a.id < b.id);
+  }
+
+  function swap(i, j) {
+    var timer = heap[i];
+    heap[i] = heap[j];
+    heap[j] = timer;
+  }
+
+  function push(timer) {
+    var i = heap.push(timer) - 1;
+    while (i > 0) {
+      var parent = (i - 1) >> 1;
+      if (!isBefore(heap[i], heap[parent])) break;
+      swap(i, parent);
+      i = parent;
+    }
+  }
+
+  function pop() {
+    var top = heap[0];
+    var last = heap.pop();
+    if (heap.length > 0) {
+      heap[0] = last;
+      var i = 0;
+      while (true) {
+        var left = 2 * i + 1, right = left + 1, smallest = i;
+        if (left < heap.length && isBefore(heap[left], heap[smallest])) smallest = left;
+        if (right < heap.length && isBefore(heap[right], heap[smallest])) smallest = right;
+        if (smallest === i) break;
+        swap(i, smallest);
+        i = smallest;
+      }
+    }
+    return top;
+  }
+
+  // Only wake up Kotlin again when the next deadline is earlier than the scheduled one
+  function schedule() {
+    if (heap.length === 0 || heap[0].deadline >= scheduledDeadline) return;
+    scheduledDeadline = heap[0].deadline;
+    scheduleJava(Math.max(0, scheduledDeadline - Date.now()));
+  }
+
+  function addTimer(cb, msecs, args, repeat) {
+    // undefined, null and wrong variable type (e.g. string) are valid values for timeout == no delay
+    // "1000" string is converted into a number
+    msecs *= 1;  // Coalesce to number or NaN
+    if (!(msecs >= 1 && msecs <= TIMEOUT_MAX)) {
+      msecs = 0;
+    }
+
+    var timer = { id: ++lastId, deadline: Date.now() + msecs, cb: cb, args: args, interval: repeat ? msecs : -1 };
+    activeTimers[timer.id] = timer;
+    push(timer);
+    schedule();
+    return timer.id;
+  }
+
+  // Cleared timers are removed from the heap once due
+  function clearTimer(id) {
+    delete activeTimers[id];
+  }
+
+  // Run all the due callbacks (except the ones of timers created meanwhile)
+  function runDueTimers() {
+    scheduledDeadline = Infinity;
+    var now = Date.now();
+    var maxId = lastId;
+
+    try {
+      while (heap.length > 0 && heap[0].deadline <= now && heap[0].id <= maxId) {
+        var timer = pop();
+        if (activeTimers[timer.id] !== timer) continue;
+
+        if (timer.interval >= 0) {
+          timer.deadline = now + Math.max(timer.interval, 1);
+          push(timer);
+        } else {
+          delete activeTimers[timer.id];
+        }
+
+        timer.cb.apply(null, timer.args);
+      }
+    } finally {
+      // Remaining timers (e.g. after an exception) are run after the next wake-up
+      schedule();
+    }
+  }
+
+  SetTimeoutExtension_init_java(runDueTimers);
+
+  globalThis.setTimeout = function(cb, msecs) {
+    return addTimer(cb, msecs, [].slice.call(arguments, 2), false);
+  };
+
+  globalThis.setInterval = function(cb, msecs) {
+    return addTimer(cb, msecs, [].slice.call(arguments, 2), true);
+  };
+
+  globalThis.clearTimeout = clearTimer;
+  globalThis.clearInterval = clearTimer;
+})();
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Minimal Web Worker support: each Worker runs its script in a separate JsBridge (own JS thread)
+// and the messages are structured clones (see WorkerExtension.kt).
+(function() {
+  var createJava = WorkerExtension_create_java;
+  var postMessageJava = WorkerExtension_postMessage_java;
+  var terminateJava = WorkerExtension_terminate_java;
+
+  // Event listeners of a Worker instance (same as in the worker global scope, see worker_scope.js)
+  function EventTargetMixin(target) {
+    var listeners = {};
+
+    target.addEventListener = function(type, listener) {
+      (listeners[type] = listeners[type] || []).push(listener);
+    };
+
+    target.removeEventListener = function(type, listener) {
+      var typeListeners = listeners[type] || [];
+      var index = typeListeners.indexOf(listener);
+      if (index >= 0) typeListeners.splice(index, 1);
+    };
+
+    target.dispatchEvent = function(event) {
+      var handler = target["on" + event.type];
+      if (typeof handler === "function") handler.call(target, event);
+      (listeners[event.type] || []).slice().forEach(function(listener) {
+        listener.call(target, event);
+      });
+    };
+  }
+
+  function Worker(url) {
+    var self = this;
+    EventTargetMixin(this);
+    this.onmessage = null;
+    this.onerror = null;
+
+    this._id = createJava(String(url), function(data) {
+      self.dispatchEvent({ type: "message", data: data, target: self });
+    }, function(message) {
+      self.dispatchEvent({ type: "error", message: message, target: self });
+    });
+  }
+
+  Worker.prototype.postMessage = function(data) {
+    postMessageJava(this._id, data);
+  };
+
+  Worker.prototype.terminate = function() {
+    terminateJava(this._id);
+  };
+
+  globalThis.Worker = Worker;
+})();
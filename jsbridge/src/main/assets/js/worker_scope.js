@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Global scope of a Worker script (see worker.js and WorkerExtension.kt)
+(function() {
+  var postMessageJava = WorkerScope_postMessage_java;
+  var closeJava = WorkerScope_close_java;
+  var listeners = {};
+
+  globalThis.self = globalThis;
+  globalThis.onmessage = null;
+
+  globalThis.addEventListener = function(type, listener) {
+    (listeners[type] = listeners[type] || []).push(listener);
+  };
+
+  globalThis.removeEventListener = function(type, listener) {
+    var typeListeners = listeners[type] || [];
+    var index = typeListeners.indexOf(listener);
+    if (index >= 0) typeListeners.splice(index, 1);
+  };
+
+  globalThis.postMessage = function(data) {
+    postMessageJava(data);
+  };
+
+  globalThis.close = function() {
+    closeJava();
+  };
+
+  // Called from Java for each message posted by the parent
+  globalThis.WorkerScope_dispatchMessage = function(data) {
+    var event = { type: "message", data: data, target: globalThis };
+    if (typeof globalThis.onmessage === "function") globalThis.onmessage(event);
+    (listeners.message || []).slice().forEach(function(listener) {
+      listener.call(globalThis, event);
+    });
+  };
+})();
@@ -51,15 +51,15 @@ function createProgressEventPayload(options) {
         defaultPrevented: false,
         eventPhase: 0,
         isTrusted: true,
-        lengthComputable: false,
-        loaded: -1,
+        lengthComputable: options.total >= 0,
+        loaded: options.loaded !== undefined ? options.loaded : -1,
         path: [],
         returnValue: true,
         srcElement: options.xhr,
         currentTarget: options.xhr,
         target: options.xhr,
         timeStamp: 0,
-        total: -1,
+        total: options.total !== undefined ? options.total : -1,
         preventDefault: noop,
         stopImmediatePropagation: noop,
         stopPropagation: noop
@@ -127,10 +127,23 @@ XMLHttpRequest.prototype.send = function(data) {
     this.onloadstart();
   }
 
+  // Request headers are given as a flat [key1, value1, key2, value2, ...] array
+  var requestHeaders = [];
+  for (var i = 0; i < this._requestHeaders.length; i++) {
+    requestHeaders.push(this._requestHeaders[i][0], this._requestHeaders[i][1]);
+  }
+
   var that = this;
-  sendJava(this._httpMethod, this._url, this._requestHeaders, this.timeout, data || null, function(responseInfo, responseText, error) {
-    that._send_java_callback(responseInfo, responseText, error);
-  });
+  sendJava(this._httpMethod, this._url, requestHeaders, this.timeout, data || null, this.responseType || "text",
+    function(statusCode, statusText, rawHeaders) {
+      that._headers_java_callback(statusCode, statusText, rawHeaders);
+    },
+    function(loaded, total) {
+      that._progress_java_callback(loaded, total);
+    },
+    function(response, error) {
+      that._send_java_callback(response, error);
+    });
 };
 
 XMLHttpRequest.prototype.addEventListener = function(eventName, handler) {
@@ -142,11 +155,42 @@ XMLHttpRequest.prototype.abort = function() {
   // Note: this.onreadystatechange() is not supposed to be called according to the XHR specs
 }
 
-// responseInfo: {statusCode, statusText, responseHeaders}
-XMLHttpRequest.prototype._send_java_callback = function(responseInfo, responseText, error) {
+// rawHeaders: "key: value\r\n" lines
+XMLHttpRequest.prototype._headers_java_callback = function(statusCode, statusText, rawHeaders) {
+  if (this.readyState != XMLHttpRequest.LOADING) {
+    return;
+  }
+
+  this.responseURL = this._url;
+  this.status = statusCode;
+  this.statusText = statusText;
+  this._responseHeaders = [];
+
+  var lines = rawHeaders.split("\r\n");
+  for (var i = 0; i < lines.length; i++) {
+    var separatorIndex = lines[i].indexOf(": ");
+    if (separatorIndex < 0) continue;
+    this._responseHeaders.push([lines[i].substring(0, separatorIndex), lines[i].substring(separatorIndex + 2)]);
+  }
+};
+
+// total: -1 if unknown
+XMLHttpRequest.prototype._progress_java_callback = function(loaded, total) {
+  if (this.readyState != XMLHttpRequest.LOADING) {
+    return;
+  }
+
+  var payload = createProgressEventPayload({ type: 'progress', xhr: this, loaded: loaded, total: total });
+  if (typeof this.onprogress === "function") {
+    this.onprogress(payload);
+  }
+  emit(this._eventListeners, 'progress', payload);
+};
+
+// response: body converted according to responseType (string, ArrayBuffer or parsed JSON)
+XMLHttpRequest.prototype._send_java_callback = function(response, error) {
   //console.log("XMLHttpRequest._send_java_callback");
-  //console.log("- responseInfo =", JSON.stringify(responseInfo));
-  //console.log("- responseText =", responseText);
+  //console.log("- response =", response);
   //console.log("- error =", error);
 
   if (this.readyState === XMLHttpRequest.UNSENT) {
@@ -165,13 +209,8 @@ XMLHttpRequest.prototype._send_java_callback = function(responseInfo, responseTe
     return;
   }
 
-  // Response info
+  // Note: the response info has already been set by _headers_java_callback()
   // TODO: responseXML?
-  this.responseURL = this._url;
-  this.status = responseInfo.statusCode;
-  this.statusText = responseInfo.statusText;
-  this._responseHeaders = responseInfo.responseHeaders || [];
-
   this.readyState = XMLHttpRequest.DONE;
 
   // Response
@@ -181,30 +220,23 @@ XMLHttpRequest.prototype._send_java_callback = function(responseInfo, responseTe
   if (error) {
     this.responseText = error;
   } else {
-    this.responseText = responseText;
-
     switch (this.responseType) {
       case "":
       case "text":
-        this.response = this.responseText;
+        this.responseText = response;
+        this.response = response;
         break;
       case "arraybuffer":
-        error = "XHR arraybuffer response is not supported!";
+      case "json":
+        this.response = response;
         break;
       case "document":
-        this.response = this.responseText;
-        this.responseXML = this.responseText;
-        break;
-      case "json":
-        try {
-            this.response = JSON.parse(responseText);
-        }
-        catch (e) {
-            error = "Could not parse JSON response: " + responseText;
-        }
+        this.responseText = response;
+        this.response = response;
+        this.responseXML = response;
         break;
       default:
-        error = "Unsupported responseType: " + responseInfo.responseType;
+        error = "Unsupported responseType: " + this.responseType;
     }
   }
 
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "AllocationStats.h"
+
+#if defined(JSBRIDGE_ALLOCATION_STATS)
+
+#include <array>
+#include <atomic>
+#include <cstdarg>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+namespace {
+  std::array<std::atomic<int64_t>, static_cast<size_t>(AllocationStats::Counter::_Count)> s_counters {};
+
+  // Copy of the original JNI function table with the counting hooks below
+  const JNINativeInterface *s_originalFunctions = nullptr;
+  JNINativeInterface s_countingFunctions;
+  std::once_flag s_countingFunctionsOnce;
+
+  inline void countLocalRef() {
+    AllocationStats::count(AllocationStats::Counter::JniLocalRefs);
+  }
+
+  inline void countGlobalRef() {
+    AllocationStats::count(AllocationStats::Counter::JniGlobalRefs);
+  }
+
+  // Forward to the original function and count the returned (non-null) ref
+#define JSBRIDGE_COUNTING_JNI_FUNCTION(countFunction, ReturnType, name, params, args) \
+  ReturnType JNICALL counting##name params { \
+    ReturnType ret = s_originalFunctions->name args; \
+    if (ret != nullptr) countFunction(); \
+    return ret; \
+  }
+
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jobject, NewLocalRef, (JNIEnv *env, jobject o), (env, o))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jclass, FindClass, (JNIEnv *env, const char *name), (env, name))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jclass, GetObjectClass, (JNIEnv *env, jobject o), (env, o))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jthrowable, ExceptionOccurred, (JNIEnv *env), (env))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jobject, NewObjectV, (JNIEnv *env, jclass c, jmethodID m, va_list a), (env, c, m, a))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jobject, NewObjectA, (JNIEnv *env, jclass c, jmethodID m, const jvalue *a), (env, c, m, a))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jobject, CallObjectMethodV, (JNIEnv *env, jobject o, jmethodID m, va_list a), (env, o, m, a))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jobject, CallObjectMethodA, (JNIEnv *env, jobject o, jmethodID m, const jvalue *a), (env, o, m, a))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jobject, CallStaticObjectMethodV, (JNIEnv *env, jclass c, jmethodID m, va_list a), (env, c, m, a))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jobject, CallStaticObjectMethodA, (JNIEnv *env, jclass c, jmethodID m, const jvalue *a), (env, c, m, a))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jobject, GetObjectField, (JNIEnv *env, jobject o, jfieldID f), (env, o, f))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jobject, GetStaticObjectField, (JNIEnv *env, jclass c, jfieldID f), (env, c, f))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jstring, NewString, (JNIEnv *env, const jchar *s, jsize len), (env, s, len))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jstring, NewStringUTF, (JNIEnv *env, const char *s), (env, s))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jobjectArray, NewObjectArray, (JNIEnv *env, jsize len, jclass c, jobject init), (env, len, c, init))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jobject, GetObjectArrayElement, (JNIEnv *env, jobjectArray a, jsize i), (env, a, i))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jbooleanArray, NewBooleanArray, (JNIEnv *env, jsize len), (env, len))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jbyteArray, NewByteArray, (JNIEnv *env, jsize len), (env, len))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jcharArray, NewCharArray, (JNIEnv *env, jsize len), (env, len))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jshortArray, NewShortArray, (JNIEnv *env, jsize len), (env, len))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jintArray, NewIntArray, (JNIEnv *env, jsize len), (env, len))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jlongArray, NewLongArray, (JNIEnv *env, jsize len), (env, len))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jfloatArray, NewFloatArray, (JNIEnv *env, jsize len), (env, len))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jdoubleArray, NewDoubleArray, (JNIEnv *env, jsize len), (env, len))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countLocalRef, jobject, NewDirectByteBuffer, (JNIEnv *env, void *address, jlong capacity), (env, address, capacity))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countGlobalRef, jobject, NewGlobalRef, (JNIEnv *env, jobject o), (env, o))
+  JSBRIDGE_COUNTING_JNI_FUNCTION(countGlobalRef, jweak, NewWeakGlobalRef, (JNIEnv *env, jobject o), (env, o))
+
+#undef JSBRIDGE_COUNTING_JNI_FUNCTION
+
+  void initCountingFunctions(const JNINativeInterface *originalFunctions) {
+    s_originalFunctions = originalFunctions;
+    s_countingFunctions = *originalFunctions;
+
+    s_countingFunctions.NewLocalRef = countingNewLocalRef;
+    s_countingFunctions.FindClass = countingFindClass;
+    s_countingFunctions.GetObjectClass = countingGetObjectClass;
+    s_countingFunctions.ExceptionOccurred = countingExceptionOccurred;
+    s_countingFunctions.NewObjectV = countingNewObjectV;
+    s_countingFunctions.NewObjectA = countingNewObjectA;
+    s_countingFunctions.CallObjectMethodV = countingCallObjectMethodV;
+    s_countingFunctions.CallObjectMethodA = countingCallObjectMethodA;
+    s_countingFunctions.CallStaticObjectMethodV = countingCallStaticObjectMethodV;
+    s_countingFunctions.CallStaticObjectMethodA = countingCallStaticObjectMethodA;
+    s_countingFunctions.GetObjectField = countingGetObjectField;
+    s_countingFunctions.GetStaticObjectField = countingGetStaticObjectField;
+    s_countingFunctions.NewString = countingNewString;
+    s_countingFunctions.NewStringUTF = countingNewStringUTF;
+    s_countingFunctions.NewObjectArray = countingNewObjectArray;
+    s_countingFunctions.GetObjectArrayElement = countingGetObjectArrayElement;
+    s_countingFunctions.NewBooleanArray = countingNewBooleanArray;
+    s_countingFunctions.NewByteArray = countingNewByteArray;
+    s_countingFunctions.NewCharArray = countingNewCharArray;
+    s_countingFunctions.NewShortArray = countingNewShortArray;
+    s_countingFunctions.NewIntArray = countingNewIntArray;
+    s_countingFunctions.NewLongArray = countingNewLongArray;
+    s_countingFunctions.NewFloatArray = countingNewFloatArray;
+    s_countingFunctions.NewDoubleArray = countingNewDoubleArray;
+    s_countingFunctions.NewDirectByteBuffer = countingNewDirectByteBuffer;
+    s_countingFunctions.NewGlobalRef = countingNewGlobalRef;
+    s_countingFunctions.NewWeakGlobalRef = countingNewWeakGlobalRef;
+  }
+}
+
+// static
+void AllocationStats::count(Counter counter) {
+  s_counters[static_cast<size_t>(counter)].fetch_add(1, std::memory_order_relaxed);
+}
+
+// static
+void AllocationStats::installJniHooks(JNIEnv *env) {
+  if (env->functions == &s_countingFunctions) {
+    return;
+  }
+
+  // All the JNIEnvs share the same function table (unless CheckJNI is toggled at runtime)
+  std::call_once(s_countingFunctionsOnce, initCountingFunctions, env->functions);
+  if (env->functions == s_originalFunctions) {
+    env->functions = &s_countingFunctions;
+  }
+}
+
+// static
+std::vector<int64_t> AllocationStats::getStats() {
+  std::vector<int64_t> stats;
+  stats.reserve(s_counters.size());
+  for (const std::atomic<int64_t> &counter : s_counters) {
+    stats.push_back(counter.load(std::memory_order_relaxed));
+  }
+  return stats;
+}
+
+
+// Counting replacements of the global allocation functions (which are only used by this library
+// because its symbols are not exported)
+// ---
+
+void *operator new(size_t size) {
+  AllocationStats::count(AllocationStats::Counter::NativeAllocations);
+  void *ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void *operator new[](size_t size) {
+  return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  AllocationStats::count(AllocationStats::Counter::NativeAllocations);
+  return malloc(size == 0 ? 1 : size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &nothrow) noexcept {
+  return operator new(size, nothrow);
+}
+
+void operator delete(void *ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+  free(ptr);
+}
+
+#endif
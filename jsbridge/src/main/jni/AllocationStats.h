@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_ALLOCATIONSTATS_H
+#define _JSBRIDGE_ALLOCATIONSTATS_H
+
+// Process-wide allocation counters (only compiled with JSBRIDGE_ALLOCATION_STATS so that the
+// default builds do not have any overhead), e.g. to check in regression tests that the fast paths
+// of the bridge do not allocate more than expected
+//
+// Counted:
+// - native allocations of the library (C++ operator new)
+// - allocations of the JS engine served by the PoolAllocator
+// - JNI local and global refs created via the JNIEnv function table of the threads using a
+//   JniContext (see installJniHooks())
+
+#if defined(JSBRIDGE_ALLOCATION_STATS)
+
+#include <jni.h>
+#include <cstdint>
+#include <vector>
+
+class AllocationStats {
+
+public:
+  enum class Counter {
+    NativeAllocations,
+    JsEngineAllocations,
+    JniLocalRefs,
+    JniGlobalRefs,
+    _Count
+  };
+
+  AllocationStats() = delete;
+
+  static void count(Counter);
+
+  // Replace the JNI function table of the given env (once per env) with a copy whose functions
+  // creating local and global refs are counted
+  static void installJniHooks(JNIEnv *);
+
+  // Current value of each counter (in Counter order)
+  static std::vector<int64_t> getStats();
+};
+
+# define JSBRIDGE_COUNT_ALLOCATION(counter) AllocationStats::count(AllocationStats::Counter::counter)
+#else
+# define JSBRIDGE_COUNT_ALLOCATION(counter) ((void) 0)
+#endif
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_ASSETBUFFER_H
+#define _JSBRIDGE_ASSETBUFFER_H
+
+#include <android/asset_manager.h>
+#include <stdexcept>
+#include <string>
+
+// Utility class using RAII to access the whole content of an Android asset (opened with
+// AASSET_MODE_BUFFER, i.e. memory-mapped when the asset is stored uncompressed) and close it when
+// leaving the current scope.
+//
+// Note: the buffer is NOT zero-terminated
+class AssetBuffer {
+
+public:
+  AssetBuffer(AAssetManager *assetManager, const std::string &strAssetPath)
+    : m_asset(assetManager ? AAssetManager_open(assetManager, strAssetPath.c_str(), AASSET_MODE_BUFFER) : nullptr) {
+
+    if (m_asset == nullptr) {
+      throw std::invalid_argument("Cannot open asset " + strAssetPath);
+    }
+
+    m_data = static_cast<const char *>(AAsset_getBuffer(m_asset));
+    m_length = static_cast<size_t>(AAsset_getLength(m_asset));
+
+    if (m_data == nullptr) {
+      AAsset_close(m_asset);
+      throw std::invalid_argument("Cannot read asset " + strAssetPath);
+    }
+  }
+
+  ~AssetBuffer() {
+    AAsset_close(m_asset);
+  }
+
+  AssetBuffer(const AssetBuffer &) = delete;
+  AssetBuffer &operator=(const AssetBuffer &) = delete;
+
+  const char *data() const { return m_data; }
+  size_t length() const { return m_length; }
+
+private:
+  AAsset *m_asset;
+  const char *m_data = nullptr;
+  size_t m_length = 0;
+};
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "CallTracer.h"
+
+#include <algorithm>
+#include <dlfcn.h>
+
+namespace {
+  // ATrace functions are only available from API 23 and therefore loaded dynamically
+  struct ATraceFunctions {
+    ATraceFunctions() {
+      void *lib = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+      if (lib == nullptr) {
+        return;
+      }
+
+      beginSection = reinterpret_cast<void (*)(const char *)>(dlsym(lib, "ATrace_beginSection"));
+      endSection = reinterpret_cast<void (*)()>(dlsym(lib, "ATrace_endSection"));
+      if (beginSection == nullptr || endSection == nullptr) {
+        beginSection = nullptr;
+        endSection = nullptr;
+      }
+    }
+
+    void (*beginSection)(const char *) = nullptr;
+    void (*endSection)() = nullptr;
+  };
+
+  const ATraceFunctions &getATraceFunctions() {
+    static const ATraceFunctions aTraceFunctions;
+    return aTraceFunctions;
+  }
+}
+
+// static
+void CallTracer::beginSection(const char *sectionName) {
+  const ATraceFunctions &aTraceFunctions = getATraceFunctions();
+  if (aTraceFunctions.beginSection != nullptr) {
+    aTraceFunctions.beginSection(sectionName);
+  }
+}
+
+// static
+void CallTracer::endSection() {
+  const ATraceFunctions &aTraceFunctions = getATraceFunctions();
+  if (aTraceFunctions.endSection != nullptr) {
+    aTraceFunctions.endSection();
+  }
+}
+
+void CallTracer::record(const char *name, const std::array<int64_t, PHASE_COUNT> &phaseDurationsNs) {
+  CallStats &callStats = m_stats[name];
+  ++callStats.count;
+
+  for (size_t i = 0; i < PHASE_COUNT; ++i) {
+    // Phases which have not been traced for this call are not part of the histogram
+    if (i > 0 && phaseDurationsNs[i] == 0) {
+      continue;
+    }
+
+    PhaseStats &phaseStats = callStats.phaseStats[i];
+    phaseStats.totalDurationNs += phaseDurationsNs[i];
+    ++phaseStats.histogram[getHistogramBucket(phaseDurationsNs[i])];
+  }
+}
+
+void CallTracer::getStats(std::vector<std::string> &names, std::vector<int64_t> &values) const {
+  names.reserve(m_stats.size());
+  values.reserve(m_stats.size() * VALUE_COUNT);
+
+  for (const auto &statsEntry : m_stats) {
+    const CallStats &callStats = statsEntry.second;
+
+    names.push_back(statsEntry.first);
+    values.push_back(callStats.count);
+
+    for (const PhaseStats &phaseStats : callStats.phaseStats) {
+      values.push_back(phaseStats.totalDurationNs);
+      values.push_back(getPercentile(phaseStats, 50));
+      values.push_back(getPercentile(phaseStats, 90));
+      values.push_back(getPercentile(phaseStats, 99));
+    }
+  }
+}
+
+// static
+size_t CallTracer::getHistogramBucket(int64_t durationNs) {
+  if (durationNs < (int64_t(1) << MIN_HISTOGRAM_BIT)) {
+    return 0;
+  }
+
+  const int highestBit = 63 - __builtin_clzll(static_cast<unsigned long long>(durationNs));
+  const auto subBucket = static_cast<size_t>((durationNs >> (highestBit - 2)) & (HISTOGRAM_BUCKETS_PER_BIT - 1));
+  const size_t bucket = (highestBit - MIN_HISTOGRAM_BIT) * HISTOGRAM_BUCKETS_PER_BIT + subBucket;
+  return std::min(bucket, HISTOGRAM_BUCKET_COUNT - 1);
+}
+
+// static
+int64_t CallTracer::getHistogramBucketValue(size_t bucket) {
+  // Middle of the bucket range
+  const int highestBit = static_cast<int>(bucket / HISTOGRAM_BUCKETS_PER_BIT) + MIN_HISTOGRAM_BIT;
+  const int64_t subBucket = bucket % HISTOGRAM_BUCKETS_PER_BIT;
+  const int64_t bucketStart = (int64_t(1) << highestBit) + (subBucket << (highestBit - 2));
+  return bucketStart + (int64_t(1) << (highestBit - 3));
+}
+
+// static
+int64_t CallTracer::getPercentile(const PhaseStats &phaseStats, int percentile) {
+  int64_t phaseCount = 0;
+  for (uint32_t bucketCount : phaseStats.histogram) {
+    phaseCount += bucketCount;
+  }
+  if (phaseCount == 0) {
+    return 0;
+  }
+
+  const int64_t rank = (phaseCount * percentile + 99) / 100;  // 1-based
+  int64_t cumulatedCount = 0;
+  for (size_t bucket = 0; bucket < HISTOGRAM_BUCKET_COUNT; ++bucket) {
+    cumulatedCount += phaseStats.histogram[bucket];
+    if (cumulatedCount >= rank) {
+      return getHistogramBucketValue(bucket);
+    }
+  }
+
+  return getHistogramBucketValue(HISTOGRAM_BUCKET_COUNT - 1);
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_CALLTRACER_H
+#define _JSBRIDGE_CALLTRACER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Optional latency tracing of the bridge calls (disabled by default)
+//
+// Each traced call (JNI entry point, Java method called from JS, JS method called from Java) is:
+// - emitted as an ATrace section (visible in Perfetto/systrace) when app tracing is enabled
+// - aggregated per call name into a call count plus the total duration and a latency histogram
+//   for the whole call and for each phase (argument/return value conversion, JS execution, JNI
+//   upcall to Java)
+//
+// Must only be used from the JS thread.
+class CallTracer {
+
+public:
+  enum class Phase {
+    Total,
+    Conversion,
+    JsExecution,
+    JniUpcall,
+    _Count
+  };
+
+  static constexpr size_t PHASE_COUNT = static_cast<size_t>(Phase::_Count);
+
+  CallTracer() = default;
+  CallTracer(const CallTracer &) = delete;
+  CallTracer &operator=(const CallTracer &) = delete;
+
+  void enable() { m_enabled = true; }
+  bool isEnabled() const { return m_enabled; }
+
+  void record(const char *name, const std::array<int64_t, PHASE_COUNT> &phaseDurationsNs);
+  void reset() { m_stats.clear(); }
+
+  // Flat statistics which can easily be transferred to Java:
+  // - one name per traced call
+  // - VALUE_COUNT values per name: the call count followed by, for each phase, the total
+  //   duration and the 50th, 90th and 99th percentiles (in ns)
+  static constexpr size_t VALUE_COUNT = 1 + PHASE_COUNT * 4;
+  void getStats(std::vector<std::string> &names, std::vector<int64_t> &values) const;
+
+  // ATrace sections (no-op if ATrace is not available, i.e. before API 23)
+  static void beginSection(const char *sectionName);
+  static void endSection();
+
+private:
+  // Logarithmic histogram: 4 buckets per power of 2 (i.e. ~19% precision), from 256ns to ~1min
+  static constexpr int MIN_HISTOGRAM_BIT = 8;
+  static constexpr int HISTOGRAM_BUCKETS_PER_BIT = 4;
+  static constexpr size_t HISTOGRAM_BUCKET_COUNT = 28 * HISTOGRAM_BUCKETS_PER_BIT;
+
+  struct PhaseStats {
+    int64_t totalDurationNs = 0;
+    std::array<uint32_t, HISTOGRAM_BUCKET_COUNT> histogram {};
+  };
+
+  struct CallStats {
+    int64_t count = 0;
+    std::array<PhaseStats, PHASE_COUNT> phaseStats;
+  };
+
+  static size_t getHistogramBucket(int64_t durationNs);
+  static int64_t getHistogramBucketValue(size_t bucket);
+  static int64_t getPercentile(const PhaseStats &, int percentile);
+
+  bool m_enabled = false;
+  std::unordered_map<std::string, CallStats> m_stats;
+};
+
+// Trace of a single call (RAII), recorded into the given CallTracer when it goes out of scope.
+// All the operations are no-ops if the tracer is null or disabled.
+//
+// e.g.:
+// CallTrace callTrace(tracer, "name");
+// callTrace.beginPhase(CallTracer::Phase::Conversion);
+// ...
+// callTrace.beginPhase(CallTracer::Phase::JsExecution);  // also ends the previous phase
+// ...
+// callTrace.endPhase();
+class CallTrace {
+
+public:
+  // The name must stay valid until the trace goes out of scope
+  CallTrace(CallTracer *tracer, const char *name)
+   : m_tracer(tracer != nullptr && tracer->isEnabled() ? tracer : nullptr)
+   , m_name(name) {
+
+    if (m_tracer != nullptr) {
+      CallTracer::beginSection(m_name);
+      m_startTime = Clock::now();
+    }
+  }
+
+  CallTrace(const CallTrace &) = delete;
+  CallTrace &operator=(const CallTrace &) = delete;
+
+  ~CallTrace() {
+    if (m_tracer != nullptr) {
+      endPhase();
+      m_phaseDurationsNs[0] = getDurationNs(m_startTime);
+      CallTracer::endSection();
+      m_tracer->record(m_name, m_phaseDurationsNs);
+    }
+  }
+
+  void beginPhase(CallTracer::Phase phase) {
+    if (m_tracer != nullptr) {
+      endPhase();
+      m_currentPhase = phase;
+      m_phaseStartTime = Clock::now();
+      CallTracer::beginSection(PHASE_SECTION_NAMES[static_cast<size_t>(phase)]);
+    }
+  }
+
+  void endPhase() {
+    if (m_tracer != nullptr && m_currentPhase != CallTracer::Phase::Total) {
+      m_phaseDurationsNs[static_cast<size_t>(m_currentPhase)] += getDurationNs(m_phaseStartTime);
+      m_currentPhase = CallTracer::Phase::Total;
+      CallTracer::endSection();
+    }
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  static int64_t getDurationNs(Clock::time_point startTime) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startTime).count();
+  }
+
+  // Indexed by CallTracer::Phase
+  static constexpr const char *PHASE_SECTION_NAMES[] = { "", "conversion", "JS execution", "JNI upcall" };
+
+  CallTracer *m_tracer;
+  const char *m_name;
+  Clock::time_point m_startTime;
+  Clock::time_point m_phaseStartTime;
+  CallTracer::Phase m_currentPhase = CallTracer::Phase::Total;
+  std::array<int64_t, CallTracer::PHASE_COUNT> m_phaseDurationsNs {};
+};
+
+// ATrace section (RAII) whose duration is always measured and added to the given value, e.g. to
+// time the startup phases independently of CallTracer::enable()
+class TimedSection {
+
+public:
+  // The name must stay valid until the section goes out of scope
+  TimedSection(const char *name, int64_t &durationNs)
+   : m_durationNs(durationNs)
+   , m_startTime(Clock::now()) {
+
+    CallTracer::beginSection(name);
+  }
+
+  TimedSection(const TimedSection &) = delete;
+  TimedSection &operator=(const TimedSection &) = delete;
+
+  ~TimedSection() {
+    CallTracer::endSection();
+    m_durationNs += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_startTime).count();
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  int64_t &m_durationNs;
+  Clock::time_point m_startTime;
+};
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "ConversionStats.h"
+
+#if defined(JSBRIDGE_CONVERSION_STATS)
+
+std::vector<int64_t> ConversionStats::getStats() const {
+  std::vector<int64_t> values;
+  values.reserve(m_counters.size() * VALUE_COUNT);
+
+  for (const auto &counterEntry : m_counters) {
+    const auto &jsToJava = counterEntry.second[static_cast<size_t>(Direction::JsToJava)];
+    const auto &javaToJs = counterEntry.second[static_cast<size_t>(Direction::JavaToJs)];
+
+    values.push_back(static_cast<int64_t>(counterEntry.first));
+    values.push_back(jsToJava.count);
+    values.push_back(jsToJava.byteCount);
+    values.push_back(javaToJs.count);
+    values.push_back(javaToJs.byteCount);
+  }
+
+  return values;
+}
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_CONVERSIONSTATS_H
+#define _JSBRIDGE_CONVERSIONSTATS_H
+
+// Conversion counters per JavaType (only compiled with JSBRIDGE_CONVERSION_STATS so that the
+// default builds do not have any overhead)
+//
+// Each JS <-> Java conversion of a value by a JavaType is counted with the (estimated) number of
+// bytes moved, i.e. the JS/Java payload size for strings, JSON and primitive arrays. Nested
+// conversions (e.g. the elements of a List) are counted, too.
+//
+// Must only be used from the JS thread.
+
+#if defined(JSBRIDGE_CONVERSION_STATS)
+
+#include "JavaTypeId.h"
+#include <array>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+class ConversionStats {
+
+public:
+  enum class Direction {
+    JsToJava,
+    JavaToJs,
+    _Count
+  };
+
+  ConversionStats() = default;
+  ConversionStats(const ConversionStats &) = delete;
+  ConversionStats &operator=(const ConversionStats &) = delete;
+
+  void count(JavaTypeId id, Direction direction, size_t byteCount) {
+    Counter &counter = m_counters[id][static_cast<size_t>(direction)];
+    ++counter.count;
+    counter.byteCount += byteCount;
+  }
+
+  void reset() { m_counters.clear(); }
+
+  // Flat statistics which can easily be transferred to Java: VALUE_COUNT values per JavaTypeId
+  // (id, JS -> Java count and bytes, Java -> JS count and bytes)
+  static constexpr size_t VALUE_COUNT = 5;
+  std::vector<int64_t> getStats() const;
+
+private:
+  struct Counter {
+    int64_t count = 0;
+    int64_t byteCount = 0;
+  };
+
+  std::map<JavaTypeId, std::array<Counter, static_cast<size_t>(Direction::_Count)>> m_counters;
+};
+
+#endif
+
+#endif
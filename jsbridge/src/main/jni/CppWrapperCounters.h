@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_CPPWRAPPERCOUNTERS_H
+#define _JSBRIDGE_CPPWRAPPERCOUNTERS_H
+
+#include <cstddef>
+
+// Number of the C++ instances and JNI global refs currently wrapped into JS values (see
+// createCppPtrValue() and createJavaRefValue()).
+//
+// Owned by the JsBridgeContext so that it outlives the wrapper finalizers which are run when the
+// JS heap gets destroyed.
+struct CppWrapperCounters {
+  size_t cppWrapperCount = 0;
+  size_t javaRefCount = 0;  // subset of cppWrapperCount
+  // Non-null JNI global refs of the Java wrappers, accounted here (instead of by a JniContext)
+  // because they can be finalized after their context has been released (QuickJS only)
+  size_t javaRefGlobalRefCount = 0;
+};
+
+#endif
@@ -0,0 +1,910 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "DuktapePromise.h"
+
+#include "StackChecker.h"
+#include <chrono>
+
+namespace {
+  // Global stash
+  const char PROMISE_INSTANCE_PROP_NAME[] = "\xff\xffpromise_instance";
+  const char PROMISE_PROTOTYPE_PROP_NAME[] = "\xff\xffpromise_prototype";
+  const char PROMISE_THEN_PROP_NAME[] = "\xff\xffpromise_then";
+  const char PROMISE_JOBS_PROP_NAME[] = "\xff\xffpromise_jobs";
+  const char PROMISE_UNHANDLED_PROP_NAME[] = "\xff\xffpromise_unhandled";
+
+  // Promise instances
+  const char STATE_PROP_NAME[] = "\xff\xffstate";
+  const char VALUE_PROP_NAME[] = "\xff\xffvalue";
+  const char REACTIONS_PROP_NAME[] = "\xff\xffreactions";
+  const char HANDLED_PROP_NAME[] = "\xff\xffhandled";
+
+  // Internal functions and records
+  const char PROMISE_PROP_NAME[] = "\xff\xffpromise";
+  const char RECORD_PROP_NAME[] = "\xff\xffrecord";
+  const char ELEMENT_PROP_NAME[] = "\xff\xff" "element";
+  const char ALREADY_CALLED_PROP_NAME[] = "\xff\xff" "already_called";
+  const char INDEX_PROP_NAME[] = "\xff\xffindex";
+  const char VALUES_PROP_NAME[] = "\xff\xffvalues";
+  const char REMAINING_PROP_NAME[] = "\xff\xffremaining";
+  const char RESOLVE_PROP_NAME[] = "\xff\xffresolve";
+  const char REJECT_PROP_NAME[] = "\xff\xffreject";
+  const char ON_FINALLY_PROP_NAME[] = "\xff\xffon_finally";
+
+  // Reaction records: { f: onFulfilled, r: onRejected, d: derived promise } (all optional)
+  const char REACTION_ON_FULFILLED_PROP_NAME[] = "f";
+  const char REACTION_ON_REJECTED_PROP_NAME[] = "r";
+  const char REACTION_DERIVED_PROP_NAME[] = "d";
+
+  enum PromiseState {
+    PENDING = 0,
+    FULFILLED = 1,
+    REJECTED = 2,
+  };
+
+  // Jobs: [FULFILL_REACTION_JOB|REJECT_REACTION_JOB, reaction, argument]
+  //       [RESOLVE_THENABLE_JOB, promise, thenable, then]
+  enum JobType {
+    FULFILL_REACTION_JOB = 0,
+    REJECT_REACTION_JOB = 1,
+    RESOLVE_THENABLE_JOB = 2,
+  };
+
+  // Magic values of the static combinators and of their element functions
+  enum Combinator {
+    COMBINATOR_ALL = 0,
+    COMBINATOR_ALL_SETTLED = 1,
+    COMBINATOR_ANY = 2,
+    COMBINATOR_RACE = 3,
+  };
+  enum ElementFunction {
+    ALL_RESOLVE_ELEMENT = 0,
+    ALL_SETTLED_RESOLVE_ELEMENT = 1,
+    ALL_SETTLED_REJECT_ELEMENT = 2,
+    ANY_REJECT_ELEMENT = 3,
+  };
+
+  DuktapePromise *getInstance(duk_context *ctx) {
+    duk_push_global_stash(ctx);
+    duk_get_prop_literal(ctx, -1, PROMISE_INSTANCE_PROP_NAME);
+    auto instance = static_cast<DuktapePromise *>(duk_get_pointer(ctx, -1));
+    duk_pop_2(ctx);  // instance pointer + global stash
+    return instance;
+  }
+
+  void defineMethod(duk_context *ctx, duk_idx_t objIdx, const char *name, duk_c_function f, duk_idx_t nargs, duk_int_t magic = 0) {
+    CHECK_STACK(ctx);
+
+    objIdx = duk_normalize_index(ctx, objIdx);
+    duk_push_string(ctx, name);
+    duk_push_c_function(ctx, f, nargs);
+    duk_set_magic(ctx, -1, magic);
+    duk_def_prop(ctx, objIdx, DUK_DEFPROP_HAVE_VALUE | DUK_DEFPROP_SET_WC | DUK_DEFPROP_CLEAR_ENUMERABLE);
+  }
+
+  bool isPromise(duk_context *ctx, duk_idx_t idx) {
+    if (!duk_is_object(ctx, idx)) {
+      return false;
+    }
+    bool ret = duk_get_prop_literal(ctx, idx, STATE_PROP_NAME);
+    duk_pop(ctx);
+    return ret;
+  }
+
+  int getIntProp(duk_context *ctx, duk_idx_t idx, const char *propName) {
+    duk_get_prop_string(ctx, idx, propName);
+    int ret = duk_get_int(ctx, -1);
+    duk_pop(ctx);
+    return ret;
+  }
+
+  bool getBooleanProp(duk_context *ctx, duk_idx_t idx, const char *propName) {
+    duk_get_prop_string(ctx, idx, propName);
+    bool ret = duk_get_boolean(ctx, -1);
+    duk_pop(ctx);
+    return ret;
+  }
+
+  // [... arg1 ... argN] => [...]
+  void enqueueJob(duk_context *ctx, JobType jobType, duk_idx_t argCount) {
+    const duk_idx_t firstArgIdx = duk_get_top(ctx) - argCount;
+
+    duk_push_array(ctx);
+    duk_push_int(ctx, jobType);
+    duk_put_prop_index(ctx, -2, 0);
+    for (duk_idx_t i = 0; i < argCount; ++i) {
+      duk_dup(ctx, firstArgIdx + i);
+      duk_put_prop_index(ctx, -2, static_cast<duk_uarridx_t>(i + 1));
+    }
+    getInstance(ctx)->enqueueJob();
+    duk_pop_n(ctx, argCount);
+  }
+
+  // [...] => [... promise]
+  void pushNewPromise(duk_context *ctx) {
+    duk_push_object(ctx);
+    duk_push_global_stash(ctx);
+    duk_get_prop_literal(ctx, -1, PROMISE_PROTOTYPE_PROP_NAME);
+    duk_remove(ctx, -2);  // global stash
+    duk_set_prototype(ctx, -2);
+
+    duk_push_int(ctx, PENDING);
+    duk_put_prop_literal(ctx, -2, STATE_PROP_NAME);
+  }
+
+  // Queue a reaction job of each reaction and release them
+  void triggerReactions(duk_context *ctx, duk_idx_t promiseIdx, JobType jobType) {
+    CHECK_STACK(ctx);
+
+    if (!duk_get_prop_literal(ctx, promiseIdx, REACTIONS_PROP_NAME)) {
+      duk_pop(ctx);  // undefined
+      return;
+    }
+
+    const duk_size_t reactionCount = duk_get_length(ctx, -1);
+    for (duk_uarridx_t i = 0; i < reactionCount; ++i) {
+      duk_get_prop_index(ctx, -1, i);
+      duk_get_prop_literal(ctx, promiseIdx, VALUE_PROP_NAME);
+      enqueueJob(ctx, jobType, 2);
+    }
+    duk_pop(ctx);  // reactions
+
+    duk_del_prop_literal(ctx, promiseIdx, REACTIONS_PROP_NAME);
+  }
+
+  void fulfillPromise(duk_context *ctx, duk_idx_t promiseIdx, duk_idx_t valueIdx) {
+    CHECK_STACK(ctx);
+
+    promiseIdx = duk_normalize_index(ctx, promiseIdx);
+
+    duk_dup(ctx, valueIdx);
+    duk_put_prop_literal(ctx, promiseIdx, VALUE_PROP_NAME);
+    duk_push_int(ctx, FULFILLED);
+    duk_put_prop_literal(ctx, promiseIdx, STATE_PROP_NAME);
+
+    triggerReactions(ctx, promiseIdx, FULFILL_REACTION_JOB);
+  }
+
+  void rejectPromise(duk_context *ctx, duk_idx_t promiseIdx, duk_idx_t reasonIdx) {
+    CHECK_STACK(ctx);
+
+    promiseIdx = duk_normalize_index(ctx, promiseIdx);
+
+    duk_dup(ctx, reasonIdx);
+    duk_put_prop_literal(ctx, promiseIdx, VALUE_PROP_NAME);
+    duk_push_int(ctx, REJECTED);
+    duk_put_prop_literal(ctx, promiseIdx, STATE_PROP_NAME);
+
+    if (!getBooleanProp(ctx, promiseIdx, HANDLED_PROP_NAME)) {
+      // Checked again once the job queue is empty (see reportUnhandledRejections())
+      duk_push_global_stash(ctx);
+      duk_get_prop_literal(ctx, -1, PROMISE_UNHANDLED_PROP_NAME);
+      duk_dup(ctx, promiseIdx);
+      duk_put_prop_index(ctx, -2, static_cast<duk_uarridx_t>(duk_get_length(ctx, -2)));
+      duk_pop_2(ctx);  // unhandled promises + global stash
+    }
+
+    triggerReactions(ctx, promiseIdx, REJECT_REACTION_JOB);
+  }
+
+  duk_ret_t getThen(duk_context *ctx, void *) {
+    // [value] => [value then]
+    duk_get_prop_literal(ctx, -1, "then");
+    return 1;
+  }
+
+  void resolvePromise(duk_context *ctx, duk_idx_t promiseIdx, duk_idx_t resolutionIdx) {
+    CHECK_STACK(ctx);
+
+    promiseIdx = duk_normalize_index(ctx, promiseIdx);
+    resolutionIdx = duk_normalize_index(ctx, resolutionIdx);
+
+    if (duk_strict_equals(ctx, promiseIdx, resolutionIdx)) {
+      duk_push_error_object(ctx, DUK_ERR_TYPE_ERROR, "Chaining cycle detected for promise");
+      rejectPromise(ctx, promiseIdx, -1);
+      duk_pop(ctx);  // error
+      return;
+    }
+
+    if (!duk_is_object(ctx, resolutionIdx)) {
+      fulfillPromise(ctx, promiseIdx, resolutionIdx);
+      return;
+    }
+
+    // Getting "then" may throw (getter, Proxy)
+    duk_dup(ctx, resolutionIdx);
+    if (duk_safe_call(ctx, getThen, nullptr, 1, 1) != DUK_EXEC_SUCCESS) {
+      rejectPromise(ctx, promiseIdx, -1);
+      duk_pop(ctx);  // error
+      return;
+    }
+
+    if (!duk_is_callable(ctx, -1)) {
+      duk_pop(ctx);  // then
+      fulfillPromise(ctx, promiseIdx, resolutionIdx);
+      return;
+    }
+
+    // [... then] => [... promise thenable then]
+    duk_dup(ctx, promiseIdx);
+    duk_dup(ctx, resolutionIdx);
+    duk_pull(ctx, -3);
+    enqueueJob(ctx, RESOLVE_THENABLE_JOB, 3);
+  }
+
+  // Note: the derived promise is optional (DUK_INVALID_INDEX) for the internal reactions
+  void performThen(duk_context *ctx, duk_idx_t promiseIdx, duk_idx_t onFulfilledIdx, duk_idx_t onRejectedIdx, duk_idx_t derivedIdx) {
+    CHECK_STACK(ctx);
+
+    promiseIdx = duk_normalize_index(ctx, promiseIdx);
+    onFulfilledIdx = duk_normalize_index(ctx, onFulfilledIdx);
+    onRejectedIdx = duk_normalize_index(ctx, onRejectedIdx);
+    derivedIdx = duk_normalize_index(ctx, derivedIdx);
+
+    duk_push_bare_object(ctx);  // reaction
+    if (duk_is_callable(ctx, onFulfilledIdx)) {
+      duk_dup(ctx, onFulfilledIdx);
+      duk_put_prop_literal(ctx, -2, REACTION_ON_FULFILLED_PROP_NAME);
+    }
+    if (duk_is_callable(ctx, onRejectedIdx)) {
+      duk_dup(ctx, onRejectedIdx);
+      duk_put_prop_literal(ctx, -2, REACTION_ON_REJECTED_PROP_NAME);
+    }
+    if (duk_is_object(ctx, derivedIdx)) {
+      duk_dup(ctx, derivedIdx);
+      duk_put_prop_literal(ctx, -2, REACTION_DERIVED_PROP_NAME);
+    }
+
+    switch (getIntProp(ctx, promiseIdx, STATE_PROP_NAME)) {
+      case PENDING:
+        // The reactions array is only allocated when needed
+        if (!duk_get_prop_literal(ctx, promiseIdx, REACTIONS_PROP_NAME)) {
+          duk_pop(ctx);  // undefined
+          duk_push_array(ctx);
+          duk_dup_top(ctx);
+          duk_put_prop_literal(ctx, promiseIdx, REACTIONS_PROP_NAME);
+        }
+        duk_dup(ctx, -2);  // reaction
+        duk_put_prop_index(ctx, -2, static_cast<duk_uarridx_t>(duk_get_length(ctx, -2)));
+        duk_pop_2(ctx);  // reactions + reaction
+        break;
+
+      case FULFILLED:
+        duk_get_prop_literal(ctx, promiseIdx, VALUE_PROP_NAME);
+        enqueueJob(ctx, FULFILL_REACTION_JOB, 2);
+        break;
+
+      default:
+        duk_get_prop_literal(ctx, promiseIdx, VALUE_PROP_NAME);
+        enqueueJob(ctx, REJECT_REACTION_JOB, 2);
+        break;
+    }
+
+    duk_push_true(ctx);
+    duk_put_prop_literal(ctx, promiseIdx, HANDLED_PROP_NAME);
+  }
+
+  // [...] => [... promise] with the given value if it is already a (native) Promise
+  void pushPromiseResolve(duk_context *ctx, duk_idx_t valueIdx) {
+    valueIdx = duk_normalize_index(ctx, valueIdx);
+
+    if (isPromise(ctx, valueIdx)) {
+      duk_dup(ctx, valueIdx);
+      return;
+    }
+
+    pushNewPromise(ctx);
+    resolvePromise(ctx, -1, valueIdx);
+  }
+
+  void pushAggregateError(duk_context *ctx, duk_idx_t errorsIdx) {
+    errorsIdx = duk_normalize_index(ctx, errorsIdx);
+
+    duk_push_error_object(ctx, DUK_ERR_ERROR, "All promises were rejected");
+    duk_push_literal(ctx, "AggregateError");
+    duk_put_prop_literal(ctx, -2, "name");
+    duk_dup(ctx, errorsIdx);
+    duk_put_prop_literal(ctx, -2, "errors");
+  }
+
+  void callFunctionProp(duk_context *ctx, duk_idx_t objIdx, const char *propName, duk_idx_t argIdx) {
+    CHECK_STACK(ctx);
+
+    argIdx = duk_normalize_index(ctx, argIdx);
+    duk_get_prop_string(ctx, objIdx, propName);
+    duk_dup(ctx, argIdx);
+    duk_call(ctx, 1);
+    duk_pop(ctx);  // (undefined) result
+  }
+
+  extern "C" {
+    duk_ret_t resolvingFunction(duk_context *ctx) {
+      // [value]
+      duk_push_current_function(ctx);
+      duk_get_prop_literal(ctx, 1, RECORD_PROP_NAME);
+      // => [value function record]
+
+      // Only the first call of resolve() or reject() has an effect
+      if (getBooleanProp(ctx, 2, ALREADY_CALLED_PROP_NAME)) {
+        return 0;
+      }
+      duk_push_true(ctx);
+      duk_put_prop_literal(ctx, 2, ALREADY_CALLED_PROP_NAME);
+
+      duk_get_prop_literal(ctx, 1, PROMISE_PROP_NAME);
+      if (duk_get_current_magic(ctx) == 0) {
+        resolvePromise(ctx, 3, 0);
+      } else {
+        rejectPromise(ctx, 3, 0);
+      }
+      return 0;
+    }
+
+    duk_ret_t promiseConstructor(duk_context *ctx) {
+      if (!duk_is_constructor_call(ctx)) {
+        return duk_type_error(ctx, "Promise constructor cannot be invoked without 'new'");
+      }
+      if (!duk_is_callable(ctx, 0)) {
+        return duk_type_error(ctx, "Promise resolver is not a function");
+      }
+
+      // The default instance already has the Promise prototype
+      duk_push_this(ctx);
+      duk_push_int(ctx, PENDING);
+      duk_put_prop_literal(ctx, 1, STATE_PROP_NAME);
+
+      getInstance(ctx)->pushResolvingFunctions(1);
+      // => [executor this resolve reject]
+
+      duk_dup(ctx, 0);
+      duk_dup(ctx, 2);
+      duk_dup(ctx, 3);
+      if (duk_pcall(ctx, 2) != DUK_EXEC_SUCCESS) {
+        // [... error] => reject(error)
+        duk_dup(ctx, 3);
+        duk_dup(ctx, -2);
+        duk_call(ctx, 1);
+        duk_pop(ctx);  // undefined
+      }
+      return 0;
+    }
+
+    duk_ret_t promiseThen(duk_context *ctx) {
+      // [onFulfilled onRejected]
+      duk_push_this(ctx);
+      if (!isPromise(ctx, 2)) {
+        return duk_type_error(ctx, "Promise.prototype.then called on an incompatible receiver");
+      }
+
+      pushNewPromise(ctx);
+      performThen(ctx, 2, 0, 1, 3);
+      return 1;
+    }
+
+    duk_ret_t promiseCatch(duk_context *ctx) {
+      // [onRejected] => this.then(undefined, onRejected)
+      duk_push_this(ctx);
+      duk_push_literal(ctx, "then");
+      duk_push_undefined(ctx);
+      duk_dup(ctx, 0);
+      duk_call_prop(ctx, 1, 2);
+      return 1;
+    }
+
+    duk_ret_t finallyValueThunk(duk_context *ctx) {
+      duk_push_current_function(ctx);
+      duk_get_prop_literal(ctx, -1, VALUE_PROP_NAME);
+      if (duk_get_current_magic(ctx) == 0) {
+        return 1;
+      }
+      return duk_throw(ctx);
+    }
+
+    duk_ret_t finallyHandler(duk_context *ctx) {
+      // [value]
+      duk_push_current_function(ctx);
+      duk_get_prop_literal(ctx, 1, ON_FINALLY_PROP_NAME);
+      duk_call(ctx, 0);
+      // => [value function onFinallyResult]
+
+      // PromiseResolve(onFinallyResult).then(() => value) or .then(() => { throw value })
+      pushPromiseResolve(ctx, 2);
+      duk_push_c_function(ctx, finallyValueThunk, 0);
+      duk_set_magic(ctx, -1, duk_get_current_magic(ctx));
+      duk_dup(ctx, 0);
+      duk_put_prop_literal(ctx, -2, VALUE_PROP_NAME);
+      pushNewPromise(ctx);
+      // => [value function onFinallyResult promise thunk derived]
+
+      performThen(ctx, 3, 4, DUK_INVALID_INDEX, 5);
+      return 1;
+    }
+
+    duk_ret_t promiseFinally(duk_context *ctx) {
+      // [onFinally]
+      duk_push_this(ctx);
+      duk_push_literal(ctx, "then");
+
+      if (!duk_is_callable(ctx, 0)) {
+        duk_dup(ctx, 0);
+        duk_dup(ctx, 0);
+      } else {
+        for (duk_int_t magic = 0; magic < 2; ++magic) {
+          duk_push_c_function(ctx, finallyHandler, 1);
+          duk_set_magic(ctx, -1, magic);
+          duk_dup(ctx, 0);
+          duk_put_prop_literal(ctx, -2, ON_FINALLY_PROP_NAME);
+        }
+      }
+
+      duk_call_prop(ctx, 1, 2);
+      return 1;
+    }
+
+    duk_ret_t promiseResolveStatic(duk_context *ctx) {
+      // [value]
+      if (isPromise(ctx, 0)) {
+        duk_get_prop_literal(ctx, 0, "constructor");
+        duk_push_this(ctx);
+        if (duk_strict_equals(ctx, -1, -2)) {
+          duk_dup(ctx, 0);
+          return 1;
+        }
+        duk_pop_2(ctx);  // this + constructor
+      }
+
+      pushNewPromise(ctx);
+      resolvePromise(ctx, -1, 0);
+      return 1;
+    }
+
+    duk_ret_t promiseRejectStatic(duk_context *ctx) {
+      // [reason]
+      pushNewPromise(ctx);
+      rejectPromise(ctx, -1, 0);
+      return 1;
+    }
+
+    duk_ret_t combinatorElement(duk_context *ctx) {
+      // [value]
+      duk_push_current_function(ctx);
+      duk_get_prop_literal(ctx, 1, ELEMENT_PROP_NAME);
+      // => [value function element]
+
+      if (getBooleanProp(ctx, 2, ALREADY_CALLED_PROP_NAME)) {
+        return 0;
+      }
+      duk_push_true(ctx);
+      duk_put_prop_literal(ctx, 2, ALREADY_CALLED_PROP_NAME);
+
+      const auto index = static_cast<duk_uarridx_t>(getIntProp(ctx, 2, INDEX_PROP_NAME));
+      duk_get_prop_literal(ctx, 2, RECORD_PROP_NAME);
+      duk_get_prop_literal(ctx, 3, VALUES_PROP_NAME);
+      // => [value function element record values]
+
+      const duk_int_t magic = duk_get_current_magic(ctx);
+      switch (magic) {
+        case ALL_SETTLED_RESOLVE_ELEMENT:
+          duk_push_object(ctx);
+          duk_push_literal(ctx, "fulfilled");
+          duk_put_prop_literal(ctx, -2, "status");
+          duk_dup(ctx, 0);
+          duk_put_prop_literal(ctx, -2, "value");
+          break;
+
+        case ALL_SETTLED_REJECT_ELEMENT:
+          duk_push_object(ctx);
+          duk_push_literal(ctx, "rejected");
+          duk_put_prop_literal(ctx, -2, "status");
+          duk_dup(ctx, 0);
+          duk_put_prop_literal(ctx, -2, "reason");
+          break;
+
+        default:
+          duk_dup(ctx, 0);
+          break;
+      }
+      duk_put_prop_index(ctx, 4, index);
+
+      const int remaining = getIntProp(ctx, 3, REMAINING_PROP_NAME) - 1;
+      duk_push_int(ctx, remaining);
+      duk_put_prop_literal(ctx, 3, REMAINING_PROP_NAME);
+      if (remaining > 0) {
+        return 0;
+      }
+
+      if (magic == ANY_REJECT_ELEMENT) {
+        pushAggregateError(ctx, 4);
+        callFunctionProp(ctx, 3, REJECT_PROP_NAME, -1);
+      } else {
+        callFunctionProp(ctx, 3, RESOLVE_PROP_NAME, 4);
+      }
+      return 0;
+    }
+
+    // [... element] => [... element elementFunction]
+    void pushCombinatorElementFunction(duk_context *ctx, duk_int_t elementFunction) {
+      duk_push_c_function(ctx, combinatorElement, 1);
+      duk_set_magic(ctx, -1, elementFunction);
+      duk_dup(ctx, -2);
+      duk_put_prop_literal(ctx, -2, ELEMENT_PROP_NAME);
+    }
+
+    duk_ret_t performCombinator(duk_context *ctx, void *udata) {
+      const auto combinator = *static_cast<const duk_int_t *>(udata);
+
+      // [iterable result resolve reject]
+      if (!duk_is_object(ctx, 0)) {
+        return duk_type_error(ctx, "%s is not iterable (only arrays and array-like objects are supported)", duk_safe_to_string(ctx, 0));
+      }
+
+      const auto length = static_cast<duk_uarridx_t>(duk_get_length(ctx, 0));
+
+      if (combinator == COMBINATOR_RACE) {
+        for (duk_uarridx_t i = 0; i < length; ++i) {
+          duk_get_prop_index(ctx, 0, i);
+          pushPromiseResolve(ctx, -1);
+          performThen(ctx, -1, 2, 3, DUK_INVALID_INDEX);
+          duk_pop_2(ctx);  // promise + element
+        }
+        return 0;
+      }
+
+      // Shared record of the element functions
+      duk_push_bare_object(ctx);
+      duk_push_array(ctx);
+      duk_dup_top(ctx);
+      duk_put_prop_literal(ctx, 4, VALUES_PROP_NAME);
+      duk_dup(ctx, 2);
+      duk_put_prop_literal(ctx, 4, RESOLVE_PROP_NAME);
+      duk_dup(ctx, 3);
+      duk_put_prop_literal(ctx, 4, REJECT_PROP_NAME);
+      // => [iterable result resolve reject record values]
+
+      for (duk_uarridx_t i = 0; i < length; ++i) {
+        duk_push_undefined(ctx);
+        duk_put_prop_index(ctx, 5, i);
+
+        duk_get_prop_index(ctx, 0, i);
+        pushPromiseResolve(ctx, -1);
+        duk_remove(ctx, -2);  // element value
+        // => [... promise]
+
+        duk_push_bare_object(ctx);
+        duk_push_uint(ctx, i);
+        duk_put_prop_literal(ctx, -2, INDEX_PROP_NAME);
+        duk_dup(ctx, 4);
+        duk_put_prop_literal(ctx, -2, RECORD_PROP_NAME);
+        // => [... promise element]
+
+        switch (combinator) {
+          case COMBINATOR_ALL:
+            pushCombinatorElementFunction(ctx, ALL_RESOLVE_ELEMENT);
+            performThen(ctx, -3, -1, 3, DUK_INVALID_INDEX);
+            break;
+
+          case COMBINATOR_ALL_SETTLED:
+            pushCombinatorElementFunction(ctx, ALL_SETTLED_RESOLVE_ELEMENT);
+            duk_dup(ctx, -2);
+            pushCombinatorElementFunction(ctx, ALL_SETTLED_REJECT_ELEMENT);
+            duk_remove(ctx, -2);  // element
+            performThen(ctx, -4, -2, -1, DUK_INVALID_INDEX);
+            duk_pop(ctx);  // reject element function
+            break;
+
+          default:
+            pushCombinatorElementFunction(ctx, ANY_REJECT_ELEMENT);
+            performThen(ctx, -3, 2, -1, DUK_INVALID_INDEX);
+            break;
+        }
+        duk_pop_3(ctx);  // element function + element + promise
+      }
+
+      // The element functions are only called from later jobs
+      duk_push_uint(ctx, length);
+      duk_put_prop_literal(ctx, 4, REMAINING_PROP_NAME);
+
+      if (length == 0) {
+        if (combinator == COMBINATOR_ANY) {
+          pushAggregateError(ctx, 5);
+          callFunctionProp(ctx, 4, REJECT_PROP_NAME, -1);
+        } else {
+          callFunctionProp(ctx, 4, RESOLVE_PROP_NAME, 5);
+        }
+      }
+      return 0;
+    }
+
+    duk_ret_t promiseCombinator(duk_context *ctx) {
+      const duk_int_t combinator = duk_get_current_magic(ctx);
+
+      // [iterable]
+      pushNewPromise(ctx);
+      getInstance(ctx)->pushResolvingFunctions(1);
+      // => [iterable result resolve reject]
+
+      // Errors while iterating reject the result
+      // (duk_safe_call() does not create a new stack frame: performCombinator() directly uses the
+      // indices above)
+      if (duk_safe_call(ctx, performCombinator, const_cast<duk_int_t *>(&combinator), 0, 1) != DUK_EXEC_SUCCESS) {
+        duk_dup(ctx, 3);
+        duk_dup(ctx, -2);
+        duk_call(ctx, 1);
+        duk_pop(ctx);  // undefined
+      }
+      duk_pop(ctx);  // (undefined) result or error
+
+      duk_dup(ctx, 1);
+      return 1;
+    }
+
+    // Note: duk_safe_call() does not create a new stack frame so the indices are relative to the
+    // job one (see runJob())
+    duk_ret_t runReactionJob(duk_context *ctx, duk_idx_t jobIdx, JobType jobType) {
+      // [job reaction argument]
+      const duk_idx_t reactionIdx = jobIdx + 1;
+      const duk_idx_t argumentIdx = jobIdx + 2;
+      const duk_idx_t handlerIdx = jobIdx + 3;
+      const duk_idx_t derivedIdx = jobIdx + 4;
+
+      duk_get_prop_literal(ctx, reactionIdx, jobType == FULFILL_REACTION_JOB ? REACTION_ON_FULFILLED_PROP_NAME : REACTION_ON_REJECTED_PROP_NAME);
+      duk_get_prop_literal(ctx, reactionIdx, REACTION_DERIVED_PROP_NAME);
+      // => [job reaction argument handler derived]
+
+      const bool hasDerived = duk_is_object(ctx, derivedIdx);
+
+      if (!duk_is_callable(ctx, handlerIdx)) {
+        // Pass-through
+        if (hasDerived) {
+          if (jobType == FULFILL_REACTION_JOB) {
+            resolvePromise(ctx, derivedIdx, argumentIdx);
+          } else {
+            rejectPromise(ctx, derivedIdx, argumentIdx);
+          }
+        }
+        return 0;
+      }
+
+      duk_dup(ctx, handlerIdx);
+      duk_push_undefined(ctx);
+      duk_dup(ctx, argumentIdx);
+      const duk_int_t rc = duk_pcall_method(ctx, 1);
+      if (hasDerived) {
+        if (rc == DUK_EXEC_SUCCESS) {
+          resolvePromise(ctx, derivedIdx, -1);
+        } else {
+          rejectPromise(ctx, derivedIdx, -1);
+        }
+      }
+      return 0;
+    }
+
+    duk_ret_t runResolveThenableJob(duk_context *ctx, duk_idx_t jobIdx) {
+      // [job promise thenable then]
+      const duk_idx_t promiseIdx = jobIdx + 1;
+      const duk_idx_t thenableIdx = jobIdx + 2;
+      const duk_idx_t thenIdx = jobIdx + 3;
+
+      // Native promise with the original then(): skip the resolving functions
+      duk_push_global_stash(ctx);
+      duk_get_prop_literal(ctx, -1, PROMISE_THEN_PROP_NAME);
+      const bool isNativeThen = duk_strict_equals(ctx, thenIdx, -1);
+      duk_pop_2(ctx);  // native then + global stash
+      if (isNativeThen && isPromise(ctx, thenableIdx)) {
+        performThen(ctx, thenableIdx, DUK_INVALID_INDEX, DUK_INVALID_INDEX, promiseIdx);
+        return 0;
+      }
+
+      getInstance(ctx)->pushResolvingFunctions(promiseIdx);
+      // => [job promise thenable then resolve reject]
+      const duk_idx_t rejectIdx = jobIdx + 5;
+
+      duk_dup(ctx, thenIdx);
+      duk_dup(ctx, thenableIdx);
+      duk_dup(ctx, rejectIdx - 1);
+      duk_dup(ctx, rejectIdx);
+      if (duk_pcall_method(ctx, 2) != DUK_EXEC_SUCCESS) {
+        duk_dup(ctx, rejectIdx);
+        duk_dup(ctx, -2);
+        duk_call(ctx, 1);
+      }
+      return 0;
+    }
+
+    duk_ret_t runJob(duk_context *ctx, void *) {
+      // [job]
+      const duk_idx_t jobIdx = duk_get_top(ctx) - 1;
+
+      duk_get_prop_index(ctx, jobIdx, 0);
+      const auto jobType = static_cast<JobType>(duk_get_int(ctx, -1));
+      duk_pop(ctx);  // job type
+      duk_get_prop_index(ctx, jobIdx, 1);
+      duk_get_prop_index(ctx, jobIdx, 2);
+
+      if (jobType == RESOLVE_THENABLE_JOB) {
+        duk_get_prop_index(ctx, jobIdx, 3);
+        return runResolveThenableJob(ctx, jobIdx);
+      }
+
+      return runReactionJob(ctx, jobIdx, jobType);
+    }
+  }
+}
+
+DuktapePromise::DuktapePromise(duk_context *ctx, UnhandledRejectionHandler &&unhandledRejectionHandler)
+ : m_ctx(ctx)
+ , m_unhandledRejectionHandler(std::move(unhandledRejectionHandler)) {
+
+  CHECK_STACK(m_ctx);
+
+  duk_push_global_stash(m_ctx);
+  duk_push_pointer(m_ctx, this);
+  duk_put_prop_literal(m_ctx, -2, PROMISE_INSTANCE_PROP_NAME);
+  duk_push_array(m_ctx);
+  duk_put_prop_literal(m_ctx, -2, PROMISE_JOBS_PROP_NAME);
+  duk_push_array(m_ctx);
+  duk_put_prop_literal(m_ctx, -2, PROMISE_UNHANDLED_PROP_NAME);
+
+  duk_push_c_function(m_ctx, promiseConstructor, 1);
+  duk_push_object(m_ctx);
+  // => [stash Promise Promise.prototype]
+
+  defineMethod(m_ctx, -1, "then", promiseThen, 2);
+  defineMethod(m_ctx, -1, "catch", promiseCatch, 1);
+  defineMethod(m_ctx, -1, "finally", promiseFinally, 1);
+
+  // Original then() (see runResolveThenableJob())
+  duk_get_prop_literal(m_ctx, -1, "then");
+  duk_put_prop_literal(m_ctx, -4, PROMISE_THEN_PROP_NAME);
+
+  duk_dup_top(m_ctx);
+  duk_put_prop_literal(m_ctx, -4, PROMISE_PROTOTYPE_PROP_NAME);
+
+  // Promise.prototype.constructor = Promise
+  duk_push_literal(m_ctx, "constructor");
+  duk_dup(m_ctx, -3);
+  duk_def_prop(m_ctx, -3, DUK_DEFPROP_HAVE_VALUE | DUK_DEFPROP_SET_WC | DUK_DEFPROP_CLEAR_ENUMERABLE);
+
+  // Promise.prototype (non-writable, non-enumerable, non-configurable)
+  duk_push_literal(m_ctx, "prototype");
+  duk_pull(m_ctx, -2);
+  duk_def_prop(m_ctx, -3, DUK_DEFPROP_HAVE_VALUE | DUK_DEFPROP_HAVE_WEC);
+  // => [stash Promise]
+
+  defineMethod(m_ctx, -1, "resolve", promiseResolveStatic, 1);
+  defineMethod(m_ctx, -1, "reject", promiseRejectStatic, 1);
+  defineMethod(m_ctx, -1, "all", promiseCombinator, 1, COMBINATOR_ALL);
+  defineMethod(m_ctx, -1, "allSettled", promiseCombinator, 1, COMBINATOR_ALL_SETTLED);
+  defineMethod(m_ctx, -1, "any", promiseCombinator, 1, COMBINATOR_ANY);
+  defineMethod(m_ctx, -1, "race", promiseCombinator, 1, COMBINATOR_RACE);
+
+  duk_push_global_object(m_ctx);
+  duk_push_literal(m_ctx, "Promise");
+  duk_pull(m_ctx, -3);
+  duk_def_prop(m_ctx, -3, DUK_DEFPROP_HAVE_VALUE | DUK_DEFPROP_SET_WC | DUK_DEFPROP_CLEAR_ENUMERABLE);
+  duk_pop_2(m_ctx);  // global object + global stash
+}
+
+void DuktapePromise::pushNewPromise() const {
+  CHECK_STACK_OFFSET(m_ctx, 1);
+
+  ::pushNewPromise(m_ctx);
+}
+
+void DuktapePromise::pushResolvingFunctions(duk_idx_t promiseIdx) const {
+  CHECK_STACK_OFFSET(m_ctx, 2);
+
+  promiseIdx = duk_normalize_index(m_ctx, promiseIdx);
+
+  // The record shared by both functions
+  const duk_idx_t recordIdx = duk_push_bare_object(m_ctx);
+
+  for (duk_int_t magic = 0; magic < 2; ++magic) {
+    duk_push_c_function(m_ctx, resolvingFunction, 1);
+    duk_set_magic(m_ctx, -1, magic);
+    duk_dup(m_ctx, promiseIdx);
+    duk_put_prop_literal(m_ctx, -2, PROMISE_PROP_NAME);
+    duk_dup(m_ctx, recordIdx);
+    duk_put_prop_literal(m_ctx, -2, RECORD_PROP_NAME);
+  }
+
+  duk_remove(m_ctx, recordIdx);
+}
+
+bool DuktapePromise::pushFulfilledValue(duk_idx_t idx) const {
+  if (!isPromise(m_ctx, idx) || getIntProp(m_ctx, idx, STATE_PROP_NAME) != FULFILLED) {
+    return false;
+  }
+
+  duk_get_prop_literal(m_ctx, idx, VALUE_PROP_NAME);
+  return true;
+}
+
+void DuktapePromise::enqueueJob() {
+  CHECK_STACK_OFFSET(m_ctx, -1);
+
+  duk_push_global_stash(m_ctx);
+  duk_get_prop_literal(m_ctx, -1, PROMISE_JOBS_PROP_NAME);
+  duk_dup(m_ctx, -3);
+  duk_put_prop_index(m_ctx, -2, m_jobTail++);
+  duk_pop_3(m_ctx);  // jobs + global stash + job
+}
+
+duk_int_t DuktapePromise::processJobs(int maxJobs, long long timeBudgetMs, const std::function<bool()> &shouldYield,
+                                      bool &hasPendingJobs) {
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeBudgetMs);
+
+  for (int jobCount = 0; m_jobHead != m_jobTail; ++jobCount) {
+    if ((maxJobs > 0 && jobCount >= maxJobs) || (timeBudgetMs > 0 && jobCount > 0 && Clock::now() >= deadline) ||
+        (jobCount > 0 && shouldYield && shouldYield())) {
+      hasPendingJobs = true;
+      return DUK_EXEC_SUCCESS;
+    }
+
+    // Dequeue the next job
+    duk_push_global_stash(m_ctx);
+    duk_get_prop_literal(m_ctx, -1, PROMISE_JOBS_PROP_NAME);
+    duk_get_prop_index(m_ctx, -1, m_jobHead);
+    duk_push_undefined(m_ctx);
+    duk_put_prop_index(m_ctx, -3, m_jobHead++);
+    if (m_jobHead == m_jobTail) {
+      // Empty queue: restart from the beginning of the array
+      m_jobHead = m_jobTail = 0;
+      duk_push_uint(m_ctx, 0);
+      duk_put_prop_literal(m_ctx, -3, "length");
+    }
+    duk_remove(m_ctx, -2);  // jobs
+    duk_remove(m_ctx, -2);  // global stash
+
+    if (duk_safe_call(m_ctx, runJob, nullptr, 1, 1) != DUK_EXEC_SUCCESS) {
+      hasPendingJobs = m_jobHead != m_jobTail;
+      return DUK_EXEC_ERROR;
+    }
+    duk_pop(m_ctx);  // undefined
+  }
+
+  hasPendingJobs = false;
+  reportUnhandledRejections();
+  return DUK_EXEC_SUCCESS;
+}
+
+void DuktapePromise::reportUnhandledRejections() const {
+  CHECK_STACK(m_ctx);
+
+  duk_push_global_stash(m_ctx);
+  duk_get_prop_literal(m_ctx, -1, PROMISE_UNHANDLED_PROP_NAME);
+  const duk_size_t promiseCount = duk_get_length(m_ctx, -1);
+  if (promiseCount == 0) {
+    duk_pop_2(m_ctx);  // unhandled promises + global stash
+    return;
+  }
+
+  duk_push_array(m_ctx);
+  duk_put_prop_literal(m_ctx, -3, PROMISE_UNHANDLED_PROP_NAME);
+
+  for (duk_uarridx_t i = 0; i < promiseCount; ++i) {
+    duk_get_prop_index(m_ctx, -1, i);
+    if (!getBooleanProp(m_ctx, -1, HANDLED_PROP_NAME)) {
+      duk_get_prop_literal(m_ctx, -1, VALUE_PROP_NAME);
+      m_unhandledRejectionHandler(m_ctx);
+      duk_pop(m_ctx);  // reason
+    }
+    duk_pop(m_ctx);  // promise
+  }
+
+  duk_pop_2(m_ctx);  // unhandled promises + global stash
+}
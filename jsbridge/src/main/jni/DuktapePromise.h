@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_DUKTAPEPROMISE_H
+#define _JSBRIDGE_DUKTAPEPROMISE_H
+
+#include "duktape/duktape.h"
+#include <functional>
+
+// Duktape only: native implementation of the ES2015+ Promise (Duktape has no built-in one) which
+// is installed as globalThis.Promise:
+// - then(), catch(), finally(), Promise.resolve(), reject(), all(), allSettled(), any() and race()
+// - the reaction jobs are queued (in the global stash) and executed by processJobs(), i.e. by the
+//   promise queue ticks of JsBridge
+// - the rejections which are still unhandled once the job queue is empty are given to the
+//   UnhandledRejectionHandler
+//
+// The promise state is stored in hidden properties of the Promise instances.
+//
+// Must only be used from the JS thread.
+class DuktapePromise {
+
+public:
+  // Called with the rejection reason at the top of the stack (which must not be popped)
+  using UnhandledRejectionHandler = std::function<void(duk_context *)>;
+
+  DuktapePromise(duk_context *, UnhandledRejectionHandler &&);
+  DuktapePromise(const DuktapePromise &) = delete;
+  DuktapePromise &operator=(const DuktapePromise &) = delete;
+
+  // Push a new pending Promise
+  void pushNewPromise() const;
+
+  // Push the (resolve, reject) functions of the Promise at the given index
+  void pushResolvingFunctions(duk_idx_t promiseIdx) const;
+
+  // If the value at the given index is a native Promise which has already been fulfilled, push
+  // its value and return true (otherwise: push nothing and return false)
+  bool pushFulfilledValue(duk_idx_t idx) const;
+
+  // Execute the queued jobs until the queue is empty, the given limits (0 = no limit) are reached
+  // or shouldYield() returns true (checked between two jobs); hasPendingJobs is set to true if
+  // some jobs are left for the next tick.
+  // Errors thrown by the reaction handlers reject the related promises, so DUK_EXEC_ERROR is only
+  // returned (with the error at the top of the stack) for failures outside of them (e.g. OOM).
+  duk_int_t processJobs(int maxJobs, long long timeBudgetMs, const std::function<bool()> &shouldYield,
+                        bool &hasPendingJobs);
+
+  bool hasPendingJobs() const { return m_jobHead != m_jobTail; }
+
+  // Queue the job array at the top of the stack (and pop it)
+  void enqueueJob();
+
+private:
+  void reportUnhandledRejections() const;
+
+  duk_context *m_ctx;
+  UnhandledRejectionHandler m_unhandledRejectionHandler;
+
+  // The queued jobs are stored in a stash array at [m_jobHead, m_jobTail)
+  duk_uarridx_t m_jobHead = 0;
+  duk_uarridx_t m_jobTail = 0;
+};
+
+#endif
@@ -15,18 +15,185 @@
  */
 #include "DuktapeUtils.h"
 
-DuktapeUtils::DuktapeUtils(const JniContext *jniContext, duk_context *ctx)
+#include "ScratchArena.h"
+#include "jni-helpers/JStringLocalRef.h"
+#include <algorithm>
+#include <cstring>
+
+DuktapeUtils::DuktapeUtils(const JniContext *jniContext, duk_context *ctx, CppWrapperCounters *counters, ScratchArena *scratchArena)
  : m_jniContext(jniContext)
- , m_ctx(ctx) {
+ , m_ctx(ctx)
+ , m_counters(counters)
+ , m_scratchArena(scratchArena) {
+}
+
+void *DuktapeUtils::pushTypedArray(duk_uint_t bufferObjectType, duk_size_t byteLength) const {
+  CHECK_STACK_OFFSET(m_ctx, 1);
+
+  void *data = duk_push_fixed_buffer(m_ctx, byteLength);
+  duk_push_buffer_object(m_ctx, -1, 0, byteLength, bufferObjectType);
+  duk_remove(m_ctx, -2);  // plain buffer (referenced by the typed array)
+  return data;
+}
+
+size_t DuktapeUtils::pushString(const JStringLocalRef &jString) const {
+  CHECK_STACK_OFFSET(m_ctx, 1);
+
+  JNIEnv *env = JniRefHelper::getJNIEnv(m_jniContext);
+  const jsize utf16Length = env->GetStringLength(jString.jstr());
+  const auto utf8Length = static_cast<size_t>(env->GetStringUTFLength(jString.jstr()));
+
+  // + 1: some JNI implementations also write a terminating 0
+  ScratchScope scratchScope(m_scratchArena);
+  auto chars = m_scratchArena->allocate<char>(utf8Length + 1);
+  env->GetStringUTFRegion(jString.jstr(), 0, utf16Length, chars);
+
+  // Modified UTF-8 encodes U+0000 as C0 80 (and 0xC0 cannot occur otherwise)
+  if (memchr(chars, '\xc0', utf8Length) != nullptr) {
+    size_t j = 0;
+    for (size_t i = 0; i < utf8Length; ++i, ++j) {
+      if (chars[i] == '\xc0' && i + 1 < utf8Length && chars[i + 1] == '\x80') {
+        chars[j] = '\0';
+        ++i;
+      } else {
+        chars[j] = chars[i];
+      }
+    }
+    duk_push_lstring(m_ctx, chars, j);
+  } else {
+    duk_push_lstring(m_ctx, chars, utf8Length);
+  }
+
+  return utf8Length;
+}
+
+void DuktapeUtils::pushUtf8String(const char *chars, size_t length) const {
+  CHECK_STACK_OFFSET(m_ctx, 1);
+
+  // Only 4-byte sequences (lead bytes 0xF0 to 0xF4) differ between UTF-8 and CESU-8
+  const auto *bytes = reinterpret_cast<const uint8_t *>(chars);
+  const auto *firstNonBmp = std::find_if(bytes, bytes + length, [](uint8_t c) { return c >= 0xf0; });
+  if (firstNonBmp == bytes + length) {
+    duk_push_lstring(m_ctx, chars, length);
+    return;
+  }
+
+  // Each 4-byte sequence becomes 2 3-byte sequences
+  ScratchScope scratchScope(m_scratchArena);
+  auto cesu8Chars = m_scratchArena->allocate<uint8_t>(length + length / 2);
+  auto appendSurrogate = [&cesu8Chars](size_t &j, uint32_t surrogate) {
+    cesu8Chars[j++] = static_cast<uint8_t>(0xe0 | (surrogate >> 12));
+    cesu8Chars[j++] = static_cast<uint8_t>(0x80 | ((surrogate >> 6) & 0x3f));
+    cesu8Chars[j++] = static_cast<uint8_t>(0x80 | (surrogate & 0x3f));
+  };
+
+  size_t i = firstNonBmp - bytes;
+  memcpy(cesu8Chars, bytes, i);
+  size_t j = i;
+  while (i < length) {
+    const uint8_t c = bytes[i];
+    if (c >= 0xf0 && i + 3 < length && (bytes[i + 1] & 0xc0) == 0x80 && (bytes[i + 2] & 0xc0) == 0x80 && (bytes[i + 3] & 0xc0) == 0x80) {
+      const uint32_t codePoint = ((c & 0x07u) << 18) | ((bytes[i + 1] & 0x3fu) << 12) | ((bytes[i + 2] & 0x3fu) << 6) | (bytes[i + 3] & 0x3fu);
+      if (codePoint >= 0x10000 && codePoint <= 0x10ffff) {
+        appendSurrogate(j, 0xd800 + ((codePoint - 0x10000) >> 10));
+        appendSurrogate(j, 0xdc00 + ((codePoint - 0x10000) & 0x3ff));
+        i += 4;
+        continue;
+      }
+    }
+
+    // Other (or invalid) sequences are copied as they are
+    cesu8Chars[j++] = c;
+    ++i;
+  }
+
+  duk_push_lstring(m_ctx, reinterpret_cast<const char *>(cesu8Chars), j);
+}
+
+JStringLocalRef DuktapeUtils::toJString(duk_idx_t index, size_t *pUtf8Length) const {
+  CHECK_STACK(m_ctx);
+
+  duk_size_t length = 0;
+  const char *chars = duk_safe_to_lstring(m_ctx, index, &length);
+  if (pUtf8Length != nullptr) {
+    *pUtf8Length = length;
+  }
+
+  // The CESU-8 chars are null-terminated and can be given as they are, unless they contain
+  // U+0000 which must be encoded as C0 80 in modified UTF-8
+  if (memchr(chars, '\0', length) == nullptr) {
+    return JStringLocalRef(m_jniContext, chars);
+  }
+
+  ScratchScope scratchScope(m_scratchArena);
+  auto modifiedUtf8Chars = m_scratchArena->allocate<char>(2 * length + 1);
+  size_t j = 0;
+  for (duk_size_t i = 0; i < length; ++i) {
+    if (chars[i] == '\0') {
+      modifiedUtf8Chars[j++] = '\xc0';
+      modifiedUtf8Chars[j++] = '\x80';
+    } else {
+      modifiedUtf8Chars[j++] = chars[i];
+    }
+  }
+  modifiedUtf8Chars[j] = '\0';
+
+  return JStringLocalRef(m_jniContext, modifiedUtf8Chars);
+}
+
+void *DuktapeUtils::getTypedArrayData(duk_idx_t index, const char *typedArrayName, duk_size_t *pByteLength) const {
+  CHECK_STACK(m_ctx);
+
+  if (!duk_is_buffer_data(m_ctx, index)) {
+    return nullptr;
+  }
+
+  index = duk_normalize_index(m_ctx, index);
+
+  duk_get_global_string(m_ctx, typedArrayName);
+  bool isInstance = duk_instanceof(m_ctx, index, -1);
+  duk_pop(m_ctx);  // typed array constructor
+
+  if (!isInstance) {
+    return nullptr;
+  }
+
+  return duk_get_buffer_data(m_ctx, index, pByteLength);
+}
+
+void DuktapeUtils::pushNamedValueOwner(const std::string &name) const {
+  CHECK_STACK_OFFSET(m_ctx, 1);
+
+  static const size_t prefixLength = strlen(STASHED_NAME_PREFIX);
+  if (name.compare(0, prefixLength, STASHED_NAME_PREFIX) == 0) {
+    duk_push_global_stash(m_ctx);
+  } else {
+    duk_push_global_object(m_ctx);
+  }
+}
+
+void DuktapeUtils::pushCppWrapper(CppWrapper *cppWrapper) const {
+  CHECK_STACK_OFFSET(m_ctx, 1);
+
+  duk_push_object(m_ctx);
+  duk_push_pointer(m_ctx, cppWrapper);
+  duk_put_prop_literal(m_ctx, -2, CPP_WRAPPER_PROP_NAME);
+
+  // Always finalized: even if the wrapped instance is not deleted, the wrapper itself must be
+  duk_push_c_function(m_ctx, &DuktapeUtils::cppWrapperFinalizer, 1);
+  duk_set_finalizer(m_ctx, -2);
+
+  m_counters->cppWrapperCount++;
 }
 
 // static
 duk_ret_t DuktapeUtils::cppWrapperFinalizer(duk_context *ctx) {
   CHECK_STACK(ctx);
 
-  duk_get_prop_string(ctx, 0, CPP_WRAPPER_PROP_NAME);
+  duk_get_prop_literal(ctx, 0, CPP_WRAPPER_PROP_NAME);
   auto cppWrapper = reinterpret_cast<CppWrapper *>(duk_require_pointer(ctx, -1));
   cppWrapper->deleter();
+  delete cppWrapper;
 
   duk_pop(ctx);  // CPP wrapper
   return 0;
@@ -16,14 +16,18 @@
 #ifndef _JSBRIDGE_DUKTAPE_UTILS_H
 #define _JSBRIDGE_DUKTAPE_UTILS_H
 
+#include "CppWrapperCounters.h"
 #include "StackChecker.h"
 #include <functional>
+#include <string>
 #include <duktape/duktape.h>
 
-static const char *CPP_WRAPPER_PROP_NAME = "__cpp_wrapper";
-static const char *CPP_OBJECT_MAP_PROP_NAME = "__cpp_object_map";
+static const char CPP_WRAPPER_PROP_NAME[] = "__cpp_wrapper";
+static const char CPP_OBJECT_MAP_PROP_NAME[] = "__cpp_object_map";
 
 class JniContext;
+class ScratchArena;
+class JStringLocalRef;
 
 class DuktapeUtils {
 
@@ -32,7 +36,39 @@ public:
   DuktapeUtils(const DuktapeUtils &) = delete;
   DuktapeUtils &operator=(const DuktapeUtils &) = delete;
 
-  DuktapeUtils(const JniContext *, duk_context *);
+  DuktapeUtils(const JniContext *, duk_context *, CppWrapperCounters *, ScratchArena *);
+
+  // Push a new typed array (DUK_BUFOBJ_xxx type) backed by a new buffer with the given size and
+  // return a pointer to its data. The data stays valid as long as the typed array is alive.
+  // [...] => [... typedArray]
+  void *pushTypedArray(duk_uint_t bufferObjectType, duk_size_t byteLength) const;
+
+  // Return a pointer to the data of the typed array at the given index (or nullptr if it is not
+  // an instance of the given typed array, e.g. "Int32Array"). The data stays valid as long as the
+  // typed array is alive.
+  void *getTypedArrayData(duk_idx_t index, const char *typedArrayName, duk_size_t *pByteLength) const;
+
+  // Push the object holding the JS value with the given name: bridge-internal values (see
+  // STASHED_NAME_PREFIX) are kept in the global stash, which is not reachable from JS and does not
+  // grow the global object. All other names are resolved in the global object.
+  // [...] => [... owner]
+  void pushNamedValueOwner(const std::string &name) const;
+  static constexpr const char *STASHED_NAME_PREFIX = "__javaTypes_";
+
+  // Push the given Java string without any intermediate null-terminated copy: the modified UTF-8
+  // chars of the Java String are directly copied into a scratch buffer, which already matches
+  // the CESU-8 encoding of Duktape, and return its byte length
+  // [...] => [... string]
+  size_t pushString(const JStringLocalRef &) const;
+
+  // Push the given (standard) UTF-8 chars, converting the 4-byte sequences of the non-BMP code
+  // points into the surrogate pairs of the CESU-8 encoding of Duktape
+  // [...] => [... string]
+  void pushUtf8String(const char *chars, size_t length) const;
+
+  // Coerce the value at the given index to a string (in place, as duk_safe_to_string()) and
+  // convert its CESU-8 chars to a new Java string. The byte length is returned via pUtf8Length.
+  JStringLocalRef toJString(duk_idx_t index, size_t *pUtf8Length = nullptr) const;
 
   // Wrap a C++ instance inside a new JSValue and (optionally) ensure that it is
   // deleted when the JSValue gets finalized
@@ -40,20 +76,15 @@ public:
   void pushCppPtrValue(T *obj, bool deleteOnFinalize) const {
     CHECK_STACK_OFFSET(m_ctx, 1);
 
-    auto deleter = [deleteOnFinalize, obj]() {
+    auto counters = m_counters;
+    auto deleter = [deleteOnFinalize, obj, counters]() {
       if (deleteOnFinalize) {
         delete obj;
       }
+      counters->cppWrapperCount--;
     };
 
-    duk_push_object(m_ctx);
-    duk_push_pointer(m_ctx, new CppWrapper { obj, deleter });
-    duk_put_prop_string(m_ctx, -2, CPP_WRAPPER_PROP_NAME);
-
-    if (deleteOnFinalize) {
-      duk_push_c_function(m_ctx, &DuktapeUtils::cppWrapperFinalizer, 1);
-      duk_set_finalizer(m_ctx, -2);
-    }
+    pushCppWrapper(new CppWrapper { obj, deleter });
   }
 
   // Access the instance wrapped at the given index via createCppPtrValue()
@@ -61,7 +92,7 @@ public:
   T *getCppPtr(duk_idx_t index) const {
     CHECK_STACK(m_ctx);
 
-    if (!duk_get_prop_string(m_ctx, index, CPP_WRAPPER_PROP_NAME)) {
+    if (!duk_get_prop_literal(m_ctx, index, CPP_WRAPPER_PROP_NAME)) {
       duk_pop(m_ctx);
       return nullptr;
     }
@@ -93,11 +124,11 @@ public:
     index = duk_normalize_index(m_ctx, index);
 
     // Get or create CPP object map
-    if (!duk_get_prop_string(m_ctx, index, CPP_OBJECT_MAP_PROP_NAME)) {
+    if (!duk_get_prop_literal(m_ctx, index, CPP_OBJECT_MAP_PROP_NAME)) {
       duk_pop(m_ctx);
       duk_push_object(m_ctx);
       duk_dup(m_ctx, -1);
-      duk_put_prop_string(m_ctx, index, CPP_OBJECT_MAP_PROP_NAME);
+      duk_put_prop_literal(m_ctx, index, CPP_OBJECT_MAP_PROP_NAME);
     }
 
     // Store it in object_at_index.cppObjectMap["lambda_global_name"]
@@ -113,7 +144,7 @@ public:
     CHECK_STACK(m_ctx);
 
     // Get CPP object map
-    if (!duk_get_prop_string(m_ctx, index, CPP_OBJECT_MAP_PROP_NAME)) {
+    if (!duk_get_prop_literal(m_ctx, index, CPP_OBJECT_MAP_PROP_NAME)) {
       duk_pop(m_ctx);  // undefined CPP object map
       return nullptr;
     }
@@ -128,6 +159,23 @@ public:
     return cppObject;
   }
 
+  // Push the value wrapping a C++ instance mapped inside a JSValue via createMappedCppPtrValue()
+  // (or undefined if there is none). Keeping it alive also keeps the C++ instance alive, even if
+  // the mapping is replaced.
+  // [...] => [... cppValue]
+  void pushMappedCppValue(duk_idx_t index, const char *key) const {
+    CHECK_STACK_OFFSET(m_ctx, 1);
+
+    // Get CPP object map
+    if (!duk_get_prop_literal(m_ctx, index, CPP_OBJECT_MAP_PROP_NAME)) {
+      return;  // undefined CPP object map
+    }
+
+    // Get the C++ wrapper stored in jsObject.cppObjectMap["lambda_global_name"]
+    duk_get_prop_string(m_ctx, -1, key);
+    duk_remove(m_ctx, -2);  // CPP object map
+  }
+
   // Wrap a JNI ref inside a new JSValue and ensure that it's properly
   // released when the JSValue gets finalized
   template <class T>
@@ -135,7 +183,16 @@ public:
     CHECK_STACK_OFFSET(m_ctx, 1);
 
     auto globalRefPtr = new JniGlobalRef<T>(ref);
-    pushCppPtrValue(globalRefPtr, true);
+
+    auto counters = m_counters;
+    auto deleter = [globalRefPtr, counters]() {
+      delete globalRefPtr;
+      counters->cppWrapperCount--;
+      counters->javaRefCount--;
+    };
+
+    pushCppWrapper(new CppWrapper { globalRefPtr, deleter });
+    m_counters->javaRefCount++;
   }
 
   // Access a JNI ref wrapped in a JSValue via createJavaRefValue()
@@ -151,10 +208,16 @@ private:
     std::function<void()> deleter;
   } CppWrapper;
 
+  // Push a new JS object holding the given wrapper which is deleted when the object gets finalized
+  // [...] => [... cppWrapperObject]
+  void pushCppWrapper(CppWrapper *) const;
+
   static duk_ret_t cppWrapperFinalizer(duk_context *);
 
   const JniContext *m_jniContext;
   duk_context *m_ctx;
+  CppWrapperCounters *m_counters;
+  ScratchArena *m_scratchArena;
 };
 
 #endif
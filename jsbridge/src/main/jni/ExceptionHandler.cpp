@@ -21,6 +21,7 @@
 #include "ExceptionHandler.h"
 #include "JniCache.h"
 #include "JsBridgeContext.h"
+#include "JsValueTable.h"
 #include "custom_stringify.h"
 #include "exceptions/JniException.h"
 #include "exceptions/JsException.h"
@@ -37,9 +38,107 @@
 // Internal
 // ---
 
+#if defined(DUKTAPE)
 namespace {
-  const char *JAVA_EXCEPTION_PROP_NAME = "__java_exception";
+  // (QuickJS uses the atom interned by QuickJsUtils)
+  const char JAVA_EXCEPTION_PROP_NAME[] = "__java_exception";
+  const char STASHED_ERRORS_PROP_NAME[] = "\xff\xffstashed_errors";
+  const char JAVA_ERROR_PROTOTYPE_PROP_NAME[] = "\xff\xff" "java_error_prototype";
+
+  // [...] => [... stashedErrors]
+  void pushStashedErrors(duk_context *ctx) {
+    duk_push_heap_stash(ctx);
+    duk_get_prop_literal(ctx, -1, STASHED_ERRORS_PROP_NAME);
+    duk_remove(ctx, -2);  // heap stash
+  }
+
+  // The message of the JS errors wrapping a Java exception is only read from Java when accessed
+  // for the first time, and then stored as an own property of the error
+  duk_ret_t javaErrorMessageGetter(duk_context *ctx) {
+    const JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    const JniContext *jniContext = jsBridgeContext->getJniContext();
+
+    duk_push_this(ctx);
+    if (!duk_is_object(ctx, 0) || !duk_has_prop_literal(ctx, 0, JAVA_EXCEPTION_PROP_NAME)) {
+      return 0;  // e.g. the prototype itself
+    }
+
+    duk_get_prop_literal(ctx, 0, JAVA_EXCEPTION_PROP_NAME);
+    JniLocalRef<jthrowable> throwable = jsBridgeContext->getUtils()->getJavaRef<jthrowable>(-1);
+    duk_pop(ctx);  // Java exception
+
+    JStringLocalRef messageRef = jsBridgeContext->getJniCache()->getThrowableMessage(throwable);
+    if (jniContext->exceptionCheck()) {
+      jsBridgeContext->getExceptionHandler()->jsThrow(JniException(jniContext));
+    }
+
+    const char *messageStr = messageRef.toUtf8Chars();
+    duk_push_string(ctx, messageStr ? messageStr : "<null>");
+
+    // [this message] => [this message]
+    duk_push_literal(ctx, "message");
+    duk_dup(ctx, -2);
+    duk_def_prop(ctx, 0, DUK_DEFPROP_HAVE_VALUE | DUK_DEFPROP_SET_WRITABLE | DUK_DEFPROP_SET_CONFIGURABLE | DUK_DEFPROP_CLEAR_ENUMERABLE);
+    return 1;
+  }
+
+  duk_ret_t javaErrorMessageSetter(duk_context *ctx) {
+    // [value] => [value this]
+    duk_push_this(ctx);
+    if (!duk_is_object(ctx, 1)) {
+      return 0;
+    }
+
+    duk_push_literal(ctx, "message");
+    duk_dup(ctx, 0);
+    duk_def_prop(ctx, 1, DUK_DEFPROP_HAVE_VALUE | DUK_DEFPROP_SET_WRITABLE | DUK_DEFPROP_SET_CONFIGURABLE | DUK_DEFPROP_CLEAR_ENUMERABLE);
+    return 0;
+  }
 }
+#elif defined(QUICKJS)
+namespace {
+  // The message of the JS errors wrapping a Java exception is only read from Java when accessed
+  // for the first time, and then stored as an own property of the error
+  JSValue javaErrorMessageGetter(JSContext *ctx, JSValueConst this_val, int, JSValueConst *) {
+    const JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    const JniContext *jniContext = jsBridgeContext->getJniContext();
+    const QuickJsUtils *utils = jsBridgeContext->getUtils();
+
+    if (!JS_IsObject(this_val)) {
+      return JS_UNDEFINED;
+    }
+
+    JSValue javaExceptionValue = utils->getProperty(this_val, QuickJsUtils::PropertyName::JavaException);
+    JniLocalRef<jthrowable> throwable = utils->getJavaRef<jthrowable>(javaExceptionValue);
+    JS_FreeValue(ctx, javaExceptionValue);
+    if (throwable.isNull()) {
+      return JS_UNDEFINED;  // e.g. the prototype itself
+    }
+
+    JStringLocalRef messageRef = jsBridgeContext->getJniCache()->getThrowableMessage(throwable);
+    if (jniContext->exceptionCheck()) {
+      jsBridgeContext->getExceptionHandler()->jsThrow(JniException(jniContext));
+      return JS_EXCEPTION;
+    }
+
+    JSValue messageValue = messageRef.isNull() ? JS_NewString(ctx, "<null>") : utils->toJsString(messageRef);
+    JS_DefinePropertyValue(ctx, this_val, utils->getAtom(QuickJsUtils::PropertyName::Message),
+                           JS_DupValue(ctx, messageValue), JS_PROP_WRITABLE | JS_PROP_CONFIGURABLE);
+    return messageValue;
+  }
+
+  JSValue javaErrorMessageSetter(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    if (!JS_IsObject(this_val) || argc < 1) {
+      return JS_UNDEFINED;
+    }
+
+    const QuickJsUtils *utils = JsBridgeContext::getInstance(ctx)->getUtils();
+    JS_DefinePropertyValue(ctx, this_val, utils->getAtom(QuickJsUtils::PropertyName::Message),
+                           JS_DupValue(ctx, argv[0]), JS_PROP_WRITABLE | JS_PROP_CONFIGURABLE);
+    return JS_UNDEFINED;
+  }
+}
+#endif
 
 
 // Class methods
@@ -47,7 +146,88 @@ namespace {
 
 ExceptionHandler::ExceptionHandler(const JsBridgeContext *jsBridgeContext)
  : m_jsBridgeContext(jsBridgeContext) {
+
+#if defined(DUKTAPE)
+  duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
+  CHECK_STACK(ctx);
+
+  duk_push_heap_stash(ctx);
+  duk_push_array(ctx);
+  duk_put_prop_literal(ctx, -2, STASHED_ERRORS_PROP_NAME);
+
+  // Prototype of the JS errors wrapping a Java exception (inheriting from Error.prototype) with a
+  // lazy message accessor
+  duk_push_object(ctx);
+  duk_get_global_literal(ctx, "Error");
+  duk_get_prop_literal(ctx, -1, "prototype");
+  duk_set_prototype(ctx, -3);
+  duk_pop(ctx);  // Error
+  duk_push_literal(ctx, "message");
+  duk_push_c_function(ctx, javaErrorMessageGetter, 0);
+  duk_push_c_function(ctx, javaErrorMessageSetter, 1);
+  duk_def_prop(ctx, -4, DUK_DEFPROP_HAVE_GETTER | DUK_DEFPROP_HAVE_SETTER | DUK_DEFPROP_SET_CONFIGURABLE | DUK_DEFPROP_CLEAR_ENUMERABLE);
+  duk_put_prop_literal(ctx, -2, JAVA_ERROR_PROTOTYPE_PROP_NAME);
+
+  duk_pop(ctx);  // heap stash
+#elif defined(QUICKJS)
+  JSContext *ctx = m_jsBridgeContext->getQuickJsContext();
+  QuickJsUtils *utils = m_jsBridgeContext->getUtils();
+
+  // Prototype of the JS errors wrapping a Java exception (inheriting from Error.prototype) with a
+  // lazy message accessor
+  JSValue errorValue = JS_NewError(ctx);
+  JSValue errorPrototype = JS_GetPrototype(ctx, errorValue);
+  JSValue prototype = JS_NewObjectProto(ctx, errorPrototype);
+  JS_DefinePropertyGetSet(ctx, prototype, utils->getAtom(QuickJsUtils::PropertyName::Message),
+                          JS_NewCFunction(ctx, javaErrorMessageGetter, "get message", 0),
+                          JS_NewCFunction(ctx, javaErrorMessageSetter, "set message", 1),
+                          JS_PROP_CONFIGURABLE);
+  utils->setJavaErrorPrototype(prototype);
+  JS_FreeValue(ctx, errorPrototype);
+  JS_FreeValue(ctx, errorValue);
+#endif
+}
+
+#if defined(DUKTAPE)
+uint32_t ExceptionHandler::stashError(duk_idx_t idx) const {
+  duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
+
+  uint32_t slot;
+  if (m_freeStashedErrorSlots.empty()) {
+    slot = m_stashedErrorSlotCount++;
+  } else {
+    slot = m_freeStashedErrorSlots.back();
+    m_freeStashedErrorSlots.pop_back();
+  }
+
+  duk_idx_t errorIdx = duk_normalize_index(ctx, idx);
+  pushStashedErrors(ctx);
+  duk_dup(ctx, errorIdx);
+  duk_put_prop_index(ctx, -2, slot);
+  duk_pop(ctx);  // stashed errors
+
+  return slot;
+}
+
+void ExceptionHandler::pushStashedError(uint32_t slot) const {
+  duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
+
+  pushStashedErrors(ctx);
+  duk_get_prop_index(ctx, -1, slot);
+  duk_remove(ctx, -2);  // stashed errors
+}
+
+void ExceptionHandler::releaseStashedError(uint32_t slot) const {
+  duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
+
+  pushStashedErrors(ctx);
+  duk_push_undefined(ctx);
+  duk_put_prop_index(ctx, -2, slot);
+  duk_pop(ctx);  // stashed errors
+
+  m_freeStashedErrorSlots.push_back(slot);
 }
+#endif
 
 // Throws a C++ JsException based on the current JavaScript error:
 // - Duktape: error at the top of the Duktape stack (note: the error will be popped!)
@@ -64,14 +244,21 @@ JsException ExceptionHandler::getCurrentJsException() const {
 }
 
 void ExceptionHandler::jsThrow(const std::exception &e) const {
+  // Note: a single RTTI lookup for the (most common) bridge exceptions
+  auto bridgeException = dynamic_cast<const JsBridgeException *>(&e);
+
 #if defined(DUKTAPE)
   duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
 
-  if (auto jniException = dynamic_cast<const JniException *>(&e)) {
-    pushJavaException(jniException->getThrowable());
-    duk_throw(ctx);
-  } else if (auto jsException = dynamic_cast<const JsException *>(&e)) {
-    jsException->pushError();
+  if (bridgeException != nullptr) {
+    switch (bridgeException->kind()) {
+      case JsBridgeException::Kind::Jni:
+        pushJavaException(static_cast<const JniException *>(bridgeException)->getThrowable());
+        break;
+      case JsBridgeException::Kind::Js:
+        static_cast<const JsException *>(bridgeException)->pushError();
+        break;
+    }
     duk_throw(ctx);
   } else if (dynamic_cast<const std::invalid_argument *>(&e)) {
     duk_error(ctx, DUK_ERR_TYPE_ERROR, e.what());
@@ -81,12 +268,17 @@ void ExceptionHandler::jsThrow(const std::exception &e) const {
 #elif defined(QUICKJS)
   JSContext *ctx = m_jsBridgeContext->getQuickJsContext();
 
-  if (auto jniException = dynamic_cast<const JniException *>(&e)) {
-    JS_Throw(ctx, javaExceptionToJsValue(jniException->getThrowable()));
-    // No JS_FreeValue(m_ctx, errorValue) after JS_Throw()
-  } else if (auto jsException = dynamic_cast<const JsException *>(&e)) {
-    JS_Throw(ctx, jsException->getValue());
-    // No JS_FreeValue(m_ctx, errorValue) after JS_Throw()
+  if (bridgeException != nullptr) {
+    switch (bridgeException->kind()) {
+      case JsBridgeException::Kind::Jni:
+        JS_Throw(ctx, javaExceptionToJsValue(static_cast<const JniException *>(bridgeException)->getThrowable()));
+        // No JS_FreeValue(m_ctx, errorValue) after JS_Throw()
+        break;
+      case JsBridgeException::Kind::Js:
+        JS_Throw(ctx, static_cast<const JsException *>(bridgeException)->getValue());
+        // No JS_FreeValue(m_ctx, errorValue) after JS_Throw()
+        break;
+    }
   } else if (dynamic_cast<const std::invalid_argument *>(&e)) {
     JS_ThrowTypeError(m_jsBridgeContext->getQuickJsContext(), "%s", e.what());
   } else {
@@ -98,10 +290,16 @@ void ExceptionHandler::jsThrow(const std::exception &e) const {
 void ExceptionHandler::jniThrow(const std::exception &e) const {
   const JniContext *jniContext = m_jsBridgeContext->getJniContext();
 
-  if (auto jniException = dynamic_cast<const JniException *>(&e)) {
-    jniContext->throw_(jniException->getThrowable());
-  } else if (auto jsException = dynamic_cast<const JsException *>(&e)) {
-    jniContext->throw_(getJavaException(*jsException));
+  // Note: a single RTTI lookup for the (most common) bridge exceptions
+  if (auto bridgeException = dynamic_cast<const JsBridgeException *>(&e)) {
+    switch (bridgeException->kind()) {
+      case JsBridgeException::Kind::Jni:
+        jniContext->throw_(static_cast<const JniException *>(bridgeException)->getThrowable());
+        break;
+      case JsBridgeException::Kind::Js:
+        jniContext->throw_(getJavaException(*static_cast<const JsException *>(bridgeException)));
+        break;
+    }
   } else if (dynamic_cast<const std::invalid_argument *>(&e)) {
     const JniCache *jniCache = m_jsBridgeContext->getJniCache();
     jniContext->throwNew(jniCache->getIllegalArgumentExceptionClass(), e.what());
@@ -120,13 +318,12 @@ JniLocalRef<jthrowable> ExceptionHandler::getJavaException(const JsException &js
 
   jsException.pushError();
 
-  // Create the JSON string
-  const char *jsonStringRaw = nullptr;
-  if (custom_stringify(ctx, -1, false /*keepErrorStack*/) == DUK_EXEC_SUCCESS) {
-    jsonStringRaw = duk_get_string(ctx, -1);
+  // Keep a handle to the error instead of eagerly creating its JSON string
+  JniLocalRef<jobject> errorValue = newJavaErrorValue();
+  JStringLocalRef jsonString;
+  if (errorValue.isNull()) {
+    jsonString = stringifyError();
   }
-  JStringLocalRef jsonString(jniContext, jsonStringRaw);
-  duk_pop(ctx);  // stringified string
 
   duk_dup(ctx, -1);  // JS error
   const std::string stack = duk_safe_to_stacktrace(ctx, -1);
@@ -137,12 +334,12 @@ JniLocalRef<jthrowable> ExceptionHandler::getJavaException(const JsException &js
 
   // Is there an exception thrown from a Java method?
   JniLocalRef<jthrowable> cause;
-  if (duk_is_object(ctx, -1) && !duk_is_null(ctx, -1) && duk_has_prop_string(ctx, -1, JAVA_EXCEPTION_PROP_NAME)) {
-    duk_get_prop_string(ctx, -1, JAVA_EXCEPTION_PROP_NAME);
+  if (duk_is_object(ctx, -1) && !duk_is_null(ctx, -1) && duk_has_prop_literal(ctx, -1, JAVA_EXCEPTION_PROP_NAME)) {
+    duk_get_prop_literal(ctx, -1, JAVA_EXCEPTION_PROP_NAME);
     cause = m_jsBridgeContext->getUtils()->getJavaRef<jthrowable>(-1);
     duk_pop(ctx);  // Java exception
-  } else if (duk_is_object(ctx, -1) && !duk_is_null(ctx, -1) && duk_has_prop_string(ctx, -1, "cause")) {
-    duk_get_prop_string(ctx, -1, "cause");
+  } else if (duk_is_object(ctx, -1) && !duk_is_null(ctx, -1) && duk_has_prop_literal(ctx, -1, "cause")) {
+    duk_get_prop_literal(ctx, -1, "cause");
     cause = getJavaException(JsException(m_jsBridgeContext, -1));
   }
 
@@ -152,7 +349,8 @@ JniLocalRef<jthrowable> ExceptionHandler::getJavaException(const JsException &js
       jsonString,  // jsonValue
       JStringLocalRef(jniContext, jsException.what()),  // detailedMessage
       JStringLocalRef(jniContext, strJsStacktrace.c_str()),  // jsStackTrace
-      cause
+      cause,
+      errorValue
   );
 #elif defined(QUICKJS)
   auto ctx = m_jsBridgeContext->getQuickJsContext();
@@ -163,18 +361,18 @@ JniLocalRef<jthrowable> ExceptionHandler::getJavaException(const JsException &js
   JniLocalRef<jthrowable> ret;
 
   JSValue exceptionValue = jsException.getValue();
-  JSValue jsonValue = custom_stringify(ctx, exceptionValue, false /*keepErrorStack*/);
+
+  // Keep a handle to the error instead of eagerly creating its JSON string
+  JniLocalRef<jobject> errorValue = newJavaErrorValue(exceptionValue);
   JStringLocalRef jsonString;
-  if (JS_IsException(jsonValue)) {
-    JS_GetException(ctx);
-  } else {
-    jsonString = utils->toJString(jsonValue);
+  if (errorValue.isNull()) {
+    jsonString = stringifyError(exceptionValue);
   }
 
   // Is there an exception thrown from a Java method?
   JniLocalRef<jthrowable> cause;
   if (JS_IsObject(exceptionValue) && !JS_IsNull(exceptionValue)) {
-    JSValue javaExceptionValue = JS_GetPropertyStr(ctx, exceptionValue, JAVA_EXCEPTION_PROP_NAME);
+    JSValue javaExceptionValue = utils->getProperty(exceptionValue, QuickJsUtils::PropertyName::JavaException);
     if (!JS_IsUndefined(javaExceptionValue)) {
       // Cause is a Java exception
       cause = utils->getJavaRef<jthrowable>(javaExceptionValue);
@@ -182,7 +380,7 @@ JniLocalRef<jthrowable> ExceptionHandler::getJavaException(const JsException &js
     } else {
       // Cause explicitely given by the JS Error instance
       alog("We have a cause!!!");
-      JSValue jsCauseValue = JS_GetPropertyStr(ctx, exceptionValue, "cause");
+      JSValue jsCauseValue = utils->getProperty(exceptionValue, QuickJsUtils::PropertyName::Cause);
       if (!JS_IsUndefined(jsCauseValue)) {
         cause = getJavaException(JsException(m_jsBridgeContext, jsCauseValue));
       }
@@ -193,7 +391,7 @@ JniLocalRef<jthrowable> ExceptionHandler::getJavaException(const JsException &js
 
   if (JS_IsError(ctx, exceptionValue)) {
     // Get the stack trace
-    JSValue stackValue = JS_GetPropertyStr(ctx, exceptionValue, "stack");
+    JSValue stackValue = utils->getProperty(exceptionValue, QuickJsUtils::PropertyName::Stack);
     if (!JS_IsUndefined(stackValue)) {
       stack = utils->toString(stackValue);
     }
@@ -204,60 +402,137 @@ JniLocalRef<jthrowable> ExceptionHandler::getJavaException(const JsException &js
       jsonString,  // jsonValue
       JStringLocalRef(jniContext, jsException.what()),  // detailedMessage
       JStringLocalRef(jniContext, stack.c_str()),  // jsStackTrace
-      cause
+      cause,
+      errorValue
   );
 
-  JS_FreeValue(ctx, jsonValue);
   return ret;
 #endif
 }
 
+JStringLocalRef ExceptionHandler::getJsonValue(jlong errorHandle) const {
 #if defined(DUKTAPE)
+  auto ctx = m_jsBridgeContext->getDuktapeContext();
+  CHECK_STACK(ctx);
 
-void ExceptionHandler::pushJavaException(const JniLocalRef<jthrowable> &throwable) const {
+  m_jsBridgeContext->getJsValueTable()->push(errorHandle);
+  JStringLocalRef ret = stringifyError();
+  duk_pop(ctx);  // error
+  return ret;
+#elif defined(QUICKJS)
+  JSValue errorValue = m_jsBridgeContext->getJsValueTable()->get(errorHandle);
+  JS_AUTORELEASE_VALUE(m_jsBridgeContext->getQuickJsContext(), errorValue);
+  return stringifyError(errorValue);
+#endif
+}
+
+#if defined(DUKTAPE)
+
+JStringLocalRef ExceptionHandler::stringifyError() const {
+  auto ctx = m_jsBridgeContext->getDuktapeContext();
+
+  const char *jsonStringRaw = nullptr;
+  if (custom_stringify(ctx, -1, false /*keepErrorStack*/) == DUK_EXEC_SUCCESS) {
+    jsonStringRaw = duk_get_string(ctx, -1);
+  }
+  JStringLocalRef jsonString(m_jsBridgeContext->getJniContext(), jsonStringRaw);
+  duk_pop(ctx);  // stringified string
+
+  return jsonString;
+}
+
+JniLocalRef<jobject> ExceptionHandler::newJavaErrorValue() const {
+  auto ctx = m_jsBridgeContext->getDuktapeContext();
   const JniContext *jniContext = m_jsBridgeContext->getJniContext();
-  auto exceptionClass = jniContext->getObjectClass(throwable);
-  jmethodID getMessage = jniContext->getMethodID(exceptionClass, "getMessage", "()Ljava/lang/String;");
-  JStringLocalRef messageRef = jniContext->callStringMethod(throwable, getMessage);
+  JsValueTable *jsValueTable = m_jsBridgeContext->getJsValueTable();
+
+  duk_dup(ctx, -1);
+  jlong handle = jsValueTable->add();
+  JniLocalRef<jobject> ret = m_jsBridgeContext->getJniCache()->newJsValue(handle);
+  if (jniContext->exceptionCheck()) {
+    // Fallback: the JSON value will be directly created
+    jniContext->exceptionClear();
+    jsValueTable->remove(handle);
+    return JniLocalRef<jobject>();
+  }
+
+  return ret;
+}
+
+#elif defined(QUICKJS)
+
+JStringLocalRef ExceptionHandler::stringifyError(JSValueConst errorValue) const {
+  auto ctx = m_jsBridgeContext->getQuickJsContext();
+  const QuickJsUtils *utils = m_jsBridgeContext->getUtils();
+
+  JSValue jsonValue = custom_stringify(ctx, utils, errorValue, false /*keepErrorStack*/);
+  JStringLocalRef jsonString;
+  if (JS_IsException(jsonValue)) {
+    JS_GetException(ctx);
+  } else {
+    jsonString = utils->toJString(jsonValue);
+  }
 
+  JS_FreeValue(ctx, jsonValue);
+  return jsonString;
+}
+
+JniLocalRef<jobject> ExceptionHandler::newJavaErrorValue(JSValueConst errorValue) const {
+  const JniContext *jniContext = m_jsBridgeContext->getJniContext();
+  JsValueTable *jsValueTable = m_jsBridgeContext->getJsValueTable();
+
+  jlong handle = jsValueTable->add(errorValue);
+  JniLocalRef<jobject> ret = m_jsBridgeContext->getJniCache()->newJsValue(handle);
+  if (jniContext->exceptionCheck()) {
+    // Fallback: the JSON value will be directly created
+    jniContext->exceptionClear();
+    jsValueTable->remove(handle);
+    return JniLocalRef<jobject>();
+  }
+
+  return ret;
+}
 
+#endif
+
+#if defined(DUKTAPE)
+
+void ExceptionHandler::pushJavaException(const JniLocalRef<jthrowable> &throwable) const {
   // Propagate Java exception to JavaScript (and store pointer to Java exception)
+  // Note: the message is only read when accessed (see javaErrorMessageGetter()), i.e. never if
+  // the error is caught and discarded
   // ---
 
   auto ctx = m_jsBridgeContext->getDuktapeContext();
 
-  const char *messageStr = messageRef.toUtf8Chars();
-  if (!messageStr) messageStr = "<null>";
-  duk_push_error_object(ctx, DUK_ERR_ERROR, messageStr);
+  // (with its stack trace, without the default numeric message)
+  duk_push_error_object(ctx, DUK_ERR_ERROR, nullptr);
+  duk_del_prop_literal(ctx, -1, "message");
+  duk_push_heap_stash(ctx);
+  duk_get_prop_literal(ctx, -1, JAVA_ERROR_PROTOTYPE_PROP_NAME);
+  duk_remove(ctx, -2);  // heap stash
+  duk_set_prototype(ctx, -2);
 
   m_jsBridgeContext->getUtils()->pushJavaRefValue(throwable);
-  duk_put_prop_string(ctx, -2, JAVA_EXCEPTION_PROP_NAME);
+  duk_put_prop_literal(ctx, -2, JAVA_EXCEPTION_PROP_NAME);
 }
 
 #elif defined(QUICKJS)
 
 JSValue ExceptionHandler::javaExceptionToJsValue(const JniLocalRef<jthrowable> &throwable) const {
-  const JniContext *jniContext = m_jsBridgeContext->getJniContext();
-  auto exceptionClass = jniContext->getObjectClass(throwable);
-  jmethodID getMessage = jniContext->getMethodID(exceptionClass, "getMessage", "()Ljava/lang/String;");
-  JStringLocalRef messageRef = jniContext->callStringMethod(throwable, getMessage);
-
-
   // Propagate Java exception to JavaScript (and store pointer to Java exception)
+  // Note: the message is only read when accessed (see javaErrorMessageGetter()), i.e. never if
+  // the error is caught and discarded
   // ---
 
   auto ctx = m_jsBridgeContext->getQuickJsContext();
 
   JSValue errorValue = JS_NewError(ctx);
-  const char *messageStr = messageRef.toUtf8Chars();
-  if (!messageStr) messageStr = "<null>";
-  JSValue messageValue = JS_NewString(ctx, messageStr);
-  JS_SetPropertyStr(ctx, errorValue, "message", messageValue);
-  // No JS_FreeValue(m_ctx, messageValue) after JS_SetPropertyStr()
+  JS_SetPrototype(ctx, errorValue, m_jsBridgeContext->getUtils()->getJavaErrorPrototype());
 
   JSValue javaExceptionValue = m_jsBridgeContext->getUtils()->createJavaRefValue(throwable);
-  JS_SetPropertyStr(ctx, errorValue, JAVA_EXCEPTION_PROP_NAME, javaExceptionValue);
-  // No JS_FreeValue(m_ctx, javaExcueptionValue) after JS_SetPropertyStr()
+  m_jsBridgeContext->getUtils()->setProperty(errorValue, QuickJsUtils::PropertyName::JavaException, javaExceptionValue);
+  // No JS_FreeValue(m_ctx, javaExcueptionValue) after setProperty()
 
   return errorValue;
 }
@@ -19,10 +19,15 @@
 #ifndef _JSBRIDGE_EXCEPTIONHANDLER_H
 #define _JSBRIDGE_EXCEPTIONHANDLER_H
 
+#include "jni-helpers/JStringLocalRef.h"
 #include "jni-helpers/JniLocalRef.h"
+#include <cstdint>
 #include <string>
+#include <vector>
 
-#if defined(QUICKJS)
+#if defined(DUKTAPE)
+# include "duktape/duktape.h"
+#elif defined(QUICKJS)
 # include "quickjs/quickjs.h"
 #endif
 
@@ -41,8 +46,12 @@ public:
   JsException getCurrentJsException() const;
 
   // C++ JsException -> Java exception
+  // (the JSON value of the error is only created when read from Java, see getJsonValue())
   JniLocalRef<jthrowable> getJavaException(const JsException &) const;
 
+  // JSON value of a JS error stored in the JsValue table (lazily read by a Java JsException)
+  JStringLocalRef getJsonValue(jlong errorHandle) const;
+
   // Java exception -> JS exception
 #if defined(DUKTAPE)
   void pushJavaException(const JniLocalRef<jthrowable> &) const;
@@ -54,8 +63,30 @@ public:
   void jsThrow(const std::exception &) const;
   void jniThrow(const std::exception &) const;
 
+#if defined(DUKTAPE)
+  // The errors captured by JsException instances are kept alive in a stash array whose slots are
+  // recycled via a free list (no new string key per error)
+  uint32_t stashError(duk_idx_t) const;
+  // [...] => [... error]
+  void pushStashedError(uint32_t slot) const;
+  void releaseStashedError(uint32_t slot) const;
+#endif
+
 private:
+#if defined(DUKTAPE)
+  // [... error] => [... error]
+  JStringLocalRef stringifyError() const;
+  JniLocalRef<jobject> newJavaErrorValue() const;
+#elif defined(QUICKJS)
+  JStringLocalRef stringifyError(JSValueConst) const;
+  JniLocalRef<jobject> newJavaErrorValue(JSValueConst) const;
+#endif
+
   const JsBridgeContext *m_jsBridgeContext;
+#if defined(DUKTAPE)
+  mutable uint32_t m_stashedErrorSlotCount = 0;
+  mutable std::vector<uint32_t> m_freeStashedErrorSlots;
+#endif
 };
 
 #endif
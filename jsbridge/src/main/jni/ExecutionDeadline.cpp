@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "ExecutionDeadline.h"
+
+#include "JsProfiler.h"
+
+ExecutionDeadline::Scope::Scope(ExecutionDeadline &executionDeadline)
+ : m_executionDeadline(executionDeadline) {
+
+  if (m_executionDeadline.m_scopeDepth++ == 0 && m_executionDeadline.m_timeoutMs > 0) {
+    m_executionDeadline.m_deadline = Clock::now() + std::chrono::milliseconds(m_executionDeadline.m_timeoutMs);
+    m_executionDeadline.m_exceeded = false;
+  }
+}
+
+ExecutionDeadline::Scope::~Scope() {
+  if (--m_executionDeadline.m_scopeDepth == 0) {
+    m_executionDeadline.m_exceeded = false;
+
+    if (m_executionDeadline.m_profiler != nullptr) {
+      m_executionDeadline.m_profiler->onEvaluationEnd();
+    }
+  }
+}
+
+bool ExecutionDeadline::check(bool *pJustExceeded) {
+  *pJustExceeded = false;
+
+  if (m_scopeDepth == 0 || m_timeoutMs <= 0) {
+    return false;
+  }
+
+  if (!m_exceeded && Clock::now() >= m_deadline) {
+    m_exceeded = true;
+    *pJustExceeded = true;
+  }
+
+  return m_exceeded;
+}
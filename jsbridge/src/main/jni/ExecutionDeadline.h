@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_EXECUTIONDEADLINE_H
+#define _JSBRIDGE_EXECUTIONDEADLINE_H
+
+#include <atomic>
+#include <chrono>
+
+class JsProfiler;
+
+// Optional time budget of each JS evaluation started from Java (disabled by default)
+//
+// The deadline is set by the outermost Scope (nested evaluations, e.g. from Java code called by
+// JS, share it) and checked by the interrupt handler of the JS engine, which aborts the script
+// once it has been exceeded. It stays exceeded until the outermost Scope ends so that the script
+// cannot catch the error and keep running.
+//
+// It also carries the yield requests of the JS thread scheduler: the long-running native loops
+// (e.g. the promise jobs) stop at their next safe point when more urgent work is waiting.
+//
+// Must only be used from the JS thread (except requestYield()).
+class ExecutionDeadline {
+
+public:
+  class Scope {
+  public:
+    explicit Scope(ExecutionDeadline &);
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+    ~Scope();
+
+  private:
+    ExecutionDeadline &m_executionDeadline;
+  };
+
+  ExecutionDeadline() = default;
+  ExecutionDeadline(const ExecutionDeadline &) = delete;
+  ExecutionDeadline &operator=(const ExecutionDeadline &) = delete;
+
+  // 0: no timeout
+  void setTimeoutMs(long long timeoutMs) { m_timeoutMs = timeoutMs; }
+  long long getTimeoutMs() const { return m_timeoutMs; }
+
+  // Optional profiler notified at the end of each outermost Scope (see JsProfiler)
+  void setProfiler(JsProfiler *profiler) { m_profiler = profiler; }
+
+  // Return true while a JS evaluation is running (e.g. when Java code called by JS calls back
+  // into JS)
+  bool isInScope() const { return m_scopeDepth > 0; }
+
+  // Return true if the deadline of the current evaluation has been exceeded and set
+  // *pJustExceeded if it is the first check since then
+  bool check(bool *pJustExceeded);
+
+  // Ask the JS work currently running to yield at its next safe point (can be called from any
+  // thread)
+  void requestYield() { m_yieldRequested.store(true, std::memory_order_relaxed); }
+
+  // Drop the pending yield request (if any) when the JS work it was meant for has ended
+  void clearYieldRequest() { m_yieldRequested.store(false, std::memory_order_relaxed); }
+
+  // Return true (only once per request) if the JS work should yield
+  bool consumeYieldRequest() {
+    return m_yieldRequested.load(std::memory_order_relaxed) && m_yieldRequested.exchange(false, std::memory_order_relaxed);
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  long long m_timeoutMs = 0;
+  int m_scopeDepth = 0;
+  Clock::time_point m_deadline;
+  bool m_exceeded = false;
+  JsProfiler *m_profiler = nullptr;
+  std::atomic<bool> m_yieldRequested { false };
+};
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JavaCallBindings.h"
+
+duk_int_t JavaCallBindings::add(JavaMethod *method, jobject javaThis) {
+  duk_int_t magic;
+
+  if (!m_freeMagics.empty()) {
+    magic = m_freeMagics.back();
+    m_freeMagics.pop_back();
+  } else if (m_bindings.size() < static_cast<size_t>(MAX_MAGIC - MIN_MAGIC + 1)) {
+    magic = static_cast<duk_int_t>(m_bindings.size()) + MIN_MAGIC;
+    m_bindings.emplace_back();
+  } else {
+    return NO_MAGIC;
+  }
+
+  Binding &binding = m_bindings[magic - MIN_MAGIC];
+  binding.method = method;
+  binding.javaThis = javaThis;
+  return magic;
+}
+
+void JavaCallBindings::remove(duk_int_t magic) {
+  if (magic == NO_MAGIC) {
+    return;
+  }
+
+  m_bindings[magic - MIN_MAGIC] = Binding();
+  m_freeMagics.push_back(magic);
+}
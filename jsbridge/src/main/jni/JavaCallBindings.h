@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JAVACALLBINDINGS_H
+#define _JSBRIDGE_JAVACALLBINDINGS_H
+
+#include "duktape/duktape.h"
+#include <jni.h>
+#include <vector>
+
+class JavaMethod;
+
+// Duktape only: native side table of the Java methods and lambdas bound to JS functions, indexed
+// by the magic value of the Duktape/C functions so that a JS -> Java call reaches its JavaMethod
+// and its Java "this" without any property lookup (see JavaObject).
+//
+// The magic value is 16-bit signed so the table has a limited number of slots: when it is full,
+// NO_MAGIC is returned and the caller falls back to the hidden properties of the function.
+//
+// Must only be used from the JS thread.
+class JavaCallBindings {
+
+public:
+  static const duk_int_t NO_MAGIC = -32768;
+
+  struct Binding {
+    JavaMethod *method = nullptr;
+    jobject javaThis = nullptr;  // JNI global ref owned by the bound JS object or function
+  };
+
+  JavaCallBindings() = default;
+  JavaCallBindings(const JavaCallBindings &) = delete;
+  JavaCallBindings &operator=(const JavaCallBindings &) = delete;
+
+  // Store the binding and return its magic value (or NO_MAGIC if the table is full)
+  duk_int_t add(JavaMethod *, jobject javaThis);
+
+  const Binding &get(duk_int_t magic) const { return m_bindings[magic - MIN_MAGIC]; }
+
+  // Release the binding with the given magic value (no-op for NO_MAGIC)
+  void remove(duk_int_t magic);
+
+private:
+  static const duk_int_t MIN_MAGIC = -32767;
+  static const duk_int_t MAX_MAGIC = 32767;
+
+  std::vector<Binding> m_bindings;
+  std::vector<duk_int_t> m_freeMagics;
+};
+
+#endif
@@ -18,11 +18,13 @@
  */
 #include "JavaMethod.h"
 
+#include "CallTracer.h"
 #include "ExceptionHandler.h"
 #include "JavaType.h"
 #include "JniCache.h"
 #include "JniTypes.h"
 #include "JsBridgeContext.h"
+#include "TrafficRecorder.h"
 #include "exceptions/JniException.h"
 #include "log.h"
 #include "jni-helpers/JniLocalRef.h"
@@ -34,17 +36,78 @@
 
 JavaMethod::JavaMethod(const JsBridgeContext *jsBridgeContext, const JniLocalRef<jsBridgeMethod> &method, std::string methodName, bool isLambda)
  : m_methodName(std::move(methodName)),
+   m_traceName("JavaMethod " + m_methodName),
    m_isLambda(isLambda) {
 
   const JniContext *jniContext = jsBridgeContext->getJniContext();
+  const JavaTypeProvider &javaTypeProvider = jsBridgeContext->getJavaTypeProvider();
   MethodInterface methodInterface = jsBridgeContext->getJniCache()->getMethodInterface(method);
 
-  m_isVarArgs = methodInterface.isVarArgs();
+  const JavaTypeProvider::MethodSignatures signatures = javaTypeProvider.getMethodSignatures(method);
+  m_isVarArgs = signatures.isVarArgs;
+
+  if (isLambda) {
+    JStringLocalRef unboxedLambdaDescriptor = methodInterface.getUnboxedLambdaDescriptor();
+    if (!unboxedLambdaDescriptor.isNull()) {
+      m_unboxedLambdaDescriptor = unboxedLambdaDescriptor.toStdString();
+    }
+  }
+  const bool hasUnboxedLambda = !m_unboxedLambdaDescriptor.empty();
+
+  // Fast path (no further JNI call): all the types have already been created with the same signatures
+  bool hasSharedTypes = javaTypeProvider.findSharedTypes(signatures.parameterTypes, m_isLambda /*boxed*/, &m_argumentTypes)
+      && (m_returnValueType = javaTypeProvider.findSharedType(signatures.returnType, m_isLambda /*boxed*/)) != nullptr;
+  if (hasSharedTypes && hasUnboxedLambda) {
+    hasSharedTypes = !m_isVarArgs
+        && javaTypeProvider.findSharedTypes(signatures.parameterTypes, false /*boxed*/, &m_unboxedArgumentTypes)
+        && (m_unboxedReturnValueType = javaTypeProvider.findSharedType(signatures.returnType, false /*boxed*/)) != nullptr;
+  }
+
+  if (!hasSharedTypes) {
+    createTypes(jsBridgeContext, methodInterface);
+  }
+
+  createConversions();
+
+  if (isLambda) {
+    m_lambdaMethod = JniGlobalRef<jsBridgeMethod>(method);
+  } else {
+    JniLocalRef<jobject> javaMethod = methodInterface.getJavaMethod();
+    m_methodId = jniContext->fromReflectedMethod(javaMethod);
+  }
+}
+
+void JavaMethod::createConversions() {
+  auto toConversions = [](const std::vector<std::shared_ptr<const JavaType>> &types) {
+    std::vector<JsToJavaConversion> conversions;
+    conversions.reserve(types.size());
+    for (const auto &type : types) {
+      conversions.push_back(type ? type->getJsToJavaConversion() : JsToJavaConversion {});
+    }
+    return conversions;
+  };
+
+  m_argumentConversions = toConversions(m_argumentTypes);
+  m_returnValueConversion = m_returnValueType->getJavaToJsConversion();
+
+  if (m_unboxedReturnValueType) {
+    m_unboxedArgumentConversions = toConversions(m_unboxedArgumentTypes);
+    m_unboxedReturnValueConversion = m_unboxedReturnValueType->getJavaToJsConversion();
+  }
+}
+
+void JavaMethod::createTypes(const JsBridgeContext *jsBridgeContext, const MethodInterface &methodInterface) {
+  const JavaTypeProvider &javaTypeProvider = jsBridgeContext->getJavaTypeProvider();
+
   JObjectArrayLocalRef parameters = methodInterface.getParameters();
   const jsize numParameters = parameters.getLength();
 
+  const bool hasUnboxedLambda = !m_unboxedLambdaDescriptor.empty();
 
   m_argumentTypes.resize((size_t) numParameters);
+  if (hasUnboxedLambda) {
+    m_unboxedArgumentTypes.resize((size_t) numParameters);
+  }
 
   // Create JavaType instances
   for (jsize i = 0; i < numParameters; ++i) {
@@ -53,12 +116,15 @@ JavaMethod::JavaMethod(const JsBridgeContext *jsBridgeContext, const JniLocalRef
     if (m_isVarArgs && i == numParameters - 1) {
       ParameterInterface parameterInterface = jsBridgeContext->getJniCache()->getParameterInterface(parameter);
       JniLocalRef<jsBridgeParameter> varArgParameter = parameterInterface.getGenericParameter();
-      auto javaType = jsBridgeContext->getJavaTypeProvider().makeUniqueType(varArgParameter, m_isLambda /*boxed*/);
+      auto javaType = javaTypeProvider.getType(varArgParameter, m_isLambda /*boxed*/);
       m_argumentTypes[i] = std::move(javaType);
       break;
     }
 
-    m_argumentTypes[i] = jsBridgeContext->getJavaTypeProvider().makeUniqueType(parameter, m_isLambda /*boxed*/);
+    m_argumentTypes[i] = javaTypeProvider.getType(parameter, m_isLambda /*boxed*/);
+    if (hasUnboxedLambda) {
+      m_unboxedArgumentTypes[i] = javaTypeProvider.getType(parameter, false /*boxed*/);
+    }
   }
 
   parameters.release();
@@ -66,34 +132,10 @@ JavaMethod::JavaMethod(const JsBridgeContext *jsBridgeContext, const JniLocalRef
   {
     // Create return value loader
     JniLocalRef<jsBridgeParameter> returnParameter = methodInterface.getReturnParameter();
-    m_returnValueType = jsBridgeContext->getJavaTypeProvider().makeUniqueType(returnParameter, m_isLambda /*boxed*/);
-  }
-
-  jmethodID methodId = nullptr;
-
-  if (isLambda) {
-    auto methodGlobal = JniGlobalRef<jsBridgeMethod>(method);
-
-    m_methodBody = [=](const JniRef<jobject> &javaThis, const std::vector<JValue> &args) {
-      JValue result = callLambda(jsBridgeContext, methodGlobal, javaThis, args);
-#if defined(DUKTAPE)
-      return m_returnValueType->push(result);
-#elif defined(QUICKJS)
-      return m_returnValueType->fromJava(result);
-#endif
-    };
-  } else {
-    JniLocalRef<jobject> javaMethod = methodInterface.getJavaMethod();
-    methodId = jniContext->fromReflectedMethod(javaMethod);
-
-    m_methodBody = [methodId, this](const JniRef<jobject> &javaThis, const std::vector<JValue> &args) {
-      JValue result = m_returnValueType->callMethod(methodId, javaThis, args);
-#if defined(DUKTAPE)
-      return m_returnValueType->push(result);
-#elif defined(QUICKJS)
-      return m_returnValueType->fromJava(result);
-#endif
-    };
+    m_returnValueType = javaTypeProvider.getType(returnParameter, m_isLambda /*boxed*/);
+    if (hasUnboxedLambda) {
+      m_unboxedReturnValueType = javaTypeProvider.getType(returnParameter, false /*boxed*/);
+    }
   }
 }
 
@@ -119,35 +161,51 @@ duk_ret_t JavaMethod::invoke(const JsBridgeContext *jsBridgeContext, const JniRe
     throw std::invalid_argument(std::string() + "Too many parameters when calling Java method " + m_methodName + " (expected: " + std::to_string(minArgs) + ", received: " + std::to_string(argCount) + ")");
   }
 
-  std::vector<JValue> args(m_argumentTypes.size());
+  // Lambdas are called via their specialized "invoke" method (if available) to skip boxing, unless
+  // missing parameters need to be set to null
+  const jmethodID unboxedLambdaMethodId = argCount >= minArgs ? getUnboxedLambdaMethodId(jsBridgeContext, javaThis) : nullptr;
+  const auto &argumentTypes = unboxedLambdaMethodId != nullptr ? m_unboxedArgumentTypes : m_argumentTypes;
+  const auto &argumentConversions = unboxedLambdaMethodId != nullptr ? m_unboxedArgumentConversions : m_argumentConversions;
+  const auto &returnValueConversion = unboxedLambdaMethodId != nullptr ? m_unboxedReturnValueConversion : m_returnValueConversion;
+
+  CallTrace callTrace(jsBridgeContext->getCallTracer(), m_traceName.c_str());
+  RecordedCall recordedCall(jsBridgeContext->getTrafficRecorder(), TrafficRecorder::CallType::JavaMethod, m_methodName.c_str());
+  if (recordedCall.isSampled()) {
+    for (duk_idx_t i = 0; i < argCount; ++i) {
+      recordedCall.addArgument(TrafficRecorder::describeJsValue(jsBridgeContext, i));
+    }
+  }
+  callTrace.beginPhase(CallTracer::Phase::Conversion);
+
+  JValueArgs args(m_argumentTypes.size());
 
   // Load the arguments off the stack and convert to Java types.
   // Note we're going backwards since the last argument is at the top of the stack.
   if (m_isVarArgs) {
-    const auto &argumentType = m_argumentTypes.back();
+    const auto &argumentType = argumentTypes.back();
     args[args.size() - 1] = argumentType->popArray(argCount - minArgs, true /*expanded*/);
   }
   for (ssize_t i = minArgs - 1; i >= 0; --i) {
-    const auto &argumentType = m_argumentTypes[i];
     JValue value;
     if (i >= argCount) {
       // Parameter not given by JS: set it to null
       // Note: we do not explicitly check if the parameter is nullable so the execution might throw!
     } else {
-      value = argumentType->pop();
+      value = argumentConversions[i].pop();
     }
     args[i] = std::move(value);
   }
 
-  return m_methodBody(javaThis, args);
+  callTrace.beginPhase(CallTracer::Phase::JniUpcall);
+  JValue result = callJava(jsBridgeContext, javaThis, args, unboxedLambdaMethodId);
+
+  callTrace.beginPhase(CallTracer::Phase::Conversion);
+  return returnValueConversion.push(result);
 }
 
 #elif defined(QUICKJS)
 
 JSValue JavaMethod::invoke(const JsBridgeContext *jsBridgeContext, const JniRef<jobject> &javaThis, int argc, JSValueConst *argv) const {
-
-  JSContext *ctx = jsBridgeContext->getQuickJsContext();
-
   const int minArgs = m_isVarArgs
       ? m_argumentTypes.size() - 1
       : m_argumentTypes.size();
@@ -162,41 +220,89 @@ JSValue JavaMethod::invoke(const JsBridgeContext *jsBridgeContext, const JniRef<
     throw std::invalid_argument(std::string() + "Too many parameters when calling Java method " + m_methodName + " (expected: " + std::to_string(minArgs) + ", received: " + std::to_string(argc) + ")");
   }
 
-  std::vector<JValue> args(m_argumentTypes.size());
+  // Lambdas are called via their specialized "invoke" method (if available) to skip boxing, unless
+  // missing parameters need to be set to null
+  const jmethodID unboxedLambdaMethodId = argc >= minArgs ? getUnboxedLambdaMethodId(jsBridgeContext, javaThis) : nullptr;
+  const auto &argumentTypes = unboxedLambdaMethodId != nullptr ? m_unboxedArgumentTypes : m_argumentTypes;
+  const auto &argumentConversions = unboxedLambdaMethodId != nullptr ? m_unboxedArgumentConversions : m_argumentConversions;
+  const auto &returnValueConversion = unboxedLambdaMethodId != nullptr ? m_unboxedReturnValueConversion : m_returnValueConversion;
+
+  CallTrace callTrace(jsBridgeContext->getCallTracer(), m_traceName.c_str());
+  RecordedCall recordedCall(jsBridgeContext->getTrafficRecorder(), TrafficRecorder::CallType::JavaMethod, m_methodName.c_str());
+  if (recordedCall.isSampled()) {
+    for (int i = 0; i < argc; ++i) {
+      recordedCall.addArgument(TrafficRecorder::describeJsValue(jsBridgeContext, argv[i]));
+    }
+  }
+  callTrace.beginPhase(CallTracer::Phase::Conversion);
+
+  JValueArgs args(m_argumentTypes.size());
 
   // Load arguments and convert to Java types
   for (int i = 0; i < minArgs; ++i) {
-    const auto &argumentType = m_argumentTypes[i];
     JValue value;
     if (i >= argc) {
       // Parameter not given by JS: set it to null
       // Note: we do not explicitly check if the parameter is nullable so the execution might throw!
     } else {
-      value = argumentType->toJava(argv[i]);
+      value = argumentConversions[i].toJava(argv[i]);
     }
     args[i] = std::move(value);
   }
 
   if (m_isVarArgs) {
-    // Move the varargs into a JS array before converting it to a Java array
-    const auto &argumentType = m_argumentTypes.back();
-    int varArgCount = argc - minArgs;
-    JSValue varArgArray = JS_NewArray(ctx);
-    for (int i = 0; i < varArgCount; ++i) {
-      JS_SetPropertyUint32(ctx, varArgArray, static_cast<uint32_t>(i), JS_DupValue(ctx, argv[minArgs + i]));
-    }
-    args[args.size() - 1] = argumentType->toJavaArray(varArgArray);
-    JS_FreeValue(ctx, varArgArray);
+    // Directly convert the remaining arguments to a Java array
+    const auto &argumentType = argumentTypes.back();
+    const int varArgCount = argc > minArgs ? argc - minArgs : 0;
+    args[args.size() - 1] = argumentType->toJavaArray(static_cast<uint32_t>(varArgCount), argv + minArgs);
   }
 
+  callTrace.beginPhase(CallTracer::Phase::JniUpcall);
+  JValue result = callJava(jsBridgeContext, javaThis, args, unboxedLambdaMethodId);
 
-  return m_methodBody(javaThis, args);
+  callTrace.beginPhase(CallTracer::Phase::Conversion);
+  return returnValueConversion.fromJava(result);
 }
 
 #endif
 
+JValue JavaMethod::callJava(const JsBridgeContext *jsBridgeContext, const JniRef<jobject> &javaThis, const JValueArgs &args,
+                            jmethodID unboxedLambdaMethodId) const {
+  if (unboxedLambdaMethodId != nullptr) {
+    return m_unboxedReturnValueType->callMethod(unboxedLambdaMethodId, javaThis, args);
+  }
+
+  if (m_isLambda) {
+    return callLambda(jsBridgeContext, m_lambdaMethod, javaThis, args);
+  }
+
+  return m_returnValueType->callMethod(m_methodId, javaThis, args);
+}
+
+jmethodID JavaMethod::getUnboxedLambdaMethodId(const JsBridgeContext *jsBridgeContext, const JniRef<jobject> &javaThis) const {
+  if (m_unboxedLambdaDescriptor.empty() || javaThis.isNull()) {
+    return nullptr;
+  }
+
+  const JniContext *jniContext = jsBridgeContext->getJniContext();
+  JniLocalRef<jclass> lambdaClass = jniContext->getObjectClass(javaThis);
+  if (!m_unboxedLambdaClass.isNull() && jniContext->isSameObject(lambdaClass, m_unboxedLambdaClass)) {
+    return m_unboxedLambdaMethodId;
+  }
+
+  // Not all lambda classes have a specialized method (e.g. lambdas compiled via invokedynamic or
+  // implemented in Java) => fall back to the generic "invoke" method
+  m_unboxedLambdaMethodId = jniContext->getMethodID(lambdaClass, "invoke", m_unboxedLambdaDescriptor.c_str());
+  if (m_unboxedLambdaMethodId == nullptr) {
+    jniContext->exceptionClear();  // NoSuchMethodError
+  }
+  m_unboxedLambdaClass = JniGlobalRef<jclass>(lambdaClass);
+
+  return m_unboxedLambdaMethodId;
+}
+
 // static
-JValue JavaMethod::callLambda(const JsBridgeContext *jsBridgeContext, const JniRef<jsBridgeMethod> &method, const JniRef<jobject> &javaThis, const std::vector<JValue> &args) {
+JValue JavaMethod::callLambda(const JsBridgeContext *jsBridgeContext, const JniRef<jsBridgeMethod> &method, const JniRef<jobject> &javaThis, const JValueArgs &args) {
   const JniContext *jniContext = jsBridgeContext->getJniContext();
   assert(jniContext != nullptr);
 
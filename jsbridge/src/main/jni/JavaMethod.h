@@ -19,11 +19,13 @@
 #ifndef _JSBRIDGE_JAVAMETHOD_H
 #define _JSBRIDGE_JAVAMETHOD_H
 
+#include "JavaType.h"
 #include "JniTypes.h"
 #include "jni-helpers/JValue.h"
+#include "jni-helpers/JValueArgs.h"
+#include "jni-helpers/JniGlobalRef.h"
 #include "jni-helpers/JniLocalRef.h"
 #include <jni.h>
-#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -34,8 +36,8 @@
 # include "quickjs/quickjs.h"
 #endif
 
-class JavaType;
 class JsBridgeContext;
+class MethodInterface;
 
 class JavaMethod {
 public:
@@ -49,19 +51,40 @@ public:
 #endif
 
 private:
-  static JValue callLambda(const JsBridgeContext *, const JniRef<jsBridgeMethod> &, const JniRef<jobject> &javaThis, const std::vector<JValue> &args);
+  // Create the types via the (reflected) Parameter instances
+  void createTypes(const JsBridgeContext *, const MethodInterface &);
+  // Create the compact signatures from the types
+  void createConversions();
+  JValue callJava(const JsBridgeContext *, const JniRef<jobject> &javaThis, const JValueArgs &args,
+                  jmethodID unboxedLambdaMethodId) const;
+  jmethodID getUnboxedLambdaMethodId(const JsBridgeContext *, const JniRef<jobject> &javaThis) const;
+  static JValue callLambda(const JsBridgeContext *, const JniRef<jsBridgeMethod> &, const JniRef<jobject> &javaThis, const JValueArgs &args);
 
   std::string m_methodName;
+  std::string m_traceName;  // see CallTracer
   bool m_isLambda;
-  std::vector<std::unique_ptr<const JavaType>> m_argumentTypes;
+  std::vector<std::shared_ptr<const JavaType>> m_argumentTypes;
   bool m_isVarArgs;
-  std::unique_ptr<const JavaType> m_returnValueType;
+  std::shared_ptr<const JavaType> m_returnValueType;
 
-#if defined(DUKTAPE)
-  std::function<duk_ret_t(const JniRef<jobject> &javaThis, const std::vector<JValue> &args)> m_methodBody;
-#elif defined(QUICKJS)
-  std::function<JSValue(const JniRef<jobject> &javaThis, const std::vector<JValue> &args)> m_methodBody;
-#endif
+  // Called method: either the lambda method or the ID of the (non-lambda) Java method
+  JniGlobalRef<jsBridgeMethod> m_lambdaMethod;
+  jmethodID m_methodId = nullptr;
+
+  // Specialized "invoke" method of lambda classes called without boxing (if available), cached for
+  // the last lambda class
+  std::string m_unboxedLambdaDescriptor;
+  std::vector<std::shared_ptr<const JavaType>> m_unboxedArgumentTypes;
+  std::shared_ptr<const JavaType> m_unboxedReturnValueType;
+  mutable JniGlobalRef<jclass> m_unboxedLambdaClass;
+  mutable jmethodID m_unboxedLambdaMethodId = nullptr;
+
+  // Compact signatures of the (boxed and unboxed) types above, read on each call instead of the
+  // JavaType instances (see JsToJavaConversion)
+  std::vector<JsToJavaConversion> m_argumentConversions;
+  JavaToJsConversion m_returnValueConversion {};
+  std::vector<JsToJavaConversion> m_unboxedArgumentConversions;
+  JavaToJsConversion m_unboxedReturnValueConversion {};
 };
 
 #endif
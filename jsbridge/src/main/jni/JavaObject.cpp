@@ -25,9 +25,14 @@
 #include "exceptions/JniException.h"
 #include "JsBridgeContext.h"
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #if defined(DUKTAPE)
 # include "JniCache.h"
 # include "DuktapeUtils.h"
+# include "JavaCallBindings.h"
 # include "StackChecker.h"
 #elif defined(QUICKJS)
 # include "AutoReleasedJSValue.h"
@@ -35,12 +40,45 @@
 #endif
 
 namespace {
-  const char *JAVA_THIS_PROP_NAME = "\xff\xffjava_this";
-  const char *JAVA_METHOD_PROP_NAME = "\xff\xffjava_method";
+  // Methods of a Java object registered with lazy methods: the JavaMethod instance and the JS
+  // function of a method are only created when the method is accessed for the first time
+  struct LazyJavaMethods {
+    JniGlobalRef<jobjectArray> methods;
+    std::string qualifiedMethodPrefix;
+  };
+
+  std::unique_ptr<JavaMethod> createJavaMethod(const JsBridgeContext *jsBridgeContext, const JniLocalRef<jsBridgeMethod> &method,
+                                               const std::string &qualifiedMethodName) {
+    try {
+      return std::make_unique<JavaMethod>(jsBridgeContext, method, qualifiedMethodName, false /*isLambda*/);
+    } catch (const std::exception &e) {
+      throw std::invalid_argument(std::string() + "In bound method \"" + qualifiedMethodName + "\": " + e.what());
+    }
+  }
 }
 
 #if defined(DUKTAPE)
 
+namespace {
+  // (QuickJS uses the atoms interned by QuickJsUtils)
+  const char JAVA_THIS_PROP_NAME[] = "\xff\xffjava_this";
+  const char JAVA_METHOD_PROP_NAME[] = "\xff\xffjava_method";
+  const char JAVA_LAZY_METHODS_PROP_NAME[] = "\xff\xffjava_lazy_methods";
+  const char JAVA_LIGHT_METHODS_PROP_NAME[] = "\xff\xffjava_light_methods";
+
+  // Methods of a Java object registered with light methods: each method is a Duktape lightfunc
+  // (a tagged value without any heap object) whose magic value and handler "page" give the
+  // method index in this table, which is owned by the bound object
+  struct LightJavaMethods {
+    std::vector<std::unique_ptr<JavaMethod>> methods;
+  };
+
+  // The magic value of a lightfunc is 8-bit signed so each handler page covers 256 methods (the
+  // additional methods are bound to full functions)
+  const int LIGHTFUNC_MAGIC_COUNT = 256;
+  const int LIGHTFUNC_PAGE_COUNT = 4;
+}
+
 namespace {
   // Called by Duktape when JS invokes a method on our bound Java object
   extern "C"
@@ -54,39 +92,99 @@ namespace {
     JNIEnv *env = jniContext->getJNIEnv();
     assert(env != nullptr);
 
-    // Get JavaMethod instance bound to the function itself
-    duk_push_current_function(ctx);
-    duk_get_prop_string(ctx, -1, JAVA_METHOD_PROP_NAME);
-    if (duk_is_null_or_undefined(ctx, -1)) {
-      duk_error(ctx, DUK_ERR_TYPE_ERROR, "Cannot execute Java method: Java method not found!");
-      duk_pop_2(ctx);
-      return DUK_RET_ERROR;
+    JavaMethod *method;
+    jobject thisObjectRaw;
+
+    const duk_int_t magic = duk_get_current_magic(ctx);
+    if (magic != JavaCallBindings::NO_MAGIC) {
+      // JavaMethod instance and Java this of the bound object from the side table
+      const JavaCallBindings::Binding &binding = jsBridgeContext->getJavaCallBindings()->get(magic);
+      method = binding.method;
+      thisObjectRaw = binding.javaThis;
+    } else {
+      // Get JavaMethod instance bound to the function itself
+      duk_push_current_function(ctx);
+      duk_get_prop_literal(ctx, -1, JAVA_METHOD_PROP_NAME);
+      if (duk_is_null_or_undefined(ctx, -1)) {
+        duk_error(ctx, DUK_ERR_TYPE_ERROR, "Cannot execute Java method: Java method not found!");
+        duk_pop_2(ctx);
+        return DUK_RET_ERROR;
+      }
+      method = static_cast<JavaMethod *>(duk_require_pointer(ctx, -1));
+      duk_pop_2(ctx);  // Java method + current function
+
+      // JS this -> Java this
+      duk_push_this(ctx);
+      duk_get_prop_literal(ctx, -1, JAVA_THIS_PROP_NAME);
+      if (duk_is_null_or_undefined(ctx, -1)) {
+        duk_error(ctx, DUK_ERR_TYPE_ERROR, "Cannot execute Java method: Java object not found!");
+        duk_pop_2(ctx);
+        return DUK_RET_ERROR;
+      }
+      thisObjectRaw = reinterpret_cast<jobject>(duk_require_pointer(ctx, -1));
+      duk_pop_2(ctx);  // Java this + JS this
+    }
+
+    JniLocalRef<jobject> thisObject(jniContext, env->NewLocalRef(thisObjectRaw));
+
+    CHECK_STACK_NOW();
+
+    try {
+      return method->invoke(jsBridgeContext, thisObject);
+    } catch (const std::exception &e) {
+      jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return DUK_RET_TYPE_ERROR;  // unreached
     }
-    auto method = static_cast<JavaMethod *>(duk_require_pointer(ctx, -1));
-    duk_pop_2(ctx);  // Java method + current function
+  }
+
+  // Called by Duktape when JS invokes a light method on our bound Java object: the lightfunc has
+  // no properties so the JavaMethod instance and the Java this are read from the JS this
+  template <int Page>
+  duk_ret_t javaLightMethodHandler(duk_context *ctx) {
+    CHECK_STACK(ctx);
+
+    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    assert(jsBridgeContext != nullptr);
+
+    JniContext *jniContext = jsBridgeContext->getJniContext();
+    JNIEnv *env = jniContext->getJNIEnv();
+    assert(env != nullptr);
+
+    const size_t methodIndex = Page * LIGHTFUNC_MAGIC_COUNT + (duk_get_current_magic(ctx) + LIGHTFUNC_MAGIC_COUNT / 2);
 
-    // JS this -> Java this
     duk_push_this(ctx);
-    duk_get_prop_string(ctx, -1, JAVA_THIS_PROP_NAME);
-    if (duk_is_null_or_undefined(ctx, -1)) {
-      duk_error(ctx, DUK_ERR_TYPE_ERROR, "Cannot execute Java method: Java object not found!");
-      duk_pop_2(ctx);
+    LightJavaMethods *lightMethods = nullptr;
+    jobject thisObjectRaw = nullptr;
+    if (duk_is_object(ctx, -1)) {
+      duk_get_prop_literal(ctx, -1, JAVA_LIGHT_METHODS_PROP_NAME);
+      lightMethods = static_cast<LightJavaMethods *>(duk_get_pointer(ctx, -1));
+      duk_get_prop_literal(ctx, -2, JAVA_THIS_PROP_NAME);
+      thisObjectRaw = static_cast<jobject>(duk_get_pointer(ctx, -1));
+      duk_pop_2(ctx);  // Java this + light methods
+    }
+    duk_pop(ctx);  // JS this
+
+    if (lightMethods == nullptr || thisObjectRaw == nullptr || methodIndex >= lightMethods->methods.size()) {
+      duk_error(ctx, DUK_ERR_TYPE_ERROR, "Cannot execute Java method: Java object not found (light methods must be called on their object)!");
       return DUK_RET_ERROR;
     }
-    auto thisObjectRaw = reinterpret_cast<jobject>(duk_require_pointer(ctx, -1));
-    JniLocalRef <jobject> thisObject(jniContext, env->NewLocalRef(thisObjectRaw));
-    duk_pop_2(ctx);
+
+    JniLocalRef<jobject> thisObject(jniContext, env->NewLocalRef(thisObjectRaw));
 
     CHECK_STACK_NOW();
 
     try {
-      return method->invoke(jsBridgeContext, thisObject);
+      return lightMethods->methods[methodIndex]->invoke(jsBridgeContext, thisObject);
     } catch (const std::exception &e) {
       jsBridgeContext->getExceptionHandler()->jsThrow(e);
       return DUK_RET_TYPE_ERROR;  // unreached
     }
   }
 
+  const duk_c_function javaLightMethodHandlers[LIGHTFUNC_PAGE_COUNT] = {
+    javaLightMethodHandler<0>, javaLightMethodHandler<1>, javaLightMethodHandler<2>, javaLightMethodHandler<3>
+  };
+
   // Called by Duktape to handle finalization of bound Java objects
   extern "C"
   duk_ret_t javaObjectFinalizer(duk_context *ctx) {
@@ -96,23 +194,47 @@ namespace {
     assert(duktapeContext != nullptr);
 
     JniContext *jniContext = duktapeContext->getJniContext();
+    JavaCallBindings *javaCallBindings = duktapeContext->getJavaCallBindings();
 
-    if (duk_get_prop_string(ctx, -1, JAVA_THIS_PROP_NAME)) {
+    if (duk_get_prop_literal(ctx, -1, JAVA_THIS_PROP_NAME)) {
       // Remove the global reference from the bound Java object
       JniGlobalRef<jobject>::deleteRawGlobalRef(jniContext, static_cast<jobject>(duk_require_pointer(ctx, -1)));
       duk_pop(ctx);
-      duk_del_prop_string(ctx, -1, JAVA_METHOD_PROP_NAME);
+      duk_del_prop_literal(ctx, -1, JAVA_METHOD_PROP_NAME);
+    }
+
+    if (duk_get_prop_literal(ctx, -1, JAVA_LAZY_METHODS_PROP_NAME)) {
+      delete static_cast<LazyJavaMethods *>(duk_require_pointer(ctx, -1));
+    }
+    duk_pop(ctx);
+
+    if (duk_get_prop_literal(ctx, -1, JAVA_LIGHT_METHODS_PROP_NAME)) {
+      auto lightMethods = static_cast<LightJavaMethods *>(duk_require_pointer(ctx, -1));
+      const bool hasFunctionMethods = lightMethods->methods.size() == LIGHTFUNC_PAGE_COUNT * LIGHTFUNC_MAGIC_COUNT;
+      delete lightMethods;
+      duk_pop(ctx);
+
+      // No need to enumerate the properties when all the methods are lightfuncs
+      if (!hasFunctionMethods) {
+        return 0;
+      }
+    } else {
+      duk_pop(ctx);
     }
 
     // Iterate over all of the properties, deleting all the JavaMethod objects we attached.
+    // Note: the values are read from the property descriptors so that the getters of lazy methods
+    // which have not been accessed are not triggered.
     duk_enum(ctx, -1, DUK_ENUM_OWN_PROPERTIES_ONLY);
-    while (duk_next(ctx, -1, (duk_bool_t) true)) {
-      if (!duk_get_prop_string(ctx, -1, JAVA_METHOD_PROP_NAME)) {
-        duk_pop_2(ctx);
-        continue;
+    const duk_idx_t enumIndex = duk_get_top_index(ctx);
+    while (duk_next(ctx, enumIndex, (duk_bool_t) false)) {
+      duk_get_prop_desc(ctx, enumIndex - 1, 0);
+      duk_get_prop_literal(ctx, -1, "value");
+      if (duk_is_function(ctx, -1) && duk_get_prop_literal(ctx, -1, JAVA_METHOD_PROP_NAME)) {
+        javaCallBindings->remove(duk_get_magic(ctx, -2));
+        delete static_cast<JavaMethod *>(duk_require_pointer(ctx, -1));
       }
-      delete static_cast<JavaMethod *>(duk_require_pointer(ctx, -1));
-      duk_pop_3(ctx);
+      duk_set_top(ctx, enumIndex + 1);
     }
 
     // Pop the enum
@@ -120,6 +242,72 @@ namespace {
     return 0;
   }
 
+  // Push the JS function calling the given (bound) Java method
+  void pushJavaMethodFunction(const JsBridgeContext *jsBridgeContext, std::unique_ptr<JavaMethod> javaMethod, jobject javaThis) {
+    duk_context *ctx = jsBridgeContext->getDuktapeContext();
+
+    // Use VARARGS here to allow us to manually validate that the proper number of arguments are
+    // given in the call. If we specify the actual number of arguments needed, Duktape will try to
+    // be helpful by discarding extra or providing missing arguments. That's not quite what we want.
+    // See http://duktape.org/api.html#duk_push_c_function for details.
+    const duk_idx_t func = duk_push_c_function(ctx, javaMethodHandler, DUK_VARARGS);
+    duk_set_magic(ctx, func, jsBridgeContext->getJavaCallBindings()->add(javaMethod.get(), javaThis));
+    duk_push_pointer(ctx, javaMethod.release());
+    duk_put_prop_literal(ctx, func, JAVA_METHOD_PROP_NAME);
+  }
+
+  // Called by Duktape when JS accesses a lazy method of a bound Java object for the first time:
+  // bind the Java method (given by the magic index) and replace the getter with its function
+  extern "C"
+  duk_ret_t lazyJavaMethodGetter(duk_context *ctx) {
+    CHECK_STACK_OFFSET(ctx, 1);
+
+    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    assert(jsBridgeContext != nullptr);
+
+    const JniContext *jniContext = jsBridgeContext->getJniContext();
+    const duk_int_t methodIndex = duk_get_current_magic(ctx);
+
+    duk_push_this(ctx);
+    const duk_idx_t objIndex = duk_get_top_index(ctx);
+
+    duk_get_prop_literal(ctx, objIndex, JAVA_LAZY_METHODS_PROP_NAME);
+    auto lazyMethods = static_cast<LazyJavaMethods *>(duk_get_pointer(ctx, -1));
+    duk_get_prop_literal(ctx, objIndex, JAVA_THIS_PROP_NAME);
+    auto javaThis = static_cast<jobject>(duk_get_pointer(ctx, -1));
+    duk_pop_2(ctx);  // Java this + lazy methods
+
+    if (lazyMethods == nullptr || javaThis == nullptr) {
+      duk_error(ctx, DUK_ERR_TYPE_ERROR, "Cannot bind Java method: Java object not found!");
+      duk_pop(ctx);
+      return DUK_RET_ERROR;
+    }
+
+    JObjectArrayLocalRef methods(jniContext, lazyMethods->methods.get(), JniLocalRefMode::Borrowed);
+    JniLocalRef<jsBridgeMethod> method = methods.getElement<jsBridgeMethod>(methodIndex);
+    std::string strMethodName = jsBridgeContext->getJniCache()->getMethodInterface(method).getName().toStdString();
+
+    std::unique_ptr<JavaMethod> javaMethod;
+    try {
+      javaMethod = createJavaMethod(jsBridgeContext, method, lazyMethods->qualifiedMethodPrefix + strMethodName);
+    } catch (const std::exception &e) {
+      duk_pop(ctx);  // this
+      CHECK_STACK_NOW();
+      jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return DUK_RET_TYPE_ERROR;  // unreached
+    }
+
+    pushJavaMethodFunction(jsBridgeContext, std::move(javaMethod), javaThis);
+
+    // Replace the getter with the function
+    duk_push_string(ctx, strMethodName.c_str());
+    duk_dup(ctx, -2);
+    duk_def_prop(ctx, objIndex, DUK_DEFPROP_HAVE_VALUE | DUK_DEFPROP_SET_WEC);
+
+    duk_remove(ctx, objIndex);  // this
+    return 1;
+  }
+
   // Called by Duktape when JS invokes a bound Java function
   extern "C"
   duk_ret_t javaLambdaHandler(duk_context *ctx) {
@@ -132,18 +320,30 @@ namespace {
     JNIEnv *env = jniContext->getJNIEnv();
     assert(env != nullptr);
 
-    duk_push_current_function(ctx);
+    JavaMethod *method;
+    jobject thisObjectRaw;
 
-    // Get JavaMethod instance bound to the function itself
-    duk_get_prop_string(ctx, -1, JAVA_METHOD_PROP_NAME);
-    auto method = static_cast<JavaMethod *>(duk_require_pointer(ctx, -1));
-    duk_pop(ctx);  // Java method
+    const duk_int_t magic = duk_get_current_magic(ctx);
+    if (magic != JavaCallBindings::NO_MAGIC) {
+      // JavaMethod instance and Java this from the side table
+      const JavaCallBindings::Binding &binding = jsBridgeContext->getJavaCallBindings()->get(magic);
+      method = binding.method;
+      thisObjectRaw = binding.javaThis;
+    } else {
+      duk_push_current_function(ctx);
+
+      // Get JavaMethod instance bound to the function itself
+      duk_get_prop_literal(ctx, -1, JAVA_METHOD_PROP_NAME);
+      method = static_cast<JavaMethod *>(duk_require_pointer(ctx, -1));
+      duk_pop(ctx);  // Java method
+
+      // Java this is a property of the JS method
+      duk_get_prop_literal(ctx, -1, JAVA_THIS_PROP_NAME);
+      thisObjectRaw = reinterpret_cast<jobject>(duk_require_pointer(ctx, -1));
+      duk_pop_2(ctx);  // Java this + current function
+    }
 
-    // Java this is a property of the JS method
-    duk_get_prop_string(ctx, -1, JAVA_THIS_PROP_NAME);
-    auto thisObjectRaw = reinterpret_cast<jobject>(duk_require_pointer(ctx, -1));
     JniLocalRef<jobject> thisObject(jniContext, env->NewLocalRef(thisObjectRaw));
-    duk_pop_2(ctx);  // Java this + current function
 
     CHECK_STACK_NOW();
     try {
@@ -164,12 +364,14 @@ namespace {
 
     JniContext *jniContext = duktapeContext->getJniContext();
 
-    if (duk_get_prop_string(ctx, -1, JAVA_THIS_PROP_NAME)) {
+    duktapeContext->getJavaCallBindings()->remove(duk_get_magic(ctx, -1));
+
+    if (duk_get_prop_literal(ctx, -1, JAVA_THIS_PROP_NAME)) {
       JniGlobalRef<jobject>::deleteRawGlobalRef(jniContext, static_cast<jobject>(duk_require_pointer(ctx, -1)));
       duk_pop(ctx);
     }
 
-    if (duk_get_prop_string(ctx, -1, JAVA_METHOD_PROP_NAME)) {
+    if (duk_get_prop_literal(ctx, -1, JAVA_METHOD_PROP_NAME)) {
       delete static_cast<JavaMethod *>(duk_require_pointer(ctx, -1));
       duk_pop(ctx);
     }
@@ -180,13 +382,12 @@ namespace {
 
 // static
 duk_ret_t JavaObject::push(const JsBridgeContext *jsBridgeContext, const std::string &strName, const JniLocalRef<jobject> &object) {
-  return push(jsBridgeContext, strName, object, JObjectArrayLocalRef());
+  return push(jsBridgeContext, strName, object, JObjectArrayLocalRef(), false /*lazyMethods*/);
 }
 
 // static
-duk_ret_t JavaObject::push(const JsBridgeContext *jsBridgeContext, const std::string &strName, const JniLocalRef<jobject> &object, const JObjectArrayLocalRef &methods) {
+duk_ret_t JavaObject::push(const JsBridgeContext *jsBridgeContext, const std::string &strName, const JniLocalRef<jobject> &object, const JObjectArrayLocalRef &methods, bool lazyMethods) {
   duk_context *ctx = jsBridgeContext->getDuktapeContext();
-  const JniContext *jniContext = jsBridgeContext->getJniContext();
 
   CHECK_STACK_OFFSET(ctx, 1);
 
@@ -196,48 +397,71 @@ duk_ret_t JavaObject::push(const JsBridgeContext *jsBridgeContext, const std::st
   duk_push_c_function(ctx, javaObjectFinalizer, 1);
   duk_set_finalizer(ctx, objIndex);
 
+  // Keep a reference in JavaScript to the object being bound.
+  jobject javaThis = JniGlobalRef(object, JniGlobalRefMode::Leaked).get();  // JNI global ref will be deleted via JS finalizer
+  duk_push_pointer(ctx, javaThis);
+  duk_put_prop_literal(ctx, objIndex, JAVA_THIS_PROP_NAME);
+
   const jsize numMethods = methods.isNull() ? 0 : methods.getLength();
   std::string qualifiedMethodPrefix = strName + "::";
 
+  if (lazyMethods && numMethods > 0) {
+    // Only define a getter for each method (its magic being the method index)
+    duk_push_pointer(ctx, new LazyJavaMethods { JniGlobalRef<jobjectArray>(methods), qualifiedMethodPrefix });  // deleted via JS finalizer
+    duk_put_prop_literal(ctx, objIndex, JAVA_LAZY_METHODS_PROP_NAME);
+
+    for (jsize i = 0; i < numMethods; ++i) {
+      JniLocalRef<jsBridgeMethod> method = methods.getElement<jsBridgeMethod>(i);
+      std::string strMethodName = jsBridgeContext->getJniCache()->getMethodInterface(method).getName().toStdString();
+
+      duk_push_string(ctx, strMethodName.c_str());
+      duk_push_c_function(ctx, lazyJavaMethodGetter, 0);
+      duk_set_magic(ctx, -1, i);
+      duk_def_prop(ctx, objIndex, DUK_DEFPROP_HAVE_GETTER | DUK_DEFPROP_SET_ENUMERABLE | DUK_DEFPROP_SET_CONFIGURABLE);
+    }
+
+    return 1;
+  }
+
+  LightJavaMethods *lightMethods = nullptr;
+  if (jsBridgeContext->areLightJavaMethodsEnabled() && numMethods > 0) {
+    lightMethods = new LightJavaMethods();  // deleted via JS finalizer
+    lightMethods->methods.reserve(std::min<size_t>(numMethods, LIGHTFUNC_PAGE_COUNT * LIGHTFUNC_MAGIC_COUNT));
+    duk_push_pointer(ctx, lightMethods);
+    duk_put_prop_literal(ctx, objIndex, JAVA_LIGHT_METHODS_PROP_NAME);
+  }
+
   for (jsize i = 0; i < numMethods; ++i) {
     JniLocalRef<jsBridgeMethod> method = methods.getElement<jsBridgeMethod>(i);
     MethodInterface methodInterface = jsBridgeContext->getJniCache()->getMethodInterface(method);
 
     std::string strMethodName = methodInterface.getName().toStdString();
-    std::string qualifiedMethodName = qualifiedMethodPrefix + strMethodName;
 
     std::unique_ptr<JavaMethod> javaMethod;
     try {
-      javaMethod = std::make_unique<JavaMethod>(jsBridgeContext, method, qualifiedMethodName, false /*isLambda*/);
-    } catch (const std::invalid_argument &e) {
-      // Remove finalizer
-      duk_push_undefined(ctx);
-      duk_set_finalizer(ctx, objIndex);
+      javaMethod = createJavaMethod(jsBridgeContext, method, qualifiedMethodPrefix + strMethodName);
+    } catch (const std::invalid_argument &) {
+      // (the finalizer releases the Java this and the methods which have already been bound)
       CHECK_STACK_NOW();
       duk_pop(ctx);  // object being bound
-
-      throw std::invalid_argument(std::string() + "In bound method \"" + qualifiedMethodName + "\": " + e.what());
+      throw;
     }
 
-    // Use VARARGS here to allow us to manually validate that the proper number of arguments are
-    // given in the call. If we specify the actual number of arguments needed, Duktape will try to
-    // be helpful by discarding extra or providing missing arguments. That's not quite what we want.
-    // See http://duktape.org/api.html#duk_push_c_function for details.
-    const duk_idx_t func = duk_push_c_function(ctx, javaMethodHandler, DUK_VARARGS);
-    duk_push_pointer(ctx, javaMethod.release());
-    duk_put_prop_string(ctx, func, JAVA_METHOD_PROP_NAME);
+    const size_t lightMethodIndex = lightMethods == nullptr ? 0 : lightMethods->methods.size();
+    if (lightMethods != nullptr && lightMethodIndex < LIGHTFUNC_PAGE_COUNT * LIGHTFUNC_MAGIC_COUNT) {
+      // See http://duktape.org/api.html#duk_push_c_lightfunc (the length is limited to 15)
+      const int page = static_cast<int>(lightMethodIndex / LIGHTFUNC_MAGIC_COUNT);
+      const int magic = static_cast<int>(lightMethodIndex % LIGHTFUNC_MAGIC_COUNT) - LIGHTFUNC_MAGIC_COUNT / 2;
+      duk_push_c_lightfunc(ctx, javaLightMethodHandlers[page], DUK_VARARGS, 0 /*length*/, magic);
+      lightMethods->methods.push_back(std::move(javaMethod));
+    } else {
+      pushJavaMethodFunction(jsBridgeContext, std::move(javaMethod), javaThis);
+    }
 
     // Add this method to the bound object.
     duk_put_prop_string(ctx, objIndex, strMethodName.c_str());
   }
 
-  JNIEnv *env = jniContext->getJNIEnv();
-  assert(env != nullptr);
-
-  // Keep a reference in JavaScript to the object being bound.
-  duk_push_pointer(ctx, JniGlobalRef(object, JniGlobalRefMode::Leaked).get());  // JNI global ref will be deleted via JS finalizer
-  duk_put_prop_string(ctx, objIndex, JAVA_THIS_PROP_NAME);
-
   return 1;
 }
 
@@ -269,12 +493,15 @@ duk_ret_t JavaObject::pushLambda(const JsBridgeContext *jsBridgeContext, const s
   // See http://duktape.org/api.html#duk_push_c_function for details.
   const duk_idx_t funcIndex = duk_push_c_function(ctx, javaLambdaHandler, DUK_VARARGS);
 
+  // Keep a reference in JavaScript to the lambda being bound.
+  jobject javaThis = JniGlobalRef(object, JniGlobalRefMode::Leaked).get();  // JNI global ref will be deleted via JS finalizer
+  duk_set_magic(ctx, funcIndex, jsBridgeContext->getJavaCallBindings()->add(javaMethod.get(), javaThis));
+
   duk_push_pointer(ctx, javaMethod.release());
-  duk_put_prop_string(ctx, funcIndex, JAVA_METHOD_PROP_NAME);
+  duk_put_prop_literal(ctx, funcIndex, JAVA_METHOD_PROP_NAME);
 
-  // Keep a reference in JavaScript to the lambda being bound.
-  duk_push_pointer(ctx, JniGlobalRef(object, JniGlobalRefMode::Leaked).get());  // JNI global ref will be deleted via JS finalizer
-  duk_put_prop_string(ctx, funcIndex, JAVA_THIS_PROP_NAME);
+  duk_push_pointer(ctx, javaThis);
+  duk_put_prop_literal(ctx, funcIndex, JAVA_THIS_PROP_NAME);
 
   // Set a finalizer
   duk_push_c_function(ctx, javaLambdaFinalizer, 1);
@@ -293,7 +520,7 @@ bool JavaObject::hasJavaThis(const JsBridgeContext *jsBridgeContext, duk_idx_t i
   }
 
   const JniContext *jniContext = jsBridgeContext->getJniContext();
-  return duk_has_prop_string(ctx, index, JAVA_THIS_PROP_NAME);
+  return duk_has_prop_literal(ctx, index, JAVA_THIS_PROP_NAME);
 }
 
 // static
@@ -306,7 +533,7 @@ JniLocalRef<jobject> JavaObject::getJavaThis(const JsBridgeContext *jsBridgeCont
   }
 
   const JniContext *jniContext = jsBridgeContext->getJniContext();
-  duk_get_prop_string(ctx, index, JAVA_THIS_PROP_NAME);
+  duk_get_prop_literal(ctx, index, JAVA_THIS_PROP_NAME);
   if (duk_is_undefined(ctx, -1)) {
     duk_pop(ctx);
     return JniLocalRef<jobject>();
@@ -325,19 +552,26 @@ JniLocalRef<jobject> JavaObject::getJavaThis(const JsBridgeContext *jsBridgeCont
 #elif defined(QUICKJS)
 
 namespace {
-  // Called by QuickJS when JS invokes a method on our bound Java object
-  // TODO: use this_val and read JAVA_THIS property instead of datav!
-  JSValue javaMethodHandler(JSContext *ctx, JSValueConst /*this_val*/, int argc, JSValueConst *argv, int /*magic*/, JSValueConst *datav) {
-    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
-    assert(jsBridgeContext != nullptr);
+  // Methods of the Java objects registered to JS: the JS function (or the lazy getter) of each
+  // method has the method index as magic value and this table (owned by the functions) as first
+  // function data. The methods are either:
+  // - defined on a prototype shared by the objects of the same API interface: the Java this is
+  //   then the opaque pointer of the JS this (see QuickJsUtils::createJavaObjectValue()), which
+  //   must be an instance of the class declaring the method
+  // - or defined on the object itself and bound to its Java this (given as second function data)
+  struct JavaObjectMethods {
+    std::vector<std::unique_ptr<JavaMethod>> javaMethods;  // (null until accessed with lazy methods)
+    std::vector<JniGlobalRef<jclass>> declaringClasses;  // (only with a shared prototype)
+    JniGlobalRef<jobjectArray> methods;  // (only with lazy methods)
+    std::string qualifiedMethodPrefix;
+    bool isShared = false;
+  };
+
+  JSValue invokeJavaMethod(JsBridgeContext *jsBridgeContext, const JavaMethod *javaMethod, const JniLocalRef<jobject> &javaThis,
+                           int argc, JSValueConst *argv) {
+    JSContext *ctx = jsBridgeContext->getQuickJsContext();
 
     try {
-      // Get JavaMethod instance bound to the function itself
-      auto javaMethod = QuickJsUtils::getCppPtr<JavaMethod>(datav[0]);
-
-      // Java this is a property of the JS method
-      JniLocalRef<jobject> javaThis = jsBridgeContext->getUtils()->getJavaRef<jobject>(datav[1]);
-
       JSValue ret = javaMethod->invoke(jsBridgeContext, javaThis, argc, argv);
 
       // Also check for pending JS exceptions
@@ -354,61 +588,234 @@ namespace {
       return JS_EXCEPTION;
     }
   }
+
+  // Called by QuickJS when JS invokes a method of a shared prototype on our bound Java object
+  JSValue sharedJavaMethodHandler(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv, int magic, JSValueConst *datav) {
+    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    assert(jsBridgeContext != nullptr);
+
+    auto javaObjectMethods = QuickJsUtils::getCppPtr<JavaObjectMethods>(datav[0]);
+    jobject javaThisRaw = QuickJsUtils::getJavaObjectGlobalRef(this_val);
+    if (javaObjectMethods == nullptr || javaThisRaw == nullptr) {
+      return JS_ThrowTypeError(ctx, "Cannot execute Java method: Java object not found (methods must be called on their object)!");
+    }
+
+    const JniContext *jniContext = jsBridgeContext->getJniContext();
+    JniLocalRef<jobject> javaThis(jniContext, javaThisRaw, JniLocalRefMode::NewLocalRef);
+
+    // JS can call the method on any other bound Java object (e.g. method.call(otherObject))
+    if (!jniContext->isInstanceOf(javaThis, javaObjectMethods->declaringClasses[magic])) {
+      return JS_ThrowTypeError(ctx, "Cannot execute Java method: the Java object is not an instance of the class of the method!");
+    }
+
+    return invokeJavaMethod(jsBridgeContext, javaObjectMethods->javaMethods[magic].get(), javaThis, argc, argv);
+  }
+
+  // Called by QuickJS when JS invokes a method bound to a Java object (independently of the JS this)
+  JSValue boundJavaMethodHandler(JSContext *ctx, JSValueConst /*this_val*/, int argc, JSValueConst *argv, int magic, JSValueConst *datav) {
+    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    assert(jsBridgeContext != nullptr);
+
+    auto javaObjectMethods = QuickJsUtils::getCppPtr<JavaObjectMethods>(datav[0]);
+    if (javaObjectMethods == nullptr) {
+      return JS_ThrowTypeError(ctx, "Cannot execute Java method: Java method not found!");
+    }
+
+    // Java this is a function data of the JS method
+    JniLocalRef<jobject> javaThis = jsBridgeContext->getUtils()->getJavaRef<jobject>(datav[1]);
+
+    return invokeJavaMethod(jsBridgeContext, javaObjectMethods->javaMethods[magic].get(), javaThis, argc, argv);
+  }
+
+  // Called by QuickJS when JS invokes a bound Java lambda
+  JSValue javaLambdaHandler(JSContext *ctx, JSValueConst /*this_val*/, int argc, JSValueConst *argv, int /*magic*/, JSValueConst *datav) {
+    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    assert(jsBridgeContext != nullptr);
+
+    // Get JavaMethod instance bound to the function itself
+    auto javaMethod = QuickJsUtils::getCppPtr<JavaMethod>(datav[0]);
+
+    // Java this is a property of the JS method
+    JniLocalRef<jobject> javaThis = jsBridgeContext->getUtils()->getJavaRef<jobject>(datav[1]);
+
+    return invokeJavaMethod(jsBridgeContext, javaMethod, javaThis, argc, argv);
+  }
+
+  // Create the JavaMethod with the given index (and the class declaring it with a shared prototype)
+  void bindJavaMethod(const JsBridgeContext *jsBridgeContext, JavaObjectMethods *javaObjectMethods, jsize index,
+                      const JniLocalRef<jsBridgeMethod> &method, const std::string &strMethodName) {
+    javaObjectMethods->javaMethods[index] = createJavaMethod(jsBridgeContext, method, javaObjectMethods->qualifiedMethodPrefix + strMethodName);
+
+    if (javaObjectMethods->isShared) {
+      const JniCache *jniCache = jsBridgeContext->getJniCache();
+      JniLocalRef<jobject> javaMethod = jniCache->getMethodInterface(method).getJavaMethod();
+      javaObjectMethods->declaringClasses[index] = JniGlobalRef<jclass>(jniCache->getJavaReflectedMethodDeclaringClass(javaMethod));
+    }
+  }
+
+  // Create the JS function calling the Java method with the given index, either on the Java this
+  // of the JS this (shared prototype) or on the given Java this
+  JSValue createJavaMethodFunction(JSContext *ctx, int index, JSValueConst javaObjectMethodsValue, JSValueConst javaThisValue) {
+    if (JS_IsUndefined(javaThisValue)) {
+      return JS_NewCFunctionData(ctx, sharedJavaMethodHandler, 1 /*length*/, index /*magic*/, 1, &javaObjectMethodsValue);
+    }
+
+    JSValueConst javaMethodHandlerData[2];
+    javaMethodHandlerData[0] = javaObjectMethodsValue;
+    javaMethodHandlerData[1] = javaThisValue;
+    return JS_NewCFunctionData(ctx, boundJavaMethodHandler, 1 /*length*/, index /*magic*/, 2, javaMethodHandlerData);
+  }
+
+  // Called by QuickJS when JS accesses a lazy method of a bound Java object for the first time:
+  // bind the Java method (given by the magic index) and replace the getter with its function. The
+  // function data are the method table, the shared prototype (or undefined) and the Java this (or
+  // undefined with a shared prototype).
+  JSValue lazyJavaMethodGetter(JSContext *ctx, JSValueConst this_val, int /*argc*/, JSValueConst * /*argv*/, int magic, JSValueConst *datav) {
+    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    assert(jsBridgeContext != nullptr);
+
+    try {
+      auto javaObjectMethods = QuickJsUtils::getCppPtr<JavaObjectMethods>(datav[0]);
+      if (javaObjectMethods == nullptr) {
+        throw std::invalid_argument("Cannot bind Java method: Java object not found!");
+      }
+
+      JObjectArrayLocalRef methods(jsBridgeContext->getJniContext(), javaObjectMethods->methods.get(), JniLocalRefMode::Borrowed);
+      JniLocalRef<jsBridgeMethod> method = methods.getElement<jsBridgeMethod>(magic);
+      std::string strMethodName = jsBridgeContext->getJniCache()->getMethodInterface(method).getName().toStdString();
+
+      if (!javaObjectMethods->javaMethods[magic]) {
+        bindJavaMethod(jsBridgeContext, javaObjectMethods, magic, method, strMethodName);
+      }
+      JSValue javaMethodHandlerValue = createJavaMethodFunction(ctx, magic, datav[0], datav[2]);
+
+      // Replace the getter (of the shared prototype or of the object) with the function
+      JSValueConst ownerValue = javaObjectMethods->isShared ? datav[1] : this_val;
+      JSAtom methodNameAtom = JS_NewAtom(ctx, strMethodName.c_str());
+      int ret = JS_DefinePropertyValue(ctx, ownerValue, methodNameAtom, JS_DupValue(ctx, javaMethodHandlerValue), JS_PROP_C_W_E);
+      JS_FreeAtom(ctx, methodNameAtom);
+      if (ret < 0) {
+        JS_FreeValue(ctx, javaMethodHandlerValue);
+        return JS_EXCEPTION;
+      }
+
+      return javaMethodHandlerValue;
+    } catch (const std::exception &e) {
+      jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return JS_EXCEPTION;
+    }
+  }
+
+  // Define the methods of the Java objects on the given owner: either a shared prototype (with an
+  // undefined Java this) or the object bound to the given Java this
+  void defineJavaObjectMethods(const JsBridgeContext *jsBridgeContext, JSValueConst ownerValue, JSValueConst javaThisValue,
+                               const std::string &qualifiedMethodPrefix, const JObjectArrayLocalRef &methods, bool lazyMethods) {
+    JSContext *ctx = jsBridgeContext->getQuickJsContext();
+    const QuickJsUtils *utils = jsBridgeContext->getUtils();
+
+    const jsize numMethods = methods.isNull() ? 0 : methods.getLength();
+    if (numMethods == 0) {
+      return;
+    }
+
+    auto javaObjectMethods = new JavaObjectMethods();
+    javaObjectMethods->isShared = JS_IsUndefined(javaThisValue);
+    javaObjectMethods->javaMethods.resize(numMethods);
+    if (javaObjectMethods->isShared) {
+      javaObjectMethods->declaringClasses.resize(numMethods);
+    }
+    javaObjectMethods->qualifiedMethodPrefix = qualifiedMethodPrefix;
+    if (lazyMethods) {
+      javaObjectMethods->methods = JniGlobalRef<jobjectArray>(methods);
+    }
+    JSValue javaObjectMethodsValue = utils->createCppPtrValue(javaObjectMethods);
+    JS_AUTORELEASE_VALUE(ctx, javaObjectMethodsValue);
+
+    // (a lazy getter defined on the object itself replaces itself on its JS this)
+    JSValueConst lazyMethodGetterData[3];
+    lazyMethodGetterData[0] = javaObjectMethodsValue;
+    lazyMethodGetterData[1] = javaObjectMethods->isShared ? ownerValue : JS_UNDEFINED;
+    lazyMethodGetterData[2] = javaThisValue;
+
+    for (jsize i = 0; i < numMethods; ++i) {
+      JniLocalRef<jsBridgeMethod> method = methods.getElement<jsBridgeMethod>(i);
+      std::string strMethodName = jsBridgeContext->getJniCache()->getMethodInterface(method).getName().toStdString();
+      JSAtom methodNameAtom = JS_NewAtom(ctx, strMethodName.c_str());
+
+      if (lazyMethods) {
+        // Only define a getter for each method (its magic being the method index)
+        JSValue getterValue = JS_NewCFunctionData(ctx, lazyJavaMethodGetter, 0 /*length*/, i /*magic*/, 3, lazyMethodGetterData);
+        JS_DefinePropertyGetSet(ctx, ownerValue, methodNameAtom, getterValue, JS_UNDEFINED, JS_PROP_CONFIGURABLE | JS_PROP_ENUMERABLE);
+        // No JS_FreeValue(m_ctx, getterValue) after JS_DefinePropertyGetSet()
+        JS_FreeAtom(ctx, methodNameAtom);
+        continue;
+      }
+
+      try {
+        bindJavaMethod(jsBridgeContext, javaObjectMethods, i, method, strMethodName);
+      } catch (const std::exception &) {
+        JS_FreeAtom(ctx, methodNameAtom);
+        throw;
+      }
+
+      JSValue javaMethodHandlerValue = createJavaMethodFunction(ctx, i, javaObjectMethodsValue, javaThisValue);
+
+      // Add this method to the prototype or to the bound object
+      JS_DefinePropertyValue(ctx, ownerValue, methodNameAtom, javaMethodHandlerValue, JS_PROP_C_W_E);
+      // No JS_FreeValue(m_ctx, javaMethodHandlerValue) after JS_DefinePropertyValue()
+      JS_FreeAtom(ctx, methodNameAtom);
+    }
+  }
 }
 
 // static
-JSValue JavaObject::create(const JsBridgeContext *jsBridgeContext, const std::string &strName, const JniLocalRef<jobject> &object) {
-    return create(jsBridgeContext, strName, object, JObjectArrayLocalRef());
+JSValue JavaObject::create(const JsBridgeContext *jsBridgeContext, const std::string &, const JniLocalRef<jobject> &object) {
+  return jsBridgeContext->getUtils()->createJavaObjectValue(object, JS_UNDEFINED);
 }
 
 // static
-JSValue JavaObject::create(const JsBridgeContext *jsBridgeContext, const std::string &strName, const JniLocalRef<jobject> &object, const JObjectArrayLocalRef &methods) {
+JSValue JavaObject::create(const JsBridgeContext *jsBridgeContext, const std::string &strName, const JniLocalRef<jobject> &object,
+                           const std::string &strPrototypeName, const JObjectArrayLocalRef &methods, bool lazyMethods) {
   JSContext *ctx = jsBridgeContext->getQuickJsContext();
-  const QuickJsUtils *utils = jsBridgeContext->getUtils();
+  QuickJsUtils *utils = jsBridgeContext->getUtils();
 
-  JSValue javaObjectValue = JS_NewObject(ctx);
-
-  const jsize numMethods = methods.isNull() ? 0 : methods.getLength();
-  std::string qualifiedMethodPrefix = strName + "::";
-
-  for (jsize i = 0; i < numMethods; ++i) {
-    JniLocalRef<jsBridgeMethod> method = methods.getElement<jsBridgeMethod>(i);
-    MethodInterface methodInterface = jsBridgeContext->getJniCache()->getMethodInterface(method);
+  if (strPrototypeName.empty()) {
+    // The methods are own properties of the object, bound to its Java this
+    JSValue javaObjectValue = utils->createJavaObjectValue(object, JS_UNDEFINED);
+    if (JS_IsException(javaObjectValue)) {
+      return javaObjectValue;
+    }
 
-    std::string strMethodName = methodInterface.getName().toStdString();
-    std::string qualifiedMethodName = qualifiedMethodPrefix + strMethodName;
+    JSValue javaThisValue = utils->createJavaRefValue(object);
+    JS_AUTORELEASE_VALUE(ctx, javaThisValue);
 
-    std::unique_ptr<JavaMethod> javaMethod;
     try {
-      javaMethod = std::make_unique<JavaMethod>(jsBridgeContext, method, qualifiedMethodName, false /*isLambda*/);
-    } catch (const std::exception &e) {
+      defineJavaObjectMethods(jsBridgeContext, javaObjectValue, javaThisValue, strName + "::", methods, lazyMethods);
+    } catch (const std::exception &) {
       JS_FreeValue(ctx, javaObjectValue);
-      throw std::invalid_argument(std::string() + "In bound method \"" + qualifiedMethodName + "\": " + e.what());
+      throw;
     }
 
-    JSValue javaMethodValue = utils->createCppPtrValue(javaMethod.release(), true);
-    JSValue javaThisValue = utils->createJavaRefValue(JniGlobalRef<jobject>(object));
-    JSValueConst javaMethodHandlerData[2];
-    javaMethodHandlerData[0] = javaMethodValue;
-    javaMethodHandlerData[1] = javaThisValue;
-    JSValue javaMethodHandlerValue = JS_NewCFunctionData(ctx, javaMethodHandler, 1 /*length*/, 0 /*magic*/, 2, javaMethodHandlerData);
+    return javaObjectValue;
+  }
 
-    // Free data values (they are duplicated by JS_NewCFunctionData)
-    JS_FreeValue(ctx, javaMethodValue);
-    JS_FreeValue(ctx, javaThisValue);
+  // Reuse the prototype (and the methods) of the objects registered with the same prototype name
+  JSValue prototypeValue = JS_DupValue(ctx, utils->getJavaObjectPrototype(strPrototypeName));
+  if (JS_IsUndefined(prototypeValue)) {
+    prototypeValue = JS_NewObject(ctx);
 
-    // Add this method to the bound object
-    JS_SetPropertyStr(ctx, javaObjectValue, strMethodName.c_str(), javaMethodHandlerValue);
-    // No JS_FreeValue(m_ctx, javaMethodHandlerValue) after JS_SetPropertyStr()
-  }
+    try {
+      defineJavaObjectMethods(jsBridgeContext, prototypeValue, JS_UNDEFINED, strPrototypeName + "::", methods, lazyMethods);
+    } catch (const std::exception &) {
+      JS_FreeValue(ctx, prototypeValue);
+      throw;
+    }
 
-  // Keep a reference in JavaScript to the object being bound
-  // (which is properly released when the JSValue gets finalized)
-  auto javaThisValue = utils->createJavaRefValue<jobject>(object);
-  JS_SetPropertyStr(ctx, javaObjectValue, JAVA_THIS_PROP_NAME, javaThisValue);
-  // No JS_FreeValue(m_ctx, javaThisValue) after JS_SetPropertyStr()
+    utils->setJavaObjectPrototype(strPrototypeName, JS_DupValue(ctx, prototypeValue));
+  }
+  JS_AUTORELEASE_VALUE(ctx, prototypeValue);
 
-  return javaObjectValue;
+  return utils->createJavaObjectValue(object, prototypeValue);
 }
 
 // static
@@ -428,12 +835,12 @@ JSValue JavaObject::createLambda(const JsBridgeContext *jsBridgeContext, const s
     throw std::invalid_argument(std::string() + "In bound method \"" + qualifiedMethodName + "\": " + e.what());
   }
 
-  JSValue javaLambdaValue = utils->createCppPtrValue(javaMethod.release(), true /*deleteOnFinalize*/);  // wrap the C++ instance
-  JSValue javaThisValue = utils->createJavaRefValue(JniGlobalRef<jobject>(object));  // wrap the JNI ref
+  JSValue javaLambdaValue = utils->createCppPtrValue(javaMethod.release());  // wrap the C++ instance
+  JSValue javaThisValue = utils->createJavaRefValue(object);  // wrap the JNI ref
   JSValueConst javaLambdaHandlerData[2];
   javaLambdaHandlerData[0] = javaLambdaValue;
   javaLambdaHandlerData[1] = javaThisValue;
-  JSValue javaLambdaHandlerValue = JS_NewCFunctionData(ctx, javaMethodHandler, 1 /*length*/, 0 /*magic*/, 2, javaLambdaHandlerData);
+  JSValue javaLambdaHandlerValue = JS_NewCFunctionData(ctx, javaLambdaHandler, 1 /*length*/, 0 /*magic*/, 2, javaLambdaHandlerData);
 
   // Free data values (they are duplicated by JS_NewCFunctionData)
   JS_FreeValue(ctx, javaLambdaValue);
@@ -443,32 +850,18 @@ JSValue JavaObject::createLambda(const JsBridgeContext *jsBridgeContext, const s
 }
 
 // static
-bool JavaObject::hasJavaThis(const JsBridgeContext *jsBridgeContext, JSValue jsObject) {
-  if (!JS_IsObject(jsObject) || JS_IsNull(jsObject)) {
-    return false;
-  }
-
-  auto ctx = jsBridgeContext->getQuickJsContext();
-  JSValue javaThisValue = JS_GetPropertyStr(ctx, jsObject, JAVA_THIS_PROP_NAME);
-  JS_AUTORELEASE_VALUE(ctx, javaThisValue);
-
-  return !JS_IsUndefined(javaThisValue);
+bool JavaObject::hasJavaThis(const JsBridgeContext *, JSValue jsObject) {
+  return QuickJsUtils::getJavaObjectGlobalRef(jsObject) != nullptr;
 }
 
 // static
 JniLocalRef<jobject> JavaObject::getJavaThis(const JsBridgeContext *jsBridgeContext, JSValue jsObject) {
-  if (!JS_IsObject(jsObject) || JS_IsNull(jsObject)) {
-    return JniLocalRef<jobject>();
-  }
-
-  auto ctx = jsBridgeContext->getQuickJsContext();
-  JSValue javaThisValue = JS_GetPropertyStr(ctx, jsObject, JAVA_THIS_PROP_NAME);
-  JS_AUTORELEASE_VALUE(ctx, javaThisValue);
-  if (!JS_IsObject(jsObject) || JS_IsNull(jsObject)) {
+  jobject globalRef = QuickJsUtils::getJavaObjectGlobalRef(jsObject);
+  if (globalRef == nullptr) {
     return JniLocalRef<jobject>();
   }
 
-  return jsBridgeContext->getUtils()->getJavaRef<jobject>(javaThisValue);
+  return JniLocalRef<jobject>(jsBridgeContext->getJniContext(), globalRef, JniLocalRefMode::NewLocalRef);
 }
 
 #endif
@@ -39,13 +39,15 @@ public:
 
 #if defined(DUKTAPE)
   static duk_ret_t push(const JsBridgeContext *, const std::string &strName, const JniLocalRef<jobject> &object);
-  static duk_ret_t push(const JsBridgeContext *, const std::string &strName, const JniLocalRef<jobject> &object, const JObjectArrayLocalRef &methods);
+  static duk_ret_t push(const JsBridgeContext *, const std::string &strName, const JniLocalRef<jobject> &object, const JObjectArrayLocalRef &methods, bool lazyMethods);
   static duk_ret_t pushLambda(const JsBridgeContext *, const std::string &strName, const JniLocalRef<jobject> &object, const JniLocalRef<jsBridgeMethod> &method);
   static bool hasJavaThis(const JsBridgeContext *, duk_idx_t);
   static JniLocalRef<jobject> getJavaThis(const JsBridgeContext *, duk_idx_t);
 #elif defined(QUICKJS)
   static JSValue create(const JsBridgeContext *, const std::string &strName, const JniLocalRef<jobject> &object);
-  static JSValue create(const JsBridgeContext *, const std::string &strName, const JniLocalRef<jobject> &object, const JObjectArrayLocalRef &methods);
+  // The objects created with the same (non-empty) prototype name share the same prototype holding
+  // their methods
+  static JSValue create(const JsBridgeContext *, const std::string &strName, const JniLocalRef<jobject> &object, const std::string &strPrototypeName, const JObjectArrayLocalRef &methods, bool lazyMethods);
   static JSValue createLambda(const JsBridgeContext *, const std::string &strName, const JniLocalRef<jobject> &object, const JniLocalRef<jsBridgeMethod> &method);
   static bool hasJavaThis(const JsBridgeContext *, JSValue jsObject);
   static JniLocalRef<jobject> getJavaThis(const JsBridgeContext *, JSValue jsObject);
@@ -53,6 +53,8 @@ JValue JavaScriptLambda::call(const JsBridgeContext *jsBridgeContext, const JObj
 
 #elif defined(QUICKJS)
 
+#include "QuickJsUtils.h"
+
 JavaScriptLambda::JavaScriptLambda(const JsBridgeContext *jsBridgeContext, const JniRef<jsBridgeMethod> &method, std::string strName, JSValue jsLambdaValue)
  : m_method(nullptr)
  , m_name(std::move(strName)) {
@@ -67,9 +69,8 @@ JavaScriptLambda::JavaScriptLambda(const JsBridgeContext *jsBridgeContext, const
 }
 
 JValue JavaScriptLambda::call(const JsBridgeContext *jsBridgeContext, const JObjectArrayLocalRef &args, bool awaitJsPromise) const {
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
-  JSValue jsLambdaValue = JS_GetPropertyStr(m_ctx, globalObj, m_name.c_str());
-  JS_FreeValue(m_ctx, globalObj);
+  JSValueConst ownerObj = jsBridgeContext->getUtils()->getNamedValueOwner(m_name);
+  JSValue jsLambdaValue = JS_GetPropertyStr(m_ctx, ownerObj, m_name.c_str());
 
   JS_AUTORELEASE_VALUE(m_ctx, jsLambdaValue);
 
@@ -78,6 +79,10 @@ JValue JavaScriptLambda::call(const JsBridgeContext *jsBridgeContext, const JObj
         "Cannot call " + m_name + " lambda. It does not exist or is not a valid function.");
   }
 
+  return call(jsBridgeContext, jsLambdaValue, args, awaitJsPromise);
+}
+
+JValue JavaScriptLambda::call(const JsBridgeContext *jsBridgeContext, JSValueConst jsLambdaValue, const JObjectArrayLocalRef &args, bool awaitJsPromise) const {
   return m_method->invoke(jsBridgeContext, jsLambdaValue, JS_UNDEFINED, args, awaitJsPromise);
 }
 
@@ -50,6 +50,11 @@ public:
 
   JValue call(const JsBridgeContext *, const JObjectArrayLocalRef &args, bool awaitJsPromise) const;
 
+#if defined(QUICKJS)
+  // Call the given JS lambda value without looking it up via its global name
+  JValue call(const JsBridgeContext *, JSValueConst jsLambdaValue, const JObjectArrayLocalRef &args, bool awaitJsPromise) const;
+#endif
+
 private:
   JavaScriptMethod *m_method;
 #if defined(DUKTAPE)
@@ -19,32 +19,161 @@
 #include "JavaScriptMethod.h"
 
 #include "AutoReleasedJSValue.h"
+#include "CallTracer.h"
 #include "ExceptionHandler.h"
 #include "JavaType.h"
 #include "JniCache.h"
 #include "JniTypes.h"
 #include "JsBridgeContext.h"
 #include "exceptions/JsException.h"
+#include "java-types/Boolean.h"
+#include "java-types/Byte.h"
+#include "java-types/Double.h"
+#include "java-types/Float.h"
+#include "java-types/Integer.h"
+#include "java-types/Long.h"
+#include "java-types/Short.h"
+#include "jni-helpers/JArrayLocalRef.h"
 #include "jni-helpers/JniContext.h"
 #include "jni-helpers/JObjectArrayLocalRef.h"
+#include <cstring>
 #include <stdexcept>
 #include <string>
 
+using namespace JavaTypes;
+
+namespace {
+  bool isPackableArgumentType(JavaTypeId id) {
+    switch (id) {
+      case JavaTypeId::Boolean:
+      case JavaTypeId::BoxedBoolean:
+      case JavaTypeId::Byte:
+      case JavaTypeId::BoxedByte:
+      case JavaTypeId::Short:
+      case JavaTypeId::BoxedShort:
+      case JavaTypeId::Int:
+      case JavaTypeId::BoxedInt:
+      case JavaTypeId::Long:
+      case JavaTypeId::BoxedLong:
+      case JavaTypeId::Float:
+      case JavaTypeId::BoxedFloat:
+      case JavaTypeId::Double:
+      case JavaTypeId::BoxedDouble:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  jdouble unpackDouble(jlong packedArg) {
+    jdouble value;
+    std::memcpy(&value, &packedArg, sizeof(value));
+    return value;
+  }
+
+  // Unpack the given argument (see JavaScriptMethod::invoke() with packedArgs) and give it to
+  // f(traits, value) with the Traits of its primitive type (see PrimitiveType)
+  template <typename F>
+  auto withUnpackedArgument(JavaTypeId id, jlong packedArg, F &&f) {
+    switch (id) {
+      case JavaTypeId::Boolean:
+      case JavaTypeId::BoxedBoolean:
+        return f(BooleanTraits(), static_cast<jboolean>(packedArg != 0 ? JNI_TRUE : JNI_FALSE));
+      case JavaTypeId::Byte:
+      case JavaTypeId::BoxedByte:
+        return f(ByteTraits(), static_cast<jbyte>(packedArg));
+      case JavaTypeId::Short:
+      case JavaTypeId::BoxedShort:
+        return f(ShortTraits(), static_cast<jshort>(packedArg));
+      case JavaTypeId::Int:
+      case JavaTypeId::BoxedInt:
+        return f(IntegerTraits(), static_cast<jint>(packedArg));
+      case JavaTypeId::Long:
+      case JavaTypeId::BoxedLong:
+        return f(LongTraits(), packedArg);
+      case JavaTypeId::Float:
+      case JavaTypeId::BoxedFloat:
+        return f(FloatTraits(), static_cast<jfloat>(unpackDouble(packedArg)));
+      case JavaTypeId::Double:
+      case JavaTypeId::BoxedDouble:
+        return f(DoubleTraits(), unpackDouble(packedArg));
+      default:
+        throw std::invalid_argument("Cannot unpack an argument of type " + std::to_string(static_cast<int>(id)));
+    }
+  }
+}
+
 JavaScriptMethod::JavaScriptMethod(const JsBridgeContext *jsBridgeContext, const JniRef<jsBridgeMethod> &method, std::string methodName, bool isLambda)
  : m_methodName(std::move(methodName))
+ , m_traceName("JsMethod " + m_methodName)
  , m_isLambda(isLambda) {
 
   const JniCache *jniCache = jsBridgeContext->getJniCache();
   const JavaTypeProvider &javaTypeProvider = jsBridgeContext->getJavaTypeProvider();
 
   MethodInterface methodInterface = jniCache->getMethodInterface(method);
-  m_isVarArgs = methodInterface.isVarArgs();
+
+  const JavaTypeProvider::MethodSignatures signatures = javaTypeProvider.getMethodSignatures(method);
+  m_isVarArgs = signatures.isVarArgs;
+
+  // Fast path (no further JNI call): all the types have already been created with the same signatures
+  m_returnValueType = javaTypeProvider.findSharedType(signatures.returnType, true /*boxed*/);
+  if (m_returnValueType != nullptr) {
+    m_deferredReturnValueType = m_returnValueType->isDeferred()
+        ? m_returnValueType
+        : javaTypeProvider.findSharedType("kotlinx.coroutines.Deferred<" + signatures.returnType + ">", true /*boxed*/);
+  }
+
+  bool hasSharedTypes = m_deferredReturnValueType != nullptr
+      && javaTypeProvider.findSharedTypes(signatures.parameterTypes, true /*boxed*/, &m_argumentTypes);
+  if (hasSharedTypes && m_isVarArgs) {
+    // Vararg elements are not boxed
+    m_argumentTypes.back() = javaTypeProvider.findSharedType(signatures.parameterTypes.back(), false /*boxed*/);
+    hasSharedTypes = m_argumentTypes.back() != nullptr;
+  }
+
+  if (!hasSharedTypes) {
+    createTypes(jsBridgeContext, methodInterface);
+  }
+
+  m_hasPackableArguments = !m_isVarArgs && !m_argumentTypes.empty();
+  for (const auto &argumentType : m_argumentTypes) {
+    m_hasPackableArguments = m_hasPackableArguments && isPackableArgumentType(argumentType->getTypeId());
+  }
+}
+
+JavaScriptMethod::JavaScriptMethod(JavaScriptMethod &&other) noexcept
+ : m_methodName(std::move(other.m_methodName))
+ , m_traceName(std::move(other.m_traceName))
+ , m_returnValueType(std::move(other.m_returnValueType))
+ , m_deferredReturnValueType(std::move(other.m_deferredReturnValueType))
+ , m_argumentTypes(std::move(other.m_argumentTypes))
+ , m_isLambda(other.m_isLambda)
+ , m_isVarArgs(other.m_isVarArgs)
+ , m_hasPackableArguments(other.m_hasPackableArguments) {
+}
+
+JavaScriptMethod &JavaScriptMethod::operator=(JavaScriptMethod &&other) noexcept {
+  m_methodName = std::move(other.m_methodName);
+  m_traceName = std::move(other.m_traceName);
+  m_returnValueType = std::move(other.m_returnValueType);
+  m_deferredReturnValueType = std::move(other.m_deferredReturnValueType);
+  m_argumentTypes = std::move(other.m_argumentTypes);
+  m_isLambda = other.m_isLambda;
+  m_isVarArgs = other.m_isVarArgs;
+  m_hasPackableArguments = other.m_hasPackableArguments;
+
+  return *this;
+}
+
+void JavaScriptMethod::createTypes(const JsBridgeContext *jsBridgeContext, const MethodInterface &methodInterface) {
+  const JavaTypeProvider &javaTypeProvider = jsBridgeContext->getJavaTypeProvider();
 
   {
     // Create return value loader
     JniLocalRef<jsBridgeParameter> returnParameter = methodInterface.getReturnParameter();
-    m_returnValueType = std::move(javaTypeProvider.makeUniqueType(returnParameter, true /*boxed*/));
-    m_returnValueParameter = JniGlobalRef<jsBridgeParameter>(returnParameter);
+    m_returnValueType = std::move(javaTypeProvider.getType(returnParameter, true /*boxed*/));
+    m_deferredReturnValueType = m_returnValueType->isDeferred() ? m_returnValueType : javaTypeProvider.getDeferredType(returnParameter);
   }
 
   JObjectArrayLocalRef parameters = methodInterface.getParameters();
@@ -62,47 +191,24 @@ JavaScriptMethod::JavaScriptMethod(const JsBridgeContext *jsBridgeContext, const
     if (m_isVarArgs && i == numParameters - 1) {
         ParameterInterface parameterInterface = jsBridgeContext->getJniCache()->getParameterInterface(parameter);
         JniLocalRef<jsBridgeParameter> varArgParameter = parameterInterface.getGenericParameter();
-        auto javaType = jsBridgeContext->getJavaTypeProvider().makeUniqueType(varArgParameter, false /*boxed*/);
+        auto javaType = javaTypeProvider.getType(varArgParameter, false /*boxed*/);
         m_argumentTypes[i] = std::move(javaType);
         break;
     }
 
     // Always load the boxed type instead of the primitive type (e.g. Integer vs int)
     // because we are going to a Proxy object
-    auto javaType = javaTypeProvider.makeUniqueType(parameter, true /*boxed*/);
+    auto javaType = javaTypeProvider.getType(parameter, true /*boxed*/);
     m_argumentTypes[i] = std::move(javaType);
   }
 }
 
-JavaScriptMethod::JavaScriptMethod(JavaScriptMethod &&other) noexcept
- : m_methodName(std::move(other.m_methodName))
- , m_returnValueType(std::move(other.m_returnValueType))
- , m_returnValueParameter(std::move(other.m_returnValueParameter))
- , m_argumentTypes(std::move(other.m_argumentTypes))
- , m_isLambda(other.m_isLambda)
- , m_isVarArgs(other.m_isVarArgs) {
-}
-
-JavaScriptMethod &JavaScriptMethod::operator=(JavaScriptMethod &&other) noexcept {
-  m_methodName = std::move(other.m_methodName);
-  m_returnValueType = std::move(other.m_returnValueType);
-  m_returnValueParameter = std::move(other.m_returnValueParameter);
-  m_argumentTypes = std::move(other.m_argumentTypes);
-  m_isLambda = other.m_isLambda;
-  m_isVarArgs = other.m_isVarArgs;
-
-  return *this;
-}
-
 #if defined(DUKTAPE)
 
 #include "StackChecker.h"
 
-JValue JavaScriptMethod::invoke(const JsBridgeContext *jsBridgeContext, void *jsHeapPtr, const JObjectArrayLocalRef &args, bool awaitJsPromise) const {
+duk_idx_t JavaScriptMethod::pushCallee(const JsBridgeContext *jsBridgeContext, void *jsHeapPtr) const {
   duk_context *ctx = jsBridgeContext->getDuktapeContext();
-  CHECK_STACK(ctx);
-
-  JValue result;
 
   // Set up the call - push the object, method name, and arguments onto the stack
   duk_push_heapptr(ctx, jsHeapPtr);
@@ -115,6 +221,18 @@ JValue JavaScriptMethod::invoke(const JsBridgeContext *jsBridgeContext, void *js
     duk_push_string(ctx, m_methodName.c_str());
   }
 
+  return jsLambdaOrObjectIdx;
+}
+
+JValue JavaScriptMethod::invoke(const JsBridgeContext *jsBridgeContext, void *jsHeapPtr, const JObjectArrayLocalRef &args, bool awaitJsPromise) const {
+  duk_context *ctx = jsBridgeContext->getDuktapeContext();
+  CHECK_STACK(ctx);
+
+  CallTrace callTrace(jsBridgeContext->getCallTracer(), m_traceName.c_str());
+  callTrace.beginPhase(CallTracer::Phase::Conversion);
+
+  duk_idx_t jsLambdaOrObjectIdx = pushCallee(jsBridgeContext, jsHeapPtr);
+
   jsize numArguments = args.isNull() ? 0U : args.getLength();
 
   for (jsize i = 0; i < numArguments; ++i) {
@@ -132,6 +250,41 @@ JValue JavaScriptMethod::invoke(const JsBridgeContext *jsBridgeContext, void *js
     }
   }
 
+  return callJs(jsBridgeContext, callTrace, jsLambdaOrObjectIdx, numArguments, awaitJsPromise);
+}
+
+JValue JavaScriptMethod::invoke(const JsBridgeContext *jsBridgeContext, void *jsHeapPtr, const JArrayLocalRef<jlong> &packedArgs, bool awaitJsPromise) const {
+  duk_context *ctx = jsBridgeContext->getDuktapeContext();
+  CHECK_STACK(ctx);
+
+  const auto numArguments = static_cast<size_t>(packedArgs.getLength());
+  if (!m_hasPackableArguments || numArguments != m_argumentTypes.size()) {
+    throw std::invalid_argument("Cannot call JS method " + m_methodName + " with packed arguments");
+  }
+
+  CallTrace callTrace(jsBridgeContext->getCallTracer(), m_traceName.c_str());
+  callTrace.beginPhase(CallTracer::Phase::Conversion);
+
+  // Single JNI call for all the arguments
+  jlong values[numArguments];
+  packedArgs.getRegion(0, static_cast<jsize>(numArguments), values);
+
+  duk_idx_t jsLambdaOrObjectIdx = pushCallee(jsBridgeContext, jsHeapPtr);
+
+  for (size_t i = 0; i < numArguments; ++i) {
+    withUnpackedArgument(m_argumentTypes[i]->getTypeId(), values[i], [ctx](auto traits, auto value) {
+      decltype(traits)::pushJsValue(ctx, value);
+    });
+  }
+
+  return callJs(jsBridgeContext, callTrace, jsLambdaOrObjectIdx, static_cast<duk_idx_t>(numArguments), awaitJsPromise);
+}
+
+JValue JavaScriptMethod::callJs(const JsBridgeContext *jsBridgeContext, CallTrace &callTrace, duk_idx_t jsLambdaOrObjectIdx, duk_idx_t numArguments, bool awaitJsPromise) const {
+  duk_context *ctx = jsBridgeContext->getDuktapeContext();
+
+  callTrace.beginPhase(CallTracer::Phase::JsExecution);
+
   duk_ret_t ret;
   if (m_isLambda) {
     ret = duk_pcall(ctx, numArguments);  // [... func arg1 ... argN] -> [... retval]
@@ -139,23 +292,15 @@ JValue JavaScriptMethod::invoke(const JsBridgeContext *jsBridgeContext, void *js
     ret = duk_pcall_prop(ctx, jsLambdaOrObjectIdx, numArguments);  // [... obj ... key arg1 ... argN] -> [... obj ... retval]
     duk_remove(ctx, jsLambdaOrObjectIdx);
   }
-  if (ret == DUK_EXEC_SUCCESS) {
-    try {
-      bool isDeferred = awaitJsPromise && duk_is_object(ctx, -1) && duk_has_prop_string(ctx, -1, "then");
-      if (isDeferred && !m_returnValueType->isDeferred()) {
-        result = jsBridgeContext->getJavaTypeProvider().getDeferredType(m_returnValueParameter)->pop();
-      } else {
-        result = m_returnValueType->pop();
-      }
-    } catch (const std::exception &) {
-      throw;
-    }
-  } else {
+
+  if (ret != DUK_EXEC_SUCCESS) {
     throw jsBridgeContext->getExceptionHandler()->getCurrentJsException();
   }
 
-  return result;
-};
+  callTrace.beginPhase(CallTracer::Phase::Conversion);
+  bool isDeferred = awaitJsPromise && duk_is_object(ctx, -1) && duk_has_prop_literal(ctx, -1, "then");
+  return isDeferred ? m_deferredReturnValueType->pop() : m_returnValueType->pop();
+}
 
 #elif defined(QUICKJS)
 
@@ -164,7 +309,11 @@ JValue JavaScriptMethod::invoke(const JsBridgeContext *jsBridgeContext, void *js
 JValue JavaScriptMethod::invoke(const JsBridgeContext *jsBridgeContext, JSValueConst jsMethod, JSValueConst jsThis, const JObjectArrayLocalRef &javaArgs, bool awaitJsPromise) const {
   JSContext *ctx = jsBridgeContext->getQuickJsContext();
 
+  CallTrace callTrace(jsBridgeContext->getCallTracer(), m_traceName.c_str());
+  callTrace.beginPhase(CallTracer::Phase::Conversion);
+
   int numJavaArguments = javaArgs.isNull() ? 0 : (int) javaArgs.getLength();
+  int numFixedArguments = m_isVarArgs ? numJavaArguments - 1 : numJavaArguments;
   int numJsArguments = numJavaArguments;
 
   JniLocalRef<jarray> varArgJavaArray;
@@ -178,21 +327,10 @@ JValue JavaScriptMethod::invoke(const JsBridgeContext *jsBridgeContext, JSValueC
 
   JSValue jsArgs[numJsArguments];
 
-  for (jsize i = 0; i < numJsArguments; ++i) {
+  for (int i = 0; i < numFixedArguments; ++i) {
     JValue javaArg(javaArgs.getElement(i));
-    const auto &argumentType = m_argumentTypes[i];
     try {
-      if (m_isVarArgs && i >= numJavaArguments - 1) {
-        // For varargs, convert Java array to JS array and "expand" it to the JS args
-        JSValue varArgJsArray = argumentType->fromJavaArray(varArgJavaArray);
-        for (int j = 0; j < varArgCount; ++j, ++i) {
-          JSValue elementJsValue = JS_GetPropertyUint32(ctx, varArgJsArray, static_cast<uint32_t>(j));
-          jsArgs[i] = elementJsValue;
-        }
-        JS_FreeValue(ctx, varArgJsArray);
-        break;
-      }
-      jsArgs[i] = argumentType->fromJava(javaArg);
+      jsArgs[i] = m_argumentTypes[i]->fromJava(javaArg);
     } catch (const std::exception &) {
       // Free all the JSValue instances which had been added until now
       for (int j = 0; j < i; ++j) {
@@ -202,10 +340,56 @@ JValue JavaScriptMethod::invoke(const JsBridgeContext *jsBridgeContext, JSValueC
     }
   }
 
-  JSValue ret = JS_Call(ctx, jsMethod, jsThis, numJsArguments, jsArgs);
+  if (m_isVarArgs) {
+    // For varargs, directly convert the Java array elements to the "expanded" JS args
+    try {
+      m_argumentTypes.back()->fromJavaArray(varArgJavaArray, static_cast<uint32_t>(varArgCount), jsArgs + numFixedArguments);
+    } catch (const std::exception &) {
+      for (int j = 0; j < numFixedArguments; ++j) {
+        JS_FreeValue(ctx, jsArgs[j]);
+      }
+      throw;
+    }
+  }
+
+  return callJs(jsBridgeContext, callTrace, jsMethod, jsThis, numJsArguments, jsArgs, awaitJsPromise);
+}
+
+JValue JavaScriptMethod::invoke(const JsBridgeContext *jsBridgeContext, JSValueConst jsMethod, JSValueConst jsThis, const JArrayLocalRef<jlong> &packedArgs, bool awaitJsPromise) const {
+  JSContext *ctx = jsBridgeContext->getQuickJsContext();
+
+  const auto numArguments = static_cast<size_t>(packedArgs.getLength());
+  if (!m_hasPackableArguments || numArguments != m_argumentTypes.size()) {
+    throw std::invalid_argument("Cannot call JS method " + m_methodName + " with packed arguments");
+  }
+
+  CallTrace callTrace(jsBridgeContext->getCallTracer(), m_traceName.c_str());
+  callTrace.beginPhase(CallTracer::Phase::Conversion);
+
+  // Single JNI call for all the arguments
+  jlong values[numArguments];
+  packedArgs.getRegion(0, static_cast<jsize>(numArguments), values);
+
+  // (primitive values: no JSValue to free in case of exception)
+  JSValue jsArgs[numArguments];
+  for (size_t i = 0; i < numArguments; ++i) {
+    jsArgs[i] = withUnpackedArgument(m_argumentTypes[i]->getTypeId(), values[i], [ctx](auto traits, auto value) {
+      return decltype(traits)::newJsValue(ctx, value);
+    });
+  }
+
+  return callJs(jsBridgeContext, callTrace, jsMethod, jsThis, static_cast<int>(numArguments), jsArgs, awaitJsPromise);
+}
+
+JValue JavaScriptMethod::callJs(const JsBridgeContext *jsBridgeContext, CallTrace &callTrace, JSValueConst jsMethod, JSValueConst jsThis, int numArguments, JSValue *jsArgs, bool awaitJsPromise) const {
+  JSContext *ctx = jsBridgeContext->getQuickJsContext();
+
+  callTrace.beginPhase(CallTracer::Phase::JsExecution);
+  JSValue ret = JS_Call(ctx, jsMethod, jsThis, numArguments, jsArgs);
   JS_AUTORELEASE_VALUE(ctx, ret);
+  callTrace.beginPhase(CallTracer::Phase::Conversion);
 
-  for (jsize i = 0; i < numJsArguments; ++i) {
+  for (int i = 0; i < numArguments; ++i) {
     JS_FreeValue(ctx, jsArgs[i]);
   }
 
@@ -213,12 +397,8 @@ JValue JavaScriptMethod::invoke(const JsBridgeContext *jsBridgeContext, JSValueC
     throw jsBridgeContext->getExceptionHandler()->getCurrentJsException();
   }
 
-  bool isDeferred = awaitJsPromise && JS_IsObject(ret) && jsBridgeContext->getUtils()->hasPropertyStr(ret, "then");
-  if (isDeferred && !m_returnValueType->isDeferred()) {
-    return jsBridgeContext->getJavaTypeProvider().getDeferredType(m_returnValueParameter)->toJava(ret);
-  }
-
-  return m_returnValueType->toJava(ret);
-};
+  bool isDeferred = awaitJsPromise && JS_IsObject(ret) && jsBridgeContext->getUtils()->hasProperty(ret, QuickJsUtils::PropertyName::Then);
+  return isDeferred ? m_deferredReturnValueType->toJava(ret) : m_returnValueType->toJava(ret);
+}
 
 #endif
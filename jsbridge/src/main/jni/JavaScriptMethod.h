@@ -24,14 +24,19 @@
 #include <string>
 #include <vector>
 
-#ifdef QUICKJS
+#if defined(DUKTAPE)
+# include "duktape/duktape.h"
+#elif defined(QUICKJS)
 # include "quickjs/quickjs.h"
 #endif
 
+class CallTrace;
 class JavaType;
 class JsBridgeContext;
 class JObjectArrayLocalRef;
 class JValue;
+class MethodInterface;
+template <typename T> class JArrayLocalRef;
 
 class JavaScriptMethod {
 public:
@@ -47,17 +52,37 @@ public:
 
 #if defined(DUKTAPE)
   JValue invoke(const JsBridgeContext *, void *jsHeapPtr, const JObjectArrayLocalRef &args, bool awaitJsPromise) const;
+  JValue invoke(const JsBridgeContext *, void *jsHeapPtr, const JArrayLocalRef<jlong> &packedArgs, bool awaitJsPromise) const;
 #elif defined(QUICKJS)
   JValue invoke(const JsBridgeContext *, JSValueConst jsMethod, JSValueConst jsThis, const JObjectArrayLocalRef &args, bool awaitJsPromise) const;
+  // Same as above for methods whose arguments are all non-null primitives (see
+  // Method.hasPackableParameters): the arguments are read with a single JNI call. Integers and booleans are given as such and floating-point
+  // values as the raw bits of a double.
+  JValue invoke(const JsBridgeContext *, JSValueConst jsMethod, JSValueConst jsThis, const JArrayLocalRef<jlong> &packedArgs, bool awaitJsPromise) const;
 #endif
 
 private:
+  // Create the types via the (reflected) Parameter instances
+  void createTypes(const JsBridgeContext *, const MethodInterface &);
+
+#if defined(DUKTAPE)
+  // Push the JS lambda or the JS object and the method name and return the index of the former
+  duk_idx_t pushCallee(const JsBridgeContext *, void *jsHeapPtr) const;
+  // Call the pushed callee with the pushed arguments and pop its (converted) return value
+  JValue callJs(const JsBridgeContext *, CallTrace &, duk_idx_t jsLambdaOrObjectIdx, duk_idx_t numArguments, bool awaitJsPromise) const;
+#elif defined(QUICKJS)
+  // Call the JS method and convert its return value (the given arguments are freed)
+  JValue callJs(const JsBridgeContext *, CallTrace &, JSValueConst jsMethod, JSValueConst jsThis, int numArguments, JSValue *jsArgs, bool awaitJsPromise) const;
+#endif
+
   std::string m_methodName;
-  std::unique_ptr<const JavaType> m_returnValueType;
-  JniGlobalRef<jsBridgeParameter> m_returnValueParameter;
-  std::vector<std::unique_ptr<const JavaType>> m_argumentTypes;
+  std::string m_traceName;  // see CallTracer
+  std::shared_ptr<const JavaType> m_returnValueType;
+  std::shared_ptr<const JavaType> m_deferredReturnValueType;  // used when a JS promise is awaited
+  std::vector<std::shared_ptr<const JavaType>> m_argumentTypes;
   bool m_isLambda;
   bool m_isVarArgs;
+  bool m_hasPackableArguments = false;  // see invoke() with packedArgs
 };
 
 #endif
@@ -24,6 +24,7 @@
 #include "JavaType.h"
 #include "JniCache.h"
 #include "JsBridgeContext.h"
+#include "jni-helpers/JArrayLocalRef.h"
 #include "jni-helpers/JniContext.h"
 #include "jni-helpers/JniLocalRef.h"
 #include "jni-helpers/JniLocalFrame.h"
@@ -43,7 +44,6 @@ JavaScriptObject::JavaScriptObject(const JsBridgeContext *jsBridgeContext, std::
  , m_jsBridgeContext(jsBridgeContext) {
 
   duk_context *ctx = jsBridgeContext->getDuktapeContext();
-  const JniContext *jniContext = jsBridgeContext->getJniContext();
   const JniCache *jniCache = jsBridgeContext->getJniCache();
 
   CHECK_STACK(ctx);
@@ -52,7 +52,7 @@ JavaScriptObject::JavaScriptObject(const JsBridgeContext *jsBridgeContext, std::
     throw std::invalid_argument("JavaScript object " + m_name + " cannot be accessed");
   }
 
-  if (duk_has_prop_string(ctx, jsObjectIndex, "then")) {
+  if (duk_has_prop_literal(ctx, jsObjectIndex, "then")) {
     alog_warn("Registering a JS object from a promise... You probably need to call JsValue.await(), first!");
   }
 
@@ -61,6 +61,7 @@ JavaScriptObject::JavaScriptObject(const JsBridgeContext *jsBridgeContext, std::
 
   // Make sure that the object has all of the methods we want and add them
   const jsize numMethods = methods.getLength();
+  m_methods.reserve(numMethods);
   for (jsize i = 0; i < numMethods; ++i) {
     const JniLocalRef<jsBridgeMethod> method = methods.getElement<jsBridgeMethod>(i);
     MethodInterface methodInterface = jniCache->getMethodInterface(method);
@@ -82,13 +83,8 @@ JavaScriptObject::JavaScriptObject(const JsBridgeContext *jsBridgeContext, std::
     }
 
     try {
-      JniLocalRef<jobject> javaMethod = methodInterface.getJavaMethod();
-      jmethodID methodId = jniContext->fromReflectedMethod(javaMethod);
-
       // Build a call wrapper that handles marshalling the arguments and return value.
-      auto jsMethod = new JavaScriptMethod(jsBridgeContext, method, strMethodName, false);
-
-      m_methods.emplace(methodId, std::shared_ptr<JavaScriptMethod>(jsMethod));
+      m_methods.push_back(std::make_shared<JavaScriptMethod>(jsBridgeContext, method, strMethodName, false));
     } catch (const std::invalid_argument &e) {
       duk_pop(ctx);
       throw std::invalid_argument("In proxied method \"" + m_name + "." + strMethodName + "\": " + e.what());
@@ -98,35 +94,33 @@ JavaScriptObject::JavaScriptObject(const JsBridgeContext *jsBridgeContext, std::
   duk_pop(ctx);  // JS object
 }
 
-JValue JavaScriptObject::call(const JniLocalRef<jobject> &javaMethod, const JObjectArrayLocalRef &args, bool awaitJsPromise) const {
+JValue JavaScriptObject::call(jint methodIndex, const JObjectArrayLocalRef &args, bool awaitJsPromise) const {
+  return callMethod(methodIndex, args, awaitJsPromise);
+}
+
+JValue JavaScriptObject::call(jint methodIndex, const JArrayLocalRef<jlong> &packedArgs, bool awaitJsPromise) const {
+  return callMethod(methodIndex, packedArgs, awaitJsPromise);
+}
+
+template <typename Args>
+JValue JavaScriptObject::callMethod(jint methodIndex, const Args &args, bool awaitJsPromise) const {
 
   if (m_jsHeapPtr == nullptr) {
     throw std::invalid_argument("JavaScript object " + m_name + " cannot be accessed");
   }
 
-  const JniContext *jniContext = m_jsBridgeContext->getJniContext();
-  const JniCache *jniCache = m_jsBridgeContext->getJniCache();
-
-  jmethodID methodId = jniContext->fromReflectedMethod(javaMethod);
-
-  auto getMethodName = [&]() -> std::string {
-    return jniCache->getJavaReflectedMethodName(javaMethod).toUtf8Chars();
-  };
+  if (methodIndex < 0 || static_cast<size_t>(methodIndex) >= m_methods.size()) {
+    throw std::invalid_argument("Could not find method #" + std::to_string(methodIndex) + " of " + m_name);
+  }
 
-  //alog("Invoking JS method %s.%s...", m_name.c_str(), getMethodName().c_str());
+  const JavaScriptMethod *jsMethod = m_methods[methodIndex].get();
 
-  const auto methodIt = m_methods.find(methodId);
+  //alog("Invoking JS method %s.%s...", m_name.c_str(), jsMethod->getName().c_str());
 
   try {
-    if (methodIt == m_methods.end()) {
-      throw std::invalid_argument("Could not find method " + m_name + "." + getMethodName());
-    }
-
-    // Method found -> call it
-    const auto &jsMethod = methodIt->second;
     return jsMethod->invoke(m_jsBridgeContext, m_jsHeapPtr, args, awaitJsPromise);
   } catch (const std::runtime_error &e) {
-    std::string strError("Error while calling JS method " + m_name + "." + getMethodName() + ": " + e.what());
+    std::string strError("Error while calling JS method " + m_name + "." + jsMethod->getName() + ": " + e.what());
     throw std::runtime_error(strError);
   }
 }
@@ -137,10 +131,10 @@ JValue JavaScriptObject::call(const JniLocalRef<jobject> &javaMethod, const JObj
 
 JavaScriptObject::JavaScriptObject(const JsBridgeContext *jsBridgeContext, std::string strName, JSValueConst jsObjectValue, const JObjectArrayLocalRef &methods, bool check)
  : m_name(std::move(strName))
- , m_jsBridgeContext(jsBridgeContext) {
+ , m_jsBridgeContext(jsBridgeContext)
+ , m_runtime(JS_GetRuntime(jsBridgeContext->getQuickJsContext())) {
 
   JSContext *ctx = jsBridgeContext->getQuickJsContext();
-  const JniContext *jniContext = jsBridgeContext->getJniContext();
   const JniCache *jniCache = jsBridgeContext->getJniCache();
   const QuickJsUtils *utils = jsBridgeContext->getUtils();
 
@@ -149,12 +143,14 @@ JavaScriptObject::JavaScriptObject(const JsBridgeContext *jsBridgeContext, std::
   }
 
   // Check that it is not a promise!
-  if (utils->hasPropertyStr(jsObjectValue, "then")) {
+  if (utils->hasProperty(jsObjectValue, QuickJsUtils::PropertyName::Then)) {
     alog_warn("Attempting to register a JS promise (%s)... JsValue.await() should probably be called, first...");
   }
 
   // Make sure that the object has all of the methods we want and add them
   const jsize numMethods = methods.getLength();
+  m_methods.reserve(numMethods);
+  m_methodAtoms.reserve(numMethods);
   for (jsize i = 0; i < numMethods; ++i) {
     JniLocalRef<jsBridgeMethod > method = methods.getElement<jsBridgeMethod>(i);
     MethodInterface methodInterface = jniCache->getMethodInterface(method);
@@ -174,46 +170,53 @@ JavaScriptObject::JavaScriptObject(const JsBridgeContext *jsBridgeContext, std::
     }
 
     try {
-      JniLocalRef<jobject> javaMethod = methodInterface.getJavaMethod();
-      jmethodID methodId = jniContext->fromReflectedMethod(javaMethod);
-
       // Build a call wrapper that handles marshalling the arguments and return value.
-      auto jsMethod = new JavaScriptMethod(jsBridgeContext, method, strMethodName, false);
-      m_methods.emplace(methodId, std::shared_ptr<JavaScriptMethod>(jsMethod));
+      m_methods.push_back(std::make_shared<JavaScriptMethod>(jsBridgeContext, method, strMethodName, false));
+      m_methodAtoms.push_back(JS_NewAtomLen(ctx, strMethodName.c_str(), strMethodName.size()));
     } catch (const std::exception &e) {
       m_methods.clear();
+      for (JSAtom atom : m_methodAtoms) {
+        JS_FreeAtomRT(m_runtime, atom);
+      }
+      m_methodAtoms.clear();
       throw std::invalid_argument("In proxied method \"" + m_name + "." + strMethodName + "\": " + e.what());
     }
   }
 }
 
-JValue JavaScriptObject::call(JSValueConst jsObjectValue, const JniLocalRef<jobject> &javaMethod, const JObjectArrayLocalRef &args, bool awaitJsPromise) const {
-
-  JSContext *ctx = m_jsBridgeContext->getQuickJsContext();
-  const JniContext *jniContext = m_jsBridgeContext->getJniContext();
-  const JniCache *jniCache = m_jsBridgeContext->getJniCache();
+JavaScriptObject::~JavaScriptObject() {
+  for (JSAtom atom : m_methodAtoms) {
+    JS_FreeAtomRT(m_runtime, atom);
+  }
+}
 
-  jmethodID methodId = jniContext->fromReflectedMethod(javaMethod);
+JValue JavaScriptObject::call(JSValueConst jsObjectValue, jint methodIndex, const JObjectArrayLocalRef &args, bool awaitJsPromise) const {
+  return callMethod(jsObjectValue, methodIndex, args, awaitJsPromise);
+}
 
-  auto getMethodName = [&]() -> std::string {
-    return jniCache->getJavaReflectedMethodName(javaMethod).toUtf8Chars();
-  };
+JValue JavaScriptObject::call(JSValueConst jsObjectValue, jint methodIndex, const JArrayLocalRef<jlong> &packedArgs, bool awaitJsPromise) const {
+  return callMethod(jsObjectValue, methodIndex, packedArgs, awaitJsPromise);
+}
 
-  //alog("Invoking JS method %s.%s...", m_name.c_str(), getMethodName().c_str());
+template <typename Args>
+JValue JavaScriptObject::callMethod(JSValueConst jsObjectValue, jint methodIndex, const Args &args, bool awaitJsPromise) const {
 
-  const auto methodIt = m_methods.find(methodId);
+  JSContext *ctx = m_jsBridgeContext->getQuickJsContext();
 
-  if (methodIt == m_methods.end()) {
-    throw std::runtime_error("Could not find method " + m_name + "." + getMethodName());
+  if (methodIndex < 0 || static_cast<size_t>(methodIndex) >= m_methods.size()) {
+    throw std::runtime_error("Could not find method #" + std::to_string(methodIndex) + " of " + m_name);
   }
 
-  const JavaScriptMethod *jsMethod = methodIt->second.get();
+  const JavaScriptMethod *jsMethod = m_methods[methodIndex].get();
+
+  //alog("Invoking JS method %s.%s...", m_name.c_str(), jsMethod->getName().c_str());
 
   if (!JS_IsObject(jsObjectValue) || JS_IsNull(jsObjectValue)) {
     throw std::invalid_argument("Cannot call " + m_name + ". It does not exist or is not a valid object.");
   }
 
-  JSValue jsMethodValue = JS_GetPropertyStr(ctx, jsObjectValue, jsMethod->getName().c_str());
+  // The method is still looked up on each call (it can be replaced from JS) but via its atom
+  JSValue jsMethodValue = JS_GetProperty(ctx, jsObjectValue, m_methodAtoms[methodIndex]);
   JS_AUTORELEASE_VALUE(ctx, jsMethodValue);
 
   //if (!JS_IsFunction(ctx, jsMethodValue)) {
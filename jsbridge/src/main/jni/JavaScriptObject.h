@@ -23,8 +23,9 @@
 #include "jni-helpers/JValue.h"
 #include "jni-helpers/JniLocalRef.h"
 #include <functional>
+#include <memory>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 #if defined(DUKTAPE)
 # include "duktape/duktape.h"
@@ -35,23 +36,29 @@
 class JsBridgeContext;
 class JavaScriptMethod;
 class JObjectArrayLocalRef;
+template <typename T> class JArrayLocalRef;
 
 // A wrapper to a JS object and its methods.
 //
 // It contains the whole information (mostly: methods with parameter and Java types) needed to call
 // the object methods from Java.
+//
+// The methods are identified by their index in the array given on registration, so that a call
+// does not need to resolve the reflected Java method.
 class JavaScriptObject {
 public:
-  typedef std::unordered_map<jmethodID, std::shared_ptr<JavaScriptMethod>> MethodMap;
-
 #if defined(DUKTAPE)
   JavaScriptObject(const JsBridgeContext *, std::string strName, duk_idx_t jsObjectIndex, const JObjectArrayLocalRef &methods, bool check);
 
-  JValue call(const JniLocalRef<jobject> &javaMethod, const JObjectArrayLocalRef &args, bool awaitJsPromise) const;
+  JValue call(jint methodIndex, const JObjectArrayLocalRef &args, bool awaitJsPromise) const;
+  JValue call(jint methodIndex, const JArrayLocalRef<jlong> &packedArgs, bool awaitJsPromise) const;
 #elif defined(QUICKJS)
   JavaScriptObject(const JsBridgeContext *, std::string strName, JSValueConst jsObjectValue, const JObjectArrayLocalRef &methods, bool check);
+  ~JavaScriptObject();
 
-  JValue call(JSValueConst jsObjectValue, const JniLocalRef<jobject> &javaMethod, const JObjectArrayLocalRef &args, bool awaitJsPromise) const;
+  JValue call(JSValueConst jsObjectValue, jint methodIndex, const JObjectArrayLocalRef &args, bool awaitJsPromise) const;
+  // (packedArgs: see JavaScriptMethod::invoke())
+  JValue call(JSValueConst jsObjectValue, jint methodIndex, const JArrayLocalRef<jlong> &packedArgs, bool awaitJsPromise) const;
 #endif
 
   JavaScriptObject() = delete;
@@ -59,12 +66,26 @@ public:
   JavaScriptObject& operator=(const JavaScriptObject &) = delete;
 
 private:
+  // Common implementation of call() for the given argument carrier
+#if defined(DUKTAPE)
+  template <typename Args>
+  JValue callMethod(jint methodIndex, const Args &args, bool awaitJsPromise) const;
+#elif defined(QUICKJS)
+  template <typename Args>
+  JValue callMethod(JSValueConst jsObjectValue, jint methodIndex, const Args &args, bool awaitJsPromise) const;
+#endif
+
   const std::string m_name;
   const JsBridgeContext *m_jsBridgeContext;
-  MethodMap m_methods;
+  std::vector<std::shared_ptr<JavaScriptMethod>> m_methods;
 
 #if defined(DUKTAPE)
   void *m_jsHeapPtr = nullptr;
+#elif defined(QUICKJS)
+  // Interned method names (same indices as m_methods), released with the runtime because the
+  // object may be finalized while the context is being freed
+  std::vector<JSAtom> m_methodAtoms;
+  JSRuntime *m_runtime;
 #endif
 };
 
@@ -31,6 +31,7 @@
 #include "jni-helpers/JObjectArrayLocalRef.h"
 #include "jni-helpers/JStringLocalRef.h"
 #include "jni-helpers/JValue.h"
+#include "jni-helpers/JniLocalFrame.h"
 #include "jni-helpers/JniLocalRef.h"
 #include "log.h"
 #include <string>
@@ -53,6 +54,22 @@ JniLocalRef<jclass> JavaType::getJavaClass() const {
  return m_jsBridgeContext->getJniCache()->getJavaClass(m_id) ;
 }
 
+JsToJavaConversion JavaType::getJsToJavaConversion() const {
+#if defined(DUKTAPE)
+  return { this, [](const JavaType *type) { return type->pop(); } };
+#elif defined(QUICKJS)
+  return { this, [](const JavaType *type, JSValueConst v) { return type->toJava(v); } };
+#endif
+}
+
+JavaToJsConversion JavaType::getJavaToJsConversion() const {
+#if defined(DUKTAPE)
+  return { this, [](const JavaType *type, const JValue &value) { return type->push(value); } };
+#elif defined(QUICKJS)
+  return { this, [](const JavaType *type, const JValue &value) { return type->fromJava(value); } };
+#endif
+}
+
 #if defined(DUKTAPE)
 
 #include "StackChecker.h"
@@ -68,11 +85,14 @@ JValue JavaType::popArray(uint32_t count, bool expanded) const {
   throw JniException(m_jniContext);
  }
 
+ const JsToJavaConversion elementConversion = getJsToJavaConversion();
+ JniChunkedLocalFrame localFrame(m_jniContext, count);
  for (int i = (int) count - 1; i >= 0; --i) {
+  localFrame.next();
   if (!expanded) {
     duk_get_prop_index(m_ctx, -1, static_cast<duk_uarridx_t>(i));
   }
-  JValue elementValue = pop();
+  JValue elementValue = elementConversion.pop();
   const JniLocalRef<jobject> &jElement = elementValue.getLocalRef();
   objectArray.setElement(i, jElement);
 
@@ -99,10 +119,13 @@ duk_ret_t JavaType::pushArray(const JniLocalRef<jarray>& values, bool expand) co
   duk_push_array(m_ctx);
  }
 
+ const JavaToJsConversion elementConversion = getJavaToJsConversion();
+ JniChunkedLocalFrame localFrame(m_jniContext, count);
  for (jsize i = 0; i < count; ++i) {
+  localFrame.next();
   JniLocalRef<jobject> object = objectArray.getElement(i);
   try {
-   push(JValue(object));
+   elementConversion.push(JValue(object));
    if (!expand) {
      duk_put_prop_index(m_ctx, -2, static_cast<duk_uarridx_t>(i));
    }
@@ -117,14 +140,16 @@ duk_ret_t JavaType::pushArray(const JniLocalRef<jarray>& values, bool expand) co
 
 #elif defined(QUICKJS)
 
+#include "ExceptionHandler.h"
 #include "QuickJsUtils.h"
+#include "exceptions/JsException.h"
 
 JValue JavaType::toJavaArray(JSValueConst jsValue) const {
   if (JS_IsNull(jsValue) || JS_IsUndefined(jsValue)) {
     return JValue();
   }
 
-  JSValue lengthValue = JS_GetPropertyStr(m_ctx, jsValue, "length");
+  JSValue lengthValue = getUtils()->getProperty(jsValue, QuickJsUtils::PropertyName::Length);
   assert(JS_IsNumber(lengthValue));
   uint32_t count = JS_VALUE_GET_INT(lengthValue);
   JS_FreeValue(m_ctx, lengthValue);
@@ -135,9 +160,12 @@ JValue JavaType::toJavaArray(JSValueConst jsValue) const {
   }
 
   assert(JS_IsArray(m_ctx, jsValue));
+  const JsToJavaConversion elementConversion = getJsToJavaConversion();
+  JniChunkedLocalFrame localFrame(m_jniContext, count);
   for (uint32_t i = 0; i < count; ++i) {
+    localFrame.next();
     JSValue elementJsValue = JS_GetPropertyUint32(m_ctx, jsValue, i);
-    JValue elementJavaValue = toJava(elementJsValue);
+    JValue elementJavaValue = elementConversion.toJava(elementJsValue);
     JS_FreeValue(m_ctx, elementJsValue);
     const JniLocalRef<jobject> &jElement = elementJavaValue.getLocalRef();
     objectArray.setElement((jsize) i, jElement);
@@ -150,34 +178,70 @@ JValue JavaType::toJavaArray(JSValueConst jsValue) const {
   return JValue(objectArray);
 }
 
+JValue JavaType::toJavaArray(uint32_t count, JSValueConst *values) const {
+  JObjectArrayLocalRef objectArray(m_jniContext, (jsize) count, getJavaClass());
+  if (objectArray.isNull()) {
+    throw JniException(m_jniContext);
+  }
+
+  const JsToJavaConversion elementConversion = getJsToJavaConversion();
+  JniChunkedLocalFrame localFrame(m_jniContext, count);
+  for (uint32_t i = 0; i < count; ++i) {
+    localFrame.next();
+    JValue elementJavaValue = elementConversion.toJava(values[i]);
+    const JniLocalRef<jobject> &jElement = elementJavaValue.getLocalRef();
+    objectArray.setElement((jsize) i, jElement);
+
+    if (m_jniContext->exceptionCheck()) {
+      throw JniException(m_jniContext);
+    }
+  }
+
+  return JValue(objectArray);
+}
+
 JSValue JavaType::fromJavaArray(const JniLocalRef<jarray>& values) const {
   JObjectArrayLocalRef objectArray(values.staticCast<jobjectArray>());
   const auto size = objectArray.getLength();
 
-  JSValue jsArray = JS_NewArray(m_ctx);
+  // Convert all the elements first so that the JS array is allocated at once
+  std::vector<JSValue> elementValues(static_cast<size_t>(size));
+  fromJavaArray(values, static_cast<uint32_t>(size), elementValues.data());
 
-  for (jsize i = 0; i < size; ++i) {
-    JniLocalRef<jobject> object = objectArray.getElement(i);
+  JSValue jsArray = JS_NewArrayFrom(m_ctx, static_cast<uint32_t>(size), elementValues.data());
+  if (JS_IsException(jsArray)) {
+    throw getExceptionHandler()->getCurrentJsException();
+  }
+  return jsArray;
+}
+
+void JavaType::fromJavaArray(const JniLocalRef<jarray> &values, uint32_t count, JSValue *jsValues) const {
+  JObjectArrayLocalRef objectArray(values.staticCast<jobjectArray>());
+
+  const JavaToJsConversion elementConversion = getJavaToJsConversion();
+  JniChunkedLocalFrame localFrame(m_jniContext, count);
+  for (uint32_t i = 0; i < count; ++i) {
+    localFrame.next();
+    JniLocalRef<jobject> object = objectArray.getElement((jsize) i);
     try {
-      JSValue elementValue = fromJava(JValue(object));
-      JS_SetPropertyUint32(m_ctx, jsArray, static_cast<uint32_t>(i), elementValue);
+      jsValues[i] = elementConversion.fromJava(JValue(object));
     } catch (const std::exception &) {
-      JS_FreeValue(m_ctx, jsArray);
+      for (uint32_t j = 0; j < i; ++j) {
+        JS_FreeValue(m_ctx, jsValues[j]);
+      }
       throw;
     }
   }
-
-  return jsArray;
 }
 
 #endif
 
-JValue JavaType::callMethod(jmethodID methodId, const JniRef<jobject> &javaThis, const std::vector<JValue> &args) const {
+JValue JavaType::callMethod(jmethodID methodId, const JniRef<jobject> &javaThis, const JValueArgs &args) const {
 
  JniLocalRef<jobject> returnValue = m_jniContext->callObjectMethodA(javaThis, methodId, args);
 
  // Release all values now because they won't be used afterwards
- JValue::releaseAll(args);
+ args.releaseAll();
 
  if (m_jniContext->exceptionCheck()) {
    throw JniException(m_jniContext);
@@ -19,11 +19,13 @@
 #ifndef _JSBRIDGE_JAVATYPE_H
 #define _JSBRIDGE_JAVATYPE_H
 
+#include "ConversionStats.h"
 #include "JavaTypeId.h"
 #include "JniTypes.h"
 #include "JsBridgeContext.h"
 #include "jni-helpers/JniGlobalRef.h"
 #include "jni-helpers/JValue.h"
+#include "jni-helpers/JValueArgs.h"
 #include <jni.h>
 #include <map>
 #include <vector>
@@ -34,11 +36,73 @@
 # include "quickjs/quickjs.h"
 #endif
 
+class JavaType;
 class JniCache;
 class JniContext;
 class JValue;
 class JsBridgeContext;
 
+// Conversion of the values of a JavaType via a plain function pointer, stored by value in the
+// (contiguous) signatures of the bound methods (see JavaMethod): each conversion takes 16 bytes so
+// that the conversions of up to 4 arguments fit in one cache line.
+// The default functions call the virtual conversion methods of the type while the primitive types
+// directly convert their values (see directJsToJavaConversion()).
+struct JsToJavaConversion {
+#if defined(DUKTAPE)
+  typedef JValue (*Function)(const JavaType *);
+  JValue pop() const { return function(type); }
+#elif defined(QUICKJS)
+  typedef JValue (*Function)(const JavaType *, JSValueConst);
+  JValue toJava(JSValueConst v) const { return function(type, v); }
+#endif
+
+  const JavaType *type;  // owned by the method
+  Function function;
+};
+
+struct JavaToJsConversion {
+#if defined(DUKTAPE)
+  typedef duk_ret_t (*Function)(const JavaType *, const JValue &);
+  duk_ret_t push(const JValue &value) const { return function(type, value); }
+#elif defined(QUICKJS)
+  typedef JSValue (*Function)(const JavaType *, const JValue &);
+  JSValue fromJava(const JValue &value) const { return function(type, value); }
+#endif
+
+  const JavaType *type;  // owned by the method
+  Function function;
+};
+
+// Conversions of the given JavaType subclass T via qualified (i.e. non-virtual) calls to its own
+// conversion methods, which are inlined in the conversion functions. They are returned by the
+// overrides of getJsToJavaConversion() and getJavaToJsConversion() of the frequently converted
+// types (e.g. the primitive types and String).
+template <class T>
+JsToJavaConversion directJsToJavaConversion(const T *type) {
+#if defined(DUKTAPE)
+  return { type, [](const JavaType *t) { return static_cast<const T *>(t)->T::pop(); } };
+#elif defined(QUICKJS)
+  return { type, [](const JavaType *t, JSValueConst v) { return static_cast<const T *>(t)->T::toJava(v); } };
+#endif
+}
+
+template <class T>
+JavaToJsConversion directJavaToJsConversion(const T *type) {
+#if defined(DUKTAPE)
+  return { type, [](const JavaType *t, const JValue &value) { return static_cast<const T *>(t)->T::push(value); } };
+#elif defined(QUICKJS)
+  return { type, [](const JavaType *t, const JValue &value) { return static_cast<const T *>(t)->T::fromJava(value); } };
+#endif
+}
+
+// Count a conversion of the current JavaType (see ConversionStats), e.g.:
+// JSBRIDGE_COUNT_CONVERSION(JsToJava, byteLength);
+#if defined(JSBRIDGE_CONVERSION_STATS)
+# define JSBRIDGE_COUNT_CONVERSION(direction, byteCount) countConversion(ConversionStats::Direction::direction, byteCount)
+#else
+# define JSBRIDGE_COUNT_CONVERSION(direction, byteCount) ((void) 0)
+#endif
+
 // Represents an instance of a Java class.  Handles getting/settings values of the represented type
 // to/from Duktape/QuickJS with appropriate conversions and boxing/unboxing.
 class JavaType {
@@ -60,14 +124,23 @@ public:
 #elif defined(QUICKJS)
     virtual JValue toJava(JSValueConst) const = 0;
   virtual JValue toJavaArray(JSValueConst) const;
+  // Convert the given (expanded, e.g. varargs) values to a Java array
+  virtual JValue toJavaArray(uint32_t count, JSValueConst *values) const;
 
   virtual JSValue fromJava(const JValue &value) const = 0;
   virtual JSValue fromJavaArray(const JniLocalRef<jarray> &values) const;
+  // Convert the elements of the given Java array to (expanded, e.g. varargs) JS values
+  // Note: in case of exception, no value needs to be freed
+  virtual void fromJavaArray(const JniLocalRef<jarray> &values, uint32_t count, JSValue *jsValues) const;
 #endif
 
-    virtual JValue callMethod(jmethodID, const JniRef<jobject> &javaThis, const std::vector<JValue> &args) const;
+    virtual JValue callMethod(jmethodID, const JniRef<jobject> &javaThis, const JValueArgs &args) const;
+
+    virtual JsToJavaConversion getJsToJavaConversion() const;
+    virtual JavaToJsConversion getJavaToJsConversion() const;
 
     virtual bool isDeferred() const { return false; }
+    virtual bool isPrimitive() const { return false; }
 
 protected:
     explicit JavaType(const JsBridgeContext *, JavaTypeId);
@@ -76,6 +149,12 @@ protected:
     const JniCache *getJniCache() const { return m_jsBridgeContext->getJniCache(); }
     const ExceptionHandler *getExceptionHandler() const { return m_jsBridgeContext->getExceptionHandler(); }
 
+#if defined(JSBRIDGE_CONVERSION_STATS)
+    void countConversion(ConversionStats::Direction direction, size_t byteCount) const {
+      m_jsBridgeContext->getConversionStats()->count(m_id, direction, byteCount);
+    }
+#endif
+
     const JsBridgeContext * const m_jsBridgeContext;
     const JniContext * const m_jniContext;
 
@@ -14,119 +14,232 @@
  * limitations under the License.
  */
 #include "JavaTypeId.h"
-#include "log.h"
-#include <unordered_map>
-#include <algorithm>
+
+#include <array>
+#include <cstdint>
+#include <iterator>
 #include <stdexcept>
 #include <string>
-#include <assert.h>
-
-// map<javaName, JavaTypeId>
-// where javaName: Java name (UTF16) as returned by Java::class.getName(), e.g.: "java.lang.Integer"
-static thread_local std::unordered_map<std::u16string_view, JavaTypeId> sJavaNameToID = {
-  { u"", JavaTypeId::Unknown },
-
-  { u"V", JavaTypeId::Void },
-  { u"java.lang.Void", JavaTypeId::BoxedVoid },
-  { u"kotlin.Unit", JavaTypeId::Unit },
-
-  { u"boolean", JavaTypeId::Boolean },
-  { u"byte", JavaTypeId::Byte },
-  { u"int", JavaTypeId::Int },
-  { u"long", JavaTypeId::Long },
-  { u"short", JavaTypeId::Short },
-  { u"float", JavaTypeId::Float },
-  { u"double", JavaTypeId::Double },
-  { u"void", JavaTypeId::Void },
-
-  { u"java.lang.Boolean", JavaTypeId::BoxedBoolean },
-  { u"java.lang.Byte", JavaTypeId::BoxedByte },
-  { u"java.lang.Integer", JavaTypeId::BoxedInt },
-  { u"java.lang.Long", JavaTypeId::BoxedLong },
-  { u"java.lang.Short", JavaTypeId::BoxedShort },
-  { u"java.lang.Float", JavaTypeId::BoxedFloat },
-  { u"java.lang.Double", JavaTypeId::BoxedDouble },
-
-  { u"java.lang.String", JavaTypeId::String },
-  { u"java.lang.Number", JavaTypeId::Number },
-  { u"java.lang.Object", JavaTypeId::Object },
-
-  { u"[Ljava.lang.Object;", JavaTypeId::ObjectArray },
-  { u"java.util.List", JavaTypeId::List },
-
-  { u"[Z", JavaTypeId::BooleanArray },
-  { u"[B", JavaTypeId::ByteArray },
-  { u"[I", JavaTypeId::IntArray },
-  { u"[J", JavaTypeId::LongArray },
-  { u"[S", JavaTypeId::ShortArray },
-  { u"[F", JavaTypeId::FloatArray },
-  { u"[D", JavaTypeId::DoubleArray },
-
-  { u"kotlin.jvm.functions.Function0", JavaTypeId::FunctionX },
-  { u"kotlin.jvm.functions.Function1", JavaTypeId::FunctionX },
-  { u"kotlin.jvm.functions.Function2", JavaTypeId::FunctionX },
-  { u"kotlin.jvm.functions.Function3", JavaTypeId::FunctionX },
-  { u"kotlin.jvm.functions.Function4", JavaTypeId::FunctionX },
-  { u"kotlin.jvm.functions.Function5", JavaTypeId::FunctionX },
-  { u"kotlin.jvm.functions.Function6", JavaTypeId::FunctionX },
-  { u"kotlin.jvm.functions.Function7", JavaTypeId::FunctionX },
-  { u"kotlin.jvm.functions.Function8", JavaTypeId::FunctionX },
-  { u"kotlin.jvm.functions.Function9", JavaTypeId::FunctionX },
-
-  { u"de.prosiebensat1digital.oasisjsbridge.DebugString", JavaTypeId::DebugString },
-  { u"de.prosiebensat1digital.oasisjsbridge.JsValue", JavaTypeId::JsValue },
-  { u"de.prosiebensat1digital.oasisjsbridge.JsonObjectWrapper", JavaTypeId::JsonObjectWrapper },
-  { u"de.prosiebensat1digital.oasisjsbridge.JavaObjectWrapper", JavaTypeId::JavaObjectWrapper },
-  { u"de.prosiebensat1digital.oasisjsbridge.JsToJavaProxy", JavaTypeId::JsToJavaProxy },
-
-  { u"kotlinx.coroutines.Deferred", JavaTypeId::Deferred }
-};
-
-// map<javaName, JavaTypeId> => map<JavaTypeId, jniClassName>
-// where:
-// - javaName = string_view: Java name (UTF16) as returned by Java::class.getName(), e.g.: "java.lang.Integer"
-// - jniClassName = string: JNI class name (UTF8) as needed by JNIenv::findClass(...), e.g.: "java/lang/Integer"
-static std::unordered_map<JavaTypeId, std::string> createIdToJniClassName() {
-  std::unordered_map<JavaTypeId, std::string> idTojniClassName;
-
-  for (const auto &p : sJavaNameToID) {
-    std::u16string_view javaName = p.first;
-    JavaTypeId id = p.second;
-
-    size_t length = javaName.length();
-    std::string strJniClassName;
-    strJniClassName.reserve(length);
-
-    // Basic UTF16 -> UTF8 conversion + replace '.' into '/'
-    for (char16_t u16char : javaName) {
-      assert(u16char <= 0x7F);  // plain ASCII
-      auto u8char = static_cast<char>(u16char);
-      if (u8char == '.') u8char = '/';
-      strJniClassName += u8char;
+#include <string_view>
+
+namespace {
+  struct JavaNameEntry {
+    std::u16string_view javaName;  // Java name as returned by Java::class.getName(), e.g.: "java.lang.Integer"
+    JavaTypeId id;
+  };
+
+  constexpr JavaNameEntry JAVA_NAMES[] = {
+    { u"V", JavaTypeId::Void },
+    { u"java.lang.Void", JavaTypeId::BoxedVoid },
+    { u"kotlin.Unit", JavaTypeId::Unit },
+
+    { u"boolean", JavaTypeId::Boolean },
+    { u"byte", JavaTypeId::Byte },
+    { u"int", JavaTypeId::Int },
+    { u"long", JavaTypeId::Long },
+    { u"short", JavaTypeId::Short },
+    { u"float", JavaTypeId::Float },
+    { u"double", JavaTypeId::Double },
+    { u"void", JavaTypeId::Void },
+
+    { u"java.lang.Boolean", JavaTypeId::BoxedBoolean },
+    { u"java.lang.Byte", JavaTypeId::BoxedByte },
+    { u"java.lang.Integer", JavaTypeId::BoxedInt },
+    { u"java.lang.Long", JavaTypeId::BoxedLong },
+    { u"java.lang.Short", JavaTypeId::BoxedShort },
+    { u"java.lang.Float", JavaTypeId::BoxedFloat },
+    { u"java.lang.Double", JavaTypeId::BoxedDouble },
+
+    { u"java.lang.String", JavaTypeId::String },
+    { u"java.lang.Number", JavaTypeId::Number },
+    { u"java.lang.Object", JavaTypeId::Object },
+
+    { u"[Ljava.lang.Object;", JavaTypeId::ObjectArray },
+    { u"java.util.List", JavaTypeId::List },
+    { u"java.util.Map", JavaTypeId::Map },
+
+    { u"[Z", JavaTypeId::BooleanArray },
+    { u"[B", JavaTypeId::ByteArray },
+    { u"[I", JavaTypeId::IntArray },
+    { u"[J", JavaTypeId::LongArray },
+    { u"[S", JavaTypeId::ShortArray },
+    { u"[F", JavaTypeId::FloatArray },
+    { u"[D", JavaTypeId::DoubleArray },
+
+    { u"kotlin.jvm.functions.Function0", JavaTypeId::FunctionX },
+    { u"kotlin.jvm.functions.Function1", JavaTypeId::FunctionX },
+    { u"kotlin.jvm.functions.Function2", JavaTypeId::FunctionX },
+    { u"kotlin.jvm.functions.Function3", JavaTypeId::FunctionX },
+    { u"kotlin.jvm.functions.Function4", JavaTypeId::FunctionX },
+    { u"kotlin.jvm.functions.Function5", JavaTypeId::FunctionX },
+    { u"kotlin.jvm.functions.Function6", JavaTypeId::FunctionX },
+    { u"kotlin.jvm.functions.Function7", JavaTypeId::FunctionX },
+    { u"kotlin.jvm.functions.Function8", JavaTypeId::FunctionX },
+    { u"kotlin.jvm.functions.Function9", JavaTypeId::FunctionX },
+
+    { u"de.prosiebensat1digital.oasisjsbridge.DebugString", JavaTypeId::DebugString },
+    { u"de.prosiebensat1digital.oasisjsbridge.JsValue", JavaTypeId::JsValue },
+    { u"de.prosiebensat1digital.oasisjsbridge.JsonObjectWrapper", JavaTypeId::JsonObjectWrapper },
+    { u"de.prosiebensat1digital.oasisjsbridge.JavaObjectWrapper", JavaTypeId::JavaObjectWrapper },
+    { u"de.prosiebensat1digital.oasisjsbridge.JsToJavaProxy", JavaTypeId::JsToJavaProxy },
+    { u"de.prosiebensat1digital.oasisjsbridge.Payload", JavaTypeId::Payload },
+    { u"de.prosiebensat1digital.oasisjsbridge.PayloadObject", JavaTypeId::PayloadObject },
+    { u"de.prosiebensat1digital.oasisjsbridge.PayloadArray", JavaTypeId::PayloadArray },
+    { u"de.prosiebensat1digital.oasisjsbridge.JsObjectView", JavaTypeId::JsObjectView },
+    // (Java name returned by Parameter::getJavaName() for @Serializable classes)
+    { u"de.prosiebensat1digital.oasisjsbridge.SerializableCodec", JavaTypeId::Serializable },
+
+    { u"kotlinx.coroutines.Deferred", JavaTypeId::Deferred }
+  };
+
+  constexpr size_t JAVA_NAME_COUNT = std::size(JAVA_NAMES);
+
+
+  // Perfect hash of the Java names: the seed of the (FNV-1a) hash is picked at compile time so that
+  // each name has its own slot, i.e. a lookup is a single hash + string comparison
+  // ---
+
+  constexpr size_t JAVA_NAME_SLOT_COUNT = 512;
+
+  constexpr uint32_t hashJavaName(std::u16string_view javaName, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (char16_t c : javaName) {
+      hash ^= static_cast<uint32_t>(c);
+      hash *= 16777619u;
     }
+    return hash;
+  }
+
+  struct JavaNameHashTable {
+    uint32_t seed = 0;
+    std::array<uint8_t, JAVA_NAME_SLOT_COUNT> slots {};  // JAVA_NAMES index + 1 (0: empty slot)
+  };
 
-    idTojniClassName[id] = strJniClassName;
+  constexpr JavaNameHashTable createJavaNameHashTable() {
+    for (uint32_t seed = 0; ; ++seed) {
+      JavaNameHashTable table;
+      table.seed = seed;
+
+      bool hasCollision = false;
+      for (size_t i = 0; i < JAVA_NAME_COUNT && !hasCollision; ++i) {
+        uint8_t &slot = table.slots[hashJavaName(JAVA_NAMES[i].javaName, seed) % JAVA_NAME_SLOT_COUNT];
+        hasCollision = slot != 0;
+        slot = static_cast<uint8_t>(i + 1);
+      }
+
+      if (!hasCollision) {
+        return table;
+      }
+    }
   }
 
-  return idTojniClassName;
-}
+  constexpr JavaNameHashTable JAVA_NAME_HASH_TABLE = createJavaNameHashTable();
 
-static std::unordered_map<JavaTypeId, std::string> sIdToJavaName = createIdToJniClassName();
+  constexpr JavaTypeId findJavaTypeId(std::u16string_view javaName) {
+    const uint8_t slot = JAVA_NAME_HASH_TABLE.slots[hashJavaName(javaName, JAVA_NAME_HASH_TABLE.seed) % JAVA_NAME_SLOT_COUNT];
+    if (slot == 0) {
+      return JavaTypeId::Unknown;
+    }
 
-// Get the id from the Java name (UTF16) returned by Java::class.getName(), e.g.: "java.lang.Integer"
-JavaTypeId getJavaTypeIdByJavaName(std::u16string_view javaName) {
-  auto itFind = sJavaNameToID.find(javaName);
-  if (itFind != sJavaNameToID.end()) {
-    return itFind->second;
+    const JavaNameEntry &entry = JAVA_NAMES[slot - 1];
+    return entry.javaName == javaName ? entry.id : JavaTypeId::Unknown;
+  }
+
+  static_assert(findJavaTypeId(u"java.lang.Integer") == JavaTypeId::BoxedInt);
+  static_assert(findJavaTypeId(u"kotlin.jvm.functions.Function9") == JavaTypeId::FunctionX);
+  static_assert(findJavaTypeId(u"java.lang.Integer2") == JavaTypeId::Unknown);
+
+
+  // JNI class names (UTF8) as needed by JNIenv::findClass(...), e.g.: "java/lang/Integer"
+  // ---
+
+  struct JniClassNameEntry {
+    JavaTypeId id;
+    const char *jniClassName;
+  };
+
+  constexpr JniClassNameEntry JNI_CLASS_NAMES[] = {
+    { JavaTypeId::Void, "void" },
+    { JavaTypeId::BoxedVoid, "java/lang/Void" },
+    { JavaTypeId::Unit, "kotlin/Unit" },
+
+    { JavaTypeId::Boolean, "boolean" },
+    { JavaTypeId::Byte, "byte" },
+    { JavaTypeId::Int, "int" },
+    { JavaTypeId::Long, "long" },
+    { JavaTypeId::Short, "short" },
+    { JavaTypeId::Float, "float" },
+    { JavaTypeId::Double, "double" },
+
+    { JavaTypeId::BoxedBoolean, "java/lang/Boolean" },
+    { JavaTypeId::BoxedByte, "java/lang/Byte" },
+    { JavaTypeId::BoxedInt, "java/lang/Integer" },
+    { JavaTypeId::BoxedLong, "java/lang/Long" },
+    { JavaTypeId::BoxedShort, "java/lang/Short" },
+    { JavaTypeId::BoxedFloat, "java/lang/Float" },
+    { JavaTypeId::BoxedDouble, "java/lang/Double" },
+
+    { JavaTypeId::String, "java/lang/String" },
+    { JavaTypeId::Number, "java/lang/Number" },
+    { JavaTypeId::Object, "java/lang/Object" },
+
+    { JavaTypeId::ObjectArray, "[Ljava/lang/Object;" },
+    { JavaTypeId::List, "java/util/List" },
+    { JavaTypeId::Map, "java/util/Map" },
+
+    { JavaTypeId::BooleanArray, "[Z" },
+    { JavaTypeId::ByteArray, "[B" },
+    { JavaTypeId::IntArray, "[I" },
+    { JavaTypeId::LongArray, "[J" },
+    { JavaTypeId::ShortArray, "[S" },
+    { JavaTypeId::FloatArray, "[F" },
+    { JavaTypeId::DoubleArray, "[D" },
+
+    // (common interface of all the FunctionX classes)
+    { JavaTypeId::FunctionX, "kotlin/Function" },
+
+    { JavaTypeId::DebugString, "de/prosiebensat1digital/oasisjsbridge/DebugString" },
+    { JavaTypeId::JsValue, "de/prosiebensat1digital/oasisjsbridge/JsValue" },
+    { JavaTypeId::JsonObjectWrapper, "de/prosiebensat1digital/oasisjsbridge/JsonObjectWrapper" },
+    { JavaTypeId::JavaObjectWrapper, "de/prosiebensat1digital/oasisjsbridge/JavaObjectWrapper" },
+    { JavaTypeId::JsToJavaProxy, "de/prosiebensat1digital/oasisjsbridge/JsToJavaProxy" },
+    { JavaTypeId::Payload, "de/prosiebensat1digital/oasisjsbridge/Payload" },
+    { JavaTypeId::PayloadObject, "de/prosiebensat1digital/oasisjsbridge/PayloadObject" },
+    { JavaTypeId::PayloadArray, "de/prosiebensat1digital/oasisjsbridge/PayloadArray" },
+    { JavaTypeId::JsObjectView, "de/prosiebensat1digital/oasisjsbridge/JsObjectView" },
+    // (codec class which is only loaded when needed)
+    { JavaTypeId::Serializable, "de/prosiebensat1digital/oasisjsbridge/SerializableCodec" },
+
+    { JavaTypeId::Deferred, "kotlinx/coroutines/Deferred" }
+  };
+
+  constexpr size_t JAVA_TYPE_ID_COUNT = static_cast<size_t>(JavaTypeId::Serializable) + 1;
+
+  // JNI class names indexed by JavaTypeId (nullptr: no class)
+  constexpr std::array<const char *, JAVA_TYPE_ID_COUNT> createIdToJniClassName() {
+    std::array<const char *, JAVA_TYPE_ID_COUNT> idToJniClassName {};
+    for (const auto &entry : JNI_CLASS_NAMES) {
+      idToJniClassName[static_cast<size_t>(entry.id)] = entry.jniClassName;
+    }
+    return idToJniClassName;
   }
 
+  constexpr std::array<const char *, JAVA_TYPE_ID_COUNT> ID_TO_JNI_CLASS_NAME = createIdToJniClassName();
+}
+
+// Get the id from the Java name (UTF16) returned by Java::class.getName(), e.g.: "java.lang.Integer"
+JavaTypeId getJavaTypeIdByJavaName(std::u16string_view javaName) {
   if (javaName.empty()) {
     return JavaTypeId::Unknown;
   }
 
+  JavaTypeId id = findJavaTypeId(javaName);
+  if (id != JavaTypeId::Unknown) {
+    return id;
+  }
+
   // ObjectArray
   if (javaName[0] == '[') {
-    sJavaNameToID[javaName] = JavaTypeId::ObjectArray;
     return JavaTypeId::ObjectArray;
   }
 
@@ -134,11 +247,12 @@ JavaTypeId getJavaTypeIdByJavaName(std::u16string_view javaName) {
 }
 
 // Returns the JNI class name (UTF8) needed by JNIenv::findClass(...), e.g.: "java/lang/Integer"
-const std::string &getJniClassNameByJavaTypeId(JavaTypeId id) {
-  auto it = sIdToJavaName.find(id);
-  if (it == sIdToJavaName.end()) {
+const char *getJniClassNameByJavaTypeId(JavaTypeId id) {
+  const auto index = static_cast<size_t>(id);
+  const char *jniClassName = index < ID_TO_JNI_CLASS_NAME.size() ? ID_TO_JNI_CLASS_NAME[index] : nullptr;
+  if (jniClassName == nullptr) {
     throw std::invalid_argument(std::string() + "Could not get Java name for JavaTypeId " + std::to_string(static_cast<int>(id)) + "!");
   }
 
-  return it->second;
+  return jniClassName;
 }
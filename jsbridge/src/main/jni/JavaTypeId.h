@@ -47,6 +47,7 @@ enum class JavaTypeId {
 
   ObjectArray = 50,
   List = 51,
+  Map = 52,  // java.util.Map with string keys
 
   BooleanArray = 60,
   ByteArray = 61,
@@ -63,9 +64,14 @@ enum class JavaTypeId {
   Deferred = 103,
   JavaObjectWrapper = 104,
   JsToJavaProxy = 105,
+  Payload = 106,
+  PayloadObject = 107,
+  PayloadArray = 108,
+  JsObjectView = 109,
+  Serializable = 110,  // kotlinx.serialization @Serializable classes (last id)
 };
 
 JavaTypeId getJavaTypeIdByJavaName(std::u16string_view javaName);
-const std::string &getJniClassNameByJavaTypeId(JavaTypeId id);
+const char *getJniClassNameByJavaTypeId(JavaTypeId id);
 
 #endif
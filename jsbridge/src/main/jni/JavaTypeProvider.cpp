@@ -32,7 +32,10 @@
 #include "java-types/JsonObjectWrapper.h"
 #include "java-types/List.h"
 #include "java-types/Long.h"
+#include "java-types/Map.h"
 #include "java-types/Object.h"
+#include "java-types/Payload.h"
+#include "java-types/Serializable.h"
 #include "java-types/Short.h"
 #include "java-types/String.h"
 #include "java-types/Void.h"
@@ -120,6 +123,10 @@ const JavaType *JavaTypeProvider::newType(const JniRef<jsBridgeParameter> &param
       auto genericParameterType = getGenericParameterType(parameter);
       return new List(m_jsBridgeContext, std::move(genericParameterType));
     }
+    case JavaTypeId::Map: {
+      auto genericParameterType = getGenericParameterType(parameter);
+      return new Map(m_jsBridgeContext, std::move(genericParameterType));
+    }
     case JavaTypeId::BooleanArray:
       return createPrimitiveArray<Boolean>(m_jsBridgeContext);
     case JavaTypeId::ByteArray:
@@ -138,7 +145,8 @@ const JavaType *JavaTypeProvider::newType(const JniRef<jsBridgeParameter> &param
     case JavaTypeId::FunctionX:
       return new FunctionX(m_jsBridgeContext, parameter);
     case JavaTypeId::JsValue:
-      return new JsValue(m_jsBridgeContext, isParameterNullable(parameter));
+    case JavaTypeId::JsObjectView:
+      return new JsValue(m_jsBridgeContext, id, isParameterNullable(parameter));
     case JavaTypeId::JsonObjectWrapper:
       return new JsonObjectWrapper(m_jsBridgeContext, isParameterNullable(parameter));
     case JavaTypeId::Deferred:
@@ -147,18 +155,100 @@ const JavaType *JavaTypeProvider::newType(const JniRef<jsBridgeParameter> &param
       return new JavaObjectWrapper(m_jsBridgeContext);
     case JavaTypeId::JsToJavaProxy:
       return new JsToJavaProxy(m_jsBridgeContext);
+    case JavaTypeId::Payload:
+    case JavaTypeId::PayloadObject:
+    case JavaTypeId::PayloadArray:
+      return new Payload(m_jsBridgeContext, id, isParameterNullable(parameter));
+    case JavaTypeId::Serializable: {
+      JniLocalRef<jclass> serializableClass = m_jsBridgeContext->getJniCache()->getParameterInterface(parameter).getJava();
+      return new Serializable(m_jsBridgeContext, serializableClass, isParameterNullable(parameter));
+    }
 
     case JavaTypeId::Unknown:
       return nullptr;
   }
 }
 
-std::unique_ptr<const JavaType> JavaTypeProvider::makeUniqueType(const JniRef<jsBridgeParameter> &parameter, bool boxed) const {
-  const JavaType *t = newType(parameter, boxed);
-  return t ? std::unique_ptr<const JavaType>(t) : std::unique_ptr<const JavaType>();
+std::shared_ptr<const JavaType> JavaTypeProvider::getType(const JniRef<jsBridgeParameter> &parameter, bool boxed) const {
+  if (parameter.isNull()) {
+    return getObjectType();
+  }
+
+  // Single JNI call instead of walking through the whole (generic) parameter type
+  JStringLocalRef typeSignature = m_jsBridgeContext->getJniCache()->getParameterInterface(parameter).getTypeSignature();
+  if (typeSignature.isNull()) {
+    // The type cannot be shared (e.g. lambda)
+    return std::shared_ptr<const JavaType>(newType(parameter, boxed));
+  }
+
+  std::string key = typeSignature.toStdString();
+  if (boxed) {
+    key += '!';
+  }
+
+  auto it = m_sharedTypes.find(key);
+  if (it != m_sharedTypes.end()) {
+    return it->second;
+  }
+
+  std::shared_ptr<const JavaType> type(newType(parameter, boxed));
+  m_sharedTypes.emplace(std::move(key), type);
+  return type;
 }
 
-const std::unique_ptr<const JavaType> &JavaTypeProvider::getObjectType() const {
+JavaTypeProvider::MethodSignatures JavaTypeProvider::getMethodSignatures(const JniRef<jsBridgeMethod> &method) const {
+  JStringLocalRef jTypeSignatures = m_jsBridgeContext->getJniCache()->getMethodInterface(method).getTypeSignatures();
+  if (jTypeSignatures.isNull()) {
+    throw std::invalid_argument("Could not get type signatures from Method!");
+  }
+
+  // "<varargs flag><return signature>\n<parameter 1 signature>\n..."
+  const std::string typeSignatures = jTypeSignatures.toStdString();
+  jTypeSignatures.release();
+
+  MethodSignatures signatures;
+  signatures.isVarArgs = !typeSignatures.empty() && typeSignatures[0] == '1';
+
+  size_t start = 1;
+  size_t end = typeSignatures.find('\n', start);
+  signatures.returnType = typeSignatures.substr(start, end - start);
+
+  while (end != std::string::npos) {
+    start = end + 1;
+    end = typeSignatures.find('\n', start);
+    signatures.parameterTypes.emplace_back(typeSignatures.substr(start, end - start));
+  }
+
+  return signatures;
+}
+
+std::shared_ptr<const JavaType> JavaTypeProvider::findSharedType(const std::string &typeSignature, bool boxed) const {
+  if (typeSignature.empty()) {
+    return nullptr;
+  }
+
+  auto it = m_sharedTypes.find(boxed ? typeSignature + '!' : typeSignature);
+  return it != m_sharedTypes.end() ? it->second : nullptr;
+}
+
+bool JavaTypeProvider::findSharedTypes(const std::vector<std::string> &typeSignatures, bool boxed,
+                                       std::vector<std::shared_ptr<const JavaType>> *pTypes) const {
+  std::vector<std::shared_ptr<const JavaType>> types;
+  types.reserve(typeSignatures.size());
+
+  for (const auto &typeSignature : typeSignatures) {
+    auto type = findSharedType(typeSignature, boxed);
+    if (type == nullptr) {
+      return false;
+    }
+    types.emplace_back(std::move(type));
+  }
+
+  *pTypes = std::move(types);
+  return true;
+}
+
+const std::shared_ptr<const JavaType> &JavaTypeProvider::getObjectType() const {
   if (m_objectType == nullptr)   {
     m_objectType.reset(new Object(m_jsBridgeContext, std::nullopt));
   }
@@ -166,8 +256,97 @@ const std::unique_ptr<const JavaType> &JavaTypeProvider::getObjectType() const {
   return m_objectType;
 }
 
-std::unique_ptr<const JavaType> JavaTypeProvider::getDeferredType(const JniRef<jsBridgeParameter> &parameter) const {
-  return std::make_unique<Deferred>(m_jsBridgeContext, makeUniqueType(parameter, true /*boxed*/));
+std::shared_ptr<const JavaType> JavaTypeProvider::getScalarType(JavaTypeId id) const {
+  // Same key as the types created from a non-null Parameter (see Parameter.typeSignature)
+  const char *typeSignature;
+  switch (id) {
+    case JavaTypeId::Boolean:
+      typeSignature = "boolean";
+      break;
+    case JavaTypeId::Int:
+      typeSignature = "int";
+      break;
+    case JavaTypeId::Double:
+      typeSignature = "double";
+      break;
+    case JavaTypeId::String:
+      typeSignature = "java.lang.String";
+      break;
+    default:
+      throw std::invalid_argument("Unsupported scalar JavaTypeId " + std::to_string(static_cast<int>(id)) + "!");
+  }
+
+  auto it = m_sharedTypes.find(typeSignature);
+  if (it != m_sharedTypes.end()) {
+    return it->second;
+  }
+
+  std::shared_ptr<const JavaType> type;
+  switch (id) {
+    case JavaTypeId::Boolean:
+      type.reset(new Boolean(m_jsBridgeContext));
+      break;
+    case JavaTypeId::Int:
+      type.reset(new Integer(m_jsBridgeContext));
+      break;
+    case JavaTypeId::Double:
+      type.reset(new Double(m_jsBridgeContext));
+      break;
+    default:
+      type.reset(new String(m_jsBridgeContext, false));
+      break;
+  }
+
+  m_sharedTypes.emplace(typeSignature, type);
+  return type;
+}
+
+std::shared_ptr<const JavaType> JavaTypeProvider::getDeferredType(const JniRef<jsBridgeParameter> &parameter) const {
+  std::string typeSignature = "java.lang.Object";
+  if (!parameter.isNull()) {
+    JStringLocalRef jTypeSignature = m_jsBridgeContext->getJniCache()->getParameterInterface(parameter).getTypeSignature();
+    if (jTypeSignature.isNull()) {
+      // The type cannot be shared (e.g. lambda)
+      return std::make_shared<Deferred>(m_jsBridgeContext, getType(parameter, true /*boxed*/));
+    }
+    typeSignature = jTypeSignature.toStdString();
+  }
+
+  std::string key = "kotlinx.coroutines.Deferred<" + typeSignature + ">!";
+
+  auto it = m_sharedTypes.find(key);
+  if (it != m_sharedTypes.end()) {
+    return it->second;
+  }
+
+  auto deferredType = std::make_shared<Deferred>(m_jsBridgeContext, getType(parameter, true /*boxed*/));
+  m_sharedTypes.emplace(std::move(key), deferredType);
+  return deferredType;
+}
+
+bool JavaTypeProvider::findClassType(const JniRef<jclass> &javaClass, std::shared_ptr<const JavaType> *pType) const {
+  const JniContext *jniContext = m_jsBridgeContext->getJniContext();
+
+  for (const auto &entry : m_classTypes) {
+    if (jniContext->isSameObject(entry.first, javaClass)) {
+      *pType = entry.second;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void JavaTypeProvider::addClassType(const JniLocalRef<jclass> &javaClass, std::shared_ptr<const JavaType> type) const {
+  JniGlobalRef<jclass> javaClassGlobal(javaClass);
+
+  if (m_classTypes.size() < CLASS_TYPE_CACHE_SIZE) {
+    m_classTypes.emplace_back(std::move(javaClassGlobal), std::move(type));
+    return;
+  }
+
+  m_classTypes[m_nextClassTypeIndex] = std::make_pair(std::move(javaClassGlobal), std::move(type));
+  m_nextClassTypeIndex = (m_nextClassTypeIndex + 1) % CLASS_TYPE_CACHE_SIZE;
 }
 
 
@@ -201,7 +380,12 @@ JniLocalRef<jsBridgeParameter> JavaTypeProvider::getGenericParameter(const JniRe
   return m_jsBridgeContext->getJniCache()->getParameterInterface(parameter).getGenericParameter();
 }
 
-std::unique_ptr<const JavaType> JavaTypeProvider::getGenericParameterType(const JniRef<jsBridgeParameter> &parameter) const {
-  return makeUniqueType(getGenericParameter(parameter), true /*boxed*/);
+std::shared_ptr<const JavaType> JavaTypeProvider::getGenericParameterType(const JniRef<jsBridgeParameter> &parameter) const {
+  return getType(getGenericParameter(parameter), true /*boxed*/);
 }
 
+void JavaTypeProvider::clearCaches() const {
+  m_sharedTypes.clear();
+  m_classTypes.clear();
+  m_nextClassTypeIndex = 0;
+}
@@ -21,7 +21,10 @@
 #include "jni-helpers/JniGlobalRef.h"
 #include "jni-helpers/JniLocalRef.h"
 #include <memory>
+#include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 class JsBridgeContext;
 class JavaType;
@@ -39,19 +42,61 @@ public:
   JavaTypeProvider(const JavaTypeProvider &) = delete;
   JavaTypeProvider &operator = (const JavaTypeProvider &) = delete;
 
-  const JavaType *newType(const JniRef<jsBridgeParameter> &, bool boxed = false) const;
-  std::unique_ptr<const JavaType> makeUniqueType(const JniRef<jsBridgeParameter> &, bool boxed) const;
+  // Return the JavaType of the given parameter. JavaType instances are immutable so the ones which
+  // are fully defined by the parameter signature (i.e. all but lambdas) are shared by all the
+  // parameters with the same signature.
+  std::shared_ptr<const JavaType> getType(const JniRef<jsBridgeParameter> &, bool boxed) const;
 
-  const std::unique_ptr<const JavaType> &getObjectType() const;
-  std::unique_ptr<const JavaType> getDeferredType(const JniRef<jsBridgeParameter> &) const;
+  // Type signatures of a method (see Method.typeSignatures) read in a single JNI call. An empty
+  // signature means that the type cannot be shared.
+  struct MethodSignatures {
+    bool isVarArgs = false;
+    std::string returnType;
+    std::vector<std::string> parameterTypes;  // element type for vararg parameters
+  };
+  MethodSignatures getMethodSignatures(const JniRef<jsBridgeMethod> &) const;
+
+  // Return the shared type with the given signature without any JNI call, or nullptr if it has
+  // not been created yet (via getType(parameter)) or cannot be shared
+  std::shared_ptr<const JavaType> findSharedType(const std::string &typeSignature, bool boxed) const;
+  // Same for several types: only set the given types when all of them have been found
+  bool findSharedTypes(const std::vector<std::string> &typeSignatures, bool boxed,
+                       std::vector<std::shared_ptr<const JavaType>> *pTypes) const;
+
+  const std::shared_ptr<const JavaType> &getObjectType() const;
+  // Return the (shared, unboxed) type of the given scalar id (Boolean, Int, Double or non-null
+  // String) without any Parameter
+  std::shared_ptr<const JavaType> getScalarType(JavaTypeId) const;
+  // Return the (shared) Deferred type wrapping the type of the given parameter
+  std::shared_ptr<const JavaType> getDeferredType(const JniRef<jsBridgeParameter> &) const;
+
+  // Cache for the types resolved from the Java class of values without static type info (i.e.
+  // given to an Object type). A null type is also cached (value to be wrapped as JavaObjectWrapper).
+  bool findClassType(const JniRef<jclass> &, std::shared_ptr<const JavaType> *) const;
+  void addClassType(const JniLocalRef<jclass> &, std::shared_ptr<const JavaType>) const;
+
+  // Release the cached types (e.g. on memory pressure): the types still in use are kept alive by
+  // their owners and the others are created again when needed
+  void clearCaches() const;
 
 private:
   const JsBridgeContext *m_jsBridgeContext;
+  const JavaType *newType(const JniRef<jsBridgeParameter> &, bool boxed) const;
   JavaTypeId getJavaTypeId(const JniRef<jsBridgeParameter> &) const;
   bool isParameterNullable(const JniRef<jsBridgeParameter> &) const;
   JniLocalRef<jsBridgeParameter> getGenericParameter(const JniRef<jsBridgeParameter> &) const;
-  std::unique_ptr<const JavaType> getGenericParameterType(const JniRef<jsBridgeParameter> &) const;
-  mutable std::unique_ptr<const JavaType> m_objectType;
+  std::shared_ptr<const JavaType> getGenericParameterType(const JniRef<jsBridgeParameter> &) const;
+  mutable std::shared_ptr<const JavaType> m_objectType;
+
+  // Shared JavaType instances by parameter signature (+ "!" suffix for boxed types)
+  // Note: a Deferred type returned by getDeferredType(parameter) is stored as a boxed
+  // "kotlinx.coroutines.Deferred<signature>" so it is shared with Deferred<T> parameters
+  mutable std::unordered_map<std::string, std::shared_ptr<const JavaType>> m_sharedTypes;
+
+  // Small cache with round-robin replacement (the lookup has to compare each entry via JNI)
+  static const size_t CLASS_TYPE_CACHE_SIZE = 32;
+  mutable std::vector<std::pair<JniGlobalRef<jclass>, std::shared_ptr<const JavaType>>> m_classTypes;
+  mutable size_t m_nextClassTypeIndex = 0;
 };
 
 #endif
@@ -18,31 +18,279 @@
 #include "JsBridgeContext.h"
 #include "jni-helpers/JniContext.h"
 #include "log.h"
+#include <mutex>
+
+namespace {
+  namespace JniCacheIds {
+    JniCachedId reflectedMethodGetName(JniCachedId::Kind::Method, "getName", "()Ljava/lang/String;");
+    JniCachedId reflectedMethodGetDeclaringClass(JniCachedId::Kind::Method, "getDeclaringClass", "()Ljava/lang/Class;");
+    JniCachedId jsExceptionInit(JniCachedId::Kind::Method, "<init>", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/Throwable;L" JSBRIDGE_PKG_PATH "/JsValue;)V");
+    JniCachedId debugStringInit(JniCachedId::Kind::Method, "<init>", "(Ljava/lang/String;)V");
+    JniCachedId debugStringGetString(JniCachedId::Kind::Method, "getString", "()Ljava/lang/String;");
+    JniCachedId jsValueInit(JniCachedId::Kind::Method, "<init>", "(L" JSBRIDGE_PKG_PATH "/JsBridge;J)V");
+    JniCachedId jsValueGetAssociatedJsName(JniCachedId::Kind::Method, "getAssociatedJsName", "()Ljava/lang/String;");
+    JniCachedId jsValueNativeHandle(JniCachedId::Kind::Field, "nativeHandle", "J");
+    JniCachedId jsObjectViewInit(JniCachedId::Kind::Method, "<init>", "(L" JSBRIDGE_PKG_PATH "/JsBridge;J)V");
+    JniCachedId jsonObjectWrapperInit(JniCachedId::Kind::Method, "<init>", "(Ljava/lang/String;)V");
+    JniCachedId jsonObjectWrapperGetJsonString(JniCachedId::Kind::Method, "getJsonString", "()Ljava/lang/String;");
+    JniCachedId payloadCodecDecode(JniCachedId::Kind::StaticMethod, "decode", "(Ljava/nio/ByteBuffer;Z)Ljava/lang/Object;");
+    JniCachedId payloadCodecEncode(JniCachedId::Kind::StaticMethod, "encode", "(Ljava/lang/Object;)Ljava/nio/ByteBuffer;");
+    JniCachedId stringArrayCodecDecode(JniCachedId::Kind::StaticMethod, "decode", "([C[IZ)Ljava/lang/Object;");
+    JniCachedId stringArrayCodecEncode(JniCachedId::Kind::StaticMethod, "encode", "([Ljava/lang/Object;[I)[C");
+    JniCachedId serializableCodecDecode(JniCachedId::Kind::StaticMethod, "decode", "(Ljava/nio/ByteBuffer;Ljava/lang/Class;)Ljava/lang/Object;");
+    JniCachedId serializableCodecEncode(JniCachedId::Kind::StaticMethod, "encode", "(Ljava/lang/Object;Ljava/lang/Class;)Ljava/nio/ByteBuffer;");
+    JniCachedId javaObjectWrapperGetOrCreate(JniCachedId::Kind::StaticMethod, "getOrCreate", "(Ljava/lang/Object;)L" JSBRIDGE_PKG_PATH "/JavaObjectWrapper;");
+    JniCachedId javaObjectWrapperFromJavaObject(JniCachedId::Kind::StaticMethod, "fromJavaObject", "(Ljava/lang/Object;)L" JSBRIDGE_PKG_PATH "/JavaObjectWrapper;");
+    JniCachedId javaObjectWrapperExtractJavaObject(JniCachedId::Kind::Method, "extractJavaObject", "()Ljava/lang/Object;");
+    JniCachedId jsToJavaProxyInit(JniCachedId::Kind::Method, "<init>", "(L" JSBRIDGE_PKG_PATH "/JsBridge;L" JSBRIDGE_PKG_PATH "/JsToJavaInterface;Ljava/lang/String;)V");
+    JniCachedId listToArray(JniCachedId::Kind::Method, "toArray", "()[Ljava/lang/Object;");
+    JniCachedId systemIdentityHashCode(JniCachedId::Kind::StaticMethod, "identityHashCode", "(Ljava/lang/Object;)I");
+    JniCachedId throwableGetMessage(JniCachedId::Kind::Method, "getMessage", "()Ljava/lang/String;");
+    JniCachedId arraysAsList(JniCachedId::Kind::StaticMethod, "asList", "([Ljava/lang/Object;)Ljava/util/List;");
+    JniCachedId arrayListInit(JniCachedId::Kind::Method, "<init>", "(Ljava/util/Collection;)V");
+    JniCachedId mapEntrySet(JniCachedId::Kind::Method, "entrySet", "()Ljava/util/Set;");
+    JniCachedId setToArray(JniCachedId::Kind::Method, "toArray", "()[Ljava/lang/Object;");
+    JniCachedId mapEntryGetKey(JniCachedId::Kind::Method, "getKey", "()Ljava/lang/Object;");
+    JniCachedId mapEntryGetValue(JniCachedId::Kind::Method, "getValue", "()Ljava/lang/Object;");
+    JniCachedId linkedHashMapInit(JniCachedId::Kind::Method, "<init>", "(I)V");
+    JniCachedId linkedHashMapPut(JniCachedId::Kind::Method, "put", "(Ljava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;");
+    JniCachedId jsBridgeGetCustomClassLoader(JniCachedId::Kind::Method, "getCustomClassLoader", "()Ljava/lang/ClassLoader;");
+    JniCachedId parameterInit(JniCachedId::Kind::Method, "<init>", "(Ljava/lang/Class;Ljava/lang/ClassLoader;)V");
+  }
+
+  const JavaTypeId JAVA_TYPE_IDS_WITH_CLASS[] = {
+      JavaTypeId::Void, JavaTypeId::BoxedVoid, JavaTypeId::Unit,
+      JavaTypeId::Boolean, JavaTypeId::Byte, JavaTypeId::Int, JavaTypeId::Long, JavaTypeId::Float, JavaTypeId::Double, JavaTypeId::Short,
+      JavaTypeId::BoxedBoolean, JavaTypeId::BoxedByte, JavaTypeId::BoxedInt, JavaTypeId::BoxedLong, JavaTypeId::BoxedFloat, JavaTypeId::BoxedDouble, JavaTypeId::BoxedShort,
+      JavaTypeId::String, JavaTypeId::Number, JavaTypeId::Object,
+      JavaTypeId::ObjectArray, JavaTypeId::List, JavaTypeId::Map,
+      JavaTypeId::BooleanArray, JavaTypeId::ByteArray, JavaTypeId::IntArray, JavaTypeId::LongArray, JavaTypeId::FloatArray, JavaTypeId::DoubleArray, JavaTypeId::ShortArray,
+      JavaTypeId::DebugString, JavaTypeId::FunctionX, JavaTypeId::JsValue, JavaTypeId::JsonObjectWrapper, JavaTypeId::Deferred,
+      JavaTypeId::JavaObjectWrapper, JavaTypeId::JsToJavaProxy, JavaTypeId::Payload, JavaTypeId::PayloadObject, JavaTypeId::PayloadArray,
+      JavaTypeId::JsObjectView,
+  };
+
+  JniLocalRef<jclass> findJavaClass(const JniContext *jniContext, JavaTypeId id) {
+    const char *javaName = getJniClassNameByJavaTypeId(id);
+
+    JniLocalRef<jclass> javaClass = jniContext->findClass(javaName);
+
+    // If the above findClass() call throws an exception, try to get the class from the primitive type
+    if (jniContext->exceptionCheck()) {
+      jniContext->exceptionClear();
+      JniLocalRef<jclass> classClass = jniContext->findClass("java/lang/Class");
+      jmethodID getPrimitiveClass = jniContext->getStaticMethodID(classClass, "getPrimitiveClass", "(Ljava/lang/String;)Ljava/lang/Class;");
+
+      javaClass = jniContext->callStaticObjectMethod<jclass>(classClass, getPrimitiveClass, JStringLocalRef(jniContext, javaName));
+    }
+    return javaClass;
+  }
+
+  // Classes shared by all the JniCache instances of the process (class global refs are valid for
+  // all the threads). They are never released and are immutable once loaded.
+  struct SharedClasses {
+    explicit SharedClasses(const JniContext *jniContext)
+     : objectClass(findClass(jniContext, "java/lang/Object"))
+     , numberClass(findClass(jniContext, "java/lang/Number"))
+     , stringClass(findClass(jniContext, "java/lang/String"))
+     , arrayListClass(findClass(jniContext, "java/util/ArrayList"))
+     , arraysClass(findClass(jniContext, "java/util/Arrays"))
+     , javaClassClass(findClass(jniContext, "java/lang/Class"))
+     , listClass(findClass(jniContext, "java/util/List"))
+     , mapClass(findClass(jniContext, "java/util/Map"))
+     , mapEntryClass(findClass(jniContext, "java/util/Map$Entry"))
+     , setClass(findClass(jniContext, "java/util/Set"))
+     , linkedHashMapClass(findClass(jniContext, "java/util/LinkedHashMap"))
+     , reflectedMethodClass(findClass(jniContext, "java/lang/reflect/Method"))
+     , systemClass(findClass(jniContext, "java/lang/System"))
+     , throwableClass(findClass(jniContext, "java/lang/Throwable"))
+     , jsBridgeClass(findClass(jniContext, JSBRIDGE_PKG_PATH "/JsBridge"))
+     , jsExceptionClass(findClass(jniContext, JSBRIDGE_PKG_PATH "/JsException"))
+     , illegalArgumentExceptionClass(findClass(jniContext, "java/lang/IllegalArgumentException"))
+     , runtimeExceptionClass(findClass(jniContext, "java/lang/RuntimeException"))
+     , jsBridgeMethodClass(findClass(jniContext, JSBRIDGE_PKG_PATH "/Method"))
+     , jsBridgeParameterClass(findClass(jniContext, JSBRIDGE_PKG_PATH "/Parameter"))
+     , payloadCodecClass(findClass(jniContext, JSBRIDGE_PKG_PATH "/PayloadCodec"))
+     , stringArrayCodecClass(findClass(jniContext, JSBRIDGE_PKG_PATH "/StringArrayCodec")) {
+
+      for (JavaTypeId id : JAVA_TYPE_IDS_WITH_CLASS) {
+        JniLocalRef<jclass> javaClass = findJavaClass(jniContext, id);
+        if (jniContext->exceptionCheck()) {
+          // Not shared: JniCache::getJavaClass() will try again (and report the error)
+          jniContext->exceptionClear();
+          continue;
+        }
+        javaClasses.emplace(id, JniGlobalRef<jclass>(javaClass, JniGlobalRefMode::Leaked));
+      }
+    }
+
+    static JniGlobalRef<jclass> findClass(const JniContext *jniContext, const char *name) {
+      return JniGlobalRef<jclass>(jniContext->findClass(name), JniGlobalRefMode::Leaked);
+    }
+
+    const JniGlobalRef<jclass> objectClass;
+    const JniGlobalRef<jclass> numberClass;
+    const JniGlobalRef<jclass> stringClass;
+    const JniGlobalRef<jclass> arrayListClass;
+    const JniGlobalRef<jclass> arraysClass;
+    const JniGlobalRef<jclass> javaClassClass;
+    const JniGlobalRef<jclass> listClass;
+    const JniGlobalRef<jclass> mapClass;
+    const JniGlobalRef<jclass> mapEntryClass;
+    const JniGlobalRef<jclass> setClass;
+    const JniGlobalRef<jclass> linkedHashMapClass;
+    const JniGlobalRef<jclass> reflectedMethodClass;
+    const JniGlobalRef<jclass> systemClass;
+    const JniGlobalRef<jclass> throwableClass;
+    const JniGlobalRef<jclass> jsBridgeClass;
+    const JniGlobalRef<jclass> jsExceptionClass;
+    const JniGlobalRef<jclass> illegalArgumentExceptionClass;
+    const JniGlobalRef<jclass> runtimeExceptionClass;
+    const JniGlobalRef<jclass> jsBridgeMethodClass;
+    const JniGlobalRef<jclass> jsBridgeParameterClass;
+    const JniGlobalRef<jclass> payloadCodecClass;
+    const JniGlobalRef<jclass> stringArrayCodecClass;
+    std::unordered_map<JavaTypeId, JniGlobalRef<jclass>> javaClasses;
+  };
+
+  const SharedClasses *s_sharedClasses = nullptr;
+  std::once_flag s_sharedClassesOnce;
+
+  const SharedClasses &getSharedClasses(const JniContext *jniContext) {
+    // Normally already loaded from JNI_OnLoad()
+    JniCache::loadShared(jniContext->getJNIEnv());
+    return *s_sharedClasses;
+  }
+
+  const JniGlobalRef<jclass> &getSharedJavaClass(JavaTypeId id) {
+    static const JniGlobalRef<jclass> nullClass;
+
+    auto itFind = s_sharedClasses->javaClasses.find(id);
+    return itFind == s_sharedClasses->javaClasses.end() ? nullClass : itFind->second;
+  }
+
+  void resolveJniCacheIds(const JniContext *jniContext, const SharedClasses &classes) {
+    JsBridgeInterface::preloadMethodIds(jniContext, classes.jsBridgeClass);
+    MethodInterface::preloadMethodIds(jniContext, classes.jsBridgeMethodClass);
+    ParameterInterface::preloadMethodIds(jniContext, classes.jsBridgeParameterClass);
+
+    JniCacheIds::reflectedMethodGetName.getMethodId(jniContext, classes.reflectedMethodClass);
+    JniCacheIds::reflectedMethodGetDeclaringClass.getMethodId(jniContext, classes.reflectedMethodClass);
+    JniCacheIds::jsExceptionInit.getMethodId(jniContext, classes.jsExceptionClass);
+    JniCacheIds::payloadCodecDecode.getMethodId(jniContext, classes.payloadCodecClass);
+    JniCacheIds::payloadCodecEncode.getMethodId(jniContext, classes.payloadCodecClass);
+    JniCacheIds::stringArrayCodecDecode.getMethodId(jniContext, classes.stringArrayCodecClass);
+    JniCacheIds::stringArrayCodecEncode.getMethodId(jniContext, classes.stringArrayCodecClass);
+    JniCacheIds::listToArray.getMethodId(jniContext, classes.listClass);
+    JniCacheIds::arraysAsList.getMethodId(jniContext, classes.arraysClass);
+    JniCacheIds::systemIdentityHashCode.getMethodId(jniContext, classes.systemClass);
+    JniCacheIds::throwableGetMessage.getMethodId(jniContext, classes.throwableClass);
+    JniCacheIds::arrayListInit.getMethodId(jniContext, classes.arrayListClass);
+    JniCacheIds::mapEntrySet.getMethodId(jniContext, classes.mapClass);
+    JniCacheIds::setToArray.getMethodId(jniContext, classes.setClass);
+    JniCacheIds::mapEntryGetKey.getMethodId(jniContext, classes.mapEntryClass);
+    JniCacheIds::mapEntryGetValue.getMethodId(jniContext, classes.mapEntryClass);
+    JniCacheIds::linkedHashMapInit.getMethodId(jniContext, classes.linkedHashMapClass);
+    JniCacheIds::linkedHashMapPut.getMethodId(jniContext, classes.linkedHashMapClass);
+    JniCacheIds::jsBridgeGetCustomClassLoader.getMethodId(jniContext, classes.jsBridgeClass);
+    JniCacheIds::parameterInit.getMethodId(jniContext, classes.jsBridgeParameterClass);
+
+    const auto &debugStringClass = getSharedJavaClass(JavaTypeId::DebugString);
+    if (!debugStringClass.isNull()) {
+      JniCacheIds::debugStringInit.getMethodId(jniContext, debugStringClass);
+      JniCacheIds::debugStringGetString.getMethodId(jniContext, debugStringClass);
+    }
+
+    const auto &jsValueClass = getSharedJavaClass(JavaTypeId::JsValue);
+    if (!jsValueClass.isNull()) {
+      JniCacheIds::jsValueInit.getMethodId(jniContext, jsValueClass);
+      JniCacheIds::jsValueGetAssociatedJsName.getMethodId(jniContext, jsValueClass);
+      JniCacheIds::jsValueNativeHandle.getFieldId(jniContext, jsValueClass);
+    }
+
+    const auto &jsObjectViewClass = getSharedJavaClass(JavaTypeId::JsObjectView);
+    if (!jsObjectViewClass.isNull()) {
+      JniCacheIds::jsObjectViewInit.getMethodId(jniContext, jsObjectViewClass);
+    }
+
+    const auto &jsonObjectWrapperClass = getSharedJavaClass(JavaTypeId::JsonObjectWrapper);
+    if (!jsonObjectWrapperClass.isNull()) {
+      JniCacheIds::jsonObjectWrapperInit.getMethodId(jniContext, jsonObjectWrapperClass);
+      JniCacheIds::jsonObjectWrapperGetJsonString.getMethodId(jniContext, jsonObjectWrapperClass);
+    }
+
+    const auto &javaObjectWrapperClass = getSharedJavaClass(JavaTypeId::JavaObjectWrapper);
+    if (!javaObjectWrapperClass.isNull()) {
+      JniCacheIds::javaObjectWrapperGetOrCreate.getMethodId(jniContext, javaObjectWrapperClass);
+      JniCacheIds::javaObjectWrapperFromJavaObject.getMethodId(jniContext, javaObjectWrapperClass);
+      JniCacheIds::javaObjectWrapperExtractJavaObject.getMethodId(jniContext, javaObjectWrapperClass);
+    }
+
+    const auto &jsToJavaProxyClass = getSharedJavaClass(JavaTypeId::JsToJavaProxy);
+    if (!jsToJavaProxyClass.isNull()) {
+      JniCacheIds::jsToJavaProxyInit.getMethodId(jniContext, jsToJavaProxyClass);
+    }
+  }
+}
+
+// static
+void JniCache::loadShared(JNIEnv *env) {
+  std::call_once(s_sharedClassesOnce, [env]() {
+    // The shared global refs may be used from any thread and outlive all the JsBridge instances
+    static const JniContext sharedJniContext(env, JniContext::EnvironmentSource::JvmAuto);
+
+    s_sharedClasses = new SharedClasses(&sharedJniContext);
+    resolveJniCacheIds(&sharedJniContext, *s_sharedClasses);
+  });
+}
 
 JniCache::JniCache(const JsBridgeContext *jsBridgeContext, const JniLocalRef<jobject> &jsBridgeJavaObject)
  : m_jsBridgeContext(jsBridgeContext)
  , m_jniContext(m_jsBridgeContext->getJniContext())
- , m_objectClass(m_jniContext->findClass("java/lang/Object"))
- , m_numberClass(m_jniContext->findClass("java/lang/Number"))
- , m_stringClass(m_jniContext->findClass("java/lang/String"))
- , m_arrayListClass(m_jniContext->findClass("java/util/ArrayList"))
- , m_javaClassClass(m_jniContext->findClass("java/lang/Class"))
- , m_listClass(m_jniContext->findClass("java/util/List"))
- , m_jsBridgeClass(m_jniContext->findClass(JSBRIDGE_PKG_PATH "/JsBridge"))
- , m_jsExceptionClass(m_jniContext->findClass(JSBRIDGE_PKG_PATH "/JsException"))
- , m_illegalArgumentExceptionClass(m_jniContext->findClass("java/lang/IllegalArgumentException"))
- , m_runtimeExceptionClass(m_jniContext->findClass("java/lang/RuntimeException"))
- , m_jsBridgeMethodClass(m_jniContext->findClass(JSBRIDGE_PKG_PATH "/Method"))
- , m_jsBridgeParameterClass(m_jniContext->findClass(JSBRIDGE_PKG_PATH "/Parameter"))
+ , m_objectClass(getSharedClasses(m_jniContext).objectClass)
+ , m_numberClass(getSharedClasses(m_jniContext).numberClass)
+ , m_stringClass(getSharedClasses(m_jniContext).stringClass)
+ , m_arrayListClass(getSharedClasses(m_jniContext).arrayListClass)
+ , m_arraysClass(getSharedClasses(m_jniContext).arraysClass)
+ , m_javaClassClass(getSharedClasses(m_jniContext).javaClassClass)
+ , m_listClass(getSharedClasses(m_jniContext).listClass)
+ , m_mapClass(getSharedClasses(m_jniContext).mapClass)
+ , m_mapEntryClass(getSharedClasses(m_jniContext).mapEntryClass)
+ , m_setClass(getSharedClasses(m_jniContext).setClass)
+ , m_linkedHashMapClass(getSharedClasses(m_jniContext).linkedHashMapClass)
+ , m_jsBridgeClass(getSharedClasses(m_jniContext).jsBridgeClass)
+ , m_jsExceptionClass(getSharedClasses(m_jniContext).jsExceptionClass)
+ , m_illegalArgumentExceptionClass(getSharedClasses(m_jniContext).illegalArgumentExceptionClass)
+ , m_runtimeExceptionClass(getSharedClasses(m_jniContext).runtimeExceptionClass)
+ , m_jsBridgeMethodClass(getSharedClasses(m_jniContext).jsBridgeMethodClass)
+ , m_jsBridgeParameterClass(getSharedClasses(m_jniContext).jsBridgeParameterClass)
  , m_jsBridgeDebugStringClass(getJavaClass(JavaTypeId::DebugString))
  , m_jsBridgeJsValueClass(getJavaClass(JavaTypeId::JsValue))
  , m_jsonObjectWrapperClass(getJavaClass(JavaTypeId::JsonObjectWrapper))
  , m_javaObjectWrapperClass(getJavaClass(JavaTypeId::JavaObjectWrapper))
  , m_jsToJavaProxyClass(getJavaClass(JavaTypeId::JsToJavaProxy))
+ , m_payloadCodecClass(getSharedClasses(m_jniContext).payloadCodecClass)
+ , m_stringArrayCodecClass(getSharedClasses(m_jniContext).stringArrayCodecClass)
+ , m_javaClassGetName(m_jniContext->getMethodID(m_javaClassClass, "getName", "()Ljava/lang/String;"))
+ , m_javaClassGetComponentType(m_jniContext->getMethodID(m_javaClassClass, "getComponentType", "()Ljava/lang/Class;"))
  , m_jsBridgeInterface(this, jsBridgeJavaObject) {
 }
 
+void JniCache::preload() const {
+  // Classes which could not be shared
+  for (JavaTypeId id : JAVA_TYPE_IDS_WITH_CLASS) {
+    getJavaClass(id);
+  }
+
+  resolveJniCacheIds(m_jniContext, *s_sharedClasses);
+}
+
 const JniGlobalRef<jclass> &JniCache::getJavaClass(JavaTypeId id) const {
+  const auto &sharedClass = getSharedJavaClass(id);
+  if (!sharedClass.isNull()) {
+    return sharedClass;
+  }
+
   auto itFind = m_javaClasses.find(id);
   if (itFind != m_javaClasses.end()) {
     return itFind->second;
@@ -51,34 +299,45 @@ const JniGlobalRef<jclass> &JniCache::getJavaClass(JavaTypeId id) const {
   const JniContext *jniContext = m_jsBridgeContext->getJniContext();
   assert(jniContext != nullptr);
 
-  const std::string &javaName = getJniClassNameByJavaTypeId(id);
+  return m_javaClasses.emplace(id, JniGlobalRef<jclass>(findJavaClass(jniContext, id))).first->second;
+}
 
-  JniLocalRef<jclass> javaClass = jniContext->findClass(javaName.c_str());
+JStringLocalRef JniCache::getJavaClassName(const JniRef<jclass> &javaClass) const {
+  return m_jniContext->callStringMethod(javaClass, m_javaClassGetName);
+}
 
-  // If the above findClass() call throws an exception, try to get the class from the primitive type
-  if (jniContext->exceptionCheck()) {
-    jniContext->exceptionClear();
-    JniLocalRef<jclass> classClass = jniContext->findClass("java/lang/Class");
-    jmethodID getPrimitiveClass = jniContext->getStaticMethodID(classClass, "getPrimitiveClass", "(Ljava/lang/String;)Ljava/lang/Class;");
+JniLocalRef<jclass> JniCache::getJavaClassComponentType(const JniRef<jclass> &javaClass) const {
+  return m_jniContext->callObjectMethod<jclass>(javaClass, m_javaClassGetComponentType);
+}
 
-    javaClass = jniContext->callStaticObjectMethod<jclass>(classClass, getPrimitiveClass, JStringLocalRef(jniContext, javaName.c_str()));
-  }
-  return m_javaClasses.emplace(id, JniGlobalRef<jclass>(javaClass)).first->second;
+jint JniCache::getIdentityHashCode(const JniRef<jobject> &javaObject) const {
+  jmethodID methodId = JniCacheIds::systemIdentityHashCode.getMethodId(m_jniContext, s_sharedClasses->systemClass);
+  return m_jniContext->callStaticIntMethod(s_sharedClasses->systemClass, methodId, javaObject);
+}
+
+JStringLocalRef JniCache::getThrowableMessage(const JniRef<jthrowable> &throwable) const {
+  jmethodID methodId = JniCacheIds::throwableGetMessage.getMethodId(m_jniContext, s_sharedClasses->throwableClass);
+  return m_jniContext->callStringMethod(throwable, methodId);
 }
 
 JStringLocalRef JniCache::getJavaReflectedMethodName(const JniLocalRef<jobject> &javaMethod) const {
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(m_jniContext->getObjectClass(javaMethod), "getName", "()Ljava/lang/String;");
+  jmethodID methodId = JniCacheIds::reflectedMethodGetName.getMethodId(m_jniContext, s_sharedClasses->reflectedMethodClass);
   return m_jniContext->callStringMethod(javaMethod, methodId);
 }
 
+JniLocalRef<jclass> JniCache::getJavaReflectedMethodDeclaringClass(const JniLocalRef<jobject> &javaMethod) const {
+  jmethodID methodId = JniCacheIds::reflectedMethodGetDeclaringClass.getMethodId(m_jniContext, s_sharedClasses->reflectedMethodClass);
+  return m_jniContext->callObjectMethod<jclass>(javaMethod, methodId);
+}
+
 JniLocalRef<jthrowable> JniCache::newJsException(
     const JStringLocalRef &jsonValue, const JStringLocalRef &detailedMessage,
-    const JStringLocalRef &jsStackTrace, const JniRef<jthrowable> &cause) const {
+    const JStringLocalRef &jsStackTrace, const JniRef<jthrowable> &cause,
+    const JniRef<jobject> &errorValue) const {
 
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(
-      m_jsExceptionClass, "<init>", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/Throwable;)V");
+  jmethodID methodId = JniCacheIds::jsExceptionInit.getMethodId(m_jniContext, m_jsExceptionClass);
 
-  return m_jniContext->newObject<jthrowable>(m_jsExceptionClass, methodId, jsonValue, detailedMessage, jsStackTrace, cause);
+  return m_jniContext->newObject<jthrowable>(m_jsExceptionClass, methodId, jsonValue, detailedMessage, jsStackTrace, cause, errorValue);
 }
 
 
@@ -90,12 +349,12 @@ JniLocalRef<jobject> JniCache::newDebugString(const char *s) const {
 }
 
 JniLocalRef<jobject> JniCache::newDebugString(const JStringLocalRef &s) const {
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(m_jsBridgeDebugStringClass, "<init>", "(Ljava/lang/String;)V");
+  jmethodID methodId = JniCacheIds::debugStringInit.getMethodId(m_jniContext, m_jsBridgeDebugStringClass);
   return m_jniContext->newObject<jobject>(m_jsBridgeDebugStringClass, methodId, s);
 }
 
 JStringLocalRef JniCache::getDebugStringString(const JniRef<jobject> &debugString) const {
-  static thread_local jmethodID getString = m_jniContext->getMethodID(m_jsBridgeDebugStringClass, "getString", "()Ljava/lang/String;");
+  jmethodID getString = JniCacheIds::debugStringGetString.getMethodId(m_jniContext, m_jsBridgeDebugStringClass);
   return m_jniContext->callStringMethod(debugString, getString);
 }
 
@@ -103,46 +362,106 @@ JStringLocalRef JniCache::getDebugStringString(const JniRef<jobject> &debugStrin
 // JsValue
 // ---
 
-JniLocalRef<jobject> JniCache::newJsValue(const JStringLocalRef &name) const {
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(m_jsBridgeJsValueClass, "<init>", "(L" JSBRIDGE_PKG_PATH "/JsBridge;Ljava/lang/String;)V");
-  return m_jniContext->newObject<jobject>(m_jsBridgeJsValueClass, methodId, m_jsBridgeInterface.object(), name);
+JniLocalRef<jobject> JniCache::newJsValue(jlong handle) const {
+  jmethodID methodId = JniCacheIds::jsValueInit.getMethodId(m_jniContext, m_jsBridgeJsValueClass);
+  return m_jniContext->newObject<jobject>(m_jsBridgeJsValueClass, methodId, m_jsBridgeInterface.object(), handle);
 }
 
 JStringLocalRef JniCache::getJsValueName(const JniRef<jobject> &jsValue) const {
-  static thread_local jmethodID getJsName = m_jniContext->getMethodID(m_jsBridgeJsValueClass, "getAssociatedJsName", "()Ljava/lang/String;");
+  jmethodID getJsName = JniCacheIds::jsValueGetAssociatedJsName.getMethodId(m_jniContext, m_jsBridgeJsValueClass);
   return m_jniContext->callStringMethod(jsValue, getJsName);
 }
 
+jlong JniCache::getJsValueHandle(const JniRef<jobject> &jsValue) const {
+  jfieldID fieldId = JniCacheIds::jsValueNativeHandle.getFieldId(m_jniContext, m_jsBridgeJsValueClass);
+  return m_jniContext->getLongField(jsValue, fieldId);
+}
+
+
+// JsObjectView
+// ---
+
+JniLocalRef<jobject> JniCache::newJsObjectView(jlong handle) const {
+  const auto &javaClass = getJavaClass(JavaTypeId::JsObjectView);
+  jmethodID methodId = JniCacheIds::jsObjectViewInit.getMethodId(m_jniContext, javaClass);
+  return m_jniContext->newObject<jobject>(javaClass, methodId, m_jsBridgeInterface.object(), handle);
+}
+
 
 // JsonObjectWrapper
 // ---
 
 JniLocalRef<jobject> JniCache::newJsonObjectWrapper(const JStringLocalRef &jsonString) const {
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(m_jsonObjectWrapperClass, "<init>", "(Ljava/lang/String;)V");
+  jmethodID methodId = JniCacheIds::jsonObjectWrapperInit.getMethodId(m_jniContext, m_jsonObjectWrapperClass);
   return m_jniContext->newObject<jobject>(m_jsonObjectWrapperClass, methodId, jsonString);
 }
 
 JStringLocalRef JniCache::getJsonObjectWrapperString(const JniRef<jobject> &jsonObjectWrapper) const {
-  static thread_local jmethodID getJsonString = m_jniContext->getMethodID(m_jsonObjectWrapperClass, "getJsonString", "()Ljava/lang/String;");
+  jmethodID getJsonString = JniCacheIds::jsonObjectWrapperGetJsonString.getMethodId(m_jniContext, m_jsonObjectWrapperClass);
   return m_jniContext->callStringMethod(jsonObjectWrapper, getJsonString);
 }
 
 
+// PayloadCodec
+// ---
+
+JniLocalRef<jobject> JniCache::decodePayload(const JniLocalRef<jobject> &byteBuffer, bool wrapPrimitives) const {
+  jmethodID methodId = JniCacheIds::payloadCodecDecode.getMethodId(m_jniContext, m_payloadCodecClass);
+  return m_jniContext->callStaticObjectMethod<jobject>(m_payloadCodecClass, methodId, byteBuffer, static_cast<jboolean>(wrapPrimitives));
+}
+
+JniLocalRef<jobject> JniCache::encodePayload(const JniRef<jobject> &payload) const {
+  jmethodID methodId = JniCacheIds::payloadCodecEncode.getMethodId(m_jniContext, m_payloadCodecClass);
+  return m_jniContext->callStaticObjectMethod<jobject>(m_payloadCodecClass, methodId, payload);
+}
+
+
+// StringArrayCodec
+// ---
+
+JniLocalRef<jobject> JniCache::decodeStrings(const JArrayLocalRef<jchar> &chars, const JArrayLocalRef<jint> &lengths, bool asList) const {
+  jmethodID methodId = JniCacheIds::stringArrayCodecDecode.getMethodId(m_jniContext, m_stringArrayCodecClass);
+  return m_jniContext->callStaticObjectMethod<jobject>(m_stringArrayCodecClass, methodId, chars, lengths, static_cast<jboolean>(asList));
+}
+
+JArrayLocalRef<jchar> JniCache::encodeStrings(const JObjectArrayLocalRef &strings, const JArrayLocalRef<jint> &lengths) const {
+  jmethodID methodId = JniCacheIds::stringArrayCodecEncode.getMethodId(m_jniContext, m_stringArrayCodecClass);
+  return JArrayLocalRef<jchar>(m_jniContext->callStaticObjectMethod<jarray>(m_stringArrayCodecClass, methodId, strings, lengths));
+}
+
+
+// SerializableCodec
+// ---
+
+JniLocalRef<jobject> JniCache::decodeSerializable(const JniLocalRef<jobject> &byteBuffer, const JniRef<jclass> &serializableClass) const {
+  // The codec class (which needs kotlinx.serialization) is only loaded when a @Serializable type is used
+  const auto &codecClass = getJavaClass(JavaTypeId::Serializable);
+  jmethodID methodId = JniCacheIds::serializableCodecDecode.getMethodId(m_jniContext, codecClass);
+  return m_jniContext->callStaticObjectMethod<jobject>(codecClass, methodId, byteBuffer, serializableClass);
+}
+
+JniLocalRef<jobject> JniCache::encodeSerializable(const JniRef<jobject> &value, const JniRef<jclass> &serializableClass) const {
+  const auto &codecClass = getJavaClass(JavaTypeId::Serializable);
+  jmethodID methodId = JniCacheIds::serializableCodecEncode.getMethodId(m_jniContext, codecClass);
+  return m_jniContext->callStaticObjectMethod<jobject>(codecClass, methodId, value, serializableClass);
+}
+
+
 // JavaObjectWrapper
 // ---
 
 JniLocalRef<jobject> JniCache::getOrCreateJavaObjectWrapper(const JniRef<jobject> &javaObject) const {
-  static thread_local jmethodID methodId = m_jniContext->getStaticMethodID(m_javaObjectWrapperClass, "getOrCreate", "(Ljava/lang/Object;)L" JSBRIDGE_PKG_PATH "/JavaObjectWrapper;");
+  jmethodID methodId = JniCacheIds::javaObjectWrapperGetOrCreate.getMethodId(m_jniContext, m_javaObjectWrapperClass);
   return m_jniContext->callStaticObjectMethod<jobject>(m_javaObjectWrapperClass, methodId, javaObject);
 }
 
 JniLocalRef<jobject> JniCache::javaObjectWrapperFromJavaObject(const JniRef<jobject> &javaObject) const {
-  static thread_local jmethodID methodId = m_jniContext->getStaticMethodID(m_javaObjectWrapperClass, "fromJavaObject", "(Ljava/lang/Object;)L" JSBRIDGE_PKG_PATH "/JavaObjectWrapper;");
+  jmethodID methodId = JniCacheIds::javaObjectWrapperFromJavaObject.getMethodId(m_jniContext, m_javaObjectWrapperClass);
   return m_jniContext->callStaticObjectMethod<jobject>(m_javaObjectWrapperClass, methodId, javaObject);
 }
 
 JniLocalRef<jobject> JniCache::getJavaObjectWrapperJavaObject(const JniRef<jobject> &javaObjectWrapper) const {
-  static thread_local jmethodID getJavaObject = m_jniContext->getMethodID(m_javaObjectWrapperClass, "extractJavaObject", "()Ljava/lang/Object;");
+  jmethodID getJavaObject = JniCacheIds::javaObjectWrapperExtractJavaObject.getMethodId(m_jniContext, m_javaObjectWrapperClass);
   return m_jniContext->callObjectMethod(javaObjectWrapper, getJavaObject);
 }
 
@@ -151,7 +470,7 @@ JniLocalRef<jobject> JniCache::getJavaObjectWrapperJavaObject(const JniRef<jobje
 // ---
 
 JniLocalRef<jobject> JniCache::newJsToJavaProxy(const JniRef<jobject> &javaObject, const JStringLocalRef &name) const {
-  static thread_local jmethodID ctorId = m_jniContext->getMethodID(m_jsToJavaProxyClass, "<init>", "(L" JSBRIDGE_PKG_PATH "/JsBridge;L" JSBRIDGE_PKG_PATH "/JsToJavaInterface;Ljava/lang/String;)V");
+  jmethodID ctorId = JniCacheIds::jsToJavaProxyInit.getMethodId(m_jniContext, m_jsToJavaProxyClass);
   return m_jniContext->newObject<jobject>(m_jsToJavaProxyClass,ctorId, m_jsBridgeInterface.object(), javaObject, name);
 }
 
@@ -159,24 +478,58 @@ JniLocalRef<jobject> JniCache::newJsToJavaProxy(const JniRef<jobject> &javaObjec
 // List
 // ---
 
-JniLocalRef<jobject> JniCache::newList() const {
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(m_arrayListClass, "<init>", "()V");
-  return m_jniContext->newObject<jobject>(m_arrayListClass, methodId);
+JObjectArrayLocalRef JniCache::listToArray(const JniLocalRef<jobject> &list) const {
+  jmethodID methodId = JniCacheIds::listToArray.getMethodId(m_jniContext, m_listClass);
+  return JObjectArrayLocalRef(m_jniContext->callObjectMethod<jobjectArray>(list, methodId));
 }
 
-void JniCache::addToList(const JniLocalRef<jobject> &list, const JniLocalRef<jobject> &element) const {
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(m_listClass, "add", "(Ljava/lang/Object;)Z");
-  m_jniContext->callBooleanMethod(list, methodId, element);
+JniLocalRef<jobject> JniCache::newListFromArray(const JObjectArrayLocalRef &array) const {
+  // new ArrayList(Arrays.asList(array)): Arrays.asList() only wraps the array and the ArrayList
+  // constructor copies it at once with the exact capacity
+  jmethodID asListMethodId = JniCacheIds::arraysAsList.getMethodId(m_jniContext, m_arraysClass);
+  jmethodID ctorId = JniCacheIds::arrayListInit.getMethodId(m_jniContext, m_arrayListClass);
+
+  JniLocalRef<jobject> arrayAsList = m_jniContext->callStaticObjectMethod(m_arraysClass, asListMethodId, array);
+  return m_jniContext->newObject<jobject>(m_arrayListClass, ctorId, arrayAsList);
 }
 
-int JniCache::getListLength(const JniLocalRef<jobject> &list) const {
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(m_listClass, "size", "()I");
-  return m_jniContext->callIntMethod(list, methodId);
+
+// Map
+// ---
+
+JObjectArrayLocalRef JniCache::mapEntriesToArray(const JniLocalRef<jobject> &map) const {
+  jmethodID entrySetMethodId = JniCacheIds::mapEntrySet.getMethodId(m_jniContext, m_mapClass);
+  jmethodID toArrayMethodId = JniCacheIds::setToArray.getMethodId(m_jniContext, m_setClass);
+
+  JniLocalRef<jobject> entrySet = m_jniContext->callObjectMethod(map, entrySetMethodId);
+  if (entrySet.isNull()) {
+    return JObjectArrayLocalRef();
+  }
+  return JObjectArrayLocalRef(m_jniContext->callObjectMethod<jobjectArray>(entrySet, toArrayMethodId));
+}
+
+JniLocalRef<jobject> JniCache::getMapEntryKey(const JniLocalRef<jobject> &entry) const {
+  jmethodID methodId = JniCacheIds::mapEntryGetKey.getMethodId(m_jniContext, m_mapEntryClass);
+  return m_jniContext->callObjectMethod(entry, methodId);
+}
+
+JniLocalRef<jobject> JniCache::getMapEntryValue(const JniLocalRef<jobject> &entry) const {
+  jmethodID methodId = JniCacheIds::mapEntryGetValue.getMethodId(m_jniContext, m_mapEntryClass);
+  return m_jniContext->callObjectMethod(entry, methodId);
+}
+
+JniLocalRef<jobject> JniCache::newMap(jsize entryCount) const {
+  // Capacity for the given entry count with the default load factor (0.75) so that the map is
+  // never rehashed while being filled
+  const jint initialCapacity = static_cast<jint>(entryCount + entryCount / 3 + 1);
+
+  jmethodID ctorId = JniCacheIds::linkedHashMapInit.getMethodId(m_jniContext, m_linkedHashMapClass);
+  return m_jniContext->newObject<jobject>(m_linkedHashMapClass, ctorId, initialCapacity);
 }
 
-JniLocalRef<jobject> JniCache::getListElement(const JniLocalRef<jobject> &list, int i) const {
-  static thread_local jmethodID methodId = m_jniContext->getMethodID(m_listClass, "get", "(I)Ljava/lang/Object;");
-  return m_jniContext->callObjectMethod(list, methodId, i);
+void JniCache::putMapEntry(const JniLocalRef<jobject> &map, const JStringLocalRef &key, const JniLocalRef<jobject> &value) const {
+  jmethodID methodId = JniCacheIds::linkedHashMapPut.getMethodId(m_jniContext, m_linkedHashMapClass);
+  m_jniContext->callObjectMethod(map, methodId, key, value);  // (ignored previous value)
 }
 
 
@@ -184,9 +537,9 @@ JniLocalRef<jobject> JniCache::getListElement(const JniLocalRef<jobject> &list,
 // ---
 
 JniLocalRef<jsBridgeParameter> JniCache::newParameter(const JniLocalRef<jclass> &javaClass) const {
-  static thread_local jmethodID getCustomClassLoader = m_jniContext->getMethodID(m_jsBridgeClass, "getCustomClassLoader", "()Ljava/lang/ClassLoader;");
+  jmethodID getCustomClassLoader = JniCacheIds::jsBridgeGetCustomClassLoader.getMethodId(m_jniContext, m_jsBridgeClass);
   const auto bridgeCustomClassLoader = m_jniContext->callObjectMethod(m_jsBridgeInterface.object(), getCustomClassLoader);
 
-  static thread_local jmethodID parameterInit = m_jniContext->getMethodID(m_jsBridgeParameterClass, "<init>", "(Ljava/lang/Class;Ljava/lang/ClassLoader;)V");
+  jmethodID parameterInit = JniCacheIds::parameterInit.getMethodId(m_jniContext, m_jsBridgeParameterClass);
   return m_jniContext->newObject<jsBridgeParameter>(m_jsBridgeParameterClass, parameterInit, javaClass, bridgeCustomClassLoader);
 }
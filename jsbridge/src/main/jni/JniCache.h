@@ -21,6 +21,7 @@
 #include "JavaTypeId.h"
 #include "JniInterfaces.h"
 #include "JniTypes.h"
+#include "jni-helpers/JArrayLocalRef.h"
 #include "jni-helpers/JniGlobalRef.h"
 #include "jni-helpers/JObjectArrayLocalRef.h"
 #include "jni-helpers/JStringLocalRef.h"
@@ -37,6 +38,15 @@ class JniCache {
 public:
   JniCache(const JsBridgeContext *, const JniLocalRef<jobject> &jsBridgeJavaObject);
 
+  // Load the Java classes and resolve the method/field IDs shared by all the JniCache instances of
+  // the process (only once). Called from JNI_OnLoad() where FindClass() can access the app classes.
+  static void loadShared(JNIEnv *);
+
+  // Eagerly load all the Java classes and resolve all the method/field IDs which could not be
+  // shared by loadShared() and are otherwise looked up when first used (must be called from a
+  // thread with access to the app class loader)
+  void preload() const;
+
   const JniGlobalRef<jclass> &getJavaClass(JavaTypeId) const;
   const JniRef<jclass> &getObjectClass() const { return m_objectClass; }
   const JniRef<jclass> &getNumberClass() const { return m_numberClass; }
@@ -57,10 +67,21 @@ public:
   const JniRef<jclass> &getRuntimeExceptionClass() const { return m_runtimeExceptionClass; }
   JniLocalRef<jthrowable> newJsException(
       const JStringLocalRef &jsonValue, const JStringLocalRef &detailedMessage,
-      const JStringLocalRef &jsStackTrace, const JniRef<jthrowable> &cause) const;
+      const JStringLocalRef &jsStackTrace, const JniRef<jthrowable> &cause,
+      const JniRef<jobject> &errorValue) const;
+  // Throwable.getMessage() (virtual call, i.e. also for the overridden implementations)
+  JStringLocalRef getThrowableMessage(const JniRef<jthrowable> &throwable) const;
+
+  // JavaClass (java.lang.Class)
+  JStringLocalRef getJavaClassName(const JniRef<jclass> &javaClass) const;
+  JniLocalRef<jclass> getJavaClassComponentType(const JniRef<jclass> &javaClass) const;
+
+  // System.identityHashCode()
+  jint getIdentityHashCode(const JniRef<jobject> &javaObject) const;
 
   // JavaReflectedMethod (java.lang.reflect.Method)
   JStringLocalRef getJavaReflectedMethodName(const JniLocalRef<jobject> &javaMethod) const;
+  JniLocalRef<jclass> getJavaReflectedMethodDeclaringClass(const JniLocalRef<jobject> &javaMethod) const;
 
   // DebugString (de.prosiebensat1digital.oasisjsbridge.DebugString)
   JniLocalRef<jobject> newDebugString(const char *s) const;
@@ -68,13 +89,30 @@ public:
   JStringLocalRef getDebugStringString(const JniRef<jobject> &debugString) const;
 
   // JsValue (de.prosiebensat1digital.oasisjsbridge.JsValue)
-  JniLocalRef<jobject> newJsValue(const JStringLocalRef &name) const;
+  JniLocalRef<jobject> newJsValue(jlong handle) const;
   JStringLocalRef getJsValueName(const JniRef<jobject> &jsValue) const;
+  jlong getJsValueHandle(const JniRef<jobject> &jsValue) const;
+
+  // JsObjectView (de.prosiebensat1digital.oasisjsbridge.JsObjectView)
+  JniLocalRef<jobject> newJsObjectView(jlong handle) const;
 
   // JsonObjectWrapper (de.prosiebensat1digital.oasisjsbridge.JsonObjectWrapper)
   JniLocalRef<jobject> newJsonObjectWrapper(const JStringLocalRef &jsonString) const;
   JStringLocalRef getJsonObjectWrapperString(const JniRef<jobject> &jsonObjectWrapper) const;
 
+  // PayloadCodec (de.prosiebensat1digital.oasisjsbridge.PayloadCodec)
+  JniLocalRef<jobject> decodePayload(const JniLocalRef<jobject> &byteBuffer, bool wrapPrimitives) const;
+  JniLocalRef<jobject> encodePayload(const JniRef<jobject> &payload) const;
+
+  // StringArrayCodec (de.prosiebensat1digital.oasisjsbridge.StringArrayCodec)
+  // All the strings are packed into one char[] with their lengths (-1 for null)
+  JniLocalRef<jobject> decodeStrings(const JArrayLocalRef<jchar> &chars, const JArrayLocalRef<jint> &lengths, bool asList) const;  // String[] or ArrayList
+  JArrayLocalRef<jchar> encodeStrings(const JObjectArrayLocalRef &strings, const JArrayLocalRef<jint> &lengths) const;
+
+  // SerializableCodec (de.prosiebensat1digital.oasisjsbridge.SerializableCodec)
+  JniLocalRef<jobject> decodeSerializable(const JniLocalRef<jobject> &byteBuffer, const JniRef<jclass> &serializableClass) const;
+  JniLocalRef<jobject> encodeSerializable(const JniRef<jobject> &value, const JniRef<jclass> &serializableClass) const;
+
   // JavaObjectWrapper (de.prosiebensat1digital.oasisjsbridge.JavaObjectWrapper)
   JniLocalRef<jobject> getOrCreateJavaObjectWrapper(const JniRef<jobject> &javaObject) const;
   JniLocalRef<jobject> javaObjectWrapperFromJavaObject(const JniRef<jobject> &javaObject) const;
@@ -84,10 +122,17 @@ public:
   JniLocalRef<jobject> newJsToJavaProxy(const JniRef<jobject> &javaObject, const JStringLocalRef &name) const;
 
   // List (java.util.List)
-  JniLocalRef<jobject> newList() const;
-  void addToList(const JniLocalRef<jobject> &list, const JniLocalRef<jobject> &element) const;
-  int getListLength(const JniLocalRef<jobject> &list) const;
-  JniLocalRef<jobject> getListElement(const JniLocalRef<jobject> &list, int i) const;
+  // Elements are transferred in bulk via an Object[] instead of one JNI call per element
+  JObjectArrayLocalRef listToArray(const JniLocalRef<jobject> &list) const;
+  JniLocalRef<jobject> newListFromArray(const JObjectArrayLocalRef &array) const;  // ArrayList
+
+  // Map (java.util.Map)
+  // Entries are read via an Object[] of Map.Entry instead of iterating over the entry set
+  JObjectArrayLocalRef mapEntriesToArray(const JniLocalRef<jobject> &map) const;
+  JniLocalRef<jobject> getMapEntryKey(const JniLocalRef<jobject> &entry) const;
+  JniLocalRef<jobject> getMapEntryValue(const JniLocalRef<jobject> &entry) const;
+  JniLocalRef<jobject> newMap(jsize entryCount) const;  // LinkedHashMap (pre-allocated)
+  void putMapEntry(const JniLocalRef<jobject> &map, const JStringLocalRef &key, const JniLocalRef<jobject> &value) const;
 
   // Parameter (de.prosiebensat1digital.oasisjsbridge.Parameter)
   JniLocalRef<jsBridgeParameter> newParameter(const JniLocalRef<jclass> &javaClass) const;
@@ -104,8 +149,13 @@ private:
   JniGlobalRef<jclass> m_numberClass;
   JniGlobalRef<jclass> m_stringClass;
   JniGlobalRef<jclass> m_listClass;
+  JniGlobalRef<jclass> m_mapClass;
+  JniGlobalRef<jclass> m_mapEntryClass;
+  JniGlobalRef<jclass> m_setClass;
+  JniGlobalRef<jclass> m_linkedHashMapClass;
   JniGlobalRef<jclass> m_javaClassClass;
   JniGlobalRef<jclass> m_arrayListClass;
+  JniGlobalRef<jclass> m_arraysClass;
   JniGlobalRef<jclass> m_jsBridgeClass;
   JniGlobalRef<jclass> m_jsExceptionClass;
   JniGlobalRef<jclass> m_illegalArgumentExceptionClass;
@@ -119,6 +169,11 @@ private:
   JniGlobalRef<jclass> m_jsonObjectWrapperClass;
   JniGlobalRef<jclass> m_javaObjectWrapperClass;
   JniGlobalRef<jclass> m_jsToJavaProxyClass;
+  JniGlobalRef<jclass> m_payloadCodecClass;
+  JniGlobalRef<jclass> m_stringArrayCodecClass;
+
+  const jmethodID m_javaClassGetName;
+  const jmethodID m_javaClassGetComponentType;
 
   const JsBridgeInterface m_jsBridgeInterface;
 };
@@ -16,193 +16,324 @@
 #include "JniInterfaces.h"
 #include "JniCache.h"
 #include "jni-helpers/JniContext.h"
+#include <cassert>
+
+
+// JniCachedId
+// ---
+
+jmethodID JniCachedId::getMethodId(const JniContext *jniContext, const JniRef<jclass> &javaClass) const {
+  assert(m_kind != Kind::Field);
+  return static_cast<jmethodID>(resolve(jniContext, javaClass));
+}
+
+jfieldID JniCachedId::getFieldId(const JniContext *jniContext, const JniRef<jclass> &javaClass) const {
+  assert(m_kind == Kind::Field);
+  return static_cast<jfieldID>(resolve(jniContext, javaClass));
+}
+
+void *JniCachedId::resolve(const JniContext *jniContext, const JniRef<jclass> &javaClass) const {
+  void *id = m_id.load(std::memory_order_acquire);
+  if (id != nullptr) {
+    return id;
+  }
+
+  // Concurrent lookups may happen but they all give the same ID
+  switch (m_kind) {
+    case Kind::Method:
+      id = jniContext->getMethodID(javaClass, m_name, m_signature);
+      break;
+    case Kind::StaticMethod:
+      id = jniContext->getStaticMethodID(javaClass, m_name, m_signature);
+      break;
+    case Kind::Field:
+      id = jniContext->getFieldID(javaClass, m_name, m_signature);
+      break;
+  }
+
+  if (id != nullptr) {
+    m_id.store(id, std::memory_order_release);
+  }
+  return id;
+}
 
 
 // JsBridgeInterface
 // ---
 
+namespace {
+  namespace JsBridgeMethodIds {
+    JniCachedId checkJsThread(JniCachedId::Kind::Method, "checkJsThread", "()V");
+    JniCachedId onDebuggerPending(JniCachedId::Kind::Method, "onDebuggerPending", "()V");
+    JniCachedId onDebuggerReady(JniCachedId::Kind::Method, "onDebuggerReady", "()V");
+    JniCachedId callJsModuleLoader(JniCachedId::Kind::Method, "callJsModuleLoader", "(Ljava/lang/String;)Ljava/lang/Object;");
+    JniCachedId storeJsModuleBytecode(JniCachedId::Kind::Method, "storeJsModuleBytecode", "(Ljava/lang/String;[B)V");
+    JniCachedId callJsModuleNameNormalizer(JniCachedId::Kind::Method, "callJsModuleNameNormalizer", "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;");
+    JniCachedId createJsLambdaProxy(JniCachedId::Kind::Method, "createJsLambdaProxy", "(Ljava/lang/String;L" JSBRIDGE_PKG_PATH "/Method;)Lkotlin/Function;");
+    JniCachedId appendConsoleMessage(JniCachedId::Kind::Method, "appendConsoleMessage", "(ILjava/lang/String;)V");
+    JniCachedId resolveDeferred(JniCachedId::Kind::Method, "resolveDeferred", "(Lkotlinx/coroutines/CompletableDeferred;Ljava/lang/Object;)V");
+    JniCachedId rejectDeferred(JniCachedId::Kind::Method, "rejectDeferred", "(Lkotlinx/coroutines/CompletableDeferred;L" JSBRIDGE_PKG_PATH "/JsException;)V");
+    JniCachedId createCompletableDeferred(JniCachedId::Kind::Method, "createCompletableDeferred", "()Lkotlinx/coroutines/CompletableDeferred;");
+    JniCachedId setUpJsPromise(JniCachedId::Kind::Method, "setUpJsPromise", "(JLkotlinx/coroutines/Deferred;)V");
+    JniCachedId addUnhandledJsPromiseException(JniCachedId::Kind::Method, "addUnhandledJsPromiseException", "(L" JSBRIDGE_PKG_PATH "/JsException;)V");
+    JniCachedId notifyJsExecutionTimeout(JniCachedId::Kind::Method, "notifyJsExecutionTimeout", "(J)V");
+  }
+}
+
 JsBridgeInterface::JsBridgeInterface(const JniCache *cache, const JniRef<jobject> &object)
  : JniInterface(cache, cache->getJsBridgeClass(), object) {
 }
 
+// static
+void JsBridgeInterface::preloadMethodIds(const JniContext *jniContext, const JniRef<jclass> &javaClass) {
+
+  JsBridgeMethodIds::checkJsThread.getMethodId(jniContext, javaClass);
+  JsBridgeMethodIds::onDebuggerPending.getMethodId(jniContext, javaClass);
+  JsBridgeMethodIds::onDebuggerReady.getMethodId(jniContext, javaClass);
+  JsBridgeMethodIds::callJsModuleLoader.getMethodId(jniContext, javaClass);
+  JsBridgeMethodIds::storeJsModuleBytecode.getMethodId(jniContext, javaClass);
+  JsBridgeMethodIds::callJsModuleNameNormalizer.getMethodId(jniContext, javaClass);
+  JsBridgeMethodIds::createJsLambdaProxy.getMethodId(jniContext, javaClass);
+  JsBridgeMethodIds::appendConsoleMessage.getMethodId(jniContext, javaClass);
+  JsBridgeMethodIds::resolveDeferred.getMethodId(jniContext, javaClass);
+  JsBridgeMethodIds::rejectDeferred.getMethodId(jniContext, javaClass);
+  JsBridgeMethodIds::createCompletableDeferred.getMethodId(jniContext, javaClass);
+  JsBridgeMethodIds::setUpJsPromise.getMethodId(jniContext, javaClass);
+  JsBridgeMethodIds::addUnhandledJsPromiseException.getMethodId(jniContext, javaClass);
+  JsBridgeMethodIds::notifyJsExecutionTimeout.getMethodId(jniContext, javaClass);
+}
+
 void JsBridgeInterface::checkJsThread() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "checkJsThread", "()V");
+  jmethodID methodId = JsBridgeMethodIds::checkJsThread.getMethodId(m_jniCache->getJniContext(), m_class);
   m_jniCache->getJniContext()->callVoidMethod(m_object, methodId);
 }
 
 void JsBridgeInterface::onDebuggerPending() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "onDebuggerPending", "()V");
+  jmethodID methodId = JsBridgeMethodIds::onDebuggerPending.getMethodId(m_jniCache->getJniContext(), m_class);
   m_jniCache->getJniContext()->callVoidMethod(m_object, methodId);
 }
 
 void JsBridgeInterface::onDebuggerReady() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "onDebuggerReady", "()V");
+  jmethodID methodId = JsBridgeMethodIds::onDebuggerReady.getMethodId(m_jniCache->getJniContext(), m_class);
   m_jniCache->getJniContext()->callVoidMethod(m_object, methodId);
 }
 
-JStringLocalRef JsBridgeInterface::callJsModuleLoader(const JStringLocalRef &moduleName) const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "callJsModuleLoader", "(Ljava/lang/String;)Ljava/lang/String;");
-  return m_jniCache->getJniContext()->callStringMethod(m_object, methodId, moduleName);
+JniLocalRef<jobject> JsBridgeInterface::callJsModuleLoader(const JStringLocalRef &moduleName) const {
+  jmethodID methodId = JsBridgeMethodIds::callJsModuleLoader.getMethodId(m_jniCache->getJniContext(), m_class);
+  return m_jniCache->getJniContext()->callObjectMethod(m_object, methodId, moduleName);
 }
 
-JniLocalRef<jobject> JsBridgeInterface::createJsLambdaProxy(
-    const JStringLocalRef &globalName, const JniRef<jsBridgeMethod> &method) const {
+void JsBridgeInterface::storeJsModuleBytecode(const JStringLocalRef &moduleName, const JArrayLocalRef<jbyte> &bytecode) const {
+  jmethodID methodId = JsBridgeMethodIds::storeJsModuleBytecode.getMethodId(m_jniCache->getJniContext(), m_class);
+  m_jniCache->getJniContext()->callVoidMethod(m_object, methodId, moduleName, bytecode);
+}
 
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-      m_class, "createJsLambdaProxy",
-      "(Ljava/lang/String;L" JSBRIDGE_PKG_PATH "/Method;)Lkotlin/Function;");
+JStringLocalRef JsBridgeInterface::callJsModuleNameNormalizer(const JStringLocalRef &baseModuleName, const JStringLocalRef &moduleName) const {
+  jmethodID methodId = JsBridgeMethodIds::callJsModuleNameNormalizer.getMethodId(m_jniCache->getJniContext(), m_class);
+  return m_jniCache->getJniContext()->callStringMethod(m_object, methodId, baseModuleName, moduleName);
+}
 
+JniLocalRef<jobject> JsBridgeInterface::createJsLambdaProxy(
+    const JStringLocalRef &globalName, const JniRef<jsBridgeMethod> &method) const {
+  jmethodID methodId = JsBridgeMethodIds::createJsLambdaProxy.getMethodId(m_jniCache->getJniContext(), m_class);
   return m_jniCache->getJniContext()->callObjectMethod(m_object, methodId, globalName, method);
 }
 
-void JsBridgeInterface::consoleLogHelper(const JStringLocalRef &logType, const JStringLocalRef &msg) const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-      m_class, "consoleLogHelper", "(Ljava/lang/String;Ljava/lang/String;)V");
-
-  m_jniCache->getJniContext()->callVoidMethod(m_object, methodId, logType, msg);
+void JsBridgeInterface::appendConsoleMessage(jint priority, const JStringLocalRef &message) const {
+  jmethodID methodId = JsBridgeMethodIds::appendConsoleMessage.getMethodId(m_jniCache->getJniContext(), m_class);
+  m_jniCache->getJniContext()->callVoidMethod(m_object, methodId, priority, message);
 }
 
 void JsBridgeInterface::resolveDeferred(const JniRef<jobject> &javaDeferred, const JValue &value) const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-      m_class, "resolveDeferred",
-      "(Lkotlinx/coroutines/CompletableDeferred;Ljava/lang/Object;)V");
-
+  jmethodID methodId = JsBridgeMethodIds::resolveDeferred.getMethodId(m_jniCache->getJniContext(), m_class);
   m_jniCache->getJniContext()->callVoidMethod(m_object, methodId, javaDeferred, value);
 }
 
 void JsBridgeInterface::rejectDeferred(const JniRef<jobject> &javaDeferred, const JValue &exception) const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-      m_class, "rejectDeferred",
-      "(Lkotlinx/coroutines/CompletableDeferred;L" JSBRIDGE_PKG_PATH "/JsException;)V");
-
+  jmethodID methodId = JsBridgeMethodIds::rejectDeferred.getMethodId(m_jniCache->getJniContext(), m_class);
   m_jniCache->getJniContext()->callVoidMethod(m_object, methodId, javaDeferred, exception);
 }
 
 JniLocalRef<jobject> JsBridgeInterface::createCompletableDeferred() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-        m_class, "createCompletableDeferred", "()Lkotlinx/coroutines/CompletableDeferred;");
+  jmethodID methodId = JsBridgeMethodIds::createCompletableDeferred.getMethodId(m_jniCache->getJniContext(), m_class);
   return m_jniCache->getJniContext()->callObjectMethod(m_object, methodId);
 }
 
-void JsBridgeInterface::setUpJsPromise(const JStringLocalRef &name, const JniRef<jobject> &deferred) const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-        m_class, "setUpJsPromise", "(Ljava/lang/String;Lkotlinx/coroutines/Deferred;)V");
-  m_jniCache->getJniContext()->callVoidMethod(m_object, methodId, name, deferred);
+void JsBridgeInterface::setUpJsPromise(jlong promiseObjectHandle, const JniRef<jobject> &deferred) const {
+  jmethodID methodId = JsBridgeMethodIds::setUpJsPromise.getMethodId(m_jniCache->getJniContext(), m_class);
+  m_jniCache->getJniContext()->callVoidMethod(m_object, methodId, promiseObjectHandle, deferred);
 }
 
 void JsBridgeInterface::addUnhandledJsPromiseException(const JValue &exception) const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-          m_class, "addUnhandledJsPromiseException", "(L" JSBRIDGE_PKG_PATH "/JsException;)V");
+  jmethodID methodId = JsBridgeMethodIds::addUnhandledJsPromiseException.getMethodId(m_jniCache->getJniContext(), m_class);
   m_jniCache->getJniContext()->callVoidMethod(m_object, methodId, exception);
 }
 
+void JsBridgeInterface::notifyJsExecutionTimeout(jlong timeoutMs) const {
+  jmethodID methodId = JsBridgeMethodIds::notifyJsExecutionTimeout.getMethodId(m_jniCache->getJniContext(), m_class);
+  m_jniCache->getJniContext()->callVoidMethod(m_object, methodId, timeoutMs);
+}
+
 
 // MethodInterface
 // ---
 
+namespace {
+  namespace MethodMethodIds {
+    JniCachedId getJavaMethod(JniCachedId::Kind::Method, "getJavaMethod", "()Ljava/lang/reflect/Method;");
+    JniCachedId getName(JniCachedId::Kind::Method, "getName", "()Ljava/lang/String;");
+    JniCachedId callJavaLambda(JniCachedId::Kind::Method, "callJavaLambda", "(Ljava/lang/Object;[Ljava/lang/Object;)Ljava/lang/Object;");
+    JniCachedId getUnboxedLambdaDescriptor(JniCachedId::Kind::Method, "getUnboxedLambdaDescriptor", "()Ljava/lang/String;");
+    JniCachedId getReturnParameter(JniCachedId::Kind::Method, "getReturnParameter", "()L" JSBRIDGE_PKG_PATH "/Parameter;");
+    JniCachedId getParameters(JniCachedId::Kind::Method, "getParameters", "()[L" JSBRIDGE_PKG_PATH "/Parameter;");
+    JniCachedId isVarArgs(JniCachedId::Kind::Method, "isVarArgs", "()Z");
+    JniCachedId getTypeSignatures(JniCachedId::Kind::Method, "getTypeSignatures", "()Ljava/lang/String;");
+  }
+}
+
 MethodInterface::MethodInterface(const JniCache *cache, const JniRef<jsBridgeMethod> &method)
  : JniInterface(cache, cache->getJsBridgeMethodClass(), method) {
 }
 
+// static
+void MethodInterface::preloadMethodIds(const JniContext *jniContext, const JniRef<jclass> &javaClass) {
+
+  MethodMethodIds::getJavaMethod.getMethodId(jniContext, javaClass);
+  MethodMethodIds::getName.getMethodId(jniContext, javaClass);
+  MethodMethodIds::callJavaLambda.getMethodId(jniContext, javaClass);
+  MethodMethodIds::getUnboxedLambdaDescriptor.getMethodId(jniContext, javaClass);
+  MethodMethodIds::getReturnParameter.getMethodId(jniContext, javaClass);
+  MethodMethodIds::getParameters.getMethodId(jniContext, javaClass);
+  MethodMethodIds::isVarArgs.getMethodId(jniContext, javaClass);
+  MethodMethodIds::getTypeSignatures.getMethodId(jniContext, javaClass);
+}
+
 JniLocalRef<jobject> MethodInterface::getJavaMethod() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getJavaMethod", "()Ljava/lang/reflect/Method;");
+  jmethodID methodId = MethodMethodIds::getJavaMethod.getMethodId(m_jniCache->getJniContext(), m_class);
   return m_jniCache->getJniContext()->callObjectMethod(m_object, methodId);
 }
 
 JStringLocalRef MethodInterface::getName() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getName", "()Ljava/lang/String;");
+  jmethodID methodId = MethodMethodIds::getName.getMethodId(m_jniCache->getJniContext(), m_class);
   return m_jniCache->getJniContext()->callStringMethod(m_object, methodId);
 }
 
 JniLocalRef<jobject> MethodInterface::callJavaLambda(const JniRef<jobject> &lambda, const JObjectArrayLocalRef &args) const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-          m_class, "callJavaLambda",
-          "(Ljava/lang/Object;[Ljava/lang/Object;)Ljava/lang/Object;");
-
+  jmethodID methodId = MethodMethodIds::callJavaLambda.getMethodId(m_jniCache->getJniContext(), m_class);
   return m_jniCache->getJniContext()->callObjectMethod(m_object, methodId, lambda, args);
 }
 
-JniLocalRef<jsBridgeParameter> MethodInterface::getReturnParameter() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-        m_class, "getReturnParameter",
-        "()L" JSBRIDGE_PKG_PATH "/Parameter;");
+JStringLocalRef MethodInterface::getUnboxedLambdaDescriptor() const {
+  jmethodID methodId = MethodMethodIds::getUnboxedLambdaDescriptor.getMethodId(m_jniCache->getJniContext(), m_class);
+  return m_jniCache->getJniContext()->callStringMethod(m_object, methodId);
+}
 
+JniLocalRef<jsBridgeParameter> MethodInterface::getReturnParameter() const {
+  jmethodID methodId = MethodMethodIds::getReturnParameter.getMethodId(m_jniCache->getJniContext(), m_class);
   return m_jniCache->getJniContext()->callObjectMethod<jsBridgeParameter>(m_object, methodId);
 }
 
 JObjectArrayLocalRef MethodInterface::getParameters() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-        m_class, "getParameters", "()[L" JSBRIDGE_PKG_PATH "/Parameter;");
-
+  jmethodID methodId = MethodMethodIds::getParameters.getMethodId(m_jniCache->getJniContext(), m_class);
   return JObjectArrayLocalRef(m_jniCache->getJniContext()->callObjectMethod<jobjectArray>(m_object, methodId));
 }
 
 jboolean MethodInterface::isVarArgs() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "isVarArgs", "()Z");
+  jmethodID methodId = MethodMethodIds::isVarArgs.getMethodId(m_jniCache->getJniContext(), m_class);
   return m_jniCache->getJniContext()->callBooleanMethod(m_object, methodId);
 }
 
+JStringLocalRef MethodInterface::getTypeSignatures() const {
+  jmethodID methodId = MethodMethodIds::getTypeSignatures.getMethodId(m_jniCache->getJniContext(), m_class);
+  return m_jniCache->getJniContext()->callStringMethod(m_object, methodId);
+}
+
 
 // ParameterInterface
 // ---
 
+namespace {
+  namespace ParameterMethodIds {
+    JniCachedId getInvokeMethod(JniCachedId::Kind::Method, "getInvokeMethod", "()L" JSBRIDGE_PKG_PATH "/Method;");
+    JniCachedId getMethods(JniCachedId::Kind::Method, "getMethods", "()[L" JSBRIDGE_PKG_PATH "/Method;");
+    JniCachedId getJava(JniCachedId::Kind::Method, "getJava", "()Ljava/lang/Class;");
+    JniCachedId getJavaName(JniCachedId::Kind::Method, "getJavaName", "()Ljava/lang/String;");
+    JniCachedId isNullable(JniCachedId::Kind::Method, "isNullable", "()Z");
+    JniCachedId getGenericParameter(JniCachedId::Kind::Method, "getGenericParameter", "()L" JSBRIDGE_PKG_PATH "/Parameter;");
+    JniCachedId getTypeSignature(JniCachedId::Kind::Method, "getTypeSignature", "()Ljava/lang/String;");
+    JniCachedId getName(JniCachedId::Kind::Method, "getName", "()Ljava/lang/String;");
+    JniCachedId getParentMethod(JniCachedId::Kind::Method, "getParentMethod", "()L" JSBRIDGE_PKG_PATH "/Method;");
+    JniCachedId getParentMethodName(JniCachedId::Kind::Method, "getParentMethodName", "()Ljava/lang/String;");
+  }
+}
+
 ParameterInterface::ParameterInterface(const JniCache *cache, const JniRef<jsBridgeParameter> &parameter)
  : JniInterface(cache, cache->getJsBridgeParameterClass(), parameter) {
 }
 
+// static
+void ParameterInterface::preloadMethodIds(const JniContext *jniContext, const JniRef<jclass> &javaClass) {
+
+  ParameterMethodIds::getInvokeMethod.getMethodId(jniContext, javaClass);
+  ParameterMethodIds::getMethods.getMethodId(jniContext, javaClass);
+  ParameterMethodIds::getJava.getMethodId(jniContext, javaClass);
+  ParameterMethodIds::getJavaName.getMethodId(jniContext, javaClass);
+  ParameterMethodIds::isNullable.getMethodId(jniContext, javaClass);
+  ParameterMethodIds::getGenericParameter.getMethodId(jniContext, javaClass);
+  ParameterMethodIds::getTypeSignature.getMethodId(jniContext, javaClass);
+  ParameterMethodIds::getName.getMethodId(jniContext, javaClass);
+  ParameterMethodIds::getParentMethod.getMethodId(jniContext, javaClass);
+  ParameterMethodIds::getParentMethodName.getMethodId(jniContext, javaClass);
+}
 
-JniLocalRef<jsBridgeMethod> ParameterInterface::getInvokeMethod() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-      m_class,
-      "getInvokeMethod",
-      "()L" JSBRIDGE_PKG_PATH "/Method;"
-  );
 
+JniLocalRef<jsBridgeMethod> ParameterInterface::getInvokeMethod() const {
+  jmethodID methodId = ParameterMethodIds::getInvokeMethod.getMethodId(m_jniCache->getJniContext(), m_class);
   return m_jniCache->getJniContext()->callObjectMethod<jsBridgeMethod>(m_object, methodId);
 }
 
 JObjectArrayLocalRef ParameterInterface::getMethods() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(
-          m_class,
-          "getMethods",
-          "()[L" JSBRIDGE_PKG_PATH "/Method;"
-  );
-
+  jmethodID methodId = ParameterMethodIds::getMethods.getMethodId(m_jniCache->getJniContext(), m_class);
   auto localRef = m_jniCache->getJniContext()->callObjectMethod<jobjectArray>(m_object, methodId);
   return JObjectArrayLocalRef(localRef);
 }
 
 JniLocalRef<jclass> ParameterInterface::getJava() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getJava", "()Ljava/lang/Class;");
+  jmethodID methodId = ParameterMethodIds::getJava.getMethodId(m_jniCache->getJniContext(), m_class);
   return m_jniCache->getJniContext()->callObjectMethod<jclass>(m_object, methodId);
 }
 
 JStringLocalRef ParameterInterface::getJavaName() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getJavaName", "()Ljava/lang/String;");
+  jmethodID methodId = ParameterMethodIds::getJavaName.getMethodId(m_jniCache->getJniContext(), m_class);
   return m_jniCache->getJniContext()->callStringMethod(m_object, methodId);
 }
 
 jboolean ParameterInterface::isNullable() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "isNullable", "()Z");
+  jmethodID methodId = ParameterMethodIds::isNullable.getMethodId(m_jniCache->getJniContext(), m_class);
   return m_jniCache->getJniContext()->callBooleanMethod(m_object, methodId);
 }
 
 JniLocalRef<jsBridgeParameter> ParameterInterface::getGenericParameter() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getGenericParameter", "()L" JSBRIDGE_PKG_PATH "/Parameter;");
+  jmethodID methodId = ParameterMethodIds::getGenericParameter.getMethodId(m_jniCache->getJniContext(), m_class);
   return m_jniCache->getJniContext()->callObjectMethod<jsBridgeParameter>(m_object, methodId);
 }
 
+JStringLocalRef ParameterInterface::getTypeSignature() const {
+  jmethodID methodId = ParameterMethodIds::getTypeSignature.getMethodId(m_jniCache->getJniContext(), m_class);
+  return m_jniCache->getJniContext()->callStringMethod(m_object, methodId);
+}
+
 JStringLocalRef ParameterInterface::getName() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getName", "()Ljava/lang/String;");
+  jmethodID methodId = ParameterMethodIds::getName.getMethodId(m_jniCache->getJniContext(), m_class);
   return m_jniCache->getJniContext()->callStringMethod(m_object, methodId);
 }
 
 JniLocalRef<jsBridgeMethod> ParameterInterface::getParentMethod() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getParentMethod", "()L" JSBRIDGE_PKG_PATH "/Method;");
+  jmethodID methodId = ParameterMethodIds::getParentMethod.getMethodId(m_jniCache->getJniContext(), m_class);
   return m_jniCache->getJniContext()->callObjectMethod<jsBridgeMethod>(m_object, methodId);
 }
 
 JStringLocalRef ParameterInterface::getParentMethodName() const {
-  static thread_local jmethodID methodId = m_jniCache->getJniContext()->getMethodID(m_class, "getParentMethodName", "()Ljava/lang/String;");
+  jmethodID methodId = ParameterMethodIds::getParentMethodName.getMethodId(m_jniCache->getJniContext(), m_class);
   return m_jniCache->getJniContext()->callStringMethod(m_object, methodId);
 }
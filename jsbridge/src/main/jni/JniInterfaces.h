@@ -17,12 +17,39 @@
 #define _JSBRIDGE_JNIINTERFACES_H
 
 #include "JniTypes.h"
+#include "jni-helpers/JArrayLocalRef.h"
 #include "jni-helpers/JniGlobalRef.h"
 #include "jni-helpers/JObjectArrayLocalRef.h"
 #include "jni-helpers/JStringLocalRef.h"
+#include <atomic>
 #include <jni.h>
 
 class JniCache;
+class JniContext;
+
+// ID of a Java method or field, resolved once per process when first used or eagerly via
+// JniCache::preload() (JNI IDs stay valid for all the threads as long as the class is loaded)
+class JniCachedId {
+public:
+  enum class Kind { Method, StaticMethod, Field };
+
+  constexpr JniCachedId(Kind kind, const char *name, const char *signature)
+   : m_kind(kind), m_name(name), m_signature(signature) {}
+
+  JniCachedId(const JniCachedId &) = delete;
+  JniCachedId &operator=(const JniCachedId &) = delete;
+
+  jmethodID getMethodId(const JniContext *, const JniRef<jclass> &) const;
+  jfieldID getFieldId(const JniContext *, const JniRef<jclass> &) const;
+
+private:
+  void *resolve(const JniContext *, const JniRef<jclass> &) const;
+
+  const Kind m_kind;
+  const char * const m_name;
+  const char * const m_signature;
+  mutable std::atomic<void *> m_id { nullptr };
+};
 
 // Base class for a JniInterface: access to methods of a Java instances
 template <class T>
@@ -44,17 +71,22 @@ class JsBridgeInterface : public JniInterface<jobject> {
 public:
   JsBridgeInterface(const JniCache *, const JniRef<jobject> &);
 
+  static void preloadMethodIds(const JniContext *, const JniRef<jclass> &);
+
   void checkJsThread() const;
   void onDebuggerPending() const;
   void onDebuggerReady() const;
-  JStringLocalRef callJsModuleLoader(const JStringLocalRef &moduleName) const;
+  JniLocalRef<jobject> callJsModuleLoader(const JStringLocalRef &moduleName) const;
+  void storeJsModuleBytecode(const JStringLocalRef &moduleName, const JArrayLocalRef<jbyte> &bytecode) const;
+  JStringLocalRef callJsModuleNameNormalizer(const JStringLocalRef &baseModuleName, const JStringLocalRef &moduleName) const;
   JniLocalRef<jobject> createJsLambdaProxy(const JStringLocalRef &, const JniRef<jsBridgeMethod> &) const;
-  void consoleLogHelper(const JStringLocalRef &logType, const JStringLocalRef &msg) const;
+  void appendConsoleMessage(jint priority, const JStringLocalRef &message) const;
   void resolveDeferred(const JniRef<jobject> &javaDeferred, const JValue &) const;
   void rejectDeferred(const JniRef<jobject> &javaDeferred, const JValue &exception) const;
   JniLocalRef<jobject> createCompletableDeferred() const;
-  void setUpJsPromise(const JStringLocalRef &, const JniRef<jobject> &deferred) const;
+  void setUpJsPromise(jlong promiseObjectHandle, const JniRef<jobject> &deferred) const;
   void addUnhandledJsPromiseException(const JValue &exception) const;
+  void notifyJsExecutionTimeout(jlong timeoutMs) const;
 };
 
 // de.prosiebensat1digital.oasisjsbridge.Method
@@ -62,12 +94,16 @@ class MethodInterface : public JniInterface<jsBridgeMethod> {
 public:
   MethodInterface(const JniCache *, const JniRef<jsBridgeMethod> &);
 
+  static void preloadMethodIds(const JniContext *, const JniRef<jclass> &);
+
   JniLocalRef<jobject> getJavaMethod() const;
   JStringLocalRef getName() const;
   JniLocalRef<jobject> callJavaLambda(const JniRef<jobject> &, const JObjectArrayLocalRef &) const;
+  JStringLocalRef getUnboxedLambdaDescriptor() const;
   JniLocalRef<jsBridgeParameter> getReturnParameter() const;
   JObjectArrayLocalRef getParameters() const;
   jboolean isVarArgs() const;
+  JStringLocalRef getTypeSignatures() const;
 };
 
 // de.prosiebensat1digital.oasisjsbridge.Parameter
@@ -75,12 +111,15 @@ class ParameterInterface : public JniInterface<jsBridgeParameter> {
 public:
   ParameterInterface(const JniCache *, const JniRef<jsBridgeParameter> &);
 
+  static void preloadMethodIds(const JniContext *, const JniRef<jclass> &);
+
   JniLocalRef<jsBridgeMethod> getInvokeMethod() const;
   JObjectArrayLocalRef getMethods() const;
   JniLocalRef<jclass> getJava() const;
   JStringLocalRef getJavaName() const;
   jboolean isNullable() const;
   JniLocalRef<jsBridgeParameter> getGenericParameter() const;
+  JStringLocalRef getTypeSignature() const;
   JStringLocalRef getName() const;
   JniLocalRef<jsBridgeMethod> getParentMethod() const;
   JStringLocalRef getParentMethodName() const;
@@ -19,11 +19,19 @@
 #ifndef _JSBRIDGE_JSBRIDGECONTEXT_H
 #define _JSBRIDGE_JSBRIDGECONTEXT_H
 
+#include "ConversionStats.h"
+#include "CppWrapperCounters.h"
 #include "JavaTypeProvider.h"
+#include "JsCommandQueue.h"
+#include "JsConsole.h"
+#include "jni-helpers/JArrayLocalRef.h"
 #include "jni-helpers/JniLocalRef.h"
 #include "jni-helpers/JniContext.h"
 #include "jni-helpers/JObjectArrayLocalRef.h"
+#include <android/asset_manager.h>
+#include <cstdint>
 #include <jni.h>
+#include <memory>
 #include <string>
 
 #if defined(DUKTAPE)
@@ -32,12 +40,25 @@
 # include "quickjs/quickjs.h"
 #endif
 
+class CallTracer;
+class DuktapePromise;
 class DuktapeUtils;
 class ExceptionHandler;
+class ExecutionDeadline;
+class JavaCallBindings;
 class JavaType;
 class JniCache;
 class JObjectArrayLocalRef;
+class JsModuleRegistry;
+class JsProfiler;
+class JsRuntime;
+class JsValueTable;
+class JsWrapperCache;
+class LocalStorage;
+class PoolAllocator;
 class QuickJsUtils;
+class ScratchArena;
+class TrafficRecorder;
 
 // JS context, delegating operations to the JS engine.
 class JsBridgeContext {
@@ -49,43 +70,279 @@ public:
 
   ~JsBridgeContext();
 
+  // JS engine settings (0: engine default)
+  struct EngineSettings {
+    size_t maxStackSize = 0;  // QuickJS only (no effect as long as CONFIG_STACK_CHECK is disabled)
+    size_t memoryLimit = 0;  // QuickJS (and Duktape with poolAllocator)
+    size_t gcThreshold = 0;  // QuickJS only
+    int regExpCacheSize = 0;  // QuickJS only (see JS_SetRegExpCacheSize())
+    bool poolAllocator = true;  // see PoolAllocator
+    long long executionTimeoutMs = 0;  // see ExecutionDeadline
+    bool preloadJniCache = false;  // see JniCache::preload()
+    const JsBridgeContext *sharedRuntimeContext = nullptr;  // QuickJS only: context whose runtime is shared (see JsRuntime)
+  };
+
   // Must be called immediately after the constructor
-  void init(JniContext *jniContext, const JniLocalRef<jobject> &jsBridgeObject);
+  void init(JniContext *jniContext, const JniLocalRef<jobject> &jsBridgeObject, const EngineSettings &engineSettings);
+
+  void runGc();
+
+  // Run the GC while the JS thread is idle and allow the given size (0: engine default) to be
+  // allocated before the engine triggers a GC itself
+  void runIdleGc(size_t allocationThreshold);
+
+  // Run the GC and release the native caches (types, compiled snippets, free pool chunks) and,
+  // if critical, also compact the JsValue table
+  void onMemoryPressure(bool critical);
+
+  // Size in bytes of the memory currently allocated by the JS engine, or -1 if unknown
+  long long getHeapSize() const;
+
+  // Shrink the property tables of the global object, of its properties (e.g. the registered Java
+  // and JS objects) and of their prototypes to their current size, e.g. once the startup
+  // registrations and evaluations are done, and return the reclaimed size in bytes (-1: unknown)
+  // Note: only supported on Duktape (no-op returning 0 on QuickJS)
+  long long compactHeap();
+
+  // When the number of JNI global refs held by the bridge reaches the given limit (0: no limit),
+  // checkJniGlobalRefLimit() runs the GC to release the global refs of the unreachable JS
+  // wrappers (e.g. of Java objects and lambdas, promise callbacks) before the global reference
+  // table of ART overflows. It is checked on each JNI entry.
+  void setJniGlobalRefLimit(size_t limit) { m_jniGlobalRefLimit = limit; m_nextJniGlobalRefGcCount = limit; }
+  void checkJniGlobalRefLimit();
+  // (QuickJS: including the global refs of the Java wrappers of all the contexts of the runtime,
+  // which share the same GC)
+  size_t getJniGlobalRefCount() const;
+
+  // JS engine (-1: unknown) and bridge memory statistics
+  struct MemoryUsage {
+    long long heapSize = -1;
+    long long objectCount = -1;
+    long long stringCount = -1;
+    long long atomCount = -1;
+    size_t cppWrapperCount = 0;
+    size_t javaRefCount = 0;
+    size_t jsValueCount = 0;  // values referenced by Java JsValue instances and pending Deferred promises
+    size_t jniGlobalRefCount = 0;  // all the JNI global refs currently held by the bridge
+  };
+
+  MemoryUsage getMemoryUsage() const;
+
+  // Durations (in ns) of the phases of the context creation, measured once by init() and by
+  // jniCreateContext() (total), also emitted as ATrace sections
+  struct StartupTimings {
+    int64_t totalNs = 0;
+    int64_t engineNs = 0;  // JS runtime (unless shared) and context
+    int64_t jniCacheNs = 0;  // JniCache construction (and preload)
+    int64_t bridgeSetupNs = 0;  // utils, exception handler, JsValue table, ...
+  };
+
+  StartupTimings &getStartupTimings() { return m_startupTimings; }
+
+  // Sampling JS profiler (see JsProfiler): stopProfiler() returns the .cpuprofile JSON
+  void startProfiler(long long samplingIntervalUs);
+  std::string stopProfiler();
+
+  // JS heap snapshot in the .heapsnapshot format of Chrome DevTools (see JsHeapSnapshot)
+  std::string takeHeapSnapshot();
 
   void startDebugger(int port);
   void cancelDebug();
 
   void enableModuleLoader();
+
+  // Register module sources (or bytecode) which are loaded natively on import instead of calling
+  // the Java module loader (QuickJS only)
+  void registerJsModules(const JObjectArrayLocalRef &names, const JObjectArrayLocalRef &contents, bool isBytecode);
+
+  // Normalize the imported module names via JsBridge.callJsModuleNameNormalizer(); the results
+  // are memoized for each (base, name) pair (QuickJS only)
+  void enableModuleNameNormalizer();
+
+  // Return the compiled bytecode of the modules loaded from source to the Java side so that it
+  // can be cached (see JsBridge.storeJsModuleBytecode())
+  void enableBytecodeCache() { m_bytecodeCacheEnabled = true; }
+  bool isBytecodeCacheEnabled() const { return m_bytecodeCacheEnabled; }
+
+  // Identifier of the bytecode format which changes with the JS engine version
+  std::string getBytecodeVersion() const;
+
+  // Convert primitive arrays (e.g. IntArray) from Java to JS typed arrays (e.g. Int32Array)
+  // instead of JS arrays
+  void enableTypedArrays() { m_typedArraysEnabled = true; }
+  // Convert repeated short Java strings to JS via a bounded cache (QuickJS only, see JsStringCache)
+  void enableStringCache(size_t entryCount);
+  bool areTypedArraysEnabled() const { return m_typedArraysEnabled; }
+
+  // Bind the methods of registered Java objects to Duktape lightfuncs instead of function objects
+  // (Duktape only, see JavaObject)
+  void enableLightJavaMethods() { m_lightJavaMethodsEnabled = true; }
+  bool areLightJavaMethodsEnabled() const { return m_lightJavaMethodsEnabled; }
+
+  // Install the native localStorage object whose items are persisted in the given file (see
+  // LocalStorage). The given initial items (e.g. migrated from another storage) are only added
+  // if their key is not stored yet.
+  void enableLocalStorage(const std::string &strFilePath, const JObjectArrayLocalRef &initialKeys,
+                          const JObjectArrayLocalRef &initialValues);
+  LocalStorage *getLocalStorage() const { return m_localStorage.get(); }
+
+  // Install the native console object (see JsConsole)
+  void enableConsole(JsConsole::Mode, int minPriority, size_t ringBufferSize);
+  JsConsole *getConsole() const { return m_console; }
+
   std::string getCurrentScriptOrModuleName(int level) const;
 
+  // If awaitJsPromise is set and a Java Deferred is given, a resulting promise which has not been
+  // fulfilled yet completes that Deferred, which is returned instead of the value (see
+  // Deferred::toJavaAwaited())
   JValue evaluateString(const JStringLocalRef &strSourceCode, const JniLocalRef<jsBridgeParameter> &returnParameter,
-                        bool awaitJsPromise) const;
-  void evaluateFileContent(const JStringLocalRef &strSourceCode, const std::string &strFileName, bool asModule) const;
+                        bool awaitJsPromise, const JniLocalRef<jobject> &awaitingDeferred = JniLocalRef<jobject>()) const;
+  // Evaluate the given code and convert the result to the given scalar type (see
+  // JavaTypeProvider::getScalarType()) without creating a type from a Parameter
+  JValue evaluateScalar(const JStringLocalRef &strSourceCode, JavaTypeId) const;
+  // Evaluate the given file content and, if returnBytecode is set, return its compiled bytecode
+  // (otherwise: a null reference)
+  JArrayLocalRef<jbyte> evaluateFileContent(const JStringLocalRef &strSourceCode, const std::string &strFileName,
+                                            bool asModule, bool returnBytecode) const;
+  // Evaluate the UTF-8 content of the given Android asset without any Java String conversion
+  void evaluateAsset(AAssetManager *assetManager, const std::string &strAssetPath, const std::string &strFileName,
+                     bool asModule) const;
+  // Evaluate the given built-in extension script (e.g. js/timers.js) via its bytecode, which is
+  // compiled by the first JsBridge instance and then shared by the whole process
+  void evaluateBuiltInAsset(AAssetManager *assetManager, const std::string &strAssetPath) const;
+  // Evaluate bytecode previously returned by evaluateFileContent() with the same bytecode version,
+  // optionally compressed as an LZ4 frame
+  void evaluateBytecode(const JArrayLocalRef<jbyte> &bytecode, const std::string &strFileName) const;
+  // Evaluate the (optionally LZ4-compressed) bytecode of the given Android asset, read from the
+  // memory-mapped asset or decompressed into an anonymous mapping without any Java byte array
+  void evaluateBytecodeAsset(AAssetManager *assetManager, const std::string &strAssetPath, const std::string &strFileName) const;
+
+  // Compile the given UTF-8 file contents to bytecode on up to threadCount worker threads, without
+  // any JS context, and return the bytecode of each file (or null if the compilation failed and
+  // errors[i] contains the JS exception) (QuickJS only)
+  // Note: can be called from any thread
+  static JObjectArrayLocalRef precompileFileContents(const JniContext *jniContext, const JObjectArrayLocalRef &fileNames,
+                                                     const JObjectArrayLocalRef &contents, bool asModule,
+                                                     int threadCount, JObjectArrayLocalRef &errors);
 
+  // With lazyMethods, the JS function of each method is only created when it is accessed for the
+  // first time. The objects registered with the same (non-empty) prototype name (i.e. the same
+  // interface) share the same JS prototype holding their methods on QuickJS (see JavaObject).
   void registerJavaObject(const std::string &strName, const JniLocalRef<jobject> &object,
-                                  const JObjectArrayLocalRef &methods);
+                                  const std::string &strPrototypeName, const JObjectArrayLocalRef &methods, bool lazyMethods);
   void registerJavaLambda(const std::string &strName, const JniLocalRef<jobject> &object,
                                   const JniLocalRef<jsBridgeMethod> &method);
-  void registerJsObject(const std::string &strName, const JObjectArrayLocalRef &methods, bool check);
-  void registerJsLambda(const std::string &strName, const JniLocalRef<jsBridgeMethod> &method);
-  JValue callJsMethod(const std::string &objectName, const JniLocalRef<jobject> &javaMethod,
+  // Registration returns the handle of a binding (stored in the JsValue table) which holds the
+  // JS object/lambda together with its C++ wrapper. It is released via releaseJsValueHandle().
+  jlong registerJsObject(const std::string &strName, const JObjectArrayLocalRef &methods, bool check);
+  jlong registerJsLambda(const std::string &strName, const JniLocalRef<jsBridgeMethod> &method);
+  // (methodIndex: index of the method in the array given on registration)
+  JValue callJsMethod(const std::string &objectName, jint methodIndex,
                               const JObjectArrayLocalRef &args, bool awaitJsPromise);
+  JValue callJsMethod(jlong bindingHandle, jint methodIndex,
+                              const JObjectArrayLocalRef &args, bool awaitJsPromise);
+  // Same as above with all the arguments packed into a long[] (see JavaScriptMethod::invoke())
+  JValue callJsMethod(jlong bindingHandle, jint methodIndex,
+                              const JArrayLocalRef<jlong> &packedArgs, bool awaitJsPromise);
   JValue callJsLambda(const std::string &strFunctionName, const JObjectArrayLocalRef &args,
                               bool awaitJsPromise);
+  JValue callJsLambda(jlong bindingHandle, const JObjectArrayLocalRef &args, bool awaitJsPromise);
+  // Call the JS lambda once for each element of argsArray (Object[][]) and return the results
+  JObjectArrayLocalRef callJsLambdaBatch(jlong bindingHandle, const JObjectArrayLocalRef &argsArray,
+                                         bool awaitJsPromise);
 
   void assignJsValue(const std::string &strGlobalName, const JStringLocalRef &strCode);
   void deleteJsValue(const std::string &strGlobalName);
   void copyJsValue(const std::string &strGlobalNameTo, const std::string &strGlobalNameFrom);
   void newJsFunction(const std::string &strGlobalName, const JObjectArrayLocalRef &args, const JStringLocalRef &strCode);
 
+  void copyJsValueHandle(const std::string &strGlobalNameTo, jlong handle);
+  void releaseJsValueHandle(jlong handle);
+
+  // Drain the given queue and run its commands (see JsCommandQueue). All the commands are run
+  // even if some of them fail, the first failure is then re-thrown.
+  void processJsCommands(JsCommandQueue *commandQueue);
+
+  // Native access to a JsValue without evaluating any generated JS code. The JsValue is given by
+  // its handle in the JsValue table or, if the handle is 0, by its global name.
+  //
+  // Convert the property with the given key (or, if strKey is null, the element with the given
+  // index) of the JS object, without converting the whole object
+  JValue getJsValueProperty(jlong handle, const std::string &strGlobalName, const JStringLocalRef &strKey, int index,
+                            const JniLocalRef<jsBridgeParameter> &returnParameter) const;
+  // Convert the Java value and assign it to the property with the given key (or, if strKey is
+  // null, to the element with the given index) of the JS object
+  void setJsValueProperty(jlong handle, const std::string &strGlobalName, const JStringLocalRef &strKey, int index,
+                          const JniLocalRef<jobject> &value, const JniLocalRef<jsBridgeParameter> &parameter) const;
+  // Call the method with the given name of the JS object (the arguments being converted according
+  // to their Java class) and convert its return value
+  JValue callJsValueMethod(jlong handle, const std::string &strGlobalName, const JStringLocalRef &strMethodName,
+                           const JObjectArrayLocalRef &args, const JniLocalRef<jsBridgeParameter> &returnParameter) const;
+  // Result of the JS typeof operator
+  const char *getJsValueType(jlong handle, const std::string &strGlobalName) const;
+
   void convertJavaValueToJs(const std::string &strGlobalName, const JniLocalRef<jobject> &javaValue, const JniLocalRef<jsBridgeParameter> &parameter);
 
-  void processPromiseQueue();
+  // Parse the UTF-8 JSON contained in the given direct ByteBuffer (length bytes from offset)
+  // without any intermediate Java string and assign the result to a global JS variable
+  void parseJsonBuffer(const std::string &strGlobalName, const JniLocalRef<jobject> &byteBuffer, jint offset, jint length);
+
+  // Assign the content of the given direct ByteBuffer (length bytes from offset) to a global JS
+  // variable, either as an ArrayBuffer or (if asUtf8String is set) as a decoded UTF-8 string.
+  // On QuickJS, the ArrayBuffer directly uses the native buffer memory (which is retained until
+  // the ArrayBuffer has been collected) instead of copying it.
+  void assignDirectBuffer(const std::string &strGlobalName, const JniLocalRef<jobject> &byteBuffer, jint offset, jint length,
+                          bool asUtf8String);
+
+  // Serialize the value of the given global JS variable into a native message which can be read
+  // by another JsBridgeContext (in any thread) and return its handle (QuickJS only)
+  jlong writeJsMessage(const std::string &strGlobalName) const;
+  // Deserialize the given message into a global JS variable (QuickJS only)
+  void readJsMessage(const std::string &strGlobalName, jlong messageHandle) const;
+  // Note: can be called from any thread
+  static void deleteJsMessage(jlong messageHandle);
+
+  // Create a SharedArrayBuffer of the given size in a global JS variable and return a direct
+  // ByteBuffer over the same memory, which holds its own reference to it (see
+  // releaseJsSharedBuffer()). The SharedArrayBuffer has a native notify() method (QuickJS only).
+  JniLocalRef<jobject> newJsSharedBuffer(const std::string &strGlobalName, jint size) const;
+  // Call the onnotify() method (if any) of the SharedArrayBuffer in the given global JS variable
+  // (QuickJS only)
+  void notifyJsSharedBuffer(const std::string &strGlobalName) const;
+  // Note: can be called from any thread
+  static void releaseJsSharedBuffer(void *data);
+  // Block until the JS notification counter of the shared buffer differs from the given one (or
+  // until the timeout, < 0: none) and return the current counter
+  // Note: can be called from any thread
+  static int waitForJsSharedBufferNotify(void *data, int notifyCount, long long timeoutMs);
+
+  // Serialize the value of the given global JS variable into a byte array which can be stored
+  // (e.g. to disk) and restored in another JsBridgeContext, even after a restart of the app.
+  // Functions and SharedArrayBuffers are not supported (QuickJS only).
+  JArrayLocalRef<jbyte> writeJsSnapshot(const std::string &strGlobalName) const;
+  // Deserialize the given snapshot into a global JS variable (QuickJS only)
+  void readJsSnapshot(const std::string &strGlobalName, const JArrayLocalRef<jbyte> &snapshot) const;
+
+  // Execute the pending jobs of the JS engine, at most maxJobs of them, until timeBudgetMs has
+  // elapsed (0: no limit) and until a yield is requested (see ExecutionDeadline::requestYield()),
+  // and return true if some jobs are still pending
+  bool processPromiseQueue(int maxJobs = 0, long long timeBudgetMs = 0);
+  bool isJobPending() const;
 
   JniContext *getJniContext() { return m_jniContext; }
   const JniContext *getJniContext() const { return m_jniContext; }
   const JniCache *getJniCache() const { return m_jniCache; }
   const ExceptionHandler *getExceptionHandler() const { return m_exceptionHandler; }
+  JsValueTable *getJsValueTable() const { return m_jsValueTable; }
+  CallTracer *getCallTracer() const { return m_callTracer; }
+  TrafficRecorder *getTrafficRecorder() const { return m_trafficRecorder; }
+  ScratchArena *getScratchArena() const { return m_scratchArena; }
+  ExecutionDeadline *getExecutionDeadline() const { return m_executionDeadline; }
+  JsProfiler *getProfiler() const { return m_profiler; }
+  PoolAllocator *getAllocator() const { return m_allocator; }
+#if defined(JSBRIDGE_CONVERSION_STATS)
+  ConversionStats *getConversionStats() const { return m_conversionStats; }
+#endif
 
   const JavaTypeProvider &getJavaTypeProvider() const { return m_javaTypeProvider; }
 
@@ -94,28 +351,76 @@ public:
 
   DuktapeUtils *getUtils() const { return m_utils; }
   duk_context *getDuktapeContext() const { return m_ctx; };
+  JavaCallBindings *getJavaCallBindings() const { return m_javaCallBindings; }
+  DuktapePromise *getPromise() const { return m_promise; }
 #elif defined(QUICKJS)
   static JsBridgeContext *getInstance(JSContext *);
 
   QuickJsUtils *getUtils() const { return m_utils; }
   JSContext *getQuickJsContext() const { return m_ctx; };
+  JsModuleRegistry *getModuleRegistry() const { return m_moduleRegistry; }
+  JsWrapperCache *getJsWrapperCache() const { return m_jsWrapperCache; }
+  JsRuntime *getJsRuntime() const { return m_jsRuntime; }
 #endif
 
 private:
+#if defined(DUKTAPE)
+  // Push the JsValue given by its handle or (if the handle is 0) by its global name
+  void pushJsValue(jlong handle, const std::string &strGlobalName) const;
+#elif defined(QUICKJS)
+  // Return the (duplicated) JsValue given by its handle or (if the handle is 0) by its global name
+  JSValue getJsValue(jlong handle, const std::string &strGlobalName) const;
+  // Set the (runtime-wide) module loader and normalizer dispatching to the importing context
+  void setModuleLoaderFuncs();
+#endif
+
+  // Compile and run the given UTF-8 source code
+  // Note: for QuickJS, the code must be zero-terminated (code[length] == '\0')
+  JArrayLocalRef<jbyte> evaluateUtf8FileContent(const char *code, size_t length, const std::string &strFileName,
+                                                bool asModule, bool returnBytecode) const;
+  // Evaluate the given (uncompressed) bytecode
+  void evaluateBytecode(const uint8_t *data, size_t size, const std::string &strFileName) const;
+  // Evaluate the given bytecode, decompressing it first if it is an LZ4 frame
+  void evaluateMaybeCompressedBytecode(const uint8_t *data, size_t size, const std::string &strFileName) const;
+
   // Updated on each Java -> Native call (and reset to nullptr afterwards)
   JniContext *m_jniContext = nullptr;
   JniCache *m_jniCache = nullptr;
   ExceptionHandler *m_exceptionHandler = nullptr;
+  JsValueTable *m_jsValueTable = nullptr;
+  CallTracer *m_callTracer = nullptr;
+  TrafficRecorder *m_trafficRecorder = nullptr;
+  ScratchArena *m_scratchArena = nullptr;
+  ExecutionDeadline *m_executionDeadline = nullptr;
+  JsProfiler *m_profiler = nullptr;
+  JsConsole *m_console = nullptr;
+#if defined(JSBRIDGE_CONVERSION_STATS)
+  ConversionStats *m_conversionStats = nullptr;
+#endif
+  StartupTimings m_startupTimings;
+  bool m_typedArraysEnabled = false;
+  bool m_lightJavaMethodsEnabled = false;
+  bool m_bytecodeCacheEnabled = false;
+  size_t m_jniGlobalRefLimit = 0;
+  size_t m_nextJniGlobalRefGcCount = 0;
+  PoolAllocator *m_allocator = nullptr;  // null when using the default allocator of the JS engine (QuickJS: owned by the JsRuntime)
+  std::shared_ptr<LocalStorage> m_localStorage;  // shared with the other contexts using the same file
 
   const JavaTypeProvider m_javaTypeProvider;
 
 #if defined(DUKTAPE)
   duk_context *m_ctx = nullptr;
   DuktapeUtils *m_utils = nullptr;
+  JavaCallBindings *m_javaCallBindings = nullptr;
+  DuktapePromise *m_promise = nullptr;
+  CppWrapperCounters m_cppWrapperCounters;
 #elif defined(QUICKJS)
+  JsRuntime *m_jsRuntime = nullptr;  // possibly shared with other contexts
   JSRuntime *m_runtime = nullptr;
   JSContext *m_ctx = nullptr;
   QuickJsUtils *m_utils = nullptr;
+  JsModuleRegistry *m_moduleRegistry = nullptr;
+  JsWrapperCache *m_jsWrapperCache = nullptr;
 #endif
 };
 
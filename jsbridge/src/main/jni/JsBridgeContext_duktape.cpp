@@ -18,20 +18,40 @@
  */
 #include "JsBridgeContext.h"
 
+#include "AssetBuffer.h"
+#include "DuktapePromise.h"
 #include "DuktapeUtils.h"
+#include "CallTracer.h"
 #include "ExceptionHandler.h"
+#include "ExecutionDeadline.h"
+#include "JavaCallBindings.h"
 #include "JavaObject.h"
 #include "JavaScriptLambda.h"
 #include "JavaScriptObject.h"
 #include "JniCache.h"
+#include "JsHeapSnapshot.h"
+#include "JsCompiledCodeCache.h"
+#include "JsConsole.h"
+#include "JsProfiler.h"
+#include "LocalStorage.h"
+#include "Lz4Frame.h"
+#include "JsValueTable.h"
+#include "PoolAllocator.h"
+#include "ScratchArena.h"
 #include "StackChecker.h"
+#include "TrafficRecorder.h"
+#include "custom_stringify.h"
 #include "log.h"
+#include "exceptions/JniException.h"
 #include "exceptions/JsException.h"
 #include "java-types/Deferred.h"
 #include "jni-helpers/JniGlobalRef.h"
 #include "jni-helpers/JObjectArrayLocalRef.h"
 #include "jni-helpers/JStringLocalRef.h"
 #include "duktape/duk_trans_socket.h"
+#include <algorithm>
+#include <cstring>
+#include <exception>
 #include <functional>
 #include <memory>
 #include <stdexcept>
@@ -42,11 +62,268 @@
 // ---
 
 namespace {
-  const char *JSBRIDGE_CPP_CLASS_PROP_NAME = "\xff\xffjsbridge_cpp";
+  // Duktape neither checks the version of the bytecode it loads nor validates it (loading
+  // incompatible bytecode is memory-unsafe) so the dumped bytecode is prefixed with a header
+  // containing the Duktape version
+  const jsize BYTECODE_HEADER_SIZE = 8;
+  const jbyte BYTECODE_HEADER[BYTECODE_HEADER_SIZE] = {
+    'J', 'S', 'B', 'D',
+    static_cast<jbyte>((DUK_VERSION >> 24) & 0xff), static_cast<jbyte>((DUK_VERSION >> 16) & 0xff),
+    static_cast<jbyte>((DUK_VERSION >> 8) & 0xff), static_cast<jbyte>(DUK_VERSION & 0xff)
+  };
+
+  // Serialize the compiled function on the top of the stack into a Java byte array
+  JArrayLocalRef<jbyte> dumpFunction(const JsBridgeContext *jsBridgeContext) {
+    duk_context *ctx = jsBridgeContext->getDuktapeContext();
+    CHECK_STACK(ctx);
+
+    duk_dup_top(ctx);
+    duk_dump_function(ctx);
+
+    duk_size_t size = 0;
+    const void *buf = duk_get_buffer(ctx, -1, &size);
+
+    JArrayLocalRef<jbyte> bytecode(jsBridgeContext->getJniContext(), BYTECODE_HEADER_SIZE + static_cast<jsize>(size));
+    bytecode.setRegion(0, BYTECODE_HEADER_SIZE, BYTECODE_HEADER);
+    bytecode.setRegion(BYTECODE_HEADER_SIZE, static_cast<jsize>(size), static_cast<const jbyte *>(buf));
+    duk_pop(ctx);
+
+    return bytecode;
+  }
+
+  bool hasValidBytecodeHeader(const uint8_t *data, size_t size) {
+    if (size < BYTECODE_HEADER_SIZE) {
+      return false;
+    }
+
+    const auto *header = reinterpret_cast<const jbyte *>(data);
+    return std::equal(header, header + BYTECODE_HEADER_SIZE, BYTECODE_HEADER);
+  }
+
+  // Compact the object on top of the stack, the values of its own data properties and their
+  // prototypes. The values are read from the property descriptors so that no getter is called.
+  void compactOwnPropertyValues(duk_context *ctx, bool skipJsValueTables) {
+    duk_compact(ctx, -1);
+
+    duk_enum(ctx, -1, DUK_ENUM_OWN_PROPERTIES_ONLY | DUK_ENUM_INCLUDE_NONENUMERABLE | DUK_ENUM_INCLUDE_HIDDEN | DUK_ENUM_INCLUDE_SYMBOLS);
+    while (duk_next(ctx, -1, 0 /*get_value*/)) {
+      if (skipJsValueTables && JsValueTable::isTablePropertyName(duk_get_string(ctx, -1))) {
+        duk_pop(ctx);  // key
+        continue;
+      }
+
+      duk_get_prop_desc(ctx, -3, 0);  // [... object enum key] => [... object enum descriptor]
+      duk_get_prop_string(ctx, -1, "value");  // undefined for accessors
+      if (duk_is_object(ctx, -1)) {
+        duk_compact(ctx, -1);
+        duk_get_prototype(ctx, -1);
+        duk_compact(ctx, -1);  // no-op if there is no prototype
+        duk_pop(ctx);  // prototype
+      }
+      duk_pop_2(ctx);  // descriptor + value
+    }
+    duk_pop(ctx);  // enum
+  }
+
+  duk_ret_t tryCompactObjects(duk_context *ctx, void *) {
+    // Global object with the registered Java and JS objects
+    duk_push_global_object(ctx);
+    compactOwnPropertyValues(ctx, false);
+    duk_pop(ctx);  // global object
+
+    // Global stash, without the (hidden) JsValue tables which are shrunk by JsValueTable::compact()
+    duk_push_global_stash(ctx);
+    compactOwnPropertyValues(ctx, true);
+    duk_pop(ctx);  // global stash
+
+    return 0;
+  }
 
+  // localStorage methods (magic: see below)
+  enum LocalStorageMethod {
+    Method_GetItem, Method_SetItem, Method_RemoveItem, Method_Clear, Method_Key, Method_Length
+  };
+
+  std::string toUtf8String(duk_context *ctx, duk_idx_t index) {
+    duk_size_t length = 0;
+    const char *str = duk_to_lstring(ctx, index, &length);
+    return std::string(str, length);
+  }
+
+  duk_ret_t localStorageMethod(duk_context *ctx) {
+    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    LocalStorage *localStorage = jsBridgeContext->getLocalStorage();
+    int magic = duk_get_current_magic(ctx);
+
+    static const int argCounts[] = { 1, 2, 1, 0, 1, 0 };
+    if (duk_get_top(ctx) < argCounts[magic]) {
+      return duk_error(ctx, DUK_ERR_TYPE_ERROR, "localStorage: %d argument(s) required, but only %d present",
+                       argCounts[magic], static_cast<int>(duk_get_top(ctx)));
+    }
+
+    try {
+      std::string value;
+      switch (magic) {
+        case Method_GetItem:
+          if (!localStorage->getItem(toUtf8String(ctx, 0), &value)) {
+            duk_push_null(ctx);
+          } else {
+            duk_push_lstring(ctx, value.data(), value.size());
+          }
+          return 1;
+
+        case Method_SetItem:
+          localStorage->setItem(toUtf8String(ctx, 0), toUtf8String(ctx, 1));
+          return 0;
+
+        case Method_RemoveItem:
+          localStorage->removeItem(toUtf8String(ctx, 0));
+          return 0;
+
+        case Method_Clear:
+          localStorage->clear();
+          return 0;
+
+        case Method_Key:
+          if (!localStorage->key(duk_to_uint32(ctx, 0), &value)) {
+            duk_push_null(ctx);
+          } else {
+            duk_push_lstring(ctx, value.data(), value.size());
+          }
+          return 1;
+
+        default:
+          duk_push_number(ctx, static_cast<duk_double_t>(localStorage->length()));
+          return 1;
+      }
+    } catch (const std::exception &e) {
+      jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return DUK_RET_ERROR;  // unreached
+    }
+  }
+
+  // Append the console representation of the value at the given index
+  void appendConsoleArg(duk_context *ctx, JsConsole::Mode mode, duk_idx_t index, std::string &message) {
+    if (duk_is_undefined(ctx, index)) {
+      message += "undefined";
+      return;
+    }
+
+    if (mode == JsConsole::Mode::AsJson && !duk_is_string(ctx, index)) {
+      if (custom_stringify(ctx, index, true) == DUK_EXEC_SUCCESS && duk_is_string(ctx, -1)) {
+        duk_size_t length = 0;
+        const char *str = duk_get_lstring(ctx, -1, &length);
+        message.append(str, length);
+        duk_pop(ctx);
+        return;
+      }
+      // Not serializable (e.g. function or cyclic object) => default string conversion
+      duk_pop(ctx);
+    }
+
+    duk_dup(ctx, index);
+    duk_size_t length = 0;
+    const char *str = duk_safe_to_lstring(ctx, -1, &length);
+    message.append(str, length);
+    duk_pop(ctx);
+  }
+
+  // console methods (magic: JsConsole::Method)
+  duk_ret_t consoleMethod(duk_context *ctx) {
+    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    JsConsole *console = jsBridgeContext->getConsole();
+    auto method = static_cast<JsConsole::Method>(duk_get_current_magic(ctx));
+
+    // Check the priority before converting anything
+    int priority = console->getEnabledPriority(method);
+    if (priority == 0) {
+      return 0;
+    }
+
+    duk_idx_t firstArgIndex = 0;
+    std::string message;
+    if (method == JsConsole::Method_Assert) {
+      if (duk_get_top(ctx) > 0 && duk_to_boolean(ctx, 0)) {
+        return 0;
+      }
+      firstArgIndex = 1;
+      message = "Assertion failed:";
+    }
+
+    try {
+      duk_idx_t top = duk_get_top(ctx);
+      for (duk_idx_t i = firstArgIndex; i < top; ++i) {
+        if (!message.empty()) {
+          message += ' ';
+        }
+        appendConsoleArg(ctx, console->getMode(), i, message);
+      }
+
+      console->append(priority, std::move(message));
+    } catch (const std::exception &e) {
+      jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return DUK_RET_ERROR;  // unreached
+    }
+    return 0;
+  }
+
+  duk_ret_t tryLoadFunction(duk_context *ctx, void *) {
+    duk_load_function(ctx);
+    return 1;
+  }
+
+  // Evaluate the given global code via its bytecode from the JsCompiledCodeCache, compiling and
+  // caching it with the given key if needed, and push the result (or the error)
+  duk_int_t pevalCachedCode(duk_context *ctx, const std::string &key, const char *code, size_t length) {
+    if (length > JsCompiledCodeCache::MAX_SOURCE_LENGTH) {
+      return duk_peval_lstring(ctx, code, length);
+    }
+
+    JsCompiledCodeCache &cache = JsCompiledCodeCache::getInstance();
+
+    std::shared_ptr<const std::string> bytecode = cache.find(key);
+    if (bytecode) {
+      void *buf = duk_push_fixed_buffer(ctx, bytecode->size());
+      memcpy(buf, bytecode->data(), bytecode->size());
+
+      if (duk_safe_call(ctx, tryLoadFunction, nullptr, 1, 1) != DUK_EXEC_SUCCESS) {
+        return DUK_EXEC_ERROR;
+      }
+    } else {
+      if (duk_pcompile_lstring(ctx, DUK_COMPILE_EVAL, code, length) != DUK_EXEC_SUCCESS) {
+        return DUK_EXEC_ERROR;
+      }
+
+      duk_dup_top(ctx);
+      duk_dump_function(ctx);
+      duk_size_t size = 0;
+      const void *buf = duk_get_buffer(ctx, -1, &size);
+      cache.add(key, std::string(static_cast<const char *>(buf), size));
+      duk_pop(ctx);
+    }
+
+    return duk_pcall(ctx, 0);
+  }
+
+#if defined(DUK_USE_DEBUGGER_SUPPORT)
   void debugger_detached(duk_context */*ctx*/, void *udata) {
       alog_info("Debugger detached, udata: %p\n", udata);
   }
+#endif
+
+  // Duktape allocation functions delegating to the PoolAllocator of the JsBridgeContext given as
+  // heap udata
+  void *poolAlloc(void *udata, duk_size_t size) {
+    return static_cast<JsBridgeContext *>(udata)->getAllocator()->allocate(size);
+  }
+
+  void *poolRealloc(void *udata, void *ptr, duk_size_t size) {
+    return static_cast<JsBridgeContext *>(udata)->getAllocator()->reallocate(ptr, size);
+  }
+
+  void poolFree(void *udata, void *ptr) {
+    static_cast<JsBridgeContext *>(udata)->getAllocator()->deallocate(ptr);
+  }
 
   // Java functions called from JS
   // ---
@@ -56,8 +333,52 @@ namespace {
       throw std::runtime_error(msg);
     }
   }  // extern "C"
+
+  // Heap walk (see jsbridge_duk_walk_heap())
+  void heapWalkNode(void *opaque, const void *ptr, const char *type, const char *name, duk_size_t selfSize) {
+    static_cast<JsHeapSnapshot *>(opaque)->addNode(ptr, type, name, selfSize);
+  }
+
+  void heapWalkEdge(void *opaque, const void *from, const void *to, const char *type, const char *name, duk_uint32_t index) {
+    static_cast<JsHeapSnapshot *>(opaque)->addEdge(from, to, type, name, index);
+  }
 } // anonymous namespace
 
+// Called by the Duktape executor (see DUK_USE_EXEC_TIMEOUT_CHECK in duk_config.h): sample the
+// JS call stack when profiling and abort the running script once the deadline of the current
+// evaluation has been exceeded
+duk_bool_t jsbridge_duk_exec_timeout_check(void *udata) {
+  auto jsBridgeContext = static_cast<JsBridgeContext *>(udata);
+
+  JsProfiler *profiler = jsBridgeContext->getProfiler();
+  if (profiler != nullptr && profiler->isSampleDue()) {
+    jsbridge_duk_stack_frame duktapeFrames[JsProfiler::MAX_STACK_DEPTH];
+    JsProfiler::Frame frames[JsProfiler::MAX_STACK_DEPTH];
+
+    duk_int_t frameCount = jsbridge_duk_get_stack_frames(jsBridgeContext->getDuktapeContext(), duktapeFrames, JsProfiler::MAX_STACK_DEPTH);
+    for (duk_int_t i = 0; i < frameCount; ++i) {
+      frames[i] = JsProfiler::Frame { duktapeFrames[i].function_name, duktapeFrames[i].file_name, duktapeFrames[i].line_number };
+    }
+    profiler->addSample(frames, frameCount);
+  }
+
+  ExecutionDeadline *executionDeadline = jsBridgeContext->getExecutionDeadline();
+  if (executionDeadline == nullptr || executionDeadline->getTimeoutMs() <= 0) {
+    return 0;
+  }
+
+  bool justExceeded = false;
+  if (!executionDeadline->check(&justExceeded)) {
+    return 0;
+  }
+
+  if (justExceeded) {
+    alog_warn("JS execution timeout (%lld ms) exceeded: interrupting the script", executionDeadline->getTimeoutMs());
+    jsBridgeContext->getJniCache()->getJsBridgeInterface().notifyJsExecutionTimeout(executionDeadline->getTimeoutMs());
+  }
+  return 1;
+}
+
 
 // Class methods
 // ---
@@ -70,34 +391,191 @@ JsBridgeContext::~JsBridgeContext() {
   // Delete the proxies before destroying the heap.
   duk_destroy_heap(m_ctx);
 
+  // Bulk release of the pooled memory
+  delete m_allocator;
+
+  delete m_jsValueTable;
+  delete m_promise;
   delete m_exceptionHandler;
   delete m_utils;
+  delete m_javaCallBindings;
   delete m_jniCache;
+  delete m_callTracer;
+  delete m_trafficRecorder;
+  delete m_scratchArena;
+  delete m_executionDeadline;
+  delete m_profiler;
+  delete m_console;
+#if defined(JSBRIDGE_CONVERSION_STATS)
+  delete m_conversionStats;
+#endif
 }
 
-void JsBridgeContext::init(JniContext *jniContext, const JniLocalRef<jobject> &jsBridgeObject) {
+void JsBridgeContext::init(JniContext *jniContext, const JniLocalRef<jobject> &jsBridgeObject, const EngineSettings &engineSettings) {
 
   m_jniContext = jniContext;
 
-  m_ctx = duk_create_heap(nullptr, nullptr, nullptr, nullptr, fatalErrorHandler);
+  {
+    TimedSection section("JsBridge engine creation", m_startupTimings.engineNs);
+
+    if (engineSettings.poolAllocator) {
+      m_allocator = new PoolAllocator();
+      m_allocator->setMemoryLimit(engineSettings.memoryLimit);
+      m_ctx = duk_create_heap(poolAlloc, poolRealloc, poolFree, this, fatalErrorHandler);
+    } else {
+      // The heap udata is also used to find our way back from a Duktape C callback (see getInstance())
+      m_ctx = duk_create_heap(nullptr, nullptr, nullptr, this, fatalErrorHandler);
+    }
+
+    if (!m_ctx) {
+      delete m_allocator;
+      m_allocator = nullptr;
+      throw std::bad_alloc();
+    }
+  }
 
-  if (!m_ctx) {
-    throw std::bad_alloc();
+  {
+    TimedSection section("JsBridge JniCache creation", m_startupTimings.jniCacheNs);
+    m_jniCache = new JniCache(this, jsBridgeObject);
+    if (engineSettings.preloadJniCache) {
+      m_jniCache->preload();
+    }
   }
 
-  m_jniCache = new JniCache(this, jsBridgeObject);
-  m_utils = new DuktapeUtils(jniContext, m_ctx);
+  TimedSection section("JsBridge setup", m_startupTimings.bridgeSetupNs);
+  m_callTracer = new CallTracer();
+  m_trafficRecorder = new TrafficRecorder();
+  m_scratchArena = new ScratchArena();
+  m_executionDeadline = new ExecutionDeadline();
+  m_executionDeadline->setTimeoutMs(engineSettings.executionTimeoutMs);
+  m_profiler = new JsProfiler();
+  m_executionDeadline->setProfiler(m_profiler);
+#if defined(JSBRIDGE_CONVERSION_STATS)
+  m_conversionStats = new ConversionStats();
+#endif
+  m_utils = new DuktapeUtils(jniContext, m_ctx, &m_cppWrapperCounters, m_scratchArena);
+  m_javaCallBindings = new JavaCallBindings();
   m_exceptionHandler = new ExceptionHandler(this);
+  m_jsValueTable = new JsValueTable(m_ctx);
+
+  // Native Promise (Duktape has no built-in one)
+  m_promise = new DuktapePromise(m_ctx, [this](duk_context *) {
+    // [... reason]
+    JsException jsException(this, -1);
+    JValue value(m_exceptionHandler->getJavaException(jsException));
+    m_jniCache->getJsBridgeInterface().addUnhandledJsPromiseException(value);
+  });
+}
 
-  // Stash the JsBridgeContext instance in the context, so we can find our way back from a Duktape C callback.
-  duk_push_global_stash(m_ctx);
-  duk_push_pointer(m_ctx, this);
-  duk_put_prop_string(m_ctx, -2, JSBRIDGE_CPP_CLASS_PROP_NAME);
-  duk_pop(m_ctx);
+void JsBridgeContext::runGc() {
+  duk_gc(m_ctx, 0);
 }
 
-void JsBridgeContext::startDebugger(int port) {
+void JsBridgeContext::runIdleGc(size_t) {
+  // Most of the garbage is already freed via reference counting: the (voluntary) mark-and-sweep
+  // trigger is based on an allocation count which is not adjusted here
+  duk_gc(m_ctx, 0);
+}
+
+void JsBridgeContext::enableStringCache(size_t) {
+  // Not needed: Duktape already interns all its strings (heap string table)
+}
+
+void JsBridgeContext::onMemoryPressure(bool critical) {
+  m_javaTypeProvider.clearCaches();
+  JsCompiledCodeCache::getInstance().clear();
+  if (critical) {
+    m_jsValueTable->compact();
+  }
+
+  // Also shrink the property tables of the objects when critical
+  duk_gc(m_ctx, critical ? DUK_GC_COMPACT : 0);
+
+  if (m_allocator != nullptr) {
+    m_allocator->releaseFreeChunks();
+  }
+}
+
+long long JsBridgeContext::getHeapSize() const {
+  return m_allocator != nullptr ? static_cast<long long>(m_allocator->getAllocatedSize()) : -1;
+}
+
+long long JsBridgeContext::compactHeap() {
+  CHECK_STACK(m_ctx);
+
+  const long long heapSizeBefore = getHeapSize();
+
+  // Note: duk_compact() may fail (e.g. out of memory)
+  if (duk_safe_call(m_ctx, tryCompactObjects, nullptr, 0, 1) != DUK_EXEC_SUCCESS) {
+    alog_warn("Could not compact the JS objects: %s", duk_safe_to_string(m_ctx, -1));
+  }
+  duk_pop(m_ctx);  // safe call result
+
+  if (m_allocator == nullptr) {
+    return -1;
+  }
 
+  const long long reclaimedSize = std::max(heapSizeBefore - getHeapSize(), 0LL);
+  m_allocator->releaseFreeChunks();
+  return reclaimedSize;
+}
+
+JsBridgeContext::MemoryUsage JsBridgeContext::getMemoryUsage() const {
+  // Duktape does not expose any object/string statistics
+  MemoryUsage memoryUsage;
+  memoryUsage.heapSize = getHeapSize();
+  memoryUsage.cppWrapperCount = m_cppWrapperCounters.cppWrapperCount;
+  memoryUsage.javaRefCount = m_cppWrapperCounters.javaRefCount;
+  memoryUsage.jsValueCount = m_jsValueTable->size();
+  memoryUsage.jniGlobalRefCount = getJniGlobalRefCount();
+  return memoryUsage;
+}
+
+size_t JsBridgeContext::getJniGlobalRefCount() const {
+  return m_jniContext->getGlobalRefCount();
+}
+
+void JsBridgeContext::checkJniGlobalRefLimit() {
+  if (m_jniGlobalRefLimit == 0 || getJniGlobalRefCount() < m_nextJniGlobalRefGcCount) {
+    return;
+  }
+
+  runGc();
+
+  // Still (mostly) reachable: only run the GC again after another eighth of the limit
+  const size_t globalRefCount = getJniGlobalRefCount();
+  m_nextJniGlobalRefGcCount = std::max(m_jniGlobalRefLimit, globalRefCount + std::max(m_jniGlobalRefLimit / 8, size_t(1)));
+  if (globalRefCount >= m_jniGlobalRefLimit) {
+    alog_warn("%zu JNI global refs are still held after the GC (limit: %zu)", globalRefCount, m_jniGlobalRefLimit);
+  }
+}
+
+std::string JsBridgeContext::takeHeapSnapshot() {
+  // Only keep the live objects
+  runGc();
+
+  // The references held by the bridge (e.g. the JsValue table) are all stored in the global stash
+  // so that they are reachable from the heap roots
+  JsHeapSnapshot snapshot;
+  const jsbridge_duk_heap_walk_funcs heapWalkFuncs = { heapWalkNode, heapWalkEdge };
+  jsbridge_duk_walk_heap(m_ctx, &heapWalkFuncs, &snapshot);
+
+  return snapshot.toJson();
+}
+
+void JsBridgeContext::startProfiler(long long samplingIntervalUs) {
+  // Sampled by jsbridge_duk_exec_timeout_check()
+  m_profiler->start(samplingIntervalUs);
+}
+
+std::string JsBridgeContext::stopProfiler() {
+  return m_profiler->stop();
+}
+
+void JsBridgeContext::startDebugger(int port) {
+#if !defined(DUK_USE_DEBUGGER_SUPPORT)
+  alog_warn("Cannot start the debugger on port %d: no debugger support in the Duktape performance profile", port);
+#else
   // Call Java onDebuggerPending()
   m_jniCache->getJsBridgeInterface().onDebuggerPending();
 
@@ -120,17 +598,88 @@ void JsBridgeContext::startDebugger(int port) {
       debugger_detached,
       (void *) m_ctx
   );
+#endif
 }
 
 void JsBridgeContext::cancelDebug() {
+#if defined(DUK_USE_DEBUGGER_SUPPORT)
     alog_info("Cancelling Duktape debug...");
     duk_trans_socket_finish();
+#endif
+}
+
+void JsBridgeContext::enableLocalStorage(const std::string &strFilePath, const JObjectArrayLocalRef &initialKeys,
+                                         const JObjectArrayLocalRef &initialValues) {
+  CHECK_STACK(m_ctx);
+
+  m_localStorage = LocalStorage::open(strFilePath);
+
+  jsize initialItemCount = std::min(initialKeys.getLength(), initialValues.getLength());
+  for (jsize i = 0; i < initialItemCount; ++i) {
+    std::string key = JStringLocalRef(initialKeys.getElement(i).staticCast<jstring>()).toStdString();
+    std::string value;
+    if (!m_localStorage->getItem(key, &value)) {
+      m_localStorage->setItem(key, JStringLocalRef(initialValues.getElement(i).staticCast<jstring>()).toStdString());
+    }
+  }
+
+  duk_push_object(m_ctx);
+
+  static const struct {
+    const char *name;
+    LocalStorageMethod method;
+  } methods[] = {
+    { "getItem", Method_GetItem },
+    { "setItem", Method_SetItem },
+    { "removeItem", Method_RemoveItem },
+    { "clear", Method_Clear },
+    { "key", Method_Key },
+  };
+  for (const auto &method : methods) {
+    duk_push_c_function(m_ctx, localStorageMethod, DUK_VARARGS);
+    duk_set_magic(m_ctx, -1, method.method);
+    duk_put_prop_string(m_ctx, -2, method.name);
+  }
+
+  duk_push_literal(m_ctx, "length");
+  duk_push_c_function(m_ctx, localStorageMethod, 0);
+  duk_set_magic(m_ctx, -1, Method_Length);
+  duk_def_prop(m_ctx, -3, DUK_DEFPROP_HAVE_GETTER | DUK_DEFPROP_SET_CONFIGURABLE);
+
+  duk_put_global_literal(m_ctx, "localStorage");
+}
+
+void JsBridgeContext::enableConsole(JsConsole::Mode mode, int minPriority, size_t ringBufferSize) {
+  CHECK_STACK(m_ctx);
+
+  delete m_console;
+  m_console = new JsConsole(this, mode, minPriority, ringBufferSize);
+
+  duk_push_object(m_ctx);
+  for (int method = 0; method < JsConsole::Method_Count; ++method) {
+    duk_push_c_function(m_ctx, consoleMethod, DUK_VARARGS);
+    duk_set_magic(m_ctx, -1, method);
+    duk_put_prop_string(m_ctx, -2, JsConsole::METHOD_NAMES[method]);
+  }
+  duk_put_global_literal(m_ctx, "console");
 }
 
 void JsBridgeContext::enableModuleLoader() {
   throw std::invalid_argument("Cannot use JS module loader on Duktape!");
 }
 
+void JsBridgeContext::registerJsModules(const JObjectArrayLocalRef &, const JObjectArrayLocalRef &, bool) {
+  throw std::invalid_argument("Cannot register JS modules on Duktape!");
+}
+
+void JsBridgeContext::enableModuleNameNormalizer() {
+  throw std::invalid_argument("Cannot use JS module name normalizer on Duktape!");
+}
+
+std::string JsBridgeContext::getBytecodeVersion() const {
+  return "duktape-" + std::to_string(DUK_VERSION);
+}
+
 std::string JsBridgeContext::getCurrentScriptOrModuleName(int level) const {
   if (level < -1)
       return {};
@@ -150,7 +699,7 @@ std::string JsBridgeContext::getCurrentScriptOrModuleName(int level) const {
 }
 
 JValue JsBridgeContext::evaluateString(const JStringLocalRef &strCode, const JniLocalRef<jsBridgeParameter> &returnParameter,
-                                       bool awaitJsPromise) const {
+                                       bool awaitJsPromise, const JniLocalRef<jobject> &awaitingDeferred) const {
   CHECK_STACK(m_ctx);
 
   //alog("Evaluating string: %s", strCode.toUtf8Chars());
@@ -163,7 +712,7 @@ JValue JsBridgeContext::evaluateString(const JStringLocalRef &strCode, const Jni
     throw m_exceptionHandler->getCurrentJsException();
   }
 
-  bool isDeferred = awaitJsPromise && duk_is_object(m_ctx, -1) && duk_has_prop_string(m_ctx, -1, "then");
+  bool isDeferred = awaitJsPromise && duk_is_object(m_ctx, -1) && duk_has_prop_literal(m_ctx, -1, "then");
   if (!isDeferred && returnParameter.isNull()) {
     // No return type given: try to guess it out of the JS value
     const int supportedTypeMask = DUK_TYPE_MASK_BOOLEAN | DUK_TYPE_MASK_NUMBER | DUK_TYPE_MASK_STRING;
@@ -182,38 +731,172 @@ JValue JsBridgeContext::evaluateString(const JStringLocalRef &strCode, const Jni
     return JValue();
   }
 
-  auto returnType = m_javaTypeProvider.makeUniqueType(returnParameter, true /*boxed*/);
+  auto returnType = m_javaTypeProvider.getType(returnParameter, true /*boxed*/);
 
   if (isDeferred && !returnType->isDeferred()) {
-    return m_javaTypeProvider.getDeferredType(returnParameter)->pop();
+    auto deferredType = m_javaTypeProvider.getDeferredType(returnParameter);
+    if (awaitingDeferred.isNull()) {
+      return deferredType->pop();
+    }
+    return static_cast<const JavaTypes::Deferred *>(deferredType.get())->popAwaited(awaitingDeferred);
   }
 
   return returnType->pop();
 }
 
-void JsBridgeContext::evaluateFileContent(const JStringLocalRef &strCode, const std::string &strFileName, bool) const {
+JValue JsBridgeContext::evaluateScalar(const JStringLocalRef &strCode, JavaTypeId id) const {
+  CHECK_STACK(m_ctx);
+
+  duk_int_t ret = duk_peval_string(m_ctx, strCode.toUtf8Chars());
+  strCode.releaseChars();
+
+  if (ret != DUK_EXEC_SUCCESS) {
+    alog("Could not evaluate string");
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  return m_javaTypeProvider.getScalarType(id)->pop();
+}
+
+JArrayLocalRef<jbyte> JsBridgeContext::evaluateFileContent(const JStringLocalRef &strCode, const std::string &strFileName,
+                                                           bool asModule, bool returnBytecode) const {
+  auto bytecode = evaluateUtf8FileContent(strCode.toUtf8Chars(), strCode.utf8Length(), strFileName, asModule, returnBytecode);
+  strCode.releaseChars();
+  return bytecode;
+}
+
+void JsBridgeContext::evaluateAsset(AAssetManager *assetManager, const std::string &strAssetPath, const std::string &strFileName,
+                                    bool asModule) const {
+  // Directly compiled from the (memory-mapped) asset buffer
+  AssetBuffer assetBuffer(assetManager, strAssetPath);
+  evaluateUtf8FileContent(assetBuffer.data(), assetBuffer.length(), strFileName, asModule, false);
+}
+
+void JsBridgeContext::evaluateBuiltInAsset(AAssetManager *assetManager, const std::string &strAssetPath) const {
+  CHECK_STACK(m_ctx);
+
+  // "a\0<asset path>"
+  std::string cacheKey;
+  cacheKey.append("a", 2).append(strAssetPath);
+
+  JsCompiledCodeCache &cache = JsCompiledCodeCache::getInstance();
+
+  std::shared_ptr<const std::string> bytecode = cache.find(cacheKey);
+  if (bytecode) {
+    // The asset does not even need to be opened
+    void *buf = duk_push_fixed_buffer(m_ctx, bytecode->size());
+    memcpy(buf, bytecode->data(), bytecode->size());
+
+    if (duk_safe_call(m_ctx, tryLoadFunction, nullptr, 1, 1) != DUK_EXEC_SUCCESS) {
+      alog("Could not load built-in asset %s", strAssetPath.c_str());
+      throw m_exceptionHandler->getCurrentJsException();
+    }
+  } else {
+    AssetBuffer assetBuffer(assetManager, strAssetPath);
+
+    duk_push_string(m_ctx, strAssetPath.c_str());
+    if (duk_pcompile_lstring_filename(m_ctx, DUK_COMPILE_EVAL, assetBuffer.data(), assetBuffer.length()) != DUK_EXEC_SUCCESS) {
+      alog("Could not compile built-in asset %s", strAssetPath.c_str());
+      throw m_exceptionHandler->getCurrentJsException();
+    }
+
+    duk_dup_top(m_ctx);
+    duk_dump_function(m_ctx);
+    duk_size_t size = 0;
+    const void *buf = duk_get_buffer(m_ctx, -1, &size);
+    cache.add(cacheKey, std::string(static_cast<const char *>(buf), size), false /*evictable*/);
+    duk_pop(m_ctx);  // bytecode buffer
+  }
+
+  if (duk_pcall(m_ctx, 0) != DUK_EXEC_SUCCESS) {
+    alog("Could not execute built-in asset %s", strAssetPath.c_str());
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  duk_pop(m_ctx);  // unused pcall result
+}
+
+JArrayLocalRef<jbyte> JsBridgeContext::evaluateUtf8FileContent(const char *code, size_t length, const std::string &strFileName,
+                                                               bool, bool returnBytecode) const {
   CHECK_STACK(m_ctx);
 
   duk_push_string(m_ctx, strFileName.c_str());
 
-  duk_int_t ret = duk_pcompile_string_filename(m_ctx, DUK_COMPILE_EVAL, strCode.toUtf8Chars());
-  strCode.releaseChars();  // release chars now as we don't need them anymore
+  duk_int_t ret = duk_pcompile_lstring_filename(m_ctx, DUK_COMPILE_EVAL, code, length);
 
   if (ret != DUK_EXEC_SUCCESS) {
     alog("Could not compile file %s", strFileName.c_str());
     throw m_exceptionHandler->getCurrentJsException();
   }
 
+  JArrayLocalRef<jbyte> bytecode = returnBytecode ? dumpFunction(this) : JArrayLocalRef<jbyte>(JniLocalRef<jarray>());
+
   if (duk_pcall(m_ctx, 0) != DUK_EXEC_SUCCESS) {
     alog("Could not execute file %s", strFileName.c_str());
     throw m_exceptionHandler->getCurrentJsException();
   }
 
   duk_pop(m_ctx);  // unused pcall result
+  return bytecode;
+}
+
+void JsBridgeContext::evaluateBytecode(const JArrayLocalRef<jbyte> &bytecode, const std::string &strFileName) const {
+  const auto *buf = reinterpret_cast<const uint8_t *>(bytecode.getElements());
+  evaluateMaybeCompressedBytecode(buf, static_cast<size_t>(bytecode.getLength()), strFileName);
+}
+
+void JsBridgeContext::evaluateBytecodeAsset(AAssetManager *assetManager, const std::string &strAssetPath, const std::string &strFileName) const {
+  AssetBuffer assetBuffer(assetManager, strAssetPath);
+  evaluateMaybeCompressedBytecode(reinterpret_cast<const uint8_t *>(assetBuffer.data()), assetBuffer.length(), strFileName);
+}
+
+void JsBridgeContext::evaluateMaybeCompressedBytecode(const uint8_t *data, size_t size, const std::string &strFileName) const {
+  if (Lz4Frame::isFrame(data, size)) {
+    Lz4Frame::MappedBuffer decompressed = Lz4Frame::decompress(data, size);
+    evaluateBytecode(decompressed.data(), decompressed.size(), strFileName);
+    return;
+  }
+
+  evaluateBytecode(data, size, strFileName);
+}
+
+void JsBridgeContext::evaluateBytecode(const uint8_t *data, size_t size, const std::string &strFileName) const {
+  CHECK_STACK(m_ctx);
+
+  if (!hasValidBytecodeHeader(data, size)) {
+    throw std::invalid_argument("Cannot read JS bytecode: not created by " + getBytecodeVersion());
+  }
+
+  // Duktape loads the bytecode from its own buffer
+  const size_t bufferSize = size - BYTECODE_HEADER_SIZE;
+  void *buf = duk_push_fixed_buffer(m_ctx, bufferSize);
+  memcpy(buf, data + BYTECODE_HEADER_SIZE, bufferSize);
+
+  if (duk_safe_call(m_ctx, tryLoadFunction, nullptr, 1, 1) != DUK_EXEC_SUCCESS) {
+    // Invalid or incompatible bytecode => nothing has been evaluated yet
+    std::string msg = std::string("Cannot read JS bytecode: ") + duk_safe_to_string(m_ctx, -1);
+    duk_pop(m_ctx);
+    throw std::invalid_argument(msg);
+  }
+
+  if (duk_pcall(m_ctx, 0) != DUK_EXEC_SUCCESS) {
+    alog("Could not execute file %s", strFileName.c_str());
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  duk_pop(m_ctx);  // unused pcall result
+}
+
+// static
+JObjectArrayLocalRef JsBridgeContext::precompileFileContents(const JniContext *, const JObjectArrayLocalRef &,
+                                                             const JObjectArrayLocalRef &, bool, int,
+                                                             JObjectArrayLocalRef &) {
+  throw std::invalid_argument("Cannot precompile JS files on Duktape!");
 }
 
 void JsBridgeContext::registerJavaObject(const std::string &strName, const JniLocalRef<jobject> &object,
-                                         const JObjectArrayLocalRef &methods) {
+                                         const std::string &/*strPrototypeName*/, const JObjectArrayLocalRef &methods,
+                                         bool lazyMethods) {
   CHECK_STACK(m_ctx);
 
   duk_push_global_object(m_ctx);
@@ -224,7 +907,7 @@ void JsBridgeContext::registerJavaObject(const std::string &strName, const JniLo
   }
 
   try {
-    JavaObject::push(this, strName, object, methods);
+    JavaObject::push(this, strName, object, methods, lazyMethods);
   } catch (const std::exception &) {
     duk_pop(m_ctx);  // global object
     throw;
@@ -261,49 +944,55 @@ void JsBridgeContext::registerJavaLambda(const std::string &strName, const JniLo
   duk_pop(m_ctx);  // global object
 }
 
-void JsBridgeContext::registerJsObject(const std::string &strName,
-                                       const JObjectArrayLocalRef &methods,
-                                       bool check) {
+jlong JsBridgeContext::registerJsObject(const std::string &strName,
+                                        const JObjectArrayLocalRef &methods,
+                                        bool check) {
   CHECK_STACK(m_ctx);
 
   duk_get_global_string(m_ctx, strName.c_str());
 
+  JavaScriptObject *cppJsObject;
   try {
     // Create the JavaScriptObject instance (which takes over jsObjectValue and will free it in its destructor)
-    auto cppJsObject = new JavaScriptObject(this, strName, -1, methods, check);  // auto-deleted
+    cppJsObject = new JavaScriptObject(this, strName, -1, methods, check);  // auto-deleted
 
     // Wrap it inside the JS object
     m_utils->createMappedCppPtrValue(cppJsObject, -1, strName.c_str());
-
-    duk_pop(m_ctx);  // JS object
   } catch (const std::exception &) {
     duk_pop(m_ctx);  // JS object
     throw;
   }
+
+  // Bind the JS object and its wrapper so that it can be called without any lookup
+  m_utils->pushMappedCppValue(-1, strName.c_str());
+  return m_jsValueTable->add(cppJsObject);  // JS object + wrapper
 }
 
-void JsBridgeContext::registerJsLambda(const std::string &strName,
-                                       const JniLocalRef<jsBridgeMethod> &method) {
+jlong JsBridgeContext::registerJsLambda(const std::string &strName,
+                                        const JniLocalRef<jsBridgeMethod> &method) {
   CHECK_STACK(m_ctx);
 
   duk_get_global_string(m_ctx, strName.c_str());
 
+  JavaScriptLambda *cppJsLambda;
   try {
     // Create the JavaScriptObject instance
-    auto cppJsLambda = new JavaScriptLambda(this, method, strName, -1);  // auto-deleted
+    cppJsLambda = new JavaScriptLambda(this, method, strName, -1);  // auto-deleted
 
     // Wrap it inside the JS object
     m_utils->createMappedCppPtrValue(cppJsLambda, -1, strName.c_str());
-
-    duk_pop(m_ctx);  // JS lambda
   } catch (const std::exception &) {
     duk_pop(m_ctx);  // JS lambda
     throw;
   }
+
+  // Bind the JS lambda and its wrapper so that it can be called without any lookup
+  m_utils->pushMappedCppValue(-1, strName.c_str());
+  return m_jsValueTable->add(cppJsLambda);  // JS lambda + wrapper
 }
 
 JValue JsBridgeContext::callJsMethod(const std::string &objectName,
-                                     const JniLocalRef<jobject> &javaMethod,
+                                     jint methodIndex,
                                      const JObjectArrayLocalRef &args,
                                      bool awaitJsPromise) {
   CHECK_STACK(m_ctx);
@@ -324,7 +1013,38 @@ JValue JsBridgeContext::callJsMethod(const std::string &objectName,
   }
 
   duk_pop(m_ctx);
-  return cppJsObject->call(javaMethod, args, awaitJsPromise);
+  return cppJsObject->call(methodIndex, args, awaitJsPromise);
+}
+
+JValue JsBridgeContext::callJsMethod(jlong bindingHandle,
+                                     jint methodIndex,
+                                     const JObjectArrayLocalRef &args,
+                                     bool awaitJsPromise) {
+  CHECK_STACK(m_ctx);
+
+  // The JS object is kept alive by the binding and referenced by the JavaScriptObject
+  auto cppJsObject = m_jsValueTable->getCppPtr<JavaScriptObject>(bindingHandle);
+  if (cppJsObject == nullptr) {
+    throw std::invalid_argument("Cannot access the JS object " + std::to_string(bindingHandle) +
+                                " because it has not been registered!");
+  }
+
+  return cppJsObject->call(methodIndex, args, awaitJsPromise);
+}
+
+JValue JsBridgeContext::callJsMethod(jlong bindingHandle,
+                                     jint methodIndex,
+                                     const JArrayLocalRef<jlong> &packedArgs,
+                                     bool awaitJsPromise) {
+  CHECK_STACK(m_ctx);
+
+  auto cppJsObject = m_jsValueTable->getCppPtr<JavaScriptObject>(bindingHandle);
+  if (cppJsObject == nullptr) {
+    throw std::invalid_argument("Cannot access the JS object " + std::to_string(bindingHandle) +
+                                " because it has not been registered!");
+  }
+
+  return cppJsObject->call(methodIndex, packedArgs, awaitJsPromise);
 }
 
 JValue JsBridgeContext::callJsLambda(const std::string &strFunctionName,
@@ -333,7 +1053,9 @@ JValue JsBridgeContext::callJsLambda(const std::string &strFunctionName,
   CHECK_STACK(m_ctx);
 
   // Get the JS lambda
-  duk_get_global_string(m_ctx, strFunctionName.c_str());
+  m_utils->pushNamedValueOwner(strFunctionName);
+  duk_get_prop_string(m_ctx, -1, strFunctionName.c_str());
+  duk_remove(m_ctx, -2);  // owner
   if (!duk_is_function(m_ctx, -1)) {
     duk_pop(m_ctx);
     throw std::invalid_argument("The JS method " + strFunctionName + " cannot be called (not a function)");
@@ -351,10 +1073,61 @@ JValue JsBridgeContext::callJsLambda(const std::string &strFunctionName,
   return cppJsLambda->call(this, args, awaitJsPromise);
 }
 
+JValue JsBridgeContext::callJsLambda(jlong bindingHandle,
+                                     const JObjectArrayLocalRef &args,
+                                     bool awaitJsPromise) {
+  CHECK_STACK(m_ctx);
+
+  // The JS lambda is kept alive by the binding and referenced by the JavaScriptLambda
+  auto cppJsLambda = m_jsValueTable->getCppPtr<JavaScriptLambda>(bindingHandle);
+  if (cppJsLambda == nullptr) {
+    throw std::invalid_argument("Cannot invoke the JS function " + std::to_string(bindingHandle) +
+                                " because it has not been registered!");
+  }
+
+  return cppJsLambda->call(this, args, awaitJsPromise);
+}
+
+JObjectArrayLocalRef JsBridgeContext::callJsLambdaBatch(jlong bindingHandle,
+                                                        const JObjectArrayLocalRef &argsArray,
+                                                        bool awaitJsPromise) {
+  CHECK_STACK(m_ctx);
+
+  auto cppJsLambda = m_jsValueTable->getCppPtr<JavaScriptLambda>(bindingHandle);
+  if (cppJsLambda == nullptr) {
+    throw std::invalid_argument("Cannot invoke the JS function " + std::to_string(bindingHandle) +
+                                " because it has not been registered!");
+  }
+
+  const jsize count = argsArray.getLength();
+  JObjectArrayLocalRef results(m_jniContext, count, m_jniCache->getObjectClass());
+  if (results.isNull()) {
+    throw JniException(m_jniContext);
+  }
+
+  for (jsize i = 0; i < count; ++i) {
+    JObjectArrayLocalRef args(argsArray.getElement<jobjectArray>(i));
+    JValue result = cppJsLambda->call(this, args, awaitJsPromise);
+    results.setElement(i, result.getLocalRef());
+  }
+
+  return results;
+}
+
 void JsBridgeContext::assignJsValue(const std::string &strGlobalName, const JStringLocalRef &strCode) {
   CHECK_STACK(m_ctx);
 
-  duk_int_t ret = duk_peval_string(m_ctx, strCode.toUtf8Chars());
+  const char *code = strCode.toUtf8Chars();
+  const size_t length = strCode.utf8Length();
+
+  // "v\0<code>"
+  std::string cacheKey;
+  if (length <= JsCompiledCodeCache::MAX_SOURCE_LENGTH) {
+    cacheKey.reserve(length + 2);
+    cacheKey.append("v", 2).append(code, length);
+  }
+
+  duk_int_t ret = pevalCachedCode(m_ctx, cacheKey, code, length);
   strCode.releaseChars();  // release chars now as we don't need them anymore
 
   if (ret != DUK_EXEC_SUCCESS) {
@@ -368,7 +1141,7 @@ void JsBridgeContext::assignJsValue(const std::string &strGlobalName, const JStr
 void JsBridgeContext::deleteJsValue(const std::string &strGlobalName) {
   CHECK_STACK(m_ctx);
 
-  duk_push_global_object(m_ctx);
+  m_utils->pushNamedValueOwner(strGlobalName);
   duk_del_prop_string(m_ctx, -1, strGlobalName.c_str());
   duk_pop(m_ctx);
 }
@@ -376,59 +1149,382 @@ void JsBridgeContext::deleteJsValue(const std::string &strGlobalName) {
 void JsBridgeContext::copyJsValue(const std::string &strGlobalNameTo, const std::string &strGlobalNameFrom) {
   CHECK_STACK(m_ctx);
 
-  duk_push_global_object(m_ctx);
+  m_utils->pushNamedValueOwner(strGlobalNameTo);
+  m_utils->pushNamedValueOwner(strGlobalNameFrom);
   duk_get_prop_string(m_ctx, -1, strGlobalNameFrom.c_str());
+  duk_remove(m_ctx, -2);  // owner of the source value
   duk_put_prop_string(m_ctx, -2, strGlobalNameTo.c_str());
   duk_pop(m_ctx);
 }
 
-void JsBridgeContext::newJsFunction(const std::string &strGlobalName, const JObjectArrayLocalRef &args, const JStringLocalRef &strCode) {
+void JsBridgeContext::processJsCommands(JsCommandQueue *commandQueue) {
   CHECK_STACK(m_ctx);
 
-  // Push global Function (which can be constructed with "new Function"
-  duk_get_global_string(m_ctx, "Function");
+  // Run all the drained commands and report the first failure at the end
+  std::exception_ptr firstException;
+
+  for (const JsCommandQueue::Command &command : commandQueue->drain()) {
+    try {
+      switch (command.type) {
+        case JsCommandQueue::Type::CallFunction: {
+          m_utils->pushNamedValueOwner(command.globalName);
+          duk_get_prop_string(m_ctx, -1, command.globalName.c_str());
+          duk_remove(m_ctx, -2);  // owner
+          if (!duk_is_function(m_ctx, -1)) {
+            duk_pop(m_ctx);
+            throw std::invalid_argument("The JS function " + command.globalName + " cannot be called (not a function)");
+          }
+
+          duk_idx_t argCount = 0;
+          if (!command.payload.empty()) {
+            duk_push_lstring(m_ctx, command.payload.c_str(), command.payload.size());
+            if (duk_safe_call(m_ctx, [](duk_context *ctx, void *) -> duk_ret_t {
+              duk_json_decode(ctx, -1);
+              return 1;
+            }, nullptr, 1, 1) != DUK_EXEC_SUCCESS) {
+              duk_remove(m_ctx, -2);  // function
+              throw m_exceptionHandler->getCurrentJsException();
+            }
+
+            // Spread the args array on the stack
+            duk_idx_t argsIndex = duk_get_top_index(m_ctx);
+            argCount = static_cast<duk_idx_t>(duk_get_length(m_ctx, argsIndex));
+            duk_require_stack(m_ctx, argCount);
+            for (duk_idx_t i = 0; i < argCount; ++i) {
+              duk_get_prop_index(m_ctx, argsIndex, static_cast<duk_uarridx_t>(i));
+            }
+            duk_remove(m_ctx, argsIndex);
+          }
+
+          if (duk_pcall(m_ctx, argCount) != DUK_EXEC_SUCCESS) {
+            throw m_exceptionHandler->getCurrentJsException();
+          }
+          duk_pop(m_ctx);  // return value
+          break;
+        }
+
+        case JsCommandQueue::Type::AssignValue:
+          if (duk_peval_lstring(m_ctx, command.payload.c_str(), command.payload.size()) != DUK_EXEC_SUCCESS) {
+            throw m_exceptionHandler->getCurrentJsException();
+          }
+          m_utils->pushNamedValueOwner(command.globalName);
+          duk_swap_top(m_ctx, -2);
+          duk_put_prop_string(m_ctx, -2, command.globalName.c_str());
+          duk_pop(m_ctx);  // owner
+          break;
+
+        case JsCommandQueue::Type::DeleteValue:
+          deleteJsValue(command.globalName);
+          break;
+      }
+    } catch (const std::exception &) {
+      if (!firstException) {
+        firstException = std::current_exception();
+      }
+    }
+  }
+
+  if (firstException) {
+    std::rethrow_exception(firstException);
+  }
+}
 
-  // This fails with "constructor requires 'new'"
-  //duk_require_constructor_call(m_ctx);
+void JsBridgeContext::newJsFunction(const std::string &strGlobalName, const JObjectArrayLocalRef &args, const JStringLocalRef &strCode) {
+  CHECK_STACK(m_ctx);
 
-  // Push all arguments (as string)
+  // Same as new Function(arg1, arg2, ..., jsCode) but via an expression which can be compiled once
+  std::string source = "(function anonymous(";
   jsize argCount = args.getLength();
   for (jsize i = 0; i < argCount; ++i) {
     JStringLocalRef argString(args.getElement<jstring>(i));
-    duk_push_string(m_ctx, argString.toUtf8Chars());
+    if (i > 0) {
+      source += ',';
+    }
+    source.append(argString.toUtf8Chars(), argString.utf8Length());
   }
-
-  // Push JS code as string
-  duk_push_string(m_ctx, strCode.toUtf8Chars());
+  source += "\n) {\n";
+  source.append(strCode.toUtf8Chars(), strCode.utf8Length());
+  source += "\n})";
   strCode.releaseChars();  // release chars now as we don't need them anymore
 
-  // New Function(arg1, arg2, ..., jsCode)
-  if (duk_pnew(m_ctx, argCount + 1) != DUK_EXEC_SUCCESS) {
+  // "f\0<source>"
+  const std::string cacheKey = std::string("f", 2) + source;
+  if (pevalCachedCode(m_ctx, cacheKey, source.c_str(), source.size()) != DUK_EXEC_SUCCESS) {
     throw m_exceptionHandler->getCurrentJsException();
   }
 
   duk_put_global_string(m_ctx, strGlobalName.c_str());
 }
 
+void JsBridgeContext::copyJsValueHandle(const std::string &strGlobalNameTo, jlong handle) {
+  CHECK_STACK(m_ctx);
+
+  m_jsValueTable->push(handle);
+  duk_put_global_string(m_ctx, strGlobalNameTo.c_str());
+}
+
+void JsBridgeContext::releaseJsValueHandle(jlong handle) {
+  m_jsValueTable->remove(handle);
+}
+
+void JsBridgeContext::pushJsValue(jlong handle, const std::string &strGlobalName) const {
+  if (handle != 0) {
+    m_jsValueTable->push(handle);
+    return;
+  }
+
+  m_utils->pushNamedValueOwner(strGlobalName);
+  duk_get_prop_string(m_ctx, -1, strGlobalName.c_str());
+  duk_remove(m_ctx, -2);  // owner
+}
+
+JValue JsBridgeContext::getJsValueProperty(jlong handle, const std::string &strGlobalName, const JStringLocalRef &strKey, int index,
+                                          const JniLocalRef<jsBridgeParameter> &returnParameter) const {
+  CHECK_STACK(m_ctx);
+
+  auto returnType = m_javaTypeProvider.getType(returnParameter, true /*boxed*/);
+
+  pushJsValue(handle, strGlobalName);
+  if (!duk_is_object(m_ctx, -1)) {
+    duk_pop(m_ctx);
+    throw std::invalid_argument("Cannot get a property of a JS value which is not an object");
+  }
+
+  if (strKey.isNull()) {
+    duk_get_prop_index(m_ctx, -1, static_cast<duk_uarridx_t>(index));
+  } else {
+    duk_get_prop_string(m_ctx, -1, strKey.toUtf8Chars());
+  }
+  duk_remove(m_ctx, -2);  // object
+
+  return returnType->pop();
+}
+
+void JsBridgeContext::setJsValueProperty(jlong handle, const std::string &strGlobalName, const JStringLocalRef &strKey, int index,
+                                         const JniLocalRef<jobject> &value, const JniLocalRef<jsBridgeParameter> &parameter) const {
+  CHECK_STACK(m_ctx);
+
+  auto type = m_javaTypeProvider.getType(parameter, true /*boxed*/);
+
+  pushJsValue(handle, strGlobalName);
+  if (!duk_is_object(m_ctx, -1)) {
+    duk_pop(m_ctx);
+    throw std::invalid_argument("Cannot set a property of a JS value which is not an object");
+  }
+
+  if (strKey.isNull()) {
+    duk_push_uint(m_ctx, static_cast<duk_uint_t>(index));
+  } else {
+    duk_push_string(m_ctx, strKey.toUtf8Chars());
+  }
+
+  try {
+    type->push(JValue(value));
+  } catch (const std::exception &) {
+    duk_pop_2(m_ctx);  // key + object
+    throw;
+  }
+
+  // [... object key value] (a setter may throw)
+  if (duk_safe_call(m_ctx, [](duk_context *ctx, void *) -> duk_ret_t {
+    duk_put_prop(ctx, -3);
+    return 0;
+  }, nullptr, 3, 1) != DUK_EXEC_SUCCESS) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+  duk_pop(m_ctx);  // (undefined) safe call result
+}
+
+JValue JsBridgeContext::callJsValueMethod(jlong handle, const std::string &strGlobalName, const JStringLocalRef &strMethodName,
+                                          const JObjectArrayLocalRef &args, const JniLocalRef<jsBridgeParameter> &returnParameter) const {
+  CHECK_STACK(m_ctx);
+
+  auto returnType = m_javaTypeProvider.getType(returnParameter, true /*boxed*/);
+  const auto &argType = m_javaTypeProvider.getObjectType();
+
+  pushJsValue(handle, strGlobalName);
+  const duk_idx_t objectIdx = duk_get_top_index(m_ctx);
+  if (!duk_is_object(m_ctx, objectIdx)) {
+    duk_pop(m_ctx);
+    throw std::invalid_argument("Cannot call a method of a JS value which is not an object");
+  }
+
+  duk_push_string(m_ctx, strMethodName.toUtf8Chars());
+
+  const jsize argCount = args.isNull() ? 0 : args.getLength();
+  try {
+    duk_require_stack(m_ctx, argCount);
+    for (jsize i = 0; i < argCount; ++i) {
+      argType->push(JValue(args.getElement<jobject>(i)));
+    }
+  } catch (const std::exception &) {
+    duk_set_top(m_ctx, objectIdx);
+    throw;
+  }
+
+  // [... object key arg1 ... argN] -> [... object retval]
+  if (duk_pcall_prop(m_ctx, objectIdx, argCount) != DUK_EXEC_SUCCESS) {
+    duk_remove(m_ctx, objectIdx);
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+  duk_remove(m_ctx, objectIdx);
+
+  return returnType->pop();
+}
+
+const char *JsBridgeContext::getJsValueType(jlong handle, const std::string &strGlobalName) const {
+  CHECK_STACK(m_ctx);
+
+  pushJsValue(handle, strGlobalName);
+
+  const char *type;
+  switch (duk_get_type(m_ctx, -1)) {
+    case DUK_TYPE_BOOLEAN:
+      type = "boolean";
+      break;
+    case DUK_TYPE_NUMBER:
+      type = "number";
+      break;
+    case DUK_TYPE_STRING:
+      type = duk_is_symbol(m_ctx, -1) ? "symbol" : "string";
+      break;
+    case DUK_TYPE_OBJECT:
+      type = duk_is_function(m_ctx, -1) ? "function" : "object";
+      break;
+    case DUK_TYPE_LIGHTFUNC:
+      type = "function";
+      break;
+    case DUK_TYPE_NULL:
+    case DUK_TYPE_BUFFER:
+      type = "object";
+      break;
+    case DUK_TYPE_POINTER:
+      type = "pointer";
+      break;
+    default:
+      type = "undefined";
+      break;
+  }
+
+  duk_pop(m_ctx);
+  return type;
+}
+
 void JsBridgeContext::convertJavaValueToJs(const std::string &strGlobalName, const JniLocalRef<jobject> &javaValue, const JniLocalRef<jsBridgeParameter> &parameter) {
 
-  auto type = m_javaTypeProvider.makeUniqueType(parameter, true /*boxed*/);
+  auto type = m_javaTypeProvider.getType(parameter, true /*boxed*/);
 
   type->push(JValue(javaValue));
   duk_put_global_string(m_ctx, strGlobalName.c_str());
 }
 
-void JsBridgeContext::processPromiseQueue() {
-  // No built-in promise
+void JsBridgeContext::parseJsonBuffer(const std::string &strGlobalName, const JniLocalRef<jobject> &byteBuffer, jint offset, jint length) {
+  CHECK_STACK(m_ctx);
+
+  auto data = static_cast<const char *>(m_jniContext->getDirectBufferAddress(byteBuffer));
+  jlong capacity = m_jniContext->getDirectBufferCapacity(byteBuffer);
+  if (data == nullptr || offset < 0 || length < 0 || offset + static_cast<jlong>(length) > capacity) {
+    throw std::invalid_argument("Invalid JSON buffer");
+  }
+
+  // The JSON text is directly copied from the native buffer into a JS string which is decoded
+  m_utils->pushUtf8String(data + offset, static_cast<size_t>(length));
+  if (duk_safe_call(m_ctx, [](duk_context *ctx, void *) -> duk_ret_t {
+    duk_json_decode(ctx, -1);
+    return 1;
+  }, nullptr, 1, 1) != DUK_EXEC_SUCCESS) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  duk_put_global_string(m_ctx, strGlobalName.c_str());
+}
+
+void JsBridgeContext::assignDirectBuffer(const std::string &strGlobalName, const JniLocalRef<jobject> &byteBuffer, jint offset, jint length,
+                                         bool asUtf8String) {
+  CHECK_STACK(m_ctx);
+
+  auto data = static_cast<const char *>(m_jniContext->getDirectBufferAddress(byteBuffer));
+  jlong capacity = m_jniContext->getDirectBufferCapacity(byteBuffer);
+  if (data == nullptr || offset < 0 || length < 0 || offset + static_cast<jlong>(length) > capacity) {
+    throw std::invalid_argument("Invalid buffer");
+  }
+
+  if (asUtf8String) {
+    m_utils->pushUtf8String(data + offset, static_cast<size_t>(length));
+  } else {
+    // Duktape external buffers cannot release the Java buffer when they are collected
+    // => single copy into a fixed buffer
+    void *bufferData = duk_push_fixed_buffer(m_ctx, static_cast<duk_size_t>(length));
+    if (length > 0) {
+      memcpy(bufferData, data + offset, static_cast<size_t>(length));
+    }
+    duk_push_buffer_object(m_ctx, -1, 0, static_cast<duk_size_t>(length), DUK_BUFOBJ_ARRAYBUFFER);
+    duk_remove(m_ctx, -2);  // plain buffer
+  }
+
+  duk_put_global_string(m_ctx, strGlobalName.c_str());
+}
+
+jlong JsBridgeContext::writeJsMessage(const std::string &) const {
+  throw std::invalid_argument("Cannot post JS messages on Duktape!");
+}
+
+void JsBridgeContext::readJsMessage(const std::string &, jlong) const {
+  throw std::invalid_argument("Cannot post JS messages on Duktape!");
 }
 
 // static
-JsBridgeContext *JsBridgeContext::getInstance(duk_context *ctx) {
-  duk_push_global_stash(ctx);
-  duk_get_prop_string(ctx, -1, JSBRIDGE_CPP_CLASS_PROP_NAME);
-  auto duktapeContext = reinterpret_cast<JsBridgeContext *>(duk_require_pointer(ctx, -1));
-  duk_pop_2(ctx);
+void JsBridgeContext::deleteJsMessage(jlong) {
+  // No message can be created on Duktape
+}
 
-  return duktapeContext;
+JniLocalRef<jobject> JsBridgeContext::newJsSharedBuffer(const std::string &, jint) const {
+  throw std::invalid_argument("Cannot create shared buffers on Duktape!");
+}
+
+void JsBridgeContext::notifyJsSharedBuffer(const std::string &) const {
+  throw std::invalid_argument("Cannot notify shared buffers on Duktape!");
+}
+
+// static
+void JsBridgeContext::releaseJsSharedBuffer(void *) {
+  // No shared buffer can be created on Duktape
+}
+
+// static
+int JsBridgeContext::waitForJsSharedBufferNotify(void *, int notifyCount, long long) {
+  // No shared buffer can be created on Duktape
+  return notifyCount;
+}
+
+JArrayLocalRef<jbyte> JsBridgeContext::writeJsSnapshot(const std::string &) const {
+  throw std::invalid_argument("Cannot write JS snapshots on Duktape!");
+}
+
+void JsBridgeContext::readJsSnapshot(const std::string &, const JArrayLocalRef<jbyte> &) const {
+  throw std::invalid_argument("Cannot read JS snapshots on Duktape!");
+}
+
+bool JsBridgeContext::processPromiseQueue(int maxJobs, long long timeBudgetMs) {
+  bool hasPendingJobs;
+  ExecutionDeadline *executionDeadline = m_executionDeadline;
+  auto shouldYield = [executionDeadline]() { return executionDeadline->consumeYieldRequest(); };
+  if (m_promise->processJobs(maxJobs, timeBudgetMs, shouldYield, hasPendingJobs) != DUK_EXEC_SUCCESS) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  return hasPendingJobs;
+}
+
+bool JsBridgeContext::isJobPending() const {
+  return m_promise->hasPendingJobs();
+}
+
+// static
+JsBridgeContext *JsBridgeContext::getInstance(duk_context *ctx) {
+  // The heap udata (see init()) is only exposed via the memory functions
+  duk_memory_functions memoryFunctions;
+  duk_get_memory_functions(ctx, &memoryFunctions);
+  return static_cast<JsBridgeContext *>(memoryFunctions.udata);
 }
 
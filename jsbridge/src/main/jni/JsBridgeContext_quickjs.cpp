@@ -15,54 +15,469 @@
  */
 #include "JsBridgeContext.h"
 
+#include "AssetBuffer.h"
 #include "AutoReleasedJSValue.h"
+#include "CallTracer.h"
 #include "ExceptionHandler.h"
+#include "ExecutionDeadline.h"
 #include "JavaObject.h"
 #include "JavaScriptLambda.h"
 #include "JavaScriptObject.h"
 #include "JavaType.h"
 #include "JavaTypeProvider.h"
 #include "JniCache.h"
+#include "JsHeapSnapshot.h"
+#include "JsCompiledCodeCache.h"
+#include "JsConsole.h"
+#include "JsMessage.h"
+#include "JsModuleRegistry.h"
+#include "LocalStorage.h"
+#include "Lz4Frame.h"
+#include "JsPrecompiler.h"
+#include "JsProfiler.h"
+#include "JsRuntime.h"
+#include "JsSharedBuffer.h"
+#include "JsValueTable.h"
+#include "JsWrapperCache.h"
+#include "PoolAllocator.h"
 #include "QuickJsUtils.h"
+#include "ScratchArena.h"
+#include "TrafficRecorder.h"
 #include "custom_stringify.h"
 #include "log.h"
 #include "exceptions/JniException.h"
 #include "exceptions/JsException.h"
 #include "java-types/Deferred.h"
 #include "java-types/Object.h"
+#include "jni-helpers/JniGlobalRef.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
 #include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 
 // Internal
 // ---
 
 namespace {
-  const char *JSBRIDGE_CPP_CLASS_PROP_NAME = "__jsbridge_cpp";
+  // Record the current JS call stack into the profiler
+  void sampleJsStack(JsBridgeContext *jsBridgeContext) {
+    JSStackFrameInfo frameInfos[JsProfiler::MAX_STACK_DEPTH];
+    JsProfiler::Frame frames[JsProfiler::MAX_STACK_DEPTH];
+
+    int frameCount = JS_GetStackFrames(jsBridgeContext->getQuickJsContext(), frameInfos, JsProfiler::MAX_STACK_DEPTH);
+    for (int i = 0; i < frameCount; ++i) {
+      frames[i] = JsProfiler::Frame { frameInfos[i].function_name, frameInfos[i].file_name, frameInfos[i].line_number };
+    }
+    jsBridgeContext->getProfiler()->addSample(frames, frameCount);
+  }
 
-  //int interrupt_handler(JSRuntime *rt, void *opaque) {
-  //  return 0;
-  //}
+  // Sample the JS call stack when profiling and return true if the running script must be
+  // aborted because the deadline of the current evaluation has been exceeded
+  bool checkInterrupt(JsBridgeContext *jsBridgeContext) {
+    if (jsBridgeContext->getProfiler()->isSampleDue()) {
+      sampleJsStack(jsBridgeContext);
+    }
 
-  JSModuleDef *jsModuleLoader(JSContext *ctx, const char *moduleName, void *opaque) {
+    ExecutionDeadline *executionDeadline = jsBridgeContext->getExecutionDeadline();
+
+    bool justExceeded = false;
+    if (!executionDeadline->check(&justExceeded)) {
+      return false;
+    }
+
+    if (justExceeded) {
+      alog_warn("JS execution timeout (%lld ms) exceeded: interrupting the script", executionDeadline->getTimeoutMs());
+      jsBridgeContext->getJniCache()->getJsBridgeInterface().notifyJsExecutionTimeout(executionDeadline->getTimeoutMs());
+    }
+    return true;
+  }
+
+  int interruptHandler(JSRuntime *, void *opaque) {
+    auto jsRuntime = static_cast<JsRuntime *>(opaque);
+
+    bool interrupt = false;
+    for (JsBridgeContext *jsBridgeContext : jsRuntime->getContexts()) {
+      // With a shared runtime, only the contexts currently running JS are concerned
+      if (jsRuntime->isShared() && !jsBridgeContext->getExecutionDeadline()->isInScope()) {
+        continue;
+      }
+      interrupt = checkInterrupt(jsBridgeContext) || interrupt;
+    }
+    return interrupt ? 1 : 0;
+  }
+
+  // The interrupt handler is only needed for the execution timeout and the profiler of the
+  // contexts of the runtime
+  void updateInterruptHandler(JsRuntime *jsRuntime) {
+    bool isNeeded = false;
+    for (const JsBridgeContext *jsBridgeContext : jsRuntime->getContexts()) {
+      isNeeded = isNeeded || jsBridgeContext->getExecutionDeadline()->getTimeoutMs() > 0 || jsBridgeContext->getProfiler()->isRunning();
+    }
+
+    JSRuntime *rt = jsRuntime->getQuickJsRuntime();
+    if (isNeeded) {
+      JS_SetInterruptHandler(rt, interruptHandler, jsRuntime);
+    } else {
+      JS_SetInterruptHandler(rt, nullptr, nullptr);
+    }
+  }
+
+  // State of the heap walk (see JS_WalkHeap()): the references which are not held by the GC
+  // objects themselves (i.e. by the bridge or by the engine) are counted so that they can be
+  // reported from synthetic nodes
+  struct HeapWalk {
+    JsHeapSnapshot snapshot;
+    std::unordered_map<const void *, int> externalRefCounts;
+    std::unordered_multiset<const void *> namedEdgeTargets;  // of the current object
+    uint32_t unnamedEdgeCount = 0;  // of the current object
+  };
+
+  void heapWalkNode(void *opaque, const void *ptr, const char *type, const char *name, size_t selfSize, int refCount) {
+    auto heapWalk = static_cast<HeapWalk *>(opaque);
+    heapWalk->snapshot.addNode(ptr, type, name, selfSize);
+    heapWalk->externalRefCounts[ptr] += refCount;
+    heapWalk->namedEdgeTargets.clear();
+    heapWalk->unnamedEdgeCount = 0;
+  }
+
+  void heapWalkEdge(void *opaque, const void *from, const void *to, const char *type, const char *name, uint32_t index) {
+    auto heapWalk = static_cast<HeapWalk *>(opaque);
+    heapWalk->snapshot.addEdge(from, to, type, name, index);
+    heapWalk->namedEdgeTargets.insert(to);
+  }
+
+  void heapWalkChild(void *opaque, const void *from, const void *to) {
+    auto heapWalk = static_cast<HeapWalk *>(opaque);
+    --heapWalk->externalRefCounts[to];
+
+    // Only report the references which have not been named by heapWalkEdge()
+    auto it = heapWalk->namedEdgeTargets.find(to);
+    if (it != heapWalk->namedEdgeTargets.end()) {
+      heapWalk->namedEdgeTargets.erase(it);
+    } else {
+      heapWalk->snapshot.addEdge(from, to, "hidden", nullptr, heapWalk->unnamedEdgeCount++);
+    }
+  }
+
+  // localStorage methods (magic: see below)
+  enum LocalStorageMethod {
+    Method_GetItem, Method_SetItem, Method_RemoveItem, Method_Clear, Method_Key, Method_Length
+  };
+
+  // Convert the given JS value to a UTF-8 string, return false on exception
+  bool toUtf8String(JSContext *ctx, JSValueConst v, std::string *pStr) {
+    size_t length = 0;
+    const char *cstr = JS_ToCStringLen(ctx, &length, v);
+    if (cstr == nullptr) {
+      return false;
+    }
+
+    pStr->assign(cstr, length);
+    JS_FreeCString(ctx, cstr);
+    return true;
+  }
+
+  JSValue localStorageMethod(JSContext *ctx, JSValueConst, int argc, JSValueConst *argv, int magic) {
+    LocalStorage *localStorage = JsBridgeContext::getInstance(ctx)->getLocalStorage();
+
+    static const int argCounts[] = { 1, 2, 1, 0, 1, 0 };
+    if (argc < argCounts[magic]) {
+      return JS_ThrowTypeError(ctx, "localStorage: %d argument(s) required, but only %d present", argCounts[magic], argc);
+    }
+
+    try {
+      std::string key, value;
+      switch (magic) {
+        case Method_GetItem:
+          if (!toUtf8String(ctx, argv[0], &key)) return JS_EXCEPTION;
+          if (!localStorage->getItem(key, &value)) return JS_NULL;
+          return JS_NewStringLen(ctx, value.data(), value.size());
+
+        case Method_SetItem:
+          if (!toUtf8String(ctx, argv[0], &key) || !toUtf8String(ctx, argv[1], &value)) return JS_EXCEPTION;
+          localStorage->setItem(key, value);
+          return JS_UNDEFINED;
+
+        case Method_RemoveItem:
+          if (!toUtf8String(ctx, argv[0], &key)) return JS_EXCEPTION;
+          localStorage->removeItem(key);
+          return JS_UNDEFINED;
+
+        case Method_Clear:
+          localStorage->clear();
+          return JS_UNDEFINED;
+
+        case Method_Key: {
+          uint32_t index = 0;
+          if (JS_ToUint32(ctx, &index, argv[0]) != 0) return JS_EXCEPTION;
+          if (!localStorage->key(index, &key)) return JS_NULL;
+          return JS_NewStringLen(ctx, key.data(), key.size());
+        }
+
+        default:
+          return JS_NewInt64(ctx, static_cast<int64_t>(localStorage->length()));
+      }
+    } catch (const std::exception &e) {
+      JsBridgeContext::getInstance(ctx)->getExceptionHandler()->jsThrow(e);
+      return JS_EXCEPTION;
+    }
+  }
+
+  // notify() method of the SharedArrayBuffers created by Java (see JsBridge.newJsSharedBuffer())
+  JSValue sharedBufferNotify(JSContext *ctx, JSValueConst thisVal, int, JSValueConst *) {
+    // Only the SharedArrayBuffers have a header with a notification counter (their memory is
+    // always allocated by JsSharedBuffer) but the method can be called on any object
+    if (!JS_IsSharedArrayBuffer(thisVal)) {
+      return JS_ThrowTypeError(ctx, "notify() must be called on a SharedArrayBuffer");
+    }
+
+    size_t size;
+    uint8_t *data = JS_GetArrayBuffer(ctx, &size, thisVal);
+    if (data == nullptr) {
+      return JS_EXCEPTION;
+    }
+
+    JsSharedBuffer::notify(data);
+    return JS_UNDEFINED;
+  }
+
+  // Append the console representation of the given value
+  void appendConsoleArg(const JsBridgeContext *jsBridgeContext, JsConsole::Mode mode, JSValueConst v, std::string &message) {
+    JSContext *ctx = jsBridgeContext->getQuickJsContext();
+
+    if (JS_IsUndefined(v)) {
+      message += "undefined";
+      return;
+    }
+
+    std::string str;
+    if (mode == JsConsole::Mode::AsJson && !JS_IsString(v)) {
+      JSValue jsonValue = custom_stringify(ctx, jsBridgeContext->getUtils(), v, true);
+      bool ok = JS_IsString(jsonValue) && toUtf8String(ctx, jsonValue, &str);
+      JS_FreeValue(ctx, jsonValue);
+      if (ok) {
+        message += str;
+        return;
+      }
+      // Not serializable (e.g. function or cyclic object) => default string conversion
+      JS_FreeValue(ctx, JS_GetException(ctx));
+    }
+
+    if (toUtf8String(ctx, v, &str)) {
+      message += str;
+    } else {
+      JS_FreeValue(ctx, JS_GetException(ctx));
+      message += "<unprintable>";
+    }
+  }
+
+  // console methods (magic: JsConsole::Method)
+  JSValue consoleMethod(JSContext *ctx, JSValueConst, int argc, JSValueConst *argv, int magic) {
     JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
-    JniContext *jniContext = jsBridgeContext->getJniContext();
+    JsConsole *console = jsBridgeContext->getConsole();
+    auto method = static_cast<JsConsole::Method>(magic);
 
-    auto contentRef = jsBridgeContext->getJniCache()->getJsBridgeInterface().callJsModuleLoader(JStringLocalRef(jniContext, moduleName));
+    // Check the priority before converting anything
+    int priority = console->getEnabledPriority(method);
+    if (priority == 0) {
+      return JS_UNDEFINED;
+    }
 
-    if (jniContext->exceptionCheck()) {
-      jsBridgeContext->getExceptionHandler()->jsThrow(JniException(jniContext));
-      return nullptr;
+    int firstArgIndex = 0;
+    std::string message;
+    if (method == JsConsole::Method_Assert) {
+      if (argc > 0 && JS_ToBool(ctx, argv[0]) > 0) {
+        return JS_UNDEFINED;
+      }
+      firstArgIndex = 1;
+      message = "Assertion failed:";
+    }
+
+    try {
+      for (int i = firstArgIndex; i < argc; ++i) {
+        if (!message.empty()) {
+          message += ' ';
+        }
+        appendConsoleArg(jsBridgeContext, console->getMode(), argv[i], message);
+      }
+
+      console->append(priority, std::move(message));
+    } catch (const std::exception &e) {
+      jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return JS_EXCEPTION;
+    }
+    return JS_UNDEFINED;
+  }
+
+  // Serialize the given compiled function or module into a Java byte array
+  JArrayLocalRef<jbyte> writeBytecode(const JsBridgeContext *jsBridgeContext, JSValueConst compiledValue) {
+    JSContext *ctx = jsBridgeContext->getQuickJsContext();
+
+    size_t size = 0;
+    uint8_t *buf = JS_WriteObject(ctx, &size, compiledValue, JS_WRITE_OBJ_BYTECODE);
+    if (buf == nullptr) {
+      throw jsBridgeContext->getExceptionHandler()->getCurrentJsException();
+    }
+
+    JArrayLocalRef<jbyte> bytecode(jsBridgeContext->getJniContext(), static_cast<jsize>(size));
+    bytecode.setRegion(0, static_cast<jsize>(size), reinterpret_cast<const jbyte *>(buf));
+    js_free(ctx, buf);
+
+    return bytecode;
+  }
+
+  // Deserialize a compiled function or module from the given buffer
+  JSValue readBytecode(const JsBridgeContext *jsBridgeContext, const uint8_t *buf, size_t size) {
+    JSContext *ctx = jsBridgeContext->getQuickJsContext();
+
+    JSValue v = JS_ReadObject(ctx, buf, size, JS_READ_OBJ_BYTECODE);
+
+    if (JS_IsException(v)) {
+      // Invalid or incompatible bytecode => nothing has been evaluated yet
+      JsException jsException = jsBridgeContext->getExceptionHandler()->getCurrentJsException();
+      throw std::invalid_argument(std::string("Cannot read JS bytecode: ") + jsException.what());
+    }
+
+    return v;
+  }
+
+  // Evaluate the given global code (zero-terminated) via its bytecode from the JsCompiledCodeCache,
+  // compiling and caching it with the given key if needed
+  JSValue evalCachedCode(JSContext *ctx, const std::string &key, const char *code, size_t length, const char *fileName) {
+    if (length > JsCompiledCodeCache::MAX_SOURCE_LENGTH) {
+      return JS_Eval(ctx, code, length, fileName, JS_EVAL_TYPE_GLOBAL);
     }
 
-    if (contentRef.isNull()) {
-      JS_ThrowTypeError(ctx, "JS module returned a null content");
+    JsCompiledCodeCache &cache = JsCompiledCodeCache::getInstance();
+
+    JSValue funcVal;
+    std::shared_ptr<const std::string> bytecode = cache.find(key);
+    if (bytecode) {
+      funcVal = JS_ReadObject(ctx, reinterpret_cast<const uint8_t *>(bytecode->data()), bytecode->size(), JS_READ_OBJ_BYTECODE);
+    } else {
+      funcVal = JS_Eval(ctx, code, length, fileName, JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+      if (JS_IsException(funcVal)) {
+        return funcVal;
+      }
+
+      size_t size = 0;
+      uint8_t *buf = JS_WriteObject(ctx, &size, funcVal, JS_WRITE_OBJ_BYTECODE);
+      if (buf != nullptr) {
+        cache.add(key, std::string(reinterpret_cast<const char *>(buf), size));
+        js_free(ctx, buf);
+      } else {
+        // Not being able to cache the bytecode is not fatal
+        JS_FreeValue(ctx, JS_GetException(ctx));
+      }
+    }
+
+    if (JS_IsException(funcVal)) {
+      return funcVal;
+    }
+
+    // Note: JS_EvalFunction() frees funcVal
+    return JS_EvalFunction(ctx, funcVal);
+  }
+
+  // Deserialize a compiled module, returning JS_EXCEPTION (with a pending JS exception) on failure
+  JSValue readModuleBytecode(const JsBridgeContext *jsBridgeContext, const uint8_t *buf, size_t size) {
+    JSContext *ctx = jsBridgeContext->getQuickJsContext();
+
+    JSValue funcVal;
+    try {
+      funcVal = readBytecode(jsBridgeContext, buf, size);
+    } catch (const std::exception &e) {
+      jsBridgeContext->getExceptionHandler()->jsThrow(e);
+      return JS_EXCEPTION;
+    }
+
+    if (JS_VALUE_GET_TAG(funcVal) != JS_TAG_MODULE) {
+      JS_FreeValue(ctx, funcVal);
+      JS_ThrowTypeError(ctx, "JS module bytecode does not contain a module");
+      return JS_EXCEPTION;
+    }
+
+    return funcVal;
+  }
+
+  // Compile the module source and, if the bytecode cache is enabled, return its bytecode to Java
+  // Note: the code must be zero-terminated (code[length] == '\0')
+  JSValue compileModule(JsBridgeContext *jsBridgeContext, const char *code, size_t length, const char *moduleName) {
+    JSContext *ctx = jsBridgeContext->getQuickJsContext();
+
+    JSValue funcVal = JS_Eval(ctx, code, length, moduleName, JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+    if (JS_IsException(funcVal)) {
+      return funcVal;
+    }
+
+    if (jsBridgeContext->isBytecodeCacheEnabled()) {
+      JniContext *jniContext = jsBridgeContext->getJniContext();
+      const JsBridgeInterface &jsBridgeInterface = jsBridgeContext->getJniCache()->getJsBridgeInterface();
+
+      // Not being able to cache the bytecode is not fatal
+      try {
+        JStringLocalRef moduleNameRef(jniContext, moduleName);
+        jsBridgeInterface.storeJsModuleBytecode(moduleNameRef, writeBytecode(jsBridgeContext, funcVal));
+      } catch (const std::exception &e) {
+        alog_warn("Could not get the bytecode of JS module %s: %s", moduleName, e.what());
+      }
+      jniContext->exceptionClear();
+    }
+
+    return funcVal;
+  }
+
+  // Note: the module loader functions are set for the whole runtime and dispatched to the context
+  // importing the module (see JsBridgeContext::setModuleLoaderFuncs())
+  JSModuleDef *jsModuleLoader(JSContext *ctx, const char *moduleName, void *opaque) {
+    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    if (!jsBridgeContext->getModuleRegistry()->isLoaderEnabled()) {
+      JS_ThrowReferenceError(ctx, "could not load module '%s'", moduleName);
       return nullptr;
     }
 
-    const char *content = contentRef.toUtf8Chars();
-    const size_t contentLength = contentRef.utf8Length();
+    JniContext *jniContext = jsBridgeContext->getJniContext();
+    const JsBridgeInterface &jsBridgeInterface = jsBridgeContext->getJniCache()->getJsBridgeInterface();
+
+    JSValue funcVal;
+
+    // Registered modules are loaded without any call to Java
+    JsModuleRegistry::Module registeredModule;
+    if (jsBridgeContext->getModuleRegistry()->take(moduleName, registeredModule)) {
+      const std::string &content = registeredModule.content;
+      if (registeredModule.isBytecode) {
+        funcVal = readModuleBytecode(jsBridgeContext, reinterpret_cast<const uint8_t *>(content.data()), content.size());
+      } else {
+        funcVal = compileModule(jsBridgeContext, content.c_str(), content.size(), moduleName);
+      }
+    } else {
+      // The module loader returns either the source code (String) or its bytecode (ByteArray)
+      JStringLocalRef moduleNameRef(jniContext, moduleName);
+      auto moduleRef = jsBridgeInterface.callJsModuleLoader(moduleNameRef);
+
+      if (jniContext->exceptionCheck()) {
+        jsBridgeContext->getExceptionHandler()->jsThrow(JniException(jniContext));
+        return nullptr;
+      }
 
-    JSValue funcVal = JS_Eval(ctx, content, contentLength, moduleName, JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+      if (moduleRef.isNull()) {
+        JS_ThrowTypeError(ctx, "JS module returned a null content");
+        return nullptr;
+      }
+
+      if (jniContext->isInstanceOf(moduleRef, jsBridgeContext->getJniCache()->getJavaClass(JavaTypeId::ByteArray))) {
+        JArrayLocalRef<jbyte> bytecode(moduleRef.staticCast<jarray>());
+        funcVal = readModuleBytecode(jsBridgeContext, reinterpret_cast<const uint8_t *>(bytecode.getElements()), bytecode.getLength());
+      } else {
+        JStringLocalRef contentRef(moduleRef.staticCast<jstring>());
+        funcVal = compileModule(jsBridgeContext, contentRef.toUtf8Chars(), contentRef.utf8Length(), moduleName);
+        contentRef.releaseChars();
+      }
+    }
 
     if (JS_IsException(funcVal)) {
       return nullptr;
@@ -74,6 +489,42 @@ namespace {
     return m;
   }
 
+  // Resolve the imported module names via the Java normalizer, memoizing the results so that
+  // importing the same module again does not need any call to Java. The contexts without any
+  // custom normalizer use the default one.
+  char *jsModuleNameNormalizer(JSContext *ctx, const char *baseName, const char *moduleName, void *opaque) {
+    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    JsModuleRegistry *moduleRegistry = jsBridgeContext->getModuleRegistry();
+    if (!moduleRegistry->isNameNormalizerEnabled()) {
+      return JS_DefaultModuleNormalizeName(ctx, baseName, moduleName);
+    }
+
+    const std::string *memoizedName = moduleRegistry->findNormalizedName(baseName, moduleName);
+    if (memoizedName != nullptr) {
+      return js_strdup(ctx, memoizedName->c_str());
+    }
+
+    JniContext *jniContext = jsBridgeContext->getJniContext();
+    const JsBridgeInterface &jsBridgeInterface = jsBridgeContext->getJniCache()->getJsBridgeInterface();
+
+    JStringLocalRef normalizedNameRef = jsBridgeInterface.callJsModuleNameNormalizer(
+        JStringLocalRef(jniContext, baseName), JStringLocalRef(jniContext, moduleName));
+
+    if (jniContext->exceptionCheck()) {
+      jsBridgeContext->getExceptionHandler()->jsThrow(JniException(jniContext));
+      return nullptr;
+    }
+
+    if (normalizedNameRef.isNull()) {
+      JS_ThrowTypeError(ctx, "JS module name normalizer returned null for %s", moduleName);
+      return nullptr;
+    }
+
+    std::string normalizedName = normalizedNameRef.toStdString();
+    moduleRegistry->addNormalizedName(baseName, moduleName, normalizedName);
+    return js_strdup(ctx, normalizedName.c_str());
+  }
+
   void promiseRejectionTracker(JSContext *ctx, JSValueConst promise, JSValueConst reason, JS_BOOL isHandled, void *opaque) {
     if (isHandled) return;
 
@@ -97,37 +548,235 @@ JsBridgeContext::JsBridgeContext()
 }
 
 JsBridgeContext::~JsBridgeContext() {
+  // The pending jobs (e.g. promise reactions) of this context must not run after it has been
+  // freed, which would otherwise happen with a shared runtime
+  if (m_ctx != nullptr) {
+    JS_FreePendingJobs(m_ctx);
+  }
+
+  // Release the JsValue handles before the context
+  delete m_jsValueTable;
+
+  // Release the interned atoms before the context, too
+  delete m_utils;
+
+  delete m_moduleRegistry;
+
   JS_FreeContext(m_ctx);
-  JS_FreeRuntime(m_runtime);
+
+  // Either finalize the objects of this context via GC (shared runtime) or release the runtime
+  // together with the pooled memory (last context)
+  if (m_jsRuntime != nullptr && !m_jsRuntime->releaseContext(this)) {
+    updateInterruptHandler(m_jsRuntime);
+  }
+
+  // The finalized JS wrappers have removed their entries
+  delete m_jsWrapperCache;
 
   delete m_exceptionHandler;
-  delete m_utils;
   delete m_jniCache;
+  delete m_callTracer;
+  delete m_trafficRecorder;
+  delete m_scratchArena;
+  delete m_executionDeadline;
+  delete m_profiler;
+  delete m_console;
+#if defined(JSBRIDGE_CONVERSION_STATS)
+  delete m_conversionStats;
+#endif
 }
 
-void JsBridgeContext::init(JniContext *jniContext, const JniLocalRef<jobject> &jsBridgeObject) {
+void JsBridgeContext::init(JniContext *jniContext, const JniLocalRef<jobject> &jsBridgeObject, const EngineSettings &engineSettings) {
   m_jniContext = jniContext;
 
-  m_runtime = JS_NewRuntime();
+  {
+    TimedSection section("JsBridge engine creation", m_startupTimings.engineNs);
 
-  //JS_SetInterruptHandler(rt, interrupt_handler, NULL)
+    if (engineSettings.sharedRuntimeContext != nullptr) {
+      m_jsRuntime = engineSettings.sharedRuntimeContext->m_jsRuntime;
+    } else {
+      m_jsRuntime = JsRuntime::create(engineSettings);
+    }
+    m_runtime = m_jsRuntime->getQuickJsRuntime();
+    m_allocator = m_jsRuntime->getAllocator();
 
-  m_ctx = JS_NewContext(m_runtime);
-  JS_SetMaxStackSize(m_runtime, 1 * 1024 * 1024);  // default: 256kb, now: 1MB
+    m_ctx = JS_NewContext(m_runtime);
+    if (m_ctx == nullptr) {
+      if (engineSettings.sharedRuntimeContext == nullptr) {
+        m_jsRuntime->releaseContext(this);
+      }
+      m_jsRuntime = nullptr;
+      m_runtime = nullptr;
+      m_allocator = nullptr;
+      throw std::bad_alloc();
+    }
 
-  m_jniCache = new JniCache(this, jsBridgeObject);
-  m_utils = new QuickJsUtils(jniContext, m_ctx);
-  m_exceptionHandler = new ExceptionHandler(this);
+    // Find our way back from a C callback (see getInstance())
+    JS_SetContextOpaque(m_ctx, this);
+    m_jsRuntime->addContext(this);
+  }
 
-  // Store the JsBridgeContext instance in the global object so we can find our way back from a C callback
-  JSValue cppWrapperObj = m_utils->createCppPtrValue(this, false);
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
-  JS_SetPropertyStr(m_ctx, globalObj, JSBRIDGE_CPP_CLASS_PROP_NAME, cppWrapperObj);
-  // No JS_FreeValue(m_ctx, cppWrapperObj) after JS_SetPropertyStr()
-  JS_FreeValue(m_ctx, globalObj);
+  {
+    TimedSection section("JsBridge JniCache creation", m_startupTimings.jniCacheNs);
+    m_jniCache = new JniCache(this, jsBridgeObject);
+    if (engineSettings.preloadJniCache) {
+      m_jniCache->preload();
+    }
+  }
+
+  TimedSection section("JsBridge setup", m_startupTimings.bridgeSetupNs);
+  m_callTracer = new CallTracer();
+  m_trafficRecorder = new TrafficRecorder();
+  m_scratchArena = new ScratchArena();
+  m_executionDeadline = new ExecutionDeadline();
+  m_executionDeadline->setTimeoutMs(engineSettings.executionTimeoutMs);
+  m_profiler = new JsProfiler();
+  m_executionDeadline->setProfiler(m_profiler);
+#if defined(JSBRIDGE_CONVERSION_STATS)
+  m_conversionStats = new ConversionStats();
+#endif
+  m_utils = new QuickJsUtils(jniContext, m_ctx, m_jsRuntime->getCppWrapperCounters(), m_scratchArena);
+  m_exceptionHandler = new ExceptionHandler(this);
+  m_jsValueTable = new JsValueTable(m_ctx);
+  m_moduleRegistry = new JsModuleRegistry();
+  m_jsWrapperCache = new JsWrapperCache(this);
 
   // Unhandled promise exceptions
   JS_SetHostPromiseRejectionTracker(m_runtime, promiseRejectionTracker, nullptr);
+
+  updateInterruptHandler(m_jsRuntime);
+}
+
+void JsBridgeContext::runGc() {
+  JS_RunGC(m_runtime);
+}
+
+void JsBridgeContext::runIdleGc(size_t allocationThreshold) {
+  JS_RunGC(m_runtime);
+
+  if (allocationThreshold > 0) {
+    JS_SetNextGCAllocationThreshold(m_runtime, allocationThreshold);
+  }
+}
+
+void JsBridgeContext::enableStringCache(size_t entryCount) {
+  m_utils->enableStringCache(entryCount);
+}
+
+void JsBridgeContext::onMemoryPressure(bool critical) {
+  m_javaTypeProvider.clearCaches();
+  JsCompiledCodeCache::getInstance().clear();
+  if (m_utils->getStringCache() != nullptr) {
+    m_utils->getStringCache()->clear();
+  }
+  if (critical) {
+    m_jsValueTable->compact();
+  }
+
+  JS_RunGC(m_runtime);
+
+  if (m_allocator != nullptr) {
+    m_allocator->releaseFreeChunks();
+  }
+}
+
+long long JsBridgeContext::compactHeap() {
+  // Not supported: QuickJS does not expose the compaction of property tables
+  return 0;
+}
+
+long long JsBridgeContext::getHeapSize() const {
+  if (m_allocator != nullptr) {
+    return static_cast<long long>(m_allocator->getAllocatedSize());
+  }
+
+  JSMemoryUsage memoryUsage;
+  JS_ComputeMemoryUsage(m_runtime, &memoryUsage);
+  return memoryUsage.malloc_size;
+}
+
+JsBridgeContext::MemoryUsage JsBridgeContext::getMemoryUsage() const {
+  JSMemoryUsage jsMemoryUsage;
+  JS_ComputeMemoryUsage(m_runtime, &jsMemoryUsage);
+
+  MemoryUsage memoryUsage;
+  memoryUsage.heapSize = getHeapSize();
+  memoryUsage.objectCount = jsMemoryUsage.obj_count;
+  memoryUsage.stringCount = jsMemoryUsage.str_count;
+  memoryUsage.atomCount = jsMemoryUsage.atom_count;
+  const CppWrapperCounters *cppWrapperCounters = m_jsRuntime->getCppWrapperCounters();
+  memoryUsage.cppWrapperCount = cppWrapperCounters->cppWrapperCount;
+  memoryUsage.javaRefCount = cppWrapperCounters->javaRefCount;
+  memoryUsage.jsValueCount = m_jsValueTable->size();
+  memoryUsage.jniGlobalRefCount = getJniGlobalRefCount();
+  return memoryUsage;
+}
+
+size_t JsBridgeContext::getJniGlobalRefCount() const {
+  return m_jniContext->getGlobalRefCount() + m_jsRuntime->getCppWrapperCounters()->javaRefGlobalRefCount;
+}
+
+void JsBridgeContext::checkJniGlobalRefLimit() {
+  if (m_jniGlobalRefLimit == 0 || getJniGlobalRefCount() < m_nextJniGlobalRefGcCount) {
+    return;
+  }
+
+  runGc();
+
+  // Still (mostly) reachable: only run the GC again after another eighth of the limit
+  const size_t globalRefCount = getJniGlobalRefCount();
+  m_nextJniGlobalRefGcCount = std::max(m_jniGlobalRefLimit, globalRefCount + std::max(m_jniGlobalRefLimit / 8, size_t(1)));
+  if (globalRefCount >= m_jniGlobalRefLimit) {
+    alog_warn("%zu JNI global refs are still held after the GC (limit: %zu)", globalRefCount, m_jniGlobalRefLimit);
+  }
+}
+
+std::string JsBridgeContext::takeHeapSnapshot() {
+  // Only keep the live objects
+  runGc();
+
+  HeapWalk heapWalk;
+  const JSHeapWalkFuncs heapWalkFuncs = { heapWalkNode, heapWalkEdge, heapWalkChild };
+  JS_WalkHeap(m_runtime, &heapWalkFuncs, &heapWalk);
+
+  JsHeapSnapshot &snapshot = heapWalk.snapshot;
+
+  // References held by the JsValue table (JsValue instances and pending Deferred promises)
+  static const char jsValueTableNode = 0;
+  snapshot.addNode(&jsValueTableNode, "synthetic", "(JsBridge JsValue table)", 0);
+  snapshot.addEdge(nullptr, &jsValueTableNode, "internal", "JsValue table", 0);
+  m_jsValueTable->forEach([&](jlong handle, JSValueConst value, JSValueConst cppPtrOwner) {
+    const std::string name = std::to_string(handle);
+    for (JSValueConst v : { value, cppPtrOwner }) {
+      if (JS_VALUE_GET_TAG(v) == JS_TAG_OBJECT) {
+        snapshot.addEdge(&jsValueTableNode, JS_VALUE_GET_PTR(v), "property", name.c_str(), 0);
+        --heapWalk.externalRefCounts[JS_VALUE_GET_PTR(v)];
+      }
+    }
+  });
+
+  // Other references from the native side (bridge C++ objects, JS engine internals...)
+  static const char nativeReferencesNode = 0;
+  snapshot.addNode(&nativeReferencesNode, "synthetic", "(native references)", 0);
+  snapshot.addEdge(nullptr, &nativeReferencesNode, "internal", "native references", 0);
+  for (const auto &externalRefCount : heapWalk.externalRefCounts) {
+    if (externalRefCount.second > 0) {
+      snapshot.addEdge(&nativeReferencesNode, externalRefCount.first, "internal", "native reference", 0);
+    }
+  }
+
+  return snapshot.toJson();
+}
+
+void JsBridgeContext::startProfiler(long long samplingIntervalUs) {
+  m_profiler->start(samplingIntervalUs);
+  updateInterruptHandler(m_jsRuntime);
+}
+
+std::string JsBridgeContext::stopProfiler() {
+  std::string profile = m_profiler->stop();
+  updateInterruptHandler(m_jsRuntime);
+  return profile;
 }
 
 void JsBridgeContext::startDebugger(int /*port*/) {
@@ -138,8 +787,99 @@ void JsBridgeContext::cancelDebug() {
   // Not supported yet
 }
 
+void JsBridgeContext::enableLocalStorage(const std::string &strFilePath, const JObjectArrayLocalRef &initialKeys,
+                                         const JObjectArrayLocalRef &initialValues) {
+  m_localStorage = LocalStorage::open(strFilePath);
+
+  jsize initialItemCount = std::min(initialKeys.getLength(), initialValues.getLength());
+  for (jsize i = 0; i < initialItemCount; ++i) {
+    std::string key = JStringLocalRef(initialKeys.getElement(i).staticCast<jstring>()).toStdString();
+    std::string value;
+    if (!m_localStorage->getItem(key, &value)) {
+      m_localStorage->setItem(key, JStringLocalRef(initialValues.getElement(i).staticCast<jstring>()).toStdString());
+    }
+  }
+
+  JSValue localStorageObj = JS_NewObject(m_ctx);
+
+  static const struct {
+    const char *name;
+    int length;
+    LocalStorageMethod method;
+  } methods[] = {
+    { "getItem", 1, Method_GetItem },
+    { "setItem", 2, Method_SetItem },
+    { "removeItem", 1, Method_RemoveItem },
+    { "clear", 0, Method_Clear },
+    { "key", 1, Method_Key },
+  };
+  for (const auto &method : methods) {
+    JSValue func = JS_NewCFunctionMagic(m_ctx, localStorageMethod, method.name, method.length, JS_CFUNC_generic_magic, method.method);
+    JS_SetPropertyStr(m_ctx, localStorageObj, method.name, func);
+  }
+
+  JSAtom lengthAtom = JS_NewAtom(m_ctx, "length");
+  JSValue lengthGetter = JS_NewCFunctionMagic(m_ctx, localStorageMethod, "length", 0, JS_CFUNC_generic_magic, Method_Length);
+  JS_DefinePropertyGetSet(m_ctx, localStorageObj, lengthAtom, lengthGetter, JS_UNDEFINED, JS_PROP_CONFIGURABLE);
+  JS_FreeAtom(m_ctx, lengthAtom);
+
+  JSValueConst globalObj = m_utils->getGlobalObject();
+  JS_SetPropertyStr(m_ctx, globalObj, "localStorage", localStorageObj);
+}
+
+void JsBridgeContext::enableConsole(JsConsole::Mode mode, int minPriority, size_t ringBufferSize) {
+  delete m_console;
+  m_console = new JsConsole(this, mode, minPriority, ringBufferSize);
+
+  JSValue consoleObj = JS_NewObject(m_ctx);
+  for (int method = 0; method < JsConsole::Method_Count; ++method) {
+    const char *name = JsConsole::METHOD_NAMES[method];
+    JSValue func = JS_NewCFunctionMagic(m_ctx, consoleMethod, name, 0, JS_CFUNC_generic_magic, method);
+    JS_SetPropertyStr(m_ctx, consoleObj, name, func);
+  }
+
+  JSValueConst globalObj = m_utils->getGlobalObject();
+  JS_SetPropertyStr(m_ctx, globalObj, "console", consoleObj);
+}
+
 void JsBridgeContext::enableModuleLoader() {
-  JS_SetModuleLoaderFunc(m_runtime, nullptr, jsModuleLoader, nullptr);
+  m_moduleRegistry->enableLoader();
+  setModuleLoaderFuncs();
+}
+
+void JsBridgeContext::registerJsModules(const JObjectArrayLocalRef &names, const JObjectArrayLocalRef &contents, bool isBytecode) {
+  jsize count = names.getLength();
+  if (contents.getLength() != count) {
+    throw std::invalid_argument("The JS module names and contents must have the same size!");
+  }
+
+  for (jsize i = 0; i < count; ++i) {
+    JStringLocalRef nameRef(names.getElement(i).staticCast<jstring>());
+    JArrayLocalRef<jbyte> contentRef(contents.getElement(i).staticCast<jarray>());
+    if (nameRef.isNull() || contentRef.isNull()) {
+      throw std::invalid_argument("Cannot register a null JS module!");
+    }
+
+    JsModuleRegistry::Module module;
+    module.isBytecode = isBytecode;
+    module.content.assign(reinterpret_cast<const char *>(contentRef.getElements()), contentRef.getLength());
+    m_moduleRegistry->add(nameRef.toStdString(), std::move(module));
+  }
+}
+
+void JsBridgeContext::enableModuleNameNormalizer() {
+  m_moduleRegistry->enableNameNormalizer();
+  setModuleLoaderFuncs();
+}
+
+void JsBridgeContext::setModuleLoaderFuncs() {
+  // The same functions are set for all the contexts of a (possibly shared) runtime: they dispatch
+  // to the loader and to the normalizer of the context importing the module
+  JS_SetModuleLoaderFunc(m_runtime, jsModuleNameNormalizer, jsModuleLoader, nullptr);
+}
+
+std::string JsBridgeContext::getBytecodeVersion() const {
+  return "quickjs-" CONFIG_VERSION;
 }
 
 std::string JsBridgeContext::getCurrentScriptOrModuleName(int level) const {
@@ -165,69 +905,248 @@ std::string JsBridgeContext::getCurrentScriptOrModuleName(int level) const {
 }
 
 JValue JsBridgeContext::evaluateString(const JStringLocalRef &strCode, const JniLocalRef<jsBridgeParameter> &returnParameter,
-                                       bool awaitJsPromise) const {
+                                       bool awaitJsPromise, const JniLocalRef<jobject> &awaitingDeferred) const {
+  JSValue v = JS_Eval(m_ctx, strCode.toUtf8Chars(), strCode.utf8Length(), "eval", JS_EVAL_TYPE_GLOBAL);
+  JS_AUTORELEASE_VALUE(m_ctx, v);
+
+  strCode.releaseChars();  // release chars now as we don't need them anymore
+
+  if (JS_IsException(v)) {
+    alog("Could not evaluate string");
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  bool isDeferred = awaitJsPromise && JS_IsObject(v) && m_utils->hasProperty(v, QuickJsUtils::PropertyName::Then);
+
+  if (!isDeferred && returnParameter.isNull()) {
+    // No return type given: try to guess it out of the JS value
+    if (JS_IsBool(v) || JS_IsNumber(v) || JS_IsString(v)) {
+      // The result is a supported scalar type - return it.
+      return m_javaTypeProvider.getObjectType()->toJava(v);
+    }
+
+    if (JS_IsArray(m_ctx, v)) {
+      return m_javaTypeProvider.getObjectType()->toJavaArray(v);
+    }
+
+    // The result is an unsupported type, undefined, or null.
+    return JValue();
+  }
+
+  auto returnType = m_javaTypeProvider.getType(returnParameter, true /*boxed*/);
+
+  JValue value;
+  if (isDeferred && !returnType->isDeferred()) {
+    auto deferredType = m_javaTypeProvider.getDeferredType(returnParameter);
+    if (awaitingDeferred.isNull()) {
+      value = deferredType->toJava(v);
+    } else {
+      value = static_cast<const JavaTypes::Deferred *>(deferredType.get())->toJavaAwaited(v, awaitingDeferred);
+    }
+  } else {
+    value = returnType->toJava(v);
+  }
+
+  return value;
+}
+
+JValue JsBridgeContext::evaluateScalar(const JStringLocalRef &strCode, JavaTypeId id) const {
   JSValue v = JS_Eval(m_ctx, strCode.toUtf8Chars(), strCode.utf8Length(), "eval", JS_EVAL_TYPE_GLOBAL);
   JS_AUTORELEASE_VALUE(m_ctx, v);
 
-  strCode.releaseChars();  // release chars now as we don't need them anymore
+  strCode.releaseChars();
+
+  if (JS_IsException(v)) {
+    alog("Could not evaluate string");
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  return m_javaTypeProvider.getScalarType(id)->toJava(v);
+}
+
+JArrayLocalRef<jbyte> JsBridgeContext::evaluateFileContent(const JStringLocalRef &strCode, const std::string &strFileName,
+                                                           bool asModule, bool returnBytecode) const {
+  auto bytecode = evaluateUtf8FileContent(strCode.toUtf8Chars(), strCode.utf8Length(), strFileName, asModule, returnBytecode);
+  strCode.releaseChars();
+  return bytecode;
+}
+
+void JsBridgeContext::evaluateAsset(AAssetManager *assetManager, const std::string &strAssetPath, const std::string &strFileName,
+                                    bool asModule) const {
+  std::string code;
+  {
+    // JS_Eval() needs a zero-terminated input which is not given by the asset buffer
+    AssetBuffer assetBuffer(assetManager, strAssetPath);
+    code.assign(assetBuffer.data(), assetBuffer.length());
+  }
+
+  evaluateUtf8FileContent(code.c_str(), code.size(), strFileName, asModule, false);
+}
+
+void JsBridgeContext::evaluateBuiltInAsset(AAssetManager *assetManager, const std::string &strAssetPath) const {
+  // "a\0<asset path>"
+  std::string cacheKey;
+  cacheKey.append("a", 2).append(strAssetPath);
+
+  JsCompiledCodeCache &cache = JsCompiledCodeCache::getInstance();
+
+  JSValue funcVal;
+  std::shared_ptr<const std::string> bytecode = cache.find(cacheKey);
+  if (bytecode) {
+    // The asset does not even need to be opened
+    funcVal = JS_ReadObject(m_ctx, reinterpret_cast<const uint8_t *>(bytecode->data()), bytecode->size(), JS_READ_OBJ_BYTECODE);
+  } else {
+    std::string code;
+    {
+      // JS_Eval() needs a zero-terminated input which is not given by the asset buffer
+      AssetBuffer assetBuffer(assetManager, strAssetPath);
+      code.assign(assetBuffer.data(), assetBuffer.length());
+    }
+
+    funcVal = JS_Eval(m_ctx, code.c_str(), code.size(), strAssetPath.c_str(), JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+    if (!JS_IsException(funcVal)) {
+      size_t size = 0;
+      uint8_t *buf = JS_WriteObject(m_ctx, &size, funcVal, JS_WRITE_OBJ_BYTECODE);
+      if (buf != nullptr) {
+        cache.add(cacheKey, std::string(reinterpret_cast<const char *>(buf), size), false /*evictable*/);
+        js_free(m_ctx, buf);
+      } else {
+        // Not being able to cache the bytecode is not fatal
+        JS_FreeValue(m_ctx, JS_GetException(m_ctx));
+      }
+    }
+  }
+
+  if (JS_IsException(funcVal)) {
+    alog("Could not compile built-in asset %s", strAssetPath.c_str());
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  // Note: JS_EvalFunction() frees funcVal
+  JSValue v = JS_EvalFunction(m_ctx, funcVal);
+  JS_AUTORELEASE_VALUE(m_ctx, v);
+
+  if (JS_IsException(v)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+}
+
+JArrayLocalRef<jbyte> JsBridgeContext::evaluateUtf8FileContent(const char *code, size_t length, const std::string &strFileName,
+                                                               bool asModule, bool returnBytecode) const {
+  const int flags = (asModule ? JS_EVAL_TYPE_MODULE : JS_EVAL_TYPE_GLOBAL) | JS_EVAL_FLAG_COMPILE_ONLY;
+  JSValue funcVal = JS_Eval(m_ctx, code, length, strFileName.c_str(), flags);
+
+  if (JS_IsException(funcVal)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  JS_AUTORELEASE_VALUE(m_ctx, funcVal);
+
+  JArrayLocalRef<jbyte> bytecode = returnBytecode ? writeBytecode(this, funcVal) : JArrayLocalRef<jbyte>(JniLocalRef<jarray>());
+
+  // Note: JS_EvalFunction() frees the given value
+  JSValue v = JS_EvalFunction(m_ctx, JS_DupValue(m_ctx, funcVal));
+  JS_AUTORELEASE_VALUE(m_ctx, v);
+
+  if (JS_IsException(v)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  return bytecode;
+}
+
+void JsBridgeContext::evaluateBytecode(const JArrayLocalRef<jbyte> &bytecode, const std::string &strFileName) const {
+  const auto *buf = reinterpret_cast<const uint8_t *>(bytecode.getElements());
+  evaluateMaybeCompressedBytecode(buf, static_cast<size_t>(bytecode.getLength()), strFileName);
+}
+
+void JsBridgeContext::evaluateBytecodeAsset(AAssetManager *assetManager, const std::string &strAssetPath, const std::string &strFileName) const {
+  // Note: JS_ReadObject() copies what it needs so the asset can be closed right after
+  AssetBuffer assetBuffer(assetManager, strAssetPath);
+  evaluateMaybeCompressedBytecode(reinterpret_cast<const uint8_t *>(assetBuffer.data()), assetBuffer.length(), strFileName);
+}
+
+void JsBridgeContext::evaluateMaybeCompressedBytecode(const uint8_t *data, size_t size, const std::string &strFileName) const {
+  if (Lz4Frame::isFrame(data, size)) {
+    Lz4Frame::MappedBuffer decompressed = Lz4Frame::decompress(data, size);
+    evaluateBytecode(decompressed.data(), decompressed.size(), strFileName);
+    return;
+  }
+
+  evaluateBytecode(data, size, strFileName);
+}
 
-  if (JS_IsException(v)) {
-    alog("Could not evaluate string");
+void JsBridgeContext::evaluateBytecode(const uint8_t *data, size_t size, const std::string &strFileName) const {
+  JSValue funcVal = readBytecode(this, data, size);
+
+  if (JS_ResolveModule(m_ctx, funcVal) < 0) {
+    JS_FreeValue(m_ctx, funcVal);
+    alog("Could not resolve the imports of %s", strFileName.c_str());
     throw m_exceptionHandler->getCurrentJsException();
   }
 
-  bool isDeferred = awaitJsPromise && JS_IsObject(v) && m_utils->hasPropertyStr(v, "then");
-
-  if (!isDeferred && returnParameter.isNull()) {
-    // No return type given: try to guess it out of the JS value
-    if (JS_IsBool(v) || JS_IsNumber(v) || JS_IsString(v)) {
-      // The result is a supported scalar type - return it.
-      return m_javaTypeProvider.getObjectType()->toJava(v);
-    }
+  // Note: JS_EvalFunction() frees the given value
+  JSValue v = JS_EvalFunction(m_ctx, funcVal);
+  JS_AUTORELEASE_VALUE(m_ctx, v);
 
-    if (JS_IsArray(m_ctx, v)) {
-      return m_javaTypeProvider.getObjectType()->toJavaArray(v);
-    }
+  if (JS_IsException(v)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+}
 
-    // The result is an unsupported type, undefined, or null.
-    return JValue();
+// static
+JObjectArrayLocalRef JsBridgeContext::precompileFileContents(const JniContext *jniContext, const JObjectArrayLocalRef &fileNames,
+                                                             const JObjectArrayLocalRef &contents, bool asModule,
+                                                             int threadCount, JObjectArrayLocalRef &errors) {
+  jsize count = fileNames.getLength();
+  if (contents.getLength() != count || errors.getLength() != count) {
+    throw std::invalid_argument("The file names, contents and errors must have the same size!");
   }
 
-  auto returnType = m_javaTypeProvider.makeUniqueType(returnParameter, true /*boxed*/);
+  std::vector<JsPrecompiler::Source> sources(count);
+  for (jsize i = 0; i < count; ++i) {
+    JStringLocalRef fileNameRef(fileNames.getElement(i).staticCast<jstring>());
+    JArrayLocalRef<jbyte> contentRef(contents.getElement(i).staticCast<jarray>());
+    if (fileNameRef.isNull() || contentRef.isNull()) {
+      throw std::invalid_argument("Cannot precompile a null file!");
+    }
 
-  JValue value;
-  if (isDeferred && !returnType->isDeferred()) {
-    value = m_javaTypeProvider.getDeferredType(returnParameter)->toJava(v);
-  } else {
-    value = returnType->toJava(v);
+    sources[i].fileName = fileNameRef.toStdString();
+    sources[i].code.assign(reinterpret_cast<const char *>(contentRef.getElements()), contentRef.getLength());
   }
 
-  return value;
-}
-
-void JsBridgeContext::evaluateFileContent(const JStringLocalRef &strCode, const std::string &strFileName, bool asModule) const {
-  const int flags = asModule ? JS_EVAL_TYPE_MODULE : JS_EVAL_TYPE_GLOBAL;
-  JSValue v = JS_Eval(m_ctx, strCode.toUtf8Chars(), strCode.utf8Length(), strFileName.c_str(), flags);
-  JS_AUTORELEASE_VALUE(m_ctx, v);
+  // No JNI call while the workers are running
+  JsPrecompiler precompiler(asModule, static_cast<unsigned int>(std::max(threadCount, 1)));
+  std::vector<JsPrecompiler::Result> results = precompiler.compile(sources);
 
-  strCode.releaseChars();  // release chars now as we don't need them anymore
+  JObjectArrayLocalRef bytecodes(jniContext, count, jniContext->findClass("[B"));
+  for (jsize i = 0; i < count; ++i) {
+    const JsPrecompiler::Result &result = results[i];
+    if (!result.success) {
+      errors.setElement(i, JStringLocalRef(jniContext, result.error.c_str()));
+      continue;
+    }
 
-  if (JS_IsException(v)) {
-    throw m_exceptionHandler->getCurrentJsException();
+    auto size = static_cast<jsize>(result.bytecode.size());
+    JArrayLocalRef<jbyte> bytecode(jniContext, size);
+    bytecode.setRegion(0, size, reinterpret_cast<const jbyte *>(result.bytecode.data()));
+    bytecodes.setElement(i, bytecode);
   }
+
+  return bytecodes;
 }
 
 void JsBridgeContext::registerJavaObject(const std::string &strName, const JniLocalRef<jobject> &object,
-                                         const JObjectArrayLocalRef &methods) {
+                                         const std::string &strPrototypeName, const JObjectArrayLocalRef &methods,
+                                         bool lazyMethods) {
 
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
-  JS_AUTORELEASE_VALUE(m_ctx, globalObj);
+  JSValueConst globalObj = m_utils->getGlobalObject();
 
   if (m_utils->hasPropertyStr(globalObj, strName.c_str())) {
     throw std::invalid_argument("Cannot register Java object: global object called " + strName + " already exists");
   }
 
-  JSValue javaObjectValue = JavaObject::create(this, strName.c_str(), object, methods);
+  JSValue javaObjectValue = JavaObject::create(this, strName, object, strPrototypeName, methods, lazyMethods);
 
   // Save the JSValue as a global property
   JS_SetPropertyStr(m_ctx, globalObj, strName.c_str(), javaObjectValue);
@@ -237,8 +1156,7 @@ void JsBridgeContext::registerJavaObject(const std::string &strName, const JniLo
 void JsBridgeContext::registerJavaLambda(const std::string &strName, const JniLocalRef<jobject> &object,
                                          const JniLocalRef<jsBridgeMethod> &method) {
 
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
-  JS_AUTORELEASE_VALUE(m_ctx, globalObj);
+  JSValueConst globalObj = m_utils->getGlobalObject();
 
   if (m_utils->hasPropertyStr(globalObj, strName.c_str())) {
     throw std::invalid_argument("Cannot register Java lambda: global object called " + strName + " already exists");
@@ -250,12 +1168,11 @@ void JsBridgeContext::registerJavaLambda(const std::string &strName, const JniLo
   // No JS_FreeValue(m_ctx, javaLambdaHandlerValue) after JS_SetPropertyStr()
 }
 
-void JsBridgeContext::registerJsObject(const std::string &strName,
-                                       const JObjectArrayLocalRef &methods,
-                                       bool check) {
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
+jlong JsBridgeContext::registerJsObject(const std::string &strName,
+                                        const JObjectArrayLocalRef &methods,
+                                        bool check) {
+  JSValueConst globalObj = m_utils->getGlobalObject();
   JSValue jsObjectValue = JS_GetPropertyStr(m_ctx, globalObj, strName.c_str());
-  JS_FreeValue(m_ctx, globalObj);
 
   JS_AUTORELEASE_VALUE(m_ctx, jsObjectValue);
 
@@ -264,14 +1181,20 @@ void JsBridgeContext::registerJsObject(const std::string &strName,
 
   // Wrap it inside the JS object
   m_utils->createMappedCppPtrValue(cppJsObject, jsObjectValue, strName.c_str());
+
+  // Bind the JS object and its wrapper so that it can be called without any lookup
+  JSValue cppValue = m_utils->getMappedCppValue(jsObjectValue, strName.c_str());
+  jlong bindingHandle = m_jsValueTable->add(jsObjectValue, cppJsObject, cppValue);
+  JS_FreeValue(m_ctx, cppValue);
+
+  return bindingHandle;
 }
 
-void JsBridgeContext::registerJsLambda(const std::string &strName,
-                                       const JniLocalRef<jsBridgeMethod> &method) {
+jlong JsBridgeContext::registerJsLambda(const std::string &strName,
+                                        const JniLocalRef<jsBridgeMethod> &method) {
 
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
+  JSValueConst globalObj = m_utils->getGlobalObject();
   JSValue jsLambdaValue = JS_GetPropertyStr(m_ctx, globalObj, strName.c_str());
-  JS_FreeValue(m_ctx, globalObj);
 
   JS_AUTORELEASE_VALUE(m_ctx, jsLambdaValue);
 
@@ -280,17 +1203,23 @@ void JsBridgeContext::registerJsLambda(const std::string &strName,
 
   // Wrap it inside the JS object
   m_utils->createMappedCppPtrValue(cppJsLambda, jsLambdaValue, strName.c_str());
+
+  // Bind the JS lambda and its wrapper so that it can be called without any lookup
+  JSValue cppValue = m_utils->getMappedCppValue(jsLambdaValue, strName.c_str());
+  jlong bindingHandle = m_jsValueTable->add(jsLambdaValue, cppJsLambda, cppValue);
+  JS_FreeValue(m_ctx, cppValue);
+
+  return bindingHandle;
 }
 
 JValue JsBridgeContext::callJsMethod(const std::string &objectName,
-                                     const JniLocalRef<jobject> &javaMethod,
+                                     jint methodIndex,
                                      const JObjectArrayLocalRef &args,
                                      bool awaitJsPromise) {
 
   // Get the JS object
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
+  JSValueConst globalObj = m_utils->getGlobalObject();
   JSValue jsObjectValue = JS_GetPropertyStr(m_ctx, globalObj, objectName.c_str());
-  JS_FreeValue(m_ctx, globalObj);
 
   JS_AUTORELEASE_VALUE(m_ctx, jsObjectValue);
 
@@ -305,16 +1234,49 @@ JValue JsBridgeContext::callJsMethod(const std::string &objectName,
                                 " because it does not exist or has been deleted!");
   }
 
-  return cppJsObject->call(jsObjectValue, javaMethod, args, awaitJsPromise);
+  return cppJsObject->call(jsObjectValue, methodIndex, args, awaitJsPromise);
+}
+
+JValue JsBridgeContext::callJsMethod(jlong bindingHandle,
+                                     jint methodIndex,
+                                     const JObjectArrayLocalRef &args,
+                                     bool awaitJsPromise) {
+
+  auto cppJsObject = m_jsValueTable->getCppPtr<JavaScriptObject>(bindingHandle);
+  if (cppJsObject == nullptr) {
+    throw std::invalid_argument("Cannot access the JS object " + std::to_string(bindingHandle) +
+                                " because it has not been registered!");
+  }
+
+  JSValue jsObjectValue = m_jsValueTable->get(bindingHandle);
+  JS_AUTORELEASE_VALUE(m_ctx, jsObjectValue);
+
+  return cppJsObject->call(jsObjectValue, methodIndex, args, awaitJsPromise);
+}
+
+JValue JsBridgeContext::callJsMethod(jlong bindingHandle,
+                                     jint methodIndex,
+                                     const JArrayLocalRef<jlong> &packedArgs,
+                                     bool awaitJsPromise) {
+
+  auto cppJsObject = m_jsValueTable->getCppPtr<JavaScriptObject>(bindingHandle);
+  if (cppJsObject == nullptr) {
+    throw std::invalid_argument("Cannot access the JS object " + std::to_string(bindingHandle) +
+                                " because it has not been registered!");
+  }
+
+  JSValue jsObjectValue = m_jsValueTable->get(bindingHandle);
+  JS_AUTORELEASE_VALUE(m_ctx, jsObjectValue);
+
+  return cppJsObject->call(jsObjectValue, methodIndex, packedArgs, awaitJsPromise);
 }
 
 JValue JsBridgeContext::callJsLambda(const std::string &strFunctionName,
                                      const JObjectArrayLocalRef &args,
                                      bool awaitJsPromise) {
   // Get the JS function
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
-  JSValue jsLambdaValue = JS_GetPropertyStr(m_ctx, globalObj, strFunctionName.c_str());
-  JS_FreeValue(m_ctx, globalObj);
+  JSValueConst ownerObj = m_utils->getNamedValueOwner(strFunctionName);
+  JSValue jsLambdaValue = JS_GetPropertyStr(m_ctx, ownerObj, strFunctionName.c_str());
 
   JS_AUTORELEASE_VALUE(m_ctx, jsLambdaValue);
 
@@ -332,108 +1294,563 @@ JValue JsBridgeContext::callJsLambda(const std::string &strFunctionName,
   return cppJsLambda->call(this, args, awaitJsPromise);
 }
 
+JValue JsBridgeContext::callJsLambda(jlong bindingHandle,
+                                     const JObjectArrayLocalRef &args,
+                                     bool awaitJsPromise) {
+
+  auto cppJsLambda = m_jsValueTable->getCppPtr<JavaScriptLambda>(bindingHandle);
+  if (cppJsLambda == nullptr) {
+    throw std::invalid_argument("Cannot invoke the JS function " + std::to_string(bindingHandle) +
+                                " because it has not been registered!");
+  }
+
+  JSValue jsLambdaValue = m_jsValueTable->get(bindingHandle);
+  JS_AUTORELEASE_VALUE(m_ctx, jsLambdaValue);
+
+  return cppJsLambda->call(this, jsLambdaValue, args, awaitJsPromise);
+}
+
+JObjectArrayLocalRef JsBridgeContext::callJsLambdaBatch(jlong bindingHandle,
+                                                        const JObjectArrayLocalRef &argsArray,
+                                                        bool awaitJsPromise) {
+
+  auto cppJsLambda = m_jsValueTable->getCppPtr<JavaScriptLambda>(bindingHandle);
+  if (cppJsLambda == nullptr) {
+    throw std::invalid_argument("Cannot invoke the JS function " + std::to_string(bindingHandle) +
+                                " because it has not been registered!");
+  }
+
+  JSValue jsLambdaValue = m_jsValueTable->get(bindingHandle);
+  JS_AUTORELEASE_VALUE(m_ctx, jsLambdaValue);
+
+  const jsize count = argsArray.getLength();
+  JObjectArrayLocalRef results(m_jniContext, count, m_jniCache->getObjectClass());
+  if (results.isNull()) {
+    throw JniException(m_jniContext);
+  }
+
+  for (jsize i = 0; i < count; ++i) {
+    JObjectArrayLocalRef args(argsArray.getElement<jobjectArray>(i));
+    JValue result = cppJsLambda->call(this, jsLambdaValue, args, awaitJsPromise);
+    results.setElement(i, result.getLocalRef());
+  }
+
+  return results;
+}
+
 void JsBridgeContext::assignJsValue(const std::string &strGlobalName, const JStringLocalRef &strCode) {
-  JSValue v = JS_Eval(m_ctx, strCode.toUtf8Chars(), strCode.utf8Length(), strGlobalName.c_str(), 0);
+  const char *code = strCode.toUtf8Chars();
+  const size_t length = strCode.utf8Length();
+
+  // "v\0<global name>\0<code>" (the global name is also the file name of the compiled code)
+  std::string cacheKey;
+  if (length <= JsCompiledCodeCache::MAX_SOURCE_LENGTH) {
+    cacheKey.reserve(strGlobalName.size() + length + 3);
+    cacheKey.append("v", 2).append(strGlobalName).append(1, '\0').append(code, length);
+  }
+
+  JSValue v = evalCachedCode(m_ctx, cacheKey, code, length, strGlobalName.c_str());
   strCode.releaseChars();  // release chars now as we don't need them anymore
 
   if (JS_IsException(v)) {
     throw m_exceptionHandler->getCurrentJsException();
   }
 
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
+  JSValueConst globalObj = m_utils->getGlobalObject();
   JS_SetPropertyStr(m_ctx, globalObj, strGlobalName.c_str(), v);
   // No JS_FreeValue(m_ctx, v) after JS_SetPropertyStr()
-  JS_FreeValue(m_ctx, globalObj);
 }
 
 void JsBridgeContext::deleteJsValue(const std::string &strGlobalName) {
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
+  JSValueConst ownerObj = m_utils->getNamedValueOwner(strGlobalName);
   JSAtom atom = JS_NewAtom(m_ctx, strGlobalName.c_str());
-  JS_DeleteProperty(m_ctx, globalObj, atom, 0);
+  JS_DeleteProperty(m_ctx, ownerObj, atom, 0);
   JS_FreeAtom(m_ctx, atom);
-  JS_FreeValue(m_ctx, globalObj);
 }
 
 void JsBridgeContext::copyJsValue(const std::string &strGlobalNameTo, const std::string &strGlobalNameFrom) {
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
-  JSValue valueFrom = JS_GetPropertyStr(m_ctx, globalObj, strGlobalNameFrom.c_str());
-  JS_SetPropertyStr(m_ctx, globalObj, strGlobalNameTo.c_str(), valueFrom);
-  JS_FreeValue(m_ctx, globalObj);
+  JSValue valueFrom = JS_GetPropertyStr(m_ctx, m_utils->getNamedValueOwner(strGlobalNameFrom), strGlobalNameFrom.c_str());
+  JS_SetPropertyStr(m_ctx, m_utils->getNamedValueOwner(strGlobalNameTo), strGlobalNameTo.c_str(), valueFrom);
 }
 
-void JsBridgeContext::newJsFunction(const std::string &strGlobalName, const JObjectArrayLocalRef &args, const JStringLocalRef &strCode) {
-  JSValue codeValue = JS_NewString(m_ctx, strCode.toUtf8Chars());
-  strCode.releaseChars();  // release chars now as we don't need them anymore
+void JsBridgeContext::processJsCommands(JsCommandQueue *commandQueue) {
+  // Run all the drained commands and report the first failure at the end
+  std::exception_ptr firstException;
+
+  for (const JsCommandQueue::Command &command : commandQueue->drain()) {
+    try {
+      switch (command.type) {
+        case JsCommandQueue::Type::CallFunction: {
+          JSValueConst ownerObj = m_utils->getNamedValueOwner(command.globalName);
+          JSValue functionValue = JS_GetPropertyStr(m_ctx, ownerObj, command.globalName.c_str());
+          JS_AUTORELEASE_VALUE(m_ctx, functionValue);
+
+          if (!JS_IsFunction(m_ctx, functionValue)) {
+            throw std::invalid_argument("The JS function " + command.globalName + " cannot be called (not a function)");
+          }
+
+          std::vector<JSValue> argValues;
+          if (!command.payload.empty()) {
+            JSValue argsValue = JS_ParseJSON(m_ctx, command.payload.c_str(), command.payload.size(), "json");
+            if (JS_IsException(argsValue)) {
+              throw m_exceptionHandler->getCurrentJsException();
+            }
+            JS_AUTORELEASE_VALUE(m_ctx, argsValue);
+
+            JSValue lengthValue = JS_GetPropertyStr(m_ctx, argsValue, "length");
+            uint32_t argCount = 0;
+            JS_ToUint32(m_ctx, &argCount, lengthValue);
+            JS_FreeValue(m_ctx, lengthValue);
+
+            argValues.reserve(argCount);
+            for (uint32_t i = 0; i < argCount; ++i) {
+              argValues.push_back(JS_GetPropertyUint32(m_ctx, argsValue, i));
+            }
+          }
+
+          JSValue ret = JS_Call(m_ctx, functionValue, JS_UNDEFINED, static_cast<int>(argValues.size()), argValues.data());
+          for (JSValue argValue : argValues) {
+            JS_FreeValue(m_ctx, argValue);
+          }
+
+          if (JS_IsException(ret)) {
+            throw m_exceptionHandler->getCurrentJsException();
+          }
+          JS_FreeValue(m_ctx, ret);
+          break;
+        }
+
+        case JsCommandQueue::Type::AssignValue: {
+          JSValue v = JS_Eval(m_ctx, command.payload.c_str(), command.payload.size(), command.globalName.c_str(), 0);
+          if (JS_IsException(v)) {
+            throw m_exceptionHandler->getCurrentJsException();
+          }
+
+          JS_SetPropertyStr(m_ctx, m_utils->getNamedValueOwner(command.globalName), command.globalName.c_str(), v);
+          // No JS_FreeValue(m_ctx, v) after JS_SetPropertyStr()
+          break;
+        }
+
+        case JsCommandQueue::Type::DeleteValue:
+          deleteJsValue(command.globalName);
+          break;
+      }
+    } catch (const std::exception &) {
+      if (!firstException) {
+        firstException = std::current_exception();
+      }
+    }
+  }
 
-  jsize argCount = args.getLength();
-  JSValue functionArgValues[argCount + 1];
+  if (firstException) {
+    std::rethrow_exception(firstException);
+  }
+}
 
+void JsBridgeContext::newJsFunction(const std::string &strGlobalName, const JObjectArrayLocalRef &args, const JStringLocalRef &strCode) {
+  // Same source text as created by the Function constructor, i.e.: new Function(arg1, arg2, ..., jsCode)
+  std::string source = "(function anonymous(";
+  jsize argCount = args.getLength();
   for (jsize i = 0; i < argCount; ++i) {
     JStringLocalRef argString(args.getElement<jstring>(i));
-    functionArgValues[i] = JS_NewString(m_ctx, argString.toUtf8Chars());
+    if (i > 0) {
+      source += ',';
+    }
+    source.append(argString.toUtf8Chars(), argString.utf8Length());
   }
+  source += "\n) {\n";
+  source.append(strCode.toUtf8Chars(), strCode.utf8Length());
+  source += "\n})";
+  strCode.releaseChars();  // release chars now as we don't need them anymore
 
-  functionArgValues[argCount] = codeValue;
-
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
-  JSValue functionObj = JS_GetPropertyStr(m_ctx, globalObj, "Function");
-  assert(JS_IsConstructor(m_ctx, functionObj));
-  JSValue functionValue = JS_CallConstructor(m_ctx, functionObj, argCount + 1, functionArgValues);
-  JS_FreeValue(m_ctx, functionObj);
-
-  for (jsize i = 0; i <= argCount; ++i) {
-    JS_FreeValue(m_ctx, functionArgValues[i]);
-  }
+  // "f\0<source>"
+  const std::string cacheKey = std::string("f", 2) + source;
+  JSValue functionValue = evalCachedCode(m_ctx, cacheKey, source.c_str(), source.size(), "<input>");
 
   if (JS_IsException(functionValue)) {
     throw m_exceptionHandler->getCurrentJsException();
   }
 
+  JSValueConst globalObj = m_utils->getGlobalObject();
   JS_SetPropertyStr(m_ctx, globalObj, strGlobalName.c_str(), functionValue);
   // No JS_FreeValue(m_ctx, functionValue) after JS_SetPropertyStr
-  JS_FreeValue(m_ctx, globalObj);
+}
+
+void JsBridgeContext::copyJsValueHandle(const std::string &strGlobalNameTo, jlong handle) {
+  JSValue value = m_jsValueTable->get(handle);
+
+  JSValueConst globalObj = m_utils->getGlobalObject();
+  JS_SetPropertyStr(m_ctx, globalObj, strGlobalNameTo.c_str(), value);
+  // No JS_FreeValue(m_ctx, value) after JS_SetPropertyStr
+}
+
+void JsBridgeContext::releaseJsValueHandle(jlong handle) {
+  m_jsValueTable->remove(handle);
+}
+
+JSValue JsBridgeContext::getJsValue(jlong handle, const std::string &strGlobalName) const {
+  if (handle != 0) {
+    return m_jsValueTable->get(handle);
+  }
+
+  return JS_GetPropertyStr(m_ctx, m_utils->getNamedValueOwner(strGlobalName), strGlobalName.c_str());
+}
+
+JValue JsBridgeContext::getJsValueProperty(jlong handle, const std::string &strGlobalName, const JStringLocalRef &strKey, int index,
+                                          const JniLocalRef<jsBridgeParameter> &returnParameter) const {
+  auto returnType = m_javaTypeProvider.getType(returnParameter, true /*boxed*/);
+
+  JSValue objectValue = getJsValue(handle, strGlobalName);
+  JS_AUTORELEASE_VALUE(m_ctx, objectValue);
+
+  if (!JS_IsObject(objectValue)) {
+    throw std::invalid_argument("Cannot get a property of a JS value which is not an object");
+  }
+
+  JSValue propertyValue;
+  if (strKey.isNull()) {
+    propertyValue = JS_GetPropertyUint32(m_ctx, objectValue, static_cast<uint32_t>(index));
+  } else {
+    JSAtom atom = JS_NewAtomLen(m_ctx, strKey.toUtf8Chars(), strKey.utf8Length());
+    propertyValue = JS_GetProperty(m_ctx, objectValue, atom);
+    JS_FreeAtom(m_ctx, atom);
+  }
+
+  if (JS_IsException(propertyValue)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+  JS_AUTORELEASE_VALUE(m_ctx, propertyValue);
+
+  return returnType->toJava(propertyValue);
+}
+
+void JsBridgeContext::setJsValueProperty(jlong handle, const std::string &strGlobalName, const JStringLocalRef &strKey, int index,
+                                         const JniLocalRef<jobject> &value, const JniLocalRef<jsBridgeParameter> &parameter) const {
+  auto type = m_javaTypeProvider.getType(parameter, true /*boxed*/);
+
+  JSValue objectValue = getJsValue(handle, strGlobalName);
+  JS_AUTORELEASE_VALUE(m_ctx, objectValue);
+
+  if (!JS_IsObject(objectValue)) {
+    throw std::invalid_argument("Cannot set a property of a JS value which is not an object");
+  }
+
+  JSValue propertyValue = type->fromJava(JValue(value));
+
+  int ret;
+  if (strKey.isNull()) {
+    ret = JS_SetPropertyUint32(m_ctx, objectValue, static_cast<uint32_t>(index), propertyValue);
+  } else {
+    JSAtom atom = JS_NewAtomLen(m_ctx, strKey.toUtf8Chars(), strKey.utf8Length());
+    ret = JS_SetProperty(m_ctx, objectValue, atom, propertyValue);
+    JS_FreeAtom(m_ctx, atom);
+  }
+  // No JS_FreeValue(m_ctx, propertyValue) after JS_SetProperty()
+
+  if (ret < 0) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+}
+
+JValue JsBridgeContext::callJsValueMethod(jlong handle, const std::string &strGlobalName, const JStringLocalRef &strMethodName,
+                                          const JObjectArrayLocalRef &args, const JniLocalRef<jsBridgeParameter> &returnParameter) const {
+  auto returnType = m_javaTypeProvider.getType(returnParameter, true /*boxed*/);
+  const auto &argType = m_javaTypeProvider.getObjectType();
+
+  JSValue objectValue = getJsValue(handle, strGlobalName);
+  JS_AUTORELEASE_VALUE(m_ctx, objectValue);
+
+  if (!JS_IsObject(objectValue)) {
+    throw std::invalid_argument("Cannot call a method of a JS value which is not an object");
+  }
+
+  JSAtom atom = JS_NewAtomLen(m_ctx, strMethodName.toUtf8Chars(), strMethodName.utf8Length());
+  JSValue methodValue = JS_GetProperty(m_ctx, objectValue, atom);
+  JS_FreeAtom(m_ctx, atom);
+
+  if (JS_IsException(methodValue)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+  JS_AUTORELEASE_VALUE(m_ctx, methodValue);
+
+  const jsize argCount = args.isNull() ? 0 : args.getLength();
+  std::vector<JSValue> argValues;
+  argValues.reserve(static_cast<size_t>(argCount));
+  try {
+    for (jsize i = 0; i < argCount; ++i) {
+      argValues.push_back(argType->fromJava(JValue(args.getElement<jobject>(i))));
+    }
+  } catch (const std::exception &) {
+    for (JSValue argValue : argValues) {
+      JS_FreeValue(m_ctx, argValue);
+    }
+    throw;
+  }
+
+  JSValue returnValue = JS_Call(m_ctx, methodValue, objectValue, argCount, argValues.data());
+  for (JSValue argValue : argValues) {
+    JS_FreeValue(m_ctx, argValue);
+  }
+
+  if (JS_IsException(returnValue)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+  JS_AUTORELEASE_VALUE(m_ctx, returnValue);
+
+  return returnType->toJava(returnValue);
+}
+
+const char *JsBridgeContext::getJsValueType(jlong handle, const std::string &strGlobalName) const {
+  JSValue value = getJsValue(handle, strGlobalName);
+  JS_AUTORELEASE_VALUE(m_ctx, value);
+
+  if (JS_IsUndefined(value) || JS_IsUninitialized(value)) {
+    return "undefined";
+  }
+  if (JS_IsBool(value)) {
+    return "boolean";
+  }
+  if (JS_IsNumber(value)) {
+    return "number";
+  }
+  if (JS_IsBigInt(m_ctx, value)) {
+    return "bigint";
+  }
+  if (JS_IsString(value)) {
+    return "string";
+  }
+  if (JS_IsSymbol(value)) {
+    return "symbol";
+  }
+  if (JS_IsFunction(m_ctx, value)) {
+    return "function";
+  }
+  return "object";  // including null
 }
 
 void JsBridgeContext::convertJavaValueToJs(const std::string &strGlobalName, const JniLocalRef<jobject> &javaValue, const JniLocalRef<jsBridgeParameter> &parameter) {
 
-  auto type = m_javaTypeProvider.makeUniqueType(parameter, true /*boxed*/);
+  auto type = m_javaTypeProvider.getType(parameter, true /*boxed*/);
 
   JSValue value = type->fromJava(JValue(javaValue));
   if (JS_IsException(value)) {
     throw m_exceptionHandler->getCurrentJsException();
   }
 
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
+  JSValueConst globalObj = m_utils->getGlobalObject();
+  JS_SetPropertyStr(m_ctx, globalObj, strGlobalName.c_str(), value);
+  // No JS_FreeValue(m_ctx, value) after JS_SetPropertyStr
+}
+
+void JsBridgeContext::parseJsonBuffer(const std::string &strGlobalName, const JniLocalRef<jobject> &byteBuffer, jint offset, jint length) {
+  auto data = static_cast<const char *>(m_jniContext->getDirectBufferAddress(byteBuffer));
+  jlong capacity = m_jniContext->getDirectBufferCapacity(byteBuffer);
+  if (data == nullptr || offset < 0 || length < 0 || offset + static_cast<jlong>(length) > capacity) {
+    throw std::invalid_argument("Invalid JSON buffer");
+  }
+
+  JSValue value;
+  if (offset + static_cast<jlong>(length) < capacity && data[offset + length] == '\0') {
+    // Parse directly from the native buffer (JS_ParseJSON needs a zero-terminated input)
+    value = JS_ParseJSON(m_ctx, data + offset, static_cast<size_t>(length), "json");
+  } else {
+    std::string json(data + offset, static_cast<size_t>(length));
+    value = JS_ParseJSON(m_ctx, json.c_str(), json.size(), "json");
+  }
+
+  if (JS_IsException(value)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  JSValueConst globalObj = m_utils->getGlobalObject();
+  JS_SetPropertyStr(m_ctx, globalObj, strGlobalName.c_str(), value);
+  // No JS_FreeValue(m_ctx, value) after JS_SetPropertyStr
+}
+
+void JsBridgeContext::assignDirectBuffer(const std::string &strGlobalName, const JniLocalRef<jobject> &byteBuffer, jint offset, jint length,
+                                         bool asUtf8String) {
+  auto data = static_cast<uint8_t *>(m_jniContext->getDirectBufferAddress(byteBuffer));
+  jlong capacity = m_jniContext->getDirectBufferCapacity(byteBuffer);
+  if (data == nullptr || offset < 0 || length < 0 || offset + static_cast<jlong>(length) > capacity) {
+    throw std::invalid_argument("Invalid buffer");
+  }
+
+  JSValue value;
+  if (asUtf8String) {
+    value = JS_NewStringLen(m_ctx, reinterpret_cast<const char *>(data + offset), static_cast<size_t>(length));
+  } else {
+    // The ArrayBuffer holds a global ref to the Java ByteBuffer which owns the memory
+    auto bufferRef = new JniGlobalRef<jobject>(byteBuffer);
+    value = JS_NewArrayBuffer(m_ctx, data + offset, static_cast<size_t>(length), [](JSRuntime *, void *opaque, void *) {
+      delete static_cast<JniGlobalRef<jobject> *>(opaque);
+    }, bufferRef, false /*is_shared*/);
+  }
+
+  if (JS_IsException(value)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  JSValueConst globalObj = m_utils->getGlobalObject();
+  JS_SetPropertyStr(m_ctx, globalObj, strGlobalName.c_str(), value);
+  // No JS_FreeValue(m_ctx, value) after JS_SetPropertyStr
+}
+
+jlong JsBridgeContext::writeJsMessage(const std::string &strGlobalName) const {
+  JSValueConst globalObj = m_utils->getGlobalObject();
+  JSValue value = JS_GetPropertyStr(m_ctx, globalObj, strGlobalName.c_str());
+
+  JsMessage *message = JsMessage::write(m_ctx, value);
+  JS_FreeValue(m_ctx, value);
+
+  if (message == nullptr) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  return reinterpret_cast<jlong>(message);
+}
+
+void JsBridgeContext::readJsMessage(const std::string &strGlobalName, jlong messageHandle) const {
+  if (messageHandle == 0) {
+    throw std::invalid_argument("Invalid JS message");
+  }
+
+  auto message = reinterpret_cast<const JsMessage *>(messageHandle);
+  JSValue value = message->read(m_ctx);
+
+  if (JS_IsException(value)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  JSValueConst globalObj = m_utils->getGlobalObject();
+  JS_SetPropertyStr(m_ctx, globalObj, strGlobalName.c_str(), value);
+  // No JS_FreeValue(m_ctx, value) after JS_SetPropertyStr
+}
+
+// static
+void JsBridgeContext::deleteJsMessage(jlong messageHandle) {
+  delete reinterpret_cast<JsMessage *>(messageHandle);
+}
+
+JniLocalRef<jobject> JsBridgeContext::newJsSharedBuffer(const std::string &strGlobalName, jint size) const {
+  if (size < 0) {
+    throw std::invalid_argument("Invalid shared buffer size: " + std::to_string(size));
+  }
+
+  uint8_t *data = JsSharedBuffer::alloc(static_cast<size_t>(size));
+  if (data == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  // The SharedArrayBuffer takes its own reference, the one of alloc() is given to Java
+  JSValue sharedArrayBuffer = JS_NewArrayBuffer(m_ctx, data, static_cast<size_t>(size), nullptr, nullptr, true /*is_shared*/);
+  if (JS_IsException(sharedArrayBuffer)) {
+    JsSharedBuffer::release(data);
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  JSValue notifyFunc = JS_NewCFunction(m_ctx, sharedBufferNotify, "notify", 0);
+  JS_DefinePropertyValueStr(m_ctx, sharedArrayBuffer, "notify", notifyFunc, JS_PROP_CONFIGURABLE);
+
+  JSValueConst globalObj = m_utils->getGlobalObject();
+  JS_SetPropertyStr(m_ctx, globalObj, strGlobalName.c_str(), sharedArrayBuffer);
+  // No JS_FreeValue(m_ctx, sharedArrayBuffer) after JS_SetPropertyStr
+
+  return m_jniContext->newDirectByteBuffer(data, size);
+}
+
+void JsBridgeContext::notifyJsSharedBuffer(const std::string &strGlobalName) const {
+  JSValueConst globalObj = m_utils->getGlobalObject();
+  JSValue sharedArrayBuffer = JS_GetPropertyStr(m_ctx, globalObj, strGlobalName.c_str());
+  JSValue onNotify = JS_GetPropertyStr(m_ctx, sharedArrayBuffer, "onnotify");
+
+  JSValue ret = JS_UNDEFINED;
+  if (JS_IsFunction(m_ctx, onNotify)) {
+    ret = JS_Call(m_ctx, onNotify, sharedArrayBuffer, 0, nullptr);
+  }
+  JS_FreeValue(m_ctx, onNotify);
+  JS_FreeValue(m_ctx, sharedArrayBuffer);
+
+  if (JS_IsException(ret)) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+  JS_FreeValue(m_ctx, ret);
+}
+
+// static
+void JsBridgeContext::releaseJsSharedBuffer(void *data) {
+  JsSharedBuffer::release(static_cast<uint8_t *>(data));
+}
+
+// static
+int JsBridgeContext::waitForJsSharedBufferNotify(void *data, int notifyCount, long long timeoutMs) {
+  return static_cast<int>(JsSharedBuffer::waitForNotify(static_cast<uint8_t *>(data), static_cast<uint32_t>(notifyCount), timeoutMs));
+}
+
+JArrayLocalRef<jbyte> JsBridgeContext::writeJsSnapshot(const std::string &strGlobalName) const {
+  JSValueConst globalObj = m_utils->getGlobalObject();
+  JSValue value = JS_GetPropertyStr(m_ctx, globalObj, strGlobalName.c_str());
+  JS_AUTORELEASE_VALUE(m_ctx, value);
+
+  // Unlike JsMessage, neither bytecode nor SharedArrayBuffers are allowed: the snapshot must be
+  // independent from the current process
+  size_t size = 0;
+  uint8_t *buf = JS_WriteObject(m_ctx, &size, value, JS_WRITE_OBJ_REFERENCE);
+  if (buf == nullptr) {
+    throw m_exceptionHandler->getCurrentJsException();
+  }
+
+  JArrayLocalRef<jbyte> snapshot(m_jniContext, static_cast<jsize>(size));
+  snapshot.setRegion(0, static_cast<jsize>(size), reinterpret_cast<const jbyte *>(buf));
+  js_free(m_ctx, buf);
+
+  return snapshot;
+}
+
+void JsBridgeContext::readJsSnapshot(const std::string &strGlobalName, const JArrayLocalRef<jbyte> &snapshot) const {
+  const auto *buf = reinterpret_cast<const uint8_t *>(snapshot.getElements());
+  JSValue value = JS_ReadObject(m_ctx, buf, snapshot.getLength(), JS_READ_OBJ_REFERENCE);
+
+  if (JS_IsException(value)) {
+    // Invalid snapshot or written by an incompatible QuickJS version
+    JsException jsException = m_exceptionHandler->getCurrentJsException();
+    throw std::invalid_argument(std::string("Cannot read JS snapshot: ") + jsException.what());
+  }
+
+  JSValueConst globalObj = m_utils->getGlobalObject();
   JS_SetPropertyStr(m_ctx, globalObj, strGlobalName.c_str(), value);
   // No JS_FreeValue(m_ctx, value) after JS_SetPropertyStr
-  JS_FreeValue(m_ctx, globalObj);
 }
 
-void JsBridgeContext::processPromiseQueue() {
+bool JsBridgeContext::processPromiseQueue(int maxJobs, long long timeBudgetMs) {
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeBudgetMs);
+
   JSContext *ctx1;
   int err;
 
   // Execute the pending jobs
-  while (true) {
+  for (int jobCount = 0; JS_IsJobPending(m_runtime); ++jobCount) {
+    if ((maxJobs > 0 && jobCount >= maxJobs) || (timeBudgetMs > 0 && jobCount > 0 && Clock::now() >= deadline) ||
+        (jobCount > 0 && m_executionDeadline->consumeYieldRequest())) {
+      return true;
+    }
+
     err = JS_ExecutePendingJob(m_runtime, &ctx1);
-    if (err <= 0) {
-      if (err < 0) {
-        throw m_exceptionHandler->getCurrentJsException();
-      }
-      break;
+    if (err < 0) {
+      // (the job may belong to another context of a shared runtime)
+      throw getInstance(ctx1)->getExceptionHandler()->getCurrentJsException();
     }
   }
+
+  return false;
+}
+
+bool JsBridgeContext::isJobPending() const {
+  return JS_IsJobPending(m_runtime);
 }
 
 // static
 JsBridgeContext *JsBridgeContext::getInstance(JSContext *ctx) {
-  //return QuickJsUtils::getCppPtrStatic<JsBridgeContext>(ctx, JSBRIDGE_CPP_CLASS_PROP_NAME);
-  JSValue globalObj = JS_GetGlobalObject(ctx);
-  JSValue cppWrapperObj = JS_GetPropertyStr(ctx, globalObj, JSBRIDGE_CPP_CLASS_PROP_NAME);
-  JS_FreeValue(ctx, globalObj);
-
-  auto that = QuickJsUtils::getCppPtr<JsBridgeContext>(cppWrapperObj);
-  JS_FreeValue(ctx, cppWrapperObj);
-  return that;
+  return static_cast<JsBridgeContext *>(JS_GetContextOpaque(ctx));
 }
 
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsCommandQueue.h"
+
+#include <utility>
+
+JsCommandQueue::JsCommandQueue() {
+  // Sentinel node
+  Node *node = new Node();
+  m_head.store(node, std::memory_order_relaxed);
+  m_tail = node;
+}
+
+JsCommandQueue::~JsCommandQueue() {
+  Node *node = m_tail;
+  while (node != nullptr) {
+    Node *next = node->next.load(std::memory_order_relaxed);
+    delete node;
+    node = next;
+  }
+}
+
+bool JsCommandQueue::push(Command &&command) {
+  Node *node = new Node();
+  node->command = std::move(command);
+
+  Node *prev = m_head.exchange(node, std::memory_order_acq_rel);
+  prev->next.store(node, std::memory_order_release);
+
+  return !m_isDrainScheduled.exchange(true, std::memory_order_acq_rel);
+}
+
+std::vector<JsCommandQueue::Command> JsCommandQueue::drain() {
+  // Reset the flag before consuming: a command pushed from now on either gets drained here or
+  // schedules a new drain (acquire: the nodes linked before the flag was set are visible)
+  m_isDrainScheduled.exchange(false, std::memory_order_acq_rel);
+
+  std::vector<Command> commands;
+
+  Node *tail = m_tail;
+  Node *next = tail->next.load(std::memory_order_acquire);
+  while (next != nullptr) {
+    commands.push_back(std::move(next->command));
+    delete tail;
+    tail = next;
+    next = tail->next.load(std::memory_order_acquire);
+  }
+  m_tail = tail;
+
+  // Note: a producer which has exchanged m_head but not yet linked its node is picked up by the
+  // drain that it has scheduled
+  return commands;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSCOMMANDQUEUE_H
+#define _JSBRIDGE_JSCOMMANDQUEUE_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Queue of pre-encoded fire-and-forget JS commands (see JsBridge.postJsFunctionCall())
+//
+// Any thread can push commands without locking or suspending (lock-free multiple producers,
+// single consumer queue). The JS thread drains all the pending commands at once so that a burst
+// of commands posted from many threads only needs a single dispatch to the JS thread and a
+// single JNI call.
+//
+// The queue is not bound to any JS context: it is owned by the Java side and given to
+// JsBridgeContext::processJsCommands() when draining it.
+class JsCommandQueue {
+
+public:
+  // Same values as JsBridge.JsCommandType
+  enum class Type {
+    CallFunction = 0,  // call the function globalName with the JSON array payload as arguments
+    AssignValue = 1,  // assign the evaluated JS code payload to globalName
+    DeleteValue = 2,  // delete globalName
+  };
+
+  struct Command {
+    Type type;
+    std::string globalName;
+    std::string payload;
+  };
+
+  JsCommandQueue();
+  JsCommandQueue(const JsCommandQueue &) = delete;
+  JsCommandQueue &operator=(const JsCommandQueue &) = delete;
+  ~JsCommandQueue();
+
+  // Push a command (from any thread) and return true if the caller needs to schedule a drain
+  // in the JS thread, i.e. if no drain has been scheduled since the last one
+  bool push(Command &&command);
+
+  // Return and remove all the pending commands (oldest first)
+  // Note: must only be called from the (single) consumer thread
+  std::vector<Command> drain();
+
+private:
+  struct Node {
+    std::atomic<Node *> next { nullptr };
+    Command command;
+  };
+
+  // Intrusive MPSC queue: producers exchange m_head, the consumer follows the next links from
+  // m_tail (which always points at the last consumed node)
+  std::atomic<Node *> m_head;
+  Node *m_tail;
+  std::atomic<bool> m_isDrainScheduled { false };
+};
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsCompiledCodeCache.h"
+
+#include <utility>
+
+// static
+JsCompiledCodeCache &JsCompiledCodeCache::getInstance() {
+  static JsCompiledCodeCache instance;
+  return instance;
+}
+
+std::shared_ptr<const std::string> JsCompiledCodeCache::find(const std::string &key) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto it = m_bytecodes.find(key);
+  return it == m_bytecodes.end() ? nullptr : it->second;
+}
+
+void JsCompiledCodeCache::add(const std::string &key, std::string bytecode, bool evictable) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto emplaced = m_bytecodes.emplace(key, std::make_shared<const std::string>(std::move(bytecode)));
+  if (!emplaced.second) {
+    // Already compiled by another thread
+    return;
+  }
+  if (!evictable) {
+    return;
+  }
+  m_keys.push_back(&emplaced.first->first);
+
+  if (m_keys.size() > MAX_ENTRY_COUNT) {
+    m_bytecodes.erase(*m_keys.front());
+    m_keys.pop_front();
+  }
+}
+
+void JsCompiledCodeCache::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_keys.clear();
+  m_bytecodes.clear();
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSCOMPILEDCODECACHE_H
+#define _JSBRIDGE_JSCOMPILEDCODECACHE_H
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Process-wide cache of the bytecode compiled from small JS snippets which are often defined
+// again with the same source code (see JsBridgeContext::assignJsValue() and newJsFunction()), so
+// that they are only parsed once, also across JsBridge instances.
+//
+// Notes:
+// - the bytecode is serialized by the JS engine (and loaded again into each context)
+// - the key is the source code (and anything else which changes the compilation result)
+// - the built-in extension scripts are cached by asset path and never evicted (they cannot change
+//   during the process lifetime, see JsBridgeContext::evaluateBuiltInAsset())
+// - thread-safe: shared by all the JS threads
+class JsCompiledCodeCache {
+
+public:
+  // Longer snippets are compiled as usual
+  static const size_t MAX_SOURCE_LENGTH = 4 * 1024;
+  // The oldest entry is removed when full
+  static const size_t MAX_ENTRY_COUNT = 256;
+
+  static JsCompiledCodeCache &getInstance();
+
+  JsCompiledCodeCache(const JsCompiledCodeCache &) = delete;
+  JsCompiledCodeCache &operator=(const JsCompiledCodeCache &) = delete;
+
+  // Return the cached bytecode for the given key or nullptr if there is none
+  std::shared_ptr<const std::string> find(const std::string &key) const;
+  // Non-evictable entries are not counted in MAX_ENTRY_COUNT (but removed by clear())
+  void add(const std::string &key, std::string bytecode, bool evictable = true);
+
+  // Remove all the entries (e.g. on memory pressure)
+  void clear();
+
+private:
+  JsCompiledCodeCache() = default;
+
+  mutable std::mutex m_mutex;
+  std::unordered_map<std::string, std::shared_ptr<const std::string>> m_bytecodes;
+  std::deque<const std::string *> m_keys;  // (insertion order) pointers to the keys of m_bytecodes
+};
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsConsole.h"
+
+#include "JniCache.h"
+#include "JsBridgeContext.h"
+#include "jni-helpers/JStringLocalRef.h"
+#include <android/log.h>
+
+// static
+const char *const JsConsole::METHOD_NAMES[Method_Count] = {
+  "log", "debug", "trace", "info", "warn", "error", "exception", "assert"
+};
+
+JsConsole::JsConsole(const JsBridgeContext *jsBridgeContext, Mode mode, int minPriority, size_t ringBufferSize)
+ : m_jsBridgeContext(jsBridgeContext)
+ , m_mode(mode)
+ , m_ringBufferSize(ringBufferSize) {
+
+  // JSON mode: debug() and trace() use the DEBUG priority
+  int debugPriority = mode == Mode::AsJson ? ANDROID_LOG_DEBUG : ANDROID_LOG_VERBOSE;
+  const int priorities[Method_Count] = {
+    ANDROID_LOG_DEBUG,  // log
+    debugPriority,  // debug
+    debugPriority,  // trace
+    ANDROID_LOG_INFO,  // info
+    ANDROID_LOG_WARN,  // warn
+    ANDROID_LOG_ERROR,  // error
+    ANDROID_LOG_ERROR,  // exception
+    ANDROID_LOG_FATAL,  // assert (Log.ASSERT)
+  };
+
+  for (int i = 0; i < Method_Count; ++i) {
+    m_enabledPriorities[i] = (mode != Mode::Empty && priorities[i] >= minPriority) ? priorities[i] : 0;
+  }
+}
+
+void JsConsole::append(int priority, std::string &&message) {
+  if (m_ringBufferSize == 0) {
+    JStringLocalRef strMessage(m_jsBridgeContext->getJniContext(), message.c_str());
+    m_jsBridgeContext->getJniCache()->getJsBridgeInterface().appendConsoleMessage(priority, strMessage);
+    return;
+  }
+
+  if (m_messages.size() >= m_ringBufferSize) {
+    // Drop the oldest message
+    m_messages.pop_front();
+  }
+  m_messages.emplace_back(priority, std::move(message));
+}
+
+std::vector<std::pair<int, std::string>> JsConsole::drain() {
+  std::vector<std::pair<int, std::string>> messages(std::make_move_iterator(m_messages.begin()),
+                                                    std::make_move_iterator(m_messages.end()));
+  m_messages.clear();
+  return messages;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSCONSOLE_H
+#define _JSBRIDGE_JSCONSOLE_H
+
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+class JsBridgeContext;
+
+// Native JS console (see JsBridgeConfig.ConsoleConfig)
+//
+// The console methods check the priority threshold before converting any argument, so that the
+// dropped messages have (almost) no cost. The enabled messages are formatted natively and either
+// given to JsBridge.appendConsoleMessage() or stored in a ring buffer which is drained by the
+// Java side on demand (without any upcall per message).
+//
+// Must only be used from the JS thread.
+class JsConsole {
+
+public:
+  // Same order as JsBridgeConfig.ConsoleConfig.Mode
+  enum class Mode {
+    AsString = 0,
+    AsJson = 1,
+    Empty = 2,
+  };
+
+  enum Method {
+    Method_Log, Method_Debug, Method_Trace, Method_Info, Method_Warn, Method_Error, Method_Exception, Method_Assert,
+    Method_Count
+  };
+
+  static const char *const METHOD_NAMES[Method_Count];
+
+  // ringBufferSize: maximum number of buffered messages (0: no ring buffer)
+  JsConsole(const JsBridgeContext *, Mode, int minPriority, size_t ringBufferSize);
+  JsConsole(const JsConsole &) = delete;
+  JsConsole &operator=(const JsConsole &) = delete;
+
+  Mode getMode() const { return m_mode; }
+
+  // Return the Android log priority of the given method or 0 if its messages are dropped
+  int getEnabledPriority(Method method) const { return m_enabledPriorities[method]; }
+
+  void append(int priority, std::string &&message);
+
+  // Return and remove the buffered messages (oldest first)
+  std::vector<std::pair<int, std::string>> drain();
+
+private:
+  const JsBridgeContext *m_jsBridgeContext;
+  const Mode m_mode;
+  int m_enabledPriorities[Method_Count];
+  const size_t m_ringBufferSize;
+  std::deque<std::pair<int, std::string>> m_messages;
+};
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsHeapSnapshot.h"
+
+#include "JsonUtils.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+  // See "meta" in toJson()
+  const char *NODE_TYPES[] = {
+    "hidden", "array", "string", "object", "code", "closure", "regexp", "number", "native",
+    "synthetic", "concatenated string", "sliced string", "symbol", "bigint", "object shape"
+  };
+  const char *EDGE_TYPES[] = {
+    "context", "element", "property", "internal", "hidden", "shortcut", "weak"
+  };
+
+  const int NODE_FIELD_COUNT = 7;
+
+  template <size_t N>
+  int getTypeIndex(const char *(&types)[N], const char *type, int defaultIndex) {
+    for (size_t i = 0; i < N; ++i) {
+      if (strcmp(types[i], type) == 0) {
+        return static_cast<int>(i);
+      }
+    }
+    return defaultIndex;
+  }
+
+  template <size_t N>
+  void appendTypes(std::string &json, const char *(&types)[N]) {
+    json += '[';
+    for (size_t i = 0; i < N; ++i) {
+      if (i > 0) json += ',';
+      JsonUtils::appendString(json, types[i], strlen(types[i]));
+    }
+    json += ']';
+  }
+
+  bool isIndexedEdgeType(int edgeType) {
+    return strcmp(EDGE_TYPES[edgeType], "element") == 0 || strcmp(EDGE_TYPES[edgeType], "hidden") == 0;
+  }
+}
+
+JsHeapSnapshot::JsHeapSnapshot() {
+  // Root
+  addNode(nullptr, "synthetic", "", 0);
+}
+
+void JsHeapSnapshot::addNode(const void *ptr, const char *type, const char *name, size_t selfSize) {
+  m_nodeIndexes.emplace(ptr, static_cast<int>(m_nodes.size()));
+  m_nodes.push_back(Node { getTypeIndex(NODE_TYPES, type, 0), getStringIndex(name), selfSize });
+}
+
+void JsHeapSnapshot::addEdge(const void *from, const void *to, const char *type, const char *name, uint32_t index) {
+  const int edgeType = getTypeIndex(EDGE_TYPES, type, 4 /*hidden*/);
+  const int nameOrIndex = isIndexedEdgeType(edgeType) ? static_cast<int>(index) : getStringIndex(name != nullptr ? name : "");
+  m_edges.push_back(Edge { from, to, edgeType, nameOrIndex });
+}
+
+std::string JsHeapSnapshot::toJson() const {
+  // Resolve the edges and group them by node (as expected by the format)
+  struct ResolvedEdge {
+    int fromIndex;
+    int toIndex;
+    const Edge *edge;
+  };
+
+  std::vector<ResolvedEdge> edges;
+  edges.reserve(m_edges.size());
+  for (const Edge &edge : m_edges) {
+    auto fromIt = m_nodeIndexes.find(edge.from);
+    auto toIt = m_nodeIndexes.find(edge.to);
+    if (fromIt != m_nodeIndexes.end() && toIt != m_nodeIndexes.end()) {
+      edges.push_back(ResolvedEdge { fromIt->second, toIt->second, &edge });
+    }
+  }
+  std::stable_sort(edges.begin(), edges.end(), [](const ResolvedEdge &a, const ResolvedEdge &b) {
+    return a.fromIndex < b.fromIndex;
+  });
+
+  std::vector<int> edgeCounts(m_nodes.size(), 0);
+  for (const ResolvedEdge &edge : edges) {
+    ++edgeCounts[edge.fromIndex];
+  }
+
+  std::string json;
+  json.reserve(m_nodes.size() * 32 + edges.size() * 16);
+
+  json += "{\"snapshot\":{\"meta\":{";
+  json += "\"node_fields\":[\"type\",\"name\",\"id\",\"self_size\",\"edge_count\",\"trace_node_id\",\"detachedness\"],";
+  json += "\"node_types\":[";
+  appendTypes(json, NODE_TYPES);
+  json += ",\"string\",\"number\",\"number\",\"number\",\"number\",\"number\"],";
+  json += "\"edge_fields\":[\"type\",\"name_or_index\",\"to_node\"],";
+  json += "\"edge_types\":[";
+  appendTypes(json, EDGE_TYPES);
+  json += ",\"string_or_number\",\"node\"],";
+  json += "\"trace_function_info_fields\":[],\"trace_node_fields\":[],\"sample_fields\":[],\"location_fields\":[]},";
+  json += "\"node_count\":" + std::to_string(m_nodes.size());
+  json += ",\"edge_count\":" + std::to_string(edges.size());
+  json += ",\"trace_function_count\":0},";
+
+  json += "\"nodes\":[";
+  for (size_t i = 0; i < m_nodes.size(); ++i) {
+    const Node &node = m_nodes[i];
+    if (i > 0) json += ',';
+    json += std::to_string(node.type) + ',' + std::to_string(node.name) + ',' + std::to_string(i * 2 + 1) + ','
+        + std::to_string(node.selfSize) + ',' + std::to_string(edgeCounts[i]) + ",0,0";
+  }
+
+  json += "],\"edges\":[";
+  for (size_t i = 0; i < edges.size(); ++i) {
+    const ResolvedEdge &edge = edges[i];
+    if (i > 0) json += ',';
+    json += std::to_string(edge.edge->type) + ',' + std::to_string(edge.edge->nameOrIndex) + ','
+        + std::to_string(edge.toIndex * NODE_FIELD_COUNT);
+  }
+
+  json += "],\"trace_function_infos\":[],\"trace_tree\":[],\"samples\":[],\"locations\":[],\"strings\":[";
+  for (size_t i = 0; i < m_strings.size(); ++i) {
+    if (i > 0) json += ',';
+    JsonUtils::appendString(json, m_strings[i]);
+  }
+  json += "]}";
+
+  return json;
+}
+
+int JsHeapSnapshot::getStringIndex(const char *str) {
+  auto it = m_stringIndexes.find(str);
+  if (it != m_stringIndexes.end()) {
+    return it->second;
+  }
+
+  const int index = static_cast<int>(m_strings.size());
+  m_strings.emplace_back(str);
+  m_stringIndexes.emplace(m_strings.back(), index);
+  return index;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSHEAPSNAPSHOT_H
+#define _JSBRIDGE_JSHEAPSNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Heap snapshot of the JS engine, exported in the .heapsnapshot (JSON) format of Chrome DevTools
+// (Memory tab) e.g. to find out what keeps JS objects alive.
+//
+// The nodes are the JS engine objects (identified by their address) and synthetic nodes for the
+// references held by the bridge (e.g. the JsValue table). The node and edge types are the ones of
+// Chrome ("object", "closure", "property", "element"...), an unknown type is mapped to "hidden".
+//
+// Notes:
+// - node 0 is the root of the snapshot
+// - the edges to unknown nodes (e.g. strings, which are not reported) are ignored
+class JsHeapSnapshot {
+
+public:
+  JsHeapSnapshot();
+  JsHeapSnapshot(const JsHeapSnapshot &) = delete;
+  JsHeapSnapshot &operator=(const JsHeapSnapshot &) = delete;
+
+  void addNode(const void *ptr, const char *type, const char *name, size_t selfSize);
+
+  // Reference from the root node if from is null. The name is not used for "element" and
+  // "hidden" edges (which are identified by their index).
+  void addEdge(const void *from, const void *to, const char *type, const char *name, uint32_t index);
+
+  std::string toJson() const;
+
+private:
+  struct Node {
+    int type;
+    int name;
+    size_t selfSize;
+  };
+
+  struct Edge {
+    const void *from;
+    const void *to;
+    int type;
+    int nameOrIndex;
+  };
+
+  int getStringIndex(const char *str);
+
+  std::vector<Node> m_nodes;
+  std::unordered_map<const void *, int> m_nodeIndexes;
+  std::vector<Edge> m_edges;
+  std::vector<std::string> m_strings;
+  std::unordered_map<std::string, int> m_stringIndexes;
+};
+
+#endif
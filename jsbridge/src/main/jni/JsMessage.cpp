@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsMessage.h"
+
+#include "JsSharedBuffer.h"
+
+JsMessage::~JsMessage() {
+  for (uint8_t *sharedBuffer : m_sharedBuffers) {
+    JsSharedBuffer::release(sharedBuffer);
+  }
+}
+
+// static
+JsMessage *JsMessage::write(JSContext *ctx, JSValueConst value) {
+  size_t size = 0;
+  uint8_t **sharedBuffers = nullptr;
+  size_t sharedBufferCount = 0;
+
+  uint8_t *buf = JS_WriteObject2(ctx, &size, value, JS_WRITE_OBJ_REFERENCE | JS_WRITE_OBJ_SAB,
+                                 &sharedBuffers, &sharedBufferCount);
+  if (buf == nullptr) {
+    return nullptr;
+  }
+
+  // Copy the data out of the source runtime which might be deleted before the message is read
+  auto message = new JsMessage();
+  message->m_data.assign(reinterpret_cast<const char *>(buf), size);
+  js_free(ctx, buf);
+
+  // Keep the shared buffers alive until the message is deleted
+  message->m_sharedBuffers.reserve(sharedBufferCount);
+  for (size_t i = 0; i < sharedBufferCount; ++i) {
+    JsSharedBuffer::retain(sharedBuffers[i]);
+    message->m_sharedBuffers.push_back(sharedBuffers[i]);
+  }
+  js_free(ctx, sharedBuffers);
+
+  return message;
+}
+
+JSValue JsMessage::read(JSContext *ctx) const {
+  const auto *buf = reinterpret_cast<const uint8_t *>(m_data.data());
+  return JS_ReadObject(ctx, buf, m_data.size(), JS_READ_OBJ_REFERENCE | JS_READ_OBJ_SAB);
+}
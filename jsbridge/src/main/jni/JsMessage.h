@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSMESSAGE_H
+#define _JSBRIDGE_JSMESSAGE_H
+
+#include "quickjs/quickjs.h"
+#include <string>
+#include <vector>
+
+// Structured clone of a JS value graph which can be read by another JS context, potentially
+// running in another thread (see JsBridge.postMessage()).
+//
+// The value is serialized with JS_WriteObject2() (object references allowed) into a native
+// buffer which is independent from the source runtime. SharedArrayBuffers are not copied but
+// shared with the target context: their memory is allocated outside of the runtimes and
+// reference-counted (see JsSharedBuffer).
+class JsMessage {
+
+public:
+  JsMessage(const JsMessage &) = delete;
+  JsMessage &operator=(const JsMessage &) = delete;
+
+  // Release the references to the shared buffers
+  ~JsMessage();
+
+  // Serialize the given value or return nullptr (with a pending JS exception) on failure
+  static JsMessage *write(JSContext *ctx, JSValueConst value);
+
+  // Deserialize the message into the given context or return JS_EXCEPTION on failure
+  // (a message can be read several times, e.g. by several contexts)
+  JSValue read(JSContext *ctx) const;
+
+private:
+  JsMessage() = default;
+
+  std::string m_data;
+  std::vector<uint8_t *> m_sharedBuffers;
+};
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsModuleRegistry.h"
+
+#include <utility>
+
+void JsModuleRegistry::add(const std::string &moduleName, Module module) {
+  m_modules[moduleName] = std::move(module);
+}
+
+bool JsModuleRegistry::take(const std::string &moduleName, Module &module) {
+  auto it = m_modules.find(moduleName);
+  if (it == m_modules.end()) {
+    return false;
+  }
+
+  module = std::move(it->second);
+  m_modules.erase(it);
+  return true;
+}
+
+const std::string *JsModuleRegistry::findNormalizedName(const std::string &baseName, const std::string &moduleName) const {
+  auto it = m_normalizedNames.find(getNormalizedNameKey(baseName, moduleName));
+  return it == m_normalizedNames.end() ? nullptr : &it->second;
+}
+
+void JsModuleRegistry::addNormalizedName(const std::string &baseName, const std::string &moduleName, const std::string &normalizedName) {
+  m_normalizedNames[getNormalizedNameKey(baseName, moduleName)] = normalizedName;
+}
+
+// static
+std::string JsModuleRegistry::getNormalizedNameKey(const std::string &baseName, const std::string &moduleName) {
+  // Module names cannot contain any '\0'
+  std::string key;
+  key.reserve(baseName.size() + moduleName.size() + 1);
+  key.append(baseName).append(1, '\0').append(moduleName);
+  return key;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSMODULEREGISTRY_H
+#define _JSBRIDGE_JSMODULEREGISTRY_H
+
+#include <string>
+#include <unordered_map>
+
+// Native storage of the JS modules registered in bulk (see JsBridge.registerJsModules()) and of
+// the module names resolved by a custom name normalizer, so that importing a module does not need
+// any call to Java.
+//
+// Notes:
+// - a registered module is removed when it is loaded because the JS engine keeps its own list of
+//   loaded modules (which are never loaded twice)
+// - must only be used from the JS thread
+class JsModuleRegistry {
+
+public:
+  // UTF-8 source code or bytecode
+  struct Module {
+    std::string content;
+    bool isBytecode = false;
+  };
+
+  JsModuleRegistry() = default;
+  JsModuleRegistry(const JsModuleRegistry &) = delete;
+  JsModuleRegistry &operator=(const JsModuleRegistry &) = delete;
+
+  // Add (or replace) a module
+  void add(const std::string &moduleName, Module module);
+
+  // Move the registered module with the given name into module and return false if there is
+  // none
+  bool take(const std::string &moduleName, Module &module);
+
+  size_t size() const { return m_modules.size(); }
+
+  // Module loader of the context (the loading of modules fails if disabled)
+  void enableLoader() { m_loaderEnabled = true; }
+  bool isLoaderEnabled() const { return m_loaderEnabled; }
+
+  // Custom module name normalizer (default normalizer if disabled)
+  void enableNameNormalizer() { m_nameNormalizerEnabled = true; }
+  bool isNameNormalizerEnabled() const { return m_nameNormalizerEnabled; }
+
+  // Return the memoized result of the normalizer for the given names or nullptr if there is none
+  const std::string *findNormalizedName(const std::string &baseName, const std::string &moduleName) const;
+  void addNormalizedName(const std::string &baseName, const std::string &moduleName, const std::string &normalizedName);
+
+private:
+  static std::string getNormalizedNameKey(const std::string &baseName, const std::string &moduleName);
+
+  std::unordered_map<std::string, Module> m_modules;
+  std::unordered_map<std::string, std::string> m_normalizedNames;
+  bool m_loaderEnabled = false;
+  bool m_nameNormalizerEnabled = false;
+};
+
+#endif
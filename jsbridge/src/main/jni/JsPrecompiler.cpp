@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsPrecompiler.h"
+
+#include "quickjs/quickjs.h"
+#include <algorithm>
+#include <thread>
+
+namespace {
+  // Exception message followed by its stack trace (if any)
+  std::string getExceptionString(JSContext *ctx) {
+    JSValue exception = JS_GetException(ctx);
+
+    std::string ret;
+    const char *message = JS_ToCString(ctx, exception);
+    if (message != nullptr) {
+      ret = message;
+      JS_FreeCString(ctx, message);
+    }
+
+    if (JS_IsError(ctx, exception)) {
+      JSValue stackValue = JS_GetPropertyStr(ctx, exception, "stack");
+      const char *stack = JS_IsUndefined(stackValue) ? nullptr : JS_ToCString(ctx, stackValue);
+      if (stack != nullptr) {
+        ret += '\n';
+        ret += stack;
+        JS_FreeCString(ctx, stack);
+      }
+      JS_FreeValue(ctx, stackValue);
+    }
+
+    JS_FreeValue(ctx, exception);
+    return ret;
+  }
+}
+
+JsPrecompiler::JsPrecompiler(bool asModule, unsigned int threadCount)
+ : m_asModule(asModule)
+ , m_threadCount(std::max(threadCount, 1U)) {
+}
+
+std::vector<JsPrecompiler::Result> JsPrecompiler::compile(const std::vector<Source> &sources) const {
+  std::vector<Result> results(sources.size());
+  std::atomic<size_t> nextIndex(0);
+
+  size_t workerCount = std::min(static_cast<size_t>(m_threadCount), sources.size());
+  if (workerCount == 0) {
+    return results;
+  }
+
+  // The calling thread is one of the workers
+  std::vector<std::thread> threads;
+  threads.reserve(workerCount - 1);
+  for (size_t i = 1; i < workerCount; ++i) {
+    threads.emplace_back(&JsPrecompiler::runWorker, this, std::cref(sources), std::ref(results), std::ref(nextIndex));
+  }
+
+  runWorker(sources, results, nextIndex);
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  return results;
+}
+
+void JsPrecompiler::runWorker(const std::vector<Source> &sources, std::vector<Result> &results, std::atomic<size_t> &nextIndex) const {
+  JSRuntime *runtime = JS_NewRuntime();
+  JSContext *ctx = runtime ? JS_NewContext(runtime) : nullptr;
+
+  int evalFlags = (m_asModule ? JS_EVAL_TYPE_MODULE : JS_EVAL_TYPE_GLOBAL) | JS_EVAL_FLAG_COMPILE_ONLY;
+
+  // Each worker picks the next source until all of them have been compiled
+  size_t index;
+  while ((index = nextIndex++) < sources.size()) {
+    const Source &source = sources[index];
+    Result &result = results[index];
+
+    if (ctx == nullptr) {
+      result.error = "Cannot create QuickJS context for precompilation";
+      continue;
+    }
+
+    // std::string content is always zero-terminated as required by JS_Eval()
+    JSValue compiledValue = JS_Eval(ctx, source.code.c_str(), source.code.size(), source.fileName.c_str(), evalFlags);
+    if (JS_IsException(compiledValue)) {
+      result.error = getExceptionString(ctx);
+      continue;
+    }
+
+    size_t size = 0;
+    uint8_t *buf = JS_WriteObject(ctx, &size, compiledValue, JS_WRITE_OBJ_BYTECODE);
+    JS_FreeValue(ctx, compiledValue);
+
+    if (buf == nullptr) {
+      result.error = getExceptionString(ctx);
+      continue;
+    }
+
+    result.bytecode.assign(reinterpret_cast<const char *>(buf), size);
+    result.success = true;
+    js_free(ctx, buf);
+  }
+
+  if (ctx != nullptr) {
+    JS_FreeContext(ctx);
+  }
+  if (runtime != nullptr) {
+    JS_FreeRuntime(runtime);
+  }
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSPRECOMPILER_H
+#define _JSBRIDGE_JSPRECOMPILER_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Compile JS sources to bytecode in parallel on worker threads, each one with its own throwaway
+// QuickJS runtime (QuickJS runtimes are independent from each other).
+//
+// The bytecode references atoms by name so it can be read by any context using the same
+// bytecode version (see JsBridgeContext::evaluateBytecode()).
+class JsPrecompiler {
+
+public:
+  // UTF-8 source code
+  struct Source {
+    std::string fileName;
+    std::string code;
+  };
+
+  // Compiled bytecode or, on failure, the JS exception (message and stack trace)
+  struct Result {
+    std::string bytecode;
+    std::string error;
+    bool success = false;
+  };
+
+  JsPrecompiler(bool asModule, unsigned int threadCount);
+  JsPrecompiler(const JsPrecompiler &) = delete;
+  JsPrecompiler &operator=(const JsPrecompiler &) = delete;
+
+  // Return the results in the same order as the given sources
+  std::vector<Result> compile(const std::vector<Source> &sources) const;
+
+private:
+  void runWorker(const std::vector<Source> &sources, std::vector<Result> &results, std::atomic<size_t> &nextIndex) const;
+
+  const bool m_asModule;
+  const unsigned int m_threadCount;
+};
+
+#endif
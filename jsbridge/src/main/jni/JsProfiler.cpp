@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsProfiler.h"
+
+#include "JsonUtils.h"
+
+namespace {
+  const char *ROOT_NODE_NAME = "(root)";
+  const char *PROGRAM_NODE_NAME = "(program)";
+  const char *ANONYMOUS_FUNCTION_NAME = "(anonymous)";
+}
+
+void JsProfiler::start(int64_t samplingIntervalUs) {
+  m_nodes.clear();
+  m_nodeIds.clear();
+  m_samples.clear();
+  m_timeDeltasUs.clear();
+  m_programNodeId = -1;
+  m_isIdle = false;
+
+  m_nodes.push_back(Node { -1, ROOT_NODE_NAME, "", 0 });
+
+  m_samplingInterval = std::chrono::microseconds(samplingIntervalUs > 0 ? samplingIntervalUs : 1);
+  m_startTime = Clock::now();
+  m_lastSampleTime = m_startTime;
+  m_nextSampleTime = m_startTime + m_samplingInterval;
+  m_running = true;
+}
+
+void JsProfiler::addSample(const Frame *frames, int frameCount) {
+  const Clock::time_point now = Clock::now();
+
+  // No JS code was running since the end of the last evaluation
+  if (m_isIdle) {
+    m_isIdle = false;
+    if (m_programNodeId < 0) {
+      m_programNodeId = getChildNode(0, PROGRAM_NODE_NAME, "", 0);
+    }
+    if (m_samples.empty() || m_samples.back() != m_programNodeId) {
+      addNodeSample(m_programNodeId, m_idleStartTime);
+    }
+  }
+
+  int nodeId = 0;
+  for (int i = frameCount - 1; i >= 0; --i) {
+    const Frame &frame = frames[i];
+    const char *functionName = frame.functionName[0] != '\0' ? frame.functionName : ANONYMOUS_FUNCTION_NAME;
+    nodeId = getChildNode(nodeId, functionName, frame.fileName, frame.lineNumber);
+  }
+
+  addNodeSample(nodeId, now);
+  m_nextSampleTime = now + m_samplingInterval;
+}
+
+void JsProfiler::onEvaluationEnd() {
+  if (m_running && !m_isIdle) {
+    m_isIdle = true;
+    m_idleStartTime = Clock::now();
+  }
+}
+
+std::string JsProfiler::stop() {
+  if (!m_running) {
+    return std::string();
+  }
+
+  m_running = false;
+  const int64_t endTimeUs = toTimestampUs(Clock::now());
+
+  std::unordered_map<std::string, int> scriptIds;
+  std::string json;
+  json.reserve(m_nodes.size() * 128 + m_samples.size() * 16);
+
+  json += "{\"nodes\":[";
+  for (size_t i = 0; i < m_nodes.size(); ++i) {
+    const Node &node = m_nodes[i];
+
+    // The scripts are identified by their file name
+    int scriptId = 0;
+    if (!node.fileName.empty()) {
+      scriptId = scriptIds.emplace(node.fileName, static_cast<int>(scriptIds.size()) + 1).first->second;
+    }
+
+    if (i > 0) json += ',';
+    json += "{\"id\":" + std::to_string(i + 1);
+    json += ",\"callFrame\":{\"functionName\":";
+    JsonUtils::appendString(json, node.functionName);
+    json += ",\"scriptId\":\"" + std::to_string(scriptId) + "\",\"url\":";
+    JsonUtils::appendString(json, node.fileName);
+    json += ",\"lineNumber\":" + std::to_string(node.lineNumber - 1);  // 0-based
+    json += ",\"columnNumber\":-1}";
+    json += ",\"hitCount\":" + std::to_string(node.hitCount);
+    json += ",\"children\":[";
+    for (size_t j = 0; j < node.childIds.size(); ++j) {
+      if (j > 0) json += ',';
+      json += std::to_string(node.childIds[j] + 1);
+    }
+    json += "]}";
+  }
+
+  json += "],\"startTime\":" + std::to_string(toTimestampUs(m_startTime));
+  json += ",\"endTime\":" + std::to_string(endTimeUs);
+
+  json += ",\"samples\":[";
+  for (size_t i = 0; i < m_samples.size(); ++i) {
+    if (i > 0) json += ',';
+    json += std::to_string(m_samples[i] + 1);
+  }
+
+  json += "],\"timeDeltas\":[";
+  for (size_t i = 0; i < m_timeDeltasUs.size(); ++i) {
+    if (i > 0) json += ',';
+    json += std::to_string(m_timeDeltasUs[i]);
+  }
+  json += "]}";
+
+  // Release the memory of the profile
+  std::vector<Node>().swap(m_nodes);
+  std::unordered_map<std::string, int>().swap(m_nodeIds);
+  std::vector<int>().swap(m_samples);
+  std::vector<int64_t>().swap(m_timeDeltasUs);
+
+  return json;
+}
+
+int JsProfiler::getChildNode(int parentId, const char *functionName, const char *fileName, int lineNumber) {
+  m_nodeKey.clear();
+  m_nodeKey += std::to_string(parentId);
+  m_nodeKey += '\0';
+  m_nodeKey += functionName;
+  m_nodeKey += '\0';
+  m_nodeKey += fileName;
+  m_nodeKey += '\0';
+  m_nodeKey += std::to_string(lineNumber);
+
+  auto it = m_nodeIds.find(m_nodeKey);
+  if (it != m_nodeIds.end()) {
+    return it->second;
+  }
+
+  const int nodeId = static_cast<int>(m_nodes.size());
+  m_nodes.push_back(Node { parentId, functionName, fileName, lineNumber });
+  m_nodes[parentId].childIds.push_back(nodeId);
+  m_nodeIds.emplace(m_nodeKey, nodeId);
+  return nodeId;
+}
+
+void JsProfiler::addNodeSample(int nodeId, Clock::time_point sampleTime) {
+  ++m_nodes[nodeId].hitCount;
+  m_samples.push_back(nodeId);
+  m_timeDeltasUs.push_back(std::chrono::duration_cast<std::chrono::microseconds>(sampleTime - m_lastSampleTime).count());
+  m_lastSampleTime = sampleTime;
+}
+
+// static
+int64_t JsProfiler::toTimestampUs(Clock::time_point timePoint) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(timePoint.time_since_epoch()).count();
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSPROFILER_H
+#define _JSBRIDGE_JSPROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Optional sampling profiler of the JS code (stopped by default)
+//
+// While it is running, the JS call stack is sampled by the interrupt handler (QuickJS) or by the
+// exec timeout check (Duktape) once the sampling interval has elapsed. The samples are merged
+// into a call tree which is exported in the .cpuprofile format (Chrome DevTools, speedscope...).
+//
+// Notes:
+// - the samples are only taken while JS code is running: the time between the end of an
+//   evaluation and the next sample (e.g. while the JS thread is idle) is attributed to a
+//   "(program)" node, the time spent in Java code called from JS to the calling JS function
+// - the engine hooks are not called at a fixed rate (every 10000 ticks for QuickJS, every 256k
+//   opcodes for Duktape) so the effective interval can be longer
+//
+// Must only be used from the JS thread.
+class JsProfiler {
+
+public:
+  // A frame of the sampled call stack. The strings only need to be valid during addSample().
+  struct Frame {
+    const char *functionName;
+    const char *fileName;
+    int lineNumber;  // 1-based, 0 if unknown
+  };
+
+  static const int MAX_STACK_DEPTH = 64;
+
+  JsProfiler() = default;
+  JsProfiler(const JsProfiler &) = delete;
+  JsProfiler &operator=(const JsProfiler &) = delete;
+
+  // Drop any previous profile
+  void start(int64_t samplingIntervalUs);
+  // Return the profile in .cpuprofile (JSON) format
+  std::string stop();
+
+  bool isRunning() const { return m_running; }
+
+  // Return true if the sampling interval has elapsed since the last sample
+  bool isSampleDue() const {
+    return m_running && Clock::now() >= m_nextSampleTime;
+  }
+
+  // The frames are given from the innermost to the outermost one
+  void addSample(const Frame *frames, int frameCount);
+
+  // Called at the end of the outermost JS evaluation (see ExecutionDeadline::Scope)
+  void onEvaluationEnd();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Node {
+    int parentId;
+    std::string functionName;
+    std::string fileName;
+    int lineNumber;
+    int64_t hitCount = 0;
+    std::vector<int> childIds;
+  };
+
+  int getChildNode(int parentId, const char *functionName, const char *fileName, int lineNumber);
+  void addNodeSample(int nodeId, Clock::time_point sampleTime);
+  static int64_t toTimestampUs(Clock::time_point);
+
+  bool m_running = false;
+  Clock::duration m_samplingInterval {};
+  Clock::time_point m_startTime;
+  Clock::time_point m_lastSampleTime;
+  Clock::time_point m_nextSampleTime;
+
+  // Node 0 is the root
+  std::vector<Node> m_nodes;
+  // "<parent id>\0<function name>\0<file name>\0<line number>" -> node id
+  std::unordered_map<std::string, int> m_nodeIds;
+  std::string m_nodeKey;  // re-used to avoid allocations
+  int m_programNodeId = -1;
+  bool m_isIdle = false;
+  Clock::time_point m_idleStartTime;
+
+  std::vector<int> m_samples;
+  std::vector<int64_t> m_timeDeltasUs;
+};
+
+#endif
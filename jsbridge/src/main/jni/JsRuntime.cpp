@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsRuntime.h"
+
+#include "JsSharedBuffer.h"
+#include "PoolAllocator.h"
+#include <algorithm>
+#include <new>
+
+namespace {
+  // QuickJS allocation functions delegating to the PoolAllocator given as opaque pointer, which
+  // also enforces the memory limit. The JSMallocState counters are kept in sync because QuickJS
+  // uses them for its GC threshold and its memory usage stats.
+  void syncMallocState(JSMallocState *s, const PoolAllocator *allocator) {
+    s->malloc_count = allocator->getAllocationCount();
+    s->malloc_size = allocator->getAllocatedSize();
+  }
+
+  void *poolMalloc(JSMallocState *s, size_t size) {
+    auto allocator = static_cast<PoolAllocator *>(s->opaque);
+    void *ptr = allocator->allocate(size);
+    syncMallocState(s, allocator);
+    return ptr;
+  }
+
+  void poolFree(JSMallocState *s, void *ptr) {
+    auto allocator = static_cast<PoolAllocator *>(s->opaque);
+    allocator->deallocate(ptr);
+    syncMallocState(s, allocator);
+  }
+
+  void *poolRealloc(JSMallocState *s, void *ptr, size_t size) {
+    auto allocator = static_cast<PoolAllocator *>(s->opaque);
+    void *newPtr = allocator->reallocate(ptr, size);
+    syncMallocState(s, allocator);
+    return newPtr;
+  }
+
+  const JSMallocFunctions poolMallocFunctions = {
+    poolMalloc,
+    poolFree,
+    poolRealloc,
+    nullptr  // the usable size of a given block cannot be retrieved without the allocator instance
+  };
+}
+
+// static
+JsRuntime *JsRuntime::create(const JsBridgeContext::EngineSettings &engineSettings) {
+  auto jsRuntime = new JsRuntime();
+
+  if (engineSettings.poolAllocator) {
+    jsRuntime->m_allocator = new PoolAllocator();
+    jsRuntime->m_runtime = JS_NewRuntime2(&poolMallocFunctions, jsRuntime->m_allocator);
+  } else {
+    jsRuntime->m_runtime = JS_NewRuntime();
+  }
+
+  if (jsRuntime->m_runtime == nullptr) {
+    delete jsRuntime;
+    throw std::bad_alloc();
+  }
+
+  JSRuntime *rt = jsRuntime->m_runtime;
+
+  // Used by the runtime-level callbacks to find their way back to the JsRuntime instance (see
+  // getInstance())
+  JS_SetRuntimeOpaque(rt, jsRuntime);
+
+  // SharedArrayBuffers can be shared with other contexts via JsMessage and with Java
+  JsSharedBuffer::enable(rt);
+
+  if (engineSettings.memoryLimit > 0) {
+    if (jsRuntime->m_allocator != nullptr) {
+      jsRuntime->m_allocator->setMemoryLimit(engineSettings.memoryLimit);
+    } else {
+      JS_SetMemoryLimit(rt, engineSettings.memoryLimit);
+    }
+  }
+  if (engineSettings.gcThreshold > 0) {
+    JS_SetGCThreshold(rt, engineSettings.gcThreshold);
+  }
+  if (engineSettings.regExpCacheSize > 0) {
+    JS_SetRegExpCacheSize(rt, engineSettings.regExpCacheSize);
+  }
+
+  // QuickJS default: 256kb, JsBridge default: 1MB
+  JS_SetMaxStackSize(rt, engineSettings.maxStackSize > 0 ? engineSettings.maxStackSize : 1 * 1024 * 1024);
+
+  return jsRuntime;
+}
+
+JsRuntime::~JsRuntime() {
+  if (m_runtime != nullptr) {
+    JS_FreeRuntime(m_runtime);
+  }
+
+  // Bulk release of the pooled memory (all the JS values have been finalized by JS_FreeRuntime)
+  delete m_allocator;
+}
+
+const JniContext *JsRuntime::getJniContext() const {
+  return m_contexts.empty() ? nullptr : m_contexts.front()->getJniContext();
+}
+
+void JsRuntime::addContext(JsBridgeContext *jsBridgeContext) {
+  m_contexts.push_back(jsBridgeContext);
+}
+
+bool JsRuntime::releaseContext(JsBridgeContext *jsBridgeContext) {
+  if (m_contexts.size() <= 1) {
+    // The last objects are finalized by JS_FreeRuntime() while the context is still registered
+    delete this;
+    return true;
+  }
+
+  // Finalize the (now unreachable) objects of the released context while it can still be used by
+  // the finalizers
+  JS_RunGC(m_runtime);
+
+  m_contexts.erase(std::remove(m_contexts.begin(), m_contexts.end(), jsBridgeContext), m_contexts.end());
+  return false;
+}
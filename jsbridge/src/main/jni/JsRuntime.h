@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSRUNTIME_H
+#define _JSBRIDGE_JSRUNTIME_H
+
+#include "CppWrapperCounters.h"
+#include "JsBridgeContext.h"
+#include "quickjs/quickjs.h"
+#include <vector>
+
+class JniContext;
+class PoolAllocator;
+
+// QuickJS runtime of one or more JsBridgeContext instances (QuickJS only)
+//
+// By default, each JsBridgeContext has its own runtime. A new context can also be created in the
+// runtime of another one (see EngineSettings::sharedRuntimeContext) so that both share the atoms,
+// the builtin shapes, the (pooled) allocator and the GC. Their JsBridge instances must then run on
+// the same JS thread.
+//
+// Notes:
+// - the runtime settings (memory limit, GC threshold, stack size, allocator) are given by the
+//   first context; the memory usage and the heap snapshots cover all its contexts
+// - the runtime-level callbacks (interrupt handler, C++ wrapper finalizers) are dispatched to the
+//   contexts of the runtime
+// - the runtime is released together with its last context
+class JsRuntime {
+
+public:
+  // Throw std::bad_alloc if the runtime could not be created
+  static JsRuntime *create(const JsBridgeContext::EngineSettings &);
+
+  static JsRuntime *getInstance(JSRuntime *rt) { return static_cast<JsRuntime *>(JS_GetRuntimeOpaque(rt)); }
+
+  JsRuntime(const JsRuntime &) = delete;
+  JsRuntime &operator=(const JsRuntime &) = delete;
+
+  JSRuntime *getQuickJsRuntime() const { return m_runtime; }
+  PoolAllocator *getAllocator() const { return m_allocator; }  // null when using the default allocator
+  CppWrapperCounters *getCppWrapperCounters() { return &m_cppWrapperCounters; }
+
+  // JS contexts of the runtime (in creation order)
+  const std::vector<JsBridgeContext *> &getContexts() const { return m_contexts; }
+  bool isShared() const { return m_contexts.size() > 1; }
+
+  // JNI context used by the runtime-level callbacks (all the contexts share the same JS thread)
+  const JniContext *getJniContext() const;
+
+  void addContext(JsBridgeContext *);
+
+  // Must be called after JS_FreeContext(): finalize the remaining JS objects of the given context
+  // (via GC) and, if it was the last one, release the runtime itself. Return true if the runtime
+  // has been released.
+  bool releaseContext(JsBridgeContext *);
+
+private:
+  JsRuntime() = default;
+  ~JsRuntime();
+
+  JSRuntime *m_runtime = nullptr;
+  PoolAllocator *m_allocator = nullptr;
+  CppWrapperCounters m_cppWrapperCounters;
+  std::vector<JsBridgeContext *> m_contexts;
+};
+
+#endif
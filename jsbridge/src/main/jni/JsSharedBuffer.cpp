@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsSharedBuffer.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace {
+  struct SharedBufferHeader {
+    std::atomic<int> refCount;
+    std::atomic<uint32_t> notifyCount;
+    alignas(std::max_align_t) uint8_t data[1];
+  };
+
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "The notification counter is used as a futex");
+
+  SharedBufferHeader *getSharedBufferHeader(const uint8_t *data) {
+    return reinterpret_cast<SharedBufferHeader *>(const_cast<uint8_t *>(data) - offsetof(SharedBufferHeader, data));
+  }
+
+  uint32_t *getFutex(SharedBufferHeader *header) {
+    return reinterpret_cast<uint32_t *>(&header->notifyCount);
+  }
+
+  void *sharedBufferAlloc(void *, size_t size) {
+    return JsSharedBuffer::alloc(size);
+  }
+
+  void sharedBufferFree(void *, void *ptr) {
+    JsSharedBuffer::release(static_cast<uint8_t *>(ptr));
+  }
+
+  void sharedBufferDup(void *, void *ptr) {
+    JsSharedBuffer::retain(static_cast<uint8_t *>(ptr));
+  }
+
+  const JSSharedArrayBufferFunctions sharedArrayBufferFunctions = {
+    sharedBufferAlloc,
+    sharedBufferFree,
+    sharedBufferDup,
+    nullptr
+  };
+}
+
+namespace JsSharedBuffer {
+
+  void enable(JSRuntime *runtime) {
+    JS_SetSharedArrayBufferFunctions(runtime, &sharedArrayBufferFunctions);
+  }
+
+  uint8_t *alloc(size_t size) {
+    size = std::max<size_t>(size, 1);
+    void *mem = std::malloc(offsetof(SharedBufferHeader, data) + size);
+    if (mem == nullptr) {
+      return nullptr;
+    }
+
+    auto header = new (mem) SharedBufferHeader();
+    header->refCount = 1;
+    header->notifyCount = 0;
+    memset(header->data, 0, size);
+    return header->data;
+  }
+
+  void retain(uint8_t *data) {
+    ++getSharedBufferHeader(data)->refCount;
+  }
+
+  void release(uint8_t *data) {
+    SharedBufferHeader *header = getSharedBufferHeader(data);
+    if (--header->refCount == 0) {
+      header->~SharedBufferHeader();
+      std::free(header);
+    }
+  }
+
+  void notify(uint8_t *data) {
+    SharedBufferHeader *header = getSharedBufferHeader(data);
+    ++header->notifyCount;
+    syscall(SYS_futex, getFutex(header), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+  }
+
+  uint32_t getNotifyCount(const uint8_t *data) {
+    return getSharedBufferHeader(data)->notifyCount.load();
+  }
+
+  uint32_t waitForNotify(uint8_t *data, uint32_t notifyCount, long long timeoutMs) {
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(std::max(timeoutMs, 0LL));
+
+    SharedBufferHeader *header = getSharedBufferHeader(data);
+    uint32_t currentCount;
+    while ((currentCount = header->notifyCount.load()) == notifyCount) {
+      timespec timeout {};
+      if (timeoutMs >= 0) {
+        auto remainingNs = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - Clock::now()).count();
+        if (remainingNs <= 0) {
+          break;
+        }
+        timeout.tv_sec = static_cast<time_t>(remainingNs / 1000000000);
+        timeout.tv_nsec = static_cast<long>(remainingNs % 1000000000);
+      }
+
+      // Returns immediately if the counter has been changed in the meantime
+      syscall(SYS_futex, getFutex(header), FUTEX_WAIT_PRIVATE, notifyCount, timeoutMs >= 0 ? &timeout : nullptr, nullptr, 0);
+    }
+
+    return currentCount;
+  }
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSSHAREDBUFFER_H
+#define _JSBRIDGE_JSSHAREDBUFFER_H
+
+#include "quickjs/quickjs.h"
+#include <cstddef>
+#include <cstdint>
+
+// Memory of the SharedArrayBuffers, allocated outside of the runtimes and reference-counted so
+// that it can be shared with other contexts (see JsMessage) and with Java (see
+// JsBridge.newJsSharedBuffer()).
+//
+// Each buffer also has a notification counter so that one side can signal new data to the other
+// one without a bridge call per message: JS code increments it with the native notify() method
+// of the buffers created by Java and Java threads can wait for it to change.
+namespace JsSharedBuffer {
+
+  // Allocate the SharedArrayBuffers of the given runtime with this allocator
+  void enable(JSRuntime *runtime);
+
+  // Allocate a zero-initialized buffer (with a single reference) or return nullptr
+  uint8_t *alloc(size_t size);
+
+  // Note: can be called from any thread
+  void retain(uint8_t *data);
+  void release(uint8_t *data);
+
+  // Increment the notification counter and wake up the waiting threads
+  void notify(uint8_t *data);
+
+  uint32_t getNotifyCount(const uint8_t *data);
+
+  // Block until the notification counter differs from the given one or until timeoutMs has
+  // elapsed (< 0: no timeout) and return the current counter
+  uint32_t waitForNotify(uint8_t *data, uint32_t notifyCount, long long timeoutMs);
+}
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsStringCache.h"
+
+#include <cstdint>
+
+namespace {
+  // FNV-1a
+  size_t hashUtf16(const char16_t *chars, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+      hash = (hash ^ chars[i]) * 16777619u;
+    }
+    return hash;
+  }
+}
+
+JsStringCache::JsStringCache(JSContext *ctx, size_t entryCount)
+ : m_ctx(ctx) {
+
+  size_t size = 1;
+  while (size < entryCount) {
+    size <<= 1;
+  }
+
+  m_entries.resize(size);
+  m_indexMask = size - 1;
+}
+
+JsStringCache::~JsStringCache() {
+  // Must be destroyed before the JSContext
+  clear();
+}
+
+bool JsStringCache::get(const JStringLocalRef &jString, JSValue *pValue) {
+  if (jString.isNull()) {
+    return false;
+  }
+
+  char16_t chars[MAX_STRING_LENGTH];
+  const jsize length = jString.copyUtf16Chars(chars, MAX_STRING_LENGTH);
+  if (length < 0) {
+    return false;
+  }
+
+  return get(chars, static_cast<size_t>(length), pValue);
+}
+
+bool JsStringCache::get(const char16_t *chars, size_t length, JSValue *pValue) {
+  if (length > static_cast<size_t>(MAX_STRING_LENGTH)) {
+    return false;
+  }
+
+  Entry &entry = m_entries[hashUtf16(chars, length) & m_indexMask];
+  if (JS_IsString(entry.value) && entry.str.compare(0, std::u16string::npos, chars, length) == 0) {
+    *pValue = JS_DupValue(m_ctx, entry.value);
+    return true;
+  }
+
+  JSValue value = JS_NewStringUTF16(m_ctx, reinterpret_cast<const uint16_t *>(chars), length);
+  if (JS_IsString(value)) {
+    JS_FreeValue(m_ctx, entry.value);
+    entry.str.assign(chars, length);
+    entry.value = JS_DupValue(m_ctx, value);
+  }
+
+  *pValue = value;
+  return true;
+}
+
+void JsStringCache::clear() {
+  for (Entry &entry : m_entries) {
+    JS_FreeValue(m_ctx, entry.value);
+    entry.value = JS_UNDEFINED;
+    entry.str.clear();
+    entry.str.shrink_to_fit();
+  }
+}
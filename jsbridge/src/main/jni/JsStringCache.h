@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSSTRINGCACHE_H
+#define _JSBRIDGE_JSSTRINGCACHE_H
+
+#include "jni-helpers/JStringLocalRef.h"
+#include "quickjs/quickjs.h"
+#include <string>
+#include <vector>
+
+// Bounded cache of the JS strings converted from short Java strings which are often given again
+// with the same content (e.g. event names or enum-like keys), so that they are only converted once
+// and share the same JS string in the JS heap.
+//
+// Notes:
+// - the key is the string content: the Java chars are copied into a local buffer (no allocation
+//   on a cache hit) and hashed
+// - direct-mapped cache: a new string replaces the entry with the same hash index
+// - must only be used from the JS thread
+class JsStringCache {
+
+public:
+  // Longer strings are converted as usual
+  static const jsize MAX_STRING_LENGTH = 64;
+
+  // The entry count is rounded up to the next power of 2
+  JsStringCache(JSContext *, size_t entryCount);
+  JsStringCache(const JsStringCache &) = delete;
+  JsStringCache &operator=(const JsStringCache &) = delete;
+
+  ~JsStringCache();
+
+  // Set pValue to the (duplicated) JS string with the same content as the given Java string,
+  // converting and caching it if needed, and return false if the string is null or too long to
+  // be cached
+  bool get(const JStringLocalRef &, JSValue *pValue);
+  // Same with the given UTF-16 chars (e.g. of a packed string array)
+  bool get(const char16_t *chars, size_t length, JSValue *pValue);
+
+  // Release all the cached JS strings (e.g. on memory pressure)
+  void clear();
+
+private:
+  struct Entry {
+    std::u16string str;
+    JSValue value = JS_UNDEFINED;
+  };
+
+  JSContext *m_ctx;
+  std::vector<Entry> m_entries;
+  size_t m_indexMask;
+};
+
+#endif
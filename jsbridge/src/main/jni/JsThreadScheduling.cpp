@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsThreadScheduling.h"
+
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace JsThreadScheduling {
+
+  void setNiceValue(int niceValue) {
+    // On Linux, the nice value is a per-thread attribute
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(gettid()), niceValue) != 0) {
+      throw std::runtime_error("Cannot set the nice value of the JS thread to " + std::to_string(niceValue) + ": " + strerror(errno));
+    }
+  }
+
+  void setCpuAffinityMask(uint64_t cpuAffinityMask) {
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+      if ((cpuAffinityMask >> cpu) & 1u) {
+        CPU_SET(cpu, &cpuSet);
+      }
+    }
+
+    // pid 0: calling thread
+    if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+      throw std::runtime_error("Cannot set the CPU affinity mask of the JS thread to " + std::to_string(cpuAffinityMask) + ": " + strerror(errno));
+    }
+  }
+}
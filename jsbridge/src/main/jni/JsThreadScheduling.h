@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSTHREADSCHEDULING_H
+#define _JSBRIDGE_JSTHREADSCHEDULING_H
+
+#include <cstdint>
+
+// Scheduling of the calling thread (i.e. the JS thread), e.g. to keep latency-critical scripts
+// on the big cores of big.LITTLE devices
+//
+// Both functions throw a std::runtime_error on failure.
+namespace JsThreadScheduling {
+
+  // Set the nice value (-20: highest priority, 19: lowest)
+  void setNiceValue(int niceValue);
+
+  // Restrict the thread to the CPUs whose bit is set in the mask (bit 0: CPU 0, ...)
+  void setCpuAffinityMask(uint64_t cpuAffinityMask);
+}
+
+#endif
@@ -0,0 +1,288 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsValueTable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(DUKTAPE)
+# include "StackChecker.h"
+#endif
+
+namespace {
+  inline jlong makeHandle(uint32_t slotIndex, uint32_t generation) {
+    return static_cast<jlong>((static_cast<uint64_t>(generation) << 32) | (static_cast<uint64_t>(slotIndex) + 1));
+  }
+
+#if defined(DUKTAPE)
+  const char JSVALUE_TABLE_PROP_NAME[] = "\xff\xffjsvalue_table";
+  const char JSVALUE_OWNER_TABLE_PROP_NAME[] = "\xff\xffjsvalue_owner_table";
+#endif
+}
+
+bool JsValueTable::findSlotIndex(jlong handle, uint32_t &slotIndex) const {
+  const auto uHandle = static_cast<uint64_t>(handle);
+  const auto slotIndexPlusOne = static_cast<uint32_t>(uHandle & 0xffffffffu);
+  const auto generation = static_cast<uint32_t>(uHandle >> 32);
+
+  if (slotIndexPlusOne == 0 || slotIndexPlusOne > m_slots.size()) {
+    return false;
+  }
+
+  const Slot &slot = m_slots[slotIndexPlusOne - 1];
+  if (!slot.isUsed || slot.generation != generation) {
+    return false;
+  }
+
+  slotIndex = slotIndexPlusOne - 1;
+  return true;
+}
+
+uint32_t JsValueTable::getSlotIndex(jlong handle) const {
+  uint32_t slotIndex;
+  if (!findSlotIndex(handle, slotIndex)) {
+    throw std::invalid_argument("Invalid JsValue handle " + std::to_string(handle) + " (the JsValue may have already been released)");
+  }
+
+  return slotIndex;
+}
+
+uint32_t JsValueTable::acquireSlot() {
+  uint32_t slotIndex;
+  if (m_freeSlots.empty()) {
+    slotIndex = static_cast<uint32_t>(m_slots.size());
+    m_slots.emplace_back();
+    m_slots.back().generation = m_newSlotGeneration;
+  } else {
+    slotIndex = m_freeSlots.back();
+    m_freeSlots.pop_back();
+  }
+
+  m_slots[slotIndex].isUsed = true;
+  return slotIndex;
+}
+
+void JsValueTable::compact() {
+  size_t slotCount = m_slots.size();
+  while (slotCount > 0 && !m_slots[slotCount - 1].isUsed) {
+    // The generation of a free slot is already higher than the one of its stale handles
+    m_newSlotGeneration = std::max(m_newSlotGeneration, m_slots[slotCount - 1].generation);
+    --slotCount;
+  }
+
+  if (slotCount == m_slots.size()) {
+    return;
+  }
+
+  m_slots.resize(slotCount);
+  m_slots.shrink_to_fit();
+  m_freeSlots.erase(std::remove_if(m_freeSlots.begin(), m_freeSlots.end(), [slotCount](uint32_t slotIndex) {
+    return slotIndex >= slotCount;
+  }), m_freeSlots.end());
+  m_freeSlots.shrink_to_fit();
+
+#if defined(DUKTAPE)
+  CHECK_STACK(m_ctx);
+
+  duk_push_global_stash(m_ctx);
+  for (const char *propName : { JSVALUE_TABLE_PROP_NAME, JSVALUE_OWNER_TABLE_PROP_NAME }) {
+    duk_get_prop_string(m_ctx, -1, propName);
+    if (duk_get_length(m_ctx, -1) > slotCount) {
+      duk_push_uint(m_ctx, static_cast<duk_uint_t>(slotCount));
+      duk_put_prop_literal(m_ctx, -2, "length");
+    }
+    duk_pop(m_ctx);  // table
+  }
+  duk_pop(m_ctx);  // global stash
+#endif
+}
+
+#if defined(DUKTAPE)
+
+JsValueTable::JsValueTable(duk_context *ctx)
+ : m_ctx(ctx) {
+
+  CHECK_STACK(m_ctx);
+
+  // The stored values are kept alive by an array in the global stash
+  duk_push_global_stash(m_ctx);
+  duk_push_array(m_ctx);
+  duk_put_prop_literal(m_ctx, -2, JSVALUE_TABLE_PROP_NAME);
+  duk_push_array(m_ctx);
+  duk_put_prop_literal(m_ctx, -2, JSVALUE_OWNER_TABLE_PROP_NAME);
+  duk_pop(m_ctx);  // global stash
+}
+
+JsValueTable::~JsValueTable() {
+  // Nothing to do: the stash array is released together with the Duktape heap
+}
+
+jlong JsValueTable::add() {
+  CHECK_STACK_OFFSET(m_ctx, -1);
+
+  const uint32_t slotIndex = acquireSlot();
+  const Slot &slot = m_slots[slotIndex];
+
+  duk_push_global_stash(m_ctx);
+  duk_get_prop_literal(m_ctx, -1, JSVALUE_TABLE_PROP_NAME);
+  duk_dup(m_ctx, -3);
+  duk_put_prop_index(m_ctx, -2, slotIndex);
+  duk_pop_3(m_ctx);  // table + global stash + value
+
+  return makeHandle(slotIndex, slot.generation);
+}
+
+jlong JsValueTable::add(void *cppPtr) {
+  CHECK_STACK_OFFSET(m_ctx, -2);
+
+  duk_push_global_stash(m_ctx);
+  duk_get_prop_literal(m_ctx, -1, JSVALUE_OWNER_TABLE_PROP_NAME);
+
+  const uint32_t slotIndex = acquireSlot();
+  Slot &slot = m_slots[slotIndex];
+  slot.cppPtr = cppPtr;
+
+  duk_dup(m_ctx, -3);
+  duk_put_prop_index(m_ctx, -2, slotIndex);
+  duk_pop_3(m_ctx);  // owner table + global stash + owner
+
+  // [... value]
+  duk_push_global_stash(m_ctx);
+  duk_get_prop_literal(m_ctx, -1, JSVALUE_TABLE_PROP_NAME);
+  duk_dup(m_ctx, -3);
+  duk_put_prop_index(m_ctx, -2, slotIndex);
+  duk_pop_3(m_ctx);  // table + global stash + value
+
+  return makeHandle(slotIndex, slot.generation);
+}
+
+void JsValueTable::push(jlong handle) const {
+  CHECK_STACK_OFFSET(m_ctx, 1);
+
+  const uint32_t slotIndex = getSlotIndex(handle);
+
+  duk_push_global_stash(m_ctx);
+  duk_get_prop_literal(m_ctx, -1, JSVALUE_TABLE_PROP_NAME);
+  duk_get_prop_index(m_ctx, -1, slotIndex);
+  duk_remove(m_ctx, -2);  // table
+  duk_remove(m_ctx, -2);  // global stash
+}
+
+// static
+bool JsValueTable::isTablePropertyName(const char *key) {
+  return key != nullptr && (strcmp(key, JSVALUE_TABLE_PROP_NAME) == 0 || strcmp(key, JSVALUE_OWNER_TABLE_PROP_NAME) == 0);
+}
+
+void JsValueTable::remove(jlong handle) {
+  CHECK_STACK(m_ctx);
+
+  uint32_t slotIndex;
+  if (!findSlotIndex(handle, slotIndex)) {
+    return;
+  }
+
+  // Replace the value with undefined (instead of deleting the index) to keep a dense array
+  duk_push_global_stash(m_ctx);
+  duk_get_prop_literal(m_ctx, -1, JSVALUE_TABLE_PROP_NAME);
+  duk_push_undefined(m_ctx);
+  duk_put_prop_index(m_ctx, -2, slotIndex);
+  duk_pop(m_ctx);  // table
+
+  Slot &slot = m_slots[slotIndex];
+  if (slot.cppPtr != nullptr) {
+    duk_get_prop_literal(m_ctx, -1, JSVALUE_OWNER_TABLE_PROP_NAME);
+    duk_push_undefined(m_ctx);
+    duk_put_prop_index(m_ctx, -2, slotIndex);
+    duk_pop(m_ctx);  // owner table
+    slot.cppPtr = nullptr;
+  }
+  duk_pop(m_ctx);  // global stash
+
+  slot.isUsed = false;
+  ++slot.generation;
+  m_freeSlots.push_back(slotIndex);
+}
+
+#elif defined(QUICKJS)
+
+JsValueTable::JsValueTable(JSContext *ctx)
+ : m_ctx(ctx) {
+}
+
+JsValueTable::~JsValueTable() {
+  // Must be destroyed before the JSContext
+  for (Slot &slot : m_slots) {
+    if (slot.isUsed) {
+      JS_FreeValue(m_ctx, slot.value);
+      JS_FreeValue(m_ctx, slot.cppPtrOwner);
+    }
+  }
+}
+
+jlong JsValueTable::add(JSValueConst v) {
+  const uint32_t slotIndex = acquireSlot();
+
+  Slot &slot = m_slots[slotIndex];
+  slot.value = JS_DupValue(m_ctx, v);
+
+  return makeHandle(slotIndex, slot.generation);
+}
+
+jlong JsValueTable::add(JSValueConst v, void *cppPtr, JSValueConst cppPtrOwner) {
+  const uint32_t slotIndex = acquireSlot();
+
+  Slot &slot = m_slots[slotIndex];
+  slot.value = JS_DupValue(m_ctx, v);
+  slot.cppPtr = cppPtr;
+  slot.cppPtrOwner = JS_DupValue(m_ctx, cppPtrOwner);
+
+  return makeHandle(slotIndex, slot.generation);
+}
+
+JSValue JsValueTable::get(jlong handle) const {
+  const uint32_t slotIndex = getSlotIndex(handle);
+  return JS_DupValue(m_ctx, m_slots[slotIndex].value);
+}
+
+void JsValueTable::forEach(const std::function<void(jlong, JSValueConst, JSValueConst)> &f) const {
+  for (size_t i = 0; i < m_slots.size(); ++i) {
+    const Slot &slot = m_slots[i];
+    if (slot.isUsed) {
+      f(makeHandle(static_cast<uint32_t>(i), slot.generation), slot.value, slot.cppPtrOwner);
+    }
+  }
+}
+
+void JsValueTable::remove(jlong handle) {
+  uint32_t slotIndex;
+  if (!findSlotIndex(handle, slotIndex)) {
+    return;
+  }
+
+  Slot &slot = m_slots[slotIndex];
+  JS_FreeValue(m_ctx, slot.value);
+  JS_FreeValue(m_ctx, slot.cppPtrOwner);
+  slot.value = JS_UNDEFINED;
+  slot.cppPtrOwner = JS_UNDEFINED;
+  slot.cppPtr = nullptr;
+  slot.isUsed = false;
+  ++slot.generation;
+  m_freeSlots.push_back(slotIndex);
+}
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSVALUETABLE_H
+#define _JSBRIDGE_JSVALUETABLE_H
+
+#include <jni.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#if defined(DUKTAPE)
+# include "duktape/duktape.h"
+#elif defined(QUICKJS)
+# include "quickjs/quickjs.h"
+#endif
+
+// Native storage for the JS values referenced by Java JsValue instances (and for the JS promises
+// created from Java Deferred instances, until they are completed).
+//
+// Each value is stored in a slot and identified by a jlong handle which is built out of the
+// slot index and a generation counter:
+// - handle = (generation << 32) | (slot index + 1)
+// - 0 is never a valid handle
+// - the generation is incremented each time a slot is released so that a stale handle (e.g.
+//   released twice) never resolves to another value
+//
+// A value can also be bound to a C++ instance (e.g. the JavaScriptObject created when registering
+// a JS object), which is kept alive with the value via its owning JS object (i.e. the CppWrapper
+// value mapped into the JS object). This allows calling it without any further JS lookup.
+//
+// Must only be used from the JS thread.
+class JsValueTable {
+
+public:
+  JsValueTable() = delete;
+  JsValueTable(const JsValueTable &) = delete;
+  JsValueTable &operator=(const JsValueTable &) = delete;
+
+#if defined(DUKTAPE)
+  explicit JsValueTable(duk_context *);
+
+  // Store the value on top of the stack and return its handle
+  // [... value] => [...]
+  jlong add();
+
+  // Store the value together with a C++ instance kept alive by cppPtrOwner and return its handle
+  // [... value cppPtrOwner] => [...]
+  jlong add(void *cppPtr);
+
+  // Push the value stored with the given handle
+  // [...] => [... value]
+  void push(jlong handle) const;
+
+  // Return true if the given key is the name of one of the (hidden) global stash properties
+  // holding the table values and their owners
+  static bool isTablePropertyName(const char *key);
+#elif defined(QUICKJS)
+  explicit JsValueTable(JSContext *);
+
+  // Store (a duplicate of) the given value and return its handle
+  jlong add(JSValueConst);
+
+  // Store (a duplicate of) the given value together with a C++ instance kept alive by
+  // cppPtrOwner and return its handle
+  jlong add(JSValueConst, void *cppPtr, JSValueConst cppPtrOwner);
+
+  // Return (a duplicate of) the value stored with the given handle
+  JSValue get(jlong handle) const;
+
+  // Call the given function with each stored value and the owner of its C++ instance (or
+  // JS_UNDEFINED), e.g. to report the references held by the table
+  void forEach(const std::function<void(jlong handle, JSValueConst value, JSValueConst cppPtrOwner)> &) const;
+#endif
+
+  ~JsValueTable();
+
+  // Release the value stored with the given handle (no-op if the handle is stale)
+  void remove(jlong handle);
+
+  // Return the C++ instance bound to the given handle (nullptr if there is none)
+  template <class T>
+  T *getCppPtr(jlong handle) const {
+    return static_cast<T *>(m_slots[getSlotIndex(handle)].cppPtr);
+  }
+
+  size_t size() const { return m_slots.size() - m_freeSlots.size(); }
+
+  // Release the free slots at the end of the table (e.g. on memory pressure). The new slots then
+  // start with a higher generation so that the stale handles of the released ones stay invalid.
+  void compact();
+
+private:
+  struct Slot {
+    uint32_t generation = 1;
+    bool isUsed = false;
+    void *cppPtr = nullptr;
+#if defined(QUICKJS)
+    JSValue value = JS_UNDEFINED;
+    JSValue cppPtrOwner = JS_UNDEFINED;
+#endif
+  };
+
+  // Get the index of the slot referenced by the handle and return false if the handle is invalid
+  bool findSlotIndex(jlong handle, uint32_t &slotIndex) const;
+
+  // Return the index of the slot referenced by the handle or throw if the handle is invalid
+  uint32_t getSlotIndex(jlong handle) const;
+
+  // Return the index of a new or recycled slot and mark it as used
+  uint32_t acquireSlot();
+
+#if defined(DUKTAPE)
+  duk_context *m_ctx;
+#elif defined(QUICKJS)
+  JSContext *m_ctx;
+#endif
+
+  std::vector<Slot> m_slots;
+  std::vector<uint32_t> m_freeSlots;
+  uint32_t m_newSlotGeneration = 1;
+};
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsWrapperCache.h"
+
+#include "JniCache.h"
+#include "JsBridgeContext.h"
+#include "QuickJsUtils.h"
+#include "jni-helpers/JniContext.h"
+
+namespace {
+  const char CACHE_REGISTRATION_KEY[] = "js_wrapper_cache";
+}
+
+JsWrapperCache::Registration::~Registration() {
+  m_cache->remove(m_identityHashCode, m_jsWrapperPtr);
+}
+
+JsWrapperCache::JsWrapperCache(const JsBridgeContext *jsBridgeContext)
+ : m_jsBridgeContext(jsBridgeContext) {
+}
+
+JSValue JsWrapperCache::getOrCreate(const JniLocalRef<jobject> &javaObject, const void *kind, const CreateWrapper &createWrapper) {
+  JSContext *ctx = m_jsBridgeContext->getQuickJsContext();
+  JNIEnv *env = m_jsBridgeContext->getJniContext()->getJNIEnv();
+
+  const jint identityHashCode = m_jsBridgeContext->getJniCache()->getIdentityHashCode(javaObject);
+
+  auto range = m_entries.equal_range(identityHashCode);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second.kind == kind && env->IsSameObject(it->second.javaObject, javaObject.get())) {
+      return JS_DupValue(ctx, JS_MKPTR(JS_TAG_OBJECT, it->second.jsWrapperPtr));
+    }
+  }
+
+  jobject javaObjectGlobalRef = nullptr;
+  JSValue jsWrapper = createWrapper(&javaObjectGlobalRef);
+  if (!JS_IsObject(jsWrapper) || javaObjectGlobalRef == nullptr) {
+    return jsWrapper;
+  }
+
+  void *jsWrapperPtr = JS_VALUE_GET_PTR(jsWrapper);
+  m_entries.emplace(identityHashCode, Entry { javaObjectGlobalRef, kind, jsWrapperPtr });
+  m_jsBridgeContext->getUtils()->createMappedCppPtrValue(new Registration(this, identityHashCode, jsWrapperPtr), jsWrapper, CACHE_REGISTRATION_KEY);
+
+  return jsWrapper;
+}
+
+void JsWrapperCache::remove(jint identityHashCode, void *jsWrapperPtr) {
+  auto range = m_entries.equal_range(identityHashCode);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second.jsWrapperPtr == jsWrapperPtr) {
+      m_entries.erase(it);
+      return;
+    }
+  }
+}
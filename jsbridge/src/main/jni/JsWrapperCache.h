@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSWRAPPERCACHE_H
+#define _JSBRIDGE_JSWRAPPERCACHE_H
+
+#include "jni-helpers/JniLocalRef.h"
+#include "quickjs/quickjs.h"
+#include <functional>
+#include <jni.h>
+#include <unordered_map>
+
+class JsBridgeContext;
+
+// Identity map of the JS wrappers created for Java objects given to JS (e.g. JavaObjectWrapper
+// instances converted via Object::fromJava() or Kotlin lambdas converted via FunctionX::fromJava()),
+// so that the same Java object always gets the same JS wrapper: no new JNI global ref on each
+// conversion and a stable identity in JS.
+//
+// Notes:
+// - the cache keeps neither the Java object nor the JS wrapper alive (weak map)
+// - the key is the identity hash code of the Java object and the candidates are compared with
+//   the global ref already held by the JS wrapper (i.e. no additional weak global ref)
+// - wrappers of different kinds (e.g. the same lambda converted with different signatures) are
+//   distinguished by an opaque kind pointer which must stay valid while its wrappers are alive
+// - an entry is removed when its JS wrapper gets finalized via a C++ wrapper mapped in the JS
+//   wrapper itself
+// - must only be used from the JS thread
+class JsWrapperCache {
+
+public:
+  // Create a new JS wrapper and set its global ref to the wrapped Java object
+  typedef std::function<JSValue(jobject *pJavaObjectGlobalRef)> CreateWrapper;
+
+  explicit JsWrapperCache(const JsBridgeContext *);
+  JsWrapperCache(const JsWrapperCache &) = delete;
+  JsWrapperCache &operator=(const JsWrapperCache &) = delete;
+
+  // Must be destroyed after the JS runtime (the last wrappers are finalized by JS_FreeRuntime())
+  ~JsWrapperCache() = default;
+
+  // Return the (duplicated) JS wrapper of the given kind for the given Java object, calling
+  // createWrapper() and caching its result if there is none
+  JSValue getOrCreate(const JniLocalRef<jobject> &javaObject, const void *kind, const CreateWrapper &createWrapper);
+
+  // Mapped in the JS wrapper: remove the entry when the wrapper gets finalized
+  class Registration {
+  public:
+    Registration(JsWrapperCache *cache, jint identityHashCode, void *jsWrapperPtr)
+     : m_cache(cache), m_identityHashCode(identityHashCode), m_jsWrapperPtr(jsWrapperPtr) {}
+    ~Registration();
+
+  private:
+    JsWrapperCache *m_cache;
+    jint m_identityHashCode;
+    void *m_jsWrapperPtr;
+  };
+
+private:
+  struct Entry {
+    jobject javaObject;  // global ref owned by the JS wrapper
+    const void *kind;
+    void *jsWrapperPtr;  // not ref-counted
+  };
+
+  void remove(jint identityHashCode, void *jsWrapperPtr);
+
+  const JsBridgeContext *m_jsBridgeContext;
+  std::unordered_multimap<jint, Entry> m_entries;
+};
+
+#endif
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "JsonUtils.h"
+
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+  void appendEscapedCodeUnit(std::string &json, uint32_t codeUnit) {
+    char escaped[8];
+    snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(codeUnit));
+    json += escaped;
+  }
+
+  // Decode the UTF-8 sequence at the given position and return its length, or 0 if invalid
+  size_t decodeUtf8(const unsigned char *p, size_t remaining, uint32_t *pCodePoint) {
+    size_t length;
+    uint32_t codePoint;
+
+    if ((p[0] & 0xe0u) == 0xc0u) {
+      length = 2;
+      codePoint = p[0] & 0x1fu;
+    } else if ((p[0] & 0xf0u) == 0xe0u) {
+      length = 3;
+      codePoint = p[0] & 0x0fu;
+    } else if ((p[0] & 0xf8u) == 0xf0u) {
+      length = 4;
+      codePoint = p[0] & 0x07u;
+    } else {
+      return 0;
+    }
+
+    if (length > remaining) {
+      return 0;
+    }
+
+    for (size_t i = 1; i < length; ++i) {
+      if ((p[i] & 0xc0u) != 0x80u) {
+        return 0;
+      }
+      codePoint = (codePoint << 6) | (p[i] & 0x3fu);
+    }
+
+    *pCodePoint = codePoint;
+    return length;
+  }
+}
+
+namespace JsonUtils {
+  void appendString(std::string &json, const char *str, size_t length) {
+    const auto *p = reinterpret_cast<const unsigned char *>(str);
+    const unsigned char *end = p + length;
+
+    json += '"';
+    while (p < end) {
+      const unsigned char c = *p;
+
+      if (c < 0x80u) {
+        switch (c) {
+          case '"': json += "\\\""; break;
+          case '\\': json += "\\\\"; break;
+          case '\n': json += "\\n"; break;
+          case '\r': json += "\\r"; break;
+          case '\t': json += "\\t"; break;
+          default:
+            if (c < 0x20u) {
+              appendEscapedCodeUnit(json, c);
+            } else {
+              json += static_cast<char>(c);
+            }
+        }
+        ++p;
+        continue;
+      }
+
+      uint32_t codePoint = 0;
+      size_t sequenceLength = decodeUtf8(p, static_cast<size_t>(end - p), &codePoint);
+      if (sequenceLength == 0) {
+        appendEscapedCodeUnit(json, 0xfffdu);
+        ++p;
+        continue;
+      }
+
+      if (codePoint >= 0x10000u) {
+        // UTF-16 surrogate pair (CESU-8 strings already contain them as 2 separate sequences)
+        codePoint -= 0x10000u;
+        appendEscapedCodeUnit(json, 0xd800u + (codePoint >> 10));
+        appendEscapedCodeUnit(json, 0xdc00u + (codePoint & 0x3ffu));
+      } else {
+        appendEscapedCodeUnit(json, codePoint);
+      }
+      p += sequenceLength;
+    }
+    json += '"';
+  }
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSONUTILS_H
+#define _JSBRIDGE_JSONUTILS_H
+
+#include <string>
+
+namespace JsonUtils {
+  // Append the given UTF-8 (or CESU-8) string as a quoted JSON string
+  //
+  // The output is pure ASCII (non-ASCII characters are escaped) so that it can safely be given
+  // to JNI's NewStringUTF(). Invalid UTF-8 bytes are replaced with U+FFFD.
+  void appendString(std::string &json, const char *str, size_t length);
+
+  inline void appendString(std::string &json, const std::string &str) {
+    appendString(json, str.data(), str.size());
+  }
+}
+
+#endif
@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "LocalStorage.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iterator>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  const char MAGIC[] = "JSBLS001";
+  const size_t HEADER_SIZE = sizeof(MAGIC) - 1;
+  const size_t RECORD_OVERHEAD = 2 * sizeof(uint32_t) + 1;  // lengths + op
+  const size_t INITIAL_CAPACITY = 64 * 1024;
+
+  std::mutex registryMutex;
+  std::unordered_map<std::string, std::weak_ptr<LocalStorage>> registry;
+
+  std::runtime_error fileError(const std::string &strMessage, const std::string &strFilePath) {
+    return std::runtime_error(strMessage + " " + strFilePath + ": " + strerror(errno));
+  }
+}
+
+// static
+std::shared_ptr<LocalStorage> LocalStorage::open(const std::string &strFilePath) {
+  std::lock_guard<std::mutex> lock(registryMutex);
+
+  std::shared_ptr<LocalStorage> localStorage = registry[strFilePath].lock();
+  if (!localStorage) {
+    localStorage = std::shared_ptr<LocalStorage>(new LocalStorage(strFilePath));
+    localStorage->load();
+    registry[strFilePath] = localStorage;
+  }
+  return localStorage;
+}
+
+LocalStorage::LocalStorage(std::string strFilePath)
+ : m_strFilePath(std::move(strFilePath)) {
+}
+
+LocalStorage::~LocalStorage() {
+  // The mapped pages are written back by the kernel
+  unmap();
+}
+
+bool LocalStorage::getItem(const std::string &key, std::string *pValue) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto it = m_items.find(key);
+  if (it == m_items.end()) {
+    return false;
+  }
+
+  *pValue = it->second;
+  return true;
+}
+
+void LocalStorage::setItem(const std::string &key, const std::string &value) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto it = m_items.find(key);
+  if (it != m_items.end() && it->second == value) {
+    // Unchanged
+    return;
+  }
+
+  // Only update the items once the change has been persisted
+  appendRecord(Op::Set, key, value);
+
+  if (it == m_items.end()) {
+    m_items.emplace(key, value);
+    m_itemsSize += key.size() + value.size();
+  } else {
+    m_itemsSize += value.size() - it->second.size();
+    it->second = value;
+  }
+}
+
+void LocalStorage::removeItem(const std::string &key) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto it = m_items.find(key);
+  if (it == m_items.end()) {
+    return;
+  }
+
+  appendRecord(Op::Remove, key, std::string());
+
+  m_itemsSize -= it->first.size() + it->second.size();
+  m_items.erase(it);
+}
+
+void LocalStorage::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_items.empty()) {
+    return;
+  }
+
+  appendRecord(Op::Clear, std::string(), std::string());
+
+  m_items.clear();
+  m_itemsSize = 0;
+}
+
+size_t LocalStorage::length() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_items.size();
+}
+
+bool LocalStorage::key(size_t index, std::string *pKey) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (index >= m_items.size()) {
+    return false;
+  }
+
+  *pKey = std::next(m_items.begin(), static_cast<std::ptrdiff_t>(index))->first;
+  return true;
+}
+
+void LocalStorage::load() {
+  int fd = ::open(m_strFilePath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    throw fileError("Cannot open local storage file", m_strFilePath);
+  }
+
+  struct stat fileStat {};
+  if (fstat(fd, &fileStat) != 0) {
+    ::close(fd);
+    throw fileError("Cannot read local storage file", m_strFilePath);
+  }
+
+  auto fileSize = static_cast<size_t>(fileStat.st_size);
+  size_t capacity = std::max(fileSize, INITIAL_CAPACITY);
+  if (capacity > fileSize && ftruncate(fd, static_cast<off_t>(capacity)) != 0) {
+    ::close(fd);
+    throw fileError("Cannot resize local storage file", m_strFilePath);
+  }
+
+  map(fd, capacity);
+
+  if (fileSize < HEADER_SIZE || memcmp(m_data, MAGIC, HEADER_SIZE) != 0) {
+    // New (or unknown) file
+    memset(m_data, 0, m_capacity);
+    memcpy(m_data, MAGIC, HEADER_SIZE);
+    m_writeOffset = HEADER_SIZE;
+    return;
+  }
+
+  // Replay the log
+  size_t offset = HEADER_SIZE;
+  while (offset + RECORD_OVERHEAD <= m_capacity) {
+    uint32_t keyLength, valueLength;
+    memcpy(&keyLength, m_data + offset, sizeof(uint32_t));
+    memcpy(&valueLength, m_data + offset + sizeof(uint32_t), sizeof(uint32_t));
+
+    size_t recordSize = RECORD_OVERHEAD + static_cast<size_t>(keyLength) + static_cast<size_t>(valueLength);
+    if (recordSize > m_capacity - offset) {
+      break;
+    }
+
+    auto op = static_cast<Op>(m_data[offset + recordSize - 1]);
+    if (op != Op::Set && op != Op::Remove && op != Op::Clear) {
+      // End of the log (or torn record)
+      break;
+    }
+
+    const char *keyData = reinterpret_cast<const char *>(m_data + offset + 2 * sizeof(uint32_t));
+    std::string key(keyData, keyLength);
+
+    switch (op) {
+      case Op::Set:
+        m_items[key] = std::string(keyData + keyLength, valueLength);
+        break;
+      case Op::Remove:
+        m_items.erase(key);
+        break;
+      default:
+        m_items.clear();
+        break;
+    }
+
+    offset += recordSize;
+  }
+
+  m_itemsSize = 0;
+  for (const auto &item : m_items) {
+    m_itemsSize += item.first.size() + item.second.size();
+  }
+
+  // Erase a torn record so that it cannot be mixed up with the next appended ones
+  memset(m_data + offset, 0, m_capacity - offset);
+  m_writeOffset = offset;
+}
+
+void LocalStorage::map(int fd, size_t capacity) {
+  void *data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    ::close(fd);
+    throw fileError("Cannot map local storage file", m_strFilePath);
+  }
+
+  unmap();
+  m_fd = fd;
+  m_data = static_cast<uint8_t *>(data);
+  m_capacity = capacity;
+}
+
+void LocalStorage::unmap() {
+  if (m_data != nullptr) {
+    munmap(m_data, m_capacity);
+    m_data = nullptr;
+    m_capacity = 0;
+  }
+
+  if (m_fd >= 0) {
+    ::close(m_fd);
+    m_fd = -1;
+  }
+}
+
+void LocalStorage::appendRecord(Op op, const std::string &key, const std::string &value) {
+  size_t recordSize = RECORD_OVERHEAD + key.size() + value.size();
+  if (recordSize > m_capacity - m_writeOffset) {
+    // The record is appended to the compacted log (which does not contain the change yet)
+    compact(recordSize);
+  }
+
+  m_writeOffset += writeRecord(m_data + m_writeOffset, op, key, value);
+}
+
+// static
+size_t LocalStorage::writeRecord(uint8_t *p, Op op, const std::string &key, const std::string &value) {
+  auto keyLength = static_cast<uint32_t>(key.size());
+  auto valueLength = static_cast<uint32_t>(value.size());
+
+  memcpy(p, &keyLength, sizeof(uint32_t));
+  p += sizeof(uint32_t);
+  memcpy(p, &valueLength, sizeof(uint32_t));
+  p += sizeof(uint32_t);
+  memcpy(p, key.data(), key.size());
+  p += key.size();
+  memcpy(p, value.data(), value.size());
+  p += value.size();
+
+  // Written last: the record is only valid once complete
+  *p = static_cast<uint8_t>(op);
+
+  return RECORD_OVERHEAD + key.size() + value.size();
+}
+
+void LocalStorage::compact(size_t extraSize) {
+  // Rewrite the current items into a new file (with at least as much free space and room for
+  // extraSize more bytes) which atomically replaces the old one. The current mapping is kept until
+  // the new file has replaced the old one so that a failure leaves the storage unchanged.
+  size_t liveSize = HEADER_SIZE + m_items.size() * RECORD_OVERHEAD + m_itemsSize;
+  size_t capacity = INITIAL_CAPACITY;
+  while (capacity < 2 * liveSize + extraSize) {
+    capacity *= 2;
+  }
+
+  std::string strTempFilePath = m_strFilePath + ".tmp";
+  int fd = ::open(strTempFilePath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    throw fileError("Cannot create local storage file", strTempFilePath);
+  }
+
+  auto discardTempFile = [&](const std::string &strMessage, const std::string &strFilePath) {
+    std::runtime_error error = fileError(strMessage, strFilePath);
+    ::close(fd);
+    unlink(strTempFilePath.c_str());
+    return error;
+  };
+
+  if (ftruncate(fd, static_cast<off_t>(capacity)) != 0) {
+    throw discardTempFile("Cannot resize local storage file", strTempFilePath);
+  }
+
+  void *mappedData = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mappedData == MAP_FAILED) {
+    throw discardTempFile("Cannot map local storage file", strTempFilePath);
+  }
+  auto data = static_cast<uint8_t *>(mappedData);
+
+  memcpy(data, MAGIC, HEADER_SIZE);
+  size_t writeOffset = HEADER_SIZE;
+  for (const auto &item : m_items) {
+    writeOffset += writeRecord(data + writeOffset, Op::Set, item.first, item.second);
+  }
+
+  msync(data, writeOffset, MS_SYNC);
+  if (rename(strTempFilePath.c_str(), m_strFilePath.c_str()) != 0) {
+    munmap(data, capacity);
+    throw discardTempFile("Cannot replace local storage file", m_strFilePath);
+  }
+
+  unmap();
+  m_fd = fd;
+  m_data = data;
+  m_capacity = capacity;
+  m_writeOffset = writeOffset;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_LOCALSTORAGE_H
+#define _JSBRIDGE_LOCALSTORAGE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// String key/value store backing the JS localStorage object
+//
+// The items are kept in a hash map and each change is appended to a memory-mapped log file, which
+// is written back to disk asynchronously by the kernel. The log is replayed when the storage is
+// opened and compacted (rewritten with the current items only) when it runs out of space.
+//
+// Log format: magic header followed by records
+//   [uint32 keyLength][uint32 valueLength][key][value][uint8 op]
+// The op byte is written last so that a torn record (op 0) ends the log.
+//
+// There is a single (thread-safe) instance per file which is shared by all the JsBridge instances
+// using it.
+class LocalStorage {
+
+public:
+  // Note: throws std::runtime_error if the file cannot be opened
+  static std::shared_ptr<LocalStorage> open(const std::string &strFilePath);
+
+  LocalStorage(const LocalStorage &) = delete;
+  LocalStorage &operator=(const LocalStorage &) = delete;
+  ~LocalStorage();
+
+  // Return false if the key does not exist
+  bool getItem(const std::string &key, std::string *pValue) const;
+  // Note: the changes throw std::runtime_error (leaving the items unchanged) if they cannot be
+  // persisted
+  void setItem(const std::string &key, const std::string &value);
+  void removeItem(const std::string &key);
+  void clear();
+
+  size_t length() const;
+  // Return false if index >= length()
+  bool key(size_t index, std::string *pKey) const;
+
+private:
+  enum class Op : uint8_t {
+    None = 0,
+    Set = 1,
+    Remove = 2,
+    Clear = 3,
+  };
+
+  explicit LocalStorage(std::string strFilePath);
+
+  void load();
+  void map(int fd, size_t capacity);
+  void unmap();
+  void appendRecord(Op op, const std::string &key, const std::string &value);
+  // Return the record size
+  static size_t writeRecord(uint8_t *p, Op op, const std::string &key, const std::string &value);
+  // Note: throws std::runtime_error (leaving the current log unchanged) if the new file cannot be
+  // written
+  void compact(size_t extraSize);
+
+  const std::string m_strFilePath;
+  mutable std::mutex m_mutex;
+  std::unordered_map<std::string, std::string> m_items;
+  size_t m_itemsSize = 0;  // sum of the key and value sizes
+
+  int m_fd = -1;
+  uint8_t *m_data = nullptr;  // mapped log
+  size_t m_capacity = 0;
+  size_t m_writeOffset = 0;
+};
+
+#endif
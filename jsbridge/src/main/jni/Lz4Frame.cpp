@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Lz4Frame.h"
+
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+  const uint32_t FRAME_MAGIC = 0x184D2204u;
+  const uint32_t SKIPPABLE_FRAME_MAGIC = 0x184D2A50u;  // 0x184D2A50 - 0x184D2A5F
+  const uint32_t SKIPPABLE_FRAME_MAGIC_MASK = 0xFFFFFFF0u;
+  const uint32_t UNCOMPRESSED_BLOCK_FLAG = 0x80000000u;
+  const size_t MIN_MATCH_LENGTH = 4;
+
+  // FLG byte of the frame descriptor
+  const uint8_t FLG_VERSION_MASK = 0xC0;
+  const uint8_t FLG_VERSION = 0x40;
+  const uint8_t FLG_BLOCK_CHECKSUM = 0x10;
+  const uint8_t FLG_CONTENT_SIZE = 0x08;
+  const uint8_t FLG_CONTENT_CHECKSUM = 0x04;
+  const uint8_t FLG_DICT_ID = 0x01;
+
+  inline uint32_t readLE32(const uint8_t *p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+  }
+
+  inline uint64_t readLE64(const uint8_t *p) {
+    return static_cast<uint64_t>(readLE32(p)) | (static_cast<uint64_t>(readLE32(p + 4)) << 32);
+  }
+
+  [[noreturn]] void throwInvalidFrame(const char *reason) {
+    throw std::invalid_argument(std::string("Invalid LZ4 frame: ") + reason);
+  }
+
+  // Read the extra bytes of a literal or match length (when its 4-bit token value is 15)
+  size_t readExtraLength(const uint8_t *&ip, const uint8_t *end) {
+    size_t length = 0;
+    uint8_t b;
+    do {
+      if (ip >= end) {
+        throwInvalidFrame("truncated block");
+      }
+      b = *ip++;
+      length += b;
+    } while (b == 255);
+    return length;
+  }
+
+  // Decompress an LZ4 block at dst + pos (the previous output being usable by the matches of
+  // linked blocks) and return the new position
+  size_t decompressBlock(const uint8_t *ip, size_t blockSize, uint8_t *dst, size_t pos, size_t capacity) {
+    const uint8_t *end = ip + blockSize;
+
+    while (ip < end) {
+      const uint8_t token = *ip++;
+
+      size_t literalLength = token >> 4;
+      if (literalLength == 15) {
+        literalLength += readExtraLength(ip, end);
+      }
+      if (literalLength > static_cast<size_t>(end - ip) || literalLength > capacity - pos) {
+        throwInvalidFrame("literals out of bounds");
+      }
+      memcpy(dst + pos, ip, literalLength);
+      ip += literalLength;
+      pos += literalLength;
+
+      if (ip == end) {
+        // The last sequence only contains literals
+        break;
+      }
+
+      if (end - ip < 2) {
+        throwInvalidFrame("truncated block");
+      }
+      const size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+      ip += 2;
+      if (offset == 0 || offset > pos) {
+        throwInvalidFrame("match offset out of bounds");
+      }
+
+      size_t matchLength = token & 0x0f;
+      if (matchLength == 15) {
+        matchLength += readExtraLength(ip, end);
+      }
+      matchLength += MIN_MATCH_LENGTH;
+      if (matchLength > capacity - pos) {
+        throwInvalidFrame("match out of bounds");
+      }
+
+      const uint8_t *match = dst + pos - offset;
+      if (offset >= matchLength) {
+        memcpy(dst + pos, match, matchLength);
+      } else {
+        // Overlapping match (e.g. a repeated pattern)
+        for (size_t i = 0; i < matchLength; ++i) {
+          dst[pos + i] = match[i];
+        }
+      }
+      pos += matchLength;
+    }
+
+    return pos;
+  }
+}
+
+namespace Lz4Frame {
+
+MappedBuffer::~MappedBuffer() {
+  if (m_data != nullptr) {
+    munmap(m_data, m_capacity);
+  }
+}
+
+MappedBuffer::MappedBuffer(MappedBuffer &&other) noexcept
+ : m_data(std::exchange(other.m_data, nullptr))
+ , m_size(std::exchange(other.m_size, 0))
+ , m_capacity(std::exchange(other.m_capacity, 0)) {
+}
+
+MappedBuffer &MappedBuffer::operator=(MappedBuffer &&other) noexcept {
+  if (this != &other) {
+    if (m_data != nullptr) {
+      munmap(m_data, m_capacity);
+    }
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+    m_capacity = std::exchange(other.m_capacity, 0);
+  }
+  return *this;
+}
+
+void MappedBuffer::reserve(size_t capacity) {
+  if (capacity <= m_capacity) {
+    return;
+  }
+
+  const auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  capacity = (capacity + pageSize - 1) / pageSize * pageSize;
+
+  void *p = m_data == nullptr
+      ? mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)
+      : mremap(m_data, m_capacity, capacity, MREMAP_MAYMOVE);
+  if (p == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+
+  m_data = static_cast<uint8_t *>(p);
+  m_capacity = capacity;
+}
+
+bool isFrame(const uint8_t *data, size_t size) {
+  return size >= 4 && readLE32(data) == FRAME_MAGIC;
+}
+
+MappedBuffer decompress(const uint8_t *data, size_t size) {
+  MappedBuffer buffer;
+  const uint8_t *ip = data;
+  const uint8_t *end = data + size;
+
+  // Concatenated frames are decompressed one after the other
+  while (ip < end) {
+    if (end - ip < 4) {
+      throwInvalidFrame("truncated header");
+    }
+
+    const uint32_t magic = readLE32(ip);
+    if ((magic & SKIPPABLE_FRAME_MAGIC_MASK) == SKIPPABLE_FRAME_MAGIC) {
+      if (end - ip < 8 || readLE32(ip + 4) > static_cast<size_t>(end - ip - 8)) {
+        throwInvalidFrame("truncated skippable frame");
+      }
+      ip += 8 + readLE32(ip + 4);
+      continue;
+    }
+    if (magic != FRAME_MAGIC) {
+      throwInvalidFrame("bad magic number");
+    }
+    ip += 4;
+
+    // Frame descriptor: FLG, BD, [content size], [dictionary id], header checksum
+    if (end - ip < 3) {
+      throwInvalidFrame("truncated header");
+    }
+    const uint8_t flg = ip[0];
+    const uint8_t bd = ip[1];
+    ip += 2;
+
+    if ((flg & FLG_VERSION_MASK) != FLG_VERSION) {
+      throwInvalidFrame("unsupported version");
+    }
+    if ((flg & FLG_DICT_ID) != 0) {
+      throwInvalidFrame("dictionaries are not supported");
+    }
+
+    const int blockSizeId = (bd >> 4) & 0x07;
+    if (blockSizeId < 4) {
+      throwInvalidFrame("bad block maximum size");
+    }
+    const size_t maxBlockSize = size_t(1) << (8 + 2 * blockSizeId);  // 64 KB - 4 MB
+
+    if ((flg & FLG_CONTENT_SIZE) != 0) {
+      if (end - ip < 9) {
+        throwInvalidFrame("truncated header");
+      }
+      // The whole content is mapped at once
+      const uint64_t contentSize = readLE64(ip);
+      if (contentSize > SIZE_MAX - buffer.m_size) {
+        throwInvalidFrame("content too large");
+      }
+      buffer.reserve(buffer.m_size + static_cast<size_t>(contentSize));
+      ip += 8;
+    }
+    ++ip;  // header checksum
+
+    // Data blocks until the end mark
+    for (;;) {
+      if (end - ip < 4) {
+        throwInvalidFrame("truncated block");
+      }
+      const uint32_t blockHeader = readLE32(ip);
+      ip += 4;
+      if (blockHeader == 0) {
+        break;
+      }
+
+      const size_t blockSize = blockHeader & ~UNCOMPRESSED_BLOCK_FLAG;
+      if (blockSize > maxBlockSize || blockSize > static_cast<size_t>(end - ip)) {
+        throwInvalidFrame("bad block size");
+      }
+
+      buffer.reserve(buffer.m_size + maxBlockSize);
+      if ((blockHeader & UNCOMPRESSED_BLOCK_FLAG) != 0) {
+        memcpy(buffer.m_data + buffer.m_size, ip, blockSize);
+        buffer.m_size += blockSize;
+      } else {
+        buffer.m_size = decompressBlock(ip, blockSize, buffer.m_data, buffer.m_size, buffer.m_capacity);
+      }
+      ip += blockSize;
+
+      if ((flg & FLG_BLOCK_CHECKSUM) != 0) {
+        if (end - ip < 4) {
+          throwInvalidFrame("truncated block checksum");
+        }
+        ip += 4;
+      }
+    }
+
+    if ((flg & FLG_CONTENT_CHECKSUM) != 0) {
+      if (end - ip < 4) {
+        throwInvalidFrame("truncated content checksum");
+      }
+      ip += 4;
+    }
+  }
+
+  return buffer;
+}
+
+}  // namespace Lz4Frame
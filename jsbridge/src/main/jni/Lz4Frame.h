@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_LZ4FRAME_H
+#define _JSBRIDGE_LZ4FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Decompression of LZ4 frames (as written by the lz4 command-line tool) into an anonymous memory
+// mapping, e.g. for compressed bytecode assets whose bytecode is then directly read from the
+// mapped pages instead of a heap copy.
+//
+// Linked and independent blocks are supported, dictionaries are not. The header, block and
+// content checksums are skipped without being verified.
+namespace Lz4Frame {
+
+  // Anonymous memory mapping holding the decompressed data (unmapped on destruction)
+  class MappedBuffer {
+
+  public:
+    MappedBuffer() = default;
+    ~MappedBuffer();
+
+    MappedBuffer(MappedBuffer &&) noexcept;
+    MappedBuffer &operator=(MappedBuffer &&) noexcept;
+    MappedBuffer(const MappedBuffer &) = delete;
+    MappedBuffer &operator=(const MappedBuffer &) = delete;
+
+    const uint8_t *data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+  private:
+    friend MappedBuffer decompress(const uint8_t *, size_t);
+
+    // Grow the mapping (which may move) to at least the given capacity
+    void reserve(size_t capacity);
+
+    uint8_t *m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_capacity = 0;
+  };
+
+  // Return true if the given data starts with the magic number of an LZ4 frame
+  bool isFrame(const uint8_t *data, size_t size);
+
+  // Decompress the given LZ4 frame(s)
+  // Throws std::invalid_argument if the data is not a valid (and supported) LZ4 frame.
+  MappedBuffer decompress(const uint8_t *data, size_t size);
+}
+
+#endif
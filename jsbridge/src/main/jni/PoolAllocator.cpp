@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "PoolAllocator.h"
+
+#include "AllocationStats.h"
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+#include <unordered_set>
+
+PoolAllocator::~PoolAllocator() {
+  // Bulk release of all the pooled blocks
+  for (const auto &chunkEntry : m_chunkSizeClasses) {
+    free(reinterpret_cast<void *>(chunkEntry.first));
+  }
+}
+
+void *PoolAllocator::allocate(size_t size) {
+  JSBRIDGE_COUNT_ALLOCATION(JsEngineAllocations);
+
+  if (size > MAX_POOLED_SIZE) {
+    if (exceedsMemoryLimit(size)) {
+      return nullptr;
+    }
+
+    void *ptr = malloc(size);
+    if (ptr == nullptr) {
+      return nullptr;
+    }
+
+    m_allocationCount++;
+    m_allocatedSize += malloc_usable_size(ptr);
+    return ptr;
+  }
+
+  const size_t sizeClassIndex = size == 0 ? 0 : (size - 1) / SIZE_CLASS_GRANULARITY;
+  const size_t blockSize = getBlockSize(sizeClassIndex);
+
+  if (exceedsMemoryLimit(blockSize)) {
+    return nullptr;
+  }
+
+  SizeClass &sizeClass = m_sizeClasses[sizeClassIndex];
+  void *ptr;
+
+  if (sizeClass.freeList != nullptr) {
+    ptr = sizeClass.freeList;
+    sizeClass.freeList = sizeClass.freeList->next;
+  } else {
+    if (sizeClass.chunkPtr == nullptr || sizeClass.chunkPtr + blockSize > sizeClass.chunkEnd) {
+      if (!addChunk(sizeClassIndex)) {
+        return nullptr;
+      }
+    }
+
+    ptr = sizeClass.chunkPtr;
+    sizeClass.chunkPtr += blockSize;
+  }
+
+  m_allocationCount++;
+  m_allocatedSize += blockSize;
+  return ptr;
+}
+
+void PoolAllocator::deallocate(void *ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+
+  const int sizeClassIndex = getSizeClassIndex(ptr);
+  m_allocationCount--;
+
+  if (sizeClassIndex < 0) {
+    m_allocatedSize -= malloc_usable_size(ptr);
+    free(ptr);
+    return;
+  }
+
+  m_allocatedSize -= getBlockSize(sizeClassIndex);
+
+  SizeClass &sizeClass = m_sizeClasses[sizeClassIndex];
+  auto freeBlock = static_cast<FreeBlock *>(ptr);
+  freeBlock->next = sizeClass.freeList;
+  sizeClass.freeList = freeBlock;
+}
+
+void *PoolAllocator::reallocate(void *ptr, size_t size) {
+  if (ptr == nullptr) {
+    return size == 0 ? nullptr : allocate(size);
+  }
+
+  if (size == 0) {
+    deallocate(ptr);
+    return nullptr;
+  }
+
+  const int sizeClassIndex = getSizeClassIndex(ptr);
+
+  if (sizeClassIndex < 0) {
+    const size_t oldSize = malloc_usable_size(ptr);
+
+    if (size > MAX_POOLED_SIZE) {
+      // malloc() block which stays a malloc() block
+      if (size > oldSize && exceedsMemoryLimit(size - oldSize)) {
+        return nullptr;
+      }
+
+      void *newPtr = realloc(ptr, size);
+      if (newPtr == nullptr) {
+        return nullptr;
+      }
+
+      m_allocatedSize = m_allocatedSize - oldSize + malloc_usable_size(newPtr);
+      return newPtr;
+    }
+
+    void *newPtr = allocate(size);
+    if (newPtr == nullptr) {
+      return nullptr;
+    }
+
+    memcpy(newPtr, ptr, size);
+    deallocate(ptr);
+    return newPtr;
+  }
+
+  const size_t oldSize = getBlockSize(sizeClassIndex);
+  if (size <= oldSize) {
+    // Still fits into the same block
+    return ptr;
+  }
+
+  void *newPtr = allocate(size);
+  if (newPtr == nullptr) {
+    return nullptr;
+  }
+
+  memcpy(newPtr, ptr, oldSize);
+  deallocate(ptr);
+  return newPtr;
+}
+int PoolAllocator::getSizeClassIndex(const void *ptr) const {
+  auto it = m_chunkSizeClasses.find(getChunkAddress(ptr));
+  return it == m_chunkSizeClasses.end() ? -1 : it->second;
+}
+
+bool PoolAllocator::addChunk(size_t sizeClassIndex) {
+  void *chunk = nullptr;
+  if (posix_memalign(&chunk, CHUNK_SIZE, CHUNK_SIZE) != 0) {
+    return false;
+  }
+
+  m_chunkSizeClasses.emplace(reinterpret_cast<uintptr_t>(chunk), static_cast<uint8_t>(sizeClassIndex));
+
+  // The remaining blocks of the previous chunk (if any) are lost until the allocator is deleted
+  SizeClass &sizeClass = m_sizeClasses[sizeClassIndex];
+  sizeClass.chunkPtr = static_cast<uint8_t *>(chunk);
+  sizeClass.chunkEnd = sizeClass.chunkPtr + CHUNK_SIZE;
+  return true;
+}
+
+size_t PoolAllocator::releaseFreeChunks() {
+  // Count the free blocks of each chunk
+  std::unordered_map<uintptr_t, size_t> freeBlockCounts;
+  for (const SizeClass &sizeClass : m_sizeClasses) {
+    for (const FreeBlock *freeBlock = sizeClass.freeList; freeBlock != nullptr; freeBlock = freeBlock->next) {
+      ++freeBlockCounts[getChunkAddress(freeBlock)];
+    }
+  }
+
+  std::unordered_set<uintptr_t> releasedChunks;
+  for (const auto &freeBlockCount : freeBlockCounts) {
+    const uintptr_t chunkAddress = freeBlockCount.first;
+    const size_t sizeClassIndex = m_chunkSizeClasses[chunkAddress];
+    const SizeClass &sizeClass = m_sizeClasses[sizeClassIndex];
+
+    // The current chunk of a size class is kept for the next allocations
+    const bool isCurrentChunk = sizeClass.chunkEnd != nullptr && getChunkAddress(sizeClass.chunkEnd - 1) == chunkAddress;
+    if (!isCurrentChunk && freeBlockCount.second == CHUNK_SIZE / getBlockSize(sizeClassIndex)) {
+      releasedChunks.insert(chunkAddress);
+    }
+  }
+
+  if (releasedChunks.empty()) {
+    return 0;
+  }
+
+  // Unlink the blocks of the released chunks from the free lists
+  for (SizeClass &sizeClass : m_sizeClasses) {
+    FreeBlock **pFreeBlock = &sizeClass.freeList;
+    while (*pFreeBlock != nullptr) {
+      if (releasedChunks.count(getChunkAddress(*pFreeBlock)) != 0) {
+        *pFreeBlock = (*pFreeBlock)->next;
+      } else {
+        pFreeBlock = &(*pFreeBlock)->next;
+      }
+    }
+  }
+
+  for (uintptr_t chunkAddress : releasedChunks) {
+    m_chunkSizeClasses.erase(chunkAddress);
+    free(reinterpret_cast<void *>(chunkAddress));
+  }
+
+  return releasedChunks.size() * CHUNK_SIZE;
+}
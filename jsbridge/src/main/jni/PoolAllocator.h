@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_POOLALLOCATOR_H
+#define _JSBRIDGE_POOLALLOCATOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+// Memory allocator of a JS engine heap (QuickJS runtime or Duktape heap) with its own accounting
+//
+// Small allocations (mostly shapes, objects, property arrays and strings) are served from
+// size-class pools carved out of large chunks, avoiding the per-allocation overhead of malloc().
+// Freed blocks are kept in the free list of their size class and the chunks are only released all
+// at once when the allocator is deleted (after the JS heap has been destroyed) or, when all their
+// blocks are free, via releaseFreeChunks(). Larger allocations are delegated to malloc().
+class PoolAllocator {
+
+public:
+  PoolAllocator() = default;
+  PoolAllocator(const PoolAllocator &) = delete;
+  PoolAllocator &operator=(const PoolAllocator &) = delete;
+
+  ~PoolAllocator();
+
+  // The allocation functions follow the malloc()/free()/realloc() semantics and return nullptr when
+  // the memory limit would be exceeded
+  void *allocate(size_t size);
+  void deallocate(void *ptr);
+  void *reallocate(void *ptr, size_t size);
+
+  // 0: no limit
+  void setMemoryLimit(size_t memoryLimit) { m_memoryLimit = memoryLimit; }
+
+  // Size in bytes of the blocks currently given to the JS engine
+  size_t getAllocatedSize() const { return m_allocatedSize; }
+  size_t getAllocationCount() const { return m_allocationCount; }
+
+  // Give the chunks which only contain free blocks back to the system (e.g. on memory pressure)
+  // and return their total size in bytes
+  size_t releaseFreeChunks();
+
+private:
+  static constexpr size_t CHUNK_SIZE = 64 * 1024;
+  static constexpr size_t SIZE_CLASS_GRANULARITY = 16;
+  static constexpr size_t MAX_POOLED_SIZE = 256;
+  static constexpr size_t SIZE_CLASS_COUNT = MAX_POOLED_SIZE / SIZE_CLASS_GRANULARITY;
+
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  struct SizeClass {
+    FreeBlock *freeList = nullptr;
+    uint8_t *chunkPtr = nullptr;  // next unused block in the current chunk
+    uint8_t *chunkEnd = nullptr;
+  };
+
+  bool exceedsMemoryLimit(size_t additionalSize) const {
+    return m_memoryLimit != 0 && m_allocatedSize + additionalSize > m_memoryLimit;
+  }
+
+  // Return the size class of a pooled block or -1 if it has been allocated via malloc()
+  int getSizeClassIndex(const void *ptr) const;
+  bool addChunk(size_t sizeClassIndex);
+
+  // Chunks are aligned to their size
+  static uintptr_t getChunkAddress(const void *ptr) { return reinterpret_cast<uintptr_t>(ptr) & ~(uintptr_t(CHUNK_SIZE) - 1); }
+
+  static size_t getBlockSize(size_t sizeClassIndex) { return (sizeClassIndex + 1) * SIZE_CLASS_GRANULARITY; }
+
+  std::array<SizeClass, SIZE_CLASS_COUNT> m_sizeClasses;
+  std::unordered_map<uintptr_t, uint8_t> m_chunkSizeClasses;  // chunk address -> size class index
+  size_t m_memoryLimit = 0;
+  size_t m_allocatedSize = 0;
+  size_t m_allocationCount = 0;
+};
+
+#endif
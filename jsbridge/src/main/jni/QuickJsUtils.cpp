@@ -14,32 +14,170 @@
  * limitations under the License.
  */
 #include "QuickJsUtils.h"
+#include "AutoReleasedJSValue.h"
+#include "JsBridgeContext.h"
+#include "JsRuntime.h"
+#include "ScratchArena.h"
+#include "custom_stringify.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
 
 // static
-JSClassID QuickJsUtils::js_cppwrapper_class_id;
+JSClassID QuickJsUtils::js_javaref_class_id = QuickJsUtils::newClassId();
+// static
+JSClassID QuickJsUtils::js_javaobject_class_id = QuickJsUtils::newClassId();
 
 namespace {
-  void js_cppwrapper_finalizer(JSRuntime *, JSValue val) {
-    auto cppWrapper = reinterpret_cast<QuickJsUtils::CppWrapper *>(JS_GetOpaque(val, QuickJsUtils::js_cppwrapper_class_id));
-    cppWrapper->deleter();
-    delete cppWrapper;
+  void js_javaref_finalizer(JSRuntime *rt, JSValue val) {
+    QuickJsUtils::onJavaRefFinalized(rt, static_cast<jobject>(JS_GetOpaque(val, QuickJsUtils::js_javaref_class_id)));
+  }
+
+  JSClassDef js_javaref_class = {
+      "JAVAREF",
+      .finalizer = js_javaref_finalizer,
+  };
+
+  void js_javaobject_finalizer(JSRuntime *rt, JSValue val) {
+    QuickJsUtils::onJavaRefFinalized(rt, QuickJsUtils::getJavaObjectGlobalRef(val));
   }
 
-  JSClassDef js_cppwrapper_class = {
-      "CPPWRAPPER",
-      .finalizer = js_cppwrapper_finalizer,
+  JSClassDef js_javaobject_class = {
+      "JavaObject",
+      .finalizer = js_javaobject_finalizer,
+  };
+
+  // Indexed by QuickJsUtils::PropertyName
+  const char *PROPERTY_NAMES[] = {
+      "cause",
+      CPP_OBJECT_MAP_PROP_NAME,
+      "__java_exception",
+      "length",
+      "message",
+      "\xff\xff" "promise_type",
+      "reject",
+      "resolve",
+      "stack",
+      "then",
   };
+  static_assert(sizeof(PROPERTY_NAMES) / sizeof(PROPERTY_NAMES[0]) == static_cast<size_t>(QuickJsUtils::PropertyName::_Count));
 }
 
-QuickJsUtils::QuickJsUtils(const JniContext *jniContext, JSContext *ctx)
+QuickJsUtils::QuickJsUtils(const JniContext *jniContext, JSContext *ctx, CppWrapperCounters *counters, ScratchArena *scratchArena)
  : m_jniContext(jniContext)
- , m_ctx(ctx) {
-  // class ID (created once)
-  JS_NewClassID(&js_cppwrapper_class_id);
+ , m_ctx(ctx)
+ , m_runtime(JS_GetRuntime(ctx))
+ , m_counters(counters)
+ , m_scratchArena(scratchArena) {
+  // classes (created once per runtime)
+  JS_NewClass(m_runtime, js_javaref_class_id, &js_javaref_class);
+  JS_NewClass(m_runtime, js_javaobject_class_id, &js_javaobject_class);
+
+  // Default (per-context) prototype of the Java objects without any shared prototype
+  JS_SetClassProto(m_ctx, js_javaobject_class_id, JS_NewObject(m_ctx));
+
+  m_globalObj = JS_GetGlobalObject(m_ctx);
+  m_stashObj = JS_NewObject(m_ctx);
+
+  for (size_t i = 0; i < m_atoms.size(); ++i) {
+    m_atoms[i] = JS_NewAtom(m_ctx, PROPERTY_NAMES[i]);
+  }
+
+  for (size_t keepErrorStack = 0; keepErrorStack < m_jsonErrorReplacers.size(); ++keepErrorStack) {
+    m_jsonErrorReplacers[keepErrorStack] = JS_NewCFunctionMagic(m_ctx, custom_stringify_replace_errors, "replaceErrors", 2,
+                                                                JS_CFUNC_generic_magic, static_cast<int>(keepErrorStack));
+  }
+}
+
+QuickJsUtils::~QuickJsUtils() {
+  m_stringCache.reset();
+
+  for (JSAtom atom : m_atoms) {
+    JS_FreeAtom(m_ctx, atom);
+  }
+
+  for (JSValue replacer : m_jsonErrorReplacers) {
+    JS_FreeValue(m_ctx, replacer);
+  }
+
+  for (auto &it : m_javaObjectPrototypes) {
+    JS_FreeValue(m_ctx, it.second);
+  }
+
+  JS_FreeValue(m_ctx, m_javaErrorPrototype);
+  JS_FreeValue(m_ctx, m_stashObj);
+  JS_FreeValue(m_ctx, m_globalObj);
+}
+
+// static
+JSClassID QuickJsUtils::newClassId() {
+  // JS_NewClassID() is not thread-safe
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
+
+  JSClassID classId = 0;
+  return JS_NewClassID(&classId);
+}
+
+// static
+void QuickJsUtils::onCppWrapperFinalized(JSRuntime *rt) {
+  JsRuntime::getInstance(rt)->getCppWrapperCounters()->cppWrapperCount--;
+}
+
+jobject QuickJsUtils::newJavaRefGlobalRef(jobject object) const {
+  jobject globalRef = m_jniContext->getJNIEnv()->NewGlobalRef(object);
+  m_counters->javaRefGlobalRefCount++;
+  return globalRef;
+}
+
+// static
+void QuickJsUtils::onJavaRefFinalized(JSRuntime *rt, jobject globalRef) {
+  JsRuntime *jsRuntime = JsRuntime::getInstance(rt);
+  CppWrapperCounters *counters = jsRuntime->getCppWrapperCounters();
+  if (globalRef != nullptr) {
+    jsRuntime->getJniContext()->getJNIEnv()->DeleteGlobalRef(globalRef);
+    counters->javaRefGlobalRefCount--;
+  }
+
+  counters->cppWrapperCount--;
+  counters->javaRefCount--;
+}
+
+JSValueConst QuickJsUtils::getJavaObjectPrototype(const std::string &name) const {
+  auto it = m_javaObjectPrototypes.find(name);
+  return it == m_javaObjectPrototypes.end() ? JS_UNDEFINED : it->second;
+}
+
+void QuickJsUtils::setJavaObjectPrototype(const std::string &name, JSValue prototype) {
+  auto it = m_javaObjectPrototypes.find(name);
+  if (it != m_javaObjectPrototypes.end()) {
+    JS_FreeValue(m_ctx, it->second);
+    it->second = prototype;
+    return;
+  }
+
+  m_javaObjectPrototypes.emplace(name, prototype);
+}
+
+JSValue QuickJsUtils::createJavaObjectValue(const JniLocalRef<jobject> &object, JSValueConst prototype) const {
+  JSValue javaObjectValue = JS_IsUndefined(prototype)
+      ? JS_NewObjectClass(m_ctx, js_javaobject_class_id)
+      : JS_NewObjectProtoClass(m_ctx, prototype, js_javaobject_class_id);
+  if (JS_IsException(javaObjectValue)) {
+    return javaObjectValue;
+  }
+
+  jobject globalRef = object.isNull() ? nullptr : newJavaRefGlobalRef(object.get());
+  JS_SetOpaque(javaObjectValue, globalRef);
+  m_counters->cppWrapperCount++;
+  m_counters->javaRefCount++;
+
+  return javaObjectValue;
+}
 
-  // class (created once per runtime)
-  JSRuntime *rt = JS_GetRuntime(ctx);
-  JS_NewClass(rt, js_cppwrapper_class_id, &js_cppwrapper_class);
+JSValueConst QuickJsUtils::getNamedValueOwner(const std::string &name) const {
+  static const size_t prefixLength = strlen(STASHED_NAME_PREFIX);
+  return name.compare(0, prefixLength, STASHED_NAME_PREFIX) == 0 ? m_stashObj : m_globalObj;
 }
 
 bool QuickJsUtils::hasPropertyStr(JSValueConst this_obj, const char *prop) const {
@@ -50,12 +188,44 @@ bool QuickJsUtils::hasPropertyStr(JSValueConst this_obj, const char *prop) const
 }
 
 JStringLocalRef QuickJsUtils::toJString(JSValueConst v) const {
-  const char *cstr = JS_ToCString(m_ctx, v);
-  JStringLocalRef ret(m_jniContext, cstr);
-  JS_FreeCString(m_ctx, cstr);
+  JSValue stringValue = JS_ToString(m_ctx, v);  // no copy if v is already a string
+  JS_AUTORELEASE_VALUE(m_ctx, stringValue);
+
+  size_t length = 0;
+  JS_BOOL isWideChar = false;
+  const void *chars = JS_GetStringChars(m_ctx, stringValue, &length, &isWideChar);
+  if (chars == nullptr) {
+    return JStringLocalRef();
+  }
+
+  if (isWideChar) {
+    return JStringLocalRef(m_jniContext, static_cast<const jchar *>(chars), static_cast<jsize>(length));
+  }
+
+  // Latin-1 -> UTF-16 (in a scratch buffer which is released as soon as the Java string is created)
+  ScratchScope scratchScope(m_scratchArena);
+  const auto latin1Chars = static_cast<const uint8_t *>(chars);
+  auto utf16Chars = m_scratchArena->allocate<jchar>(length);
+  std::copy(latin1Chars, latin1Chars + length, utf16Chars);
+  return JStringLocalRef(m_jniContext, utf16Chars, static_cast<jsize>(length));
+}
+
+JSValue QuickJsUtils::toJsString(const JStringLocalRef &jString) const {
+  JSValue cachedString;
+  if (m_stringCache != nullptr && m_stringCache->get(jString, &cachedString)) {
+    return cachedString;
+  }
+
+  std::u16string_view utf16View = jString.getUtf16View();
+  JSValue ret = JS_NewStringUTF16(m_ctx, reinterpret_cast<const uint16_t *>(utf16View.data()), utf16View.length());
+  jString.releaseChars();  // release chars now as we don't need them anymore
   return ret;
 }
 
+void QuickJsUtils::enableStringCache(size_t entryCount) {
+  m_stringCache.reset(new JsStringCache(m_ctx, entryCount));
+}
+
 std::string QuickJsUtils::toString(JSValueConst v) const {
   const char *cstr = JS_ToCString(m_ctx, v);
   std::string ret = cstr;
@@ -63,3 +233,101 @@ std::string QuickJsUtils::toString(JSValueConst v) const {
   return ret;
 }
 
+JSValue QuickJsUtils::newTypedArray(const char *typedArrayName, size_t byteLength, void **pData) const {
+  auto data = static_cast<uint8_t *>(js_malloc(m_ctx, byteLength > 0 ? byteLength : 1));
+  if (data == nullptr) {
+    return JS_EXCEPTION;
+  }
+
+  auto freeData = [](JSRuntime *rt, void *, void *ptr) {
+    js_free_rt(rt, ptr);
+  };
+
+  // The ArrayBuffer takes over the data
+  JSValue arrayBufferValue = JS_NewArrayBuffer(m_ctx, data, byteLength, freeData, nullptr, false);
+  if (JS_IsException(arrayBufferValue)) {
+    js_free(m_ctx, data);
+    return JS_EXCEPTION;
+  }
+
+  JSValue typedArrayCtor = JS_GetPropertyStr(m_ctx, m_globalObj, typedArrayName);
+
+  JSValue typedArrayValue = JS_CallConstructor(m_ctx, typedArrayCtor, 1, &arrayBufferValue);
+  JS_FreeValue(m_ctx, typedArrayCtor);
+  JS_FreeValue(m_ctx, arrayBufferValue);
+
+  *pData = data;
+  return typedArrayValue;
+}
+
+uint8_t *QuickJsUtils::getTypedArrayData(JSValueConst v, const char *typedArrayName, size_t *pByteLength) const {
+  if (!JS_IsObject(v)) {
+    return nullptr;
+  }
+
+  JSValue typedArrayCtor;
+  if (typedArrayName == nullptr) {
+    // %TypedArray% intrinsic object (prototype of all typed array constructors)
+    JSValue int8ArrayCtor = JS_GetPropertyStr(m_ctx, m_globalObj, "Int8Array");
+    typedArrayCtor = JS_GetPrototype(m_ctx, int8ArrayCtor);
+    JS_FreeValue(m_ctx, int8ArrayCtor);
+  } else {
+    typedArrayCtor = JS_GetPropertyStr(m_ctx, m_globalObj, typedArrayName);
+  }
+
+  int isInstance = JS_IsInstanceOf(m_ctx, v, typedArrayCtor);
+  JS_FreeValue(m_ctx, typedArrayCtor);
+
+  if (isInstance != 1) {
+    if (isInstance < 0) {
+      JS_FreeValue(m_ctx, JS_GetException(m_ctx));
+    }
+    return nullptr;
+  }
+
+  size_t byteOffset = 0, byteLength = 0;
+  JSValue arrayBufferValue = JS_GetTypedArrayBuffer(m_ctx, v, &byteOffset, &byteLength, nullptr);
+  if (JS_IsException(arrayBufferValue)) {
+    // Not a real typed array (e.g. only inheriting from its prototype)
+    JS_FreeValue(m_ctx, JS_GetException(m_ctx));
+    return nullptr;
+  }
+
+  size_t arrayBufferSize = 0;
+  uint8_t *data = JS_GetArrayBuffer(m_ctx, &arrayBufferSize, arrayBufferValue);
+  JS_FreeValue(m_ctx, arrayBufferValue);
+
+  if (data == nullptr) {
+    // Detached ArrayBuffer
+    JS_FreeValue(m_ctx, JS_GetException(m_ctx));
+    return nullptr;
+  }
+
+  *pByteLength = byteLength;
+  return data + byteOffset;
+}
+
+uint8_t *QuickJsUtils::getArrayBufferData(JSValueConst v, size_t *pByteLength) const {
+  if (!JS_IsObject(v)) {
+    return nullptr;
+  }
+
+  JSValue arrayBufferCtor = JS_GetPropertyStr(m_ctx, m_globalObj, "ArrayBuffer");
+
+  int isArrayBuffer = JS_IsInstanceOf(m_ctx, v, arrayBufferCtor);
+  JS_FreeValue(m_ctx, arrayBufferCtor);
+
+  if (isArrayBuffer != 1) {
+    if (isArrayBuffer < 0) {
+      JS_FreeValue(m_ctx, JS_GetException(m_ctx));
+    }
+    return getTypedArrayData(v, nullptr, pByteLength);
+  }
+
+  uint8_t *data = JS_GetArrayBuffer(m_ctx, pByteLength, v);
+  if (data == nullptr) {
+    JS_FreeValue(m_ctx, JS_GetException(m_ctx));
+  }
+
+  return data;
+}
@@ -16,13 +16,20 @@
 #ifndef _JSBRIDGE_QUICKJS_UTILS_H
 #define _JSBRIDGE_QUICKJS_UTILS_H
 
+#include "CppWrapperCounters.h"
+#include "JsStringCache.h"
 #include "jni-helpers/JniGlobalRef.h"
+#include "jni-helpers/JniLocalRef.h"
 #include "jni-helpers/JStringLocalRef.h"
 #include "quickjs/quickjs.h"
-#include <functional>
+#include <array>
+#include <memory>
+#include <string>
+#include <unordered_map>
 
 static const char *CPP_OBJECT_MAP_PROP_NAME = "__cpp_object_map";
 
+class ScratchArena;
 
 class QuickJsUtils {
 
@@ -31,34 +38,105 @@ public:
   QuickJsUtils(const QuickJsUtils &) = delete;
   QuickJsUtils &operator=(const QuickJsUtils &) = delete;
 
-  QuickJsUtils(const JniContext *, JSContext *);
+  QuickJsUtils(const JniContext *, JSContext *, CppWrapperCounters *, ScratchArena *);
+  ~QuickJsUtils();
+
+  // Frequently accessed (and bridge-internal) property names, interned once as atoms
+  enum class PropertyName {
+    Cause,
+    CppObjectMap,
+    JavaException,
+    Length,
+    Message,
+    PromiseComponentType,
+    Reject,
+    Resolve,
+    Stack,
+    Then,
+    _Count
+  };
+
+  JSAtom getAtom(PropertyName name) const { return m_atoms[static_cast<size_t>(name)]; }
+  JSValue getProperty(JSValueConst this_obj, PropertyName name) const { return JS_GetProperty(m_ctx, this_obj, getAtom(name)); }
+  int setProperty(JSValueConst this_obj, PropertyName name, JSValue val) const { return JS_SetProperty(m_ctx, this_obj, getAtom(name), val); }
+  bool hasProperty(JSValueConst this_obj, PropertyName name) const { return JS_HasProperty(m_ctx, this_obj, getAtom(name)) == 1; }
 
   bool hasPropertyStr(JSValueConst this_obj, const char *prop) const;
+
+  // Global object (cached for the lifetime of the QuickJsUtils instance)
+  JSValueConst getGlobalObject() const { return m_globalObj; }
+
+  // Object holding the JS value with the given name: bridge-internal values (see
+  // STASHED_NAME_PREFIX) are kept in a native-owned stash object, which is not reachable from JS
+  // and does not grow the global object. All other names are resolved in the global object.
+  JSValueConst getNamedValueOwner(const std::string &name) const;
+  static constexpr const char *STASHED_NAME_PREFIX = "__javaTypes_";
+
+  // Native JSON.stringify() replacer for Error instances (see custom_stringify())
+  JSValueConst getJsonErrorReplacer(bool keepErrorStack) const { return m_jsonErrorReplacers[keepErrorStack ? 1 : 0]; }
+
+  // Prototype of the JS errors wrapping a Java exception (set by ExceptionHandler), released
+  // together with the other values before the JS context
+  JSValueConst getJavaErrorPrototype() const { return m_javaErrorPrototype; }
+  void setJavaErrorPrototype(JSValue prototype) {
+    JS_FreeValue(m_ctx, m_javaErrorPrototype);
+    m_javaErrorPrototype = prototype;
+  }
+
+  // Shared prototypes of the Java objects registered with the same prototype name (see
+  // JavaObject), released together with the other values before the JS context
+  JSValueConst getJavaObjectPrototype(const std::string &name) const;  // JS_UNDEFINED if none
+  void setJavaObjectPrototype(const std::string &name, JSValue prototype);
+
+  // Conversions between JS and Java strings (without intermediate UTF-8 conversion)
   JStringLocalRef toJString(JSValueConst v) const;
+  JSValue toJsString(const JStringLocalRef &) const;
+
+  // Convert the short Java strings given to toJsString() via a cache with the given entry count
+  // (see JsStringCache)
+  void enableStringCache(size_t entryCount);
+  JsStringCache *getStringCache() const { return m_stringCache.get(); }
   std::string toString(JSValueConst v) const;
 
-  // Wrap a C++ instance inside a new JSValue and (optionally) ensure that it is
-  // deleted when the JSValue gets finalized
-  template <class T>
-  JSValue createCppPtrValue(T *obj, bool deleteOnFinalize) const {
-    JSValue cppWrapperObj = JS_NewObjectClass(m_ctx, js_cppwrapper_class_id);
+  // Create a new typed array (e.g. "Int32Array") backed by a new ArrayBuffer with the given size
+  // and return a pointer to its (uninitialized) data via pData. The data stays valid as long as
+  // the typed array is alive. Return JS_EXCEPTION in case of error.
+  JSValue newTypedArray(const char *typedArrayName, size_t byteLength, void **pData) const;
 
-    auto deleter = [deleteOnFinalize, obj]() {
-      if (deleteOnFinalize) {
-        delete obj;
-      }
-    };
+  // Return a pointer to the data of a typed array (or nullptr if it is not an instance of the
+  // given typed array, e.g. "Int32Array"). If typedArrayName is nullptr, any typed array is
+  // accepted. The data stays valid as long as the typed array is alive.
+  uint8_t *getTypedArrayData(JSValueConst v, const char *typedArrayName, size_t *pByteLength) const;
 
-    auto cppWrapper = new CppWrapper { obj, deleter };
-    JS_SetOpaque(cppWrapperObj, cppWrapper);
+  // Return a pointer to the data of an ArrayBuffer or of a typed array (or nullptr if it is none
+  // of them)
+  uint8_t *getArrayBufferData(JSValueConst v, size_t *pByteLength) const;
+
+  // Wrap a C++ instance inside a new JSValue and ensure that it is deleted when the JSValue gets
+  // finalized.
+  //
+  // Each wrapped type T has its own JS class whose finalizer directly deletes the instance stored
+  // as opaque pointer, i.e. wrapping does not need any allocation besides the JS object itself.
+  template <class T>
+  JSValue createCppPtrValue(T *obj) const {
+    JSClassID classId = cppPtrClassId<T>();
+    if (!JS_IsRegisteredClass(m_runtime, classId)) {
+      // class (created once per runtime)
+      JSClassDef classDef = { "CPPWRAPPER", .finalizer = cppPtrFinalizer<T> };
+      JS_NewClass(m_runtime, classId, &classDef);
+    }
+
+    JSValue cppWrapperObj = JS_NewObjectClass(m_ctx, classId);
+    JS_SetOpaque(cppWrapperObj, obj);
+    m_counters->cppWrapperCount++;
     return cppWrapperObj;
   }
 
-  // Access the instance wrapped in a JSValue via createCppPtrValue()
+  // Access the instance wrapped in a JSValue via createCppPtrValue() (or nullptr if the JSValue
+  // does not wrap an instance of T)
   template <class T>
   static T *getCppPtr(JSValueConst cppWrapperValue) {
-    auto cppWrapper = reinterpret_cast<CppWrapper *>(JS_GetOpaque(cppWrapperValue, js_cppwrapper_class_id));
-    return reinterpret_cast<T *>(cppWrapper->ptr);
+    return static_cast<T *>(JS_GetOpaque(cppWrapperValue, cppPtrClassId<T>()));
   }
 
   // Wrap a C++ instance inside an existing JSValue as a new map entry with the given key.
@@ -75,14 +153,14 @@ public:
   template <class T>
   void createMappedCppPtrValue(T *obj, JSValueConst jsValue, const char *key) const {
     // Get or create CPP object map
-    JSValue cppObjectMapValue = JS_GetPropertyStr(m_ctx, jsValue, CPP_OBJECT_MAP_PROP_NAME);
+    JSValue cppObjectMapValue = getProperty(jsValue, PropertyName::CppObjectMap);
     if (JS_IsUndefined(cppObjectMapValue)) {
       cppObjectMapValue = JS_NewObject(m_ctx);
-      JS_SetPropertyStr(m_ctx, jsValue, CPP_OBJECT_MAP_PROP_NAME, JS_DupValue(m_ctx, cppObjectMapValue));
+      setProperty(jsValue, PropertyName::CppObjectMap, JS_DupValue(m_ctx, cppObjectMapValue));
     }
 
     // Store it in jsValue.cppObjectMap[key]
-    JSValue cppValue = createCppPtrValue<T>(obj, true /*deleteOnFinalize*/);
+    JSValue cppValue = createCppPtrValue<T>(obj);
     JS_SetPropertyStr(m_ctx, cppObjectMapValue, key, cppValue);
     // No JS_FreeValue(m_ctx, cppValue) after JS_SetPropertyStr
 
@@ -92,68 +170,109 @@ public:
   // Access a C++ instance mapped inside a JSValue via createMappedCppPtrValue()
   template <class T>
   T *getMappedCppPtrValue(JSValueConst jsValue, const char *key) const {
-    // Get CPP object map
-    JSValue cppObjectMapValue = JS_GetPropertyStr(m_ctx, jsValue, CPP_OBJECT_MAP_PROP_NAME);
-    if (JS_IsUndefined(cppObjectMapValue)) {
-      return nullptr;
-    }
-
-    // Get C++ JavaScriptObject instance stored in jsObject.cppObjectMap["lambda_global_name"]
-    JSValue cppJsObjectValue = JS_GetPropertyStr(m_ctx, cppObjectMapValue, key);
+    JSValue cppJsObjectValue = getMappedCppValue(jsValue, key);
     T *cppObject = nullptr;
     if (JS_IsObject(cppJsObjectValue)) {
       cppObject = getCppPtr<T>(cppJsObjectValue);
     }
 
     JS_FreeValue(m_ctx, cppJsObjectValue);
+    return cppObject;
+  }
+
+  // Return the JSValue wrapping a C++ instance mapped inside a JSValue via
+  // createMappedCppPtrValue() or JS_UNDEFINED if there is none. Keeping it alive also keeps the
+  // C++ instance alive, even if the mapping is replaced.
+  JSValue getMappedCppValue(JSValueConst jsValue, const char *key) const {
+    // Get CPP object map
+    JSValue cppObjectMapValue = getProperty(jsValue, PropertyName::CppObjectMap);
+    if (!JS_IsObject(cppObjectMapValue)) {
+      JS_FreeValue(m_ctx, cppObjectMapValue);
+      return JS_UNDEFINED;
+    }
+
+    // Get the C++ wrapper stored in jsObject.cppObjectMap["lambda_global_name"]
+    JSValue cppValue = JS_GetPropertyStr(m_ctx, cppObjectMapValue, key);
     JS_FreeValue(m_ctx, cppObjectMapValue);
 
-    return cppObject;
+    return cppValue;
   }
 
   // Wrap a JNI ref inside a new JSValue and ensure that it's properly
-  // released when the JSValue gets finalized
+  // released when the JSValue gets finalized (the raw global ref is directly stored as opaque
+  // pointer)
   template <class T>
   JSValue createJavaRefValue(const JniRef<T> &ref) const {
-    JSValue cppWrapperObj = JS_NewObjectClass(m_ctx, js_cppwrapper_class_id);
-
-    auto globalRefPtr = new JniGlobalRef<T>(ref);
-
-    auto deleter = [globalRefPtr]() {
-      delete globalRefPtr;
-    };
+    JSValue javaRefObj = JS_NewObjectClass(m_ctx, js_javaref_class_id);
 
-    auto cppWrapper = new CppWrapper { globalRefPtr, deleter };
-    JS_SetOpaque(cppWrapperObj, cppWrapper);
+    jobject globalRef = ref.isNull() ? nullptr : newJavaRefGlobalRef(ref.get());
+    JS_SetOpaque(javaRefObj, globalRef);
+    m_counters->cppWrapperCount++;
+    m_counters->javaRefCount++;
 
-    return cppWrapperObj;
+    return javaRefObj;
   }
 
   // Access a JNI ref wrapped in a JSValue via createJavaRefValue()
   template <class T>
   JniLocalRef<T> getJavaRef(JSValueConst v) const {
-    void *opaque = JS_GetOpaque(v, js_cppwrapper_class_id);
-    if (opaque == nullptr) {
+    auto globalRef = static_cast<jobject>(JS_GetOpaque(v, js_javaref_class_id));
+    if (globalRef == nullptr) {
       return JniLocalRef<T>();
     }
 
-    auto cppWrapper = reinterpret_cast<CppWrapper *>(opaque);
-    auto globalRefPtr = reinterpret_cast<JniGlobalRef<T> *>(cppWrapper->ptr);
-
-    return JniLocalRef<T>(*globalRefPtr);
+    return JniLocalRef<T>(m_jniContext, globalRef, JniLocalRefMode::NewLocalRef);
   }
 
+  // Create a new JS object bound to the given Java object with the given prototype (or with an
+  // empty prototype if undefined): like createJavaRefValue(), the raw global ref is directly
+  // stored as opaque pointer and released when the JS object gets finalized
+  JSValue createJavaObjectValue(const JniLocalRef<jobject> &object, JSValueConst prototype) const;
+
+  // Raw global ref of a JS object created via createJavaObjectValue() (or nullptr)
+  static jobject getJavaObjectGlobalRef(JSValueConst v) { return static_cast<jobject>(JS_GetOpaque(v, js_javaobject_class_id)); }
+
 public:  // internal
-  typedef struct {
-    void *ptr;
-    std::function<void()> deleter;
-  } CppWrapper;
+  static JSClassID js_javaref_class_id;
+  static JSClassID js_javaobject_class_id;
 
-  static JSClassID js_cppwrapper_class_id;
+  // Called by the wrapper finalizers, which may run until the JS runtime gets freed (i.e. after
+  // the QuickJsUtils instance has been deleted)
+  static void onCppWrapperFinalized(JSRuntime *);
+  static void onJavaRefFinalized(JSRuntime *, jobject globalRef);
 
 private:
+  // New global ref accounted by the CppWrapperCounters of the JS runtime, released in
+  // onJavaRefFinalized()
+  jobject newJavaRefGlobalRef(jobject) const;
+
+  // Thread-safe allocation of a new (process-wide) JS class ID
+  static JSClassID newClassId();
+
+  template <class T>
+  static JSClassID cppPtrClassId() {
+    static const JSClassID classId = newClassId();
+    return classId;
+  }
+
+  template <class T>
+  static void cppPtrFinalizer(JSRuntime *rt, JSValue val) {
+    delete static_cast<T *>(JS_GetOpaque(val, cppPtrClassId<T>()));
+    onCppWrapperFinalized(rt);
+  }
+
   const JniContext *m_jniContext;
   JSContext *m_ctx;
+  JSRuntime *m_runtime;
+  CppWrapperCounters *m_counters;
+  ScratchArena *m_scratchArena;
+  std::array<JSAtom, static_cast<size_t>(PropertyName::_Count)> m_atoms;
+  std::array<JSValue, 2> m_jsonErrorReplacers;  // without/with Error stack
+  JSValue m_javaErrorPrototype = JS_UNDEFINED;
+  JSValue m_globalObj;
+  JSValue m_stashObj;
+  std::unique_ptr<JsStringCache> m_stringCache;
+  std::unordered_map<std::string, JSValue> m_javaObjectPrototypes;
 };
 
 #endif
@@ -29,8 +29,11 @@ $ python tools/configure.py --source-directory src-input --output-directory tmp-
 
 
 Note 1: duk_console is based on the version in duktape/extras/console but adjusted to use Timber via JNI
-Note 2: promise.js is based on the version in duktape/polyfills but adjusted to properly handle errors
-(see https://github.com/svaarala/duktape/issues/1934)
+Note 2: Duktape has no built-in Promise (DUK_USE_PROMISE_BUILTIN is not available in 2.x): it is
+natively implemented in DuktapePromise.cpp
 Note 3: duk_trans_socket.h and duk_trans_socket_unix.c are based on the version in duktape/examples/debug-trans-socket
 and may need to be adjusted in the future
-
+Note 4: duk_config.h contains the JsBridge performance profile (JSBRIDGE_DUKTAPE_PERFORMANCE, see CMakeLists.txt)
+which enables DUK_USE_FASTINT and removes the DUK_USE_DEBUGGER_* options. It has to be re-applied after updating
+duk_config.h. ROM builtins (DUK_USE_ROM_OBJECTS/DUK_USE_ROM_STRINGS) would additionally require to run configure.py
+with --rom-support.
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "ScratchArena.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+  constexpr size_t ALIGNMENT = 8;
+}
+
+void *ScratchArena::allocate(size_t size) {
+  const size_t alignedSize = (std::max(size, size_t(1)) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+  if (!m_blocks.empty() && m_offset + alignedSize <= m_blocks[m_blockIndex].size) {
+    void *ptr = m_blocks[m_blockIndex].data.get() + m_offset;
+    m_offset += alignedSize;
+    return ptr;
+  }
+
+  // Move to the next block (the blocks after the current one do not hold any allocation) and
+  // replace it if it is too small
+  const size_t nextBlockIndex = m_blocks.empty() ? 0 : m_blockIndex + 1;
+  if (nextBlockIndex == m_blocks.size() || m_blocks[nextBlockIndex].size < alignedSize) {
+    const size_t previousSize = m_blocks.empty() ? 0 : m_blocks[m_blockIndex].size;
+    const size_t blockSize = std::max({ alignedSize, 2 * previousSize, MIN_BLOCK_SIZE });
+    Block block { std::unique_ptr<char[]>(new char[blockSize]), blockSize };
+
+    if (nextBlockIndex == m_blocks.size()) {
+      m_blocks.push_back(std::move(block));
+    } else {
+      m_blocks[nextBlockIndex] = std::move(block);
+    }
+  }
+
+  m_blockIndex = nextBlockIndex;
+  m_offset = alignedSize;
+  return m_blocks[m_blockIndex].data.get();
+}
+
+const char *ScratchArena::makeName(const char *prefix, unsigned long long number) {
+  const size_t prefixLength = strlen(prefix);
+  const size_t maxLength = prefixLength + 20;  // 20: max digit count of a 64-bit number
+
+  auto name = allocate<char>(maxLength + 1);
+  memcpy(name, prefix, prefixLength);
+  snprintf(name + prefixLength, maxLength + 1 - prefixLength, "%llu", number);
+  return name;
+}
+
+size_t ScratchArena::getCapacity() const {
+  size_t capacity = 0;
+  for (const Block &block : m_blocks) {
+    capacity += block.size;
+  }
+  return capacity;
+}
+
+void ScratchArena::releaseOversizedBlocks() {
+  if (getCapacity() <= MAX_KEPT_SIZE) {
+    return;
+  }
+
+  m_blockIndex = 0;
+  m_offset = 0;
+  m_blocks.resize(1);
+  if (m_blocks[0].size > MAX_KEPT_SIZE) {
+    m_blocks.clear();
+  }
+  m_blocks.shrink_to_fit();
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_SCRATCHARENA_H
+#define _JSBRIDGE_SCRATCHARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Bump allocator for the transient data of the conversions (e.g. the chars of a string which are
+// copied into a JS or a Java string right afterwards), owned by the JsBridgeContext
+//
+// Allocations must be made within a ScratchScope and are only valid until it ends, which rewinds the arena to
+// where it was when the scope started. The blocks are kept for the next allocations so that the
+// converters do not need any malloc() once the arena is warm. When the outermost scope (i.e. the
+// JNI entry function, see TRACE_JNI_CALL) ends, all blocks but the first one are released if they
+// have grown bigger than MAX_KEPT_SIZE.
+//
+// Must only be used from the JS thread.
+class ScratchArena {
+
+public:
+  ScratchArena() = default;
+  ScratchArena(const ScratchArena &) = delete;
+  ScratchArena &operator=(const ScratchArena &) = delete;
+
+  // Return a new uninitialized (8-byte aligned) buffer with the given size
+  void *allocate(size_t size);
+
+  template <class T>
+  T *allocate(size_t count) { return static_cast<T *>(allocate(count * sizeof(T))); }
+
+  // Return a new null-terminated string "<prefix><number>"
+  const char *makeName(const char *prefix, unsigned long long number);
+
+  // Total size of the blocks currently kept by the arena
+  size_t getCapacity() const;
+
+private:
+  friend class ScratchScope;
+
+  static constexpr size_t MIN_BLOCK_SIZE = 4 * 1024;
+  static constexpr size_t MAX_KEPT_SIZE = 64 * 1024;
+
+  struct Block {
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+
+  void releaseOversizedBlocks();
+
+  std::vector<Block> m_blocks;
+  size_t m_blockIndex = 0;  // current block
+  size_t m_offset = 0;  // in the current block
+  int m_scopeDepth = 0;
+};
+
+// Scope (RAII) of the allocations made in the given arena while it is alive
+class ScratchScope {
+
+public:
+  explicit ScratchScope(ScratchArena *arena)
+   : m_arena(arena)
+   , m_blockIndex(arena->m_blockIndex)
+   , m_offset(arena->m_offset) {
+
+    ++m_arena->m_scopeDepth;
+  }
+
+  ScratchScope(const ScratchScope &) = delete;
+  ScratchScope &operator=(const ScratchScope &) = delete;
+
+  ~ScratchScope() {
+    m_arena->m_blockIndex = m_blockIndex;
+    m_arena->m_offset = m_offset;
+
+    if (--m_arena->m_scopeDepth == 0) {
+      m_arena->releaseOversizedBlocks();
+    }
+  }
+
+private:
+  ScratchArena *m_arena;
+  size_t m_blockIndex;
+  size_t m_offset;
+};
+
+#endif
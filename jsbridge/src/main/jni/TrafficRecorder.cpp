@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "TrafficRecorder.h"
+
+#include "JavaTypeId.h"
+#include "JniCache.h"
+#include "JsBridgeContext.h"
+#include "jni-helpers/JniContext.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#if defined(QUICKJS)
+# include "QuickJsUtils.h"
+#endif
+
+namespace {
+  const uint8_t MAGIC[] = { 'J', 'S', 'B', 'T' };
+  const size_t FLAGS_OFFSET = sizeof(MAGIC) + 1;
+}
+
+void TrafficRecorder::start(int samplingInterval, size_t maxSizeBytes) {
+  m_samplingInterval = std::max(samplingInterval, 1);
+  m_maxSizeBytes = maxSizeBytes;
+  m_buffer.clear();
+  m_nameIds.clear();
+  m_outermostCallCount = 0;
+  m_depth = 0;
+  m_outermostCallSampled = false;
+
+  m_buffer.insert(m_buffer.end(), std::begin(MAGIC), std::end(MAGIC));
+  writeByte(FORMAT_VERSION);
+  writeByte(0);  // flags
+  writeVarint(static_cast<uint64_t>(m_samplingInterval));
+
+  m_startTime = Clock::now();
+  m_recording = true;
+}
+
+std::vector<uint8_t> TrafficRecorder::stop() {
+  m_recording = false;
+  m_nameIds.clear();
+
+  std::vector<uint8_t> recording;
+  recording.swap(m_buffer);
+  return recording;
+}
+
+bool TrafficRecorder::beginCall() {
+  if (m_depth++ == 0) {
+    m_outermostCallSampled = m_outermostCallCount++ % m_samplingInterval == 0;
+  }
+  return m_outermostCallSampled;
+}
+
+void TrafficRecorder::endCall(bool isSampled, CallType callType, const char *name, Clock::time_point startTime,
+                              const std::vector<Value> &arguments) {
+  m_depth = std::max(m_depth - 1, 0);
+
+  if (!m_recording || !isSampled) {
+    return;
+  }
+
+  const Clock::time_point endTime = Clock::now();
+  const size_t initialSize = m_buffer.size();
+
+  const uint32_t nameId = getNameId(name != nullptr ? name : "");
+  writeByte(static_cast<uint8_t>(RecordTag::Call));
+  writeByte(static_cast<uint8_t>(callType));
+  writeVarint(nameId);
+  writeVarint(static_cast<uint64_t>(m_depth));
+  writeVarint(static_cast<uint64_t>(std::max(std::chrono::duration_cast<std::chrono::microseconds>(startTime - m_startTime).count(), int64_t(0))));
+  writeVarint(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count()));
+  writeVarint(arguments.size());
+  for (const Value &argument : arguments) {
+    writeByte(static_cast<uint8_t>(argument.type));
+    writeVarint(argument.size);
+  }
+
+  if (m_buffer.size() > m_maxSizeBytes) {
+    // Drop the call (and the name it may have defined) and stop recording
+    m_buffer.resize(initialSize);
+    m_buffer[FLAGS_OFFSET] |= FLAG_TRUNCATED;
+    m_recording = false;
+  }
+}
+
+uint32_t TrafficRecorder::getNameId(const char *name) {
+  auto itFind = m_nameIds.find(name);
+  if (itFind != m_nameIds.end()) {
+    return itFind->second;
+  }
+
+  const auto nameId = static_cast<uint32_t>(m_nameIds.size());
+  const size_t nameLength = strlen(name);
+  m_nameIds.emplace(name, nameId);
+
+  writeByte(static_cast<uint8_t>(RecordTag::Name));
+  writeVarint(nameId);
+  writeVarint(nameLength);
+  m_buffer.insert(m_buffer.end(), name, name + nameLength);
+  return nameId;
+}
+
+void TrafficRecorder::writeVarint(uint64_t value) {
+  while (value >= 0x80) {
+    m_buffer.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  m_buffer.push_back(static_cast<uint8_t>(value));
+}
+
+TrafficRecorder::Value TrafficRecorder::describeJavaValue(const JsBridgeContext *jsBridgeContext, jobject value) {
+  if (value == nullptr) {
+    return { ValueType::Null, 0 };
+  }
+
+  JNIEnv *env = jsBridgeContext->getJniContext()->getJNIEnv();
+  const JniCache *jniCache = jsBridgeContext->getJniCache();
+
+  if (env->IsInstanceOf(value, jniCache->getStringClass().get())) {
+    return { ValueType::String, static_cast<uint32_t>(env->GetStringLength(static_cast<jstring>(value))) };
+  }
+  if (env->IsInstanceOf(value, jniCache->getNumberClass().get())) {
+    return { ValueType::Number, 0 };
+  }
+  if (env->IsInstanceOf(value, jniCache->getJavaClass(JavaTypeId::BoxedBoolean).get())) {
+    return { ValueType::Boolean, 0 };
+  }
+  if (env->IsInstanceOf(value, jniCache->getJavaClass(JavaTypeId::ObjectArray).get())) {
+    return { ValueType::Array, static_cast<uint32_t>(env->GetArrayLength(static_cast<jarray>(value))) };
+  }
+  if (env->IsInstanceOf(value, jniCache->getJavaClass(JavaTypeId::ByteArray).get())) {
+    return { ValueType::ArrayBuffer, static_cast<uint32_t>(env->GetArrayLength(static_cast<jarray>(value))) };
+  }
+  return { ValueType::Object, 0 };
+}
+
+#if defined(DUKTAPE)
+
+TrafficRecorder::Value TrafficRecorder::describeJsValue(const JsBridgeContext *jsBridgeContext, duk_idx_t index) {
+  duk_context *ctx = jsBridgeContext->getDuktapeContext();
+
+  switch (duk_get_type(ctx, index)) {
+    case DUK_TYPE_NONE:
+    case DUK_TYPE_UNDEFINED:
+      return { ValueType::Undefined, 0 };
+    case DUK_TYPE_NULL:
+      return { ValueType::Null, 0 };
+    case DUK_TYPE_BOOLEAN:
+      return { ValueType::Boolean, 0 };
+    case DUK_TYPE_NUMBER:
+      return { ValueType::Number, 0 };
+    case DUK_TYPE_STRING:
+      return { ValueType::String, static_cast<uint32_t>(duk_get_length(ctx, index)) };
+    case DUK_TYPE_BUFFER:
+      return { ValueType::ArrayBuffer, static_cast<uint32_t>(duk_get_length(ctx, index)) };
+    case DUK_TYPE_LIGHTFUNC:
+      return { ValueType::Function, 0 };
+    default:
+      break;
+  }
+
+  if (duk_is_array(ctx, index)) {
+    return { ValueType::Array, static_cast<uint32_t>(duk_get_length(ctx, index)) };
+  }
+  if (duk_is_function(ctx, index)) {
+    return { ValueType::Function, 0 };
+  }
+  if (duk_is_buffer_data(ctx, index)) {
+    duk_size_t byteLength = 0;
+    duk_get_buffer_data(ctx, index, &byteLength);
+    return { ValueType::ArrayBuffer, static_cast<uint32_t>(byteLength) };
+  }
+  return { ValueType::Object, 0 };
+}
+
+#elif defined(QUICKJS)
+
+namespace {
+  uint32_t getLength(const JsBridgeContext *jsBridgeContext, JSValueConst v) {
+    JSContext *ctx = jsBridgeContext->getQuickJsContext();
+
+    JSValue lengthValue = jsBridgeContext->getUtils()->getProperty(v, QuickJsUtils::PropertyName::Length);
+    uint32_t length = 0;
+    if (JS_ToUint32(ctx, &length, lengthValue) < 0) {
+      JS_FreeValue(ctx, JS_GetException(ctx));
+    }
+    JS_FreeValue(ctx, lengthValue);
+    return length;
+  }
+}
+
+TrafficRecorder::Value TrafficRecorder::describeJsValue(const JsBridgeContext *jsBridgeContext, JSValueConst v) {
+  JSContext *ctx = jsBridgeContext->getQuickJsContext();
+
+  if (JS_IsUndefined(v)) {
+    return { ValueType::Undefined, 0 };
+  }
+  if (JS_IsNull(v)) {
+    return { ValueType::Null, 0 };
+  }
+  if (JS_IsBool(v)) {
+    return { ValueType::Boolean, 0 };
+  }
+  if (JS_IsNumber(v)) {
+    return { ValueType::Number, 0 };
+  }
+  if (JS_IsString(v)) {
+    return { ValueType::String, getLength(jsBridgeContext, v) };
+  }
+  if (!JS_IsObject(v)) {
+    return { ValueType::Object, 0 };
+  }
+  const int isArray = JS_IsArray(ctx, v);
+  if (isArray == 1) {
+    return { ValueType::Array, getLength(jsBridgeContext, v) };
+  }
+  if (isArray < 0) {
+    // Revoked proxy
+    JS_FreeValue(ctx, JS_GetException(ctx));
+  }
+  if (JS_IsFunction(ctx, v)) {
+    return { ValueType::Function, 0 };
+  }
+
+  size_t byteLength = 0;
+  if (jsBridgeContext->getUtils()->getArrayBufferData(v, &byteLength) != nullptr) {
+    return { ValueType::ArrayBuffer, static_cast<uint32_t>(byteLength) };
+  }
+  return { ValueType::Object, 0 };
+}
+
+#endif
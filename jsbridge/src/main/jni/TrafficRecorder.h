@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_TRAFFICRECORDER_H
+#define _JSBRIDGE_TRAFFICRECORDER_H
+
+#include <jni.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(DUKTAPE)
+# include "duktape/duktape.h"
+#elif defined(QUICKJS)
+# include "quickjs/quickjs.h"
+#endif
+
+class JsBridgeContext;
+
+// Optional recorder of the bridge traffic (stopped by default), e.g. to replay the calls of a
+// production session with synthetic payloads (see JsTrafficReplayer)
+//
+// Each recorded call (JNI entry point or Java method called from JS) is stored with its start
+// time, duration and the type and size of its arguments - not their content - into a compact
+// binary buffer:
+// - header: "JSBT", format version (u8), flags (u8, see FLAG_*), sampling interval (varint)
+// - records: a tag (u8, see RecordTag) followed by
+//   - Name: name id (varint), UTF-8 length (varint), UTF-8 bytes
+//   - Call: call type (u8), name id (varint), nesting depth (varint), start time since the
+//     beginning of the recording in us (varint), duration in ns (varint), argument count (varint)
+//     and for each argument: value type (u8), size (varint)
+// All the varints are unsigned LEB128. The calls are written when they end, so nested calls
+// come before their parent.
+//
+// Sampling is done on the outermost calls: the calls nested in a sampled call (e.g. a Java
+// method called from an evaluation) are always recorded.
+//
+// Must only be used from the JS thread.
+class TrafficRecorder {
+
+public:
+  enum class CallType : uint8_t {
+    EvaluateString = 0,
+    CallJsMethod = 1,
+    CallJsLambda = 2,
+    JavaMethod = 3,
+  };
+
+  enum class ValueType : uint8_t {
+    Undefined = 0,
+    Null = 1,
+    Boolean = 2,
+    Number = 3,
+    String = 4,  // size: length (UTF-16 units)
+    Array = 5,  // size: length
+    ArrayBuffer = 6,  // size: byte length (also for typed arrays and Java byte[])
+    Object = 7,
+    Function = 8,
+  };
+
+  struct Value {
+    ValueType type;
+    uint32_t size;
+  };
+
+  static constexpr uint8_t FORMAT_VERSION = 1;
+  static constexpr uint8_t FLAG_TRUNCATED = 0x01;  // some calls were dropped (max size reached)
+
+  TrafficRecorder() = default;
+  TrafficRecorder(const TrafficRecorder &) = delete;
+  TrafficRecorder &operator=(const TrafficRecorder &) = delete;
+
+  // Drop any previous recording and record 1 out of samplingInterval outermost calls until the
+  // recording reaches maxSizeBytes
+  void start(int samplingInterval, size_t maxSizeBytes);
+  // Return the recording (empty if the recorder has not been started)
+  std::vector<uint8_t> stop();
+
+  bool isRecording() const { return m_recording; }
+
+  static Value describeJavaValue(const JsBridgeContext *, jobject);
+#if defined(DUKTAPE)
+  static Value describeJsValue(const JsBridgeContext *, duk_idx_t);
+#elif defined(QUICKJS)
+  static Value describeJsValue(const JsBridgeContext *, JSValueConst);
+#endif
+
+private:
+  friend class RecordedCall;
+
+  using Clock = std::chrono::steady_clock;
+
+  enum class RecordTag : uint8_t {
+    Name = 0,
+    Call = 1,
+  };
+
+  // Called when a call begins: return true if it must be recorded
+  bool beginCall();
+  void endCall(bool isSampled, CallType, const char *name, Clock::time_point startTime,
+               const std::vector<Value> &arguments);
+
+  uint32_t getNameId(const char *name);
+  void writeVarint(uint64_t);
+  void writeByte(uint8_t b) { m_buffer.push_back(b); }
+
+  bool m_recording = false;
+  int m_samplingInterval = 1;
+  size_t m_maxSizeBytes = 0;
+  Clock::time_point m_startTime;
+  std::vector<uint8_t> m_buffer;
+  std::unordered_map<std::string, uint32_t> m_nameIds;
+  uint64_t m_outermostCallCount = 0;
+  int m_depth = 0;
+  bool m_outermostCallSampled = false;
+};
+
+// Call recorded (RAII) into the given TrafficRecorder when it goes out of scope.
+// All the operations are no-ops if the recorder is null or stopped or if the call is not sampled.
+//
+// e.g.:
+// RecordedCall recordedCall(recorder, TrafficRecorder::CallType::JavaMethod, name);
+// if (recordedCall.isSampled()) {
+//   recordedCall.addArgument(TrafficRecorder::describeJsValue(jsBridgeContext, arg));
+// }
+class RecordedCall {
+
+public:
+  // The name must stay valid until the call goes out of scope
+  RecordedCall(TrafficRecorder *recorder, TrafficRecorder::CallType callType, const char *name)
+   : m_recorder(recorder != nullptr && recorder->isRecording() ? recorder : nullptr)
+   , m_callType(callType)
+   , m_name(name) {
+
+    if (m_recorder != nullptr) {
+      m_isSampled = m_recorder->beginCall();
+      m_startTime = TrafficRecorder::Clock::now();
+    }
+  }
+
+  RecordedCall(const RecordedCall &) = delete;
+  RecordedCall &operator=(const RecordedCall &) = delete;
+
+  ~RecordedCall() {
+    if (m_recorder != nullptr) {
+      m_recorder->endCall(m_isSampled, m_callType, m_name, m_startTime, m_arguments);
+    }
+  }
+
+  bool isSampled() const { return m_isSampled; }
+
+  void addArgument(TrafficRecorder::Value value) {
+    if (m_isSampled) {
+      m_arguments.push_back(value);
+    }
+  }
+
+private:
+  TrafficRecorder *m_recorder;
+  TrafficRecorder::CallType m_callType;
+  const char *m_name;
+  bool m_isSampled = false;
+  TrafficRecorder::Clock::time_point m_startTime;
+  std::vector<TrafficRecorder::Value> m_arguments;
+};
+
+#endif
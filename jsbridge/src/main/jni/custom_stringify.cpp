@@ -17,6 +17,10 @@
 #include "custom_stringify.h"
 #include <cstring>
 
+#if defined(DUKTAPE)
+
+#include "StackChecker.h"
+
 static const char *customStringifyJs = R"(
 // Custom stringify which probably handles Error instances
 // See https://stackoverflow.com/questions/18391212/is-it-not-possible-to-stringify-an-error-using-json-stringify
@@ -39,10 +43,6 @@ globalThis.__jsBridge__stringify = function(value, keepErrorStack) {
   return JSON.stringify(value, replaceErrors);
 };)";
 
-#if defined(DUKTAPE)
-
-#include "StackChecker.h"
-
 // [... object ...] -> [... object ... jsonString]
 duk_int_t custom_stringify(duk_context *ctx, duk_idx_t idx, bool keepErrorStack) {
   CHECK_STACK_OFFSET(ctx, 1);
@@ -71,30 +71,61 @@ duk_int_t custom_stringify(duk_context *ctx, duk_idx_t idx, bool keepErrorStack)
 
 #elif defined(QUICKJS)
 
-JSValue custom_stringify(JSContext *ctx, JSValueConst v, bool keepErrorStack) {
-  JSValue ret;
+#include "QuickJsUtils.h"
 
-#if 0
-  // 1. JSON stringify (but does not properly serialize Error instances!)
-  ret = JS_JSONStringify(ctx, v, JS_UNDEFINED, JS_UNDEFINED);
-#else
-  // 2. Custom stringify which properly serializes Error instances
-  JSValue globalObj = JS_GetGlobalObject(ctx);
-  JSValue jsbridgeStringifyValue = JS_GetPropertyStr(ctx, globalObj, "__jsBridge__stringify");
-  if (JS_IsUndefined(jsbridgeStringifyValue)) {
-    jsbridgeStringifyValue = JS_Eval(ctx, customStringifyJs, strlen(customStringifyJs), "custom_stringify.cpp", 0);
-    JS_SetPropertyStr(ctx, globalObj, "__jsBridge__stringify", JS_DupValue(ctx, jsbridgeStringifyValue));
+// Called by JSON.stringify() for each key: replace Error instances by plain JS objects using the
+// Error own properties (see https://stackoverflow.com/questions/18391212/is-it-not-possible-to-stringify-an-error-using-json-stringify)
+JSValue custom_stringify_replace_errors(JSContext *ctx, JSValueConst, int argc, JSValueConst *argv, int keepErrorStack) {
+  JSValueConst value = argc > 1 ? argv[1] : JS_UNDEFINED;
+
+  if (!JS_IsError(ctx, value)) {
+    return JS_DupValue(ctx, value);
   }
 
-  JSValue args[] = { v, JS_NewBool(ctx, keepErrorStack) };
-  ret = JS_Call(ctx, jsbridgeStringifyValue, JS_NULL, 2, args);
+  JSPropertyEnum *properties = nullptr;
+  uint32_t propertyCount = 0;
+  if (JS_GetOwnPropertyNames(ctx, &properties, &propertyCount, value, JS_GPN_STRING_MASK) < 0) {
+    return JS_EXCEPTION;
+  }
+
+  JSAtom stackAtom = JS_NewAtom(ctx, "stack");
+  JSValue ret = JS_NewObject(ctx);
+
+  for (uint32_t i = 0; i < propertyCount; ++i) {
+    JSAtom atom = properties[i].atom;
+    if (JS_IsException(ret) || (!keepErrorStack && atom == stackAtom)) {
+      continue;
+    }
+
+    JSValue propertyValue = JS_GetProperty(ctx, value, atom);
+    if (JS_IsException(propertyValue)) {
+      JS_FreeValue(ctx, ret);
+      ret = JS_EXCEPTION;
+      continue;
+    }
+
+    JS_SetProperty(ctx, ret, atom, propertyValue);
+    // No JS_FreeValue(ctx, propertyValue) after JS_SetProperty()
+  }
+
+  for (uint32_t i = 0; i < propertyCount; ++i) {
+    JS_FreeAtom(ctx, properties[i].atom);
+  }
+  js_free(ctx, properties);
+  JS_FreeAtom(ctx, stackAtom);
 
-  JS_FreeValue(ctx, jsbridgeStringifyValue);
-  JS_FreeValue(ctx, globalObj);
-#endif
   return ret;
 }
 
-#include <cstring>
+// Custom stringify which properly serializes Error instances
+// Note: directly using JS_JSONStringify() with a native replacer which is much cheaper than a JS
+// replacer closure being called for each property
+JSValue custom_stringify(JSContext *ctx, const QuickJsUtils *utils, JSValueConst v, bool keepErrorStack) {
+  if (JS_IsUndefined(v)) {
+    return JS_NewString(ctx, "");
+  }
+
+  return JS_JSONStringify(ctx, v, utils->getJsonErrorReplacer(keepErrorStack), JS_UNDEFINED);
+}
 
 #endif
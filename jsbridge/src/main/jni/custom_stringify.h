@@ -26,7 +26,13 @@ duk_int_t custom_stringify(duk_context *, duk_idx_t, bool keepErrorStack);
 
 # include "quickjs/quickjs.h"
 
-JSValue custom_stringify(JSContext *, JSValueConst, bool keepErrorStack);
+class QuickJsUtils;
+
+// Native JSON.stringify() replacer converting Error instances into plain objects, created once
+// per context with JS_NewCFunctionMagic() with keepErrorStack as magic (see QuickJsUtils)
+JSValue custom_stringify_replace_errors(JSContext *, JSValueConst this_val, int argc, JSValueConst *argv, int keepErrorStack);
+
+JSValue custom_stringify(JSContext *, const QuickJsUtils *, JSValueConst, bool keepErrorStack);
 
 #endif
 #endif
@@ -17,16 +17,32 @@
  * limitations under the License.
  */
 #include "de_prosiebensat1digital_oasisjsbridge_JsBridge.h"
+#include "AllocationStats.h"
+#include "CallTracer.h"
 #include "ExceptionHandler.h"
+#include "ExecutionDeadline.h"
 #include "JniCache.h"
 #include "JsBridgeContext.h"
+#include "JsConsole.h"
+#include "JsThreadScheduling.h"
+#include "ScratchArena.h"
+#include "TrafficRecorder.h"
 #include "log.h"
 #include "java-types/Deferred.h"
+#include "java-types/Payload.h"
+#include "jni-helpers/JArrayLocalRef.h"
 #include "jni-helpers/JniContext.h"
+#include "jni-helpers/JniLocalFrame.h"
 #include "jni-helpers/JniLocalRef.h"
 #include "jni-helpers/JObjectArrayLocalRef.h"
 #include "jni-helpers/JStringLocalRef.h"
+#include <android/asset_manager_jni.h>
+#include <algorithm>
+#include <exception>
 #include <new>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace {
   // This should be instanciated in each JNI entry function to make sure that the JNI context is
@@ -47,69 +63,1348 @@ namespace {
     jsBridgeContext->getJniCache()->getJsBridgeInterface().checkJsThread();
 #endif
 
+    jsBridgeContext->checkJniGlobalRefLimit();
     return jsBridgeContext;
   }
+
+  // Add the type and size of the given Java arguments to a sampled call (see TrafficRecorder)
+  void recordJavaArguments(RecordedCall &recordedCall, JsBridgeContext *jsBridgeContext, jobjectArray args) {
+    if (!recordedCall.isSampled() || args == nullptr) {
+      return;
+    }
+
+    JniContext *jniContext = jsBridgeContext->getJniContext();
+    JNIEnv *env = jniContext->getJNIEnv();
+    const jsize argCount = env->GetArrayLength(args);
+    for (jsize i = 0; i < argCount; ++i) {
+      JniLocalRef<jobject> arg(jniContext, env->GetObjectArrayElement(args, i));
+      recordedCall.addArgument(TrafficRecorder::describeJavaValue(jsBridgeContext, arg.get()));
+    }
+  }
+}
+
+// Trace the current JNI entry function (see CallTracer), named without its
+// "Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_" prefix, and release its scratch
+// allocations (see ScratchArena) when it returns
+#define TRACE_JNI_CALL(jsBridgeContext) \
+  CallTrace jniCallTrace((jsBridgeContext)->getCallTracer(), \
+                         __func__ + sizeof("Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_") - 1); \
+  ScratchScope jniScratchScope((jsBridgeContext)->getScratchArena())
+
+#if defined(JSBRIDGE_PGO_GENERATE)
+// LLVM profile runtime (linked with -fprofile-generate)
+extern "C" void __llvm_profile_set_filename(const char *);
+extern "C" int __llvm_profile_write_file();
+#endif
+
+extern "C" {
+
+JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *jvm, void *) {
+  JNIEnv *env = nullptr;
+  if (jvm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) != JNI_OK) {
+    return JNI_ERR;
+  }
+
+  // Shared by all the JsBridge instances (FindClass() uses here the class loader of the app)
+  JniCache::loadShared(env);
+  if (env->ExceptionCheck()) {
+    env->ExceptionClear();
+    return JNI_ERR;
+  }
+
+  return JNI_VERSION_1_6;
+}
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCreateContext
+    (JNIEnv *env, jobject object, jlong maxStackSize, jlong memoryLimit, jlong gcThreshold, jint regExpCacheSize, jboolean poolAllocator,
+     jlong executionTimeoutMs, jboolean preloadJniCache, jlong sharedRuntimeContext) {
+
+  alog("jniCreateContext()");
+
+  auto jsBridgeContext = new JsBridgeContext();
+  TimedSection section("jniCreateContext", jsBridgeContext->getStartupTimings().totalNs);
+  auto jniContext = new JniContext(env, JniContext::EnvironmentSource::Manual);
+
+  JsBridgeContext::EngineSettings engineSettings;
+  engineSettings.maxStackSize = static_cast<size_t>(std::max(maxStackSize, jlong(0)));
+  engineSettings.memoryLimit = static_cast<size_t>(std::max(memoryLimit, jlong(0)));
+  engineSettings.gcThreshold = static_cast<size_t>(std::max(gcThreshold, jlong(0)));
+  engineSettings.regExpCacheSize = std::max(regExpCacheSize, jint(0));
+  engineSettings.poolAllocator = poolAllocator == JNI_TRUE;
+  engineSettings.executionTimeoutMs = std::max(executionTimeoutMs, jlong(0));
+  engineSettings.preloadJniCache = preloadJniCache == JNI_TRUE;
+  engineSettings.sharedRuntimeContext = reinterpret_cast<const JsBridgeContext *>(sharedRuntimeContext);
+
+  try {
+    jsBridgeContext->init(jniContext, JniLocalRef<jobject>(jniContext, object, JniLocalRefMode::Borrowed), engineSettings);
+  } catch (const std::bad_alloc &) {
+    return 0L;
+  }
+
+  return reinterpret_cast<jlong>(jsBridgeContext);
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniStartDebugger
+    (JNIEnv *env, jobject, jlong lctx, jint port) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  jsBridgeContext->startDebugger(port);
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCancelDebug
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  jsBridgeContext->cancelDebug();
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteContext
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  alog("jniDeleteContext()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  delete jsBridgeContext;
+  delete jniContext;
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRunGc
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  jsBridgeContext->runGc();
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRunIdleGc
+    (JNIEnv *env, jobject, jlong lctx, jlong allocationThreshold) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  jsBridgeContext->runIdleGc(static_cast<size_t>(std::max(allocationThreshold, jlong(0))));
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniOnMemoryPressure
+    (JNIEnv *env, jobject, jlong lctx, jboolean critical) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  jsBridgeContext->onMemoryPressure(critical == JNI_TRUE);
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniSetJsThreadScheduling
+    (JNIEnv *env, jobject, jlong lctx, jboolean setNiceValue, jint niceValue, jlong cpuAffinityMask) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+
+  try {
+    if (setNiceValue == JNI_TRUE) {
+      JsThreadScheduling::setNiceValue(niceValue);
+    }
+    if (cpuAffinityMask != 0) {
+      JsThreadScheduling::setCpuAffinityMask(static_cast<uint64_t>(cpuAffinityMask));
+    }
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJsHeapSize
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  return static_cast<jlong>(jsBridgeContext->getHeapSize());
+}
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCompactHeap
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  return static_cast<jlong>(jsBridgeContext->compactHeap());
+}
+
+JNIEXPORT jlongArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetMemoryUsage
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  const JsBridgeContext::MemoryUsage memoryUsage = jsBridgeContext->getMemoryUsage();
+
+  // Order must match JsMemoryUsage.fromLongArray()
+  const jlong values[] = {
+      static_cast<jlong>(memoryUsage.heapSize),
+      static_cast<jlong>(memoryUsage.objectCount),
+      static_cast<jlong>(memoryUsage.stringCount),
+      static_cast<jlong>(memoryUsage.atomCount),
+      static_cast<jlong>(memoryUsage.cppWrapperCount),
+      static_cast<jlong>(memoryUsage.javaRefCount),
+      static_cast<jlong>(memoryUsage.jsValueCount),
+      static_cast<jlong>(memoryUsage.jniGlobalRefCount),
+  };
+  const jsize count = sizeof(values) / sizeof(values[0]);
+
+  JArrayLocalRef<jlong> valueArray(jniContext, count);
+  valueArray.setRegion(0, count, values);
+
+  // Prevent auto-releasing the localref returned to Java
+  valueArray.detach();
+
+  return static_cast<jlongArray>(valueArray.get());
+}
+
+JNIEXPORT jlongArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetStartupTimings
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  const JsBridgeContext::StartupTimings &startupTimings = jsBridgeContext->getStartupTimings();
+
+  // Order must match JsStartupMetrics.withNativeTimings()
+  const jlong values[] = {
+      static_cast<jlong>(startupTimings.totalNs),
+      static_cast<jlong>(startupTimings.engineNs),
+      static_cast<jlong>(startupTimings.jniCacheNs),
+      static_cast<jlong>(startupTimings.bridgeSetupNs),
+  };
+  const jsize count = sizeof(values) / sizeof(values[0]);
+
+  JArrayLocalRef<jlong> valueArray(jniContext, count);
+  valueArray.setRegion(0, count, values);
+
+  // Prevent auto-releasing the localref returned to Java
+  valueArray.detach();
+
+  return static_cast<jlongArray>(valueArray.get());
+}
+
+// Note: the call trace functions are not traced themselves so that the statistics stay unchanged
+// while they are read
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableCallTracing
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  jsBridgeContext->getCallTracer()->enable();
+}
+
+JNIEXPORT jobjectArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetCallTraceStats
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+  const JniCache *jniCache = jsBridgeContext->getJniCache();
+
+  std::vector<std::string> names;
+  std::vector<int64_t> values;
+  jsBridgeContext->getCallTracer()->getStats(names, values);
+
+  // [String[] names, long[] values] (see CallTracer::getStats())
+  JObjectArrayLocalRef nameArray(jniContext, static_cast<jsize>(names.size()), jniCache->getJavaClass(JavaTypeId::String));
+  for (size_t i = 0; i < names.size(); ++i) {
+    nameArray.setElement(static_cast<jsize>(i), JStringLocalRef(jniContext, names[i].c_str()));
+  }
+
+  JArrayLocalRef<jlong> valueArray(jniContext, static_cast<jsize>(values.size()));
+  std::vector<jlong> jvalues(values.begin(), values.end());
+  valueArray.setRegion(0, static_cast<jsize>(jvalues.size()), jvalues.data());
+
+  JObjectArrayLocalRef statsArray(jniContext, 2, jniCache->getJavaClass(JavaTypeId::Object));
+  statsArray.setElement(0, nameArray);
+  statsArray.setElement(1, valueArray);
+
+  // Prevent auto-releasing the localref returned to Java
+  statsArray.detach();
+
+  return statsArray.get();
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniResetCallTraceStats
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  jsBridgeContext->getCallTracer()->reset();
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniStartProfiler
+    (JNIEnv *env, jobject, jlong lctx, jlong samplingIntervalUs) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  jsBridgeContext->startProfiler(samplingIntervalUs);
+}
+
+JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniStopProfiler
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string profile = jsBridgeContext->stopProfiler();
+  auto returnValue = JStringLocalRef(jniContext, profile.c_str());
+
+  // Prevent auto-releasing the localref returned to Java
+  returnValue.detach();
+
+  return returnValue.get();
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniStartTrafficRecording
+    (JNIEnv *env, jobject, jlong lctx, jint samplingInterval, jlong maxSizeBytes) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  jsBridgeContext->getTrafficRecorder()->start(samplingInterval, static_cast<size_t>(std::max(maxSizeBytes, jlong(0))));
+}
+
+JNIEXPORT jbyteArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniStopTrafficRecording
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::vector<uint8_t> recording = jsBridgeContext->getTrafficRecorder()->stop();
+  JArrayLocalRef<jbyte> recordingArray(jniContext, static_cast<jsize>(recording.size()));
+  recordingArray.setRegion(0, static_cast<jsize>(recording.size()), reinterpret_cast<const jbyte *>(recording.data()));
+
+  // Prevent auto-releasing the localref returned to Java
+  recordingArray.detach();
+
+  return static_cast<jbyteArray>(recordingArray.get());
+}
+
+JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniTakeHeapSnapshot
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string heapSnapshot = jsBridgeContext->takeHeapSnapshot();
+  auto returnValue = JStringLocalRef(jniContext, heapSnapshot.c_str());
+
+  // Prevent auto-releasing the localref returned to Java
+  returnValue.detach();
+
+  return returnValue.get();
+}
+
+JNIEXPORT jlongArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetConversionStats
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  // Flat values (see ConversionStats::getStats()), empty if the conversion counters are not compiled in
+#if defined(JSBRIDGE_CONVERSION_STATS)
+  const std::vector<int64_t> values = jsBridgeContext->getConversionStats()->getStats();
+  std::vector<jlong> jvalues(values.begin(), values.end());
+#else
+  std::vector<jlong> jvalues;
+#endif
+
+  JArrayLocalRef<jlong> valueArray(jniContext, static_cast<jsize>(jvalues.size()));
+  if (!jvalues.empty()) {
+    valueArray.setRegion(0, static_cast<jsize>(jvalues.size()), jvalues.data());
+  }
+
+  // Prevent auto-releasing the localref returned to Java
+  valueArray.detach();
+
+  return static_cast<jlongArray>(valueArray.get());
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniResetConversionStats
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+#if defined(JSBRIDGE_CONVERSION_STATS)
+  jsBridgeContext->getConversionStats()->reset();
+#else
+  (void) jsBridgeContext;
+#endif
+}
+
+JNIEXPORT jlongArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetAllocationStats
+    (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  // Process-wide counters (see AllocationStats::getStats()), empty if they are not compiled in
+#if defined(JSBRIDGE_ALLOCATION_STATS)
+  const std::vector<int64_t> values = AllocationStats::getStats();
+  std::vector<jlong> jvalues(values.begin(), values.end());
+#else
+  std::vector<jlong> jvalues;
+#endif
+
+  JArrayLocalRef<jlong> valueArray(jniContext, static_cast<jsize>(jvalues.size()));
+  if (!jvalues.empty()) {
+    valueArray.setRegion(0, static_cast<jsize>(jvalues.size()), jvalues.data());
+  }
+
+  // Prevent auto-releasing the localref returned to Java
+  valueArray.detach();
+
+  return static_cast<jlongArray>(valueArray.get());
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableModuleLoader
+        (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  jsBridgeContext->enableModuleLoader();
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJsModules
+        (JNIEnv *env, jobject, jlong lctx, jobjectArray names, jobjectArray contents, jboolean isBytecode) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  try {
+    jsBridgeContext->registerJsModules(JObjectArrayLocalRef(jniContext, names, JniLocalRefMode::Borrowed),
+                                       JObjectArrayLocalRef(jniContext, contents, JniLocalRefMode::Borrowed),
+                                       isBytecode);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableModuleNameNormalizer
+        (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+
+  try {
+    jsBridgeContext->enableModuleNameNormalizer();
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableTypedArrays
+        (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  jsBridgeContext->enableTypedArrays();
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableLightJavaMethods
+        (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  jsBridgeContext->enableLightJavaMethods();
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableStringCache
+        (JNIEnv *env, jobject, jlong lctx, jint entryCount) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  jsBridgeContext->enableStringCache(static_cast<size_t>(std::max(entryCount, jint(1))));
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniSetJniGlobalRefLimit
+        (JNIEnv *env, jobject, jlong lctx, jint limit) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  jsBridgeContext->setJniGlobalRefLimit(static_cast<size_t>(std::max(limit, jint(0))));
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableLocalStorage
+        (JNIEnv *env, jobject, jlong lctx, jstring filePath, jobjectArray initialKeys, jobjectArray initialValues) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strFilePath = JStringLocalRef(jniContext, filePath, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->enableLocalStorage(strFilePath,
+                                        JObjectArrayLocalRef(jniContext, initialKeys, JniLocalRefMode::Borrowed),
+                                        JObjectArrayLocalRef(jniContext, initialValues, JniLocalRefMode::Borrowed));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableConsole
+        (JNIEnv *env, jobject, jlong lctx, jint mode, jint minPriority, jint ringBufferSize) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+
+  try {
+    jsBridgeContext->enableConsole(static_cast<JsConsole::Mode>(mode), minPriority, static_cast<size_t>(std::max(ringBufferSize, 0)));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT jobjectArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDrainConsoleMessages
+        (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+  const JniCache *jniCache = jsBridgeContext->getJniCache();
+
+  std::vector<std::pair<int, std::string>> messages;
+  if (jsBridgeContext->getConsole() != nullptr) {
+    messages = jsBridgeContext->getConsole()->drain();
+  }
+
+  // [int[] priorities, String[] messages]
+  auto messageCount = static_cast<jsize>(messages.size());
+  std::vector<jint> priorities;
+  priorities.reserve(messages.size());
+  JObjectArrayLocalRef messageArray(jniContext, messageCount, jniCache->getJavaClass(JavaTypeId::String));
+  for (jsize i = 0; i < messageCount; ++i) {
+    priorities.push_back(messages[i].first);
+    messageArray.setElement(i, JStringLocalRef(jniContext, messages[i].second.c_str()));
+  }
+
+  JArrayLocalRef<jint> priorityArray(jniContext, messageCount);
+  priorityArray.setRegion(0, messageCount, priorities.data());
+
+  JObjectArrayLocalRef resultArray(jniContext, 2, jniCache->getJavaClass(JavaTypeId::Object));
+  resultArray.setElement(0, priorityArray);
+  resultArray.setElement(1, messageArray);
+
+  // Prevent auto-releasing the localref returned to Java
+  resultArray.detach();
+
+  return resultArray.get();
+}
+
+JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetCurrentScriptOrModuleName
+        (JNIEnv *env, jobject, jlong lctx, jint level) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string s = jsBridgeContext->getCurrentScriptOrModuleName(level);
+  auto returnValue = JStringLocalRef(jniContext, s.c_str());
+
+  // Prevent auto-releasing the localref returned to Java
+  returnValue.detach();
+
+  return returnValue.get();
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableBytecodeCache
+        (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  jsBridgeContext->enableBytecodeCache();
+}
+
+JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetBytecodeVersion
+        (JNIEnv *env, jobject, jlong lctx) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  auto returnValue = JStringLocalRef(jniContext, jsBridgeContext->getBytecodeVersion().c_str());
+
+  // Prevent auto-releasing the localref returned to Java
+  returnValue.detach();
+
+  return returnValue.get();
+}
+
+
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateString
+    (JNIEnv *env, jobject, jlong lctx, jstring code, jobject returnParameter, jboolean awaitJsPromise) {
+
+  //alog("jniEvaluateString()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  RecordedCall recordedCall(jsBridgeContext->getTrafficRecorder(), TrafficRecorder::CallType::EvaluateString, "");
+  if (recordedCall.isSampled()) {
+    recordedCall.addArgument(TrafficRecorder::describeJavaValue(jsBridgeContext, code));
+  }
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  JValue returnValue;
+  try {
+    returnValue = jsBridgeContext->evaluateString(JStringLocalRef(jniContext, code, JniLocalRefMode::Borrowed), JniLocalRef<jsBridgeParameter >(jniContext, returnParameter, JniLocalRefMode::Borrowed), awaitJsPromise);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return nullptr;
+  }
+
+  // Prevent auto-releasing the localref returned to Java
+  returnValue.detachLocalRef();
+
+  return returnValue.get().l;
+}
+
+// Same as jniEvaluateString() with awaitJsPromise, returning either the final value or (if the
+// resulting promise is not fulfilled yet) the given awaitingDeferred, completed once settled
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateStringAwaited
+    (JNIEnv *env, jobject, jlong lctx, jstring code, jobject returnParameter, jobject awaitingDeferred) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  RecordedCall recordedCall(jsBridgeContext->getTrafficRecorder(), TrafficRecorder::CallType::EvaluateString, "");
+  if (recordedCall.isSampled()) {
+    recordedCall.addArgument(TrafficRecorder::describeJavaValue(jsBridgeContext, code));
+  }
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  JValue returnValue;
+  try {
+    returnValue = jsBridgeContext->evaluateString(JStringLocalRef(jniContext, code, JniLocalRefMode::Borrowed),
+                                                  JniLocalRef<jsBridgeParameter>(jniContext, returnParameter, JniLocalRefMode::Borrowed),
+                                                  true /*awaitJsPromise*/,
+                                                  JniLocalRef<jobject>(jniContext, awaitingDeferred, JniLocalRefMode::Borrowed));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return nullptr;
+  }
+
+  // Prevent auto-releasing the localref returned to Java
+  returnValue.detachLocalRef();
+
+  return returnValue.get().l;
+}
+
+JNIEXPORT jint JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateInt
+    (JNIEnv *env, jobject, jlong lctx, jstring code) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  try {
+    return jsBridgeContext->evaluateScalar(JStringLocalRef(jniContext, code, JniLocalRefMode::Borrowed), JavaTypeId::Int).getInt();
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return 0;
+  }
+}
+
+JNIEXPORT jdouble JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateDouble
+    (JNIEnv *env, jobject, jlong lctx, jstring code) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  try {
+    return jsBridgeContext->evaluateScalar(JStringLocalRef(jniContext, code, JniLocalRefMode::Borrowed), JavaTypeId::Double).getDouble();
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return 0.0;
+  }
+}
+
+JNIEXPORT jboolean JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateBoolean
+    (JNIEnv *env, jobject, jlong lctx, jstring code) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  try {
+    return jsBridgeContext->evaluateScalar(JStringLocalRef(jniContext, code, JniLocalRefMode::Borrowed), JavaTypeId::Boolean).getBool();
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return JNI_FALSE;
+  }
+}
+
+JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateToString
+    (JNIEnv *env, jobject, jlong lctx, jstring code) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  JValue returnValue;
+  try {
+    returnValue = jsBridgeContext->evaluateScalar(JStringLocalRef(jniContext, code, JniLocalRefMode::Borrowed), JavaTypeId::String);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return nullptr;
+  }
+
+  // Prevent auto-releasing the localref returned to Java
+  returnValue.detachLocalRef();
+
+  return static_cast<jstring>(returnValue.get().l);
+}
+
+JNIEXPORT jbyteArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateFileContent
+    (JNIEnv *env, jobject, jlong lctx, jstring code, jstring filename, jboolean asModule, jboolean returnBytecode) {
+
+  //alog("jniEvaluateFileContent()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strFilename = JStringLocalRef(jniContext, filename, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    auto bytecode = jsBridgeContext->evaluateFileContent(JStringLocalRef(jniContext, code, JniLocalRefMode::Borrowed), strFilename, asModule, returnBytecode);
+
+    // Prevent auto-releasing the localref returned to Java
+    bytecode.detach();
+
+    return static_cast<jbyteArray>(bytecode.get());
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return nullptr;
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateAsset
+    (JNIEnv *env, jobject, jlong lctx, jobject assetManager, jstring assetPath, jstring filename, jboolean asModule) {
+
+  //alog("jniEvaluateAsset()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strAssetPath = JStringLocalRef(jniContext, assetPath, JniLocalRefMode::Borrowed).toStdString();
+  std::string strFilename = JStringLocalRef(jniContext, filename, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->evaluateAsset(AAssetManager_fromJava(env, assetManager), strAssetPath, strFilename, asModule);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateBuiltInAsset
+    (JNIEnv *env, jobject, jlong lctx, jobject assetManager, jstring assetPath) {
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strAssetPath = JStringLocalRef(jniContext, assetPath, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->evaluateBuiltInAsset(AAssetManager_fromJava(env, assetManager), strAssetPath);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateBytecode
+    (JNIEnv *env, jobject, jlong lctx, jbyteArray bytecode, jstring filename) {
+
+  //alog("jniEvaluateBytecode()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strFilename = JStringLocalRef(jniContext, filename, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->evaluateBytecode(JArrayLocalRef<jbyte>(JniLocalRef<jarray>(jniContext, bytecode, JniLocalRefMode::Borrowed)), strFilename);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateBytecodeAsset
+    (JNIEnv *env, jobject, jlong lctx, jobject assetManager, jstring assetPath, jstring filename) {
+
+  //alog("jniEvaluateBytecodeAsset()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strAssetPath = JStringLocalRef(jniContext, assetPath, JniLocalRefMode::Borrowed).toStdString();
+  std::string strFilename = JStringLocalRef(jniContext, filename, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->evaluateBytecodeAsset(AAssetManager_fromJava(env, assetManager), strAssetPath, strFilename);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT jobjectArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniPrecompileFileContents
+    (JNIEnv *env, jobject, jobjectArray fileNames, jobjectArray contents, jboolean asModule, jint threadCount, jobjectArray errors) {
+
+  //alog("jniPrecompileFileContents()");
+
+  // Not bound to any JS context: can be called from any thread
+  JniContext jniContext(env);
+  JObjectArrayLocalRef errorsRef(&jniContext, errors, JniLocalRefMode::Borrowed);
+  JObjectArrayLocalRef bytecodes;
+
+  try {
+    bytecodes = JsBridgeContext::precompileFileContents(&jniContext,
+                                                        JObjectArrayLocalRef(&jniContext, fileNames, JniLocalRefMode::Borrowed),
+                                                        JObjectArrayLocalRef(&jniContext, contents, JniLocalRefMode::Borrowed),
+                                                        asModule, threadCount, errorsRef);
+  } catch (const std::exception &e) {
+    jniContext.throwNew(jniContext.findClass("java/lang/IllegalArgumentException"), e.what());
+  }
+
+  // Prevent auto-releasing the localref returned to Java
+  bytecodes.detach();
+
+  return bytecodes.get();
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJavaObject
+    (JNIEnv *env, jobject, jlong lctx, jstring name, jobject javaObject, jstring prototypeName, jobjectArray javaMethods, jboolean lazyMethods) {
+
+  //alog("jniRegisterJavaObject()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strName = JStringLocalRef(jniContext, name, JniLocalRefMode::Borrowed).toUtf8Chars();
+  std::string strPrototypeName = JStringLocalRef(jniContext, prototypeName, JniLocalRefMode::Borrowed).toUtf8Chars();
+
+  try {
+    jsBridgeContext->registerJavaObject(strName, JniLocalRef<jobject>(jniContext, javaObject, JniLocalRefMode::Borrowed),
+                                       strPrototypeName,
+                                       JObjectArrayLocalRef(jniContext, javaMethods, JniLocalRefMode::Borrowed),
+                                       lazyMethods);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+// Register many Java objects in a single JNI call (e.g. at startup). The arrays are parallel: the
+// i-th object is registered with the i-th name, prototype name and methods. On error, the objects
+// before the failing one stay registered.
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJavaObjects
+    (JNIEnv *env, jobject, jlong lctx, jobjectArray names, jobjectArray javaObjects, jobjectArray prototypeNames, jobjectArray javaMethods, jboolean lazyMethods) {
+
+  //alog("jniRegisterJavaObjects()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  JObjectArrayLocalRef nameArray(jniContext, names, JniLocalRefMode::Borrowed);
+  JObjectArrayLocalRef javaObjectArray(jniContext, javaObjects, JniLocalRefMode::Borrowed);
+  JObjectArrayLocalRef prototypeNameArray(jniContext, prototypeNames, JniLocalRefMode::Borrowed);
+  JObjectArrayLocalRef javaMethodsArray(jniContext, javaMethods, JniLocalRefMode::Borrowed);
+  const jsize count = nameArray.getLength();
+
+  try {
+    for (jsize i = 0; i < count; ++i) {
+      std::string strName = JStringLocalRef(nameArray.getElement<jstring>(i)).toUtf8Chars();
+      std::string strPrototypeName = JStringLocalRef(prototypeNameArray.getElement<jstring>(i)).toUtf8Chars();
+
+      jsBridgeContext->registerJavaObject(strName, javaObjectArray.getElement(i), strPrototypeName,
+                                         JObjectArrayLocalRef(javaMethodsArray.getElement<jobjectArray>(i)),
+                                         lazyMethods);
+    }
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJavaLambda
+    (JNIEnv *env, jobject, jlong lctx, jstring name, jobject javaObject, jobject javaMethod) {
+
+  //alog("jniRegisterJavaLambda()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strName = JStringLocalRef(jniContext, name, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->registerJavaLambda(strName, JniLocalRef<jobject>(jniContext, javaObject, JniLocalRefMode::Borrowed),
+                                       JniLocalRef<jsBridgeMethod>(jniContext, javaMethod, JniLocalRefMode::Borrowed));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJsObject
+    (JNIEnv *env, jobject, jlong lctx, jstring name, jobjectArray methods, jboolean check) {
+
+  //alog("jniRegisterJsObject()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strName = JStringLocalRef(jniContext, name, JniLocalRefMode::Borrowed).toUtf8Chars();
+
+  try {
+    return jsBridgeContext->registerJsObject(strName, JObjectArrayLocalRef(jniContext, methods, JniLocalRefMode::Borrowed), check);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+
+  return 0;
+}
+
+// Register many JS objects in a single JNI call and return their binding handles (in the same
+// order as the names). On error, the bindings already created in this call are released.
+JNIEXPORT jlongArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJsObjects
+    (JNIEnv *env, jobject, jlong lctx, jobjectArray names, jobjectArray methods, jboolean check) {
+
+  //alog("jniRegisterJsObjects()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  JObjectArrayLocalRef nameArray(jniContext, names, JniLocalRefMode::Borrowed);
+  JObjectArrayLocalRef methodsArray(jniContext, methods, JniLocalRefMode::Borrowed);
+  const jsize count = nameArray.getLength();
+
+  std::vector<jlong> bindingHandles;
+  bindingHandles.reserve(count);
+
+  try {
+    for (jsize i = 0; i < count; ++i) {
+      std::string strName = JStringLocalRef(nameArray.getElement<jstring>(i)).toUtf8Chars();
+      bindingHandles.push_back(jsBridgeContext->registerJsObject(
+          strName, JObjectArrayLocalRef(methodsArray.getElement<jobjectArray>(i)), check));
+    }
+  } catch (const std::exception &e) {
+    for (jlong handle : bindingHandles) {
+      jsBridgeContext->releaseJsValueHandle(handle);
+    }
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return nullptr;
+  }
+
+  JArrayLocalRef<jlong> bindingHandleArray(jniContext, count);
+  bindingHandleArray.setRegion(0, count, bindingHandles.data());
+
+  // Prevent auto-releasing the localref returned to Java
+  bindingHandleArray.detach();
+
+  return static_cast<jlongArray>(bindingHandleArray.get());
+}
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJsLambda
+    (JNIEnv *env, jobject, jlong lctx, jstring name, jobject method) {
+
+  //alog("jniRegisterJsLambda()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strName = JStringLocalRef(jniContext, name, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    return jsBridgeContext->registerJsLambda(strName, JniLocalRef<jsBridgeMethod>(jniContext, method, JniLocalRefMode::Borrowed));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+
+  return 0;
+}
+
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsMethod
+    (JNIEnv *env, jobject, jlong lctx, jstring objectName, jint methodIndex, jobjectArray args, jboolean awaitJsPromise) {
+
+  //alog("jniCallJsMethod()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strObjectName = JStringLocalRef(jniContext, objectName, JniLocalRefMode::Borrowed).toUtf8Chars();
+  RecordedCall recordedCall(jsBridgeContext->getTrafficRecorder(), TrafficRecorder::CallType::CallJsMethod, strObjectName.c_str());
+  recordJavaArguments(recordedCall, jsBridgeContext, args);
+
+  JValue value;
+
+  try {
+    value = jsBridgeContext->callJsMethod(strObjectName,
+                                          methodIndex,
+                                          JObjectArrayLocalRef(jniContext, args, JniLocalRefMode::Borrowed),
+                                          awaitJsPromise);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+
+  // Prevent auto-releasing the localref returned to Java
+  value.detachLocalRef();
+
+  return value.get().l;
+}
+
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsMethodBinding
+    (JNIEnv *env, jobject, jlong lctx, jlong bindingHandle, jint methodIndex, jobjectArray args, jboolean awaitJsPromise) {
+
+  //alog("jniCallJsMethodBinding()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  JValue value;
+
+  try {
+    value = jsBridgeContext->callJsMethod(bindingHandle,
+                                          methodIndex,
+                                          JObjectArrayLocalRef(jniContext, args, JniLocalRefMode::Borrowed),
+                                          awaitJsPromise);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+
+  // Prevent auto-releasing the localref returned to Java
+  value.detachLocalRef();
+
+  return value.get().l;
+}
+
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsMethodBindingPacked
+    (JNIEnv *env, jobject, jlong lctx, jlong bindingHandle, jint methodIndex, jlongArray packedArgs, jboolean awaitJsPromise) {
+
+  //alog("jniCallJsMethodBindingPacked()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  JValue value;
+
+  try {
+    value = jsBridgeContext->callJsMethod(bindingHandle,
+                                          methodIndex,
+                                          JArrayLocalRef<jlong>(JniLocalRef<jarray>(jniContext, packedArgs, JniLocalRefMode::Borrowed)),
+                                          awaitJsPromise);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+
+  // Prevent auto-releasing the localref returned to Java
+  value.detachLocalRef();
+
+  return value.get().l;
+}
+
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsLambda
+    (JNIEnv *env, jobject, jlong lctx, jstring objectName, jobjectArray args, jboolean awaitJsPromise) {
+
+  //alog("jniCallJsLambda()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strObjectName = JStringLocalRef(jniContext, objectName, JniLocalRefMode::Borrowed).toStdString();
+  RecordedCall recordedCall(jsBridgeContext->getTrafficRecorder(), TrafficRecorder::CallType::CallJsLambda, strObjectName.c_str());
+  recordJavaArguments(recordedCall, jsBridgeContext, args);
+
+  JValue value;
+
+  try {
+    value = jsBridgeContext->callJsLambda(strObjectName,
+                                          JObjectArrayLocalRef(jniContext, args, JniLocalRefMode::Borrowed),
+                                          awaitJsPromise);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+
+// Prevent auto-releasing the localref returned to Java
+  value.detachLocalRef();
+
+  return value.get().l;
+}
+
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsLambdaBinding
+    (JNIEnv *env, jobject, jlong lctx, jlong bindingHandle, jobjectArray args, jboolean awaitJsPromise) {
+
+  //alog("jniCallJsLambdaBinding()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  JValue value;
+
+  try {
+    value = jsBridgeContext->callJsLambda(bindingHandle,
+                                          JObjectArrayLocalRef(jniContext, args, JniLocalRefMode::Borrowed),
+                                          awaitJsPromise);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+
+  // Prevent auto-releasing the localref returned to Java
+  value.detachLocalRef();
+
+  return value.get().l;
+}
+
+JNIEXPORT jobjectArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsLambdaBatch
+    (JNIEnv *env, jobject, jlong lctx, jlong bindingHandle, jobjectArray argsArray, jboolean awaitJsPromise) {
+
+  //alog("jniCallJsLambdaBatch()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  JObjectArrayLocalRef results;
+
+  try {
+    results = jsBridgeContext->callJsLambdaBatch(bindingHandle,
+                                                 JObjectArrayLocalRef(jniContext, argsArray, JniLocalRefMode::Borrowed),
+                                                 awaitJsPromise);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+
+  // Prevent auto-releasing the localref returned to Java
+  results.detach();
+
+  return results.get();
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniAssignJsValue
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jstring jsCode) {
+
+  //alog("jniAssignJsValue()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toUtf8Chars();
+
+  try {
+    jsBridgeContext->assignJsValue(strGlobalName, JStringLocalRef(jniContext, jsCode, JniLocalRefMode::Borrowed));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCopyJsValue
+    (JNIEnv *env, jobject, jlong lctx, jstring globalNameTo, jstring globalNameFrom) {
+
+  //alog("jniCopyJsValue()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalNameTo = JStringLocalRef(jniContext, globalNameTo, JniLocalRefMode::Borrowed).toStdString();
+  std::string strGlobalNameFrom = JStringLocalRef(jniContext, globalNameFrom, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->copyJsValue(strGlobalNameTo, strGlobalNameFrom);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniNewJsFunction
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jobjectArray args, jstring jsCode) {
+
+  //alog("jniNewJsFunction()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toUtf8Chars();
+  JObjectArrayLocalRef objectArgs(jniContext, args, JniLocalRefMode::Borrowed);
+  JStringLocalRef strCode(jniContext, jsCode, JniLocalRefMode::Borrowed);
+
+  try {
+    jsBridgeContext->newJsFunction(strGlobalName, objectArgs, strCode);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
 }
 
-extern "C" {
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCopyJsValueHandle
+    (JNIEnv *env, jobject, jlong lctx, jstring globalNameTo, jlong handle) {
 
-JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCreateContext(JNIEnv *env, jobject object) {
+  //alog("jniCopyJsValueHandle()");
 
-  alog("jniCreateContext()");
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
 
-  auto jsBridgeContext = new JsBridgeContext();
-  auto jniContext = new JniContext(env, JniContext::EnvironmentSource::Manual);
+  std::string strGlobalNameTo = JStringLocalRef(jniContext, globalNameTo, JniLocalRefMode::Borrowed).toStdString();
 
   try {
-    jsBridgeContext->init(jniContext, JniLocalRef<jobject>(jniContext, object, JniLocalRefMode::Borrowed));
-  } catch (const std::bad_alloc &) {
-    return 0L;
+    jsBridgeContext->copyJsValueHandle(strGlobalNameTo, handle);
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
   }
-
-  return reinterpret_cast<jlong>(jsBridgeContext);
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniStartDebugger
-    (JNIEnv *env, jobject, jlong lctx, jint port) {
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniReleaseJsValues
+    (JNIEnv *env, jobject, jlong lctx, jlongArray handles, jobjectArray globalNames) {
+
+  //alog("jniReleaseJsValues()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
-  jsBridgeContext->startDebugger(port);
+  TRACE_JNI_CALL(jsBridgeContext);
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  // Copy all the handles at once instead of one JNI call per released JsValue
+  JArrayLocalRef<jlong> handleArray(JniLocalRef<jarray>(jniContext, handles, JniLocalRefMode::Borrowed));
+  std::vector<jlong> handleValues(static_cast<size_t>(handleArray.getLength()));
+  handleArray.getRegion(0, static_cast<jsize>(handleValues.size()), handleValues.data());
+
+  JObjectArrayLocalRef globalNameArray(jniContext, globalNames, JniLocalRefMode::Borrowed);
+  jsize globalNameCount = globalNameArray.getLength();
+
+  try {
+    for (jlong handle : handleValues) {
+      jsBridgeContext->releaseJsValueHandle(handle);
+    }
+
+    for (jsize i = 0; i < globalNameCount; ++i) {
+      JStringLocalRef globalName(globalNameArray.getElement<jstring>(i));
+      jsBridgeContext->deleteJsValue(globalName.toStdString());
+    }
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCancelDebug
-    (JNIEnv *env, jobject, jlong lctx) {
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJsValueProperty
+    (JNIEnv *env, jobject, jlong lctx, jlong handle, jstring globalName, jstring key, jint index, jobject returnParameter) {
+
+  //alog("jniGetJsValueProperty()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
-  jsBridgeContext->cancelDebug();
+  TRACE_JNI_CALL(jsBridgeContext);
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  JValue returnValue;
+  try {
+    returnValue = jsBridgeContext->getJsValueProperty(handle, strGlobalName, JStringLocalRef(jniContext, key, JniLocalRefMode::Borrowed), index,
+                                                      JniLocalRef<jsBridgeParameter>(jniContext, returnParameter, JniLocalRefMode::Borrowed));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return nullptr;
+  }
+
+  // Prevent auto-releasing the localref returned to Java
+  returnValue.detachLocalRef();
+
+  return returnValue.get().l;
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteContext
-    (JNIEnv *env, jobject, jlong lctx) {
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniSetJsValueProperty
+    (JNIEnv *env, jobject, jlong lctx, jlong handle, jstring globalName, jstring key, jint index, jobject value, jobject parameter) {
 
-  alog("jniDeleteContext()");
+  //alog("jniSetJsValueProperty()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
   auto jniContext = jsBridgeContext->getJniContext();
 
-  delete jsBridgeContext;
-  delete jniContext;
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  try {
+    jsBridgeContext->setJsValueProperty(handle, strGlobalName, JStringLocalRef(jniContext, key, JniLocalRefMode::Borrowed), index,
+                                        JniLocalRef<jobject>(jniContext, value, JniLocalRefMode::Borrowed),
+                                        JniLocalRef<jsBridgeParameter>(jniContext, parameter, JniLocalRefMode::Borrowed));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+  }
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableModuleLoader
-        (JNIEnv *env, jobject, jlong lctx) {
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsValueMethod
+    (JNIEnv *env, jobject, jlong lctx, jlong handle, jstring globalName, jstring methodName, jobjectArray args, jobject returnParameter) {
+
+  //alog("jniCallJsValueMethod()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
-  jsBridgeContext->enableModuleLoader();
+  TRACE_JNI_CALL(jsBridgeContext);
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
+  auto jniContext = jsBridgeContext->getJniContext();
+
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  JValue returnValue;
+  try {
+    returnValue = jsBridgeContext->callJsValueMethod(handle, strGlobalName, JStringLocalRef(jniContext, methodName, JniLocalRefMode::Borrowed),
+                                                     JObjectArrayLocalRef(jniContext, args, JniLocalRefMode::Borrowed),
+                                                     JniLocalRef<jsBridgeParameter>(jniContext, returnParameter, JniLocalRefMode::Borrowed));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return nullptr;
+  }
+
+  // Prevent auto-releasing the localref returned to Java
+  returnValue.detachLocalRef();
+
+  return returnValue.get().l;
 }
 
-JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetCurrentScriptOrModuleName
-        (JNIEnv *env, jobject, jlong lctx, jint level) {
+JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJsValueType
+    (JNIEnv *env, jobject, jlong lctx, jlong handle, jstring globalName) {
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
-  std::string s = jsBridgeContext->getCurrentScriptOrModuleName(level);
-  auto returnValue = JStringLocalRef(jniContext, s.c_str());
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+
+  JStringLocalRef returnValue;
+  try {
+    returnValue = JStringLocalRef(jniContext, jsBridgeContext->getJsValueType(handle, strGlobalName));
+  } catch (const std::exception &e) {
+    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return nullptr;
+  }
 
   // Prevent auto-releasing the localref returned to Java
   returnValue.detach();
@@ -117,284 +1412,423 @@ JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jn
   return returnValue.get();
 }
 
-
-JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateString
-    (JNIEnv *env, jobject, jlong lctx, jstring code, jobject returnParameter, jboolean awaitJsPromise) {
-
-  //alog("jniEvaluateString()");
+JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJsExceptionJsonValue
+    (JNIEnv *env, jobject, jlong lctx, jlong errorHandle) {
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
-  auto jniContext = jsBridgeContext->getJniContext();
+  TRACE_JNI_CALL(jsBridgeContext);
 
-  JValue returnValue;
+  JStringLocalRef returnValue;
   try {
-    returnValue = jsBridgeContext->evaluateString(JStringLocalRef(jniContext, code, JniLocalRefMode::Borrowed), JniLocalRef<jsBridgeParameter >(jniContext, returnParameter, JniLocalRefMode::Borrowed), awaitJsPromise);
+    returnValue = jsBridgeContext->getExceptionHandler()->getJsonValue(errorHandle);
   } catch (const std::exception &e) {
     jsBridgeContext->getExceptionHandler()->jniThrow(e);
     return nullptr;
   }
 
   // Prevent auto-releasing the localref returned to Java
-  returnValue.detachLocalRef();
+  returnValue.detach();
 
-  return returnValue.get().l;
+  return returnValue.get();
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateFileContent
-    (JNIEnv *env, jobject, jlong lctx, jstring code, jstring filename, jboolean asModule) {
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniConvertJavaValueToJs
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jobject javaValue, jobject parameter) {
 
-  //alog("jniEvaluateFileContent()");
+  //alog("jniConvertJavaValueToJs()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
-  std::string strFilename = JStringLocalRef(jniContext, filename, JniLocalRefMode::Borrowed).toStdString();
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+  JniLocalRef<jobject> javaValueRef(jniContext, javaValue, JniLocalRefMode::Borrowed);
+  JniLocalRef<jsBridgeParameter> parameterRef(jniContext, parameter, JniLocalRefMode::Borrowed);
 
   try {
-    jsBridgeContext->evaluateFileContent(JStringLocalRef(jniContext, code, JniLocalRefMode::Borrowed), strFilename, asModule);
+    jsBridgeContext->convertJavaValueToJs(strGlobalName, javaValueRef, parameterRef);
   } catch (const std::exception &e) {
     jsBridgeContext->getExceptionHandler()->jniThrow(e);
   }
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJavaObject
-    (JNIEnv *env, jobject, jlong lctx, jstring name, jobject javaObject, jobjectArray javaMethods) {
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniParseJsonBuffer
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jobject byteBuffer, jint offset, jint length) {
 
-  //alog("jniRegisterJavaObject()");
+  //alog("jniParseJsonBuffer()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
-  std::string strName = JStringLocalRef(jniContext, name, JniLocalRefMode::Borrowed).toUtf8Chars();
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
 
   try {
-    jsBridgeContext->registerJavaObject(strName, JniLocalRef<jobject>(jniContext, javaObject, JniLocalRefMode::Borrowed),
-                                       JObjectArrayLocalRef(jniContext, javaMethods, JniLocalRefMode::Borrowed));
+    jsBridgeContext->parseJsonBuffer(strGlobalName, JniLocalRef<jobject>(jniContext, byteBuffer, JniLocalRefMode::Borrowed), offset, length);
   } catch (const std::exception &e) {
     jsBridgeContext->getExceptionHandler()->jniThrow(e);
   }
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJavaLambda
-    (JNIEnv *env, jobject, jlong lctx, jstring name, jobject javaObject, jobject javaMethod) {
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniAssignDirectBuffer
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jobject byteBuffer, jint offset, jint length, jboolean asUtf8String) {
 
-  //alog("jniRegisterJavaLambda()");
+  //alog("jniAssignDirectBuffer()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
-  std::string strName = JStringLocalRef(jniContext, name, JniLocalRefMode::Borrowed).toStdString();
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
 
   try {
-    jsBridgeContext->registerJavaLambda(strName, JniLocalRef<jobject>(jniContext, javaObject, JniLocalRefMode::Borrowed),
-                                       JniLocalRef<jsBridgeMethod>(jniContext, javaMethod, JniLocalRefMode::Borrowed));
+    jsBridgeContext->assignDirectBuffer(strGlobalName, JniLocalRef<jobject>(jniContext, byteBuffer, JniLocalRefMode::Borrowed), offset, length, asUtf8String);
   } catch (const std::exception &e) {
     jsBridgeContext->getExceptionHandler()->jniThrow(e);
   }
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJsObject
-    (JNIEnv *env, jobject, jlong lctx, jstring name, jobjectArray methods, jboolean check) {
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniWriteJsMessage
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName) {
 
-  //alog("jniRegisterJsObject()");
+  //alog("jniWriteJsMessage()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
-  std::string strName = JStringLocalRef(jniContext, name, JniLocalRefMode::Borrowed).toUtf8Chars();
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
 
   try {
-    jsBridgeContext->registerJsObject(strName, JObjectArrayLocalRef(jniContext, methods, JniLocalRefMode::Borrowed), check);
+    return jsBridgeContext->writeJsMessage(strGlobalName);
   } catch (const std::exception &e) {
     jsBridgeContext->getExceptionHandler()->jniThrow(e);
   }
+
+  return 0;
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJsLambda
-    (JNIEnv *env, jobject, jlong lctx, jstring name, jobject method) {
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniReadJsMessage
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jlong messageHandle) {
 
-  //alog("jniRegisterJsLambda()");
+  //alog("jniReadJsMessage()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
-  std::string strName = JStringLocalRef(jniContext, name, JniLocalRefMode::Borrowed).toStdString();
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
 
   try {
-    jsBridgeContext->registerJsLambda(strName, JniLocalRef<jsBridgeMethod>(jniContext, method, JniLocalRefMode::Borrowed));
+    jsBridgeContext->readJsMessage(strGlobalName, messageHandle);
   } catch (const std::exception &e) {
     jsBridgeContext->getExceptionHandler()->jniThrow(e);
   }
 }
 
-JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsMethod
-    (JNIEnv *env, jobject, jlong lctx, jstring objectName, jobject javaMethod, jobjectArray args, jboolean awaitJsPromise) {
+JNIEXPORT jbyteArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniWriteJsSnapshot
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName) {
 
-  //alog("jniCallJsMethod()");
+  //alog("jniWriteJsSnapshot()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
-  std::string strObjectName = JStringLocalRef(jniContext, objectName, JniLocalRefMode::Borrowed).toUtf8Chars();
-
-  JValue value;
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
 
   try {
-    value = jsBridgeContext->callJsMethod(strObjectName,
-                                          JniLocalRef<jobject>(jniContext, javaMethod, JniLocalRefMode::Borrowed),
-                                          JObjectArrayLocalRef(jniContext, args, JniLocalRefMode::Borrowed),
-                                          awaitJsPromise);
+    auto snapshot = jsBridgeContext->writeJsSnapshot(strGlobalName);
+
+    // Prevent auto-releasing the localref returned to Java
+    snapshot.detach();
+
+    return static_cast<jbyteArray>(snapshot.get());
   } catch (const std::exception &e) {
     jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return nullptr;
   }
-
-  // Prevent auto-releasing the localref returned to Java
-  value.detachLocalRef();
-
-  return value.get().l;
 }
 
-JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsLambda
-    (JNIEnv *env, jobject, jlong lctx, jstring objectName, jobjectArray args, jboolean awaitJsPromise) {
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniReadJsSnapshot
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jbyteArray snapshot) {
 
-  //alog("jniCallJsLambda()");
+  //alog("jniReadJsSnapshot()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
-  std::string strObjectName = JStringLocalRef(jniContext, objectName, JniLocalRefMode::Borrowed).toStdString();
-
-  JValue value;
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
 
   try {
-    value = jsBridgeContext->callJsLambda(strObjectName,
-                                          JObjectArrayLocalRef(jniContext, args, JniLocalRefMode::Borrowed),
-                                          awaitJsPromise);
+    jsBridgeContext->readJsSnapshot(strGlobalName, JArrayLocalRef<jbyte>(JniLocalRef<jarray>(jniContext, snapshot, JniLocalRefMode::Borrowed)));
   } catch (const std::exception &e) {
     jsBridgeContext->getExceptionHandler()->jniThrow(e);
   }
+}
 
-// Prevent auto-releasing the localref returned to Java
-  value.detachLocalRef();
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteJsMessage
+    (JNIEnv *, jclass, jlong messageHandle) {
 
-  return value.get().l;
+  // Not bound to any JS context: can be called from any thread
+  JsBridgeContext::deleteJsMessage(messageHandle);
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniAssignJsValue
-    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jstring jsCode) {
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniNewJsSharedBuffer
+    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jint size) {
 
-  //alog("jniAssignJsValue()");
+  //alog("jniNewJsSharedBuffer()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
-  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toUtf8Chars();
+  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+  JniLocalRef<jobject> byteBuffer;
 
   try {
-    jsBridgeContext->assignJsValue(strGlobalName, JStringLocalRef(jniContext, jsCode, JniLocalRefMode::Borrowed));
+    byteBuffer = jsBridgeContext->newJsSharedBuffer(strGlobalName, size);
   } catch (const std::exception &e) {
     jsBridgeContext->getExceptionHandler()->jniThrow(e);
   }
+
+  // Prevent auto-releasing the localref returned to Java
+  byteBuffer.detach();
+
+  return byteBuffer.get();
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteJsValue
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniNotifyJsSharedBuffer
     (JNIEnv *env, jobject, jlong lctx, jstring globalName) {
 
-  //alog("jniDeleteJsValue()");
+  //alog("jniNotifyJsSharedBuffer()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
 
   std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
 
   try {
-    jsBridgeContext->deleteJsValue(strGlobalName);
+    jsBridgeContext->notifyJsSharedBuffer(strGlobalName);
   } catch (const std::exception &e) {
     jsBridgeContext->getExceptionHandler()->jniThrow(e);
   }
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCopyJsValue
-    (JNIEnv *env, jobject, jlong lctx, jstring globalNameTo, jstring globalNameFrom) {
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniReleaseJsSharedBuffer
+    (JNIEnv *env, jclass, jobject byteBuffer) {
 
-  //alog("jniCopyJsValue()");
+  // Not bound to any JS context: can be called from any thread
+  void *data = env->GetDirectBufferAddress(byteBuffer);
+  if (data != nullptr) {
+    JsBridgeContext::releaseJsSharedBuffer(data);
+  }
+}
 
-  auto jsBridgeContext = getJsBridgeContext(env, lctx);
-  auto jniContext = jsBridgeContext->getJniContext();
+JNIEXPORT jint JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniWaitForJsSharedBufferNotify
+    (JNIEnv *env, jclass, jobject byteBuffer, jint notifyCount, jlong timeoutMs) {
 
-  std::string strGlobalNameTo = JStringLocalRef(jniContext, globalNameTo, JniLocalRefMode::Borrowed).toStdString();
-  std::string strGlobalNameFrom = JStringLocalRef(jniContext, globalNameFrom, JniLocalRefMode::Borrowed).toStdString();
+  // Not bound to any JS context: can be called from any thread
+  void *data = env->GetDirectBufferAddress(byteBuffer);
+  if (data == nullptr) {
+    return notifyCount;
+  }
+
+  return JsBridgeContext::waitForJsSharedBufferNotify(data, notifyCount, timeoutMs);
+}
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniNewJsCommandQueue
+    (JNIEnv *, jclass) {
+
+  return reinterpret_cast<jlong>(new JsCommandQueue());
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteJsCommandQueue
+    (JNIEnv *, jclass, jlong commandQueueHandle) {
+
+  delete reinterpret_cast<JsCommandQueue *>(commandQueueHandle);
+}
+
+JNIEXPORT jboolean JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniPostJsCommand
+    (JNIEnv *env, jclass, jlong commandQueueHandle, jint type, jstring globalName, jstring payload) {
+
+  // Not bound to any JS context: can be called from any thread
+  JniContext jniContext(env);
+  auto commandQueue = reinterpret_cast<JsCommandQueue *>(commandQueueHandle);
+
+  JsCommandQueue::Command command;
+  command.type = static_cast<JsCommandQueue::Type>(type);
+  command.globalName = JStringLocalRef(&jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
+  if (payload != nullptr) {
+    command.payload = JStringLocalRef(&jniContext, payload, JniLocalRefMode::Borrowed).toStdString();
+  }
+
+  return static_cast<jboolean>(commandQueue->push(std::move(command)));
+}
+
+JNIEXPORT jbyteArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEncodeJsonPayload
+    (JNIEnv *env, jclass, jstring json) {
+
+  // Not bound to any JS context: can be called from any thread
+  JniContext jniContext(env);
+  JStringLocalRef jsonRef(&jniContext, json, JniLocalRefMode::Borrowed);
 
   try {
-    jsBridgeContext->copyJsValue(strGlobalNameTo, strGlobalNameFrom);
+    std::string payload = JavaTypes::Payload::encodeJson(std::string_view(jsonRef.toUtf8Chars(), jsonRef.utf8Length()));
+    JArrayLocalRef<jbyte> payloadArray(&jniContext, static_cast<jsize>(payload.size()));
+    payloadArray.setRegion(0, static_cast<jsize>(payload.size()), reinterpret_cast<const jbyte *>(payload.data()));
+
+    // Prevent auto-releasing the localref returned to Java
+    payloadArray.detach();
+
+    return static_cast<jbyteArray>(payloadArray.get());
   } catch (const std::exception &e) {
-    jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    jniContext.throwNew(jniContext.findClass("java/lang/IllegalArgumentException"), e.what());
+    return nullptr;
   }
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniNewJsFunction
-    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jobjectArray args, jstring jsCode) {
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRequestYield
+    (JNIEnv *, jclass, jlong lctx) {
 
-  //alog("jniNewJsFunction()");
+  // Called from any thread (the JsBridge ensures that the context is not deleted in the meantime):
+  // the JniContext must not be touched
+  reinterpret_cast<JsBridgeContext *>(lctx)->getExecutionDeadline()->requestYield();
+}
 
-  auto jsBridgeContext = getJsBridgeContext(env, lctx);
-  auto jniContext = jsBridgeContext->getJniContext();
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniClearYieldRequest
+    (JNIEnv *, jclass, jlong lctx) {
 
-  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toUtf8Chars();
-  JObjectArrayLocalRef objectArgs(jniContext, args, JniLocalRefMode::Borrowed);
-  JStringLocalRef strCode(jniContext, jsCode, JniLocalRefMode::Borrowed);
+  // Called in the JS thread before each task (see jniRequestYield())
+  reinterpret_cast<JsBridgeContext *>(lctx)->getExecutionDeadline()->clearYieldRequest();
+}
+
+JNIEXPORT jboolean JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniWriteNativeProfile
+    (JNIEnv *env, jclass, jstring filePath) {
+
+#if defined(JSBRIDGE_PGO_GENERATE)
+  // Not bound to any JS context: can be called from any thread
+  JniContext jniContext(env);
+  std::string strFilePath = JStringLocalRef(&jniContext, filePath, JniLocalRefMode::Borrowed).toStdString();
+
+  __llvm_profile_set_filename(strFilePath.c_str());
+  return static_cast<jboolean>(__llvm_profile_write_file() == 0);
+#else
+  return JNI_FALSE;
+#endif
+}
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniProcessJsCommands
+    (JNIEnv *env, jobject, jlong lctx, jlong commandQueueHandle) {
+
+  //alog("jniProcessJsCommands()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
 
   try {
-    jsBridgeContext->newJsFunction(strGlobalName, objectArgs, strCode);
+    jsBridgeContext->processJsCommands(reinterpret_cast<JsCommandQueue *>(commandQueueHandle));
   } catch (const std::exception &e) {
     jsBridgeContext->getExceptionHandler()->jniThrow(e);
   }
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniConvertJavaValueToJs
-    (JNIEnv *env, jobject, jlong lctx, jstring globalName, jobject javaValue, jobject parameter) {
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCompleteJsPromise
+    (JNIEnv *env, jobject, jlong lctx, jlong promiseObjectHandle, jboolean isFulfilled, jobject value) {
 
-  //alog("jniConvertJavaValueToJs()");
+  //alog("jniCompleteJsPromise()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
-  std::string strGlobalName = JStringLocalRef(jniContext, globalName, JniLocalRefMode::Borrowed).toStdString();
-  JniLocalRef<jobject> javaValueRef(jniContext, javaValue, JniLocalRefMode::Borrowed);
-  JniLocalRef<jsBridgeParameter> parameterRef(jniContext, parameter, JniLocalRefMode::Borrowed);
+  JniLocalRef<jobject> valueRef(jniContext, value, JniLocalRefMode::Borrowed);
 
   try {
-    jsBridgeContext->convertJavaValueToJs(strGlobalName, javaValueRef, parameterRef);
+    JavaTypes::Deferred::completeJsPromise(jsBridgeContext, promiseObjectHandle, isFulfilled, valueRef);
   } catch (const std::exception &e) {
     jsBridgeContext->getExceptionHandler()->jniThrow(e);
   }
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCompleteJsPromise
-    (JNIEnv *env, jobject, jlong lctx, jstring id, jboolean isFulfilled, jobject value) {
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCompleteJsPromises
+    (JNIEnv *env, jobject, jlong lctx, jlongArray promiseObjectHandles, jbooleanArray fulfilledFlags, jobjectArray values) {
 
-  //alog("jniCompleteJsPromise()");
+  //alog("jniCompleteJsPromises()");
 
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
   auto jniContext = jsBridgeContext->getJniContext();
 
-  std::string strId = JStringLocalRef(jniContext, id, JniLocalRefMode::Borrowed).toUtf8Chars();
-  JniLocalRef<jobject> valueRef(jniContext, value, JniLocalRefMode::Borrowed);
+  JArrayLocalRef<jlong> handlesRef(JniLocalRef<jarray>(jniContext, promiseObjectHandles, JniLocalRefMode::Borrowed));
+  JArrayLocalRef<jboolean> fulfilledFlagsRef(JniLocalRef<jarray>(jniContext, fulfilledFlags, JniLocalRefMode::Borrowed));
+  JObjectArrayLocalRef valuesRef(jniContext, values, JniLocalRefMode::Borrowed);
+
+  const jsize count = handlesRef.getLength();
+  std::vector<jlong> handles(static_cast<size_t>(count));
+  std::vector<jboolean> isFulfilled(static_cast<size_t>(count));
+  if (count > 0) {
+    handlesRef.getRegion(0, count, handles.data());
+    fulfilledFlagsRef.getRegion(0, count, isFulfilled.data());
+  }
+
+  // Complete all the promises even if one of them fails and report the first error
+  std::exception_ptr firstError;
+  JniChunkedLocalFrame localFrame(jniContext, static_cast<size_t>(count));
+  for (jsize i = 0; i < count; ++i) {
+    localFrame.next();
+
+    try {
+      JavaTypes::Deferred::completeJsPromise(jsBridgeContext, handles[i], isFulfilled[i] == JNI_TRUE, valuesRef.getElement(i));
+    } catch (const std::exception &) {
+      if (!firstError) {
+        firstError = std::current_exception();
+      }
+    }
+  }
+
+  if (firstError) {
+    try {
+      std::rethrow_exception(firstError);
+    } catch (const std::exception &e) {
+      jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    }
+  }
+}
+
+JNIEXPORT jboolean JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniProcessPromiseQueue
+  (JNIEnv *env, jobject, jlong lctx, jint maxJobs, jlong timeBudgetMs) {
+
+  //alog("jniProcessPromiseQueue()");
+
+  auto jsBridgeContext = getJsBridgeContext(env, lctx);
+  TRACE_JNI_CALL(jsBridgeContext);
+
+  // Direct nested call from Java code called by JS: postpone the pending jobs to the next tick
+  // so that they do not run in the middle of the outer JS code
+  if (jsBridgeContext->getExecutionDeadline()->isInScope()) {
+    return static_cast<jboolean>(jsBridgeContext->isJobPending());
+  }
+
+  ExecutionDeadline::Scope executionDeadlineScope(*jsBridgeContext->getExecutionDeadline());
 
   try {
-    JavaTypes::Deferred::completeJsPromise(jsBridgeContext, strId, isFulfilled, valueRef);
+    return static_cast<jboolean>(jsBridgeContext->processPromiseQueue(maxJobs, timeBudgetMs));
   } catch (const std::exception &e) {
     jsBridgeContext->getExceptionHandler()->jniThrow(e);
+    return JNI_FALSE;
   }
 }
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniProcessPromiseQueue
+JNIEXPORT jboolean JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniIsJobPending
   (JNIEnv *env, jobject, jlong lctx) {
 
-  //alog("jniProcessPromiseQueue()");
-
   auto jsBridgeContext = getJsBridgeContext(env, lctx);
-  jsBridgeContext->processPromiseQueue();
+  return static_cast<jboolean>(jsBridgeContext->isJobPending());
 }
 
 }  // extern "C"
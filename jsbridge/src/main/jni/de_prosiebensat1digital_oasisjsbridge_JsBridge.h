@@ -26,7 +26,7 @@ extern "C" {
 #endif
 
 JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCreateContext
-  (JNIEnv *, jobject);
+  (JNIEnv *, jobject, jlong, jlong, jlong, jint, jboolean, jlong, jboolean, jlong);
 
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniStartDebug
     (JNIEnv *, jobject, jlong, jint);
@@ -37,55 +37,265 @@ JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCa
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteContext
   (JNIEnv *, jobject, jlong);
 
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRunGc
+  (JNIEnv *, jobject, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRunIdleGc
+  (JNIEnv *, jobject, jlong, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniOnMemoryPressure
+  (JNIEnv *, jobject, jlong, jboolean);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniSetJsThreadScheduling
+  (JNIEnv *, jobject, jlong, jboolean, jint, jlong);
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJsHeapSize
+  (JNIEnv *, jobject, jlong);
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCompactHeap
+  (JNIEnv *, jobject, jlong);
+
+JNIEXPORT jlongArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetMemoryUsage
+  (JNIEnv *, jobject, jlong);
+
+JNIEXPORT jlongArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetStartupTimings
+  (JNIEnv *, jobject, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableCallTracing
+  (JNIEnv *, jobject, jlong);
+
+JNIEXPORT jobjectArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetCallTraceStats
+  (JNIEnv *, jobject, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniResetCallTraceStats
+  (JNIEnv *, jobject, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniStartProfiler
+  (JNIEnv *, jobject, jlong, jlong);
+
+JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniStopProfiler
+  (JNIEnv *, jobject, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniStartTrafficRecording
+  (JNIEnv *, jobject, jlong, jint, jlong);
+
+JNIEXPORT jbyteArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniStopTrafficRecording
+  (JNIEnv *, jobject, jlong);
+
+JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniTakeHeapSnapshot
+  (JNIEnv *, jobject, jlong);
+
+JNIEXPORT jlongArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetConversionStats
+  (JNIEnv *, jobject, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniResetConversionStats
+  (JNIEnv *, jobject, jlong);
+
+JNIEXPORT jlongArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetAllocationStats
+  (JNIEnv *, jobject, jlong);
+
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableModuleLoader
         (JNIEnv *, jobject, jlong);
 
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJsModules
+        (JNIEnv *, jobject, jlong, jobjectArray, jobjectArray, jboolean);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableModuleNameNormalizer
+        (JNIEnv *, jobject, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableTypedArrays
+        (JNIEnv *, jobject, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableLightJavaMethods
+        (JNIEnv *, jobject, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableStringCache
+        (JNIEnv *, jobject, jlong, jint);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniSetJniGlobalRefLimit
+        (JNIEnv *, jobject, jlong, jint);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableLocalStorage
+        (JNIEnv *, jobject, jlong, jstring, jobjectArray, jobjectArray);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableConsole
+        (JNIEnv *, jobject, jlong, jint, jint, jint);
+
+JNIEXPORT jobjectArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDrainConsoleMessages
+        (JNIEnv *, jobject, jlong);
+
 JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetCurrentScriptOrModuleName
         (JNIEnv *, jobject, jlong, jint);
 
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEnableBytecodeCache
+        (JNIEnv *, jobject, jlong);
+
+JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetBytecodeVersion
+        (JNIEnv *, jobject, jlong);
+
 JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateString
   (JNIEnv *, jobject, jlong, jstring, jobject, jboolean);
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateFileContent
-  (JNIEnv *, jobject, jlong, jstring, jstring, jboolean asModule);
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateStringAwaited
+  (JNIEnv *, jobject, jlong, jstring, jobject, jobject);
+
+JNIEXPORT jint JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateInt
+  (JNIEnv *, jobject, jlong, jstring);
+
+JNIEXPORT jdouble JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateDouble
+  (JNIEnv *, jobject, jlong, jstring);
+
+JNIEXPORT jboolean JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateBoolean
+  (JNIEnv *, jobject, jlong, jstring);
+
+JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateToString
+  (JNIEnv *, jobject, jlong, jstring);
+
+JNIEXPORT jbyteArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateFileContent
+  (JNIEnv *, jobject, jlong, jstring, jstring, jboolean asModule, jboolean returnBytecode);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateAsset
+    (JNIEnv *, jobject, jlong, jobject, jstring, jstring, jboolean);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateBuiltInAsset
+    (JNIEnv *, jobject, jlong, jobject, jstring);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateBytecode
+  (JNIEnv *, jobject, jlong, jbyteArray, jstring);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEvaluateBytecodeAsset
+  (JNIEnv *, jobject, jlong, jobject, jstring, jstring);
+
+JNIEXPORT jobjectArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniPrecompileFileContents
+    (JNIEnv *, jobject, jobjectArray, jobjectArray, jboolean, jint, jobjectArray);
 
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJavaObject
-    (JNIEnv *, jobject, jlong, jstring, jobject, jobjectArray);
+    (JNIEnv *, jobject, jlong, jstring, jobject, jstring, jobjectArray, jboolean);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJavaObjects
+    (JNIEnv *, jobject, jlong, jobjectArray, jobjectArray, jobjectArray, jobjectArray, jboolean);
 
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJavaLambda
     (JNIEnv *, jobject, jlong, jstring, jobject, jobject);
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJsObject
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJsObject
     (JNIEnv *, jobject, jlong, jstring, jobjectArray, jboolean);
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJsLambda
+JNIEXPORT jlongArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJsObjects
+    (JNIEnv *, jobject, jlong, jobjectArray, jobjectArray, jboolean);
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRegisterJsLambda
     (JNIEnv *, jobject, jlong, jstring, jobject);
 
 JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsMethod
-    (JNIEnv *, jobject, jlong, jstring, jobject, jobjectArray, jboolean awaitJsPromise);
+    (JNIEnv *, jobject, jlong, jstring, jint, jobjectArray, jboolean awaitJsPromise);
+
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsMethodBinding
+    (JNIEnv *, jobject, jlong, jlong, jint, jobjectArray, jboolean);
 
 JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsLambda
     (JNIEnv *, jobject, jlong, jstring, jobjectArray, jboolean);
 
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsLambdaBinding
+    (JNIEnv *, jobject, jlong, jlong, jobjectArray, jboolean);
+
+JNIEXPORT jobjectArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsLambdaBatch
+    (JNIEnv *, jobject, jlong, jlong, jobjectArray, jboolean);
+
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniAssignJsValue
 (JNIEnv *, jobject, jlong, jstring, jstring);
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteJsValue
-    (JNIEnv *, jobject, jlong, jstring);
-
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCopyJsValue
     (JNIEnv *, jobject, jlong, jstring, jstring);
 
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniNewJsFunction
 (JNIEnv *, jobject, jlong, jstring, jobjectArray, jstring);
 
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCopyJsValueHandle
+    (JNIEnv *, jobject, jlong, jstring, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniReleaseJsValues
+    (JNIEnv *, jobject, jlong, jlongArray, jobjectArray);
+
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJsValueProperty
+    (JNIEnv *, jobject, jlong, jlong, jstring, jstring, jint, jobject);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniSetJsValueProperty
+    (JNIEnv *, jobject, jlong, jlong, jstring, jstring, jint, jobject, jobject);
+
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCallJsValueMethod
+    (JNIEnv *, jobject, jlong, jlong, jstring, jstring, jobjectArray, jobject);
+
+JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJsValueType
+    (JNIEnv *, jobject, jlong, jlong, jstring);
+
+JNIEXPORT jstring JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniGetJsExceptionJsonValue
+    (JNIEnv *, jobject, jlong, jlong);
+
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniConvertJavaValueToJs
     (JNIEnv *, jobject, jlong, jstring, jobject, jobject);
 
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniParseJsonBuffer
+    (JNIEnv *, jobject, jlong, jstring, jobject, jint, jint);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniAssignDirectBuffer
+    (JNIEnv *, jobject, jlong, jstring, jobject, jint, jint, jboolean);
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniWriteJsMessage
+    (JNIEnv *, jobject, jlong, jstring);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniReadJsMessage
+    (JNIEnv *, jobject, jlong, jstring, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteJsMessage
+    (JNIEnv *, jclass, jlong);
+
+JNIEXPORT jobject JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniNewJsSharedBuffer
+    (JNIEnv *, jobject, jlong, jstring, jint);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniNotifyJsSharedBuffer
+    (JNIEnv *, jobject, jlong, jstring);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniReleaseJsSharedBuffer
+    (JNIEnv *, jclass, jobject);
+
+JNIEXPORT jint JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniWaitForJsSharedBufferNotify
+    (JNIEnv *, jclass, jobject, jint, jlong);
+
+JNIEXPORT jlong JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniNewJsCommandQueue
+    (JNIEnv *, jclass);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniDeleteJsCommandQueue
+    (JNIEnv *, jclass, jlong);
+
+JNIEXPORT jboolean JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniPostJsCommand
+    (JNIEnv *, jclass, jlong, jint, jstring, jstring);
+
+JNIEXPORT jbyteArray JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniEncodeJsonPayload
+  (JNIEnv *, jclass, jstring);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniRequestYield
+  (JNIEnv *, jclass, jlong);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniClearYieldRequest
+  (JNIEnv *, jclass, jlong);
+
+JNIEXPORT jboolean JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniWriteNativeProfile
+    (JNIEnv *, jclass, jstring);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniProcessJsCommands
+    (JNIEnv *, jobject, jlong, jlong);
+
 JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCompleteJsPromise
-    (JNIEnv *, jobject, jlong, jstring, jboolean, jobject);
+    (JNIEnv *, jobject, jlong, jlong, jboolean, jobject);
+
+JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniCompleteJsPromises
+    (JNIEnv *, jobject, jlong, jlongArray, jbooleanArray, jobjectArray);
+
+JNIEXPORT jboolean JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniProcessPromiseQueue
+    (JNIEnv *, jobject, jlong, jint, jlong);
 
-JNIEXPORT void JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniProcessPromiseQueue
+JNIEXPORT jboolean JNICALL Java_de_prosiebensat1digital_oasisjsbridge_JsBridge_jniIsJobPending
     (JNIEnv *, jobject, jlong);
 
 #ifdef __cplusplus
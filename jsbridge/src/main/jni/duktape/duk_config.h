@@ -2900,12 +2900,15 @@ typedef struct duk_hthread duk_context;
  */
 
 #define DUK_USE_CPP_EXCEPTIONS
+/* JsBridge: the performance profile has no debugger support (see CMakeLists.txt) */
+#if !defined(JSBRIDGE_DUKTAPE_PERFORMANCE)
 #define DUK_USE_DEBUGGER_FWD_LOGGING
 #define DUK_USE_DEBUGGER_FWD_PRINTALERT
 #define DUK_USE_DEBUGGER_INSPECT
 #define DUK_USE_DEBUGGER_PAUSE_UNCAUGHT
 #define DUK_USE_DEBUGGER_SUPPORT
 #define DUK_USE_DEBUGGER_THROW_NOTIFY
+#endif
 #define DUK_USE_INTERRUPT_COUNTER
 #define DUK_USE_SYMBOL_BUILTIN
 
@@ -2971,11 +2974,18 @@ typedef struct duk_hthread duk_context;
 #undef DUK_USE_EXEC_INDIRECT_BOUND_CHECK
 #undef DUK_USE_EXEC_PREFER_SIZE
 #define DUK_USE_EXEC_REGCONST_OPTIMIZE
-#undef DUK_USE_EXEC_TIMEOUT_CHECK
+/* JsBridge: per-evaluation timeout (see ExecutionDeadline) */
+extern duk_bool_t jsbridge_duk_exec_timeout_check(void *udata);
+#define DUK_USE_EXEC_TIMEOUT_CHECK(udata) jsbridge_duk_exec_timeout_check((udata))
 #undef DUK_USE_EXPLICIT_NULL_INIT
 #undef DUK_USE_EXTSTR_FREE
 #undef DUK_USE_EXTSTR_INTERN_CHECK
+/* JsBridge: fastint arithmetic in the performance profile (see CMakeLists.txt) */
+#if defined(JSBRIDGE_DUKTAPE_PERFORMANCE)
+#define DUK_USE_FASTINT
+#else
 #undef DUK_USE_FASTINT
+#endif
 #define DUK_USE_FAST_REFCOUNT_DEFAULT
 #undef DUK_USE_FATAL_HANDLER
 #define DUK_USE_FATAL_MAXLEN 128
@@ -16808,6 +16808,241 @@ DUK_EXTERNAL void duk_inspect_callstack_entry(duk_hthread *thr, duk_int_t level)
 	 */
 }
 
+/* JsBridge: walk the call stack of the running thread from the innermost
+ * activation without any side effect (no allocation, no getter call) so that
+ * it can be used from the exec timeout check.  The returned strings point to
+ * the heap and must not be used once the execution has resumed.
+ */
+DUK_LOCAL const char *duk__jsbridge_get_string_prop(duk_hthread *thr, duk_hobject *func, duk_small_uint_t stridx) {
+	duk_tval *tv;
+
+	if (func == NULL) {
+		return "";
+	}
+	tv = duk_hobject_find_entry_tval_ptr_stridx(thr->heap, func, stridx);
+	if (tv == NULL || !DUK_TVAL_IS_STRING(tv)) {
+		return "";
+	}
+	return (const char *) DUK_HSTRING_GET_DATA(DUK_TVAL_GET_STRING(tv));
+}
+
+DUK_EXTERNAL duk_int_t jsbridge_duk_get_stack_frames(duk_hthread *thr, jsbridge_duk_stack_frame *frames, duk_int_t max_frames) {
+	duk_activation *act;
+	duk_hobject *func;
+	duk_int_t count = 0;
+
+	DUK_ASSERT(thr != NULL);
+
+	thr = thr->heap->curr_thread;
+	if (thr == NULL) {
+		return 0;
+	}
+
+	for (act = thr->callstack_curr; act != NULL && count < max_frames; act = act->parent) {
+		func = DUK_ACT_GET_FUNC(act);
+		frames[count].function_name = duk__jsbridge_get_string_prop(thr, func, DUK_STRIDX_NAME);
+		if (func != NULL && DUK_HOBJECT_IS_COMPFUNC(func)) {
+			frames[count].file_name = duk__jsbridge_get_string_prop(thr, func, DUK_STRIDX_FILE_NAME);
+#if defined(DUK_USE_DEBUGGER_SUPPORT)
+			frames[count].line_number = (duk_int_t) ((duk_hcompfunc *) func)->start_line;
+#else
+			frames[count].line_number = 0;  /* not tracked without debugger support */
+#endif
+		} else {
+			frames[count].file_name = "";
+			frames[count].line_number = 0;
+		}
+		count++;
+	}
+	return count;
+}
+
+/* JsBridge: report all the heap objects and buffers and their references
+ * without any side effect (same references as the mark-and-sweep, except the
+ * strings which are not reported).
+ */
+typedef struct {
+	const jsbridge_duk_heap_walk_funcs *funcs;
+	void *opaque;
+	duk_heaphdr *from;
+} duk__jsbridge_heap_walk_state;
+
+DUK_LOCAL const char *duk__jsbridge_get_key_name(duk_hstring *key) {
+	const duk_uint8_t *data = DUK_HSTRING_GET_DATA(key);
+
+	/* Skip the symbol markers (0x80-0x82 and 0xff, which are never valid
+	 * UTF-8 lead bytes) so that hidden keys stay readable.
+	 */
+	while (*data == 0x80U || *data == 0x81U || *data == 0x82U || *data == 0xffU) {
+		data++;
+	}
+	return (const char *) data;
+}
+
+DUK_LOCAL void duk__jsbridge_heap_walk_edge(duk__jsbridge_heap_walk_state *s, duk_heaphdr *to, const char *type, const char *name, duk_uint32_t index) {
+	if (to != NULL && DUK_HEAPHDR_GET_TYPE(to) != DUK_HTYPE_STRING) {
+		s->funcs->edge(s->opaque, s->from, to, type, name, index);
+	}
+}
+
+DUK_LOCAL void duk__jsbridge_heap_walk_tval_edge(duk__jsbridge_heap_walk_state *s, duk_tval *tv, const char *type, const char *name, duk_uint32_t index) {
+	if (DUK_TVAL_IS_HEAP_ALLOCATED(tv)) {
+		duk__jsbridge_heap_walk_edge(s, DUK_TVAL_GET_HEAPHDR(tv), type, name, index);
+	}
+}
+
+/* Name of the constructor of the given object, NULL if unknown */
+DUK_LOCAL const char *duk__jsbridge_get_constructor_name(duk_hthread *thr, duk_hobject *h) {
+	duk_hobject *proto = DUK_HOBJECT_GET_PROTOTYPE(thr->heap, h);
+	duk_tval *tv;
+	const char *name;
+
+	if (proto == NULL) {
+		return NULL;
+	}
+	tv = duk_hobject_find_entry_tval_ptr_stridx(thr->heap, proto, DUK_STRIDX_CONSTRUCTOR);
+	if (tv == NULL || !DUK_TVAL_IS_OBJECT(tv)) {
+		return NULL;
+	}
+	name = duk__jsbridge_get_string_prop(thr, DUK_TVAL_GET_OBJECT(tv), DUK_STRIDX_NAME);
+	return name[0] != '\0' ? name : NULL;
+}
+
+DUK_LOCAL void duk__jsbridge_heap_walk_hobject(duk_hthread *thr, duk__jsbridge_heap_walk_state *s, duk_hobject *h) {
+	duk_heap *heap = thr->heap;
+	duk_uint_fast32_t i;
+	const char *type;
+	const char *name = NULL;
+
+	/* node */
+	if (DUK_HOBJECT_IS_FUNCTION(h)) {
+		type = "closure";
+		name = duk__jsbridge_get_string_prop(thr, h, DUK_STRIDX_NAME);
+	} else if (DUK_HOBJECT_IS_ARRAY(h)) {
+		type = "array";
+	} else if (DUK_HOBJECT_GET_CLASS_NUMBER(h) == DUK_HOBJECT_CLASS_REGEXP) {
+		type = "regexp";
+	} else if (DUK_HOBJECT_IS_THREAD(h) || DUK_HOBJECT_IS_DECENV(h) || DUK_HOBJECT_IS_OBJENV(h)) {
+		type = "hidden";
+	} else {
+		type = "object";
+		name = duk__jsbridge_get_constructor_name(thr, h);
+	}
+	if (name == NULL || name[0] == '\0') {
+		name = (const char *) DUK_HSTRING_GET_DATA(DUK_HOBJECT_GET_CLASS_STRING(heap, h));
+	}
+	s->funcs->node(s->opaque, h, type, name, sizeof(duk_hobject) + DUK_HOBJECT_P_ALLOC_SIZE(h));
+
+	/* edges */
+	for (i = 0; i < (duk_uint_fast32_t) DUK_HOBJECT_GET_ENEXT(h); i++) {
+		duk_hstring *key = DUK_HOBJECT_E_GET_KEY(heap, h, i);
+		if (key == NULL) {
+			continue;
+		}
+		name = duk__jsbridge_get_key_name(key);
+		if (DUK_HOBJECT_E_SLOT_IS_ACCESSOR(heap, h, i)) {
+			duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) DUK_HOBJECT_E_GET_VALUE_PTR(heap, h, i)->a.get, "property", name, 0);
+			duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) DUK_HOBJECT_E_GET_VALUE_PTR(heap, h, i)->a.set, "property", name, 0);
+		} else {
+			duk__jsbridge_heap_walk_tval_edge(s, &DUK_HOBJECT_E_GET_VALUE_PTR(heap, h, i)->v, "property", name, 0);
+		}
+	}
+
+	for (i = 0; i < (duk_uint_fast32_t) DUK_HOBJECT_GET_ASIZE(h); i++) {
+		duk__jsbridge_heap_walk_tval_edge(s, DUK_HOBJECT_A_GET_VALUE_PTR(heap, h, i), "element", NULL, (duk_uint32_t) i);
+	}
+
+	duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) DUK_HOBJECT_GET_PROTOTYPE(heap, h), "property", "__proto__", 0);
+
+	if (DUK_HOBJECT_IS_COMPFUNC(h)) {
+		duk_hcompfunc *f = (duk_hcompfunc *) h;
+		duk_tval *tv, *tv_end;
+		duk_hobject **fn, **fn_end;
+
+		duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) DUK_HCOMPFUNC_GET_DATA(heap, f), "internal", "code", 0);
+		duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) DUK_HCOMPFUNC_GET_LEXENV(heap, f), "context", "lex_env", 0);
+		duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) DUK_HCOMPFUNC_GET_VARENV(heap, f), "context", "var_env", 0);
+		if (DUK_HCOMPFUNC_GET_DATA(heap, f) != NULL) {
+			tv_end = DUK_HCOMPFUNC_GET_CONSTS_END(heap, f);
+			for (tv = DUK_HCOMPFUNC_GET_CONSTS_BASE(heap, f); tv < tv_end; tv++) {
+				duk__jsbridge_heap_walk_tval_edge(s, tv, "internal", "constant", 0);
+			}
+			fn_end = DUK_HCOMPFUNC_GET_FUNCS_END(heap, f);
+			for (fn = DUK_HCOMPFUNC_GET_FUNCS_BASE(heap, f); fn < fn_end; fn++) {
+				duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) *fn, "internal", "function", 0);
+			}
+		}
+	} else if (DUK_HOBJECT_IS_DECENV(h)) {
+		duk_hdecenv *e = (duk_hdecenv *) h;
+		duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) e->thread, "internal", "thread", 0);
+		duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) e->varmap, "internal", "varmap", 0);
+	} else if (DUK_HOBJECT_IS_OBJENV(h)) {
+		duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) ((duk_hobjenv *) h)->target, "internal", "target", 0);
+#if defined(DUK_USE_BUFFEROBJECT_SUPPORT)
+	} else if (DUK_HOBJECT_IS_BUFOBJ(h)) {
+		duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) ((duk_hbufobj *) h)->buf, "internal", "buffer", 0);
+		duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) ((duk_hbufobj *) h)->buf_prop, "internal", "buffer", 0);
+#endif
+	} else if (DUK_HOBJECT_IS_BOUNDFUNC(h)) {
+		duk_hboundfunc *f = (duk_hboundfunc *) (void *) h;
+		duk_idx_t j;
+		duk__jsbridge_heap_walk_tval_edge(s, &f->target, "internal", "target", 0);
+		duk__jsbridge_heap_walk_tval_edge(s, &f->this_binding, "internal", "this", 0);
+		for (j = 0; j < f->nargs; j++) {
+			duk__jsbridge_heap_walk_tval_edge(s, &f->args[j], "internal", "argument", 0);
+		}
+#if defined(DUK_USE_ES6_PROXY)
+	} else if (DUK_HOBJECT_IS_PROXY(h)) {
+		duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) ((duk_hproxy *) h)->target, "internal", "target", 0);
+		duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) ((duk_hproxy *) h)->handler, "internal", "handler", 0);
+#endif
+	} else if (DUK_HOBJECT_IS_THREAD(h)) {
+		duk_hthread *t = (duk_hthread *) h;
+		duk_activation *act;
+		duk_tval *tv;
+
+		for (tv = t->valstack; tv < t->valstack_top; tv++) {
+			duk__jsbridge_heap_walk_tval_edge(s, tv, "internal", "value stack", 0);
+		}
+		for (act = t->callstack_curr; act != NULL; act = act->parent) {
+			duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) DUK_ACT_GET_FUNC(act), "internal", "call stack", 0);
+			duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) act->var_env, "context", "var_env", 0);
+			duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) act->lex_env, "context", "lex_env", 0);
+		}
+		duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) t->resumer, "internal", "resumer", 0);
+		for (i = 0; i < DUK_NUM_BUILTINS; i++) {
+			duk__jsbridge_heap_walk_edge(s, (duk_heaphdr *) t->builtins[i], "internal", "builtin", 0);
+		}
+	}
+}
+
+DUK_EXTERNAL void jsbridge_duk_walk_heap(duk_hthread *thr, const jsbridge_duk_heap_walk_funcs *funcs, void *opaque) {
+	duk_heap *heap;
+	duk_heaphdr *hdr;
+	duk__jsbridge_heap_walk_state s;
+
+	DUK_ASSERT(thr != NULL);
+
+	heap = thr->heap;
+	s.funcs = funcs;
+	s.opaque = opaque;
+
+	/* roots (see duk__mark_roots_heap()) */
+	s.from = NULL;
+	duk__jsbridge_heap_walk_edge(&s, (duk_heaphdr *) heap->heap_thread, "internal", "heap thread", 0);
+	duk__jsbridge_heap_walk_edge(&s, (duk_heaphdr *) heap->heap_object, "internal", "heap object", 0);
+	duk__jsbridge_heap_walk_edge(&s, (duk_heaphdr *) heap->curr_thread, "internal", "current thread", 0);
+
+	for (hdr = heap->heap_allocated; hdr != NULL; hdr = DUK_HEAPHDR_GET_NEXT(heap, hdr)) {
+		s.from = hdr;
+		if (DUK_HEAPHDR_GET_TYPE(hdr) == DUK_HTYPE_OBJECT) {
+			duk__jsbridge_heap_walk_hobject(thr, &s, (duk_hobject *) hdr);
+		} else if (DUK_HEAPHDR_GET_TYPE(hdr) == DUK_HTYPE_BUFFER) {
+			funcs->node(opaque, hdr, "native", "(buffer)", sizeof(duk_hbuffer) + DUK_HBUFFER_GET_SIZE((duk_hbuffer *) hdr));
+		}
+	}
+}
+
 /* automatic undefs */
 #undef DUK__IDX_ASIZE
 #undef DUK__IDX_BCBYTES
@@ -1136,6 +1136,25 @@ DUK_EXTERNAL_DECL duk_bool_t duk_put_global_heapptr(duk_context *ctx, void *ptr)
 DUK_EXTERNAL_DECL void duk_inspect_value(duk_context *ctx, duk_idx_t idx);
 DUK_EXTERNAL_DECL void duk_inspect_callstack_entry(duk_context *ctx, duk_int_t level);
 
+/* JsBridge: call stack sampling from the exec timeout check (see JsProfiler) */
+typedef struct {
+	const char *function_name;  /* "" if unknown, valid until the execution resumes */
+	const char *file_name;      /* "" if unknown (e.g. native function) */
+	duk_int_t line_number;      /* line of the function declaration, 0 if unknown */
+} jsbridge_duk_stack_frame;
+DUK_EXTERNAL_DECL duk_int_t jsbridge_duk_get_stack_frames(duk_context *ctx, jsbridge_duk_stack_frame *frames, duk_int_t max_frames);
+
+/* JsBridge: heap snapshot (see JsHeapSnapshot). The node and edge types are the ones of the
+ * Chrome DevTools heap snapshots ("object", "closure", "property", "element"...), the heap roots
+ * are reported as edges from NULL and the strings are only valid during the call.
+ */
+typedef struct {
+	void (*node)(void *opaque, const void *ptr, const char *type, const char *name, duk_size_t self_size);
+	/* name is NULL for elements */
+	void (*edge)(void *opaque, const void *from, const void *to, const char *type, const char *name, duk_uint32_t index);
+} jsbridge_duk_heap_walk_funcs;
+DUK_EXTERNAL_DECL void jsbridge_duk_walk_heap(duk_context *ctx, const jsbridge_duk_heap_walk_funcs *funcs, void *opaque);
+
 /*
  *  Object prototype
  */
@@ -17,15 +17,30 @@
 #include "jni-helpers/JniContext.h"
 #include "log.h"
 
-JniException::JniException(const JniContext *jniContext) {
+JniException::JniException(const JniContext *jniContext)
+ : JsBridgeException(Kind::Jni)
+ , m_jniContext(jniContext) {
+
   // First, clear the exception otherwise we cannot call any JNI method!
   jthrowable rawThrowable = jniContext->exceptionOccurred();
   assert(rawThrowable != nullptr);
 
-  m_throwable = JniLocalRef<jthrowable>(jniContext, rawThrowable, JniLocalRefMode::AutoReleased);
+  JniLocalRef<jthrowable> throwable(jniContext, rawThrowable, JniLocalRefMode::AutoReleased);
   jniContext->exceptionClear();
 
-  m_what = createMessage(jniContext, m_throwable);
+  m_throwable = JniGlobalRef<jthrowable>(throwable);
+}
+
+const char *JniException::what() const throw() {
+  if (m_what.empty()) {
+    if (m_jniContext->exceptionCheck()) {
+      // No JNI call is allowed while another Java exception is pending
+      return "Java exception";
+    }
+    m_what = createMessage(m_jniContext, getThrowable());
+  }
+
+  return m_what.c_str();
 }
 
 // static
@@ -16,6 +16,8 @@
 #ifndef _JSBRIDGE_JNIEXCEPTION_H
 #define _JSBRIDGE_JNIEXCEPTION_H
 
+#include "JsBridgeException.h"
+#include "jni-helpers/JniGlobalRef.h"
 #include "jni-helpers/JniLocalRef.h"
 #include <exception>
 #include <jni.h>
@@ -23,21 +25,23 @@
 
 class JniContext;
 
-class JniException : public std::exception {
+class JniException : public JsBridgeException {
 public:
   explicit JniException(const JniContext *);
 
-  const char *what() const throw() override {
-    return m_what.c_str();
-  }
+  // The message is only created when needed (Java exceptions propagated to JS do not need it)
+  const char *what() const throw() override;
 
-  const JniLocalRef<jthrowable> &getThrowable() const { return m_throwable; }
+  JniLocalRef<jthrowable> getThrowable() const { return JniLocalRef<jthrowable>(m_throwable); }
 
 private:
   static std::string createMessage(const JniContext *, const JniLocalRef<jthrowable> &);
 
-  JniLocalRef<jthrowable> m_throwable;
-  std::string m_what;
+  // Global ref: the exception may leave the local frame in which it has been created (see
+  // JniChunkedLocalFrame)
+  JniGlobalRef<jthrowable> m_throwable;
+  const JniContext *m_jniContext;
+  mutable std::string m_what;
 };
 
 #endif
@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JSBRIDGEEXCEPTION_H
+#define _JSBRIDGE_JSBRIDGEEXCEPTION_H
+
+#include <exception>
+
+// Base class of the exceptions thrown by the bridge. The kind allows classifying them with a
+// switch instead of a chain of dynamic_cast (see ExceptionHandler).
+class JsBridgeException : public std::exception {
+public:
+  enum class Kind {
+    Jni,  // JniException
+    Js,  // JsException
+  };
+
+  Kind kind() const { return m_kind; }
+
+protected:
+  explicit JsBridgeException(Kind kind)
+   : m_kind(kind) {}
+
+private:
+  Kind m_kind;
+};
+
+#endif
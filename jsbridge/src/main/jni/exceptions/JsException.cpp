@@ -14,20 +14,21 @@
  * limitations under the License.
  */
 #include "JsException.h"
+#include "ExceptionHandler.h"
 #include "JsBridgeContext.h"
 
 #if defined(QUICKJS)
+# include "AutoReleasedJSValue.h"
 # include "QuickJsUtils.h"
 #endif
 
 namespace {
 #if defined(DUKTAPE)
-  const char *ERROR_PROP_NAME_PREFIX = "JsException_error_";
-
-  std::string createMessage(const JsBridgeContext *jsBridgeContext, duk_idx_t idx) {
+  // [... error] => [... error]
+  std::string createMessage(const JsBridgeContext *jsBridgeContext) {
     duk_context *ctx = jsBridgeContext->getDuktapeContext();
 
-    duk_dup(ctx, idx);
+    duk_dup(ctx, -1);
     std::string ret = duk_safe_to_string(ctx, -1);
     duk_pop(ctx);
 
@@ -39,7 +40,9 @@ namespace {
     const QuickJsUtils *utils = jsBridgeContext->getUtils();
 
     if (JS_IsError(ctx, exceptionValue)) {
-      return utils->toString(JS_GetPropertyStr(ctx, exceptionValue, "message"));
+      JSValue messageValue = utils->getProperty(exceptionValue, QuickJsUtils::PropertyName::Message);
+      JS_AUTORELEASE_VALUE(ctx, messageValue);
+      return utils->toString(messageValue);
     }
 
     return utils->toString(exceptionValue);
@@ -50,59 +53,62 @@ namespace {
 #if defined(DUKTAPE)
 
 JsException::JsException(const JsBridgeContext *jsBridgeContext, duk_idx_t idx)
- : m_jsBridgeContext(jsBridgeContext)
- , m_what(createMessage(jsBridgeContext, idx)) {
-
-  duk_context *ctx = jsBridgeContext->getDuktapeContext();
-
-  static int counter = 0;
-  m_errorPropName = ERROR_PROP_NAME_PREFIX + std::to_string(++counter);
-
-  duk_idx_t errorIdx = duk_normalize_index(ctx, idx);
-
-  duk_push_heap_stash(ctx);
-  duk_dup(ctx, errorIdx);  // duplicate error
-  duk_put_prop_string(ctx, -2, m_errorPropName.c_str());
-  duk_pop(ctx);  // heap stash
+ : JsBridgeException(Kind::Js)
+ , m_jsBridgeContext(jsBridgeContext)
+ , m_errorSlot(jsBridgeContext->getExceptionHandler()->stashError(idx)) {
 }
 
 JsException::JsException(JsException &&other)
- : m_jsBridgeContext(other.m_jsBridgeContext) {
+ : JsBridgeException(Kind::Js)
+ , m_jsBridgeContext(other.m_jsBridgeContext)
+ , m_hasWhat(other.m_hasWhat) {
 
   std::swap(m_what, other.m_what);
-  std::swap(m_errorPropName, other.m_errorPropName);
+  std::swap(m_errorSlot, other.m_errorSlot);
 }
 
 JsException::~JsException() {
-  if (m_errorPropName.empty()) {
+  if (m_errorSlot == NO_ERROR_SLOT) {
     return;
   }
 
-  duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
-
-  duk_push_heap_stash(ctx);
-  duk_del_prop_string(ctx, -1, m_errorPropName.c_str());
-  duk_pop(ctx);  // heap stash
+  m_jsBridgeContext->getExceptionHandler()->releaseStashedError(m_errorSlot);
 }
 
 void JsException::pushError() const {
-  duk_context *ctx = m_jsBridgeContext->getDuktapeContext();
+  m_jsBridgeContext->getExceptionHandler()->pushStashedError(m_errorSlot);
+}
 
-  duk_push_heap_stash(ctx);
-  duk_get_prop_string(ctx, -1, m_errorPropName.c_str());
-  duk_remove(ctx, -2);  // heap stash
+const char *JsException::what() const throw() {
+  if (!m_hasWhat) {
+    pushError();
+    m_what = createMessage(m_jsBridgeContext);
+    duk_pop(m_jsBridgeContext->getDuktapeContext());  // error
+    m_hasWhat = true;
+  }
+
+  return m_what.c_str();
 }
 
 #elif defined(QUICKJS)
 
 JsException::JsException(const JsBridgeContext *jsBridgeContext, JSValue exceptionValue)
- : m_jsBridgeContext(jsBridgeContext)
- , m_value(exceptionValue)
- , m_what(createMessage(jsBridgeContext, exceptionValue)) {
+ : JsBridgeException(Kind::Js)
+ , m_jsBridgeContext(jsBridgeContext)
+ , m_value(exceptionValue) {
 }
 
 JsException::~JsException() {
   JS_FreeValue(m_jsBridgeContext->getQuickJsContext(), m_value);
 }
 
+const char *JsException::what() const throw() {
+  if (!m_hasWhat) {
+    m_what = createMessage(m_jsBridgeContext, m_value);
+    m_hasWhat = true;
+  }
+
+  return m_what.c_str();
+}
+
 #endif
@@ -16,6 +16,8 @@
 #ifndef _JSBRIDGE_JSEXCEPTION_H
 #define _JSBRIDGE_JSEXCEPTION_H
 
+#include "JsBridgeException.h"
+#include <cstdint>
 #include <exception>
 #include <jni.h>
 #include <string>
@@ -28,7 +30,7 @@
 
 class JsBridgeContext;
 
-class JsException : public std::exception {
+class JsException : public JsBridgeException {
 public:
 #if defined(DUKTAPE)
   // Pop the current JS exception to create a new C++ exception
@@ -47,16 +49,19 @@ public:
 
   ~JsException() override;
 
-  const char *what() const throw() override { return m_what.c_str(); }
+  // The message is only created when needed (e.g. not when the error is re-thrown to JS)
+  const char *what() const throw() override;
 
 private:
   const JsBridgeContext *m_jsBridgeContext;
 #if defined(DUKTAPE)
-  std::string m_errorPropName;
+  static const uint32_t NO_ERROR_SLOT = UINT32_MAX;  // moved-from instance
+  uint32_t m_errorSlot = NO_ERROR_SLOT;  // see ExceptionHandler::stashError()
 #elif defined(QUICKJS)
   JSValue m_value;
 #endif
-  std::string m_what;
+  mutable std::string m_what;
+  mutable bool m_hasWhat = false;
 };
 
 #endif
@@ -27,45 +27,71 @@
 #include "jni-helpers/JValue.h"
 #include <string>
 
+#if defined(QUICKJS)
+# include "QuickJsUtils.h"
+#endif
+
 namespace {
   JavaTypeId getArrayId(const JavaType *componentType) {
-    auto primitive = dynamic_cast<const JavaTypes::Primitive *>(componentType);
-    if (primitive == nullptr) {
+    if (!componentType->isPrimitive()) {
       return JavaTypeId::ObjectArray;
     }
-    return primitive->arrayId();
+    return static_cast<const JavaTypes::Primitive *>(componentType)->arrayId();
   }
 
-  std::unique_ptr<const JavaType> getComponentType(const JsBridgeContext *jsBridgeContext, const JniRef<jclass> &arrayJavaClass) {
+  std::shared_ptr<const JavaType> getComponentType(const JsBridgeContext *jsBridgeContext, const JniRef<jclass> &arrayJavaClass) {
     const JniContext *jniContext = jsBridgeContext->getJniContext();
-
-    JniLocalRef<jclass> javaClassClass = jsBridgeContext->getJniCache()->getJavaClassClass();
+    const JniCache *jniCache = jsBridgeContext->getJniCache();
 
     // Get the component class of the array
-    jmethodID getComponentType = jniContext->getMethodID(javaClassClass, "getComponentType", "()Ljava/lang/Class;");
-    JniLocalRef<jclass> javaClassRef = jniContext->callObjectMethod<jclass>(arrayJavaClass, getComponentType);
+    JniLocalRef<jclass> javaClassRef = jniCache->getJavaClassComponentType(arrayJavaClass);
     if (jniContext->exceptionCheck()) {
       throw JniException(jniContext);
     }
 
     // Get its Java name
-    jmethodID getName = jniContext->getMethodID(javaClassClass, "getName", "()Ljava/lang/String;");
-    if (jniContext->exceptionCheck()) {
-      throw JniException(jniContext);
-    }
-    JStringLocalRef javaNameRef = jniContext->callStringMethod(javaClassRef, getName);
+    JStringLocalRef javaNameRef = jniCache->getJavaClassName(javaClassRef);
     if (jniContext->exceptionCheck()) {
       throw JniException(jniContext);
     }
 
     const auto objectType = new JavaTypes::Object(jsBridgeContext, std::optional(JniGlobalRef(javaNameRef)));
-    return std::unique_ptr<const JavaType>(objectType);
+    return std::shared_ptr<const JavaType>(objectType);
   }
+
+#if defined(JSBRIDGE_CONVERSION_STATS)
+  // Estimated payload size of a primitive array (0 for object arrays whose elements are counted
+  // by their own JavaType)
+  size_t getArrayByteCount(const JniContext *jniContext, JavaTypeId arrayId, const JniLocalRef<jarray> &jArray) {
+    size_t elementSize;
+    switch (arrayId) {
+      case JavaTypeId::BooleanArray:
+      case JavaTypeId::ByteArray:
+        elementSize = 1;
+        break;
+      case JavaTypeId::ShortArray:
+        elementSize = 2;
+        break;
+      case JavaTypeId::IntArray:
+      case JavaTypeId::FloatArray:
+        elementSize = 4;
+        break;
+      case JavaTypeId::LongArray:
+      case JavaTypeId::DoubleArray:
+        elementSize = 8;
+        break;
+      default:
+        return 0;
+    }
+
+    return jArray.isNull() ? 0 : elementSize * jniContext->getArrayLength(jArray);
+  }
+#endif
 }
 
 namespace JavaTypes {
 
-Array::Array(const JsBridgeContext *jsBridgeContext, std::unique_ptr<const JavaType> &&componentType)
+Array::Array(const JsBridgeContext *jsBridgeContext, std::shared_ptr<const JavaType> &&componentType)
  : JavaType(jsBridgeContext, getArrayId(componentType.get()))
  , m_componentType(std::move(componentType)) {
 }
@@ -83,17 +109,21 @@ JValue Array::pop() const {
   CHECK_STACK_OFFSET(m_ctx, -1);
 
   if (duk_is_null_or_undefined(m_ctx, -1)) {
+    JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
     duk_pop(m_ctx);
     return JValue();
   }
 
-  if (!duk_is_array(m_ctx, -1)) {
+  // Note: typed arrays are also accepted for primitive arrays
+  if (!duk_is_array(m_ctx, -1) && !duk_is_buffer_data(m_ctx, -1)) {
     const auto message = std::string("Cannot convert ") + duk_safe_to_string(m_ctx, -1) + " to array";
     duk_pop(m_ctx);
     throw std::invalid_argument(message);
   }
 
-  return m_componentType->popArray(1, false);
+  JValue value = m_componentType->popArray(1, false);
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, getArrayByteCount(m_jniContext, getTypeId(), value.getLocalRef().staticCast<jarray>()));
+  return value;
 }
 
 duk_ret_t Array::push(const JValue &value) const {
@@ -101,6 +131,8 @@ duk_ret_t Array::push(const JValue &value) const {
 
   JniLocalRef<jarray> jArray(value.getLocalRef().staticCast<jarray>());
 
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, getArrayByteCount(m_jniContext, getTypeId(), jArray));
+
   if (jArray.isNull()) {
     duk_push_null(m_ctx);
     return 1;
@@ -113,19 +145,26 @@ duk_ret_t Array::push(const JValue &value) const {
 
 JValue Array::toJava(JSValueConst v) const {
   if (JS_IsNull(v) || JS_IsUndefined(v)) {
+    JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
     return JValue();
   }
 
-  if (!JS_IsArray(m_ctx, v)) {
+  // Note: typed arrays are also accepted for primitive arrays
+  size_t typedArrayByteLength;
+  if (!JS_IsArray(m_ctx, v) && getUtils()->getTypedArrayData(v, nullptr, &typedArrayByteLength) == nullptr) {
     throw std::invalid_argument("Cannot convert value to array");
   }
 
-  return m_componentType->toJavaArray(v);
+  JValue value = m_componentType->toJavaArray(v);
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, getArrayByteCount(m_jniContext, getTypeId(), value.getLocalRef().staticCast<jarray>()));
+  return value;
 }
 
 JSValue Array::fromJava(const JValue &value) const {
   JniLocalRef<jarray> jArray(value.getLocalRef().staticCast<jarray>());
 
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, getArrayByteCount(m_jniContext, getTypeId(), jArray));
+
   if (jArray.isNull()) {
     return JS_NULL;
   }
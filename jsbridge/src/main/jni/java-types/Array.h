@@ -26,7 +26,7 @@ namespace JavaTypes {
 class Array : public JavaType {
 
 public:
-  Array(const JsBridgeContext *, std::unique_ptr<const JavaType> &&componentType);
+  Array(const JsBridgeContext *, std::shared_ptr<const JavaType> &&componentType);
   Array(const JsBridgeContext *, const JniRef<jclass> &arrayJavaClass);
 
 #if defined(DUKTAPE)
@@ -38,7 +38,7 @@ public:
 #endif
 
 private:
-  std::unique_ptr<const JavaType> m_componentType;
+  std::shared_ptr<const JavaType> m_componentType;
 };
 
 }  // namespace JavaTypes
@@ -19,39 +19,60 @@
 #ifndef _JSBRIDGE_JAVATYPES_BOOLEAN_H
 #define _JSBRIDGE_JAVATYPES_BOOLEAN_H
 
-#include "Primitive.h"
+#include "PrimitiveType.h"
 
 namespace JavaTypes {
 
-class Boolean : public Primitive {
+struct BooleanTraits {
+  using JniType = jboolean;
 
-public:
-  Boolean(const JsBridgeContext *);
+  static constexpr JavaTypeId ID = JavaTypeId::Boolean;
+  static constexpr JavaTypeId BOXED_ID = JavaTypeId::BoxedBoolean;
+  static constexpr JavaTypeId ARRAY_ID = JavaTypeId::BooleanArray;
 
-#if defined(DUKTAPE)
-  JValue pop() const override;
-  JValue popArray(uint32_t count, bool expanded) const override;
+  static constexpr const char *JAVA_NAME = "boolean";
+  static constexpr const char *BOXED_JAVA_NAME = "Boolean";
 
-  duk_ret_t push(const JValue &) const override;
-  duk_ret_t pushArray(const JniLocalRef<jarray>& values, bool expand) const override;
-#elif defined(QUICKJS)
-  JValue toJava(JSValueConst) const override;
-  JValue toJavaArray(JSValueConst) const override;
+  static constexpr const char *BOX_SIGNATURE = "(Z)Ljava/lang/Boolean;";
+  static constexpr const char *UNBOX_METHOD_NAME = "booleanValue";
+  static constexpr const char *UNBOX_SIGNATURE = "()Z";
 
-  JSValue fromJava(const JValue &) const override;
-  JSValue fromJavaArray(const JniLocalRef<jarray>& values) const override;
+  // No typed array for booleans
+  using TypedArrayElement = jboolean;
+  static constexpr const char *TYPED_ARRAY_NAME = nullptr;
+  static constexpr const char *ALT_TYPED_ARRAY_NAME = nullptr;
+#if defined(DUKTAPE)
+  static constexpr duk_uint_t DUK_TYPED_ARRAY_TYPE = DUK_BUFOBJ_UINT8ARRAY;
 #endif
 
-  JValue callMethod(jmethodID, const JniRef<jobject> &javaThis, const std::vector<JValue> &args) const override;
+  static jboolean get(const JValue &value) { return value.getBool(); }
+
+  static jboolean callMethodA(const JniContext *jniContext, const JniRef<jobject> &javaThis, jmethodID methodId, const JValueArgs &args) {
+    return jniContext->callBooleanMethodA(javaThis, methodId, args);
+  }
+
+  static jboolean callMethod(const JniContext *jniContext, const JniRef<jobject> &object, jmethodID methodId) {
+    return jniContext->callBooleanMethod(object, methodId);
+  }
 
-  JavaTypeId arrayId() const override { return JavaTypeId::BooleanArray; }
+#if defined(DUKTAPE)
+  static bool isJsValue(duk_context *ctx, duk_idx_t index) { return duk_is_boolean(ctx, index); }
+  static jboolean getJsValue(duk_context *ctx, duk_idx_t index) { return static_cast<jboolean>(duk_require_boolean(ctx, index)); }
+  static void pushJsValue(duk_context *ctx, jboolean value) { duk_push_boolean(ctx, static_cast<duk_bool_t>(value == JNI_TRUE)); }
+#elif defined(QUICKJS)
+  static jboolean getJsValue(JSValueConst v, const char *javaName) {
+    if (!JS_IsBool(v)) {
+      throw std::invalid_argument(std::string("Cannot convert JS value to Java ") + javaName);
+    }
+    return static_cast<jboolean>(JS_VALUE_GET_BOOL(v));
+  }
 
-private:
-  JValue box(const JValue &) const override;
-  JValue unbox(const JValue &) const override;
+  static JSValue newJsValue(JSContext *ctx, jboolean value) { return JS_NewBool(ctx, value); }
+#endif
 };
 
+using Boolean = PrimitiveType<BooleanTraits>;
+
 }  // namespace JavaTypes
 
 #endif
-
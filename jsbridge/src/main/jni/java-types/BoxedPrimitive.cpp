@@ -31,7 +31,9 @@ namespace JavaTypes {
 
 BoxedPrimitive::BoxedPrimitive(const JsBridgeContext *jsBridgeContext, std::unique_ptr<Primitive> primitive)
  : JavaType(jsBridgeContext, primitive->boxedId())
- , m_primitive(std::move(primitive)) {
+ , m_primitive(std::move(primitive))
+ , m_primitiveJsToJava(m_primitive->getJsToJavaConversion())
+ , m_primitiveJavaToJs(m_primitive->getJavaToJsConversion()) {
 }
 
 #if defined(DUKTAPE)
@@ -44,7 +46,7 @@ JValue BoxedPrimitive::pop() const {
     return JValue();
   }
 
-  JValue primitiveValue = m_primitive->pop();
+  JValue primitiveValue = m_primitiveJsToJava.pop();
   return m_primitive->box(primitiveValue);
 }
 
@@ -57,7 +59,7 @@ duk_ret_t BoxedPrimitive::push(const JValue &value) const {
     return 1;
   }
 
-  return m_primitive->push(m_primitive->unbox(value));
+  return m_primitiveJavaToJs.push(m_primitive->unbox(value));
 }
 
 #elif defined(QUICKJS)
@@ -67,7 +69,7 @@ JValue BoxedPrimitive::toJava(JSValueConst v) const {
     return JValue();
   }
 
-  JValue primitiveValue = m_primitive->toJava(v);
+  JValue primitiveValue = m_primitiveJsToJava.toJava(v);
   return JValue(m_primitive->box(primitiveValue));
 }
 
@@ -78,10 +80,18 @@ JSValue BoxedPrimitive::fromJava(const JValue &value) const {
   }
 
   JValue unboxedValue = m_primitive->unbox(value);
-  return m_primitive->fromJava(unboxedValue);
+  return m_primitiveJavaToJs.fromJava(unboxedValue);
 }
 
 #endif
 
+JsToJavaConversion BoxedPrimitive::getJsToJavaConversion() const {
+  return directJsToJavaConversion(this);
+}
+
+JavaToJsConversion BoxedPrimitive::getJavaToJsConversion() const {
+  return directJavaToJsConversion(this);
+}
+
 }  // namespace JavaTypes
 
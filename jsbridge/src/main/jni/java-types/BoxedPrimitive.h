@@ -38,8 +38,14 @@ public:
   JSValue fromJava(const JValue &) const override;
 #endif
 
+  // Direct (non-virtual) conversions, e.g. for the elements of lists and arrays
+  JsToJavaConversion getJsToJavaConversion() const override;
+  JavaToJsConversion getJavaToJsConversion() const override;
+
 private:
   std::unique_ptr<Primitive> m_primitive;
+  JsToJavaConversion m_primitiveJsToJava;
+  JavaToJsConversion m_primitiveJavaToJs;
 };
 
 }  // namespace JavaTypes
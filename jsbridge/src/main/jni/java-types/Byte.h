@@ -19,40 +19,49 @@
 #ifndef _JSBRIDGE_JAVATYPES_BYTE_H
 #define _JSBRIDGE_JAVATYPES_BYTE_H
 
-#include "Primitive.h"
+#include "PrimitiveType.h"
 
 namespace JavaTypes {
 
-class Byte : public Primitive {
+struct ByteTraits : NumberTraits<jbyte> {
+  static constexpr JavaTypeId ID = JavaTypeId::Byte;
+  static constexpr JavaTypeId BOXED_ID = JavaTypeId::BoxedByte;
+  static constexpr JavaTypeId ARRAY_ID = JavaTypeId::ByteArray;
 
-public:
-    Byte(const JsBridgeContext *);
+  static constexpr const char *JAVA_NAME = "byte";
+  static constexpr const char *BOXED_JAVA_NAME = "Byte";
 
-#if defined(DUKTAPE)
-  JValue pop() const override;
-  JValue popArray(uint32_t count, bool expanded) const override;
-
-  duk_ret_t push(const JValue &) const override;
-  duk_ret_t pushArray(const JniLocalRef<jarray> &, bool expand) const override;
-#elif defined(QUICKJS)
-  JValue toJava(JSValueConst) const override;
-  JValue toJavaArray(JSValueConst) const override;
+  static constexpr const char *BOX_SIGNATURE = "(B)Ljava/lang/Byte;";
+  static constexpr const char *UNBOX_METHOD_NAME = "byteValue";
+  static constexpr const char *UNBOX_SIGNATURE = "()B";
 
-  JSValue fromJava(const JValue &) const override;
-  JSValue fromJavaArray(const JniLocalRef<jarray> &) const override;
+  using TypedArrayElement = jbyte;
+  static constexpr const char *TYPED_ARRAY_NAME = "Uint8Array";
+  static constexpr const char *ALT_TYPED_ARRAY_NAME = "Int8Array";
+#if defined(DUKTAPE)
+  static constexpr duk_uint_t DUK_TYPED_ARRAY_TYPE = DUK_BUFOBJ_UINT8ARRAY;
 #endif
 
-  JValue callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
-                    const std::vector<JValue> &args) const override;
+  static jbyte get(const JValue &value) { return value.getByte(); }
+
+  static jbyte callMethodA(const JniContext *jniContext, const JniRef<jobject> &javaThis, jmethodID methodId, const JValueArgs &args) {
+    return jniContext->callByteMethodA(javaThis, methodId, args);
+  }
 
-  JavaTypeId arrayId() const override { return JavaTypeId::IntArray; }
+  static jbyte callMethod(const JniContext *jniContext, const JniRef<jobject> &object, jmethodID methodId) {
+    return static_cast<jbyte>(jniContext->callByteMethod(object, methodId));
+  }
 
-private:
-  JValue box(const JValue &) const override;
-  JValue unbox(const JValue &) const override;
+#if defined(DUKTAPE)
+  static jbyte getJsValue(duk_context *ctx, duk_idx_t index) { return static_cast<jbyte>(duk_require_int(ctx, index)); }
+  static void pushJsValue(duk_context *ctx, jbyte value) { duk_push_int(ctx, value); }
+#elif defined(QUICKJS)
+  static JSValue newJsValue(JSContext *ctx, jbyte value) { return JS_NewInt32(ctx, value); }
+#endif
 };
 
+using Byte = PrimitiveType<ByteTraits>;
+
 }  // namespace JavaTypes
 
 #endif
-
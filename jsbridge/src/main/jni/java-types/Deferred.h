@@ -23,9 +23,9 @@ namespace JavaTypes {
 class Deferred : public JavaType {
 
 public:
-  static const char *PROMISE_COMPONENT_TYPE_PROP_NAME;
+  static constexpr char PROMISE_COMPONENT_TYPE_PROP_NAME[] = "\xff\xff" "promise_type";
 
-  Deferred(const JsBridgeContext *, std::unique_ptr<const JavaType> &&componentType);
+  Deferred(const JsBridgeContext *, std::shared_ptr<const JavaType> &&componentType);
 
 #if defined(DUKTAPE)
   JValue pop() const override;
@@ -37,9 +37,29 @@ public:
 
   bool isDeferred() const override { return true; }
 
-  static void completeJsPromise(const JsBridgeContext *, const std::string &strId, bool isFulfilled, const JniLocalRef<jobject> &value);
+  // Awaited JS promise to Java: the value of a promise which has already been fulfilled (or a
+  // value which is not a promise) is directly converted to the component type. Otherwise, the
+  // given Java Deferred (created by the caller) is completed once the promise gets settled and is
+  // returned instead. Unlike toJava()/pop(), no Java Deferred needs to be created and completed
+  // via JNI for immediately available values.
+#if defined(DUKTAPE)
+  JValue popAwaited(const JniLocalRef<jobject> &javaDeferred) const;
+#elif defined(QUICKJS)
+  JValue toJavaAwaited(JSValueConst, const JniLocalRef<jobject> &javaDeferred) const;
+#endif
+
+  // Complete the JS promise created by fromJava()/push() whose PromiseObject is stored in the
+  // JsValue table with the given handle (released afterwards)
+  static void completeJsPromise(const JsBridgeContext *, jlong handle, bool isFulfilled, const JniLocalRef<jobject> &value);
 
 private:
+  // Complete the given Java Deferred with the JS value (now or, for a promise, once settled)
+#if defined(DUKTAPE)
+  JValue popToJavaDeferred(const JniLocalRef<jobject> &javaDeferred) const;
+#elif defined(QUICKJS)
+  JValue toJavaDeferred(JSValueConst, const JniLocalRef<jobject> &javaDeferred) const;
+#endif
+
   std::shared_ptr<const JavaType> m_componentType;
 };
 
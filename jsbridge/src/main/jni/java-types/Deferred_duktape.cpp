@@ -15,18 +15,18 @@
  */
 #include "java-types/Deferred.h"
 
+#include "DuktapePromise.h"
 #include "ExceptionHandler.h"
 #include "JniCache.h"
 #include "JsBridgeContext.h"
+#include "JsValueTable.h"
 #include "StackChecker.h"
 #include "exceptions/JniException.h"
 #include "exceptions/JsException.h"
 #include "jni-helpers/JniContext.h"
 
 namespace {
-  const char *PAYLOAD_PROP_NAME = "\xff\xffpayload";
-  const char *PROMISE_OBJECT_PROP_NAME = "\xff\xff" "promise_object";
-  const char *PROMISE_OBJECT_GLOBAL_NAME_PREFIX = "javaTypes_deferred_promiseobject_";  // Note: initial "\xff\xff" removed because of JNI string conversion issues
+  const char PAYLOAD_PROP_NAME[] = "\xff\xffpayload";
 
   struct OnPromisePayload {
     JniGlobalRef<jobject> javaDeferred;
@@ -46,7 +46,7 @@ namespace {
       // Get the bound Java Deferred instance and the generic argument loader
       duk_push_current_function(ctx);
 
-      if (!duk_get_prop_string(ctx, -1, PAYLOAD_PROP_NAME)) {
+      if (!duk_get_prop_literal(ctx, -1, PAYLOAD_PROP_NAME)) {
         duk_pop_n(ctx, 2 + hasValue);  // (undefined) OnPromiseFulfilledPayload + current function + value
         return DUK_RET_ERROR;
       }
@@ -89,7 +89,7 @@ namespace {
       // Get the bound Java Deferred instance and the generic argument loader
       duk_push_current_function(ctx);
 
-      if (!duk_get_prop_string(ctx, -1, PAYLOAD_PROP_NAME)) {
+      if (!duk_get_prop_literal(ctx, -1, PAYLOAD_PROP_NAME)) {
         duk_pop_n(ctx, 2 + hasValue);  // (undefined) OnPromiseRejectedPayload + current function + value
         return DUK_RET_ERROR;
       }
@@ -129,7 +129,7 @@ namespace {
       JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
       assert(jsBridgeContext != nullptr);
 
-      if (duk_get_prop_string(ctx, -1, PAYLOAD_PROP_NAME)) {
+      if (duk_get_prop_literal(ctx, -1, PAYLOAD_PROP_NAME)) {
         delete reinterpret_cast<OnPromisePayload *>(duk_require_pointer(ctx, -1));
       }
 
@@ -137,40 +137,13 @@ namespace {
       return 0;
     }
 
-    // Add resolve and reject to bound PromiseObject instance
-    duk_ret_t promiseFunction(duk_context *ctx) {
-      CHECK_STACK(ctx);
-
-      JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
-      assert(jsBridgeContext != nullptr);
-
-      duk_require_function(ctx, 0);
-      duk_require_function(ctx, 1);
-
-      duk_push_current_function(ctx);
-
-      if (!duk_get_prop_string(ctx, -1, PROMISE_OBJECT_PROP_NAME)) {
-        duk_pop_2(ctx);  // (undefined) PromiseObject + current function
-        return DUK_RET_ERROR;
-      }
-
-      // Set PromiseObject.resolve and PromiseObject.reject
-      duk_dup(ctx, 0);
-      duk_put_prop_string(ctx, -2, "resolve");
-      duk_dup(ctx, 1);
-      duk_put_prop_string(ctx, -2, "reject");
-
-      duk_pop_2(ctx);  // PromiseObject + current function
-      return 0;
-    }
-
     duk_ret_t finalizePromiseObject(duk_context *ctx) {
       CHECK_STACK(ctx);
 
       JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
       assert(jsBridgeContext != nullptr);
 
-      if (duk_get_prop_string(ctx, -1, JavaTypes::Deferred::PROMISE_COMPONENT_TYPE_PROP_NAME)) {
+      if (duk_get_prop_literal(ctx, -1, JavaTypes::Deferred::PROMISE_COMPONENT_TYPE_PROP_NAME)) {
         delete reinterpret_cast<std::shared_ptr<const JavaType> *>(duk_require_pointer(ctx, -1));
       }
 
@@ -183,16 +156,14 @@ namespace {
 
 namespace JavaTypes {
 
-// static
-const char *Deferred::PROMISE_COMPONENT_TYPE_PROP_NAME = "\xff\xff" "promise_type";
-
-Deferred::Deferred(const JsBridgeContext *jsBridgeContext, std::unique_ptr<const JavaType> &&componentType)
+Deferred::Deferred(const JsBridgeContext *jsBridgeContext, std::shared_ptr<const JavaType> &&componentType)
  : JavaType(jsBridgeContext, JavaTypeId::Deferred)
  , m_componentType(std::move(componentType)) {
 }
 
 // JS Promise to Java Deferred
 JValue Deferred::pop() const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
   CHECK_STACK_OFFSET(m_ctx, -1);
 
   // Create a Java Deferred instance
@@ -201,7 +172,29 @@ JValue Deferred::pop() const {
     throw JniException(m_jniContext);
   }
 
-  if (!duk_is_object(m_ctx, -1) || !duk_has_prop_string(m_ctx, -1, "then")) {
+  return popToJavaDeferred(javaDeferred);
+}
+
+JValue Deferred::popAwaited(const JniLocalRef<jobject> &javaDeferred) const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
+  CHECK_STACK_OFFSET(m_ctx, -1);
+
+  if (m_jsBridgeContext->getPromise()->pushFulfilledValue(-1)) {
+    duk_remove(m_ctx, -2);  // Promise
+    return m_componentType->pop();
+  }
+
+  if (!duk_is_object(m_ctx, -1) || !duk_has_prop_literal(m_ctx, -1, "then")) {
+    return m_componentType->pop();
+  }
+
+  return popToJavaDeferred(javaDeferred);
+}
+
+JValue Deferred::popToJavaDeferred(const JniLocalRef<jobject> &javaDeferred) const {
+  CHECK_STACK_OFFSET(m_ctx, -1);
+
+  if (!duk_is_object(m_ctx, -1) || !duk_has_prop_literal(m_ctx, -1, "then")) {
     // Not a Promise => directly resolve the Java Deferred with the value
     JValue value = m_componentType->pop();
 
@@ -233,15 +226,18 @@ JValue Deferred::pop() const {
   }
   duk_pop(m_ctx);  // ignored ret val
 
+  // Both payloads share the same JNI global ref (released with the last one)
+  JniGlobalRef<jobject> javaDeferredGlobalRef(javaDeferred);
+
   // Bind the payload to the onPromiseFulfilled function
-  auto onPromiseFulfilledPayload = new OnPromisePayload { JniGlobalRef<jobject>(javaDeferred), m_componentType };
+  auto onPromiseFulfilledPayload = new OnPromisePayload { javaDeferredGlobalRef, m_componentType };
   duk_push_pointer(m_ctx, reinterpret_cast<void *>(onPromiseFulfilledPayload));
-  duk_put_prop_string(m_ctx, onPromiseFulfilledIdx, PAYLOAD_PROP_NAME);
+  duk_put_prop_literal(m_ctx, onPromiseFulfilledIdx, PAYLOAD_PROP_NAME);
 
   // Bind the payload to the onPromiseRejected function
-  auto onPromiseRejectedPayload = new OnPromisePayload { JniGlobalRef<jobject>(javaDeferred), m_componentType };
+  auto onPromiseRejectedPayload = new OnPromisePayload { javaDeferredGlobalRef, m_componentType };
   duk_push_pointer(m_ctx, reinterpret_cast<void *>(onPromiseRejectedPayload));
-  duk_put_prop_string(m_ctx, onPromiseRejectedIdx, PAYLOAD_PROP_NAME);
+  duk_put_prop_literal(m_ctx, onPromiseRejectedIdx, PAYLOAD_PROP_NAME);
 
   // Finalizer (which releases the JavaDeferred and the component Parameter global refs)
   duk_push_c_function(m_ctx, finalizeOnPromise, 1);
@@ -255,6 +251,7 @@ JValue Deferred::pop() const {
 
 // Java Deferred to JS Promise
 duk_ret_t Deferred::push(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
   CHECK_STACK_OFFSET(m_ctx, 1);
 
   const JniLocalRef<jobject> &jDeferred = value.getLocalRef();
@@ -264,47 +261,35 @@ duk_ret_t Deferred::push(const JValue &value) const {
     return 1;
   }
 
-  // promiseFunction = function (resolve, reject)
-  duk_push_c_function(m_ctx, promiseFunction, 2);
-  // => STASH: [... promiseFunction]
-
-  // Create a PromiseObject which will be eventually filled with {resolve, reject}
+  // Create a PromiseObject which will be filled with {resolve, reject}
   duk_push_object(m_ctx);
   duk_push_pointer(m_ctx, new std::shared_ptr<const JavaType>(m_componentType));
-  duk_put_prop_string(m_ctx, -2, PROMISE_COMPONENT_TYPE_PROP_NAME);
-  // => STASH: [... promiseFunction PromiseObject]
+  duk_put_prop_literal(m_ctx, -2, PROMISE_COMPONENT_TYPE_PROP_NAME);
+  // => STASH: [... PromiseObject]
 
   // Set the finalizer of the PromiseObject
   duk_push_c_function(m_ctx, finalizePromiseObject, 1);
   duk_set_finalizer(m_ctx, -2);
 
-  static int promiseCount = 0;
-  std::string promiseObjectGlobalName = PROMISE_OBJECT_GLOBAL_NAME_PREFIX + std::to_string(++promiseCount);
-
-  // Put it to the global stash
+  // Keep it in the JsValue table until the promise is completed (see completeJsPromise())
   duk_dup_top(m_ctx);
-  duk_put_global_string(m_ctx, promiseObjectGlobalName.c_str());
-  // => STASH: [... promiseFunction PromiseObject]
-
-  // Bind the PromiseObject to the promiseFunction
-  duk_put_prop_string(m_ctx, -2 /*promiseFunction*/, PROMISE_OBJECT_PROP_NAME);
-  // => STASH: [... promiseFunction]
-
-  // new Promise(promiseFunction)
-  if (!duk_get_global_string(m_ctx, "Promise")) {
-    duk_pop_2(m_ctx);  // (undefined) "Promise" + promiseFunction
-    throw std::invalid_argument("Cannot push Deferred: globalThis.Promise is undefined");
-  }
-  duk_dup(m_ctx, -2 /*promiseFunction*/);
-  duk_new(m_ctx, 1);  // [... "Promise" promiseFunction] => [... Promise]
-  // => STASH: [... promiseFunction, Promise]
-
-  duk_remove(m_ctx, -2);  // promiseFunction
+  jlong promiseObjectHandle = m_jsBridgeContext->getJsValueTable()->add();
+  // => STASH: [... PromiseObject]
+
+  // Native Promise and its resolving functions (no JS executor call)
+  const DuktapePromise *duktapePromise = m_jsBridgeContext->getPromise();
+  duktapePromise->pushNewPromise();
+  duktapePromise->pushResolvingFunctions(-1);
+  // => STASH: [... PromiseObject Promise resolve reject]
+
+  // Set PromiseObject.resolve and PromiseObject.reject
+  duk_put_prop_literal(m_ctx, -4, "reject");
+  duk_put_prop_literal(m_ctx, -3, "resolve");
+  duk_remove(m_ctx, -2);  // PromiseObject
   // => STASH: [... Promise]
 
   // Call Java setUpJsPromise()
-  getJniCache()->getJsBridgeInterface().setUpJsPromise(
-    JStringLocalRef(m_jniContext, promiseObjectGlobalName.c_str()), jDeferred);
+  getJniCache()->getJsBridgeInterface().setUpJsPromise(promiseObjectHandle, jDeferred);
   if (m_jniContext->exceptionCheck()) {
     throw JniException(m_jniContext);
   }
@@ -312,22 +297,26 @@ duk_ret_t Deferred::push(const JValue &value) const {
   return 1;
 }
 
-void Deferred::completeJsPromise(const JsBridgeContext *jsBridgeContext, const std::string &strId, bool isFulfilled, const JniLocalRef<jobject> &value) {
+void Deferred::completeJsPromise(const JsBridgeContext *jsBridgeContext, jlong handle, bool isFulfilled, const JniLocalRef<jobject> &value) {
   duk_context *ctx = jsBridgeContext->getDuktapeContext();
   assert(ctx != nullptr);
 
   CHECK_STACK(ctx);
 
-  // Get the global PromiseObject
-  if (!duk_get_global_string(ctx, strId.c_str())) {
-    alog_warn("Could not find PromiseObject with id %s", strId.c_str());
-    duk_pop(ctx);
+  JsValueTable *jsValueTable = jsBridgeContext->getJsValueTable();
+
+  // Push the PromiseObject and free its slot (a promise is only completed once)
+  try {
+    jsValueTable->push(handle);
+  } catch (const std::invalid_argument &) {
+    alog_warn("Could not find PromiseObject with handle %lld", static_cast<long long>(handle));
     return;
   }
+  jsValueTable->remove(handle);
 
   // Get attached type ptr...
-  if (!duk_get_prop_string(ctx, -1, JavaTypes::Deferred::PROMISE_COMPONENT_TYPE_PROP_NAME)) {
-    alog_warn("Could not get component type from Promise with id %s", strId.c_str());
+  if (!duk_get_prop_literal(ctx, -1, JavaTypes::Deferred::PROMISE_COMPONENT_TYPE_PROP_NAME)) {
+    alog_warn("Could not get component type from Promise with handle %lld", static_cast<long long>(handle));
     duk_pop_2(ctx);  // (undefined) component type + PromiseObject
     return;
   }
@@ -349,7 +338,7 @@ void Deferred::completeJsPromise(const JsBridgeContext *jsBridgeContext, const s
     jsBridgeContext->getExceptionHandler()->pushJavaException(value.staticCast<jthrowable>());
   }
   if (duk_pcall(ctx, 1) != DUK_EXEC_SUCCESS) {
-    alog("Could not complete Promise with id %s", strId.c_str());
+    alog("Could not complete Promise with handle %lld", static_cast<long long>(handle));
   }
 
   duk_pop_2(ctx);  // (undefined) call result + PromiseObject
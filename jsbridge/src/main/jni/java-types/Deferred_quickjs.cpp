@@ -15,10 +15,12 @@
  */
 #include "Deferred.h"
 
+#include "AutoReleasedJSValue.h"
 #include "ExceptionHandler.h"
 #include "JavaTypeId.h"
 #include "JniCache.h"
 #include "JsBridgeContext.h"
+#include "JsValueTable.h"
 #include "QuickJsUtils.h"
 #include "log.h"
 #include "exceptions/JniException.h"
@@ -26,63 +28,54 @@
 #include "jni-helpers/JniContext.h"
 
 namespace {
-  const char *PROMISE_OBJECT_GLOBAL_NAME_PREFIX = "__javaTypes_deferred_promiseobject_";
-
-  struct OnPromisePayload {
-    JniGlobalRef<jobject> javaDeferred;
+  // Java Deferred waiting for the completion of a pending native JS promise, shared by the two
+  // reaction handlers of the promise. It is deleted with them, i.e. also when the promise is
+  // never settled and gets garbage-collected.
+  struct PendingDeferred {
+    JniGlobalRef<jobject> javaDeferred;  // null once completed
     std::shared_ptr<const JavaType> componentType;
   };
 
-  JSValue onPromiseFulfilled(JSContext *ctx, JSValueConst /*this_val*/, int argc, JSValueConst *argv, int /*magic*/, JSValueConst *datav) {
-    JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
-    assert(jsBridgeContext != nullptr);
-
-    const ExceptionHandler *exceptionHandler = jsBridgeContext->getExceptionHandler();
-
-    try {
-      // data => OnPromisePayload
-      auto payload = QuickJsUtils::getCppPtr<OnPromisePayload>(*datav);
+  // Resolve or reject the Java Deferred with the given JS promise value (or rejection reason)
+  void completeJavaDeferred(const JsBridgeContext *jsBridgeContext, const JniRef<jobject> &javaDeferred,
+                            const JavaType *componentType, bool isFulfilled, JSValueConst value) {
+    const JniContext *jniContext = jsBridgeContext->getJniContext();
+    const JniCache *jniCache = jsBridgeContext->getJniCache();
 
-      // Pop promise value
-      JSValueConst promiseValue = argc >= 1 ? *argv : JS_NULL;
-      JValue value = payload->componentType->toJava(promiseValue);
-
-      const JniContext *jniContext = jsBridgeContext->getJniContext();
-      const JniCache *jniCache = jsBridgeContext->getJniCache();
-
-      // Complete the Java Deferred
-      jniCache->getJsBridgeInterface().resolveDeferred(payload->javaDeferred, value);
-      if (jniContext->exceptionCheck()) {
-        throw JniException(jniContext);
-      }
+    if (isFulfilled) {
+      jniCache->getJsBridgeInterface().resolveDeferred(javaDeferred, componentType->toJava(value));
+    } else {
+      JsException jsException(jsBridgeContext, JS_DupValue(jsBridgeContext->getQuickJsContext(), value));
+      JValue exception(jsBridgeContext->getExceptionHandler()->getJavaException(jsException));
+      jniCache->getJsBridgeInterface().rejectDeferred(javaDeferred, exception);
+    }
 
-      return JS_UNDEFINED;
-    } catch (const JniException &e) {
-      exceptionHandler->jsThrow(e);
-      return JS_EXCEPTION;
+    if (jniContext->exceptionCheck()) {
+      throw JniException(jniContext);
     }
   }
 
-  JSValue onPromiseRejected(JSContext *ctx, JSValueConst /*this_val*/, int argc, JSValueConst *argv, int /*magic*/, JSValueConst *datav) {
+  // Reaction handler shared by all pending native promises (magic: 0 = fulfilled, 1 = rejected)
+  // with their wrapped PendingDeferred as data
+  JSValue onPromiseSettled(JSContext *ctx, JSValueConst /*this_val*/, int argc, JSValueConst *argv, int magic, JSValueConst *datav) {
     JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
+    assert(jsBridgeContext != nullptr);
+
     const ExceptionHandler *exceptionHandler = jsBridgeContext->getExceptionHandler();
 
     try {
-      // data => OnPromisePayload
-      auto payload = QuickJsUtils::getCppPtr<OnPromisePayload>(*datav);
-
-      const JniContext *jniContext = jsBridgeContext->getJniContext();
-      const JniCache *jniCache = jsBridgeContext->getJniCache();
-
-      JsException jsException(jsBridgeContext, argc > 0 ? JS_DupValue(ctx, *argv) : JS_NULL);
-      JValue value(exceptionHandler->getJavaException(jsException));
-
-      // Reject the Java Deferred
-      jniCache->getJsBridgeInterface().rejectDeferred(payload->javaDeferred, value);
-      if (jniContext->exceptionCheck()) {
-        throw JniException(jniContext);
+      auto pendingDeferred = QuickJsUtils::getCppPtr<PendingDeferred>(*datav);
+      if (pendingDeferred == nullptr || pendingDeferred->javaDeferred.isNull()) {
+        alog_warn("The pending Deferred has already been completed");
+        return JS_UNDEFINED;
       }
 
+      // Take the Java Deferred (released on return) so that it is only completed once
+      JniGlobalRef<jobject> javaDeferred;
+      javaDeferred = std::move(pendingDeferred->javaDeferred);
+
+      completeJavaDeferred(jsBridgeContext, javaDeferred, pendingDeferred->componentType.get(),
+                           magic == 0, argc >= 1 ? *argv : JS_NULL);
       return JS_UNDEFINED;
     } catch (const JniException &e) {
       exceptionHandler->jsThrow(e);
@@ -108,18 +101,14 @@ namespace {
 
 namespace JavaTypes {
 
-// static
-const char *Deferred::PROMISE_COMPONENT_TYPE_PROP_NAME = "\xff\xff" "promise_type";
-
-Deferred::Deferred(const JsBridgeContext *jsBridgeContext, std::unique_ptr<const JavaType> &&componentType)
+Deferred::Deferred(const JsBridgeContext *jsBridgeContext, std::shared_ptr<const JavaType> &&componentType)
  : JavaType(jsBridgeContext, JavaTypeId::Deferred)
  , m_componentType(std::move(componentType)) {
 }
 
 // JS Promise to Java Deferred
 JValue Deferred::toJava(JSValueConst v) const {
-  const QuickJsUtils *utils = m_jsBridgeContext->getUtils();
-  assert(utils != nullptr);
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
 
   // Create a Java Deferred instance
   JniLocalRef<jobject> javaDeferred = getJniCache()->getJsBridgeInterface().createCompletableDeferred();
@@ -127,7 +116,46 @@ JValue Deferred::toJava(JSValueConst v) const {
     throw JniException(m_jniContext);
   }
 
-  bool isPromise = JS_IsObject(v) && utils->hasPropertyStr(v, "then");
+  return toJavaDeferred(v, javaDeferred);
+}
+
+JValue Deferred::toJavaAwaited(JSValueConst v, const JniLocalRef<jobject> &javaDeferred) const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
+
+  int promiseState = JS_PromiseState(m_ctx, v);
+  if (promiseState == JS_PROMISE_FULFILLED) {
+    JSValue promiseResult = JS_PromiseResult(m_ctx, v);
+    JS_AUTORELEASE_VALUE(m_ctx, promiseResult);
+    return m_componentType->toJava(promiseResult);
+  }
+
+  bool isPromise = promiseState != -1 || (JS_IsObject(v) && getUtils()->hasProperty(v, QuickJsUtils::PropertyName::Then));
+  if (!isPromise) {
+    return m_componentType->toJava(v);
+  }
+
+  return toJavaDeferred(v, javaDeferred);
+}
+
+JValue Deferred::toJavaDeferred(JSValueConst v, const JniLocalRef<jobject> &javaDeferred) const {
+  QuickJsUtils *utils = m_jsBridgeContext->getUtils();
+  assert(utils != nullptr);
+
+  // Native promises can be read immediately once settled (no job is enqueued)
+  int promiseState = JS_PromiseState(m_ctx, v);
+  if (promiseState == JS_PROMISE_FULFILLED || promiseState == JS_PROMISE_REJECTED) {
+    JSValue promiseResult = JS_PromiseResult(m_ctx, v);
+    try {
+      completeJavaDeferred(m_jsBridgeContext, javaDeferred, m_componentType.get(), promiseState == JS_PROMISE_FULFILLED, promiseResult);
+    } catch (...) {
+      JS_FreeValue(m_ctx, promiseResult);
+      throw;
+    }
+    JS_FreeValue(m_ctx, promiseResult);
+    return JValue(javaDeferred);
+  }
+
+  bool isPromise = promiseState == JS_PROMISE_PENDING || (JS_IsObject(v) && utils->hasProperty(v, QuickJsUtils::PropertyName::Then));
   if (!isPromise) {
     // Not a Promise => directly resolve the Java Deferred with the value
     JValue value = m_componentType->toJava(v);
@@ -140,33 +168,22 @@ JValue Deferred::toJava(JSValueConst v) const {
     return JValue(javaDeferred);
   }
 
-  // onPromiseFulfilledFunc with data
-  auto onPromiseFulfilledPayload = new OnPromisePayload { JniGlobalRef<jobject>(javaDeferred), m_componentType };
-  JSValue onPromiseFulfilledPayloadValue = utils->createCppPtrValue<OnPromisePayload>(onPromiseFulfilledPayload, true);
-  JSValue onPromiseFulfilledValue = JS_NewCFunctionData(
-      m_ctx, onPromiseFulfilled, 1 /*length*/, 0 /*magic*/, 1, &onPromiseFulfilledPayloadValue);
-  JS_FreeValue(m_ctx, onPromiseFulfilledPayloadValue);
-
-  // onPromiseRejectedFunc with data
-  auto onPromiseRejectedPayload = new OnPromisePayload { JniGlobalRef<jobject>(javaDeferred), m_componentType };
-  JSValue onPromiseRejectedPayloadValue = utils->createCppPtrValue<OnPromisePayload>(onPromiseRejectedPayload, true);
-  JSValue onPromiseRejectedValue = JS_NewCFunctionData(
-      m_ctx, onPromiseRejected, 1 /*length*/, 0 /*magic*/, 1, &onPromiseRejectedPayloadValue);
-  JS_FreeValue(m_ctx, onPromiseRejectedPayloadValue);
-
-  // JsPromise.then()
-  JSValue thenValue = JS_GetPropertyStr(m_ctx, v, "then");
-  assert(JS_IsFunction(m_ctx, thenValue));
+  // Pending promise (or thenable) => bind the shared reaction handlers to a new PendingDeferred
+  auto pendingDeferred = new PendingDeferred { JniGlobalRef<jobject>(javaDeferred), m_componentType };
+  JSValue pendingDeferredValue = utils->createCppPtrValue(pendingDeferred);
+  JSValueConst thenArgs[2];
+  thenArgs[0] = JS_NewCFunctionData(m_ctx, onPromiseSettled, 1 /*length*/, 0 /*magic*/, 1, &pendingDeferredValue);
+  thenArgs[1] = JS_NewCFunctionData(m_ctx, onPromiseSettled, 1 /*length*/, 1 /*magic*/, 1, &pendingDeferredValue);
+  JS_FreeValue(m_ctx, pendingDeferredValue);  // owned by the reaction handlers
 
   // Call JsPromise.then(onPromiseFulfilled, onPromiseRejected)
-  JSValueConst thenArgs[2];
-  thenArgs[0] = onPromiseFulfilledValue;
-  thenArgs[1] = onPromiseRejectedValue;
-  JSValue ret = JS_Call(m_ctx, thenValue, v, 2, thenArgs);
+  JSValue ret = JS_Invoke(m_ctx, v, utils->getAtom(QuickJsUtils::PropertyName::Then), 2, thenArgs);
 
   if (JS_IsException(ret)) {
     alog("Error while calling JSPromise.then()");
 
+    pendingDeferred->javaDeferred = JniGlobalRef<jobject>();
+
     JsException jsException(m_jsBridgeContext, JS_GetException(m_ctx));
     JniLocalRef<jthrowable> javaException = getExceptionHandler()->getJavaException(jsException);
     getJniCache()->getJsBridgeInterface().rejectDeferred(javaDeferred, JValue(javaException));
@@ -176,15 +193,15 @@ JValue Deferred::toJava(JSValueConst v) const {
   }
 
   JS_FreeValue(m_ctx, ret);
-  JS_FreeValue(m_ctx, onPromiseFulfilledValue);
-  JS_FreeValue(m_ctx, onPromiseRejectedValue);
-  JS_FreeValue(m_ctx, thenValue);
+  JS_FreeValue(m_ctx, thenArgs[0]);
+  JS_FreeValue(m_ctx, thenArgs[1]);
 
   return JValue(javaDeferred);
 }
 
 // Java Deferred to JS Promise
 JSValue Deferred::fromJava(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
   const JniLocalRef<jobject> &jDeferred = value.getLocalRef();
 
   if (jDeferred.isNull()) {
@@ -195,17 +212,12 @@ JSValue Deferred::fromJava(const JValue &value) const {
 
   // Create a PromiseObject which will be eventually filled with {resolve, reject}
   JSValue promiseObject = JS_NewObject(m_ctx);
-  JSValue componentTypeValue = utils->createCppPtrValue(new std::shared_ptr<const JavaType>(m_componentType), true /*deleteOnFinalize*/);
-  JS_SetPropertyStr(m_ctx, promiseObject, PROMISE_COMPONENT_TYPE_PROP_NAME, componentTypeValue);
+  JSValue componentTypeValue = utils->createCppPtrValue(new std::shared_ptr<const JavaType>(m_componentType));
+  getUtils()->setProperty(promiseObject, QuickJsUtils::PropertyName::PromiseComponentType, componentTypeValue);
   // No JS_FreeValue(m_ctx, componentTypeValue) after JS_SetPropertyStr()
 
-  static int promiseCount = 0;
-  std::string promiseObjectGlobalName = PROMISE_OBJECT_GLOBAL_NAME_PREFIX + std::to_string(++promiseCount);
-
-  // Put it to the global stash
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
-  JS_SetPropertyStr(m_ctx, globalObj, promiseObjectGlobalName.c_str(), JS_DupValue(m_ctx, promiseObject));
-  JS_FreeValue(m_ctx, globalObj);
+  // Keep it in the JsValue table until the promise is completed (see completeJsPromise())
+  jlong promiseObjectHandle = m_jsBridgeContext->getJsValueTable()->add(promiseObject);
 
   // promiseFunction = function(resolve, reject) + data (promiseObject)
   JSValue promiseFunctionValue = JS_NewCFunctionData(m_ctx, promiseFunction, 1, 0, 1, &promiseObject);
@@ -213,15 +225,14 @@ JSValue Deferred::fromJava(const JValue &value) const {
 
   // Create a new JS promise with the promiseFunction as parameter
   // => new Promise(promiseFunction)
-  JSValue promiseCtor = JS_GetPropertyStr(m_ctx, globalObj, "Promise");
+  JSValue promiseCtor = JS_GetPropertyStr(m_ctx, utils->getGlobalObject(), "Promise");
   JSValue promiseInstance = JS_CallConstructor(m_ctx, promiseCtor, 1, &promiseFunctionValue);
   assert(JS_IsObject(promiseInstance));
   JS_FreeValue(m_ctx, promiseCtor);
   JS_FreeValue(m_ctx, promiseFunctionValue);
 
   // Call Java setUpJsPromise()
-  getJniCache()->getJsBridgeInterface().setUpJsPromise(
-      JStringLocalRef(m_jniContext, promiseObjectGlobalName.c_str()), jDeferred);
+  getJniCache()->getJsBridgeInterface().setUpJsPromise(promiseObjectHandle, jDeferred);
   if (m_jniContext->exceptionCheck()) {
     throw JniException(m_jniContext);
   }
@@ -229,25 +240,27 @@ JSValue Deferred::fromJava(const JValue &value) const {
   return promiseInstance;
 }
 
-void Deferred::completeJsPromise(const JsBridgeContext *jsBridgeContext, const std::string &strId, bool isFulfilled, const JniLocalRef<jobject> &value) {
+void Deferred::completeJsPromise(const JsBridgeContext *jsBridgeContext, jlong handle, bool isFulfilled, const JniLocalRef<jobject> &value) {
   JSContext *ctx = jsBridgeContext->getQuickJsContext();
   assert(ctx != nullptr);
 
   const QuickJsUtils *utils = jsBridgeContext->getUtils();
-
-  // Get the global PromiseObject
-  JSValue globalObj = JS_GetGlobalObject(ctx);
-  JSValue promiseObj = JS_GetPropertyStr(ctx, globalObj, strId.c_str());
-  JS_FreeValue(ctx, globalObj);
-  if (!JS_IsObject(promiseObj)) {
-    alog_warn("Could not find PromiseObject with id %s", strId.c_str());
+  JsValueTable *jsValueTable = jsBridgeContext->getJsValueTable();
+
+  // Get the PromiseObject and free its slot (a promise is only completed once)
+  JSValue promiseObj;
+  try {
+    promiseObj = jsValueTable->get(handle);
+  } catch (const std::invalid_argument &) {
+    alog_warn("Could not find PromiseObject with handle %lld", static_cast<long long>(handle));
     return;
   }
+  jsValueTable->remove(handle);
 
   // Get attached type ptr...
-  JSValue componentTypeValue = JS_GetPropertyStr(ctx, promiseObj, JavaTypes::Deferred::PROMISE_COMPONENT_TYPE_PROP_NAME);
+  JSValue componentTypeValue = utils->getProperty(promiseObj, QuickJsUtils::PropertyName::PromiseComponentType);
   if (JS_IsNull(componentTypeValue) || !JS_IsObject(componentTypeValue)) {
-    alog_warn("Could not get component type from Promise with id %s", strId.c_str());
+    alog_warn("Could not get component type from Promise with handle %lld", static_cast<long long>(handle));
     JS_FreeValue(ctx, promiseObj);
     return;
   }
@@ -255,8 +268,7 @@ void Deferred::completeJsPromise(const JsBridgeContext *jsBridgeContext, const s
   JS_FreeValue(ctx, componentTypeValue);
 
   // Get the resolve/reject function
-  const char *resolveOrRejectStr = isFulfilled ? "resolve" : "reject";
-  JSValue resolveOrReject = JS_GetPropertyStr(ctx, promiseObj, resolveOrRejectStr);
+  JSValue resolveOrReject = utils->getProperty(promiseObj, isFulfilled ? QuickJsUtils::PropertyName::Resolve : QuickJsUtils::PropertyName::Reject);
   if (JS_IsFunction(ctx, resolveOrReject)) {
     // Call it with the Promise value
     JSValue promiseParam;
@@ -267,13 +279,13 @@ void Deferred::completeJsPromise(const JsBridgeContext *jsBridgeContext, const s
     }
     JSValue ret = JS_Call(ctx, resolveOrReject, promiseObj, 1, &promiseParam);
     if (JS_IsException(ret)) {
-      alog("Could not complete Promise with id %s", strId.c_str());
+      alog("Could not complete Promise with handle %lld", static_cast<long long>(handle));
     }
 
     JS_FreeValue(ctx, ret);
     JS_FreeValue(ctx, promiseParam);
   } else {
-    alog("Could not complete Promise with id %s: cannot find %s", strId.c_str(), resolveOrRejectStr);
+    alog("Could not complete Promise with handle %lld: cannot find %s", static_cast<long long>(handle), isFulfilled ? "resolve" : "reject");
   }
 
   JS_FreeValue(ctx, resolveOrReject);
@@ -19,40 +19,49 @@
 #ifndef _JSBRIDGE_JAVATYPES_DOUBLE_H
 #define _JSBRIDGE_JAVATYPES_DOUBLE_H
 
-#include "Primitive.h"
+#include "PrimitiveType.h"
 
 namespace JavaTypes {
 
-class Double : public Primitive {
+struct DoubleTraits : NumberTraits<jdouble> {
+  static constexpr JavaTypeId ID = JavaTypeId::Double;
+  static constexpr JavaTypeId BOXED_ID = JavaTypeId::BoxedDouble;
+  static constexpr JavaTypeId ARRAY_ID = JavaTypeId::DoubleArray;
 
-public:
-  Double(const JsBridgeContext *);
+  static constexpr const char *JAVA_NAME = "double";
+  static constexpr const char *BOXED_JAVA_NAME = "Double";
 
-#if defined(DUKTAPE)
-  JValue pop() const override;
-  JValue popArray(uint32_t count, bool expanded) const override;
-
-  duk_ret_t push(const JValue &) const override;
-  duk_ret_t pushArray(const JniLocalRef<jarray> &values, bool expand) const override;
-#elif defined(QUICKJS)
-  JValue toJava(JSValueConst) const override;
-  JValue toJavaArray(JSValueConst) const override;
+  static constexpr const char *BOX_SIGNATURE = "(D)Ljava/lang/Double;";
+  static constexpr const char *UNBOX_METHOD_NAME = "doubleValue";
+  static constexpr const char *UNBOX_SIGNATURE = "()D";
 
-  JSValue fromJava(const JValue &) const override;
-  JSValue fromJavaArray(const JniLocalRef<jarray> &values) const override;
+  using TypedArrayElement = jdouble;
+  static constexpr const char *TYPED_ARRAY_NAME = "Float64Array";
+  static constexpr const char *ALT_TYPED_ARRAY_NAME = nullptr;
+#if defined(DUKTAPE)
+  static constexpr duk_uint_t DUK_TYPED_ARRAY_TYPE = DUK_BUFOBJ_FLOAT64ARRAY;
 #endif
 
-  JValue callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
-                    const std::vector<JValue> &args) const override;
+  static jdouble get(const JValue &value) { return value.getDouble(); }
+
+  static jdouble callMethodA(const JniContext *jniContext, const JniRef<jobject> &javaThis, jmethodID methodId, const JValueArgs &args) {
+    return jniContext->callDoubleMethodA(javaThis, methodId, args);
+  }
 
-  JavaTypeId arrayId() const override { return JavaTypeId::DoubleArray; }
+  static jdouble callMethod(const JniContext *jniContext, const JniRef<jobject> &object, jmethodID methodId) {
+    return jniContext->callDoubleMethod(object, methodId);
+  }
 
-private:
-  JValue box(const JValue &) const override;
-  JValue unbox(const JValue &) const override;
+#if defined(DUKTAPE)
+  static jdouble getJsValue(duk_context *ctx, duk_idx_t index) { return duk_require_number(ctx, index); }
+  static void pushJsValue(duk_context *ctx, jdouble value) { duk_push_number(ctx, value); }
+#elif defined(QUICKJS)
+  static JSValue newJsValue(JSContext *ctx, jdouble value) { return JS_NewFloat64(ctx, value); }
+#endif
 };
 
+using Double = PrimitiveType<DoubleTraits>;
+
 }  // namespace JavaTypes
 
 #endif
-
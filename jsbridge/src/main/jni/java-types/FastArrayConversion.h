@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JAVATYPES_FASTARRAYCONVERSION_H
+#define _JSBRIDGE_JAVATYPES_FASTARRAYCONVERSION_H
+
+#if defined(QUICKJS)
+
+#include "quickjs/quickjs.h"
+#include <cmath>
+#include <cstdint>
+#include <jni.h>
+#include <limits>
+#include <type_traits>
+
+namespace JavaTypes {
+
+// Conversion of a JS float64 to a Java number which does not depend on the CPU where the
+// value is out of range: like the arm64 conversion instructions, integers saturate to int32
+// (int64 for jlong) before being narrowed and NaN is converted to 0
+template <typename T>
+inline T castFloat64(double d) {
+  if constexpr (std::is_integral_v<T>) {
+    using Saturated = std::conditional_t<(sizeof(T) > sizeof(int32_t)), int64_t, int32_t>;
+    if (std::isnan(d)) {
+      return 0;
+    }
+    if (d >= static_cast<double>(std::numeric_limits<Saturated>::max())) {
+      return static_cast<T>(std::numeric_limits<Saturated>::max());
+    }
+    if (d <= static_cast<double>(std::numeric_limits<Saturated>::min())) {
+      return static_cast<T>(std::numeric_limits<Saturated>::min());
+    }
+    return static_cast<T>(static_cast<Saturated>(d));
+  } else {
+    return static_cast<T>(d);
+  }
+}
+
+// Bulk conversion of the values of a QuickJS fast array (or of expanded values) into a Java
+// primitive array:
+// - convert the leading values as long as they are numbers (JS_TAG_INT or JS_TAG_FLOAT64) with
+//   the same result as an element-wise conversion (static_cast of int32 values, castFloat64() of
+//   float64 values)
+// - return the count of converted values (i.e. the index of the first non-number value) so that
+//   the caller can handle the remaining values (and errors) element-wise
+//
+// On arm64, runs of values with uniform tags are converted with NEON (int32 <-> double, double
+// -> float narrowing, double -> int64/int32 saturation) and mixed tags fall back to scalar
+// conversion.
+uint32_t convertFastArray(const JSValue *values, uint32_t count, jbyte *elements);
+uint32_t convertFastArray(const JSValue *values, uint32_t count, jshort *elements);
+uint32_t convertFastArray(const JSValue *values, uint32_t count, jint *elements);
+uint32_t convertFastArray(const JSValue *values, uint32_t count, jlong *elements);
+uint32_t convertFastArray(const JSValue *values, uint32_t count, jfloat *elements);
+uint32_t convertFastArray(const JSValue *values, uint32_t count, jdouble *elements);
+
+// No bulk conversion for other types (e.g. jboolean)
+template <typename T>
+uint32_t convertFastArray(const JSValue *, uint32_t, T *) { return 0; }
+
+}  // namespace JavaTypes
+
+#endif
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "FastArrayConversion.h"
+
+#if defined(__aarch64__) && !defined(JS_NAN_BOXING)
+# include <arm_neon.h>
+# define JSBRIDGE_NEON_FAST_ARRAY_CONVERSION
+#endif
+
+using JavaTypes::castFloat64;
+
+namespace {
+  template <typename T>
+  inline bool convertValue(JSValueConst v, T *element) {
+    int tag = JS_VALUE_GET_TAG(v);
+    if (tag == JS_TAG_INT) {
+      *element = static_cast<T>(JS_VALUE_GET_INT(v));
+      return true;
+    }
+
+    if (JS_TAG_IS_FLOAT64(tag)) {
+      *element = castFloat64<T>(JS_VALUE_GET_FLOAT64(v));
+      return true;
+    }
+
+    return false;
+  }
+
+  template <typename T>
+  uint32_t convertScalar(const JSValue *values, uint32_t start, uint32_t count, T *elements) {
+    uint32_t i = start;
+    while (i < count && convertValue(values[i], &elements[i])) {
+      ++i;
+    }
+    return i;
+  }
+
+#if defined(JSBRIDGE_NEON_FAST_ARRAY_CONVERSION)
+  static_assert(sizeof(JSValue) == 2 * sizeof(int64_t), "Unexpected JSValue layout");
+
+  // Convert pairs of values with the same tag with NEON (the payloads of 2 values are loaded
+  // into a single register) and mixed pairs with scalar code
+  template <typename T, typename IntKernel, typename Float64Kernel>
+  uint32_t convertNeon(const JSValue *values, uint32_t count, T *elements, IntKernel intKernel, Float64Kernel float64Kernel) {
+    uint32_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+      const int64_t tag = JS_VALUE_GET_TAG(values[i]);
+      if (tag == JS_VALUE_GET_TAG(values[i + 1]) && (tag == JS_TAG_INT || tag == JS_TAG_FLOAT64)) {
+        int64x2_t payloads = vld2q_s64(reinterpret_cast<const int64_t *>(values + i)).val[0];
+        if (tag == JS_TAG_INT) {
+          // The int32 payload is the low half of the 64-bit union (the upper half is not
+          // sign-extended so it must be extracted with a plain, non-saturating narrowing)
+          intKernel(vmovn_s64(payloads), elements + i);
+        } else {
+          float64Kernel(vreinterpretq_f64_s64(payloads), elements + i);
+        }
+        continue;
+      }
+
+      if (!convertValue(values[i], &elements[i])) {
+        return i;
+      }
+      if (!convertValue(values[i + 1], &elements[i + 1])) {
+        return i + 1;
+      }
+    }
+
+    return convertScalar(values, i, count, elements);
+  }
+#endif
+}
+
+namespace JavaTypes {
+
+uint32_t convertFastArray(const JSValue *values, uint32_t count, jbyte *elements) {
+  return convertScalar(values, 0, count, elements);
+}
+
+uint32_t convertFastArray(const JSValue *values, uint32_t count, jshort *elements) {
+  return convertScalar(values, 0, count, elements);
+}
+
+uint32_t convertFastArray(const JSValue *values, uint32_t count, jint *elements) {
+#if defined(JSBRIDGE_NEON_FAST_ARRAY_CONVERSION)
+  return convertNeon(values, count, elements,
+      [](int32x2_t ints, jint *out) { vst1_s32(out, ints); },
+      [](float64x2_t doubles, jint *out) { vst1_s32(out, vqmovn_s64(vcvtq_s64_f64(doubles))); });  // saturating
+#else
+  return convertScalar(values, 0, count, elements);
+#endif
+}
+
+uint32_t convertFastArray(const JSValue *values, uint32_t count, jlong *elements) {
+#if defined(JSBRIDGE_NEON_FAST_ARRAY_CONVERSION)
+  return convertNeon(values, count, elements,
+      [](int32x2_t ints, jlong *out) { vst1q_s64(out, vmovl_s32(ints)); },
+      [](float64x2_t doubles, jlong *out) { vst1q_s64(out, vcvtq_s64_f64(doubles)); });  // saturating
+#else
+  return convertScalar(values, 0, count, elements);
+#endif
+}
+
+uint32_t convertFastArray(const JSValue *values, uint32_t count, jfloat *elements) {
+#if defined(JSBRIDGE_NEON_FAST_ARRAY_CONVERSION)
+  // Note: int32 -> double is exact so int32 -> double -> float rounds only once
+  return convertNeon(values, count, elements,
+      [](int32x2_t ints, jfloat *out) { vst1_f32(out, vcvt_f32_f64(vcvtq_f64_s64(vmovl_s32(ints)))); },
+      [](float64x2_t doubles, jfloat *out) { vst1_f32(out, vcvt_f32_f64(doubles)); });
+#else
+  return convertScalar(values, 0, count, elements);
+#endif
+}
+
+uint32_t convertFastArray(const JSValue *values, uint32_t count, jdouble *elements) {
+#if defined(JSBRIDGE_NEON_FAST_ARRAY_CONVERSION)
+  return convertNeon(values, count, elements,
+      [](int32x2_t ints, jdouble *out) { vst1q_f64(out, vcvtq_f64_s64(vmovl_s32(ints))); },
+      [](float64x2_t doubles, jdouble *out) { vst1q_f64(out, doubles); });
+#else
+  return convertScalar(values, 0, count, elements);
+#endif
+}
+
+}  // namespace JavaTypes
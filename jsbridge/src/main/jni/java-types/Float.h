@@ -19,40 +19,49 @@
 #ifndef _JSBRIDGE_JAVATYPES_FLOAT_H
 #define _JSBRIDGE_JAVATYPES_FLOAT_H
 
-#include "Primitive.h"
+#include "PrimitiveType.h"
 
 namespace JavaTypes {
 
-class Float : public Primitive {
+struct FloatTraits : NumberTraits<jfloat> {
+  static constexpr JavaTypeId ID = JavaTypeId::Float;
+  static constexpr JavaTypeId BOXED_ID = JavaTypeId::BoxedFloat;
+  static constexpr JavaTypeId ARRAY_ID = JavaTypeId::FloatArray;
 
-public:
-  Float(const JsBridgeContext *);
+  static constexpr const char *JAVA_NAME = "float";
+  static constexpr const char *BOXED_JAVA_NAME = "Float";
 
-#if defined(DUKTAPE)
-  JValue pop() const override;
-  JValue popArray(uint32_t count, bool expanded) const override;
-
-  duk_ret_t push(const JValue &) const override;
-  duk_ret_t pushArray(const JniLocalRef<jarray> &values, bool expand) const override;
-#elif defined(QUICKJS)
-  JValue toJava(JSValueConst) const override;
-  JValue toJavaArray(JSValueConst) const override;
+  static constexpr const char *BOX_SIGNATURE = "(F)Ljava/lang/Float;";
+  static constexpr const char *UNBOX_METHOD_NAME = "floatValue";
+  static constexpr const char *UNBOX_SIGNATURE = "()F";
 
-  JSValue fromJava(const JValue &) const override;
-  JSValue fromJavaArray(const JniLocalRef<jarray> &values) const override;
+  using TypedArrayElement = jfloat;
+  static constexpr const char *TYPED_ARRAY_NAME = "Float32Array";
+  static constexpr const char *ALT_TYPED_ARRAY_NAME = nullptr;
+#if defined(DUKTAPE)
+  static constexpr duk_uint_t DUK_TYPED_ARRAY_TYPE = DUK_BUFOBJ_FLOAT32ARRAY;
 #endif
 
-  JValue callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
-                    const std::vector<JValue> &args) const override;
+  static jfloat get(const JValue &value) { return value.getFloat(); }
+
+  static jfloat callMethodA(const JniContext *jniContext, const JniRef<jobject> &javaThis, jmethodID methodId, const JValueArgs &args) {
+    return jniContext->callFloatMethodA(javaThis, methodId, args);
+  }
 
-  JavaTypeId arrayId() const override { return JavaTypeId::FloatArray; }
+  static jfloat callMethod(const JniContext *jniContext, const JniRef<jobject> &object, jmethodID methodId) {
+    return jniContext->callFloatMethod(object, methodId);
+  }
 
-private:
-  JValue box(const JValue &) const override;
-  JValue unbox(const JValue &) const override;
+#if defined(DUKTAPE)
+  static jfloat getJsValue(duk_context *ctx, duk_idx_t index) { return static_cast<jfloat>(duk_require_number(ctx, index)); }
+  static void pushJsValue(duk_context *ctx, jfloat value) { duk_push_number(ctx, value); }
+#elif defined(QUICKJS)
+  static JSValue newJsValue(JSContext *ctx, jfloat value) { return JS_NewFloat64(ctx, value); }
+#endif
 };
 
+using Float = PrimitiveType<FloatTraits>;
+
 }  // namespace JavaTypes
 
 #endif
-
@@ -25,12 +25,14 @@
 #include "jni-helpers/JniContext.h"
 #include "jni-helpers/JniGlobalRef.h"
 #include "jni-helpers/JObjectArrayLocalRef.h"
+#include <atomic>
 #include <memory>
 
 #if defined(DUKTAPE)
 # include "DuktapeUtils.h"
 # include "StackChecker.h"
 #elif defined(QUICKJS)
+# include "JsWrapperCache.h"
 # include "QuickJsUtils.h"
 #endif
 
@@ -51,7 +53,7 @@ namespace {
     CHECK_STACK(ctx);
 
     duk_push_current_function(ctx);
-    if (!duk_get_prop_string(ctx, -1, PAYLOAD_PROP_NAME)) {
+    if (!duk_get_prop_literal(ctx, -1, PAYLOAD_PROP_NAME)) {
       duk_pop_2(ctx);  // (undefined) javaThis + current function
       return DUK_RET_ERROR;
     }
@@ -79,7 +81,7 @@ namespace {
     JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
     assert(jsBridgeContext != nullptr);
 
-    if (duk_get_prop_string(ctx, -1, PAYLOAD_PROP_NAME)) {
+    if (duk_get_prop_literal(ctx, -1, PAYLOAD_PROP_NAME)) {
       delete reinterpret_cast<const CallJavaLambdaPayload *>(duk_require_pointer(ctx, -1));
     }
 
@@ -87,6 +89,25 @@ namespace {
     return 0;
   }
 #elif defined(QUICKJS)
+  const char *JS_LAMBDA_PROXY_CACHE_KEY_PREFIX = "__javaTypes_functionX_proxy_";
+
+  // Kotlin proxy created for a JS function (see FunctionX::toJava()), mapped inside the JS function
+  // with a key specific to the FunctionX signature. Only weakly referenced: the proxy itself keeps
+  // the stashed JS function alive via its JsValue.
+  struct JsLambdaProxyCacheEntry {
+    JsLambdaProxyCacheEntry(const JsBridgeContext *jsBridgeContext, const JniLocalRef<jobject> &javaFunction)
+     : jsBridgeContext(jsBridgeContext)
+     , weakJavaFunction(jsBridgeContext->getJniContext()->getJNIEnv()->NewWeakGlobalRef(javaFunction.get())) {
+    }
+
+    ~JsLambdaProxyCacheEntry() {
+      JniGlobalRef<jobject>::deleteRawWeakGlobalRef(jsBridgeContext->getJniContext(), weakJavaFunction);
+    }
+
+    const JsBridgeContext *jsBridgeContext;
+    jobject weakJavaFunction;
+  };
+
   JSValue callJavaLambda(JSContext *ctx, JSValue, int argc, JSValueConst *argv, int /*magic*/, JSValueConst *datav) {
     JsBridgeContext *jsBridgeContext = JsBridgeContext::getInstance(ctx);
     assert(jsBridgeContext != nullptr);
@@ -118,6 +139,10 @@ namespace JavaTypes {
 FunctionX::FunctionX(const JsBridgeContext *jsBridgeContext, const JniRef<jsBridgeParameter> &parameter)
  : JavaType(jsBridgeContext, JavaTypeId::FunctionX)
  , m_parameter(parameter) {
+#if defined(QUICKJS)
+  static std::atomic<int> functionXCount(0);
+  m_jsLambdaProxyCacheKey = JS_LAMBDA_PROXY_CACHE_KEY_PREFIX + std::to_string(++functionXCount);
+#endif
 }
 
 #if defined(DUKTAPE)
@@ -126,6 +151,7 @@ FunctionX::FunctionX(const JsBridgeContext *jsBridgeContext, const JniRef<jsBrid
 // - C++ -> Java: call createJsLambdaProxy with <functionId> as argument
 // - Java -> C++: call callJsLambda (with <functionId> + args parameters)
 JValue FunctionX::pop() const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
   CHECK_STACK_OFFSET(m_ctx, -1);
 
   if (!duk_is_function(m_ctx, -1) && !duk_is_null(m_ctx, -1)) {
@@ -145,11 +171,11 @@ JValue FunctionX::pop() const {
   duk_require_function(m_ctx, -1);
   duk_idx_t jsFuncIdx = duk_normalize_index(m_ctx, -1);
 
-  // 2. Duplicate it into the global object with prop name <functionId>
-  duk_push_global_object(m_ctx);
+  // 2. Duplicate it into the global stash with prop name <functionId>
+  utils->pushNamedValueOwner(jsFunctionGlobalName);
   duk_dup(m_ctx, jsFuncIdx);
   duk_put_prop_string(m_ctx, -2, jsFunctionGlobalName.c_str());
-  duk_pop(m_ctx);  // global object
+  duk_pop(m_ctx);  // global stash
 
   // 3. Create JavaScriptLambda C++ object and wrap it inside the JS function
   auto javaScriptLambda = new JavaScriptLambda(m_jsBridgeContext, javaMethod, jsFunctionGlobalName, -1);
@@ -177,6 +203,7 @@ JValue FunctionX::popArray(uint32_t count, bool expanded) const {
 
 // Get a Java function, register it and push a JS wrapper
 duk_ret_t FunctionX::push(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
 
   // 1. C++: create the JValue object which is a Java FunctionX instance
   const JniLocalRef<jobject> &javaFunctionObject = value.getLocalRef();
@@ -192,7 +219,7 @@ duk_ret_t FunctionX::push(const JValue &value) const {
   // Bind Payload
   auto payload = new CallJavaLambdaPayload { JniGlobalRef<jobject>(javaFunctionObject), getCppJavaMethod() };
   duk_push_pointer(m_ctx, payload);
-  duk_put_prop_string(m_ctx, funcIdx, PAYLOAD_PROP_NAME);
+  duk_put_prop_literal(m_ctx, funcIdx, PAYLOAD_PROP_NAME);
 
   // Finalizer (which releases the JavaMethod instance)
   duk_push_c_function(m_ctx, finalizeJavaLambda, 1);
@@ -211,6 +238,7 @@ duk_ret_t FunctionX::pushArray(const JniLocalRef<jarray> &, bool /*expand*/) con
 // - C++ -> Java: call createJsLambdaProxy with <functionId> as argument
 // - Java -> C++: call callJsLambda (with <functionId> + args parameters)
 JValue FunctionX::toJava(JSValueConst v) const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
   const QuickJsUtils *utils = m_jsBridgeContext->getUtils();
   assert(utils != nullptr);
 
@@ -218,15 +246,23 @@ JValue FunctionX::toJava(JSValueConst v) const {
     throw std::invalid_argument("Cannot convert return value to FunctionX");
   }
 
+  // 0. Reuse the Kotlin proxy if the same JS function has already been converted with this signature
+  // (and the proxy has not been garbage-collected yet)
+  auto proxyCacheEntry = utils->getMappedCppPtrValue<JsLambdaProxyCacheEntry>(v, m_jsLambdaProxyCacheKey.c_str());
+  if (proxyCacheEntry != nullptr) {
+    JniLocalRef<jobject> cachedJavaFunction(m_jniContext, m_jniContext->getJNIEnv()->NewLocalRef(proxyCacheEntry->weakJavaFunction));
+    if (!cachedJavaFunction.isNull()) {
+      return JValue(cachedJavaFunction);
+    }
+  }
+
   static int jsFunctionCount = 0;
   std::string jsFunctionGlobalName = JS_FUNCTION_GLOBAL_NAME_PREFIX + std::to_string(++jsFunctionCount);
 
   const JniRef<jsBridgeMethod> &jniJavaMethod = getJniJavaMethod();
 
-  // 1. Duplicate it into the global object with prop name <functionId>
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
-  JS_SetPropertyStr(m_ctx, globalObj, jsFunctionGlobalName.c_str(), JS_DupValue(m_ctx, v));
-  JS_FreeValue(m_ctx, globalObj);
+  // 1. Duplicate it into the bridge stash with prop name <functionId>
+  JS_SetPropertyStr(m_ctx, utils->getNamedValueOwner(jsFunctionGlobalName), jsFunctionGlobalName.c_str(), JS_DupValue(m_ctx, v));
 
   // 2. Create the  C++ JavaScriptLambda instance
   auto javaScriptLambda = new JavaScriptLambda(m_jsBridgeContext, jniJavaMethod, jsFunctionGlobalName, v);
@@ -243,6 +279,9 @@ JValue FunctionX::toJava(JSValueConst v) const {
     throw JniException(m_jniContext);
   }
 
+  // 5. Cache it (replacing the previous entry whose proxy has been collected)
+  utils->createMappedCppPtrValue(new JsLambdaProxyCacheEntry(m_jsBridgeContext, javaFunction), v, m_jsLambdaProxyCacheKey.c_str());
+
   return JValue(javaFunction);
 }
 
@@ -250,8 +289,13 @@ JValue FunctionX::toJavaArray(JSValueConst) const {
   throw std::invalid_argument("Cannot transfer from JS to Java an array of functions!");
 }
 
+JValue FunctionX::toJavaArray(uint32_t, JSValueConst *) const {
+  throw std::invalid_argument("Cannot transfer from JS to Java an array of functions!");
+}
+
 // Get a Java function, register it and return JS wrapper
 JSValue FunctionX::fromJava(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
   const QuickJsUtils *utils = m_jsBridgeContext->getUtils();
   assert(utils != nullptr);
 
@@ -264,20 +308,30 @@ JSValue FunctionX::fromJava(const JValue &value) const {
     return JS_NULL;
   }
 
-  // 3. C++: create a JS function which invokes the JavaMethod with the above Java this
-  auto payload = new CallJavaLambdaPayload { JniGlobalRef<jobject>(javaFunctionObject), javaMethodPtr };
-  JSValue payloadValue = utils->createCppPtrValue<CallJavaLambdaPayload>(payload, true);
-  JSValue invokeFunctionValue = JS_NewCFunctionData(m_ctx, callJavaLambda, 1, 0, 1, &payloadValue);
+  // 3. C++: create a JS function which invokes the JavaMethod with the above Java this (or reuse
+  // the one created when the same lambda has already been given to JS with this signature)
+  // Note: the JavaMethod instance is kept alive by the payload of its cached JS functions
+  return m_jsBridgeContext->getJsWrapperCache()->getOrCreate(javaFunctionObject, javaMethodPtr.get() /*kind*/, [&](jobject *pJavaObjectGlobalRef) {
+    auto payload = new CallJavaLambdaPayload { JniGlobalRef<jobject>(javaFunctionObject), javaMethodPtr };
+    *pJavaObjectGlobalRef = payload->javaThis.get();
 
-  JS_FreeValue(m_ctx, payloadValue);
+    JSValue payloadValue = utils->createCppPtrValue<CallJavaLambdaPayload>(payload);
+    JSValue invokeFunctionValue = JS_NewCFunctionData(m_ctx, callJavaLambda, 1, 0, 1, &payloadValue);
 
-  return invokeFunctionValue;
+    JS_FreeValue(m_ctx, payloadValue);
+
+    return invokeFunctionValue;
+  });
 }
 
 JSValue FunctionX::fromJavaArray(const JniLocalRef<jarray> &) const {
   throw std::invalid_argument("Cannot transfer from Java to JS an array of functions!");
 }
 
+void FunctionX::fromJavaArray(const JniLocalRef<jarray> &, uint32_t, JSValue *) const {
+  throw std::invalid_argument("Cannot transfer from Java to JS an array of functions!");
+}
+
 #endif
 
 
@@ -19,6 +19,7 @@
 #include "JavaType.h"
 #include "JavaMethod.h"
 #include <memory>
+#include <string>
 
 namespace JavaTypes {
 
@@ -35,8 +36,10 @@ public:
 #elif defined(QUICKJS)
   JValue toJava(JSValueConst) const override;
   JValue toJavaArray(JSValueConst) const override;
+  JValue toJavaArray(uint32_t count, JSValueConst *values) const override;
   JSValue fromJava(const JValue &) const override;
   JSValue fromJavaArray(const JniLocalRef<jarray> &values) const override;
+  void fromJavaArray(const JniLocalRef<jarray> &values, uint32_t count, JSValue *jsValues) const override;
 #endif
 
 private:
@@ -46,6 +49,9 @@ private:
   JniGlobalRef<jsBridgeParameter> m_parameter;
   mutable JniGlobalRef<jsBridgeMethod> m_lazyJniJavaMethod;
   mutable std::shared_ptr<JavaMethod> m_lazyCppJavaMethod;
+#if defined(QUICKJS)
+  std::string m_jsLambdaProxyCacheKey;  // unique per FunctionX instance (i.e. per signature)
+#endif
 };
 
 }  // namespace JavaTypes
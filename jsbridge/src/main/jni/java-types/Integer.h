@@ -19,40 +19,49 @@
 #ifndef _JSBRIDGE_JAVATYPES_INTEGER_H
 #define _JSBRIDGE_JAVATYPES_INTEGER_H
 
-#include "Primitive.h"
+#include "PrimitiveType.h"
 
 namespace JavaTypes {
 
-class Integer : public Primitive {
+struct IntegerTraits : NumberTraits<jint> {
+  static constexpr JavaTypeId ID = JavaTypeId::Int;
+  static constexpr JavaTypeId BOXED_ID = JavaTypeId::BoxedInt;
+  static constexpr JavaTypeId ARRAY_ID = JavaTypeId::IntArray;
 
-public:
-  Integer(const JsBridgeContext *);
+  static constexpr const char *JAVA_NAME = "int";
+  static constexpr const char *BOXED_JAVA_NAME = "Integer";
 
-#if defined(DUKTAPE)
-  JValue pop() const override;
-  JValue popArray(uint32_t count, bool expanded) const override;
-
-  duk_ret_t push(const JValue &) const override;
-  duk_ret_t pushArray(const JniLocalRef<jarray> &, bool expand) const override;
-#elif defined(QUICKJS)
-  JValue toJava(JSValueConst) const override;
-  JValue toJavaArray(JSValueConst) const override;
+  static constexpr const char *BOX_SIGNATURE = "(I)Ljava/lang/Integer;";
+  static constexpr const char *UNBOX_METHOD_NAME = "intValue";
+  static constexpr const char *UNBOX_SIGNATURE = "()I";
 
-  JSValue fromJava(const JValue &) const override;
-  JSValue fromJavaArray(const JniLocalRef<jarray> &) const override;
+  using TypedArrayElement = jint;
+  static constexpr const char *TYPED_ARRAY_NAME = "Int32Array";
+  static constexpr const char *ALT_TYPED_ARRAY_NAME = nullptr;
+#if defined(DUKTAPE)
+  static constexpr duk_uint_t DUK_TYPED_ARRAY_TYPE = DUK_BUFOBJ_INT32ARRAY;
 #endif
 
-  JValue callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
-                    const std::vector<JValue> &args) const override;
+  static jint get(const JValue &value) { return value.getInt(); }
+
+  static jint callMethodA(const JniContext *jniContext, const JniRef<jobject> &javaThis, jmethodID methodId, const JValueArgs &args) {
+    return jniContext->callIntMethodA(javaThis, methodId, args);
+  }
 
-  JavaTypeId arrayId() const override { return JavaTypeId::IntArray; }
+  static jint callMethod(const JniContext *jniContext, const JniRef<jobject> &object, jmethodID methodId) {
+    return jniContext->callIntMethod(object, methodId);
+  }
 
-private:
-  JValue box(const JValue &) const override;
-  JValue unbox(const JValue &) const override;
+#if defined(DUKTAPE)
+  static jint getJsValue(duk_context *ctx, duk_idx_t index) { return duk_require_int(ctx, index); }
+  static void pushJsValue(duk_context *ctx, jint value) { duk_push_int(ctx, value); }
+#elif defined(QUICKJS)
+  static JSValue newJsValue(JSContext *ctx, jint value) { return JS_NewInt32(ctx, value); }
+#endif
 };
 
+using Integer = PrimitiveType<IntegerTraits>;
+
 }  // namespace JavaTypes
 
 #endif
-
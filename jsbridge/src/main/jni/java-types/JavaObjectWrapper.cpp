@@ -26,6 +26,11 @@
 #include <exceptions/JniException.h>
 #include <log.h>
 
+#if defined(QUICKJS)
+# include "JsWrapperCache.h"
+# include "QuickJsUtils.h"
+#endif
+
 namespace JavaTypes {
 
 JavaObjectWrapper::JavaObjectWrapper(const JsBridgeContext *jsBridgeContext)
@@ -38,6 +43,7 @@ JavaObjectWrapper::JavaObjectWrapper(const JsBridgeContext *jsBridgeContext)
 #include "StackChecker.h"
 
 JValue JavaObjectWrapper::pop() const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
   CHECK_STACK_OFFSET(m_ctx, -1);
 
   if (!duk_is_object(m_ctx, -1) && !duk_is_undefined(m_ctx, -1) && !duk_is_null(m_ctx, -1)) {
@@ -54,6 +60,7 @@ JValue JavaObjectWrapper::pop() const {
 }
 
 duk_ret_t JavaObjectWrapper::push(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
   CHECK_STACK_OFFSET(m_ctx, 1);
 
   const JniLocalRef<jobject> &javaJavaObjectWrapper = value.getLocalRef();
@@ -69,9 +76,8 @@ duk_ret_t JavaObjectWrapper::push(const JValue &value) const {
 
 #elif defined(QUICKJS)
 
-#include "QuickJsUtils.h"
-
 JValue JavaObjectWrapper::toJava(JSValueConst v) const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
   if (!JS_IsObject(v) && !JS_IsNull(v) && !JS_IsUndefined(v)) {
     return JValue();
   }
@@ -83,6 +89,7 @@ JValue JavaObjectWrapper::toJava(JSValueConst v) const {
 }
 
 JSValue JavaObjectWrapper::fromJava(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
   const JniLocalRef<jobject> &javaJavaObjectWrapper = value.getLocalRef();
 
   if (javaJavaObjectWrapper.isNull()) {
@@ -90,7 +97,19 @@ JSValue JavaObjectWrapper::fromJava(const JValue &value) const {
   }
 
   auto javaWrappedObject = getJniCache()->getJavaObjectWrapperJavaObject(javaJavaObjectWrapper);
-  return JavaObject::create(m_jsBridgeContext, "<wrappedJavaObject>", javaWrappedObject);
+  if (javaWrappedObject.isNull()) {
+    return JavaObject::create(m_jsBridgeContext, "<wrappedJavaObject>", javaWrappedObject);
+  }
+
+  // Reuse the JS wrapper if the same Java object has already been given to JS
+  return m_jsBridgeContext->getJsWrapperCache()->getOrCreate(javaWrappedObject, nullptr /*kind*/, [this, &javaWrappedObject](jobject *pJavaObjectGlobalRef) {
+    JSValue jsWrapper = JavaObject::create(m_jsBridgeContext, "<wrappedJavaObject>", javaWrappedObject);
+
+    // The global ref is owned by the wrapper
+    *pJavaObjectGlobalRef = QuickJsUtils::getJavaObjectGlobalRef(jsWrapper);
+
+    return jsWrapper;
+  });
 }
 
 #endif
@@ -21,11 +21,18 @@
 #include "JavaObject.h"
 #include "JsBridgeContext.h"
 #include "JniCache.h"
+#include "ScratchArena.h"
 #include "jni-helpers/JniContext.h"
 
 #include <exceptions/JniException.h>
 #include <log.h>
 
+#if defined(DUKTAPE)
+# include "DuktapeUtils.h"
+#elif defined(QUICKJS)
+# include "QuickJsUtils.h"
+#endif
+
 namespace {
     const char *JSTOJAVAPROXY_GLOBAL_NAME_PREFIX = "javaTypes_jsToJavaProxy_";
 }
@@ -41,6 +48,7 @@ JsToJavaProxy::JsToJavaProxy(const JsBridgeContext *jsBridgeContext)
 #include "StackChecker.h"
 
 JValue JsToJavaProxy::pop() const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
   CHECK_STACK_OFFSET(m_ctx, -1);
 
   JNIEnv *env = m_jniContext->getJNIEnv();
@@ -52,20 +60,22 @@ JValue JsToJavaProxy::pop() const {
   }
 
   static int jsValueCount = 0;
-  std::string jsValueGlobalName = JSTOJAVAPROXY_GLOBAL_NAME_PREFIX + std::to_string(++jsValueCount);
+  ScratchScope scratchScope(m_jsBridgeContext->getScratchArena());
+  const char *jsValueGlobalName = m_jsBridgeContext->getScratchArena()->makeName(JSTOJAVAPROXY_GLOBAL_NAME_PREFIX, ++jsValueCount);
 
   // Create a new JsToJavaProxy to the Java object with a new global name
   auto javaWrappedObject = JavaObject::getJavaThis(m_jsBridgeContext, -1);
-  JStringLocalRef jsValueName(m_jniContext, jsValueGlobalName.c_str());
+  JStringLocalRef jsValueName(m_jniContext, jsValueGlobalName);
   auto jsToJavaProxy = getJniCache()->newJsToJavaProxy(javaWrappedObject, jsValueName);
   jsValueName.release();
 
   // Set value
-  duk_put_global_string(m_ctx, jsValueGlobalName.c_str());
+  duk_put_global_string(m_ctx, jsValueGlobalName);
   return JValue(jsToJavaProxy);
 }
 
 duk_ret_t JsToJavaProxy::push(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
   CHECK_STACK_OFFSET(m_ctx, 1);
 
   const JniLocalRef<jobject> &jValue = value.getLocalRef();
@@ -82,15 +92,17 @@ duk_ret_t JsToJavaProxy::push(const JValue &value) const {
   }
 
   // Push the global JS value with that name
-  duk_get_global_string(m_ctx, jsValueName.toUtf8Chars());
+  std::string strJsValueName = jsValueName.toStdString();
+  m_jsBridgeContext->getUtils()->pushNamedValueOwner(strJsValueName);
+  duk_get_prop_string(m_ctx, -1, strJsValueName.c_str());
+  duk_remove(m_ctx, -2);  // owner
   return 1;
 }
 
 #elif defined(QUICKJS)
 
-#include "QuickJsUtils.h"
-
 JValue JsToJavaProxy::toJava(JSValueConst v) const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
   JNIEnv *env = m_jniContext->getJNIEnv();
   assert(env != nullptr);
 
@@ -99,25 +111,25 @@ JValue JsToJavaProxy::toJava(JSValueConst v) const {
   }
 
   static int jsValueCount = 0;
-  std::string jsValueGlobalName = JSTOJAVAPROXY_GLOBAL_NAME_PREFIX + std::to_string(++jsValueCount);
+  ScratchScope scratchScope(m_jsBridgeContext->getScratchArena());
+  const char *jsValueGlobalName = m_jsBridgeContext->getScratchArena()->makeName(JSTOJAVAPROXY_GLOBAL_NAME_PREFIX, ++jsValueCount);
 
   JniLocalRef<jclass> javaClass = getJavaClass();
 
   // Create a new JsToJavaProxy instance for the Java object with a new global name
   auto javaWrappedObject = JavaObject::getJavaThis(m_jsBridgeContext, v);
-  JStringLocalRef jsValueName(m_jniContext, jsValueGlobalName.c_str());
+  JStringLocalRef jsValueName(m_jniContext, jsValueGlobalName);
   auto jsToJavaProxy = getJniCache()->newJsToJavaProxy(javaWrappedObject, jsValueName);
   jsValueName.release();
 
   // Set value
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
-  JS_SetPropertyStr(m_ctx, globalObj, jsValueGlobalName.c_str(), JS_DupValue(m_ctx, v));
-  JS_FreeValue(m_ctx, globalObj);
+  JS_SetPropertyStr(m_ctx, m_jsBridgeContext->getUtils()->getGlobalObject(), jsValueGlobalName, JS_DupValue(m_ctx, v));
 
   return JValue(jsToJavaProxy);
 }
 
 JSValue JsToJavaProxy::fromJava(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
   const JniLocalRef<jobject> &jValue = value.getLocalRef();
 
   if (jValue.isNull()) {
@@ -131,10 +143,8 @@ JSValue JsToJavaProxy::fromJava(const JValue &value) const {
   }
 
   // Get the global JS value with that name
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
-  JSValue ret = JS_GetPropertyStr(m_ctx, globalObj, jsValueName.c_str());
-  JS_FreeValue(m_ctx, globalObj);
-  return ret;
+  JSValueConst ownerObj = m_jsBridgeContext->getUtils()->getNamedValueOwner(jsValueName);
+  return JS_GetPropertyStr(m_ctx, ownerObj, jsValueName.c_str());
 }
 
 #endif
@@ -17,28 +17,38 @@
 
 #include "JniCache.h"
 #include "JsBridgeContext.h"
+#include "JsValueTable.h"
 #include "exceptions/JniException.h"
 #include "jni-helpers/JniContext.h"
 #include "jni-helpers/JStringLocalRef.h"
 
-namespace {
-  const char *JSVALUE_GLOBAL_NAME_PREFIX = "javaTypes_jsValue_";
-}
-
+#if defined(DUKTAPE)
+# include "DuktapeUtils.h"
+#elif defined(QUICKJS)
+# include "QuickJsUtils.h"
+#endif
 
 namespace JavaTypes {
 
-JsValue::JsValue(const JsBridgeContext *jsBridgeContext, bool isNullable)
- : JavaType(jsBridgeContext, JavaTypeId::JsValue)
+JsValue::JsValue(const JsBridgeContext *jsBridgeContext, JavaTypeId id, bool isNullable)
+ : JavaType(jsBridgeContext, id)
  , m_isNullable(isNullable) {
 }
 
+JniLocalRef<jobject> JsValue::newJavaJsValue(jlong handle) const {
+  if (getTypeId() == JavaTypeId::JsObjectView) {
+    return getJniCache()->newJsObjectView(handle);
+  }
+  return getJniCache()->newJsValue(handle);
+}
+
 #if defined(DUKTAPE)
 
 #include "StackChecker.h"
 
 // JS to Java JsValue
 JValue JsValue::pop() const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
   CHECK_STACK_OFFSET(m_ctx, -1);
 
   JNIEnv *env = m_jniContext->getJNIEnv();
@@ -51,21 +61,20 @@ JValue JsValue::pop() const {
     return JValue();
   }
 
-  static int jsValueCount = 0;
-  std::string jsValueGlobalName = JSVALUE_GLOBAL_NAME_PREFIX + std::to_string(++jsValueCount);
-
-  // Create a new JS value with a new global name
-  JStringLocalRef jsValueName(m_jniContext, jsValueGlobalName.c_str());
-  JniLocalRef<jobject> jsValue = getJniCache()->newJsValue(jsValueName);
-  jsValueName.release();
+  // Store the value in the native table and create a new Java JsValue with its handle
+  jlong handle = m_jsBridgeContext->getJsValueTable()->add();
+  JniLocalRef<jobject> jsValue = newJavaJsValue(handle);
+  if (m_jniContext->exceptionCheck()) {
+    m_jsBridgeContext->getJsValueTable()->remove(handle);
+    throw JniException(m_jniContext);
+  }
 
-  // Set value
-  duk_put_global_string(m_ctx, jsValueGlobalName.c_str());
   return JValue(jsValue);
 }
 
 // Java JsValue to JS
 duk_ret_t JsValue::push(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
   CHECK_STACK_OFFSET(m_ctx, 1);
 
   const JniLocalRef<jobject> &jValue = value.getLocalRef();
@@ -75,6 +84,13 @@ duk_ret_t JsValue::push(const JValue &value) const {
     return 1;
   }
 
+  // Fast path: JsValue created from JS with a native handle
+  jlong handle = getJniCache()->getJsValueHandle(jValue);
+  if (handle != 0) {
+    m_jsBridgeContext->getJsValueTable()->push(handle);
+    return 1;
+  }
+
   // Get JsValue JS name from Java
   JStringLocalRef jsValueName = getJniCache()->getJsValueName(jValue);
   if (m_jniContext->exceptionCheck()) {
@@ -82,13 +98,17 @@ duk_ret_t JsValue::push(const JValue &value) const {
   }
 
   // Push the global JS value with that name
-  duk_get_global_string(m_ctx, jsValueName.toUtf8Chars());
+  std::string strJsValueName = jsValueName.toStdString();
+  m_jsBridgeContext->getUtils()->pushNamedValueOwner(strJsValueName);
+  duk_get_prop_string(m_ctx, -1, strJsValueName.c_str());
+  duk_remove(m_ctx, -2);  // owner
   return 1;
 }
 
 #elif defined(QUICKJS)
 
 JValue JsValue::toJava(JSValueConst v) const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
   JNIEnv *env = m_jniContext->getJNIEnv();
   assert(env != nullptr);
 
@@ -98,31 +118,31 @@ JValue JsValue::toJava(JSValueConst v) const {
     return JValue();
   }
 
-  static int jsValueCount = 0;
-  std::string jsValueGlobalName = JSVALUE_GLOBAL_NAME_PREFIX + std::to_string(++jsValueCount);
-
-  JniLocalRef<jclass> javaClass = getJavaClass();
-
-  // Create a new JS value with a new global name
-  JStringLocalRef jsValueName(m_jniContext, jsValueGlobalName.c_str());
-  JniLocalRef<jobject> jsValue = getJniCache()->newJsValue(jsValueName);
-  jsValueName.release();
-
-  // Set value
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
-  JS_SetPropertyStr(m_ctx, globalObj, jsValueGlobalName.c_str(), JS_DupValue(m_ctx, v));
-  JS_FreeValue(m_ctx, globalObj);
+  // Store the value in the native table and create a new Java JsValue with its handle
+  jlong handle = m_jsBridgeContext->getJsValueTable()->add(v);
+  JniLocalRef<jobject> jsValue = newJavaJsValue(handle);
+  if (m_jniContext->exceptionCheck()) {
+    m_jsBridgeContext->getJsValueTable()->remove(handle);
+    throw JniException(m_jniContext);
+  }
 
   return JValue(jsValue);
 }
 
 JSValue JsValue::fromJava(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
   const JniLocalRef<jobject> &jValue = value.getLocalRef();
 
   if (jValue.isNull()) {
     return JS_NULL;
   }
 
+  // Fast path: JsValue created from JS with a native handle
+  jlong handle = getJniCache()->getJsValueHandle(jValue);
+  if (handle != 0) {
+    return m_jsBridgeContext->getJsValueTable()->get(handle);
+  }
+
   // Get JsValue JS name from Java
   std::string jsValueName = getJniCache()->getJsValueName(jValue).toStdString();
   if (m_jniContext->exceptionCheck()) {
@@ -130,10 +150,8 @@ JSValue JsValue::fromJava(const JValue &value) const {
   }
 
   // Get the global JS value with that name
-  JSValue globalObj = JS_GetGlobalObject(m_ctx);
-  JSValue ret = JS_GetPropertyStr(m_ctx, globalObj, jsValueName.c_str());
-  JS_FreeValue(m_ctx, globalObj);
-  return ret;
+  JSValueConst ownerObj = m_jsBridgeContext->getUtils()->getNamedValueOwner(jsValueName);
+  return JS_GetPropertyStr(m_ctx, ownerObj, jsValueName.c_str());
 }
 
 #endif
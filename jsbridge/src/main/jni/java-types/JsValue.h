@@ -20,10 +20,13 @@
 
 namespace JavaTypes {
 
+// JsValue and JsObjectView (a JsValue subclass) referencing a JS value stored in the
+// native JsValue table
 class JsValue : public JavaType {
 
 public:
-  JsValue(const JsBridgeContext *, bool isNullable);
+  // id: JavaTypeId::JsValue or JavaTypeId::JsObjectView
+  JsValue(const JsBridgeContext *, JavaTypeId id, bool isNullable);
 
 #if defined(DUKTAPE)
   JValue pop() const override;
@@ -34,6 +37,8 @@ public:
 #endif
 
 private:
+  JniLocalRef<jobject> newJavaJsValue(jlong handle) const;
+
   bool m_isNullable;
 };
 
@@ -24,6 +24,10 @@
 #include "exceptions/JsException.h"
 #include "jni-helpers/JniContext.h"
 
+#if defined(QUICKJS)
+# include "QuickJsUtils.h"
+#endif
+
 namespace JavaTypes {
 
 JsonObjectWrapper::JsonObjectWrapper(const JsBridgeContext *jsBridgeContext, bool isNullable)
@@ -48,6 +52,7 @@ JValue JsonObjectWrapper::pop() const {
 
   // Check if the caller passed in a null string.
   if (m_isNullable && duk_is_null_or_undefined(m_ctx, -1)) {
+    JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
     duk_pop(m_ctx);
     return JValue();
   }
@@ -58,6 +63,7 @@ JValue JsonObjectWrapper::pop() const {
   }
 
   JStringLocalRef str(m_jniContext, duk_require_string(m_ctx, -1));
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, duk_get_length(m_ctx, -1));
   duk_pop(m_ctx);
 
   JniLocalRef<jobject> localRef = getJniCache()->newJsonObjectWrapper(str);
@@ -75,6 +81,7 @@ duk_ret_t JsonObjectWrapper::push(const JValue &value) const {
 
   const JniLocalRef<jobject> &jWrapper = value.getLocalRef();
   if (jWrapper.isNull()) {
+    JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
     duk_push_null(m_ctx);
     return 1;
   }
@@ -86,6 +93,8 @@ duk_ret_t JsonObjectWrapper::push(const JValue &value) const {
     throw JniException(m_jniContext);
   }
 
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, str ? strlen(str) : 0);
+
   // Undefined values are returned as an empty string
   if (!str || strlen(str) == 0) {
     duk_push_undefined(m_ctx);
@@ -108,17 +117,18 @@ duk_ret_t JsonObjectWrapper::push(const JValue &value) const {
 
 JValue JsonObjectWrapper::toJava(JSValueConst v) const {
   if (m_isNullable && (JS_IsNull(v) || JS_IsUndefined(v))) {
+    JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
     return JValue();
   }
 
-  JSValue jsonValue = custom_stringify(m_ctx, v, true /*keepErrorStack*/);
+  JSValue jsonValue = custom_stringify(m_ctx, getUtils(), v, true /*keepErrorStack*/);
   if (JS_IsException(jsonValue)) {
     throw getExceptionHandler()->getCurrentJsException();
   }
 
-  const char *jsonCStr = JS_ToCString(m_ctx, jsonValue);
-  JStringLocalRef str(m_jniContext, jsonCStr);
-  JS_FreeCString(m_ctx, jsonCStr);
+  // Direct JS -> Java string conversion (without the UTF-8 copy of JS_ToCString())
+  JStringLocalRef str = getUtils()->toJString(jsonValue);
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, str.utf16Length() * sizeof(jchar));
   JS_FreeValue(m_ctx, jsonValue);
 
   JniLocalRef<jobject> localRef = getJniCache()->newJsonObjectWrapper(str);
@@ -129,6 +139,7 @@ JSValue JsonObjectWrapper::fromJava(const JValue &value) const {
 
   const JniLocalRef<jobject> &jWrapper = value.getLocalRef();
   if (jWrapper.isNull()) {
+    JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
     return JS_NULL;
   }
 
@@ -139,6 +150,7 @@ JSValue JsonObjectWrapper::fromJava(const JValue &value) const {
   }
 
   const char *str = strRef.toUtf8Chars();
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, str ? strlen(str) : 0);
 
   // Undefined values are returned as an empty string
   if (!str || strlen(str) == 0) {
@@ -22,25 +22,35 @@
 #include "JniCache.h"
 #include "JsBridgeContext.h"
 #include "Primitive.h"
+#include "String.h"
 #include "exceptions/JniException.h"
 #include "jni-helpers/JValue.h"
+#include "jni-helpers/JniLocalFrame.h"
 #include <string>
+#include <vector>
+
+#if defined(QUICKJS)
+# include "ExceptionHandler.h"
+# include "QuickJsUtils.h"
+# include "exceptions/JsException.h"
+#endif
 
 namespace {
   JavaTypeId getArrayId(const JavaType *componentType) {
-    auto primitive = dynamic_cast<const JavaTypes::Primitive *>(componentType);
-    if (primitive == nullptr) {
+    if (!componentType->isPrimitive()) {
       return JavaTypeId::ObjectArray;
     }
-    return primitive->arrayId();
+    return static_cast<const JavaTypes::Primitive *>(componentType)->arrayId();
   }
 }
 
 namespace JavaTypes {
 
-List::List(const JsBridgeContext *jsBridgeContext, std::unique_ptr<const JavaType> &&componentType)
+List::List(const JsBridgeContext *jsBridgeContext, std::shared_ptr<const JavaType> &&componentType)
  : JavaType(jsBridgeContext, getArrayId(componentType.get()))
- , m_componentType(std::move(componentType)) {
+ , m_componentType(std::move(componentType))
+ , m_componentJsToJava(m_componentType->getJsToJavaConversion())
+ , m_componentJavaToJs(m_componentType->getJavaToJsConversion()) {
 }
 
 #if defined(DUKTAPE)
@@ -48,6 +58,7 @@ List::List(const JsBridgeContext *jsBridgeContext, std::unique_ptr<const JavaTyp
 #include "StackChecker.h"
 
 JValue List::pop() const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
   CHECK_STACK_OFFSET(m_ctx, -1);
 
   if (duk_is_null_or_undefined(m_ctx, -1)) {
@@ -63,33 +74,49 @@ JValue List::pop() const {
 
   uint32_t count = duk_get_length(m_ctx, -1);
 
-  JniLocalRef<jobject> javaList = m_jsBridgeContext->getJniCache()->newList();
-
-  for (int i = 0; i < count; ++i) {
-    duk_get_prop_index(m_ctx, -1, static_cast<duk_uarridx_t>(i));
-
-    JValue elementValue;
-
-    try {
-      elementValue = m_componentType->pop();
-    } catch (const std::exception &) {
-      duk_pop(m_ctx);  // pop array
-      throw;
-    }
-    const JniLocalRef<jobject> &jElement = elementValue.getLocalRef();
-    m_jsBridgeContext->getJniCache()->addToList(javaList, jElement);
+  // Fill an Object[] which is given at once to the new ArrayList
+  JObjectArrayLocalRef elementArray(m_jniContext, static_cast<jsize>(count), m_jsBridgeContext->getJniCache()->getObjectClass());
+  if (elementArray.isNull()) {
+    duk_pop(m_ctx);  // pop array
+    throw JniException(m_jniContext);
+  }
 
-    if (m_jniContext->exceptionCheck()) {
-      duk_pop(m_ctx);  // pop array
-      throw JniException(m_jniContext);
+  {
+    // (the local frames must be popped before the list is created)
+    JniChunkedLocalFrame localFrame(m_jniContext, count);
+    for (int i = 0; i < count; ++i) {
+      localFrame.next();
+      duk_get_prop_index(m_ctx, -1, static_cast<duk_uarridx_t>(i));
+
+      JValue elementValue;
+
+      try {
+        elementValue = m_componentJsToJava.pop();
+      } catch (const std::exception &) {
+        duk_pop(m_ctx);  // pop array
+        throw;
+      }
+      const JniLocalRef<jobject> &jElement = elementValue.getLocalRef();
+      elementArray.setElement(i, jElement);
+
+      if (m_jniContext->exceptionCheck()) {
+        duk_pop(m_ctx);  // pop array
+        throw JniException(m_jniContext);
+      }
     }
   }
 
   duk_pop(m_ctx);  // pop array
+
+  JniLocalRef<jobject> javaList = m_jsBridgeContext->getJniCache()->newListFromArray(elementArray);
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
   return JValue(javaList);
 }
 
 duk_ret_t List::push(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
   CHECK_STACK_OFFSET(m_ctx, 1);
 
   const JniLocalRef<jobject> &jList = value.getLocalRef();
@@ -99,14 +126,22 @@ duk_ret_t List::push(const JValue &value) const {
     return 1;
   }
 
+  // Get all the elements at once
+  JObjectArrayLocalRef elementArray = m_jsBridgeContext->getJniCache()->listToArray(jList);
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+
   duk_push_array(m_ctx);
 
-  const int count = m_jsBridgeContext->getJniCache()->getListLength(jList);
-  for (int i = 0; i < count; ++i) {
-    JniLocalRef<jobject> jElement = m_jsBridgeContext->getJniCache()->getListElement(jList, i);
+  const jsize count = elementArray.getLength();
+  JniChunkedLocalFrame localFrame(m_jniContext, count);
+  for (jsize i = 0; i < count; ++i) {
+    localFrame.next();
+    JniLocalRef<jobject> jElement = elementArray.getElement(i);
 
     try {
-      m_componentType->push(JValue(jElement));
+      m_componentJavaToJs.push(JValue(jElement));
       duk_put_prop_index(m_ctx, -2, static_cast<duk_uarridx_t>(i));
     } catch (const std::exception &) {
       duk_pop(m_ctx);  // pop array
@@ -120,6 +155,7 @@ duk_ret_t List::push(const JValue &value) const {
 #elif defined(QUICKJS)
 
 JValue List::toJava(JSValueConst v) const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
   if (JS_IsNull(v) || JS_IsUndefined(v)) {
     return JValue();
   }
@@ -128,51 +164,98 @@ JValue List::toJava(JSValueConst v) const {
     throw std::invalid_argument("Cannot convert value to array");
   }
 
-  JSValue lengthValue = JS_GetPropertyStr(m_ctx, v, "length");
+  JSValue lengthValue = getUtils()->getProperty(v, QuickJsUtils::PropertyName::Length);
   assert(JS_IsNumber(lengthValue));
   uint32_t count = JS_VALUE_GET_INT(lengthValue);
   JS_FreeValue(m_ctx, lengthValue);
 
-  JniLocalRef<jobject> javaList = m_jsBridgeContext->getJniCache()->newList();
-
-  for (int i = 0; i < count; ++i) {
-    JSValue elementJsValue = JS_GetPropertyUint32(m_ctx, v, i);
-    JS_AUTORELEASE_VALUE(m_ctx, elementJsValue);  // also released in case of exception!
-    JValue elementValue = m_componentType->toJava(elementJsValue);
+  if (m_componentType->getTypeId() == JavaTypeId::String) {
+    // Bulk conversion of the fast array storage (see String::toJavaStrings())
+    JSValue *fastArrayValues = nullptr;
+    uint32_t fastArrayCount = 0;
+    JValue javaList;
+    if (JS_GetFastArray(m_ctx, v, &fastArrayValues, &fastArrayCount) && fastArrayCount == count &&
+        static_cast<const String *>(m_componentType.get())->toJavaStrings(count, fastArrayValues, true, &javaList)) {
+      return javaList;
+    }
+  }
 
-    const JniLocalRef<jobject> &jElement = elementValue.getLocalRef();
-    m_jsBridgeContext->getJniCache()->addToList(javaList, jElement);
+  // Fill an Object[] which is given at once to the new ArrayList
+  JObjectArrayLocalRef elementArray(m_jniContext, static_cast<jsize>(count), m_jsBridgeContext->getJniCache()->getObjectClass());
+  if (elementArray.isNull()) {
+    throw JniException(m_jniContext);
+  }
 
-    if (m_jniContext->exceptionCheck()) {
-      throw JniException(m_jniContext);
+  {
+    // (the local frames must be popped before the list is created)
+    JniChunkedLocalFrame localFrame(m_jniContext, count);
+    for (int i = 0; i < count; ++i) {
+      localFrame.next();
+      JSValue elementJsValue = JS_GetPropertyUint32(m_ctx, v, i);
+      JS_AUTORELEASE_VALUE(m_ctx, elementJsValue);  // also released in case of exception!
+      JValue elementValue = m_componentJsToJava.toJava(elementJsValue);
+
+      const JniLocalRef<jobject> &jElement = elementValue.getLocalRef();
+      elementArray.setElement(i, jElement);
+
+      if (m_jniContext->exceptionCheck()) {
+        throw JniException(m_jniContext);
+      }
     }
   }
 
+  JniLocalRef<jobject> javaList = m_jsBridgeContext->getJniCache()->newListFromArray(elementArray);
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
   return JValue(javaList);
 }
 
 JSValue List::fromJava(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
   const JniLocalRef<jobject> &jList = value.getLocalRef();
 
   if (jList.isNull()) {
     return JS_NULL;
   }
 
-  JSValue jsArray = JS_NewArray(m_ctx);
-
-  const int count = m_jsBridgeContext->getJniCache()->getListLength(jList);
-  for (int i = 0; i < count; ++i) {
-    JniLocalRef<jobject> jElement = m_jsBridgeContext->getJniCache()->getListElement(jList, i);
+  // Get all the elements at once
+  JObjectArrayLocalRef elementArray = m_jsBridgeContext->getJniCache()->listToArray(jList);
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
 
-    try {
-      JSValue jsElement = m_componentType->fromJava(JValue(jElement));
-      JS_SetPropertyUint32(m_ctx, jsArray, static_cast<uint32_t>(i), jsElement);
-    } catch (const std::exception &) {
-      JS_FreeValue(m_ctx, jsArray);
-      throw;
+  // Convert all the elements first so that the JS array is allocated at once
+  const jsize count = elementArray.getLength();
+  std::vector<JSValue> jsElements;
+
+  if (m_componentType->getTypeId() == JavaTypeId::String) {
+    // Bulk conversion (see String::fromJavaStrings())
+    jsElements.resize(static_cast<size_t>(count));
+    static_cast<const String *>(m_componentType.get())->fromJavaStrings(elementArray, static_cast<uint32_t>(count), jsElements.data());
+  } else {
+    jsElements.reserve(static_cast<size_t>(count));
+
+    JniChunkedLocalFrame localFrame(m_jniContext, count);
+    for (jsize i = 0; i < count; ++i) {
+      localFrame.next();
+      JniLocalRef<jobject> jElement = elementArray.getElement(i);
+
+      try {
+        jsElements.push_back(m_componentJavaToJs.fromJava(JValue(jElement)));
+      } catch (const std::exception &) {
+        for (JSValue jsElement : jsElements) {
+          JS_FreeValue(m_ctx, jsElement);
+        }
+        throw;
+      }
     }
   }
 
+  JSValue jsArray = JS_NewArrayFrom(m_ctx, static_cast<uint32_t>(count), jsElements.data());
+  if (JS_IsException(jsArray)) {
+    throw m_jsBridgeContext->getExceptionHandler()->getCurrentJsException();
+  }
   return jsArray;
 }
 
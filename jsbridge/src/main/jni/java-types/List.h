@@ -26,7 +26,7 @@ namespace JavaTypes {
 class List : public JavaType {
 
 public:
-  List(const JsBridgeContext *, std::unique_ptr<const JavaType> &&componentType);
+  List(const JsBridgeContext *, std::shared_ptr<const JavaType> &&componentType);
 
 #if defined(DUKTAPE)
   JValue pop() const override;
@@ -37,7 +37,11 @@ public:
 #endif
 
 private:
-  std::unique_ptr<const JavaType> m_componentType;
+  std::shared_ptr<const JavaType> m_componentType;
+
+  // Element conversions selected once (see JsToJavaConversion)
+  JsToJavaConversion m_componentJsToJava;
+  JavaToJsConversion m_componentJavaToJs;
 };
 
 }  // namespace JavaTypes
@@ -19,40 +19,50 @@
 #ifndef _JSBRIDGE_JAVATYPES_LONG_H
 #define _JSBRIDGE_JAVATYPES_LONG_H
 
-#include "Primitive.h"
+#include "PrimitiveType.h"
 
 namespace JavaTypes {
 
-class Long : public Primitive {
+struct LongTraits : NumberTraits<jlong> {
+  static constexpr JavaTypeId ID = JavaTypeId::Long;
+  static constexpr JavaTypeId BOXED_ID = JavaTypeId::BoxedLong;
+  static constexpr JavaTypeId ARRAY_ID = JavaTypeId::LongArray;
 
-public:
-  Long(const JsBridgeContext *);
+  static constexpr const char *JAVA_NAME = "long";
+  static constexpr const char *BOXED_JAVA_NAME = "Long";
 
-#if defined(DUKTAPE)
-  JValue pop() const override;
-  JValue popArray(uint32_t count, bool expanded) const override;
-
-  duk_ret_t push(const JValue &) const override;
-  duk_ret_t pushArray(const JniLocalRef<jarray> &values, bool expand) const override;
-#elif defined(QUICKJS)
-  JValue toJava(JSValueConst) const override;
-  JValue toJavaArray(JSValueConst) const override;
+  static constexpr const char *BOX_SIGNATURE = "(J)Ljava/lang/Long;";
+  static constexpr const char *UNBOX_METHOD_NAME = "longValue";
+  static constexpr const char *UNBOX_SIGNATURE = "()J";
 
-  JSValue fromJava(const JValue &) const override;
-  JSValue fromJavaArray(const JniLocalRef<jarray> &) const override;
+  // No int64 in Duktape and no BigInt conversion: long values and arrays are converted from/to doubles
+  using TypedArrayElement = double;
+  static constexpr const char *TYPED_ARRAY_NAME = "Float64Array";
+  static constexpr const char *ALT_TYPED_ARRAY_NAME = nullptr;
+#if defined(DUKTAPE)
+  static constexpr duk_uint_t DUK_TYPED_ARRAY_TYPE = DUK_BUFOBJ_FLOAT64ARRAY;
 #endif
 
-  JValue callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
-                    const std::vector<JValue> &args) const override;
+  static jlong get(const JValue &value) { return value.getLong(); }
+
+  static jlong callMethodA(const JniContext *jniContext, const JniRef<jobject> &javaThis, jmethodID methodId, const JValueArgs &args) {
+    return jniContext->callLongMethodA(javaThis, methodId, args);
+  }
 
-  JavaTypeId arrayId() const override { return JavaTypeId::LongArray; }
+  static jlong callMethod(const JniContext *jniContext, const JniRef<jobject> &object, jmethodID methodId) {
+    return jniContext->callLongMethod(object, methodId);
+  }
 
-private:
-  JValue box(const JValue &) const override;
-  JValue unbox(const JValue &) const override;
+#if defined(DUKTAPE)
+  static jlong getJsValue(duk_context *ctx, duk_idx_t index) { return static_cast<jlong>(duk_require_number(ctx, index)); }
+  static void pushJsValue(duk_context *ctx, jlong value) { duk_push_number(ctx, static_cast<duk_double_t>(value)); }
+#elif defined(QUICKJS)
+  static JSValue newJsValue(JSContext *ctx, jlong value) { return JS_NewInt64(ctx, value); }
+#endif
 };
 
+using Long = PrimitiveType<LongTraits>;
+
 }  // namespace JavaTypes
 
 #endif
-
@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Map.h"
+
+#include "AutoReleasedJSValue.h"
+#include "ExceptionHandler.h"
+#include "JniCache.h"
+#include "JsBridgeContext.h"
+#include "exceptions/JniException.h"
+#include "exceptions/JsException.h"
+#include "jni-helpers/JValue.h"
+#include "jni-helpers/JniLocalFrame.h"
+#include <string>
+
+#if defined(DUKTAPE)
+# include "StackChecker.h"
+#elif defined(QUICKJS)
+# include "QuickJsUtils.h"
+#endif
+
+namespace JavaTypes {
+
+Map::Map(const JsBridgeContext *jsBridgeContext, std::shared_ptr<const JavaType> &&valueType)
+ : JavaType(jsBridgeContext, JavaTypeId::Map)
+ , m_valueType(std::move(valueType)) {
+}
+
+#if defined(DUKTAPE)
+
+JValue Map::pop() const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
+  CHECK_STACK_OFFSET(m_ctx, -1);
+
+  if (duk_is_null_or_undefined(m_ctx, -1)) {
+    duk_pop(m_ctx);
+    return JValue();
+  }
+
+  if (!duk_is_object(m_ctx, -1) || duk_is_array(m_ctx, -1) || duk_is_function(m_ctx, -1)) {
+    const auto message = std::string("Cannot convert ") + duk_safe_to_string(m_ctx, -1) + " to map";
+    duk_pop(m_ctx);
+    throw std::invalid_argument(message);
+  }
+
+  // Count the (own enumerable) properties first to pre-allocate the map
+  jsize count = 0;
+  duk_enum(m_ctx, -1, DUK_ENUM_OWN_PROPERTIES_ONLY);
+  while (duk_next(m_ctx, -1, 0 /*getValue*/)) {
+    duk_pop(m_ctx);  // key
+    ++count;
+  }
+  duk_pop(m_ctx);  // enum
+
+  const JniCache *jniCache = m_jsBridgeContext->getJniCache();
+  JniLocalRef<jobject> javaMap = jniCache->newMap(count);
+  if (m_jniContext->exceptionCheck()) {
+    duk_pop(m_ctx);  // object
+    throw JniException(m_jniContext);
+  }
+
+  duk_enum(m_ctx, -1, DUK_ENUM_OWN_PROPERTIES_ONLY);
+
+  JniChunkedLocalFrame localFrame(m_jniContext, count);
+  while (duk_next(m_ctx, -1, 1 /*getValue*/)) {
+    localFrame.next();
+    JStringLocalRef jKey(m_jniContext, duk_get_string(m_ctx, -2));
+
+    JValue value;
+    try {
+      value = m_valueType->pop();
+    } catch (const std::exception &) {
+      duk_pop_3(m_ctx);  // key + enum + object
+      throw;
+    }
+    duk_pop(m_ctx);  // key
+
+    jniCache->putMapEntry(javaMap, jKey, value.getLocalRef());
+    if (m_jniContext->exceptionCheck()) {
+      duk_pop_2(m_ctx);  // enum + object
+      throw JniException(m_jniContext);
+    }
+  }
+
+  duk_pop_2(m_ctx);  // enum + object
+  return JValue(javaMap);
+}
+
+duk_ret_t Map::push(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
+  CHECK_STACK_OFFSET(m_ctx, 1);
+
+  const JniLocalRef<jobject> &jMap = value.getLocalRef();
+
+  if (jMap.isNull()) {
+    duk_push_null(m_ctx);
+    return 1;
+  }
+
+  // Get all the entries at once
+  const JniCache *jniCache = m_jsBridgeContext->getJniCache();
+  JObjectArrayLocalRef entryArray = jniCache->mapEntriesToArray(jMap);
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+
+  duk_push_object(m_ctx);
+
+  const jsize count = entryArray.getLength();
+  JniChunkedLocalFrame localFrame(m_jniContext, count);
+  for (jsize i = 0; i < count; ++i) {
+    localFrame.next();
+    JniLocalRef<jobject> jEntry = entryArray.getElement(i);
+    JniLocalRef<jobject> jKey = jniCache->getMapEntryKey(jEntry);
+    JniLocalRef<jobject> jValue = jniCache->getMapEntryValue(jEntry);
+    if (m_jniContext->exceptionCheck()) {
+      duk_pop(m_ctx);  // object
+      throw JniException(m_jniContext);
+    }
+
+    // (IsInstanceOf() is also true for null)
+    if (jKey.isNull() || !m_jniContext->isInstanceOf(jKey, jniCache->getStringClass())) {
+      duk_pop(m_ctx);  // object
+      throw std::invalid_argument("Cannot convert map to JS object: the keys must be (non-null) strings");
+    }
+
+    try {
+      m_valueType->push(JValue(jValue));
+
+      // Defining the property (instead of putting it) does not call any setter, e.g. for "__proto__"
+      duk_push_string(m_ctx, JStringLocalRef(jKey.staticCast<jstring>()).toUtf8Chars());
+      duk_swap_top(m_ctx, -2);
+      duk_def_prop(m_ctx, -3, DUK_DEFPROP_HAVE_VALUE | DUK_DEFPROP_SET_WEC);
+    } catch (const std::exception &) {
+      duk_pop(m_ctx);  // object
+      throw;
+    }
+  }
+
+  return 1;
+}
+
+#elif defined(QUICKJS)
+
+namespace {
+  // Release the property enumeration of JS_GetOwnPropertyNames() (also in case of exception)
+  struct PropertyEnumReleaser {
+    ~PropertyEnumReleaser() {
+      for (uint32_t i = 0; i < count; ++i) {
+        JS_FreeAtom(ctx, properties[i].atom);
+      }
+      js_free(ctx, properties);
+    }
+
+    JSContext *ctx;
+    JSPropertyEnum *properties;
+    uint32_t count;
+  };
+}
+
+JValue Map::toJava(JSValueConst v) const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
+  if (JS_IsNull(v) || JS_IsUndefined(v)) {
+    return JValue();
+  }
+
+  if (!JS_IsObject(v) || JS_IsArray(m_ctx, v) || JS_IsFunction(m_ctx, v)) {
+    throw std::invalid_argument("Cannot convert value to map");
+  }
+
+  JSPropertyEnum *properties = nullptr;
+  uint32_t count = 0;
+  if (JS_GetOwnPropertyNames(m_ctx, &properties, &count, v, JS_GPN_STRING_MASK | JS_GPN_ENUM_ONLY) < 0) {
+    throw getExceptionHandler()->getCurrentJsException();
+  }
+  PropertyEnumReleaser propertyEnumReleaser { m_ctx, properties, count };
+
+  const JniCache *jniCache = m_jsBridgeContext->getJniCache();
+  JniLocalRef<jobject> javaMap = jniCache->newMap(static_cast<jsize>(count));
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+
+  JniChunkedLocalFrame localFrame(m_jniContext, count);
+  for (uint32_t i = 0; i < count; ++i) {
+    localFrame.next();
+    JSAtom atom = properties[i].atom;
+
+    JSValue keyJsValue = JS_AtomToString(m_ctx, atom);
+    JS_AUTORELEASE_VALUE(m_ctx, keyJsValue);
+    JStringLocalRef jKey = getUtils()->toJString(keyJsValue);
+
+    JSValue propertyJsValue = JS_GetProperty(m_ctx, v, atom);
+    if (JS_IsException(propertyJsValue)) {
+      throw getExceptionHandler()->getCurrentJsException();
+    }
+    JS_AUTORELEASE_VALUE(m_ctx, propertyJsValue);  // also released in case of exception!
+    JValue value = m_valueType->toJava(propertyJsValue);
+
+    jniCache->putMapEntry(javaMap, jKey, value.getLocalRef());
+    if (m_jniContext->exceptionCheck()) {
+      throw JniException(m_jniContext);
+    }
+  }
+
+  return JValue(javaMap);
+}
+
+JSValue Map::fromJava(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
+  const JniLocalRef<jobject> &jMap = value.getLocalRef();
+
+  if (jMap.isNull()) {
+    return JS_NULL;
+  }
+
+  // Get all the entries at once
+  const JniCache *jniCache = m_jsBridgeContext->getJniCache();
+  JObjectArrayLocalRef entryArray = jniCache->mapEntriesToArray(jMap);
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+
+  JSValue jsObject = JS_NewObject(m_ctx);
+
+  const jsize count = entryArray.getLength();
+  JniChunkedLocalFrame localFrame(m_jniContext, count);
+  for (jsize i = 0; i < count; ++i) {
+    localFrame.next();
+    JniLocalRef<jobject> jEntry = entryArray.getElement(i);
+    JniLocalRef<jobject> jKey = jniCache->getMapEntryKey(jEntry);
+    JniLocalRef<jobject> jValue = jniCache->getMapEntryValue(jEntry);
+    if (m_jniContext->exceptionCheck()) {
+      JS_FreeValue(m_ctx, jsObject);
+      throw JniException(m_jniContext);
+    }
+
+    // (IsInstanceOf() is also true for null)
+    if (jKey.isNull() || !m_jniContext->isInstanceOf(jKey, jniCache->getStringClass())) {
+      JS_FreeValue(m_ctx, jsObject);
+      throw std::invalid_argument("Cannot convert map to JS object: the keys must be (non-null) strings");
+    }
+
+    JSValue jsValue;
+    try {
+      jsValue = m_valueType->fromJava(JValue(jValue));
+    } catch (const std::exception &) {
+      JS_FreeValue(m_ctx, jsObject);
+      throw;
+    }
+
+    // Defining the property (instead of setting it) does not call any setter, e.g. for "__proto__"
+    JSValue jsKey = getUtils()->toJsString(JStringLocalRef(jKey.staticCast<jstring>()));
+    JSAtom atom = JS_ValueToAtom(m_ctx, jsKey);
+    JS_FreeValue(m_ctx, jsKey);
+    JS_DefinePropertyValue(m_ctx, jsObject, atom, jsValue, JS_PROP_C_W_E);
+    // No JS_FreeValue(m_ctx, jsValue) after JS_DefinePropertyValue()
+    JS_FreeAtom(m_ctx, atom);
+  }
+
+  return jsObject;
+}
+
+#endif
+
+}  // namespace JavaTypes
@@ -42,7 +42,8 @@ namespace JavaTypes {
 
 Object::Object(const JsBridgeContext *jsBridgeContext, std::optional<JniGlobalRef<jstring>> optJavaName)
  : JavaType(jsBridgeContext, JavaTypeId::Object)
- , m_optJavaName(std::move(optJavaName)) {
+ , m_optJavaName(std::move(optJavaName))
+ , m_optJavaNameId(m_optJavaName.has_value() ? getJavaTypeIdByJavaName(JStringLocalRef(m_optJavaName.value()).getUtf16View()) : JavaTypeId::Unknown) {
 }
 
 #if defined(DUKTAPE)
@@ -51,6 +52,7 @@ Object::Object(const JsBridgeContext *jsBridgeContext, std::optional<JniGlobalRe
 #include "JsonObjectWrapper.h"
 
 JValue Object::pop() const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
   CHECK_STACK_OFFSET(m_ctx, -1);
 
   duk_ret_t dukType = duk_get_type(m_ctx, -1);
@@ -101,6 +103,7 @@ JValue Object::pop() const {
 }
 
 duk_ret_t Object::push(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
   CHECK_STACK_OFFSET(m_ctx, 1);
 
   const JniLocalRef<jobject> &jBasicObject = value.getLocalRef();
@@ -110,20 +113,15 @@ duk_ret_t Object::push(const JValue &value) const {
     return 1;
   }
 
-  JavaType *javaType = newJavaType(jBasicObject);
+  auto javaType = getJavaType(jBasicObject);
 
   if (javaType == nullptr) {
     // Java Any -> JS wrapped JavaObject
     auto javaObjectWrapper = m_jsBridgeContext->getJniCache()->getOrCreateJavaObjectWrapper(jBasicObject);
-    javaType = new JavaObjectWrapper(m_jsBridgeContext);
-    duk_ret_t ret = javaType->push(JValue(javaObjectWrapper));
-    delete javaType;
-    return ret;
+    return JavaObjectWrapper(m_jsBridgeContext).push(JValue(javaObjectWrapper));
   }
 
-  duk_ret_t ret = javaType->push(value);
-  delete javaType;
-  return ret;
+  return javaType->push(value);
 }
 
 #elif defined(QUICKJS)
@@ -131,6 +129,7 @@ duk_ret_t Object::push(const JValue &value) const {
 #include "QuickJsUtils.h"
 
 JValue Object::toJava(JSValueConst v) const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
   if (JS_IsUndefined(v) || JS_IsNull(v)) {
     return JValue();
   }
@@ -169,22 +168,18 @@ JValue Object::toJava(JSValueConst v) const {
 }
 
 JSValue Object::fromJava(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
   const JniLocalRef<jobject> &jBasicObject = value.getLocalRef();
 
   if (jBasicObject.isNull()) {
     return JS_NULL;
   }
 
-  auto javaNameRef = getJavaName(jBasicObject);
-  auto javaNameView = javaNameRef.getUtf16View();
-  const auto id = getJavaTypeIdByJavaName(javaNameView);
-
-  auto javaType = std::unique_ptr<JavaType>(newJavaType(jBasicObject));
+  auto javaType = getJavaType(jBasicObject);
   if (javaType == nullptr) {
     // Java Any -> JS wrapped JavaObject
     auto javaObjectWrapper = m_jsBridgeContext->getJniCache()->getOrCreateJavaObjectWrapper(jBasicObject);
-    javaType.reset(new JavaObjectWrapper(m_jsBridgeContext));
-    return javaType->fromJava(JValue(javaObjectWrapper));
+    return JavaObjectWrapper(m_jsBridgeContext).fromJava(JValue(javaObjectWrapper));
   }
 
   return javaType->fromJava(value);
@@ -192,37 +187,42 @@ JSValue Object::fromJava(const JValue &value) const {
 
 #endif
 
-JStringLocalRef Object::getJavaName(const JniLocalRef<jobject> &object) const {
+JStringLocalRef Object::getJavaName(const JniLocalRef<jclass> &javaClass) const {
   if (m_optJavaName.has_value()) {
     return JStringLocalRef(m_optJavaName.value());
   }
 
-  // Get the class of the passed Java object
-  jmethodID getClass = m_jniContext->getMethodID(m_jsBridgeContext->getJniCache()->getObjectClass(), "getClass", "()Ljava/lang/Class;");
-  JniLocalRef<jclass> javaClassRef = m_jniContext->callObjectMethod<jclass>(object, getClass);
-  JniLocalRef<jclass> javaClassClass = m_jsBridgeContext->getJniCache()->getJavaClassClass();
-
+  JStringLocalRef javaNameRef = getJniCache()->getJavaClassName(javaClass);
   if (m_jniContext->exceptionCheck()) {
     throw JniException(m_jniContext);
   }
 
-  // Call java.lang.Class::getName()
-  jmethodID getName = m_jniContext->getMethodID(javaClassClass, "getName", "()Ljava/lang/String;");
+  return javaNameRef;
+}
 
-  if (m_jniContext->exceptionCheck()) {
-    throw JniException(m_jniContext);
+std::shared_ptr<const JavaType> Object::getJavaType(const JniLocalRef<jobject> &object) const {
+  JniLocalRef<jclass> javaClass = m_jniContext->getObjectClass(object);
+
+  // Note: object arrays are always resolved from their class (and their component class) so sub-arrays
+  // of nested arrays can also use the cache
+  if (m_optJavaName.has_value() && m_optJavaNameId != JavaTypeId::ObjectArray) {
+    // The type depends on the given Java name and not (only) on the class
+    return std::shared_ptr<const JavaType>(newJavaType(object, javaClass));
   }
 
-  JStringLocalRef javaNameRef = m_jniContext->callStringMethod(javaClassRef, getName);
-  if (m_jniContext->exceptionCheck()) {
-    throw JniException(m_jniContext);
+  // Resolving the type from the class needs several JNI calls so it is cached
+  const JavaTypeProvider &javaTypeProvider = m_jsBridgeContext->getJavaTypeProvider();
+  std::shared_ptr<const JavaType> javaType;
+  if (!javaTypeProvider.findClassType(javaClass, &javaType)) {
+    javaType.reset(newJavaType(object, javaClass));
+    javaTypeProvider.addClassType(javaClass, javaType);
   }
 
-  return javaNameRef;
+  return javaType;
 }
 
-JavaType *Object::newJavaType(const JniLocalRef<jobject> &object) const {
-  auto javaNameRef = getJavaName(object);
+JavaType *Object::newJavaType(const JniLocalRef<jobject> &object, const JniLocalRef<jclass> &javaClass) const {
+  auto javaNameRef = getJavaName(javaClass);
   auto javaNameView = javaNameRef.getUtf16View();
   JavaTypeId id = getJavaTypeIdByJavaName(javaNameView);
 
@@ -260,11 +260,7 @@ JavaType *Object::newJavaType(const JniLocalRef<jobject> &object) const {
     }
     case JavaTypeId::ObjectArray: {
       // ObjectArray -> Array of Object
-
-      // Get the class of the passed Java object
-      jmethodID getClass = m_jniContext->getMethodID(m_jsBridgeContext->getJniCache()->getObjectClass(), "getClass", "()Ljava/lang/Class;");
-      JniLocalRef<jclass> javaClassRef = m_jniContext->callObjectMethod<jclass>(object, getClass);
-      return new Array(m_jsBridgeContext, javaClassRef);
+      return new Array(m_jsBridgeContext, javaClass);
     }
     case JavaTypeId::Unknown:
     default:
@@ -40,9 +40,11 @@ private:
   friend class Array;
 
   const std::optional<JniGlobalRef<jstring>> m_optJavaName;
+  const JavaTypeId m_optJavaNameId;
 
-  JStringLocalRef getJavaName(const JniLocalRef<jobject> &object) const;
-  JavaType *newJavaType(const JniLocalRef<jobject> &jobject) const;
+  JStringLocalRef getJavaName(const JniLocalRef<jclass> &javaClass) const;
+  std::shared_ptr<const JavaType> getJavaType(const JniLocalRef<jobject> &object) const;
+  JavaType *newJavaType(const JniLocalRef<jobject> &object, const JniLocalRef<jclass> &javaClass) const;
   JavaType *newJavaTypeFromJavaName(std::u16string_view javaName) const;
   JavaType *newJavaTypeFromJavaTypeId(JavaTypeId id, std::unique_ptr<const JavaType> &&componentJavaType) const;
 };
@@ -0,0 +1,1153 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Payload.h"
+
+#include "ExceptionHandler.h"
+#include "JniCache.h"
+#include "JsBridgeContext.h"
+#include "exceptions/JniException.h"
+#include "exceptions/JsException.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(DUKTAPE)
+# include "StackChecker.h"
+#elif defined(QUICKJS)
+# include "AutoReleasedJSValue.h"
+# include "QuickJsUtils.h"
+#endif
+
+namespace {
+  // Must match PayloadCodec.kt
+  enum Tag : uint8_t {
+    TAG_NULL = 0,
+    TAG_FALSE = 1,
+    TAG_TRUE = 2,
+    TAG_INT = 3,
+    TAG_DOUBLE = 4,
+    TAG_LATIN1_STRING = 5,
+    TAG_UTF8_STRING = 6,
+    TAG_ARRAY = 7,
+    TAG_OBJECT = 8,
+    TAG_SHAPED_OBJECT = 9,
+  };
+
+  // Maximum nesting level of arrays and objects (to detect cyclic values)
+  const int MAX_DEPTH = 1000;
+
+  void checkDepth(int depth) {
+    if (depth > MAX_DEPTH) {
+      throw std::invalid_argument("Payload nesting is too deep (cyclic value?)");
+    }
+  }
+
+  void writeTag(std::string &out, Tag tag) {
+    out += static_cast<char>(tag);
+  }
+
+  void writeVarint(std::string &out, uint32_t value) {
+    while (value >= 0x80) {
+      out += static_cast<char>((value & 0x7F) | 0x80);
+      value >>= 7;
+    }
+    out += static_cast<char>(value);
+  }
+
+  void writeUint32(std::string &out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+      out += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+  }
+
+  void patchUint32(std::string &out, size_t offset, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+      out[offset + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+  }
+
+  void writeNumber(std::string &out, double d) {
+    // Integers (except -0) are written as compact zigzag varints
+    if (d >= INT32_MIN && d <= INT32_MAX && std::floor(d) == d && !(d == 0 && std::signbit(d))) {
+      auto i = static_cast<int32_t>(d);
+      writeTag(out, TAG_INT);
+      writeVarint(out, (static_cast<uint32_t>(i) << 1) ^ static_cast<uint32_t>(i >> 31));
+      return;
+    }
+
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    writeTag(out, TAG_DOUBLE);
+    for (int i = 0; i < 8; ++i) {
+      out += static_cast<char>((bits >> (8 * i)) & 0xFF);
+    }
+  }
+
+  bool isAscii(std::string_view s) {
+    for (char c : s) {
+      if (static_cast<uint8_t>(c) >= 0x80) return false;
+    }
+    return true;
+  }
+
+  void writeString(std::string &out, std::string_view s, bool latin1) {
+    writeTag(out, latin1 ? TAG_LATIN1_STRING : TAG_UTF8_STRING);
+    writeVarint(out, static_cast<uint32_t>(s.size()));
+    out.append(s.data(), s.size());
+  }
+
+  std::string latin1ToUtf8(std::string_view latin1) {
+    std::string utf8;
+    utf8.reserve(latin1.size() * 2);
+    for (char c : latin1) {
+      auto u = static_cast<uint8_t>(c);
+      if (u < 0x80) {
+        utf8 += c;
+      } else {
+        utf8 += static_cast<char>(0xC0 | (u >> 6));
+        utf8 += static_cast<char>(0x80 | (u & 0x3F));
+      }
+    }
+    return utf8;
+  }
+
+  // Sequential reader of an encoded payload
+  class Reader {
+  public:
+    explicit Reader(std::string_view buffer)
+     : m_p(reinterpret_cast<const uint8_t *>(buffer.data()))
+     , m_end(m_p + buffer.size()) {
+    }
+
+    uint8_t readByte() {
+      require(1);
+      return *m_p++;
+    }
+
+    uint32_t readVarint() {
+      uint32_t value = 0;
+      for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t b = readByte();
+        value |= static_cast<uint32_t>(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) return value;
+      }
+      throw std::invalid_argument("Invalid payload varint");
+    }
+
+    int32_t readInt() {
+      uint32_t zigzag = readVarint();
+      return static_cast<int32_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+    }
+
+    uint32_t readUint32() {
+      require(4);
+      uint32_t value = m_p[0] | (m_p[1] << 8) | (m_p[2] << 16) | (static_cast<uint32_t>(m_p[3]) << 24);
+      m_p += 4;
+      return value;
+    }
+
+    double readDouble() {
+      require(8);
+      uint64_t bits = 0;
+      for (int i = 0; i < 8; ++i) {
+        bits |= static_cast<uint64_t>(m_p[i]) << (8 * i);
+      }
+      m_p += 8;
+
+      double d;
+      memcpy(&d, &bits, sizeof(d));
+      return d;
+    }
+
+    // Read the bytes of a string with the given (already read) tag
+    std::string_view readString(uint8_t tag) {
+      if (tag != TAG_LATIN1_STRING && tag != TAG_UTF8_STRING) {
+        throw std::invalid_argument("Invalid payload string");
+      }
+
+      uint32_t length = readVarint();
+      require(length);
+      std::string_view s(reinterpret_cast<const char *>(m_p), length);
+      m_p += length;
+      return s;
+    }
+
+    size_t remaining() const {
+      return static_cast<size_t>(m_end - m_p);
+    }
+
+  private:
+    void require(size_t count) const {
+      if (static_cast<size_t>(m_end - m_p) < count) {
+        throw std::invalid_argument("Invalid payload (unexpected end)");
+      }
+    }
+
+    const uint8_t *m_p;
+    const uint8_t *m_end;
+  };
+
+  // Recursive descent parser of a JSON text (given as UTF-8 or as the modified UTF-8 of JNI) which
+  // directly writes the encoded payload
+  class JsonEncoder {
+  public:
+    JsonEncoder(std::string_view json, std::string &out)
+     : m_begin(json.data())
+     , m_p(json.data())
+     , m_end(json.data() + json.size())
+     , m_out(out) {
+    }
+
+    void encode() {
+      skipWhitespaces();
+      encodeValue(0);
+      skipWhitespaces();
+      if (m_p != m_end) {
+        fail();
+      }
+    }
+
+  private:
+    [[noreturn]] void fail() const {
+      throw std::invalid_argument("Invalid JSON at offset " + std::to_string(m_p - m_begin));
+    }
+
+    char peek() const {
+      if (m_p == m_end) {
+        fail();
+      }
+      return *m_p;
+    }
+
+    void expect(char c) {
+      if (peek() != c) {
+        fail();
+      }
+      ++m_p;
+    }
+
+    void expectLiteral(std::string_view literal) {
+      if (static_cast<size_t>(m_end - m_p) < literal.size() || std::string_view(m_p, literal.size()) != literal) {
+        fail();
+      }
+      m_p += literal.size();
+    }
+
+    void skipWhitespaces() {
+      while (m_p != m_end && (*m_p == ' ' || *m_p == '\t' || *m_p == '\n' || *m_p == '\r')) {
+        ++m_p;
+      }
+    }
+
+    void encodeValue(int depth) {
+      checkDepth(depth);
+
+      switch (peek()) {
+        case '{':
+          encodeObject(depth);
+          break;
+        case '[':
+          encodeArray(depth);
+          break;
+        case '"':
+          encodeString();
+          break;
+        case 't':
+          expectLiteral("true");
+          writeTag(m_out, TAG_TRUE);
+          break;
+        case 'f':
+          expectLiteral("false");
+          writeTag(m_out, TAG_FALSE);
+          break;
+        case 'n':
+          expectLiteral("null");
+          writeTag(m_out, TAG_NULL);
+          break;
+        default:
+          encodeNumber();
+          break;
+      }
+    }
+
+    void encodeObject(int depth) {
+      expect('{');
+      writeTag(m_out, TAG_OBJECT);
+      const size_t countOffset = m_out.size();
+      writeUint32(m_out, 0);
+
+      uint32_t count = 0;
+      skipWhitespaces();
+      if (peek() == '}') {
+        ++m_p;
+        return;
+      }
+
+      while (true) {
+        skipWhitespaces();
+        encodeString();
+        skipWhitespaces();
+        expect(':');
+        skipWhitespaces();
+        encodeValue(depth + 1);
+        ++count;
+
+        skipWhitespaces();
+        if (peek() == ',') {
+          ++m_p;
+          continue;
+        }
+        expect('}');
+        break;
+      }
+
+      patchUint32(m_out, countOffset, count);
+    }
+
+    void encodeArray(int depth) {
+      expect('[');
+      writeTag(m_out, TAG_ARRAY);
+      const size_t countOffset = m_out.size();
+      writeUint32(m_out, 0);
+
+      uint32_t count = 0;
+      skipWhitespaces();
+      if (peek() == ']') {
+        ++m_p;
+        return;
+      }
+
+      while (true) {
+        skipWhitespaces();
+        encodeValue(depth + 1);
+        ++count;
+
+        skipWhitespaces();
+        if (peek() == ',') {
+          ++m_p;
+          continue;
+        }
+        expect(']');
+        break;
+      }
+
+      patchUint32(m_out, countOffset, count);
+    }
+
+    void encodeString() {
+      expect('"');
+
+      // Fast path: strings without escape sequences are copied as they are
+      const char *start = m_p;
+      while (m_p != m_end && *m_p != '"' && *m_p != '\\') {
+        if (static_cast<uint8_t>(*m_p) < 0x20) {
+          fail();
+        }
+        ++m_p;
+      }
+
+      if (peek() == '"') {
+        std::string_view s(start, static_cast<size_t>(m_p - start));
+        ++m_p;
+        writeString(m_out, s, isAscii(s));
+        return;
+      }
+
+      m_string.assign(start, static_cast<size_t>(m_p - start));
+      while (peek() != '"') {
+        char c = *m_p++;
+        if (static_cast<uint8_t>(c) < 0x20) {
+          fail();
+        }
+        if (c != '\\') {
+          m_string += c;
+          continue;
+        }
+
+        switch (peek()) {
+          case '"': m_string += '"'; break;
+          case '\\': m_string += '\\'; break;
+          case '/': m_string += '/'; break;
+          case 'b': m_string += '\b'; break;
+          case 'f': m_string += '\f'; break;
+          case 'n': m_string += '\n'; break;
+          case 'r': m_string += '\r'; break;
+          case 't': m_string += '\t'; break;
+          case 'u': {
+            ++m_p;
+            appendUtf16Unit(readHex4());
+            continue;
+          }
+          default:
+            fail();
+        }
+        ++m_p;
+      }
+      ++m_p;
+
+      writeString(m_out, m_string, isAscii(m_string));
+    }
+
+    uint32_t readHex4() {
+      uint32_t value = 0;
+      for (int i = 0; i < 4; ++i) {
+        char c = peek();
+        ++m_p;
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= static_cast<uint32_t>(c - '0');
+        else if (c >= 'a' && c <= 'f') value |= static_cast<uint32_t>(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') value |= static_cast<uint32_t>(c - 'A' + 10);
+        else fail();
+      }
+      return value;
+    }
+
+    // Surrogates are encoded separately (as in CESU-8), which the decoder accepts
+    void appendUtf16Unit(uint32_t u) {
+      if (u < 0x80) {
+        m_string += static_cast<char>(u);
+      } else if (u < 0x800) {
+        m_string += static_cast<char>(0xC0 | (u >> 6));
+        m_string += static_cast<char>(0x80 | (u & 0x3F));
+      } else {
+        m_string += static_cast<char>(0xE0 | (u >> 12));
+        m_string += static_cast<char>(0x80 | ((u >> 6) & 0x3F));
+        m_string += static_cast<char>(0x80 | (u & 0x3F));
+      }
+    }
+
+    void encodeNumber() {
+      const char *start = m_p;
+      bool isInteger = true;
+
+      if (m_p != m_end && *m_p == '-') ++m_p;
+      if (peek() == '0') {
+        ++m_p;
+      } else if (*m_p >= '1' && *m_p <= '9') {
+        skipDigits();
+      } else {
+        fail();
+      }
+      if (m_p != m_end && *m_p == '.') {
+        ++m_p;
+        isInteger = false;
+        if (peek() < '0' || *m_p > '9') fail();
+        skipDigits();
+      }
+      if (m_p != m_end && (*m_p == 'e' || *m_p == 'E')) {
+        ++m_p;
+        isInteger = false;
+        if (peek() == '+' || *m_p == '-') ++m_p;
+        if (peek() < '0' || *m_p > '9') fail();
+        skipDigits();
+      }
+
+      const size_t length = static_cast<size_t>(m_p - start);
+      if (isInteger && length <= 10) {
+        // Small integers are directly computed (and written as varints)
+        bool negative = *start == '-';
+        int64_t value = 0;
+        for (const char *p = start + (negative ? 1 : 0); p != m_p; ++p) {
+          value = value * 10 + (*p - '0');
+        }
+        writeNumber(m_out, negative ? -static_cast<double>(value) : static_cast<double>(value));
+        return;
+      }
+
+      // The number is copied as the JSON text is not zero-terminated
+      m_string.assign(start, length);
+      writeNumber(m_out, std::strtod(m_string.c_str(), nullptr));
+    }
+
+    void skipDigits() {
+      while (m_p != m_end && *m_p >= '0' && *m_p <= '9') {
+        ++m_p;
+      }
+    }
+
+    const char *m_begin;
+    const char *m_p;
+    const char *m_end;
+    std::string &m_out;
+    std::string m_string;  // unescaped string or number being parsed
+  };
+}
+
+namespace JavaTypes {
+
+std::string Payload::encodeJson(std::string_view json) {
+  std::string out;
+  out.reserve(json.size());
+  JsonEncoder(json, out).encode();
+  return out;
+}
+
+Payload::Payload(const JsBridgeContext *jsBridgeContext, JavaTypeId id, bool isNullable)
+ : JavaType(jsBridgeContext, id)
+ , m_isNullable(isNullable) {
+}
+
+JValue Payload::decodeToJava(std::string &buffer) const {
+  // The direct buffer is only used during the (synchronous) decoding
+  JniLocalRef<jobject> byteBuffer = m_jniContext->newDirectByteBuffer(buffer.data(), static_cast<jlong>(buffer.size()));
+  JniLocalRef<jobject> javaPayload = getJniCache()->decodePayload(byteBuffer, getTypeId() == JavaTypeId::Payload);
+
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, buffer.size());
+  return JValue(javaPayload);
+}
+
+std::string_view Payload::encodeFromJava(const JniLocalRef<jobject> &payload) const {
+  JniLocalRef<jobject> byteBuffer = getJniCache()->encodePayload(payload);
+
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+
+  // The buffer memory is held by PayloadCodec until the next encoding
+  auto data = static_cast<const char *>(m_jniContext->getDirectBufferAddress(byteBuffer));
+  jlong size = m_jniContext->getDirectBufferCapacity(byteBuffer);
+  if (data == nullptr || size <= 0) {
+    throw std::invalid_argument("Could not encode payload");
+  }
+
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, static_cast<size_t>(size));
+  return std::string_view(data, static_cast<size_t>(size));
+}
+
+#if defined(DUKTAPE)
+
+namespace {
+  class Encoder {
+  public:
+    Encoder(duk_context *ctx, std::string &out)
+     : m_ctx(ctx), m_out(out) {}
+
+    // Encode the value at the given index and return false if it has been skipped
+    bool encode(duk_idx_t idx, int depth) {
+      switch (duk_get_type(m_ctx, idx)) {
+        case DUK_TYPE_NULL:
+          writeTag(m_out, TAG_NULL);
+          return true;
+        case DUK_TYPE_BOOLEAN:
+          writeTag(m_out, duk_get_boolean(m_ctx, idx) ? TAG_TRUE : TAG_FALSE);
+          return true;
+        case DUK_TYPE_NUMBER:
+          writeNumber(m_out, duk_get_number(m_ctx, idx));
+          return true;
+        case DUK_TYPE_STRING:
+          encodeString(idx);
+          return true;
+        case DUK_TYPE_OBJECT:
+          return encodeObject(idx, depth);
+        default:
+          // undefined, buffers, pointers, lightfuncs
+          return false;
+      }
+    }
+
+  private:
+    void encodeString(duk_idx_t idx) {
+      // Duktape strings are stored as UTF-8 with separately encoded surrogates which is accepted
+      // by PayloadCodec
+      duk_size_t length = 0;
+      const char *s = duk_get_lstring(m_ctx, idx, &length);
+      std::string_view view(s, length);
+      writeString(m_out, view, isAscii(view));
+    }
+
+    bool encodeObject(duk_idx_t idx, int depth) {
+      if (duk_is_function(m_ctx, idx)) {
+        return false;
+      }
+
+      checkDepth(depth);
+      idx = duk_normalize_index(m_ctx, idx);
+      duk_require_stack(m_ctx, 3);
+
+      if (duk_is_array(m_ctx, idx)) {
+        auto length = static_cast<uint32_t>(duk_get_length(m_ctx, idx));
+        writeTag(m_out, TAG_ARRAY);
+        writeUint32(m_out, length);
+
+        for (uint32_t i = 0; i < length; ++i) {
+          duk_get_prop_index(m_ctx, idx, i);
+          if (!encode(-1, depth + 1)) {
+            writeTag(m_out, TAG_NULL);
+          }
+          duk_pop(m_ctx);  // element
+        }
+        return true;
+      }
+
+      // Error instances: also include the non-enumerable properties (e.g. "message")
+      duk_uint_t enumFlags = DUK_ENUM_OWN_PROPERTIES_ONLY;
+      if (duk_is_error(m_ctx, idx)) {
+        enumFlags |= DUK_ENUM_INCLUDE_NONENUMERABLE;
+      }
+
+      writeTag(m_out, TAG_OBJECT);
+      size_t countOffset = m_out.size();
+      writeUint32(m_out, 0);
+      uint32_t count = 0;
+
+      duk_enum(m_ctx, idx, enumFlags);
+      while (duk_next(m_ctx, -1, 1 /*getValue*/)) {
+        size_t keyOffset = m_out.size();
+        encodeString(-2);
+
+        if (encode(-1, depth + 1)) {
+          ++count;
+        } else {
+          m_out.resize(keyOffset);
+        }
+        duk_pop_2(m_ctx);  // key + value
+      }
+      duk_pop(m_ctx);  // enum
+
+      patchUint32(m_out, countOffset, count);
+      return true;
+    }
+
+    duk_context *m_ctx;
+    std::string &m_out;
+  };
+
+  class Decoder {
+  public:
+    Decoder(duk_context *ctx, std::string_view buffer)
+     : m_ctx(ctx), m_reader(buffer) {}
+
+    // Decode the next value and push it
+    void decode(int depth) {
+      duk_require_stack(m_ctx, 3);
+
+      uint8_t tag = m_reader.readByte();
+      switch (tag) {
+        case TAG_NULL:
+          duk_push_null(m_ctx);
+          break;
+        case TAG_FALSE:
+        case TAG_TRUE:
+          duk_push_boolean(m_ctx, tag == TAG_TRUE);
+          break;
+        case TAG_INT:
+          duk_push_int(m_ctx, m_reader.readInt());
+          break;
+        case TAG_DOUBLE:
+          duk_push_number(m_ctx, m_reader.readDouble());
+          break;
+        case TAG_LATIN1_STRING:
+        case TAG_UTF8_STRING:
+          pushString(tag);
+          break;
+        case TAG_ARRAY: {
+          checkDepth(depth);
+          uint32_t count = m_reader.readUint32();
+          duk_push_array(m_ctx);
+          for (uint32_t i = 0; i < count; ++i) {
+            decode(depth + 1);
+            duk_put_prop_index(m_ctx, -2, i);
+          }
+          break;
+        }
+        case TAG_OBJECT: {
+          checkDepth(depth);
+          uint32_t count = m_reader.readUint32();
+          duk_push_object(m_ctx);
+          for (uint32_t i = 0; i < count; ++i) {
+            pushString(m_reader.readByte());
+            decode(depth + 1);
+            duk_put_prop(m_ctx, -3);
+          }
+          break;
+        }
+        case TAG_SHAPED_OBJECT: {
+          checkDepth(depth);
+          const std::vector<std::string> &keys = readShape();
+          duk_push_object(m_ctx);
+          for (const std::string &key : keys) {
+            decode(depth + 1);
+            duk_put_prop_lstring(m_ctx, -2, key.data(), key.size());
+          }
+          break;
+        }
+        default:
+          throw std::invalid_argument("Invalid payload tag " + std::to_string(tag));
+      }
+    }
+
+  private:
+    void pushString(uint8_t tag) {
+      std::string_view s = m_reader.readString(tag);
+      if (tag == TAG_LATIN1_STRING && !isAscii(s)) {
+        std::string utf8 = latin1ToUtf8(s);
+        duk_push_lstring(m_ctx, utf8.data(), utf8.size());
+      } else {
+        duk_push_lstring(m_ctx, s.data(), s.size());
+      }
+    }
+
+    // Read the shape index of a shaped object (and the shape keys when it is used for the first time)
+    const std::vector<std::string> &readShape() {
+      uint32_t shapeIndex = m_reader.readVarint();
+      if (shapeIndex < m_shapes.size()) {
+        return m_shapes[shapeIndex];
+      }
+      if (shapeIndex != m_shapes.size()) {
+        throw std::invalid_argument("Invalid payload shape " + std::to_string(shapeIndex));
+      }
+
+      uint32_t count = m_reader.readUint32();
+      std::vector<std::string> keys;
+      for (uint32_t i = 0; i < count; ++i) {
+        uint8_t tag = m_reader.readByte();
+        std::string_view s = m_reader.readString(tag);
+        keys.emplace_back(tag == TAG_LATIN1_STRING && !isAscii(s) ? latin1ToUtf8(s) : std::string(s));
+      }
+      m_shapes.emplace_back(std::move(keys));
+      return m_shapes.back();
+    }
+
+    duk_context *m_ctx;
+    Reader m_reader;
+    std::vector<std::vector<std::string>> m_shapes;  // property keys of the shaped objects
+  };
+}
+
+JValue Payload::pop() const {
+  CHECK_STACK_OFFSET(m_ctx, -1);
+
+  if (m_isNullable && duk_is_null_or_undefined(m_ctx, -1)) {
+    JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
+    duk_pop(m_ctx);
+    return JValue();
+  }
+
+  if ((getTypeId() == JavaTypeId::PayloadObject && (!duk_is_object(m_ctx, -1) || duk_is_array(m_ctx, -1) || duk_is_function(m_ctx, -1)))
+      || (getTypeId() == JavaTypeId::PayloadArray && !duk_is_array(m_ctx, -1))) {
+    const auto message = std::string("Cannot convert ") + duk_safe_to_string(m_ctx, -1) + " to " +
+                         (getTypeId() == JavaTypeId::PayloadObject ? "PayloadObject" : "PayloadArray");
+    duk_pop(m_ctx);
+    throw std::invalid_argument(message);
+  }
+
+  std::string buffer;
+  duk_idx_t top = duk_get_top(m_ctx);
+  try {
+    if (!Encoder(m_ctx, buffer).encode(-1, 0)) {
+      writeTag(buffer, TAG_NULL);
+    }
+  } catch (...) {
+    duk_set_top(m_ctx, top);
+    duk_pop(m_ctx);
+    throw;
+  }
+  duk_pop(m_ctx);
+
+  return decodeToJava(buffer);
+}
+
+duk_ret_t Payload::push(const JValue &value) const {
+  CHECK_STACK_OFFSET(m_ctx, 1);
+
+  const JniLocalRef<jobject> &jPayload = value.getLocalRef();
+  if (jPayload.isNull()) {
+    JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
+    duk_push_null(m_ctx);
+    return 1;
+  }
+
+  std::string_view buffer = encodeFromJava(jPayload);
+
+  duk_idx_t top = duk_get_top(m_ctx);
+  try {
+    Decoder(m_ctx, buffer).decode(0);
+  } catch (...) {
+    duk_set_top(m_ctx, top);
+    throw;
+  }
+
+  return 1;
+}
+
+#elif defined(QUICKJS)
+
+namespace {
+  class Encoder {
+  public:
+    Encoder(JSContext *ctx, const QuickJsUtils *utils, const ExceptionHandler *exceptionHandler, std::string &out)
+     : m_ctx(ctx), m_utils(utils), m_exceptionHandler(exceptionHandler), m_out(out) {}
+
+    // Encode the given value and return false if it has been skipped
+    bool encode(JSValueConst v, int depth) {
+      switch (JS_VALUE_GET_NORM_TAG(v)) {
+        case JS_TAG_NULL:
+          writeTag(m_out, TAG_NULL);
+          return true;
+        case JS_TAG_BOOL:
+          writeTag(m_out, JS_VALUE_GET_BOOL(v) ? TAG_TRUE : TAG_FALSE);
+          return true;
+        case JS_TAG_INT:
+          writeNumber(m_out, JS_VALUE_GET_INT(v));
+          return true;
+        case JS_TAG_FLOAT64:
+          writeNumber(m_out, JS_VALUE_GET_FLOAT64(v));
+          return true;
+        case JS_TAG_STRING:
+          encodeString(v);
+          return true;
+        case JS_TAG_OBJECT:
+          return encodeObject(v, depth);
+        default:
+          // undefined, symbols, big ints
+          return false;
+      }
+    }
+
+  private:
+    void encodeString(JSValueConst v) {
+      size_t length = 0;
+      JS_BOOL isWideChar = false;
+      const void *chars = JS_GetStringChars(m_ctx, v, &length, &isWideChar);
+      if (chars == nullptr) {
+        throw std::invalid_argument("Cannot encode string");
+      }
+
+      // 8-bit strings are directly written as Latin-1
+      if (!isWideChar) {
+        writeString(m_out, std::string_view(static_cast<const char *>(chars), length), true);
+        return;
+      }
+
+      // UTF-16 -> UTF-8 with separately encoded surrogates (like CESU-8)
+      auto utf16 = static_cast<const uint16_t *>(chars);
+      size_t byteLength = 0;
+      for (size_t i = 0; i < length; ++i) {
+        byteLength += utf16[i] < 0x80 ? 1 : (utf16[i] < 0x800 ? 2 : 3);
+      }
+
+      writeTag(m_out, TAG_UTF8_STRING);
+      writeVarint(m_out, static_cast<uint32_t>(byteLength));
+      m_out.reserve(m_out.size() + byteLength);
+      for (size_t i = 0; i < length; ++i) {
+        uint16_t c = utf16[i];
+        if (c < 0x80) {
+          m_out += static_cast<char>(c);
+        } else if (c < 0x800) {
+          m_out += static_cast<char>(0xC0 | (c >> 6));
+          m_out += static_cast<char>(0x80 | (c & 0x3F));
+        } else {
+          m_out += static_cast<char>(0xE0 | (c >> 12));
+          m_out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+          m_out += static_cast<char>(0x80 | (c & 0x3F));
+        }
+      }
+    }
+
+    bool encodeObject(JSValueConst v, int depth) {
+      if (JS_IsFunction(m_ctx, v)) {
+        return false;
+      }
+
+      checkDepth(depth);
+
+      if (JS_IsArray(m_ctx, v)) {
+        JSValue lengthValue = m_utils->getProperty(v, QuickJsUtils::PropertyName::Length);
+        uint32_t length = 0;
+        JS_ToUint32(m_ctx, &length, lengthValue);
+        JS_FreeValue(m_ctx, lengthValue);
+
+        writeTag(m_out, TAG_ARRAY);
+        writeUint32(m_out, length);
+
+        for (uint32_t i = 0; i < length; ++i) {
+          JSValue elementValue = JS_GetPropertyUint32(m_ctx, v, i);
+          if (JS_IsException(elementValue)) {
+            throw m_exceptionHandler->getCurrentJsException();
+          }
+          JS_AUTORELEASE_VALUE(m_ctx, elementValue);
+
+          if (!encode(elementValue, depth + 1)) {
+            writeTag(m_out, TAG_NULL);
+          }
+        }
+        return true;
+      }
+
+      // Error instances: also include the non-enumerable properties (e.g. "message")
+      int flags = JS_GPN_STRING_MASK;
+      if (!JS_IsError(m_ctx, v)) {
+        flags |= JS_GPN_ENUM_ONLY;
+      }
+
+      JSPropertyEnum *properties = nullptr;
+      uint32_t propertyCount = 0;
+      if (JS_GetOwnPropertyNames(m_ctx, &properties, &propertyCount, v, flags) < 0) {
+        throw m_exceptionHandler->getCurrentJsException();
+      }
+
+      writeTag(m_out, TAG_OBJECT);
+      size_t countOffset = m_out.size();
+      writeUint32(m_out, 0);
+      uint32_t count = 0;
+
+      try {
+        for (uint32_t i = 0; i < propertyCount; ++i) {
+          JSValue propertyValue = JS_GetProperty(m_ctx, v, properties[i].atom);
+          if (JS_IsException(propertyValue)) {
+            throw m_exceptionHandler->getCurrentJsException();
+          }
+          JS_AUTORELEASE_VALUE(m_ctx, propertyValue);
+
+          JSValue keyValue = JS_AtomToString(m_ctx, properties[i].atom);
+          JS_AUTORELEASE_VALUE(m_ctx, keyValue);
+
+          size_t keyOffset = m_out.size();
+          encodeString(keyValue);
+
+          if (encode(propertyValue, depth + 1)) {
+            ++count;
+          } else {
+            m_out.resize(keyOffset);
+          }
+        }
+      } catch (...) {
+        freeProperties(properties, propertyCount);
+        throw;
+      }
+
+      freeProperties(properties, propertyCount);
+      patchUint32(m_out, countOffset, count);
+      return true;
+    }
+
+    void freeProperties(JSPropertyEnum *properties, uint32_t propertyCount) {
+      for (uint32_t i = 0; i < propertyCount; ++i) {
+        JS_FreeAtom(m_ctx, properties[i].atom);
+      }
+      js_free(m_ctx, properties);
+    }
+
+    JSContext *m_ctx;
+    const QuickJsUtils *m_utils;
+    const ExceptionHandler *m_exceptionHandler;
+    std::string &m_out;
+  };
+
+  class Decoder {
+  public:
+    Decoder(JSContext *ctx, const ExceptionHandler *exceptionHandler, std::string_view buffer)
+     : m_ctx(ctx), m_exceptionHandler(exceptionHandler), m_reader(buffer) {}
+
+    Decoder(const Decoder &) = delete;
+    Decoder &operator = (const Decoder &) = delete;
+
+    ~Decoder() {
+      for (const auto &atoms : m_shapes) {
+        for (JSAtom atom : atoms) {
+          JS_FreeAtom(m_ctx, atom);
+        }
+      }
+    }
+
+    JSValue decode(int depth) {
+      uint8_t tag = m_reader.readByte();
+      switch (tag) {
+        case TAG_NULL:
+          return JS_NULL;
+        case TAG_FALSE:
+        case TAG_TRUE:
+          return JS_NewBool(m_ctx, tag == TAG_TRUE);
+        case TAG_INT:
+          return JS_NewInt32(m_ctx, m_reader.readInt());
+        case TAG_DOUBLE:
+          return JS_NewFloat64(m_ctx, m_reader.readDouble());
+        case TAG_LATIN1_STRING:
+        case TAG_UTF8_STRING:
+          return checkValue(newString(tag));
+        case TAG_ARRAY: {
+          checkDepth(depth);
+          uint32_t count = m_reader.readUint32();
+          if (count > m_reader.remaining()) {
+            // (each element takes at least one byte)
+            throw std::invalid_argument("Invalid payload (unexpected end)");
+          }
+
+          // Decode all the elements first so that the JS array is allocated at once
+          std::vector<JSValue> elementValues;
+          elementValues.reserve(count);
+          try {
+            for (uint32_t i = 0; i < count; ++i) {
+              elementValues.push_back(decode(depth + 1));
+            }
+          } catch (...) {
+            for (JSValue elementValue : elementValues) {
+              JS_FreeValue(m_ctx, elementValue);
+            }
+            throw;
+          }
+          return checkValue(JS_NewArrayFrom(m_ctx, count, elementValues.data()));
+        }
+        case TAG_OBJECT: {
+          checkDepth(depth);
+          uint32_t count = m_reader.readUint32();
+          JSValue objectValue = checkValue(JS_NewObject(m_ctx));
+          try {
+            for (uint32_t i = 0; i < count; ++i) {
+              JSAtom atom = newAtom(m_reader.readByte());
+              JSValue propertyValue;
+              try {
+                propertyValue = decode(depth + 1);
+              } catch (...) {
+                JS_FreeAtom(m_ctx, atom);
+                throw;
+              }
+              JS_DefinePropertyValue(m_ctx, objectValue, atom, propertyValue, JS_PROP_C_W_E);
+              JS_FreeAtom(m_ctx, atom);
+            }
+          } catch (...) {
+            JS_FreeValue(m_ctx, objectValue);
+            throw;
+          }
+          return objectValue;
+        }
+        case TAG_SHAPED_OBJECT: {
+          // All the objects of a shape get the same atoms in the same order and then share their
+          // QuickJS shape
+          checkDepth(depth);
+          const std::vector<JSAtom> &atoms = readShape();
+          JSValue objectValue = checkValue(JS_NewObject(m_ctx));
+          try {
+            for (JSAtom atom : atoms) {
+              JS_DefinePropertyValue(m_ctx, objectValue, atom, decode(depth + 1), JS_PROP_C_W_E);
+            }
+          } catch (...) {
+            JS_FreeValue(m_ctx, objectValue);
+            throw;
+          }
+          return objectValue;
+        }
+        default:
+          throw std::invalid_argument("Invalid payload tag " + std::to_string(tag));
+      }
+    }
+
+  private:
+    // Read the shape index of a shaped object (and the shape keys when it is used for the first time)
+    const std::vector<JSAtom> &readShape() {
+      uint32_t shapeIndex = m_reader.readVarint();
+      if (shapeIndex < m_shapes.size()) {
+        return m_shapes[shapeIndex];
+      }
+      if (shapeIndex != m_shapes.size()) {
+        throw std::invalid_argument("Invalid payload shape " + std::to_string(shapeIndex));
+      }
+
+      uint32_t count = m_reader.readUint32();
+      std::vector<JSAtom> &atoms = m_shapes.emplace_back();
+      for (uint32_t i = 0; i < count; ++i) {
+        atoms.push_back(newAtom(m_reader.readByte()));
+      }
+      return atoms;
+    }
+
+    JSValue checkValue(JSValue v) const {
+      if (JS_IsException(v)) {
+        throw m_exceptionHandler->getCurrentJsException();
+      }
+      return v;
+    }
+
+    JSValue newString(uint8_t tag) {
+      std::string_view s = m_reader.readString(tag);
+      if (tag == TAG_LATIN1_STRING && !isAscii(s)) {
+        // Creates an 8-bit string
+        std::u16string latin1(s.size(), u'\0');
+        for (size_t i = 0; i < s.size(); ++i) {
+          latin1[i] = static_cast<uint8_t>(s[i]);
+        }
+        return JS_NewStringUTF16(m_ctx, reinterpret_cast<const uint16_t *>(latin1.data()), latin1.size());
+      }
+      return JS_NewStringLen(m_ctx, s.data(), s.size());
+    }
+
+    JSAtom newAtom(uint8_t tag) {
+      std::string_view s = m_reader.readString(tag);
+      JSAtom atom;
+      if (tag == TAG_LATIN1_STRING && !isAscii(s)) {
+        std::string utf8 = latin1ToUtf8(s);
+        atom = JS_NewAtomLen(m_ctx, utf8.data(), utf8.size());
+      } else {
+        atom = JS_NewAtomLen(m_ctx, s.data(), s.size());
+      }
+
+      if (atom == JS_ATOM_NULL) {
+        throw m_exceptionHandler->getCurrentJsException();
+      }
+      return atom;
+    }
+
+    JSContext *m_ctx;
+    const ExceptionHandler *m_exceptionHandler;
+    Reader m_reader;
+    std::vector<std::vector<JSAtom>> m_shapes;  // property keys of the shaped objects
+  };
+}
+
+JValue Payload::toJava(JSValueConst v) const {
+  if (m_isNullable && (JS_IsNull(v) || JS_IsUndefined(v))) {
+    JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
+    return JValue();
+  }
+
+  if (getTypeId() == JavaTypeId::PayloadObject && (!JS_IsObject(v) || JS_IsArray(m_ctx, v) || JS_IsFunction(m_ctx, v))) {
+    throw std::invalid_argument("Cannot convert value to PayloadObject");
+  }
+  if (getTypeId() == JavaTypeId::PayloadArray && !JS_IsArray(m_ctx, v)) {
+    throw std::invalid_argument("Cannot convert value to PayloadArray");
+  }
+
+  std::string buffer;
+  if (!Encoder(m_ctx, getUtils(), getExceptionHandler(), buffer).encode(v, 0)) {
+    writeTag(buffer, TAG_NULL);
+  }
+
+  return decodeToJava(buffer);
+}
+
+JSValue Payload::fromJava(const JValue &value) const {
+  const JniLocalRef<jobject> &jPayload = value.getLocalRef();
+  if (jPayload.isNull()) {
+    JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
+    return JS_NULL;
+  }
+
+  std::string_view buffer = encodeFromJava(jPayload);
+  return Decoder(m_ctx, getExceptionHandler(), buffer).decode(0);
+}
+
+#endif
+
+}  // namespace JavaTypes
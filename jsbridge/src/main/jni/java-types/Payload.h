@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JAVATYPES_PAYLOAD_H
+#define _JSBRIDGE_JAVATYPES_PAYLOAD_H
+
+#include "JavaType.h"
+#include <string>
+#include <string_view>
+
+namespace JavaTypes {
+
+// Payload, PayloadObject and PayloadArray values which are transferred in a compact binary format
+// (see PayloadCodec.kt) instead of JSON:
+// - JS -> Java: the JS value is walked and encoded into a native buffer which is directly decoded
+//   by Kotlin (via a direct ByteBuffer)
+// - Java -> JS: Kotlin encodes the value into a direct ByteBuffer which is decoded into JS values
+//
+// Note: like with JSON, undefined values, functions and symbols are skipped in objects and
+// replaced by null in arrays. Error instances are encoded with all their own properties.
+// Unlike JSON.stringify(), toJSON() methods are not called.
+class Payload : public JavaType {
+
+public:
+  // id: JavaTypeId::Payload, JavaTypeId::PayloadObject, JavaTypeId::PayloadArray or (for the
+  // Serializable subclass) JavaTypeId::Serializable
+  Payload(const JsBridgeContext *, JavaTypeId id, bool isNullable);
+
+  // Parse the given JSON text (UTF-8) into an encoded payload (see PayloadCodec.kt), e.g. to
+  // decode a large JSON result outside of the JS thread. Throws std::invalid_argument if the JSON
+  // is invalid. Not bound to any JS context.
+  static std::string encodeJson(std::string_view json);
+
+#if defined(DUKTAPE)
+  JValue pop() const override;
+  duk_ret_t push(const JValue &value) const override;
+#elif defined(QUICKJS)
+  JValue toJava(JSValueConst) const override;
+  JSValue fromJava(const JValue &value) const override;
+#endif
+
+protected:
+  // Decode the given encoded value into a Java Payload
+  virtual JValue decodeToJava(std::string &buffer) const;
+
+  // Return the encoded value of the given Java Payload (valid until the next call)
+  virtual std::string_view encodeFromJava(const JniLocalRef<jobject> &payload) const;
+
+private:
+  bool m_isNullable;
+};
+
+}  // namespace JavaTypes
+
+#endif
@@ -32,6 +32,8 @@ public:
   JavaTypeId boxedId() const { return m_boxedId; }
   virtual JavaTypeId arrayId() const = 0;
 
+  bool isPrimitive() const override { return true; }
+
 protected:
   Primitive(const JsBridgeContext *, JavaTypeId primitiveId, JavaTypeId boxedId);
 
@@ -0,0 +1,447 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "PrimitiveType.h"
+
+#include "Boolean.h"
+#include "Byte.h"
+#include "Double.h"
+#include "Float.h"
+#include "Integer.h"
+#include "Long.h"
+#include "Short.h"
+#include "ExceptionHandler.h"
+#include "JsBridgeContext.h"
+#include "exceptions/JniException.h"
+#include "jni-helpers/JArrayLocalRef.h"
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#if defined(DUKTAPE)
+# include "DuktapeUtils.h"
+# include "StackChecker.h"
+#elif defined(QUICKJS)
+# include "FastArrayConversion.h"
+# include "QuickJsUtils.h"
+# include "exceptions/JsException.h"
+#endif
+
+namespace {
+  // Read the data of a typed array matching the given Traits (or nullptr if there is none)
+#if defined(DUKTAPE)
+  template <typename Traits>
+  const void *getTypedArrayData(const DuktapeUtils *utils, duk_size_t *pByteLength) {
+    if constexpr (Traits::TYPED_ARRAY_NAME == nullptr) {
+      return nullptr;
+    } else {
+      const void *typedArrayData = utils->getTypedArrayData(-1, Traits::TYPED_ARRAY_NAME, pByteLength);
+      if constexpr (Traits::ALT_TYPED_ARRAY_NAME != nullptr) {
+        if (typedArrayData == nullptr) {
+          typedArrayData = utils->getTypedArrayData(-1, Traits::ALT_TYPED_ARRAY_NAME, pByteLength);
+        }
+      }
+      return typedArrayData;
+    }
+  }
+#elif defined(QUICKJS)
+  template <typename Traits>
+  const void *getTypedArrayData(const QuickJsUtils *utils, JSValueConst v, size_t *pByteLength) {
+    if constexpr (Traits::TYPED_ARRAY_NAME == nullptr) {
+      return nullptr;
+    } else {
+      const void *typedArrayData = utils->getTypedArrayData(v, Traits::TYPED_ARRAY_NAME, pByteLength);
+      if constexpr (Traits::ALT_TYPED_ARRAY_NAME != nullptr) {
+        if (typedArrayData == nullptr) {
+          typedArrayData = utils->getTypedArrayData(v, Traits::ALT_TYPED_ARRAY_NAME, pByteLength);
+        }
+      }
+      return typedArrayData;
+    }
+  }
+#endif
+
+  // Bulk copy of typed array data into a new Java array (a single region copy if the typed array
+  // elements have the JNI type); returns a null ref if the Java array could not be created
+  template <typename Traits>
+  JArrayLocalRef<typename Traits::JniType> newJavaArray(const JniContext *jniContext, const void *typedArrayData, size_t byteLength) {
+    using JniType = typename Traits::JniType;
+    using TypedArrayElement = typename Traits::TypedArrayElement;
+
+    const auto count = static_cast<jsize>(byteLength / sizeof(TypedArrayElement));
+    JArrayLocalRef<JniType> javaArray(jniContext, count);
+    if (javaArray.isNull()) {
+      return javaArray;
+    }
+
+    if constexpr (std::is_same<JniType, TypedArrayElement>::value) {
+      javaArray.setRegion(0, count, static_cast<const JniType *>(typedArrayData));
+    } else {
+      JniType *elements = javaArray.getMutableElements();
+      if (elements == nullptr) {
+        return JArrayLocalRef<JniType>(JniLocalRef<jarray>());
+      }
+
+      const auto typedArrayElements = static_cast<const TypedArrayElement *>(typedArrayData);
+      for (jsize i = 0; i < count; ++i) {
+        elements[i] = static_cast<JniType>(typedArrayElements[i]);
+      }
+      javaArray.releaseArrayElements();  // copy back elements to Java
+    }
+
+    return javaArray;
+  }
+
+  // Bulk copy of a Java array into the given typed array data (a single region copy if the
+  // typed array elements have the JNI type); returns false if the Java elements could not be read
+  template <typename Traits>
+  bool copyToTypedArray(JArrayLocalRef<typename Traits::JniType> &javaArray, jsize count, void *typedArrayData) {
+    using JniType = typename Traits::JniType;
+    using TypedArrayElement = typename Traits::TypedArrayElement;
+
+    if constexpr (std::is_same<JniType, TypedArrayElement>::value) {
+      javaArray.getRegion(0, count, static_cast<JniType *>(typedArrayData));
+    } else {
+      const JniType *elements = javaArray.getElements();
+      if (elements == nullptr) {
+        return false;
+      }
+
+      auto typedArrayElements = static_cast<TypedArrayElement *>(typedArrayData);
+      for (jsize i = 0; i < count; ++i) {
+        typedArrayElements[i] = static_cast<TypedArrayElement>(elements[i]);
+      }
+    }
+
+    return true;
+  }
+}
+
+namespace JavaTypes {
+
+template <typename Traits>
+PrimitiveType<Traits>::PrimitiveType(const JsBridgeContext *jsBridgeContext)
+ : Primitive(jsBridgeContext, Traits::ID, Traits::BOXED_ID) {
+}
+
+#if defined(DUKTAPE)
+
+template <typename Traits>
+JValue PrimitiveType<Traits>::pop() const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
+  CHECK_STACK_OFFSET(m_ctx, -1);
+
+  if (!Traits::isJsValue(m_ctx, -1)) {
+    const auto message = std::string("Cannot convert return value ") + duk_safe_to_string(m_ctx, -1) + " to " + Traits::JAVA_NAME;
+    duk_pop(m_ctx);
+    throw std::invalid_argument(message);
+  }
+
+  JniType value = Traits::getJsValue(m_ctx, -1);
+  duk_pop(m_ctx);
+  return JValue(value);
+}
+
+template <typename Traits>
+JValue PrimitiveType<Traits>::popArray(uint32_t count, bool expanded) const {
+  if (!expanded) {
+    // Bulk copy from a typed array
+    duk_size_t byteLength = 0;
+    const void *typedArrayData = getTypedArrayData<Traits>(getUtils(), &byteLength);
+    if (typedArrayData != nullptr) {
+      JArrayLocalRef<JniType> javaArray = newJavaArray<Traits>(m_jniContext, typedArrayData, byteLength);
+      duk_pop(m_ctx);  // pop the typed array
+      if (javaArray.isNull()) {
+        throw JniException(m_jniContext);
+      }
+      return JValue(javaArray);
+    }
+
+    count = static_cast<uint32_t>(duk_get_length(m_ctx, -1));
+    if (!duk_is_array(m_ctx, -1)) {
+      const auto message = std::string("Cannot convert JS value ") + duk_safe_to_string(m_ctx, -1) + " to Array<" + Traits::BOXED_JAVA_NAME + ">";
+      duk_pop(m_ctx);  // pop the array
+      throw std::invalid_argument(message);
+    }
+  }
+
+  JArrayLocalRef<JniType> javaArray(m_jniContext, count);
+  JniType *elements = javaArray.isNull() ? nullptr : javaArray.getMutableElements();
+  if (elements == nullptr) {
+    duk_pop_n(m_ctx, expanded ? count : 1);  // pop the expanded elements or the array
+    throw JniException(m_jniContext);
+  }
+
+  for (int i = count - 1; i >= 0; --i) {
+    if (!expanded) {
+      duk_get_prop_index(m_ctx, -1, static_cast<duk_uarridx_t>(i));
+    }
+    try {
+      JValue value = pop();
+      elements[i] = Traits::get(value);
+    } catch (const std::exception &) {
+      if (!expanded) {
+        duk_pop(m_ctx);  // pop the array
+      }
+      throw;
+    }
+  }
+
+  if (!expanded) {
+    duk_pop(m_ctx);  // pop the array
+  }
+
+  return JValue(javaArray);
+}
+
+template <typename Traits>
+duk_ret_t PrimitiveType<Traits>::push(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
+  Traits::pushJsValue(m_ctx, Traits::get(value));
+  return 1;
+}
+
+template <typename Traits>
+duk_ret_t PrimitiveType<Traits>::pushArray(const JniLocalRef<jarray> &values, bool expand) const {
+  JArrayLocalRef<JniType> javaArray(values);
+  const auto count = javaArray.getLength();
+
+  if constexpr (Traits::TYPED_ARRAY_NAME != nullptr) {
+    if (!expand && m_jsBridgeContext->areTypedArraysEnabled()) {
+      CHECK_STACK_OFFSET(m_ctx, 1);
+
+      // Single bulk copy into a new typed array
+      using TypedArrayElement = typename Traits::TypedArrayElement;
+      void *typedArrayData = getUtils()->pushTypedArray(Traits::DUK_TYPED_ARRAY_TYPE, count * sizeof(TypedArrayElement));
+      if (!copyToTypedArray<Traits>(javaArray, count, typedArrayData)) {
+        duk_pop(m_ctx);  // typed array
+        throw JniException(m_jniContext);
+      }
+      return 1;
+    }
+  }
+
+  const JniType *elements = javaArray.getElements();
+  if (elements == nullptr) {
+    throw JniException(m_jniContext);
+  }
+
+  CHECK_STACK_OFFSET(m_ctx, expand ? count : 1);
+
+  if (!expand) {
+    duk_push_array(m_ctx);
+  }
+
+  for (jsize i = 0; i < count; ++i) {
+    Traits::pushJsValue(m_ctx, elements[i]);
+    if (!expand) {
+      duk_put_prop_index(m_ctx, -2, static_cast<duk_uarridx_t>(i));
+    }
+  }
+
+  return expand ? count : 1;
+}
+
+#elif defined(QUICKJS)
+
+template <typename Traits>
+JValue PrimitiveType<Traits>::toJava(JSValueConst v) const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
+  return JValue(Traits::getJsValue(v, Traits::JAVA_NAME));
+}
+
+template <typename Traits>
+JValue PrimitiveType<Traits>::toJavaArray(JSValueConst v) const {
+  if (JS_IsNull(v) || JS_IsUndefined(v)) {
+    return JValue();
+  }
+
+  // Bulk copy from a typed array
+  size_t byteLength = 0;
+  const void *typedArrayData = getTypedArrayData<Traits>(getUtils(), v, &byteLength);
+  if (typedArrayData != nullptr) {
+    JArrayLocalRef<JniType> javaArray = newJavaArray<Traits>(m_jniContext, typedArrayData, byteLength);
+    if (javaArray.isNull()) {
+      throw JniException(m_jniContext);
+    }
+    return JValue(javaArray);
+  }
+
+  if (!JS_IsArray(m_ctx, v)) {
+    throw std::invalid_argument("Cannot convert JS value to Java array");
+  }
+
+  JSValue lengthValue = getUtils()->getProperty(v, QuickJsUtils::PropertyName::Length);
+  assert(JS_IsNumber(lengthValue));
+  uint32_t count = JS_VALUE_GET_INT(lengthValue);
+  JS_FreeValue(m_ctx, lengthValue);
+
+  JArrayLocalRef<JniType> javaArray(m_jniContext, count);
+  if (javaArray.isNull()) {
+    throw JniException(m_jniContext);
+  }
+
+  JniType *elements = javaArray.getMutableElements();
+  if (elements == nullptr) {
+    throw JniException(m_jniContext);
+  }
+
+  // Read the contiguous storage of fast arrays directly (converting the elements runs no JS code
+  // so the array cannot be modified meanwhile) and fall back to property access otherwise
+  JSValue *fastArrayValues = nullptr;
+  uint32_t fastArrayCount = 0;
+  if (!JS_GetFastArray(m_ctx, v, &fastArrayValues, &fastArrayCount)) {
+    fastArrayCount = 0;
+  }
+
+  // Bulk conversion of the leading numbers of the fast array storage
+  uint32_t i = convertFastArray(fastArrayValues, std::min(count, fastArrayCount), elements);
+
+  for (; i < count; ++i) {
+    JSValue ev = i < fastArrayCount ? fastArrayValues[i] : JS_GetPropertyUint32(m_ctx, v, i);
+    elements[i] = Traits::getJsValue(ev, Traits::JAVA_NAME);
+  }
+
+  javaArray.releaseArrayElements();  // copy back elements to Java
+  return JValue(javaArray);
+}
+
+template <typename Traits>
+JValue PrimitiveType<Traits>::toJavaArray(uint32_t count, JSValueConst *values) const {
+  JArrayLocalRef<JniType> javaArray(m_jniContext, count);
+  if (javaArray.isNull()) {
+    throw JniException(m_jniContext);
+  }
+
+  JniType *elements = javaArray.getMutableElements();
+  if (elements == nullptr) {
+    throw JniException(m_jniContext);
+  }
+
+  uint32_t i = convertFastArray(values, count, elements);
+
+  for (; i < count; ++i) {
+    elements[i] = Traits::getJsValue(values[i], Traits::JAVA_NAME);
+  }
+
+  javaArray.releaseArrayElements();  // copy back elements to Java
+  return JValue(javaArray);
+}
+
+template <typename Traits>
+JSValue PrimitiveType<Traits>::fromJava(const JValue &value) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
+  return Traits::newJsValue(m_ctx, Traits::get(value));
+}
+
+template <typename Traits>
+JSValue PrimitiveType<Traits>::fromJavaArray(const JniLocalRef<jarray> &values) const {
+  JArrayLocalRef<JniType> javaArray(values);
+  const auto count = javaArray.getLength();
+
+  if constexpr (Traits::TYPED_ARRAY_NAME != nullptr) {
+    if (m_jsBridgeContext->areTypedArraysEnabled()) {
+      // Single bulk copy into a new typed array
+      using TypedArrayElement = typename Traits::TypedArrayElement;
+      void *typedArrayData = nullptr;
+      JSValue typedArray = getUtils()->newTypedArray(Traits::TYPED_ARRAY_NAME, count * sizeof(TypedArrayElement), &typedArrayData);
+      if (JS_IsException(typedArray)) {
+        throw getExceptionHandler()->getCurrentJsException();
+      }
+
+      if (!copyToTypedArray<Traits>(javaArray, count, typedArrayData)) {
+        JS_FreeValue(m_ctx, typedArray);
+        throw JniException(m_jniContext);
+      }
+      return typedArray;
+    }
+  }
+
+  std::vector<JSValue> elementValues(static_cast<size_t>(count));
+  fromJavaArray(values, static_cast<uint32_t>(count), elementValues.data());
+
+  // Allocated at once
+  JSValue jsArray = JS_NewArrayFrom(m_ctx, static_cast<uint32_t>(count), elementValues.data());
+  if (JS_IsException(jsArray)) {
+    throw getExceptionHandler()->getCurrentJsException();
+  }
+  return jsArray;
+}
+
+template <typename Traits>
+void PrimitiveType<Traits>::fromJavaArray(const JniLocalRef<jarray> &values, uint32_t count, JSValue *jsValues) const {
+  JArrayLocalRef<JniType> javaArray(values);
+
+  const JniType *elements = javaArray.getElements();
+  if (elements == nullptr) {
+    throw JniException(m_jniContext);
+  }
+
+  // (primitive values: nothing to free in case of exception)
+  for (uint32_t i = 0; i < count; ++i) {
+    jsValues[i] = Traits::newJsValue(m_ctx, elements[i]);
+  }
+}
+
+#endif
+
+template <typename Traits>
+JValue PrimitiveType<Traits>::callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
+                                         const JValueArgs &args) const {
+  JniType returnValue = Traits::callMethodA(m_jniContext, javaThis, methodId, args);
+
+  // Explicitly release all values now because they won't be used afterwards
+  args.releaseAll();
+
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+
+  return JValue(returnValue);
+}
+
+template <typename Traits>
+JsToJavaConversion PrimitiveType<Traits>::getJsToJavaConversion() const {
+  return directJsToJavaConversion(this);
+}
+
+template <typename Traits>
+JavaToJsConversion PrimitiveType<Traits>::getJavaToJsConversion() const {
+  return directJavaToJsConversion(this);
+}
+
+template <typename Traits>
+JValue PrimitiveType<Traits>::box(const JValue &value) const {
+  // From primitive to boxed value
+  static thread_local jmethodID boxId = m_jniContext->getStaticMethodID(getBoxedJavaClass(), "valueOf", Traits::BOX_SIGNATURE);
+  return JValue(m_jniContext->callStaticObjectMethod(getBoxedJavaClass(), boxId, Traits::get(value)));
+}
+
+template <typename Traits>
+JValue PrimitiveType<Traits>::unbox(const JValue &boxedValue) const {
+  // From boxed value to primitive
+  static thread_local jmethodID unboxId = m_jniContext->getMethodID(getBoxedJavaClass(), Traits::UNBOX_METHOD_NAME, Traits::UNBOX_SIGNATURE);
+  return JValue(Traits::callMethod(m_jniContext, boxedValue.getLocalRef(), unboxId));
+}
+
+template class PrimitiveType<BooleanTraits>;
+template class PrimitiveType<ByteTraits>;
+template class PrimitiveType<ShortTraits>;
+template class PrimitiveType<IntegerTraits>;
+template class PrimitiveType<LongTraits>;
+template class PrimitiveType<FloatTraits>;
+template class PrimitiveType<DoubleTraits>;
+
+}  // namespace JavaTypes
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JAVATYPES_PRIMITIVETYPE_H
+#define _JSBRIDGE_JAVATYPES_PRIMITIVETYPE_H
+
+#include "Primitive.h"
+#include "jni-helpers/JniContext.h"
+#include <stdexcept>
+
+#if defined(QUICKJS)
+# include "FastArrayConversion.h"
+#endif
+
+namespace JavaTypes {
+
+// Java primitive type (boolean, byte, short, int, long, float, double) whose conversions are all
+// generated from a single implementation (see PrimitiveType.cpp) specialized by Traits:
+// - JniType: the JNI type (e.g. jint)
+// - ID, BOXED_ID, ARRAY_ID: the JavaTypeIds of the primitive, its boxed type and its array type
+// - JAVA_NAME, BOXED_JAVA_NAME: names used in error messages (e.g. "int", "Integer")
+// - BOX_SIGNATURE, UNBOX_METHOD_NAME, UNBOX_SIGNATURE: boxing methods of the boxed type
+// - TypedArrayElement, TYPED_ARRAY_NAME, ALT_TYPED_ARRAY_NAME, [DUK_TYPED_ARRAY_TYPE]: JS typed
+//   array used for bulk array conversions (TYPED_ARRAY_NAME is nullptr if there is none)
+// - get(), callMethodA(), callMethod(): JValue accessor and JNI calls
+// - Duktape: isJsValue(), getJsValue(), pushJsValue()
+// - QuickJS: getJsValue() (throwing if not convertible), newJsValue()
+//
+// Each primitive type is instantiated in PrimitiveType.cpp.
+template <typename Traits>
+class PrimitiveType : public Primitive {
+
+public:
+  using JniType = typename Traits::JniType;
+
+  explicit PrimitiveType(const JsBridgeContext *);
+
+#if defined(DUKTAPE)
+  JValue pop() const override;
+  JValue popArray(uint32_t count, bool expanded) const override;
+
+  duk_ret_t push(const JValue &) const override;
+  duk_ret_t pushArray(const JniLocalRef<jarray> &, bool expand) const override;
+#elif defined(QUICKJS)
+  JValue toJava(JSValueConst) const override;
+  JValue toJavaArray(JSValueConst) const override;
+  JValue toJavaArray(uint32_t count, JSValueConst *values) const override;
+
+  JSValue fromJava(const JValue &) const override;
+  JSValue fromJavaArray(const JniLocalRef<jarray> &) const override;
+  void fromJavaArray(const JniLocalRef<jarray> &, uint32_t count, JSValue *jsValues) const override;
+#endif
+
+  JValue callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
+                    const JValueArgs &args) const override;
+
+  JavaTypeId arrayId() const override { return Traits::ARRAY_ID; }
+
+  // Direct (non-virtual) conversions
+  JsToJavaConversion getJsToJavaConversion() const override;
+  JavaToJsConversion getJavaToJsConversion() const override;
+
+private:
+  JValue box(const JValue &) const override;
+  JValue unbox(const JValue &) const override;
+};
+
+// Common traits of the numeric primitive types
+template <typename T>
+struct NumberTraits {
+  using JniType = T;
+
+#if defined(DUKTAPE)
+  static bool isJsValue(duk_context *ctx, duk_idx_t index) { return duk_is_number(ctx, index); }
+#elif defined(QUICKJS)
+  static T getJsValue(JSValueConst v, const char *javaName) {
+    int tag = JS_VALUE_GET_TAG(v);
+    if (tag == JS_TAG_INT) {
+      return static_cast<T>(JS_VALUE_GET_INT(v));
+    }
+
+    if (JS_TAG_IS_FLOAT64(tag)) {
+      return JavaTypes::castFloat64<T>(JS_VALUE_GET_FLOAT64(v));
+    }
+
+    throw std::invalid_argument(std::string("Cannot convert JS value to Java ") + javaName);
+  }
+#endif
+};
+
+}  // namespace JavaTypes
+
+#endif
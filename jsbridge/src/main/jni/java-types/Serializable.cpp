@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "Serializable.h"
+
+#include "JniCache.h"
+#include "JsBridgeContext.h"
+#include "exceptions/JniException.h"
+#include <stdexcept>
+
+namespace JavaTypes {
+
+Serializable::Serializable(const JsBridgeContext *jsBridgeContext, const JniLocalRef<jclass> &serializableClass, bool isNullable)
+ : Payload(jsBridgeContext, JavaTypeId::Serializable, isNullable)
+ , m_serializableClass(serializableClass) {
+}
+
+JValue Serializable::decodeToJava(std::string &buffer) const {
+  // The direct buffer is only used during the (synchronous) decoding
+  JniLocalRef<jobject> byteBuffer = m_jniContext->newDirectByteBuffer(buffer.data(), static_cast<jlong>(buffer.size()));
+  JniLocalRef<jobject> javaValue = getJniCache()->decodeSerializable(byteBuffer, m_serializableClass);
+
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, buffer.size());
+  return JValue(javaValue);
+}
+
+std::string_view Serializable::encodeFromJava(const JniLocalRef<jobject> &value) const {
+  JniLocalRef<jobject> byteBuffer = getJniCache()->encodeSerializable(value, m_serializableClass);
+
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+
+  // The buffer memory is held by SerializableCodec until the next encoding
+  auto data = static_cast<const char *>(m_jniContext->getDirectBufferAddress(byteBuffer));
+  jlong size = m_jniContext->getDirectBufferCapacity(byteBuffer);
+  if (data == nullptr || size <= 0) {
+    throw std::invalid_argument("Could not encode @Serializable value");
+  }
+
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, static_cast<size_t>(size));
+  return std::string_view(data, static_cast<size_t>(size));
+}
+
+}  // namespace JavaTypes
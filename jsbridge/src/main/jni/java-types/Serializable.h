@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JAVATYPES_SERIALIZABLE_H
+#define _JSBRIDGE_JAVATYPES_SERIALIZABLE_H
+
+#include "Payload.h"
+#include "jni-helpers/JniGlobalRef.h"
+
+namespace JavaTypes {
+
+// kotlinx.serialization @Serializable classes transferred in the Payload binary format (see
+// SerializableCodec.kt):
+// - JS -> Java: the JS value is encoded like a Payload and directly decoded by the serializer of
+//   the class (without any intermediate PayloadObject or JSON string)
+// - Java -> JS: the serializer writes the objects as "shaped" objects whose property names are only
+//   transferred once per buffer so all the JS objects of a class share the same property keys
+class Serializable : public Payload {
+
+public:
+  Serializable(const JsBridgeContext *, const JniLocalRef<jclass> &serializableClass, bool isNullable);
+
+protected:
+  JValue decodeToJava(std::string &buffer) const override;
+  std::string_view encodeFromJava(const JniLocalRef<jobject> &value) const override;
+
+private:
+  JniGlobalRef<jclass> m_serializableClass;
+};
+
+}  // namespace JavaTypes
+
+#endif
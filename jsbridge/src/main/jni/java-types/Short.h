@@ -19,40 +19,49 @@
 #ifndef _JSBRIDGE_JAVATYPES_SHORT_H
 #define _JSBRIDGE_JAVATYPES_SHORT_H
 
-#include "Primitive.h"
+#include "PrimitiveType.h"
 
 namespace JavaTypes {
 
-class Short : public Primitive {
+struct ShortTraits : NumberTraits<jshort> {
+  static constexpr JavaTypeId ID = JavaTypeId::Short;
+  static constexpr JavaTypeId BOXED_ID = JavaTypeId::BoxedShort;
+  static constexpr JavaTypeId ARRAY_ID = JavaTypeId::ShortArray;
 
-public:
-  Short(const JsBridgeContext *);
+  static constexpr const char *JAVA_NAME = "short";
+  static constexpr const char *BOXED_JAVA_NAME = "Short";
 
-#if defined(DUKTAPE)
-  JValue pop() const override;
-  JValue popArray(uint32_t count, bool expanded) const override;
-
-  duk_ret_t push(const JValue &) const override;
-  duk_ret_t pushArray(const JniLocalRef<jarray> &values, bool expand) const override;
-#elif defined(QUICKJS)
-  JValue toJava(JSValueConst) const override;
-  JValue toJavaArray(JSValueConst) const override;
+  static constexpr const char *BOX_SIGNATURE = "(S)Ljava/lang/Short;";
+  static constexpr const char *UNBOX_METHOD_NAME = "shortValue";
+  static constexpr const char *UNBOX_SIGNATURE = "()S";
 
-  JSValue fromJava(const JValue &) const override;
-  JSValue fromJavaArray(const JniLocalRef<jarray> &) const override;
+  using TypedArrayElement = jshort;
+  static constexpr const char *TYPED_ARRAY_NAME = "Int16Array";
+  static constexpr const char *ALT_TYPED_ARRAY_NAME = nullptr;
+#if defined(DUKTAPE)
+  static constexpr duk_uint_t DUK_TYPED_ARRAY_TYPE = DUK_BUFOBJ_INT16ARRAY;
 #endif
 
-  JValue callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
-                    const std::vector<JValue> &args) const override;
+  static jshort get(const JValue &value) { return value.getShort(); }
+
+  static jshort callMethodA(const JniContext *jniContext, const JniRef<jobject> &javaThis, jmethodID methodId, const JValueArgs &args) {
+    return jniContext->callShortMethodA(javaThis, methodId, args);
+  }
 
-  JavaTypeId arrayId() const override { return JavaTypeId::ShortArray; }
+  static jshort callMethod(const JniContext *jniContext, const JniRef<jobject> &object, jmethodID methodId) {
+    return jniContext->callShortMethod(object, methodId);
+  }
 
-private:
-  JValue box(const JValue &) const override;
-  JValue unbox(const JValue &) const override;
+#if defined(DUKTAPE)
+  static jshort getJsValue(duk_context *ctx, duk_idx_t index) { return static_cast<jshort>(duk_require_number(ctx, index)); }
+  static void pushJsValue(duk_context *ctx, jshort value) { duk_push_int(ctx, value); }
+#elif defined(QUICKJS)
+  static JSValue newJsValue(JSContext *ctx, jshort value) { return JS_NewInt32(ctx, value); }
+#endif
 };
 
+using Short = PrimitiveType<ShortTraits>;
+
 }  // namespace JavaTypes
 
 #endif
-
@@ -21,9 +21,17 @@
 #include "JniCache.h"
 
 #if defined(DUKTAPE)
+# include "DuktapeUtils.h"
 # include "StackChecker.h"
 #elif defined(QUICKJS)
+# include "ExceptionHandler.h"
 # include "QuickJsUtils.h"
+# include "ScratchArena.h"
+# include "exceptions/JniException.h"
+# include "exceptions/JsException.h"
+# include "jni-helpers/JArrayLocalRef.h"
+# include <algorithm>
+# include <limits>
 #endif
 
 namespace JavaTypes {
@@ -51,6 +59,7 @@ JValue String::pop() const {
     }
 
     auto debugString = m_jsBridgeContext->getJniCache()->newDebugString(s);
+    JSBRIDGE_COUNT_CONVERSION(JsToJava, strlen(s));
 
     duk_pop(m_ctx);
     return JValue(debugString);
@@ -58,11 +67,14 @@ JValue String::pop() const {
 
   // Check if the caller passed in a null string.
   if (duk_is_null_or_undefined(m_ctx, -1)) {
+    JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
     duk_pop(m_ctx);
     return JValue();
   }
 
-  JStringLocalRef stringLocalRef(m_jniContext, duk_safe_to_string(m_ctx, -1));
+  size_t utf8Length = 0;
+  JStringLocalRef stringLocalRef = getUtils()->toJString(-1, &utf8Length);
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, utf8Length);
   duk_pop(m_ctx);
   return JValue(stringLocalRef);
 }
@@ -71,6 +83,7 @@ duk_ret_t String::push(const JValue &value) const {
   CHECK_STACK_OFFSET(m_ctx, 1);
 
   if (value.isNull()) {
+    JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
     duk_push_null(m_ctx);
     return 1;
   }
@@ -83,11 +96,13 @@ duk_ret_t String::push(const JValue &value) const {
   }
 
   if (jString.isNull()) {
+    JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
     duk_push_null(m_ctx);
     return 1;
   }
 
-  duk_push_string(m_ctx, jString.toUtf8Chars());
+  const size_t utf8Length = getUtils()->pushString(jString);
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, utf8Length);
   return 1;
 }
 
@@ -107,20 +122,24 @@ JValue String::toJava(JSValueConst v) const {
     }
 
     auto debugString = m_jsBridgeContext->getJniCache()->newDebugString(js);
+    JSBRIDGE_COUNT_CONVERSION(JsToJava, js.utf16Length() * sizeof(jchar));
     return JValue(debugString);
   }
 
   // Check if the caller passed in a null string.
   if (JS_IsNull(v) || JS_IsUndefined(v)) {
+    JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
     return JValue();
   }
 
   JStringLocalRef stringLocalRef = m_jsBridgeContext->getUtils()->toJString(v);
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, stringLocalRef.utf16Length() * sizeof(jchar));
   return JValue(stringLocalRef);
 }
 
 JSValue String::fromJava(const JValue &value) const {
   if (value.isNull()) {
+    JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
     return JS_NULL;
   }
 
@@ -132,13 +151,166 @@ JSValue String::fromJava(const JValue &value) const {
   }
 
   if (jString.isNull()) {
+    JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
     return JS_NULL;
   }
 
-  return JS_NewString(m_ctx, jString.toUtf8Chars());
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, jString.utf16Length() * sizeof(jchar));
+  return getUtils()->toJsString(jString);
+}
+
+JValue String::toJavaArray(JSValueConst v) const {
+  // Read the contiguous storage of fast arrays directly (checking the values runs no JS code so
+  // the array cannot be modified meanwhile) and fall back to the element-wise conversion otherwise
+  JSValue *fastArrayValues = nullptr;
+  uint32_t fastArrayCount = 0;
+  JValue value;
+  if (JS_GetFastArray(m_ctx, v, &fastArrayValues, &fastArrayCount) && toJavaStrings(fastArrayCount, fastArrayValues, false, &value)) {
+    return value;
+  }
+
+  return JavaType::toJavaArray(v);
+}
+
+JValue String::toJavaArray(uint32_t count, JSValueConst *values) const {
+  JValue value;
+  if (toJavaStrings(count, values, false, &value)) {
+    return value;
+  }
+
+  return JavaType::toJavaArray(count, values);
+}
+
+void String::fromJavaArray(const JniLocalRef<jarray> &values, uint32_t count, JSValue *jsValues) const {
+  if (m_forDebug) {
+    JavaType::fromJavaArray(values, count, jsValues);
+    return;
+  }
+
+  fromJavaStrings(JObjectArrayLocalRef(values.staticCast<jobjectArray>()), count, jsValues);
+}
+
+bool String::toJavaStrings(uint32_t count, JSValueConst *values, bool asList, JValue *pValue) const {
+  if (m_forDebug) {
+    return false;
+  }
+
+  size_t totalLength = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    JSValueConst v = values[i];
+    if (JS_IsString(v)) {
+      size_t length = 0;
+      JS_BOOL isWideChar = false;
+      JS_GetStringChars(m_ctx, v, &length, &isWideChar);
+      totalLength += length;
+    } else if (!JS_IsNull(v) && !JS_IsUndefined(v)) {
+      return false;
+    }
+  }
+
+  if (totalLength > static_cast<size_t>(std::numeric_limits<jsize>::max())) {
+    return false;
+  }
+
+  JArrayLocalRef<jchar> chars(m_jniContext, static_cast<jsize>(totalLength));
+  JArrayLocalRef<jint> lengths(m_jniContext, static_cast<jsize>(count));
+  if (chars.isNull() || lengths.isNull()) {
+    throw JniException(m_jniContext);
+  }
+
+  {
+    // Pack the UTF-16 chars (Latin-1 strings are widened) and the lengths (-1 for null)
+    ScratchScope scratchScope(m_jsBridgeContext->getScratchArena());
+    auto packedChars = m_jsBridgeContext->getScratchArena()->allocate<jchar>(std::max<size_t>(totalLength, 1));
+    auto packedLengths = m_jsBridgeContext->getScratchArena()->allocate<jint>(std::max<uint32_t>(count, 1));
+
+    jchar *p = packedChars;
+    for (uint32_t i = 0; i < count; ++i) {
+      size_t length = 0;
+      JS_BOOL isWideChar = false;
+      const void *stringChars = JS_GetStringChars(m_ctx, values[i], &length, &isWideChar);
+      if (stringChars == nullptr) {
+        packedLengths[i] = -1;
+        continue;
+      }
+
+      if (isWideChar) {
+        std::copy_n(static_cast<const uint16_t *>(stringChars), length, p);
+      } else {
+        std::copy_n(static_cast<const uint8_t *>(stringChars), length, p);
+      }
+      packedLengths[i] = static_cast<jint>(length);
+      p += length;
+    }
+
+    chars.setRegion(0, static_cast<jsize>(totalLength), packedChars);
+    lengths.setRegion(0, static_cast<jsize>(count), packedLengths);
+  }
+
+  JniLocalRef<jobject> strings = getJniCache()->decodeStrings(chars, lengths, asList);
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, totalLength * sizeof(jchar));
+  *pValue = JValue(strings);
+  return true;
+}
+
+void String::fromJavaStrings(const JObjectArrayLocalRef &strings, uint32_t count, JSValue *jsValues) const {
+  JArrayLocalRef<jint> lengths(m_jniContext, static_cast<jsize>(count));
+  if (lengths.isNull()) {
+    throw JniException(m_jniContext);
+  }
+
+  JArrayLocalRef<jchar> chars = getJniCache()->encodeStrings(strings, lengths);
+  if (m_jniContext->exceptionCheck()) {
+    throw JniException(m_jniContext);
+  }
+
+  const jsize totalLength = chars.getLength();
+
+  ScratchScope scratchScope(m_jsBridgeContext->getScratchArena());
+  auto packedChars = m_jsBridgeContext->getScratchArena()->allocate<jchar>(std::max<jsize>(totalLength, 1));
+  auto packedLengths = m_jsBridgeContext->getScratchArena()->allocate<jint>(std::max<uint32_t>(count, 1));
+  chars.getRegion(0, totalLength, packedChars);
+  lengths.getRegion(0, static_cast<jsize>(count), packedLengths);
+
+  JsStringCache *stringCache = getUtils()->getStringCache();
+  const jchar *p = packedChars;
+  for (uint32_t i = 0; i < count; ++i) {
+    const jint length = packedLengths[i];
+
+    JSValue v;
+    if (length < 0) {
+      v = JS_NULL;
+    } else if (stringCache == nullptr || !stringCache->get(reinterpret_cast<const char16_t *>(p), static_cast<size_t>(length), &v)) {
+      v = JS_NewStringUTF16(m_ctx, reinterpret_cast<const uint16_t *>(p), static_cast<size_t>(length));
+    }
+
+    if (JS_IsException(v)) {
+      for (uint32_t j = 0; j < i; ++j) {
+        JS_FreeValue(m_ctx, jsValues[j]);
+      }
+      throw getExceptionHandler()->getCurrentJsException();
+    }
+
+    jsValues[i] = v;
+    p += std::max(length, 0);
+  }
+
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, totalLength * sizeof(jchar));
 }
 
 #endif
 
+JsToJavaConversion String::getJsToJavaConversion() const {
+  return directJsToJavaConversion(this);
+}
+
+JavaToJsConversion String::getJavaToJsConversion() const {
+  return directJavaToJsConversion(this);
+}
+
 }  // namespace JavaTypes
 
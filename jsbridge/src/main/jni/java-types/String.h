@@ -34,8 +34,27 @@ public:
 #elif defined(QUICKJS)
   JValue toJava(JSValueConst) const override;
   JSValue fromJava(const JValue &) const override;
+
+  // Arrays are converted in bulk (see toJavaStrings() and fromJavaStrings())
+  JValue toJavaArray(JSValueConst) const override;
+  JValue toJavaArray(uint32_t count, JSValueConst *values) const override;
+  void fromJavaArray(const JniLocalRef<jarray> &values, uint32_t count, JSValue *jsValues) const override;
+
+  // Convert the given JS strings to a String[] (or, if asList is set, to an ArrayList) with a
+  // single JNI region copy of all their packed UTF-16 chars and a single StringArrayCodec call
+  // Return false without converting anything if a value is neither a string nor null/undefined
+  // (i.e. needs a JS string conversion which may run JS code) or for DebugString.
+  bool toJavaStrings(uint32_t count, JSValueConst *values, bool asList, JValue *pValue) const;
+  // Convert the given String[] (or Object[] of a List<String>) to JS strings with a single
+  // StringArrayCodec call and a single JNI region copy of all their packed UTF-16 chars
+  // Note: in case of exception, no value needs to be freed
+  void fromJavaStrings(const JObjectArrayLocalRef &strings, uint32_t count, JSValue *jsValues) const;
 #endif
 
+  // Direct (non-virtual) conversions, e.g. for the elements of lists and arrays
+  JsToJavaConversion getJsToJavaConversion() const override;
+  JavaToJsConversion getJavaToJsConversion() const override;
+
 private:
   bool m_forDebug;
 };
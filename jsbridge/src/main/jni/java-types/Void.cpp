@@ -21,6 +21,10 @@
 #include "JsBridgeContext.h"
 #include "exceptions/JniException.h"
 
+#if defined(QUICKJS)
+# include "QuickJsUtils.h"
+#endif
+
 namespace JavaTypes {
 
 Void::Void(const JsBridgeContext *jsBridgeContext, JavaTypeId id, bool boxed)
@@ -31,6 +35,7 @@ Void::Void(const JsBridgeContext *jsBridgeContext, JavaTypeId id, bool boxed)
 #if defined(DUKTAPE)
 
 JValue Void::pop() const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
   duk_pop(m_ctx);
 
   if (m_boxed) {
@@ -52,6 +57,7 @@ JValue Void::popArray(uint32_t count, bool expanded) const {
 }
 
 duk_ret_t Void::push(const JValue &) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
   if (m_boxed) {
     // If void is boxed, it is actually a value which must be pushed
     duk_push_undefined(m_ctx);
@@ -68,6 +74,7 @@ duk_ret_t Void::pushArray(const JniLocalRef<jarray> &, bool /*expand*/) const {
 #elif defined(QUICKJS)
 
 JValue Void::toJava(JSValueConst) const {
+  JSBRIDGE_COUNT_CONVERSION(JsToJava, 0);
   if (m_boxed) {
     // Create and return a new Void or Unit instance
     const auto &javaClass = getJavaClass();
@@ -80,7 +87,7 @@ JValue Void::toJava(JSValueConst) const {
 }
 
 JValue Void::toJavaArray(JSValueConst jsValue) const {
-  JSValue lengthValue = JS_GetPropertyStr(m_ctx, jsValue, "length");
+  JSValue lengthValue = getUtils()->getProperty(jsValue, QuickJsUtils::PropertyName::Length);
   assert(JS_IsNumber(lengthValue));
   uint32_t count = JS_VALUE_GET_INT(lengthValue);
   JS_FreeValue(m_ctx, lengthValue);
@@ -89,7 +96,13 @@ JValue Void::toJavaArray(JSValueConst jsValue) const {
   return JValue(objectArray);
 }
 
+JValue Void::toJavaArray(uint32_t count, JSValueConst *) const {
+  JObjectArrayLocalRef objectArray(m_jniContext, count, getJavaClass());
+  return JValue(objectArray);
+}
+
 JSValue Void::fromJava(const JValue &) const {
+  JSBRIDGE_COUNT_CONVERSION(JavaToJs, 0);
   return JS_UNDEFINED;
 }
 
@@ -97,10 +110,14 @@ JSValue Void::fromJavaArray(const JniLocalRef<jarray> &) const {
   throw std::invalid_argument("Cannot transfer from Java to JS an array of Void values!");
 }
 
+void Void::fromJavaArray(const JniLocalRef<jarray> &, uint32_t, JSValue *) const {
+  throw std::invalid_argument("Cannot transfer from Java to JS an array of Void values!");
+}
+
 #endif
 
 JValue Void::callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
-                        const std::vector<JValue> &args) const {
+                        const JValueArgs &args) const {
   if (m_boxed) {
     m_jniContext->callObjectMethodA<jobject>(javaThis, methodId, args);
   } else {
@@ -108,7 +125,7 @@ JValue Void::callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
   }
 
   // Explicitly release all values now because they won't be used afterwards
-  JValue::releaseAll(args);
+  args.releaseAll();
 
   if (m_jniContext->exceptionCheck()) {
     throw JniException(m_jniContext);
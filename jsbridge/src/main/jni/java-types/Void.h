@@ -37,12 +37,14 @@ public:
 #elif defined(QUICKJS)
   JValue toJava(JSValueConst) const override;
   JValue toJavaArray(JSValueConst) const override;
+  JValue toJavaArray(uint32_t count, JSValueConst *values) const override;
   JSValue fromJava(const JValue &) const override;
   JSValue fromJavaArray(const JniLocalRef<jarray> &values) const override;
+  void fromJavaArray(const JniLocalRef<jarray> &values, uint32_t count, JSValue *jsValues) const override;
 #endif
 
   JValue callMethod(jmethodID methodId, const JniRef<jobject> &javaThis,
-                    const std::vector<JValue> &args) const override;
+                    const JValueArgs &args) const override;
 
 private:
   bool m_boxed;
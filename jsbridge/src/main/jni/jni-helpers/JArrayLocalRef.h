@@ -68,6 +68,12 @@ public:
       , m_jniReleaseArrayMode(JNI_ABORT) {
   }
 
+  template<typename U = T>
+  JArrayLocalRef(const JniContext *jniContext, jsize count, Mode mode = Mode::AutoReleased, typename std::enable_if_t<std::is_same<U, jchar>::value>* = nullptr)
+      : JniLocalRef<jarray>(jniContext, JniRefHelper::getJNIEnv(jniContext)->NewCharArray(count), mode)
+      , m_jniReleaseArrayMode(JNI_ABORT) {
+  }
+
   template<typename U = T>
   JArrayLocalRef(const JniContext *jniContext, jsize count, Mode mode = Mode::AutoReleased, typename std::enable_if_t<std::is_same<U, jshort>::value>* = nullptr)
           : JniLocalRef<jarray>(jniContext, JniRefHelper::getJNIEnv(jniContext)->NewShortArray(count), mode)
@@ -106,6 +112,50 @@ public:
     return env->GetArrayLength(get());
   }
 
+  // Copy a region of the Java array into buf (without accessing the whole array elements)
+  void getRegion(jsize start, jsize length, T *buf) const {
+    JNIEnv *env = getJniEnv();
+    if constexpr (std::is_same<T, jboolean>::value) {
+      env->GetBooleanArrayRegion(static_cast<jbooleanArray>(get()), start, length, buf);
+    } else if constexpr (std::is_same<T, jbyte>::value) {
+      env->GetByteArrayRegion(static_cast<jbyteArray>(get()), start, length, buf);
+    } else if constexpr (std::is_same<T, jint>::value) {
+      env->GetIntArrayRegion(static_cast<jintArray>(get()), start, length, buf);
+    } else if constexpr (std::is_same<T, jlong>::value) {
+      env->GetLongArrayRegion(static_cast<jlongArray>(get()), start, length, buf);
+    } else if constexpr (std::is_same<T, jshort>::value) {
+      env->GetShortArrayRegion(static_cast<jshortArray>(get()), start, length, buf);
+    } else if constexpr (std::is_same<T, jchar>::value) {
+      env->GetCharArrayRegion(static_cast<jcharArray>(get()), start, length, buf);
+    } else if constexpr (std::is_same<T, jdouble>::value) {
+      env->GetDoubleArrayRegion(static_cast<jdoubleArray>(get()), start, length, buf);
+    } else if constexpr (std::is_same<T, jfloat>::value) {
+      env->GetFloatArrayRegion(static_cast<jfloatArray>(get()), start, length, buf);
+    }
+  }
+
+  // Copy buf into a region of the Java array (without accessing the whole array elements)
+  void setRegion(jsize start, jsize length, const T *buf) {
+    JNIEnv *env = getJniEnv();
+    if constexpr (std::is_same<T, jboolean>::value) {
+      env->SetBooleanArrayRegion(static_cast<jbooleanArray>(get()), start, length, buf);
+    } else if constexpr (std::is_same<T, jbyte>::value) {
+      env->SetByteArrayRegion(static_cast<jbyteArray>(get()), start, length, buf);
+    } else if constexpr (std::is_same<T, jint>::value) {
+      env->SetIntArrayRegion(static_cast<jintArray>(get()), start, length, buf);
+    } else if constexpr (std::is_same<T, jlong>::value) {
+      env->SetLongArrayRegion(static_cast<jlongArray>(get()), start, length, buf);
+    } else if constexpr (std::is_same<T, jshort>::value) {
+      env->SetShortArrayRegion(static_cast<jshortArray>(get()), start, length, buf);
+    } else if constexpr (std::is_same<T, jchar>::value) {
+      env->SetCharArrayRegion(static_cast<jcharArray>(get()), start, length, buf);
+    } else if constexpr (std::is_same<T, jdouble>::value) {
+      env->SetDoubleArrayRegion(static_cast<jdoubleArray>(get()), start, length, buf);
+    } else if constexpr (std::is_same<T, jfloat>::value) {
+      env->SetFloatArrayRegion(static_cast<jfloatArray>(get()), start, length, buf);
+    }
+  }
+
   template<typename U = T, typename = std::enable_if_t<std::is_same<U, jboolean>::value>>
   const jboolean *getElements() const {
     if (!m_elements) {
@@ -330,6 +380,12 @@ public:
     }
   }
 
+  // Only used via getRegion() / setRegion(), without any array elements to release
+  template <typename V = void, class Q = T>
+  typename std::enable_if<std::is_same<Q, jchar>::value, V>::type
+  releaseArrayElements() {
+  }
+
 private:
   mutable void *m_elements = nullptr;
   mutable jint m_jniReleaseArrayMode;
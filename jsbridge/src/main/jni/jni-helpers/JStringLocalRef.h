@@ -124,6 +124,18 @@ public:
     return std::u16string_view(m_utf16Chars, static_cast<size_t>(utf16Length()));
   }
 
+  // Copy the UTF-16 chars of the Java string into the given buffer (without keeping any pointer
+  // to the Java String) and return their count, or -1 if the string is longer than maxLength
+  jsize copyUtf16Chars(char16_t *buffer, jsize maxLength) const {
+    const jsize length = utf16Length();
+    if (length > maxLength) {
+      return -1;
+    }
+
+    getJniEnv()->GetStringRegion(jstr(), 0, length, reinterpret_cast<jchar *>(buffer));
+    return length;
+  }
+
   size_t utf8Length() const {
      return m_utf8Chars ? strlen(m_utf8Chars) :
            jstr() ? getJniEnv()->GetStringUTFLength(jstr()) : 0;
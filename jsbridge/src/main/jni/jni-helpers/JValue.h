@@ -18,7 +18,6 @@
 
 #include "JniLocalRef.h"
 #include <jni.h>
-#include <vector>
 
 // Small wrapper around JNI value
 // It has the (small) memory cost of having an additional LocalRef but makes the management of JNI
@@ -132,22 +131,6 @@ public:
     m_localRef.reset();
   }
 
-  // Note: returned array needs to be explictly deleted!!!
-  static jvalue *createArray(const std::vector<JValue> &values) {
-    size_t count = values.size();
-    auto *array = new jvalue[count];
-    for (int i = 0; i < count; ++i) {
-      array[i] = values[i].get();
-    }
-    return array;
-  }
-
-  static void releaseAll(const std::vector<JValue> &values) {
-    for (const JValue &value: values) {
-      value.releaseLocalRef();
-    }
-  }
-
 private:
   jvalue m_value;
   mutable JniLocalRef<jobject> m_localRef;
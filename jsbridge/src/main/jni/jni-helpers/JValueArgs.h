@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _JSBRIDGE_JVALUEARGS_H
+#define _JSBRIDGE_JVALUEARGS_H
+
+#include "JValue.h"
+#include <jni.h>
+#include <array>
+#include <memory>
+
+// Fixed-size list of JValue arguments for a JNI method call
+// The values (and the raw jvalue array given to JNI) are stored inline up to INLINE_CAPACITY
+// arguments so that the usual calls do not need any heap allocation
+class JValueArgs {
+public:
+  static constexpr size_t INLINE_CAPACITY = 8;
+
+  explicit JValueArgs(size_t count)
+    : m_count(count) {
+
+    if (count > INLINE_CAPACITY) {
+      m_heapValues.reset(new JValue[count]);
+      m_heapRawValues.reset(new jvalue[count]);
+    }
+  }
+
+  JValueArgs(const JValueArgs &) = delete;
+  JValueArgs& operator=(const JValueArgs &) = delete;
+
+  size_t size() const { return m_count; }
+
+  JValue &operator[](size_t i) { return getValues()[i]; }
+  const JValue &operator[](size_t i) const { return getValues()[i]; }
+
+  const JValue *begin() const { return getValues(); }
+  const JValue *end() const { return getValues() + m_count; }
+
+  // Return the raw values to be given to JNI
+  // Note: they are only valid until the next call
+  const jvalue *getRawValues() const {
+    jvalue *rawValues = m_heapRawValues ? m_heapRawValues.get() : m_inlineRawValues.data();
+    for (size_t i = 0; i < m_count; ++i) {
+      rawValues[i] = getValues()[i].get();
+    }
+    return rawValues;
+  }
+
+  void releaseAll() const {
+    for (const JValue &value: *this) {
+      value.releaseLocalRef();
+    }
+  }
+
+private:
+  JValue *getValues() { return m_heapValues ? m_heapValues.get() : m_inlineValues.data(); }
+  const JValue *getValues() const { return m_heapValues ? m_heapValues.get() : m_inlineValues.data(); }
+
+  const size_t m_count;
+  std::array<JValue, INLINE_CAPACITY> m_inlineValues;
+  mutable std::array<jvalue, INLINE_CAPACITY> m_inlineRawValues;
+  std::unique_ptr<JValue[]> m_heapValues;
+  std::unique_ptr<jvalue[]> m_heapRawValues;
+};
+
+#endif
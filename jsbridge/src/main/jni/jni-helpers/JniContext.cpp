@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 #include "JniContext.h"
+
+#include "AllocationStats.h"
+#include <pthread.h>
 #include "JStringLocalRef.h"
 
 JniContext::JniContext(JNIEnv *env, EnvironmentSource jniEnvSetup)
@@ -42,6 +45,11 @@ jfieldID JniContext::getStaticFieldID(const JniRef<jclass> &clazz, const char *n
   return env->GetStaticFieldID(clazz.get(), name, sig);
 }
 
+jfieldID JniContext::getFieldID(const JniRef<jclass> &clazz, const char *name, const char *sig) const {
+  JNIEnv *env = getJNIEnv();
+  return env->GetFieldID(clazz.get(), name, sig);
+}
+
 JniLocalRef<jclass> JniContext::findClass(const char *name) const {
   JNIEnv *env = getJNIEnv();
   return JniLocalRef<jclass>(this, env->FindClass(name));
@@ -72,11 +80,51 @@ void JniContext::exceptionClear() const {
   env->ExceptionClear();
 }
 
-static JNIEnv *getEnvFromJvm(JavaVM *jvm) {
-  JNIEnv *jvmEnv;
+namespace {
+  // JNIEnv of the current thread if it has been attached by getEnvFromJvm(). It is then detached
+  // via the pthread key destructor when the thread exits.
+  thread_local JNIEnv *t_attachedJniEnv = nullptr;
+  pthread_key_t s_detachThreadKey;
+  pthread_once_t s_detachThreadKeyOnce = PTHREAD_ONCE_INIT;
+
+  void detachThread(void *jvm) {
+    static_cast<JavaVM *>(jvm)->DetachCurrentThread();
+  }
+
+  void createDetachThreadKey() {
+    pthread_key_create(&s_detachThreadKey, detachThread);
+  }
+
+  // Return the JNIEnv of the current thread or nullptr if it is not attached to the JVM
+  JNIEnv *getCurrentEnv(JavaVM *jvm) {
+    JNIEnv *jvmEnv = nullptr;
+    if (jvm->GetEnv(reinterpret_cast<void **>(&jvmEnv), JNI_VERSION_1_6) != JNI_OK) {
+      return nullptr;
+    }
+    return jvmEnv;
+  }
 
-  jvm->AttachCurrentThread(&jvmEnv, nullptr);
-  return jvmEnv;
+  JNIEnv *getEnvFromJvm(JavaVM *jvm) {
+    if (t_attachedJniEnv != nullptr) {
+      return t_attachedJniEnv;
+    }
+
+    // Threads already attached elsewhere (e.g. Java threads) are not cached because they might be
+    // detached without us knowing it. GetEnv() is cheap, though.
+    JNIEnv *jvmEnv = getCurrentEnv(jvm);
+    if (jvmEnv != nullptr) {
+      return jvmEnv;
+    }
+
+    // Attach once and detach when the thread exits
+    if (jvm->AttachCurrentThread(&jvmEnv, nullptr) != JNI_OK) {
+      return nullptr;
+    }
+    pthread_once(&s_detachThreadKeyOnce, createDetachThreadKey);
+    pthread_setspecific(s_detachThreadKey, jvm);
+    t_attachedJniEnv = jvmEnv;
+    return jvmEnv;
+  }
 }
 
 JNIEnv *JniContext::getJNIEnv() const {
@@ -91,12 +139,15 @@ JNIEnv *JniContext::getJNIEnv() const {
     case EnvironmentSource::Manual:
       env = m_currentJniEnv;
 #ifndef NDEBUG
-      assert(env == getEnvFromJvm(m_jvm));
+      assert(env == getCurrentEnv(m_jvm));
 #endif
       break;
   }
 
   assert(env);
+#if defined(JSBRIDGE_ALLOCATION_STATS)
+  AllocationStats::installJniHooks(env);
+#endif
   return env;
 }
 
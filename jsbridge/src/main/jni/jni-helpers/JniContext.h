@@ -19,10 +19,12 @@
 #include "JniGlobalRef.h"
 #include "JStringLocalRef.h"
 #include "JValue.h"
+#include "JValueArgs.h"
 #include "JniValueConverter.h"
 #include "JniLocalRef.h"
 #include <jni.h>
 #include <array>
+#include <atomic>
 #include <string>
 
 // JNI functions wrapper with JniLocalRef/JniGlobalRef
@@ -43,6 +45,7 @@ public:
   jmethodID getMethodID(const JniRef<jclass> &, const char *name, const char *sig) const;
   jmethodID getStaticMethodID(const JniRef<jclass> &, const char *name, const char *sig) const;
   jfieldID getStaticFieldID(const JniRef<jclass> &, const char *name, const char *sig) const;
+  jfieldID getFieldID(const JniRef<jclass> &, const char *name, const char *sig) const;
 
   JniLocalRef<jclass> findClass(const char *name) const;
 
@@ -60,11 +63,23 @@ public:
     return JniLocalRef<jclass>(this, env->GetStaticObjectField(clazz.get(), fieldId));
   }
 
+  template <class T>
+  jlong getLongField(const JniRef<T> &t, jfieldID fieldId) const {
+    JNIEnv *env = getJNIEnv();
+    return env->GetLongField((jobject) t.get(), fieldId);
+  }
+
   jboolean isInstanceOf(const JniRef<jobject> &obj, const JniRef<jclass> &klass) const {
     JNIEnv *env = getJNIEnv();
     return env->IsInstanceOf(obj.get(), klass.get());
   }
 
+  template <class T, class U>
+  jboolean isSameObject(const JniRef<T> &t, const JniRef<U> &u) const {
+    JNIEnv *env = getJNIEnv();
+    return env->IsSameObject((jobject) t.get(), (jobject) u.get());
+  }
+
   template <class T>
   jmethodID fromReflectedMethod(const JniRef<T> &t) const {
     JNIEnv *env = getJNIEnv();
@@ -92,11 +107,9 @@ public:
   }
 
   template <class ObjT>
-  void callVoidMethodA(const JniRef<ObjT> &t, jmethodID methodId, const std::vector<JValue> &args) const {
+  void callVoidMethodA(const JniRef<ObjT> &t, jmethodID methodId, const JValueArgs &args) const {
     JNIEnv *env = getJNIEnv();
-    jvalue *rawArgs = JValue::createArray(args);
-    env->CallVoidMethodA(t.get(), methodId, rawArgs);
-    delete[] rawArgs;
+    env->CallVoidMethodA(t.get(), methodId, args.getRawValues());
   }
 
   template <class ObjT, typename ...InputArgs>
@@ -106,11 +119,9 @@ public:
   }
 
   template <class ObjT>
-  jboolean callBooleanMethodA(const JniRef<ObjT> &t, jmethodID methodId, const std::vector<JValue> &args) const {
+  jboolean callBooleanMethodA(const JniRef<ObjT> &t, jmethodID methodId, const JValueArgs &args) const {
     JNIEnv *env = getJNIEnv();
-    jvalue *rawArgs = JValue::createArray(args);
-    jboolean ret = env->CallBooleanMethodA(t.get(), methodId, rawArgs);
-    delete[] rawArgs;
+    jboolean ret = env->CallBooleanMethodA(t.get(), methodId, args.getRawValues());
     return ret;
   }
 
@@ -121,11 +132,9 @@ public:
   }
 
   template <class ObjT>
-  jbyte callByteMethodA(const JniRef<ObjT> &t, jmethodID methodId, const std::vector<JValue> &args) const {
+  jbyte callByteMethodA(const JniRef<ObjT> &t, jmethodID methodId, const JValueArgs &args) const {
     JNIEnv *env = getJNIEnv();
-    jvalue *rawArgs = JValue::createArray(args);
-    jbyte ret = env->CallByteMethodA(t.get(), methodId, rawArgs);
-    delete[] rawArgs;
+    jbyte ret = env->CallByteMethodA(t.get(), methodId, args.getRawValues());
     return ret;
   }
 
@@ -136,11 +145,9 @@ public:
   }
 
   template <class ObjT>
-  jint callIntMethodA(const JniRef<ObjT> &t, jmethodID methodId, const std::vector<JValue> &args) const {
+  jint callIntMethodA(const JniRef<ObjT> &t, jmethodID methodId, const JValueArgs &args) const {
     JNIEnv *env = getJNIEnv();
-    jvalue *rawArgs = JValue::createArray(args);
-    jint ret = env->CallIntMethodA(t.get(), methodId, rawArgs);
-    delete[] rawArgs;
+    jint ret = env->CallIntMethodA(t.get(), methodId, args.getRawValues());
     return ret;
   }
 
@@ -151,11 +158,9 @@ public:
   }
 
   template <class ObjT>
-  jlong callLongMethodA(const JniRef<ObjT> &t, jmethodID methodId, const std::vector<JValue> &args) const {
+  jlong callLongMethodA(const JniRef<ObjT> &t, jmethodID methodId, const JValueArgs &args) const {
     JNIEnv *env = getJNIEnv();
-    jvalue *rawArgs = JValue::createArray(args);
-    jlong ret = env->CallLongMethodA(t.get(), methodId, rawArgs);
-    delete[] rawArgs;
+    jlong ret = env->CallLongMethodA(t.get(), methodId, args.getRawValues());
     return ret;
   }
 
@@ -166,11 +171,9 @@ public:
   }
 
   template <class ObjT>
-  jshort callShortMethodA(const JniRef<ObjT> &t, jmethodID methodId, const std::vector<JValue> &args) const {
+  jshort callShortMethodA(const JniRef<ObjT> &t, jmethodID methodId, const JValueArgs &args) const {
     JNIEnv *env = getJNIEnv();
-    jvalue *rawArgs = JValue::createArray(args);
-    jlong ret = env->CallShortMethodA(t.get(), methodId, rawArgs);
-    delete[] rawArgs;
+    jlong ret = env->CallShortMethodA(t.get(), methodId, args.getRawValues());
     return ret;
   }
 
@@ -181,11 +184,9 @@ public:
   }
 
   template <class ObjT>
-  jdouble callDoubleMethodA(const JniRef<ObjT> &t, jmethodID methodId, const std::vector<JValue> &args) const {
+  jdouble callDoubleMethodA(const JniRef<ObjT> &t, jmethodID methodId, const JValueArgs &args) const {
     JNIEnv *env = getJNIEnv();
-    jvalue *rawArgs = JValue::createArray(args);
-    jdouble ret = env->CallDoubleMethodA(t.get(), methodId, rawArgs);
-    delete[] rawArgs;
+    jdouble ret = env->CallDoubleMethodA(t.get(), methodId, args.getRawValues());
     return ret;
   }
 
@@ -196,11 +197,9 @@ public:
   }
 
   template <class ObjT>
-  jfloat callFloatMethodA(const JniRef<ObjT> &t, jmethodID methodId, const std::vector<JValue> &args) const {
+  jfloat callFloatMethodA(const JniRef<ObjT> &t, jmethodID methodId, const JValueArgs &args) const {
     JNIEnv *env = getJNIEnv();
-    jvalue *rawArgs = JValue::createArray(args);
-    jfloat ret = env->CallFloatMethodA(t.get(), methodId, rawArgs);
-    delete[] rawArgs;
+    jfloat ret = env->CallFloatMethodA(t.get(), methodId, args.getRawValues());
     return ret;
   }
 
@@ -219,11 +218,9 @@ public:
   }
 
   template <class RetT = jobject, class ObjT>
-  JniLocalRef<RetT> callObjectMethodA(const JniRef<ObjT> &t, jmethodID methodId, const std::vector<JValue> &args) const {
+  JniLocalRef<RetT> callObjectMethodA(const JniRef<ObjT> &t, jmethodID methodId, const JValueArgs &args) const {
     JNIEnv *env = getJNIEnv();
-    jvalue *rawArgs = JValue::createArray(args);
-    jobject o = env->CallObjectMethodA(t.get(), methodId, rawArgs);
-    delete[] rawArgs;
+    jobject o = env->CallObjectMethodA(t.get(), methodId, args.getRawValues());
     return JniLocalRef<RetT>(this, o);
   }
 
@@ -240,6 +237,12 @@ public:
     return JniLocalRef<RetT>(this, o);
   }
 
+  template <typename ...InputArgs>
+  jint callStaticIntMethod(const JniRef<jclass> &t, jmethodID methodId, InputArgs &&...args) const {
+    JNIEnv *env = getJNIEnv();
+    return env->CallStaticIntMethod(t.get(), methodId, JniValueConverter::toJniValues(std::forward<InputArgs>(args))...);
+  }
+
   template <typename ...InputArgs>
   JStringLocalRef callStaticStringMethod(const JniRef<jclass> &t, jmethodID methodId, InputArgs &&...args) const {
     JNIEnv *env = getJNIEnv();
@@ -248,11 +251,9 @@ public:
   }
 
     template <class RetT = jobject>
-  JniLocalRef<RetT> callStaticObjectMethodA(const JniRef<jclass> &t, jmethodID methodId, const std::vector<JValue> &args) const {
+  JniLocalRef<RetT> callStaticObjectMethodA(const JniRef<jclass> &t, jmethodID methodId, const JValueArgs &args) const {
     JNIEnv *env = getJNIEnv();
-    jvalue *rawArgs = JValue::createArray(args);
-    jobject o = env->CallStaticObjectMethodA(t.get(), methodId, rawArgs);
-    delete[] rawArgs;
+    jobject o = env->CallStaticObjectMethodA(t.get(), methodId, args.getRawValues());
     return JniLocalRef<RetT>(this, o);
   }
 
@@ -261,7 +262,30 @@ public:
     return env->GetArrayLength(array.get());
   }
 
+  // Direct java.nio.ByteBuffer wrapping the given memory (which must outlive the buffer)
+  JniLocalRef<jobject> newDirectByteBuffer(void *address, jlong capacity) const {
+    JNIEnv *env = getJNIEnv();
+    return JniLocalRef<jobject>(this, env->NewDirectByteBuffer(address, capacity));
+  }
+
+  void *getDirectBufferAddress(const JniRef<jobject> &buffer) const {
+    JNIEnv *env = getJNIEnv();
+    return env->GetDirectBufferAddress(buffer.get());
+  }
+
+  jlong getDirectBufferCapacity(const JniRef<jobject> &buffer) const {
+    JNIEnv *env = getJNIEnv();
+    return env->GetDirectBufferCapacity(buffer.get());
+  }
+
+  // Number of the JNI global refs currently held via JniGlobalRef instances created with this
+  // context (which can be released from any thread)
+  size_t getGlobalRefCount() const { return m_globalRefCount.load(std::memory_order_relaxed); }
+  void onGlobalRefCreated() const { m_globalRefCount.fetch_add(1, std::memory_order_relaxed); }
+  void onGlobalRefDeleted() const { m_globalRefCount.fetch_sub(1, std::memory_order_relaxed); }
+
 private:
+  mutable std::atomic<size_t> m_globalRefCount { 0 };
   JNIEnv *m_currentJniEnv;
   JavaVM *m_jvm;
   EnvironmentSource m_jniEnvSetup;
@@ -51,6 +51,7 @@ public:
 
     if (!localRef.isNull()) {
       m_object = static_cast<T>(JniRefHelper::getJNIEnv(m_jniContext)->NewGlobalRef(localRef.get()));
+      JniRefHelper::onGlobalRefCreated(m_jniContext);
       if (mode == Mode::AutoReleased) {
         m_sharedAutoRelease = makeSharedAutoRelease(true);
       }
@@ -96,6 +97,7 @@ public:
     assert(env != nullptr);
 
     env->DeleteGlobalRef(object);
+    JniRefHelper::onGlobalRefDeleted(jniContext);
   }
 
   static void deleteRawWeakGlobalRef(const JniContext *jniContext, jobject object) {
@@ -132,6 +134,7 @@ private:
     return std::shared_ptr<bool>(new bool(autoRelease), [jniContext, object](bool *pAutoRelease) {
       if (*pAutoRelease) {
         JniRefHelper::getJNIEnv(jniContext)->DeleteGlobalRef(object);
+        JniRefHelper::onGlobalRefDeleted(jniContext);
       }
       delete pAutoRelease;
     });
@@ -22,6 +22,7 @@
 #include "JniContext.h"
 #include <jni.h>
 #include <memory>
+#include <optional>
 
 class JniContext;
 
@@ -55,4 +56,44 @@ private:
   JNIEnv *m_env;
 };
 
+// Local reference frames for the element loops of large conversions (e.g. List, arrays of
+// objects): a new frame is pushed every CHUNK_SIZE elements so that the local references
+// created while converting the elements cannot overflow the local reference table. Smaller
+// conversions do not push any frame and only ensure the needed capacity.
+//
+// Usage: call next() at the beginning of each loop iteration. Local references created inside
+// the loop must not outlive the iteration!
+class JniChunkedLocalFrame {
+public:
+  static const size_t CHUNK_SIZE = 256;
+
+  JniChunkedLocalFrame(const JniContext *jniContext, size_t elementCount, size_t refsPerElement = 4)
+      : m_jniContext(jniContext)
+      , m_isChunked(elementCount > CHUNK_SIZE)
+      , m_capacity(CHUNK_SIZE * refsPerElement) {
+
+    if (!m_isChunked) {
+      // Hint only: the table is grown anyway if needed
+      jniContext->getJNIEnv()->EnsureLocalCapacity(static_cast<jint>(elementCount * refsPerElement));
+    }
+  }
+
+  JniChunkedLocalFrame(const JniChunkedLocalFrame &) = delete;
+  JniChunkedLocalFrame& operator=(const JniChunkedLocalFrame &) = delete;
+
+  void next() {
+    if (m_isChunked && m_elementIndex++ % CHUNK_SIZE == 0) {
+      m_frame.reset();
+      m_frame.emplace(m_jniContext, m_capacity);
+    }
+  }
+
+private:
+  const JniContext *m_jniContext;
+  const bool m_isChunked;
+  const size_t m_capacity;
+  size_t m_elementIndex = 0;
+  std::optional<JniLocalFrame> m_frame;
+};
+
 #endif
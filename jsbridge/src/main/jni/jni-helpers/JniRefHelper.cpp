@@ -23,3 +23,15 @@ JNIEnv *JniRefHelper::getJNIEnv(const JniContext *jniContext) {
   assert(jniContext != nullptr);
   return jniContext->getJNIEnv();
 }
+
+// static
+void JniRefHelper::onGlobalRefCreated(const JniContext *jniContext) {
+  assert(jniContext != nullptr);
+  jniContext->onGlobalRefCreated();
+}
+
+// static
+void JniRefHelper::onGlobalRefDeleted(const JniContext *jniContext) {
+  assert(jniContext != nullptr);
+  jniContext->onGlobalRefDeleted();
+}
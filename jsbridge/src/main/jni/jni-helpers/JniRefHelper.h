@@ -29,6 +29,10 @@ public:
   ~JniRefHelper() = delete;
 
   static JNIEnv *getJNIEnv(const JniContext *);
+
+  // Global ref accounting (see JniContext::getGlobalRefCount())
+  static void onGlobalRefCreated(const JniContext *);
+  static void onGlobalRefDeleted(const JniContext *);
 };
 
 #endif
@@ -44,6 +44,10 @@
 #include "list.h"
 #include "quickjs.h"
 #include "libregexp.h"
+#if defined(__ARM_NEON)
+/* JsBridge: vectorized fast paths for 8-bit strings */
+#include <arm_neon.h>
+#endif
 #ifdef CONFIG_BIGNUM
 #include "libbf.h"
 #endif
@@ -263,6 +267,7 @@ struct JSRuntime {
     struct list_head tmp_obj_list; /* used during GC */
     JSGCPhaseEnum gc_phase : 8;
     size_t malloc_gc_threshold;
+    size_t malloc_gc_threshold_min; /* lower bound of malloc_gc_threshold after a GC */
 #ifdef DUMP_LEAKS
     struct list_head string_list; /* list of JSString.link */
 #endif
@@ -280,6 +285,15 @@ struct JSRuntime {
     JSInterruptHandler *interrupt_handler;
     void *interrupt_opaque;
 
+    /* JsBridge: state of JS_WalkHeap() (used by the mark function) */
+    void *heap_walk_state;
+
+    /* JsBridge: compiled RegExp bytecode by pattern and flags, most recently used first (see
+       JS_SetRegExpCacheSize()) */
+    struct JSRegExpCacheEntry *regexp_cache;
+    int regexp_cache_count;
+    int regexp_cache_size;
+
     JSHostPromiseRejectionTracker *host_promise_rejection_tracker;
     void *host_promise_rejection_tracker_opaque;
     
@@ -1274,6 +1288,8 @@ static void js_trigger_gc(JSRuntime *rt, size_t size)
         JS_RunGC(rt);
         rt->malloc_gc_threshold = rt->malloc_state.malloc_size +
             (rt->malloc_state.malloc_size >> 1);
+        if (rt->malloc_gc_threshold < rt->malloc_gc_threshold_min)
+            rt->malloc_gc_threshold = rt->malloc_gc_threshold_min;
     }
 }
 
@@ -1616,6 +1632,7 @@ JSRuntime *JS_NewRuntime2(const JSMallocFunctions *mf, void *opaque)
     }
     rt->malloc_state = ms;
     rt->malloc_gc_threshold = 256 * 1024;
+    rt->malloc_gc_threshold_min = 0;
 
 #ifdef CONFIG_BIGNUM
     bf_context_init(&rt->bf_ctx, js_bf_realloc, rt);
@@ -1778,6 +1795,55 @@ void JS_SetMemoryLimit(JSRuntime *rt, size_t limit)
 void JS_SetGCThreshold(JSRuntime *rt, size_t gc_threshold)
 {
     rt->malloc_gc_threshold = gc_threshold;
+    /* the threshold is kept as a lower bound when it is recomputed after a GC */
+    rt->malloc_gc_threshold_min = gc_threshold;
+}
+
+/* JsBridge: trigger the next GC after the given size has been allocated (e.g. after an idle GC)
+   without changing the lower bound given to JS_SetGCThreshold(). The threshold is recomputed as
+   usual after the next GC. */
+void JS_SetNextGCAllocationThreshold(JSRuntime *rt, size_t allocation_threshold)
+{
+    rt->malloc_gc_threshold = rt->malloc_state.malloc_size + allocation_threshold;
+    if (rt->malloc_gc_threshold < rt->malloc_gc_threshold_min)
+        rt->malloc_gc_threshold = rt->malloc_gc_threshold_min;
+}
+
+/* JsBridge: compiled RegExp bytecode cache */
+typedef struct JSRegExpCacheEntry {
+    JSString *pattern;
+    int re_flags;
+    JSString *bytecode;
+} JSRegExpCacheEntry;
+
+/* JsBridge: keep the bytecode of the given number of most recently compiled RegExp patterns
+   (with their flags) so that e.g. "new RegExp(str)" in a loop only compiles "str" once. The
+   bytecode strings are immutable and shared with the RegExp objects. Use 0 (default) to disable
+   the cache and release the cached entries. */
+void JS_SetRegExpCacheSize(JSRuntime *rt, int size)
+{
+    JSRegExpCacheEntry *cache;
+    int i;
+
+    if (size < 0)
+        size = 0;
+    for(i = size; i < rt->regexp_cache_count; i++) {
+        JS_FreeValueRT(rt, JS_MKPTR(JS_TAG_STRING, rt->regexp_cache[i].pattern));
+        JS_FreeValueRT(rt, JS_MKPTR(JS_TAG_STRING, rt->regexp_cache[i].bytecode));
+    }
+    if (rt->regexp_cache_count > size)
+        rt->regexp_cache_count = size;
+
+    if (size == 0) {
+        js_free_rt(rt, rt->regexp_cache);
+        rt->regexp_cache = NULL;
+    } else if (size != rt->regexp_cache_size) {
+        cache = js_realloc_rt(rt, rt->regexp_cache, sizeof(rt->regexp_cache[0]) * size);
+        if (!cache)
+            return;  /* keep the current (larger or equal) capacity */
+        rt->regexp_cache = cache;
+    }
+    rt->regexp_cache_size = size;
 }
 
 #define malloc(s) malloc_is_forbidden(s)
@@ -1858,6 +1924,26 @@ int JS_ExecutePendingJob(JSRuntime *rt, JSContext **pctx)
     return ret;
 }
 
+/* free the pending jobs of the given context without executing them
+   (e.g. before freeing a context whose runtime is shared with other
+   contexts) */
+void JS_FreePendingJobs(JSContext *ctx)
+{
+    JSRuntime *rt = ctx->rt;
+    struct list_head *el, *el1;
+    int i;
+
+    list_for_each_safe(el, el1, &rt->job_list) {
+        JSJobEntry *e = list_entry(el, JSJobEntry, link);
+        if (e->ctx != ctx)
+            continue;
+        list_del(&e->link);
+        for(i = 0; i < e->argc; i++)
+            JS_FreeValue(ctx, e->argv[i]);
+        js_free(ctx, e);
+    }
+}
+
 static inline uint32_t atom_get_free(const JSAtomStruct *p)
 {
     return (uintptr_t)p >> 1;
@@ -1939,6 +2025,8 @@ void JS_FreeRuntime(JSRuntime *rt)
     }
     init_list_head(&rt->job_list);
 
+    JS_SetRegExpCacheSize(rt, 0);
+
     JS_RunGC(rt);
 
 #ifdef DUMP_LEAKS
@@ -3968,6 +4056,45 @@ JSValue JS_NewAtomString(JSContext *ctx, const char *str)
     return val;
 }
 
+JSValue JS_NewStringUTF16(JSContext *ctx, const uint16_t *buf, size_t len)
+{
+    JSString *str;
+    size_t i;
+
+    if (len > JS_STRING_LEN_MAX)
+        return JS_ThrowInternalError(ctx, "string too long");
+    for (i = 0; i < len; i++) {
+        if (buf[i] >= 0x100)
+            return js_new_string16(ctx, buf, len);
+    }
+    /* Latin-1 string */
+    if (len == 0)
+        return JS_AtomToString(ctx, JS_ATOM_empty_string);
+    str = js_alloc_string(ctx, len, 0);
+    if (!str)
+        return JS_EXCEPTION;
+    for (i = 0; i < len; i++)
+        str->u.str8[i] = buf[i];
+    str->u.str8[len] = '\0';
+    return JS_MKPTR(JS_TAG_STRING, str);
+}
+
+const void *JS_GetStringChars(JSContext *ctx, JSValueConst val, size_t *plen,
+                              JS_BOOL *pis_wide_char)
+{
+    JSString *p;
+
+    if (JS_VALUE_GET_TAG(val) != JS_TAG_STRING)
+        return NULL;
+    p = JS_VALUE_GET_STRING(val);
+    *plen = p->len;
+    *pis_wide_char = p->is_wide_char;
+    if (p->is_wide_char)
+        return p->u.str16;
+    else
+        return p->u.str8;
+}
+
 /* return (NULL, 0) if exception. */
 /* return pointer into a JSString with a live ref_count */
 /* cesu8 determines if non-BMP1 codepoints are encoded as 1 or 2 utf-8 sequences */
@@ -8270,6 +8397,37 @@ static int expand_fast_array(JSContext *ctx, JSObject *p, uint32_t new_len)
     return 0;
 }
 
+JSValue JS_NewArrayFrom(JSContext *ctx, uint32_t count, JSValue *values)
+{
+    JSValue obj;
+    JSObject *p;
+    uint32_t i;
+
+    if (count > INT32_MAX) {
+        JS_ThrowRangeError(ctx, "invalid array length");
+        goto fail;
+    }
+    obj = JS_NewArray(ctx);
+    if (JS_IsException(obj))
+        goto fail;
+    if (count > 0) {
+        /* single allocation of the fast array storage */
+        p = JS_VALUE_GET_OBJ(obj);
+        if (expand_fast_array(ctx, p, count)) {
+            JS_FreeValue(ctx, obj);
+            goto fail;
+        }
+        memcpy(p->u.array.u.values, values, sizeof(JSValue) * count);
+        p->u.array.count = count;
+        p->prop[0].u.value = JS_NewInt32(ctx, count);
+    }
+    return obj;
+ fail:
+    for(i = 0; i < count; i++)
+        JS_FreeValue(ctx, values[i]);
+    return JS_EXCEPTION;
+}
+
 /* Preconditions: 'p' must be of class JS_CLASS_ARRAY, p->fast_array =
    TRUE and p->extensible = TRUE */
 static int add_fast_array_element(JSContext *ctx, JSObject *p,
@@ -15554,6 +15712,12 @@ static BOOL js_get_fast_array(JSContext *ctx, JSValueConst obj,
     return FALSE;
 }
 
+JS_BOOL JS_GetFastArray(JSContext *ctx, JSValueConst val, JSValue **parray,
+                        uint32_t *pcount)
+{
+    return js_get_fast_array(ctx, val, parray, pcount);
+}
+
 static __exception int js_append_enumerate(JSContext *ctx, JSValue *sp)
 {
     JSValue iterator, enumobj, method, value;
@@ -21204,6 +21368,121 @@ static JSAtom json_parse_ident(JSParseState *s, const uint8_t **pp, int c)
     return atom;
 }
 
+/* JsBridge: length of the leading bytes of [p, end) which are copied as is into a JSON string,
+   i.e. printable ASCII chars except '"' and '\\'. With NEON, the bytes are checked in 16-byte
+   blocks. */
+static inline size_t json_plain_chars_len(const uint8_t *p, const uint8_t *end)
+{
+    const uint8_t *p0 = p;
+#if defined(__ARM_NEON)
+    while (end - p >= 16) {
+        uint8x16_t v = vld1q_u8(p);
+        /* (v - 0x20) >= 0x60 for control chars and non-ASCII bytes */
+        uint8x16_t special = vorrq_u8(vcgeq_u8(vsubq_u8(v, vdupq_n_u8(0x20)), vdupq_n_u8(0x60)),
+                                      vorrq_u8(vceqq_u8(v, vdupq_n_u8('\"')),
+                                               vceqq_u8(v, vdupq_n_u8('\\'))));
+        uint8x8_t m = vorr_u8(vget_low_u8(special), vget_high_u8(special));
+        if (vget_lane_u64(vreinterpret_u64_u8(m), 0) != 0)
+            break;
+        p += 16;
+    }
+#endif
+    while (p < end && *p >= 0x20 && *p < 0x80 && *p != '\"' && *p != '\\')
+        p++;
+    return p - p0;
+}
+
+/* JsBridge: dedicated parser for the (double quoted) strings of standard JSON: runs of plain
+   chars are appended at once and only the JSON escapes are accepted. p points after the opening
+   quote. */
+static __exception int json_parse_string(JSParseState *s, const uint8_t *p,
+                                         JSToken *token, const uint8_t **pp)
+{
+    StringBuffer b_s, *b = &b_s;
+    size_t n;
+    uint32_t c;
+    int i, h;
+
+    if (string_buffer_init(s->ctx, b, 32))
+        goto fail;
+    for(;;) {
+        n = json_plain_chars_len(p, s->buf_end);
+        if (n > 0) {
+            if (string_buffer_write8(b, p, n))
+                goto fail;
+            p += n;
+        }
+        if (p >= s->buf_end) {
+            js_parse_error(s, "unexpected end of string");
+            goto fail;
+        }
+        c = *p++;
+        if (c == '\"')
+            break;
+        if (c < 0x20) {
+            js_parse_error(s, "invalid character in a JSON string");
+            goto fail;
+        }
+        if (c == '\\') {
+            c = *p++;
+            switch(c) {
+            case '\"':
+            case '\\':
+            case '/':
+                break;
+            case 'b':
+                c = '\b';
+                break;
+            case 'f':
+                c = '\f';
+                break;
+            case 'n':
+                c = '\n';
+                break;
+            case 'r':
+                c = '\r';
+                break;
+            case 't':
+                c = '\t';
+                break;
+            case 'u':
+                c = 0;
+                for(i = 0; i < 4; i++) {
+                    h = from_hex(*p++);
+                    if (h < 0)
+                        goto invalid_escape;
+                    c = (c << 4) | h;
+                }
+                break;
+            default:
+            invalid_escape:
+                js_parse_error(s, "malformed escape sequence in string literal");
+                goto fail;
+            }
+        } else {
+            /* c >= 0x80 */
+            const uint8_t *p_next;
+            c = unicode_from_utf8(p - 1, UTF8_CHAR_LEN_MAX, &p_next);
+            if (c > 0x10FFFF) {
+                js_parse_error(s, "invalid UTF-8 sequence");
+                goto fail;
+            }
+            p = p_next;
+        }
+        if (string_buffer_putc(b, c))
+            goto fail;
+    }
+    token->val = TOK_STRING;
+    token->u.str.sep = '\"';
+    token->u.str.str = string_buffer_end(b);
+    *pp = p;
+    return 0;
+
+ fail:
+    string_buffer_free(b);
+    return -1;
+}
+
 static __exception int json_next_token(JSParseState *s)
 {
     const uint8_t *p;
@@ -21237,6 +21516,11 @@ static __exception int json_next_token(JSParseState *s)
         }
         /* fall through */
     case '\"':
+        if (!s->ext_json) {
+            if (json_parse_string(s, p + 1, &s->token, &p))
+                goto fail;
+            break;
+        }
         if (js_parse_string(s, c, TRUE, p + 1, &s->token, &p))
             goto fail;
         break;
@@ -21248,6 +21532,9 @@ static __exception int json_next_token(JSParseState *s)
     case '\n':
         p++;
         s->line_num++;
+        /* JsBridge: skip the indentation at once */
+        while (*p == ' ' || *p == '\t')
+            p++;
         goto redo;
     case '\f':
     case '\v':
@@ -21259,6 +21546,8 @@ static __exception int json_next_token(JSParseState *s)
     case ' ':
     case '\t':
         p++;
+        while (*p == ' ' || *p == '\t')
+            p++;
         goto redo;
     case '/':
         if (!s->ext_json) {
@@ -27308,6 +27597,12 @@ static char *js_default_module_normalize_name(JSContext *ctx,
     return filename;
 }
 
+char *JS_DefaultModuleNormalizeName(JSContext *ctx, const char *base_name,
+                                    const char *name)
+{
+    return js_default_module_normalize_name(ctx, base_name, name);
+}
+
 static JSModuleDef *js_find_loaded_module(JSContext *ctx, JSAtom name)
 {
     struct list_head *el;
@@ -28139,6 +28434,277 @@ JSAtom JS_GetScriptOrModuleName(JSContext *ctx, int n_stack_levels)
     return JS_DupAtom(ctx, b->debug.filename);
 }
 
+/* JsBridge: copy the given atom without allocating any memory */
+static void js_get_stack_frame_str(JSContext *ctx, char *buf, int buf_size,
+                                   JSAtom atom)
+{
+    const char *str;
+
+    if (atom == JS_ATOM_NULL) {
+        buf[0] = '\0';
+        return;
+    }
+    str = JS_AtomGetStr(ctx, buf, buf_size, atom);
+    if (str != buf)
+        pstrcpy(buf, buf_size, str);
+}
+
+/* JsBridge: walk the call stack from the innermost frame. Does not
+   allocate any memory so that it can be used from the interrupt handler.
+   Return the number of frames. */
+int JS_GetStackFrames(JSContext *ctx, JSStackFrameInfo *frames, int max_frames)
+{
+    JSStackFrame *sf;
+    JSFunctionBytecode *b;
+    JSObject *p;
+    JSStackFrameInfo *fi;
+    int count = 0;
+
+    for (sf = ctx->rt->current_stack_frame; sf != NULL && count < max_frames;
+         sf = sf->prev_frame) {
+        fi = &frames[count++];
+        fi->function_name[0] = '\0';
+        fi->file_name[0] = '\0';
+        fi->line_number = 0;
+        if (JS_VALUE_GET_TAG(sf->cur_func) != JS_TAG_OBJECT)
+            continue;
+        p = JS_VALUE_GET_OBJ(sf->cur_func);
+        if (!js_class_has_bytecode(p->class_id)) {
+            pstrcpy(fi->function_name, sizeof(fi->function_name), "(native)");
+            continue;
+        }
+        b = p->u.func.function_bytecode;
+        js_get_stack_frame_str(ctx, fi->function_name,
+                               sizeof(fi->function_name), b->func_name);
+        if (b->has_debug) {
+            js_get_stack_frame_str(ctx, fi->file_name,
+                                   sizeof(fi->file_name), b->debug.filename);
+            fi->line_number = b->debug.line_num;
+        }
+    }
+    return count;
+}
+
+/* JsBridge: heap snapshot */
+typedef struct JSHeapWalkState {
+    const JSHeapWalkFuncs *funcs;
+    void *opaque;
+    JSGCObjectHeader *from;
+} JSHeapWalkState;
+
+static void js_heap_walk_mark(JSRuntime *rt, JSGCObjectHeader *gp)
+{
+    JSHeapWalkState *s = rt->heap_walk_state;
+    s->funcs->child(s->opaque, s->from, gp);
+}
+
+static void js_heap_walk_edge(JSHeapWalkState *s, JSGCObjectHeader *to,
+                              const char *type, const char *name,
+                              uint32_t index)
+{
+    if (to)
+        s->funcs->edge(s->opaque, s->from, to, type, name, index);
+}
+
+static void js_heap_walk_value_edge(JSHeapWalkState *s, JSValueConst v,
+                                    const char *type, const char *name,
+                                    uint32_t index)
+{
+    int tag = JS_VALUE_GET_TAG(v);
+    if (tag == JS_TAG_OBJECT || tag == JS_TAG_FUNCTION_BYTECODE)
+        js_heap_walk_edge(s, JS_VALUE_GET_PTR(v), type, name, index);
+}
+
+/* name of the constructor of the given object, NULL if unknown */
+static const char *js_heap_walk_get_constructor_name(JSRuntime *rt,
+                                                     char *buf, int buf_size,
+                                                     JSObject *p)
+{
+    JSShapeProperty *prs;
+    JSProperty *pr;
+    JSObject *ctor;
+
+    if (!p->shape->proto)
+        return NULL;
+    prs = find_own_property(&pr, p->shape->proto, JS_ATOM_constructor);
+    if (!prs || (prs->flags & JS_PROP_TMASK) != JS_PROP_NORMAL ||
+        JS_VALUE_GET_TAG(pr->u.value) != JS_TAG_OBJECT)
+        return NULL;
+    ctor = JS_VALUE_GET_OBJ(pr->u.value);
+    if (!js_class_has_bytecode(ctor->class_id))
+        return NULL;
+    return JS_AtomGetStrRT(rt, buf, buf_size,
+                           ctor->u.func.function_bytecode->func_name);
+}
+
+static void js_heap_walk_object(JSRuntime *rt, JSHeapWalkState *s,
+                                JSObject *p)
+{
+    char name_buf[ATOM_GET_STR_BUF_SIZE], buf[ATOM_GET_STR_BUF_SIZE + 4];
+    const char *type, *name;
+    JSShape *sh = p->shape;
+    JSShapeProperty *prs;
+    JSProperty *pr;
+    size_t size;
+    uint32_t i;
+
+    /* node */
+    name = NULL;
+    size = sizeof(JSObject) + sh->prop_size * sizeof(JSProperty);
+    if (js_class_has_bytecode(p->class_id)) {
+        type = "closure";
+        name = JS_AtomGetStrRT(rt, name_buf, sizeof(name_buf),
+                               p->u.func.function_bytecode->func_name);
+    } else if (p->class_id == JS_CLASS_ARRAY ||
+               p->class_id == JS_CLASS_ARGUMENTS) {
+        type = "array";
+        if (p->fast_array)
+            size += p->u.array.u1.size * sizeof(JSValue);
+    } else if (p->class_id == JS_CLASS_REGEXP) {
+        type = "regexp";
+    } else {
+        type = "object";
+        if (p->class_id == JS_CLASS_OBJECT)
+            name = js_heap_walk_get_constructor_name(rt, name_buf,
+                                                     sizeof(name_buf), p);
+    }
+    if (!name || name[0] == '\0') {
+        name = JS_AtomGetStrRT(rt, name_buf, sizeof(name_buf),
+                               rt->class_array[p->class_id].class_name);
+    }
+    s->funcs->node(s->opaque, p, type, name, size, p->header.ref_count);
+
+    /* named edges */
+    if (sh->proto)
+        js_heap_walk_edge(s, &sh->proto->header, "property", "__proto__", 0);
+    prs = get_shape_prop(sh);
+    for(i = 0; i < sh->prop_count; i++, prs++) {
+        pr = &p->prop[i];
+        if (prs->atom == JS_ATOM_NULL)
+            continue;
+        name = JS_AtomGetStrRT(rt, name_buf, sizeof(name_buf), prs->atom);
+        switch(prs->flags & JS_PROP_TMASK) {
+        case JS_PROP_NORMAL:
+            js_heap_walk_value_edge(s, pr->u.value, "property", name, 0);
+            break;
+        case JS_PROP_GETSET:
+            snprintf(buf, sizeof(buf), "get %s", name);
+            if (pr->u.getset.getter)
+                js_heap_walk_edge(s, &pr->u.getset.getter->header,
+                                  "property", buf, 0);
+            snprintf(buf, sizeof(buf), "set %s", name);
+            if (pr->u.getset.setter)
+                js_heap_walk_edge(s, &pr->u.getset.setter->header,
+                                  "property", buf, 0);
+            break;
+        case JS_PROP_VARREF:
+            if (pr->u.var_ref->is_detached)
+                js_heap_walk_edge(s, &pr->u.var_ref->header,
+                                  "context", name, 0);
+            break;
+        default:
+            break;
+        }
+    }
+    if (p->fast_array && (p->class_id == JS_CLASS_ARRAY ||
+                          p->class_id == JS_CLASS_ARGUMENTS)) {
+        for(i = 0; i < p->u.array.count; i++) {
+            js_heap_walk_value_edge(s, p->u.array.u.values[i],
+                                    "element", NULL, i);
+        }
+    }
+    if (js_class_has_bytecode(p->class_id)) {
+        JSFunctionBytecode *b = p->u.func.function_bytecode;
+        js_heap_walk_edge(s, &b->header, "internal", "code", 0);
+        if (p->u.func.var_refs) {
+            for(i = 0; i < b->closure_var_count; i++) {
+                JSVarRef *var_ref = p->u.func.var_refs[i];
+                if (var_ref && var_ref->is_detached) {
+                    name = JS_AtomGetStrRT(rt, name_buf, sizeof(name_buf),
+                                           b->closure_var[i].var_name);
+                    js_heap_walk_edge(s, &var_ref->header, "context", name, 0);
+                }
+            }
+        }
+        if (p->u.func.home_object)
+            js_heap_walk_edge(s, &p->u.func.home_object->header,
+                              "internal", "home_object", 0);
+    }
+}
+
+/* JsBridge: report all the GC objects and their references without
+   modifying the heap */
+void JS_WalkHeap(JSRuntime *rt, const JSHeapWalkFuncs *funcs, void *opaque)
+{
+    char name_buf[ATOM_GET_STR_BUF_SIZE];
+    JSHeapWalkState s;
+    struct list_head *el;
+    JSGCObjectHeader *gp;
+    int i;
+
+    s.funcs = funcs;
+    s.opaque = opaque;
+    rt->heap_walk_state = &s;
+
+    list_for_each(el, &rt->gc_obj_list) {
+        gp = list_entry(el, JSGCObjectHeader, link);
+        s.from = gp;
+        switch(gp->gc_obj_type) {
+        case JS_GC_OBJ_TYPE_JS_OBJECT:
+            js_heap_walk_object(rt, &s, (JSObject *)gp);
+            break;
+        case JS_GC_OBJ_TYPE_FUNCTION_BYTECODE:
+            {
+                JSFunctionBytecode *b = (JSFunctionBytecode *)gp;
+                funcs->node(opaque, gp, "code",
+                            JS_AtomGetStrRT(rt, name_buf, sizeof(name_buf),
+                                            b->func_name),
+                            sizeof(JSFunctionBytecode) + b->byte_code_len +
+                            b->cpool_count * sizeof(JSValue),
+                            gp->ref_count);
+                for(i = 0; i < b->cpool_count; i++)
+                    js_heap_walk_value_edge(&s, b->cpool[i], "internal",
+                                            "constant", 0);
+            }
+            break;
+        case JS_GC_OBJ_TYPE_SHAPE:
+            {
+                JSShape *sh = (JSShape *)gp;
+                funcs->node(opaque, gp, "object shape", "(object shape)",
+                            get_shape_size(sh->prop_hash_mask + 1,
+                                           sh->prop_size),
+                            gp->ref_count);
+            }
+            break;
+        case JS_GC_OBJ_TYPE_VAR_REF:
+            funcs->node(opaque, gp, "hidden", "(closure variable)",
+                        sizeof(JSVarRef), gp->ref_count);
+            js_heap_walk_value_edge(&s, *((JSVarRef *)gp)->pvalue,
+                                    "internal", "value", 0);
+            break;
+        case JS_GC_OBJ_TYPE_ASYNC_FUNCTION:
+            funcs->node(opaque, gp, "hidden", "(async function state)",
+                        sizeof(JSAsyncFunctionData), gp->ref_count);
+            break;
+        case JS_GC_OBJ_TYPE_JS_CONTEXT:
+            funcs->node(opaque, gp, "synthetic", "(context)",
+                        sizeof(JSContext), gp->ref_count);
+            js_heap_walk_value_edge(&s, ((JSContext *)gp)->global_obj,
+                                    "property", "global", 0);
+            break;
+        default:
+            funcs->node(opaque, gp, "hidden", "(internal)", 0,
+                        gp->ref_count);
+            break;
+        }
+
+        /* all the references, as seen by the cycle collector */
+        mark_children(rt, gp, js_heap_walk_mark);
+    }
+
+    rt->heap_walk_state = NULL;
+}
+
 JSAtom JS_GetModuleName(JSContext *ctx, JSModuleDef *m)
 {
     return JS_DupAtom(ctx, m->module_name);
@@ -40442,10 +41008,10 @@ static int string_indexof_char(JSString *p, int c, int from)
         }
     } else {
         if ((c & ~0xff) == 0) {
-            for (i = from; i < len; i++) {
-                if (p->u.str8[i] == (uint8_t)c)
-                    return i;
-            }
+            /* JsBridge: memchr() is vectorized by the libc */
+            const uint8_t *q = memchr(p->u.str8 + from, c, len - from);
+            if (q)
+                return q - p->u.str8;
         }
     }
     return -1;
@@ -40524,7 +41090,10 @@ static JSValue js_string_indexOf(JSContext *ctx, JSValueConst this_val,
         inc = 1;
     }
     ret = -1;
-    if (len >= v_len && inc * (stop - start) >= 0) {
+    if (len >= v_len && inc > 0 && stop >= start) {
+        /* JsBridge: search the first char (see string_indexof_char()) */
+        ret = string_indexof(p, p1, start);
+    } else if (len >= v_len && inc * (stop - start) >= 0) {
         for (i = start;; i += inc) {
             if (!string_cmp(p, p1, i, 0, v_len)) {
                 ret = i;
@@ -40590,7 +41159,10 @@ static JSValue js_string_includes(JSContext *ctx, JSValueConst this_val,
         }
         start = stop = pos;
     }
-    if (start >= 0 && start <= stop) {
+    if (start >= 0 && start <= stop && magic == 0) {
+        /* JsBridge: search the first char (see string_indexof_char()) */
+        ret = string_indexof(p, p1, start) >= 0;
+    } else if (start >= 0 && start <= stop) {
         for (i = start;; i++) {
             if (!string_cmp(p, p1, i, 0, v_len)) {
                 ret = 1;
@@ -41206,6 +41778,12 @@ fail:
     return JS_EXCEPTION;
 }
 
+static inline BOOL is_latin1_space(int c)
+{
+    /* same as lre_is_space() for c <= 0xff */
+    return c == 0x20 || (c >= 0x09 && c <= 0x0d) || c == 0xa0;
+}
+
 static JSValue js_string_trim(JSContext *ctx, JSValueConst this_val,
                               int argc, JSValueConst *argv, int magic)
 {
@@ -41219,6 +41797,18 @@ static JSValue js_string_trim(JSContext *ctx, JSValueConst this_val,
     p = JS_VALUE_GET_STRING(str);
     a = 0;
     b = len = p->len;
+    if (!p->is_wide_char) {
+        /* JsBridge: Latin-1 white space without the range table lookup of lre_is_space() */
+        if (magic & 1) {
+            while (a < len && is_latin1_space(p->u.str8[a]))
+                a++;
+        }
+        if (magic & 2) {
+            while (b > a && is_latin1_space(p->u.str8[b - 1]))
+                b--;
+        }
+        goto done;
+    }
     if (magic & 1) {
         while (a < len && lre_is_space(string_get(p, a)))
             a++;
@@ -41227,6 +41817,7 @@ static JSValue js_string_trim(JSContext *ctx, JSValueConst this_val,
         while (b > a && lre_is_space(string_get(p, b - 1)))
             b--;
     }
+ done:
     ret = js_sub_string(ctx, p, a, b);
     JS_FreeValue(ctx, str);
     return ret;
@@ -41311,6 +41902,78 @@ static JSValue js_string_localeCompare(JSContext *ctx, JSValueConst this_val,
     return JS_NewInt32(ctx, cmp);
 }
 
+/* JsBridge: case conversion of a Latin-1 char to a Latin-1 char, or -1 if the converted char is
+   not a single Latin-1 char (i.e. the upper case of U+00B5, U+00DF and U+00FF) */
+static inline int latin1_case_conv(int c, int to_lower)
+{
+    if (to_lower) {
+        if ((unsigned)(c - 'A') < 26 || ((unsigned)(c - 0xc0) < 0x1f && c != 0xd7))
+            c += 0x20;
+    } else {
+        if ((unsigned)(c - 'a') < 26 || ((unsigned)(c - 0xe0) < 0x1f && c != 0xf7))
+            c -= 0x20;
+        else if (c == 0xb5 || c == 0xdf || c == 0xff)
+            return -1;
+    }
+    return c;
+}
+
+/* JsBridge: case conversion of an 8-bit string without the libunicode tables. ASCII chunks are
+   converted with NEON when available. Return a new reference to val if no char is changed or
+   JS_UNDEFINED if the result is not an 8-bit string (then the generic conversion must be used). */
+static JSValue js_string_case_conv8(JSContext *ctx, JSValueConst val, const JSString *p,
+                                    int to_lower)
+{
+    JSString *str;
+    const uint8_t *src = p->u.str8;
+    uint8_t *dst;
+    int i, n, c, len = p->len;
+    BOOL changed = FALSE;
+
+    str = js_alloc_string(ctx, len, 0);
+    if (!str)
+        return JS_EXCEPTION;
+    dst = str->u.str8;
+    for(i = 0; i < len;) {
+#if defined(__ARM_NEON)
+        if (i + 16 <= len) {
+            uint8x16_t v = vld1q_u8(src + i);
+            uint8x8_t hi = vorr_u8(vget_low_u8(v), vget_high_u8(v));
+            if ((vget_lane_u64(vreinterpret_u64_u8(hi), 0) & 0x8080808080808080ULL) == 0) {
+                /* ASCII only: flip the 0x20 bit of the letters of the converted case */
+                uint8x16_t first = vdupq_n_u8(to_lower ? 'A' : 'a');
+                uint8x16_t mask = vcltq_u8(vsubq_u8(v, first), vdupq_n_u8(26));
+                uint8x16_t bits = vandq_u8(mask, vdupq_n_u8(0x20));
+                uint8x8_t m = vorr_u8(vget_low_u8(mask), vget_high_u8(mask));
+                vst1q_u8(dst + i, veorq_u8(v, bits));
+                changed |= vget_lane_u64(vreinterpret_u64_u8(m), 0) != 0;
+                i += 16;
+                continue;
+            }
+        }
+        /* chunk with a non-ASCII char or end of the string */
+        n = min_int(i + 16, len);
+#else
+        n = len;
+#endif
+        for(; i < n; i++) {
+            c = latin1_case_conv(src[i], to_lower);
+            if (c < 0) {
+                js_free_string(ctx->rt, str);
+                return JS_UNDEFINED;
+            }
+            changed |= c != src[i];
+            dst[i] = c;
+        }
+    }
+    if (!changed) {
+        js_free_string(ctx->rt, str);
+        return JS_DupValue(ctx, val);
+    }
+    dst[len] = '\0';
+    return JS_MKPTR(JS_TAG_STRING, str);
+}
+
 static JSValue js_string_toLowerCase(JSContext *ctx, JSValueConst this_val,
                                      int argc, JSValueConst *argv, int to_lower)
 {
@@ -41326,6 +41989,13 @@ static JSValue js_string_toLowerCase(JSContext *ctx, JSValueConst this_val,
     p = JS_VALUE_GET_STRING(val);
     if (p->len == 0)
         return val;
+    if (!p->is_wide_char) {
+        JSValue ret = js_string_case_conv8(ctx, val, p, to_lower);
+        if (!JS_IsUndefined(ret)) {
+            JS_FreeValue(ctx, val);
+            return ret;
+        }
+    }
     if (string_buffer_init(ctx, b, p->len))
         goto fail;
     for(i = 0; i < p->len;) {
@@ -42087,6 +42757,10 @@ static JSValue js_compile_regexp(JSContext *ctx, JSValueConst pattern,
     int re_bytecode_len;
     JSValue ret;
     char error_msg[64];
+    JSRuntime *rt;
+    JSString *p;
+    JSRegExpCacheEntry *e, entry;
+    int cache_index;
 
     re_flags = 0;
     if (!JS_IsUndefined(flags)) {
@@ -42127,6 +42801,24 @@ static JSValue js_compile_regexp(JSContext *ctx, JSValueConst pattern,
         JS_FreeCString(ctx, str);
     }
 
+    /* JsBridge: look up the compiled RegExp cache */
+    rt = ctx->rt;
+    if (rt->regexp_cache_size > 0 && JS_VALUE_GET_TAG(pattern) == JS_TAG_STRING) {
+        p = JS_VALUE_GET_STRING(pattern);
+        for(cache_index = 0; cache_index < rt->regexp_cache_count; cache_index++) {
+            e = &rt->regexp_cache[cache_index];
+            if (e->re_flags == re_flags && e->pattern->len == p->len &&
+                js_string_compare(ctx, e->pattern, p) == 0) {
+                entry = *e;
+                memmove(rt->regexp_cache + 1, rt->regexp_cache, sizeof(entry) * cache_index);
+                rt->regexp_cache[0] = entry;
+                return JS_DupValue(ctx, JS_MKPTR(JS_TAG_STRING, entry.bytecode));
+            }
+        }
+    } else {
+        p = NULL;
+    }
+
     str = JS_ToCStringLen2(ctx, &len, pattern, !(re_flags & LRE_FLAG_UTF16));
     if (!str)
         return JS_EXCEPTION;
@@ -42140,6 +42832,23 @@ static JSValue js_compile_regexp(JSContext *ctx, JSValueConst pattern,
 
     ret = js_new_string8(ctx, re_bytecode_buf, re_bytecode_len);
     js_free(ctx, re_bytecode_buf);
+
+    /* JsBridge: insert the new bytecode as the most recently used entry (evicting the least
+       recently used one if the cache is full) */
+    if (p && !JS_IsException(ret)) {
+        if (rt->regexp_cache_count == rt->regexp_cache_size) {
+            e = &rt->regexp_cache[rt->regexp_cache_count - 1];
+            JS_FreeValueRT(rt, JS_MKPTR(JS_TAG_STRING, e->pattern));
+            JS_FreeValueRT(rt, JS_MKPTR(JS_TAG_STRING, e->bytecode));
+            rt->regexp_cache_count--;
+        }
+        memmove(rt->regexp_cache + 1, rt->regexp_cache, sizeof(entry) * rt->regexp_cache_count);
+        e = &rt->regexp_cache[0];
+        e->pattern = JS_VALUE_GET_STRING(JS_DupValue(ctx, pattern));
+        e->re_flags = re_flags;
+        e->bytecode = JS_VALUE_GET_STRING(JS_DupValue(ctx, ret));
+        rt->regexp_cache_count++;
+    }
     return ret;
 }
 
@@ -46243,12 +46952,6 @@ static const JSCFunctionListEntry js_generator_proto_funcs[] = {
 
 /* Promise */
 
-typedef enum JSPromiseStateEnum {
-    JS_PROMISE_PENDING,
-    JS_PROMISE_FULFILLED,
-    JS_PROMISE_REJECTED,
-} JSPromiseStateEnum;
-
 typedef struct JSPromiseData {
     JSPromiseStateEnum promise_state;
     /* 0=fulfill, 1=reject, list of JSPromiseReactionData.link */
@@ -47108,6 +47811,22 @@ static __exception int perform_promise_then(JSContext *ctx,
     return 0;
 }
 
+int JS_PromiseState(JSContext *ctx, JSValueConst promise)
+{
+    JSPromiseData *s = JS_GetOpaque(promise, JS_CLASS_PROMISE);
+    if (!s)
+        return -1;
+    return s->promise_state;
+}
+
+JSValue JS_PromiseResult(JSContext *ctx, JSValueConst promise)
+{
+    JSPromiseData *s = JS_GetOpaque(promise, JS_CLASS_PROMISE);
+    if (!s)
+        return JS_UNDEFINED;
+    return JS_DupValue(ctx, s->promise_result);
+}
+
 static JSValue js_promise_then(JSContext *ctx, JSValueConst this_val,
                                int argc, JSValueConst *argv)
 {
@@ -51319,6 +52038,12 @@ static JSArrayBuffer *js_get_array_buffer(JSContext *ctx, JSValueConst obj)
     return p->u.array_buffer;
 }
 
+JS_BOOL JS_IsSharedArrayBuffer(JSValueConst obj)
+{
+    return JS_VALUE_GET_TAG(obj) == JS_TAG_OBJECT &&
+        JS_VALUE_GET_OBJ(obj)->class_id == JS_CLASS_SHARED_ARRAY_BUFFER;
+}
+
 /* return NULL if exception. WARNING: any JS call can detach the
    buffer and render the returned pointer invalid */
 uint8_t *JS_GetArrayBuffer(JSContext *ctx, size_t *psize, JSValueConst obj)
@@ -64,6 +64,11 @@ typedef uint32_t JSAtom;
 #define JS_NAN_BOXING
 #endif
 
+/* JsBridge: NaN boxing only keeps 32 bits of the pointers */
+#if defined(JS_NAN_BOXING) && defined(JS_PTR64)
+#error JS_NAN_BOXING is not supported on 64-bit targets
+#endif
+
 enum {
     /* all tags with a reference count are negative */
     JS_TAG_FIRST       = -11, /* first negative tag */
@@ -333,6 +338,10 @@ JSRuntime *JS_NewRuntime(void);
 void JS_SetRuntimeInfo(JSRuntime *rt, const char *info);
 void JS_SetMemoryLimit(JSRuntime *rt, size_t limit);
 void JS_SetGCThreshold(JSRuntime *rt, size_t gc_threshold);
+/* JsBridge: trigger the next GC after the given size has been allocated */
+void JS_SetNextGCAllocationThreshold(JSRuntime *rt, size_t allocation_threshold);
+/* JsBridge: cache the bytecode of the given number of compiled RegExp patterns (0: disabled) */
+void JS_SetRegExpCacheSize(JSRuntime *rt, int size);
 /* use 0 to disable maximum stack size check */
 void JS_SetMaxStackSize(JSRuntime *rt, size_t stack_size);
 /* should be called when changing thread to update the stack top value
@@ -695,6 +704,13 @@ int JS_ToInt64Ext(JSContext *ctx, int64_t *pres, JSValueConst val);
 JSValue JS_NewStringLen(JSContext *ctx, const char *str1, size_t len1);
 JSValue JS_NewString(JSContext *ctx, const char *str);
 JSValue JS_NewAtomString(JSContext *ctx, const char *str);
+/* New string from UTF-16 code units (stored as Latin-1 when possible) */
+JSValue JS_NewStringUTF16(JSContext *ctx, const uint16_t *buf, size_t len);
+/* Return the (borrowed) characters of the string 'val' without conversion:
+   Latin-1 (8 bit) or UTF-16 (16 bit) if '*pis_wide_char' is TRUE. Return
+   NULL if 'val' is not a string. */
+const void *JS_GetStringChars(JSContext *ctx, JSValueConst val, size_t *plen,
+                              JS_BOOL *pis_wide_char);
 JSValue JS_ToString(JSContext *ctx, JSValueConst val);
 JSValue JS_ToPropertyKey(JSContext *ctx, JSValueConst val);
 const char *JS_ToCStringLen2(JSContext *ctx, size_t *plen, JSValueConst val1, JS_BOOL cesu8);
@@ -719,6 +735,13 @@ JS_BOOL JS_SetConstructorBit(JSContext *ctx, JSValueConst func_obj, JS_BOOL val)
 
 JSValue JS_NewArray(JSContext *ctx);
 int JS_IsArray(JSContext *ctx, JSValueConst val);
+/* Return TRUE and the (borrowed) contiguous values if 'val' is a fast
+   array. The values are only valid until the array is modified. */
+JS_BOOL JS_GetFastArray(JSContext *ctx, JSValueConst val, JSValue **parray,
+                        uint32_t *pcount);
+/* Return a new fast array holding the given values, allocated at once
+   (the values are always freed or moved into the array) */
+JSValue JS_NewArrayFrom(JSContext *ctx, uint32_t count, JSValue *values);
 
 JSValue JS_GetPropertyInternal(JSContext *ctx, JSValueConst obj,
                                JSAtom prop, JSValueConst receiver,
@@ -818,6 +841,9 @@ JSValue JS_NewArrayBuffer(JSContext *ctx, uint8_t *buf, size_t len,
 JSValue JS_NewArrayBufferCopy(JSContext *ctx, const uint8_t *buf, size_t len);
 void JS_DetachArrayBuffer(JSContext *ctx, JSValueConst obj);
 uint8_t *JS_GetArrayBuffer(JSContext *ctx, size_t *psize, JSValueConst obj);
+/* return TRUE if obj is a SharedArrayBuffer (JS_GetArrayBuffer() also
+   accepts them) */
+JS_BOOL JS_IsSharedArrayBuffer(JSValueConst obj);
 JSValue JS_GetTypedArrayBuffer(JSContext *ctx, JSValueConst obj,
                                size_t *pbyte_offset,
                                size_t *pbyte_length,
@@ -833,6 +859,19 @@ void JS_SetSharedArrayBufferFunctions(JSRuntime *rt,
 
 JSValue JS_NewPromiseCapability(JSContext *ctx, JSValue *resolving_funcs);
 
+typedef enum JSPromiseStateEnum {
+    JS_PROMISE_PENDING,
+    JS_PROMISE_FULFILLED,
+    JS_PROMISE_REJECTED,
+} JSPromiseStateEnum;
+
+/* Return the JSPromiseStateEnum value of 'promise' or -1 if it is not a
+   native promise. */
+int JS_PromiseState(JSContext *ctx, JSValueConst promise);
+/* Return the fulfillment value or rejection reason of a settled promise
+   (undefined while it is pending). */
+JSValue JS_PromiseResult(JSContext *ctx, JSValueConst promise);
+
 /* is_handled = TRUE means that the rejection is handled */
 typedef void JSHostPromiseRejectionTracker(JSContext *ctx, JSValueConst promise,
                                            JSValueConst reason,
@@ -862,6 +901,10 @@ typedef JSModuleDef *JSModuleLoaderFunc(JSContext *ctx,
 void JS_SetModuleLoaderFunc(JSRuntime *rt,
                             JSModuleNormalizeFunc *module_normalize,
                             JSModuleLoaderFunc *module_loader, void *opaque);
+/* default module filename normalizer (e.g. for a custom normalizer
+   falling back to it) */
+char *JS_DefaultModuleNormalizeName(JSContext *ctx, const char *base_name,
+                                    const char *name);
 /* return the import.meta object of a module */
 JSValue JS_GetImportMeta(JSContext *ctx, JSModuleDef *m);
 JSAtom JS_GetModuleName(JSContext *ctx, JSModuleDef *m);
@@ -873,6 +916,7 @@ int JS_EnqueueJob(JSContext *ctx, JSJobFunc *job_func, int argc, JSValueConst *a
 
 JS_BOOL JS_IsJobPending(JSRuntime *rt);
 int JS_ExecutePendingJob(JSRuntime *rt, JSContext **pctx);
+void JS_FreePendingJobs(JSContext *ctx);
 
 /* Object Writer/Reader (currently only used to handle precompiled code) */
 #define JS_WRITE_OBJ_BYTECODE  (1 << 0) /* allow function/module */
@@ -901,6 +945,31 @@ int JS_ResolveModule(JSContext *ctx, JSValueConst obj);
 
 /* only exported for os.Worker() */
 JSAtom JS_GetScriptOrModuleName(JSContext *ctx, int n_stack_levels);
+
+/* JsBridge: call stack sampling from the interrupt handler (see JsProfiler) */
+typedef struct JSStackFrameInfo {
+    char function_name[64]; /* UTF-8, truncated, "" if unknown */
+    char file_name[64]; /* UTF-8, truncated, "" if unknown (e.g. C function) */
+    int line_number; /* line of the function declaration, 0 if unknown */
+} JSStackFrameInfo;
+int JS_GetStackFrames(JSContext *ctx, JSStackFrameInfo *frames, int max_frames);
+
+/* JsBridge: heap snapshot (see JsHeapSnapshot). The node and edge types are
+   the ones of the Chrome DevTools heap snapshots ("object", "closure",
+   "property", "element"...). The strings are only valid during the call. */
+typedef struct JSHeapWalkFuncs {
+    /* GC object: ref_count also counts the references which are not held
+       by a GC object (e.g. by C code) */
+    void (*node)(void *opaque, const void *ptr, const char *type,
+                 const char *name, size_t self_size, int ref_count);
+    /* named reference between 2 GC objects (name is NULL for elements) */
+    void (*edge)(void *opaque, const void *from, const void *to,
+                 const char *type, const char *name, uint32_t index);
+    /* any reference between 2 GC objects, as counted by the cycle
+       collector */
+    void (*child)(void *opaque, const void *from, const void *to);
+} JSHeapWalkFuncs;
+void JS_WalkHeap(JSRuntime *rt, const JSHeapWalkFuncs *funcs, void *opaque);
 /* only exported for os.Worker() */
 JSModuleDef *JS_RunModule(JSContext *ctx, const char *basename,
                           const char *filename);
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+/**
+ * Process-wide allocation and JNI ref counters of the native library (see
+ * JsBridge.getAllocationStats())
+ *
+ * The counters only increase: the difference of two snapshots gives the allocations done in
+ * between, e.g.: (after - before).nativeAllocations
+ */
+data class JsAllocationStats(
+    // C++ allocations (operator new) of the native library
+    val nativeAllocations: Long,
+
+    // Allocations of the JS engine served by the pool allocator (see
+    // JsBridgeConfig.JsEngineConfig.poolAllocator)
+    val jsEngineAllocations: Long,
+
+    // JNI local and global (including weak) refs created by the threads using the native library
+    val jniLocalRefs: Long,
+    val jniGlobalRefs: Long,
+) {
+    operator fun minus(other: JsAllocationStats) = JsAllocationStats(
+        nativeAllocations = nativeAllocations - other.nativeAllocations,
+        jsEngineAllocations = jsEngineAllocations - other.jsEngineAllocations,
+        jniLocalRefs = jniLocalRefs - other.jniLocalRefs,
+        jniGlobalRefs = jniGlobalRefs - other.jniGlobalRefs,
+    )
+
+    internal companion object {
+        // Number of values given by jniGetAllocationStats() (must match AllocationStats::Counter)
+        private const val VALUE_COUNT = 4
+
+        fun fromLongArray(values: LongArray): JsAllocationStats? {
+            if (values.size < VALUE_COUNT) {
+                return null
+            }
+
+            return JsAllocationStats(
+                nativeAllocations = values[0],
+                jsEngineAllocations = values[1],
+                jniLocalRefs = values[2],
+                jniGlobalRefs = values[3],
+            )
+        }
+    }
+}
@@ -19,19 +19,33 @@
 package de.prosiebensat1digital.oasisjsbridge
 
 import android.app.Activity
+import android.content.ComponentCallbacks2
 import android.content.Context
+import android.content.res.AssetManager
 import android.os.Looper
+import android.os.Trace
 import androidx.annotation.VisibleForTesting
 import de.prosiebensat1digital.oasisjsbridge.JsBridgeError.*
 import de.prosiebensat1digital.oasisjsbridge.extensions.*
+import java.io.File
 import java.io.FileNotFoundException
-import java.io.InputStream
+import java.io.IOException
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
 import java.lang.reflect.Method as JavaMethod
+import java.util.concurrent.ConcurrentLinkedQueue
 import java.util.concurrent.CopyOnWriteArraySet
-import java.util.concurrent.Executors
+import java.util.concurrent.ScheduledFuture
+import java.util.concurrent.ScheduledThreadPoolExecutor
+import java.util.concurrent.ThreadFactory
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicBoolean
 import java.util.concurrent.atomic.AtomicInteger
 import java.util.concurrent.locks.ReentrantLock
+import java.util.concurrent.locks.ReentrantReadWriteLock
+import kotlin.concurrent.read
 import kotlin.concurrent.withLock
+import kotlin.concurrent.write
 import kotlin.coroutines.*
 import kotlin.reflect.*
 import kotlin.reflect.full.createType
@@ -59,12 +73,84 @@ import java.lang.reflect.Proxy
  *
  * @param config JsBridge configuration
  * @param context Context needed for local storage extension
+ * @param sharedRuntimeWith (QuickJS) JsBridge whose JS runtime (and JS thread) is shared: the
+ * JS context is isolated (own globals and extensions) but the atoms, the builtin shapes and the GC
+ * are shared, which cuts the memory needed by each additional instance. The JS engine settings
+ * of the given instance apply to both (see JsBridgeConfig.JsEngineConfig). With Duktape, only the
+ * JS thread is shared.
  */
 class JsBridge
-constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
+@JvmOverloads
+constructor(config: JsBridgeConfig, context: Context, sharedRuntimeWith: JsBridge? = null) : CoroutineScope {
 
     companion object {
+        @Volatile
         private var isLibraryLoaded = false
+
+        // Messages are not bound to any JS context (see JsMessage)
+        internal fun deleteJsMessage(messageHandle: Long) = jniDeleteJsMessage(messageHandle)
+
+        @JvmStatic
+        private external fun jniDeleteJsMessage(messageHandle: Long)
+
+        // Shared buffers are not bound to any JS context (see JsSharedBuffer)
+        internal fun releaseJsSharedBuffer(byteBuffer: ByteBuffer) = jniReleaseJsSharedBuffer(byteBuffer)
+        internal fun waitForJsSharedBufferNotify(byteBuffer: ByteBuffer, notifyCount: Int, timeoutMs: Long) =
+            jniWaitForJsSharedBufferNotify(byteBuffer, notifyCount, timeoutMs)
+
+        @JvmStatic
+        private external fun jniReleaseJsSharedBuffer(byteBuffer: ByteBuffer)
+        @JvmStatic
+        private external fun jniWaitForJsSharedBufferNotify(byteBuffer: ByteBuffer, notifyCount: Int, timeoutMs: Long): Int
+
+        // Command queues are not bound to any JS context (see postJsFunctionCall())
+        @JvmStatic
+        private external fun jniNewJsCommandQueue(): Long
+        @JvmStatic
+        private external fun jniDeleteJsCommandQueue(commandQueueHandle: Long)
+        @JvmStatic
+        private external fun jniPostJsCommand(commandQueueHandle: Long, type: Int, globalName: String, payload: String?): Boolean
+
+        // Parse the given JSON string natively into a Payload, from any thread (falls back to
+        // org.json as long as the native library has not been loaded)
+        internal fun parseJsonPayload(jsonString: String): Payload? {
+            if (jsonString.isEmpty() || jsonString == "null" || jsonString == "undefined") {
+                // Same as Payload.fromJsonString()
+                return null
+            }
+            if (!isLibraryLoaded) {
+                return Payload.fromJsonString(jsonString)
+            }
+
+            val encodedPayload = jniEncodeJsonPayload(jsonString)
+            return PayloadCodec.decode(ByteBuffer.wrap(encodedPayload), true) as Payload?
+        }
+
+        // Not bound to any JS context (see parseJsonPayload())
+        @JvmStatic
+        private external fun jniEncodeJsonPayload(json: String): ByteArray
+
+        // Can be called from any thread (see requestYield())
+        @JvmStatic
+        private external fun jniRequestYield(context: Long)
+        @JvmStatic
+        private external fun jniClearYieldRequest(context: Long)
+
+        /**
+         * Write the profile of the instrumented native library (PGO training run) to the given
+         * .profraw file and return true on success
+         *
+         * Note: always returns false unless the native library has been built with
+         * -Pjsbridge.pgoGenerate=true (see BuildConfig.HAS_PGO_INSTRUMENTATION). The library is
+         * loaded when the first JsBridge instance is started.
+         */
+        fun writeNativeProfile(filePath: String): Boolean {
+            if (!BuildConfig.HAS_PGO_INSTRUMENTATION || !isLibraryLoaded) return false
+            return jniWriteNativeProfile(filePath)
+        }
+
+        @JvmStatic
+        private external fun jniWriteNativeProfile(filePath: String): Boolean
     }
 
     abstract class ErrorListener(val coroutineContext: CoroutineContext? = null) {
@@ -81,31 +167,121 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
     private var state = AtomicInteger(State.Pending.intValue)
     private val currentState get() = State.values().firstOrNull { it.intValue == state.get() }
 
-    // JS coroutine dispatcher (single thread/sequential execution)
-    private val jsDispatcher = Executors.newSingleThreadExecutor().asCoroutineDispatcher()
+    // Single JS thread (sequential execution by priority, see JsCallPriority), possibly shared by
+    // the JsBridge instances sharing the same JS runtime: it is shut down when the last of them has
+    // been released
+    private class JsThread(maxStackSize: Long, onTaskExecuted: () -> Unit) {
+        val executor = object : ScheduledThreadPoolExecutor(1, ThreadFactory { runnable ->
+            Thread(null, runnable, "JsBridge", maxStackSize)
+        }) {
+            override fun afterExecute(r: Runnable?, t: Throwable?) {
+                super.afterExecute(r, t)
+                onTaskExecuted()
+            }
+        }.apply {
+            executeExistingDelayedTasksAfterShutdownPolicy = false
+        }
+        private val userCount = AtomicInteger(1)
+
+        // JsBridge instances asked to yield when interactive work is waiting
+        val jsBridges = CopyOnWriteArraySet<JsBridge>()
+        val dispatcher = JsPriorityDispatcher(
+            executor,
+            onYieldRequested = { jsBridges.forEach { it.requestYield() } },
+            onYieldRequestExpired = { jsBridges.forEach { it.clearYieldRequest() } }
+        )
+
+        fun retain(): JsThread = also { userCount.incrementAndGet() }
+
+        fun release() {
+            if (userCount.decrementAndGet() == 0) {
+                executor.shutdown()
+            }
+        }
+    }
+
+    // JsBridge whose JS runtime is shared (if any). The idle GC is only scheduled by the JsBridge
+    // owning the JS thread (the GC of a shared runtime covers all its contexts).
+    private val sharedRuntimeJsBridge = sharedRuntimeWith
+    private val jsThread = sharedRuntimeWith?.retainJsThread()
+        ?: JsThread(config.jsEngineConfig.maxStackSize, ::onJsTaskExecuted)
+
+    // JS coroutine dispatcher (single thread/sequential execution by priority)
+    private val jsExecutor = jsThread.executor
+    private val jsDispatcher = jsThread.dispatcher
     private var jsThreadId: Long? = null  // for checking thread
 
+    // Idle GC (see JsBridgeConfig.JsEngineConfig.idleGcDelayMs), JS thread only
+    private var lastJsTaskTimeNs = 0L
+    private var idleGcFuture: ScheduledFuture<*>? = null
+    private var isRunningIdleGc = false
+
     // Handle couroutines lifecycle via a Job instance (for structured concurrency)
     private val rootJob = SupervisorJob()
     private val coroutineExceptionHandler = CoroutineExceptionHandler(::handleCoroutineException)
     override val coroutineContext = rootJob + jsDispatcher + coroutineExceptionHandler
 
     private var jniJsContext: Long? = null
+    // Protects the JS context against its deletion while a yield is requested from another thread
+    private val jniJsContextLock = ReentrantReadWriteLock()
+    private var isPromiseQueueTickScheduled = false
+
+    // JsValues waiting to be released in the JS thread (multiple producers, JS thread consumer)
+    private class PendingJsValueRelease(val handles: List<Long>, val globalName: String?)
+    private val pendingJsValueReleases = ConcurrentLinkedQueue<PendingJsValueRelease>()
+    private val isJsValueReleaseDrainScheduled = AtomicBoolean(false)
+
+    // Native queue of commands posted from any thread (see postJsFunctionCall()). The lock only
+    // protects the queue against its deletion.
+    private enum class JsCommandType { CallFunction, AssignValue, DeleteValue }
+    @Volatile
+    private var jsCommandQueueHandle = 0L
+    private val jsCommandQueueLock = ReentrantReadWriteLock()
     var customClassLoader: ClassLoader? = null
         private set
+    private var lazyJavaObjectMethods = false
+    private var sharedJavaObjectPrototypes = false
+
+    // Methods of the registered API interfaces (by interface name, see
+    // resolveJsToJavaInterfaceMethods()), only reflected once per interface
+    // Note: must only be accessed from the JS thread
+    private val jsToJavaInterfaceMethods = mutableMapOf<String, Array<Any>>()
 
     private val errorListeners = CopyOnWriteArraySet<ErrorListener>()
 
+    /**
+     * Duration of the context creation, of each extension installation and of the first file
+     * evaluation (see JsStartupMetrics), updated while the JsBridge is starting
+     */
+    @Volatile
+    var startupMetrics = JsStartupMetrics()
+        private set
+
     // Extensions
     private var jsDebuggerExtension: JsDebuggerExtension? = null
     private var promiseExtension: PromiseExtension? = null
     private var setTimeoutExtension: SetTimeoutExtension? = null
     private var consoleExtension: ConsoleExtension? = null
     private var xhrExtension: XMLHttpRequestExtension? = null
+    private var fetchExtension: FetchExtension? = null
     private var localStorageExtension: LocalStorageExtension? = null
+    private var workerExtension: WorkerExtension? = null
 
     private var internalCounter = AtomicInteger(0)
 
+    // Bytecode cache (only accessed from the JS thread)
+    private var bytecodeCache: JsBytecodeCache? = null
+    private val pendingJsModuleBytecodeKeys = mutableMapOf<String, String>()
+
+    // JS promises waiting to be completed in the next flush (only accessed from the JS thread,
+    // see completeJsPromise())
+    private class PendingJsPromiseCompletion(val promiseObjectHandle: Long, val isFulfilled: Boolean, val value: Any?)
+    private val pendingJsPromiseCompletions = mutableListOf<PendingJsPromiseCompletion>()
+
+    // Parameters of the types returned by evaluate() (only accessed from the JS thread), reused so
+    // that their (lazy) type signature is only computed once per type
+    private val evaluateParameters = mutableMapOf<KType, Parameter>()
+
     // Initialize the JS interpreter
     // - create the JS context via JNI
     // - set up the interpreter with polyfills and helpers (e.g. support for setTimeout)
@@ -134,12 +310,16 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
                 }
 
                 try {
-                    val jniJsContext = createJniJsContext()
+                    val jniJsContext = createJniJsContext(config.jsEngineConfig, config.jvmConfig)
 
                     if (this@JsBridge.jniJsContext != null) {
                         throw InternalError("Cannot create a second JNI context!")
                     }
-                    this@JsBridge.jniJsContext = jniJsContext
+                    jniJsContextLock.write {
+                        this@JsBridge.jniJsContext = jniJsContext
+                    }
+                    jsThread.jsBridges.add(this@JsBridge)
+                    startupMetrics = startupMetrics.withNativeTimings(jniGetStartupTimings(jniJsContext))
                 } catch (t: Throwable) {
                     throw StartError(t)
                 }
@@ -151,26 +331,52 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
 
             // Extensions
             if (config.jsDebuggerConfig.enabled)
-                jsDebuggerExtension = JsDebuggerExtension(this, config.jsDebuggerConfig)
+                jsDebuggerExtension = installExtension("JsDebugger") { JsDebuggerExtension(this, config.jsDebuggerConfig) }
             if (config.promiseConfig.enabled)
-                promiseExtension = PromiseExtension(
-                    context = context,
-                    jsBridge = this@JsBridge,
-                    config = config.promiseConfig
-                )
+                promiseExtension = installExtension("Promise") { PromiseExtension(config.promiseConfig) }
             if (config.setTimeoutConfig.enabled)
-                setTimeoutExtension = SetTimeoutExtension(this@JsBridge)
+                setTimeoutExtension = installExtension("SetTimeout") { SetTimeoutExtension(context, this@JsBridge) }
             if (config.consoleConfig.enabled)
-                consoleExtension = ConsoleExtension(this@JsBridge, config.consoleConfig)
+                consoleExtension = installExtension("Console") { ConsoleExtension(this@JsBridge, config.consoleConfig) }
             if (config.xhrConfig.enabled)
-                xhrExtension = XMLHttpRequestExtension(context, this@JsBridge, config.xhrConfig)
+                xhrExtension = installExtension("XMLHttpRequest") { XMLHttpRequestExtension(context, this@JsBridge, config.xhrConfig) }
+            if (config.fetchConfig.enabled)
+                fetchExtension = installExtension("Fetch") {
+                    FetchExtension(context, this@JsBridge, config.fetchConfig, config.xhrConfig.okHttpClient)
+                }
             if (config.localStorageConfig.enabled)
-                localStorageExtension = LocalStorageExtension(
-                    this@JsBridge,
-                    config.localStorageConfig,
-                    context.applicationContext
-                )
+                localStorageExtension = installExtension("LocalStorage") {
+                    LocalStorageExtension(
+                        this@JsBridge,
+                        config.localStorageConfig,
+                        context.applicationContext
+                    )
+                }
+            if (config.workerConfig.enabled)
+                workerExtension = installExtension("Worker") {
+                    WorkerExtension(context, this@JsBridge, config.workerConfig, config.consoleConfig)
+                }
             config.jvmConfig.customClassLoader?.let { customClassLoader = it }
+            lazyJavaObjectMethods = config.jvmConfig.lazyJavaObjectMethods
+            sharedJavaObjectPrototypes = config.jvmConfig.sharedJavaObjectPrototypes
+            if (config.jvmConfig.typedArrays)
+                launch { jniEnableTypedArrays(jniJsContextOrThrow()) }
+            if (config.jvmConfig.lightJavaObjectMethods)
+                launch { jniEnableLightJavaMethods(jniJsContextOrThrow()) }
+            if (config.jvmConfig.stringCacheSize > 0)
+                launch { jniEnableStringCache(jniJsContextOrThrow(), config.jvmConfig.stringCacheSize) }
+            if (config.jvmConfig.maxJniGlobalRefs > 0)
+                launch { jniSetJniGlobalRefLimit(jniJsContextOrThrow(), config.jvmConfig.maxJniGlobalRefs) }
+            if (config.callTracingConfig.enabled)
+                launch { jniEnableCallTracing(jniJsContextOrThrow()) }
+            if (config.bytecodeCacheConfig.enabled)
+                launch {
+                    val jniJsContext = jniJsContextOrThrow()
+                    val directory = config.bytecodeCacheConfig.directory
+                        ?: File(context.codeCacheDir, "jsbridge-bytecode")
+                    bytecodeCache = JsBytecodeCache(directory, jniGetBytecodeVersion(jniJsContext))
+                    jniEnableBytecodeCache(jniJsContext)
+                }
         }
     }
 
@@ -186,6 +392,254 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
     // Public methods
     // ---
 
+    /**
+     * Run the garbage collector of the JS engine, e.g. when the app goes to background
+     */
+    fun runGc() {
+        launch {
+            val jniJsContext = jniJsContextOrThrow()
+            jniRunGc(jniJsContext)
+        }
+    }
+
+    /**
+     * Give memory back to the system, e.g. from ComponentCallbacks2.onTrimMemory(level): run the
+     * garbage collector and release the native caches (Java types, compiled JS snippets, free
+     * blocks of the pool allocator).
+     *
+     * From TRIM_MEMORY_RUNNING_CRITICAL on, the table of the JsValue handles (and the property
+     * tables of the JS objects on Duktape) are also compacted.
+     */
+    fun onMemoryPressure(level: Int) {
+        launch {
+            val jniJsContext = jniJsContextOrThrow()
+            jniOnMemoryPressure(jniJsContext, level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL)
+        }
+    }
+
+    /**
+     * Change the scheduling of the JS thread, e.g. to raise its priority and move it to the big
+     * cores of a big.LITTLE device while latency-critical scripts are running
+     *
+     * @param niceValue the new nice value (from -20 to 19) or null to keep the current one
+     * @param cpuAffinityMask mask of the CPUs the JS thread may run on (bit 0: CPU 0, ...) or 0 to
+     * keep the current one
+     *
+     * Note: JsBridge instances sharing a JS runtime also share the same JS thread.
+     * Note: raising the priority (negative nice value) may fail without the needed permissions.
+     */
+    suspend fun setJsThreadScheduling(niceValue: Int? = null, cpuAffinityMask: Long = 0L) {
+        withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            jniSetJsThreadScheduling(jniJsContext, niceValue != null, niceValue ?: 0, cpuAffinityMask)
+        }
+    }
+
+    /**
+     * Return the size in bytes of the memory currently allocated by the JS engine, or -1 if it is
+     * unknown (Duktape without the pool allocator, see JsBridgeConfig.jsEngineConfig)
+     */
+    suspend fun getJsHeapSize(): Long {
+        return withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            jniGetJsHeapSize(jniJsContext)
+        }
+    }
+
+    /**
+     * Shrink the property tables of the global object, of its properties (e.g. the objects
+     * registered via registerJavaObject() or registerJsObject()) and of their prototypes to
+     * their current size, e.g. once the startup registrations and evaluations are done (see also
+     * JsBridgeConfig.jsEngineConfig.compactHeapAfterFirstFileEvaluation).
+     *
+     * Return the reclaimed size in bytes or -1 if it is unknown (without the pool allocator, see
+     * JsBridgeConfig.jsEngineConfig)
+     *
+     * Note: only supported on Duktape (no-op returning 0 on QuickJS)
+     */
+    suspend fun compactHeap(): Long {
+        return withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            jniCompactHeap(jniJsContext)
+        }
+    }
+
+    /**
+     * Return the memory statistics of the JS engine and of the bridge, e.g. to track leaks of
+     * JsValue instances or to budget the memory used by multiple JsBridge instances
+     */
+    suspend fun getMemoryUsage(): JsMemoryUsage {
+        return withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            JsMemoryUsage.fromLongArray(jniGetMemoryUsage(jniJsContext))
+        }
+    }
+
+    /**
+     * Return the latency statistics of the traced bridge calls since the JsBridge has been
+     * created or since the last resetCallTraceStats() call
+     *
+     * Note: the list is always empty unless JsBridgeConfig.callTracingConfig is enabled
+     */
+    suspend fun getCallTraceStats(): List<JsCallTraceStats> {
+        return withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            val stats = jniGetCallTraceStats(jniJsContext)
+
+            @Suppress("UNCHECKED_CAST")
+            JsCallTraceStats.fromNativeStats(stats[0] as Array<String>, stats[1] as LongArray)
+        }
+    }
+
+    /**
+     * Clear the latency statistics of the traced bridge calls
+     */
+    fun resetCallTraceStats() {
+        launch {
+            val jniJsContext = jniJsContextOrThrow()
+            jniResetCallTraceStats(jniJsContext)
+        }
+    }
+
+    /**
+     * Start sampling the JS call stack every samplingIntervalUs while JS code is running, e.g. to
+     * find the hot spots of a JS bundle. A running profile is discarded.
+     *
+     * Note: the samples are taken from the interrupt handler (QuickJS) or the execution timeout
+     * check (Duktape) which are only triggered after a few thousands of instructions so the
+     * effective sampling interval can be longer.
+     */
+    fun startJsProfiler(samplingIntervalUs: Long = 1000L) {
+        launch {
+            val jniJsContext = jniJsContextOrThrow()
+            jniStartProfiler(jniJsContext, samplingIntervalUs)
+        }
+    }
+
+    /**
+     * Stop the JS profiler and write the profile to the given file in the .cpuprofile format
+     * (which can be loaded into Chrome DevTools or speedscope)
+     *
+     * Note: the file is empty if the profiler has not been started
+     */
+    suspend fun stopJsProfiler(outputFile: File) {
+        val profile = withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            jniStopProfiler(jniJsContext)
+        }
+
+        withContext(Dispatchers.IO) {
+            outputFile.writeText(profile)
+        }
+    }
+
+    /**
+     * Start recording the bridge traffic: each evaluateString, Java to JS call (method of a JS
+     * proxy or lambda) and Java method called from JS is recorded with its timing and the type and
+     * size of its arguments (not their content), e.g. to replay the traffic of a production
+     * session with JsTrafficReplayer. A running recording is discarded.
+     *
+     * Only 1 out of samplingInterval outermost calls is recorded (with the calls nested into it)
+     * and the recording stops when it reaches maxSizeBytes.
+     */
+    fun startTrafficRecording(samplingInterval: Int = 1, maxSizeBytes: Long = 16L * 1024 * 1024) {
+        launch {
+            val jniJsContext = jniJsContextOrThrow()
+            jniStartTrafficRecording(jniJsContext, samplingInterval, maxSizeBytes)
+        }
+    }
+
+    /**
+     * Stop recording the bridge traffic and write the recording to the given file in a compact
+     * binary format (see JsTrafficRecording)
+     *
+     * Note: the file is empty if the recording has not been started
+     */
+    suspend fun stopTrafficRecording(outputFile: File) {
+        val recording = withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            jniStopTrafficRecording(jniJsContext)
+        }
+
+        withContext(Dispatchers.IO) {
+            outputFile.writeBytes(recording)
+        }
+    }
+
+    /**
+     * Run the garbage collector and write a snapshot of the JS heap to the given file in the
+     * .heapsnapshot format (which can be loaded into the Memory tab of Chrome DevTools), e.g. to
+     * find out what retains the JS objects leaking across evaluations
+     *
+     * Note: the JS values held by the bridge (e.g. JsValue, JS objects proxied to Java) are
+     * reported as retained by a "(JsBridge JsValue table)" node (QuickJS) or by the global stash
+     * (Duktape). Strings are not reported as separate nodes.
+     */
+    suspend fun writeJsHeapSnapshot(outputFile: File) {
+        val snapshot = withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            jniTakeHeapSnapshot(jniJsContext)
+        }
+
+        withContext(Dispatchers.IO) {
+            outputFile.writeText(snapshot)
+        }
+    }
+
+    /**
+     * Return the conversion counters per native type since the JsBridge has been created or since
+     * the last resetConversionStats() call
+     *
+     * Note: the list is always empty unless the native library has been built with
+     * -Pjsbridge.conversionStats=true (see BuildConfig.HAS_CONVERSION_STATS)
+     */
+    suspend fun getConversionStats(): List<JsConversionStats> {
+        return withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            JsConversionStats.fromLongArray(jniGetConversionStats(jniJsContext))
+        }
+    }
+
+    /**
+     * Clear the conversion counters
+     */
+    fun resetConversionStats() {
+        launch {
+            val jniJsContext = jniJsContextOrThrow()
+            jniResetConversionStats(jniJsContext)
+        }
+    }
+
+    /**
+     * Return the current (process-wide) allocation and JNI ref counters, e.g. to compare the
+     * counters before and after an operation
+     *
+     * Note: the counters are always null unless the native library has been built with
+     * -Pjsbridge.allocationStats=true (see BuildConfig.HAS_ALLOCATION_STATS)
+     */
+    suspend fun getAllocationStats(): JsAllocationStats? {
+        return withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            JsAllocationStats.fromLongArray(jniGetAllocationStats(jniJsContext))
+        }
+    }
+
+    /**
+     * Return and clear the console messages as (priority, message) pairs, oldest first
+     *
+     * Note: the list is always empty unless JsBridgeConfig.consoleConfig.ringBufferSize > 0
+     */
+    suspend fun drainConsoleMessages(): List<Pair<Int, String>> {
+        return withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            val messages = jniDrainConsoleMessages(jniJsContext)
+
+            val priorities = messages[0] as IntArray
+            @Suppress("UNCHECKED_CAST")
+            (messages[1] as Array<String>).mapIndexed { i, message -> priorities[i] to message }
+        }
+    }
+
     /**
      * Destroy the JsBridge
      *
@@ -230,13 +684,21 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             }
 
             try {
+                jsThread.jsBridges.remove(this@JsBridge)
                 jniJsContext?.let {
-                    jniJsContext = null
+                    jniJsContextLock.write {
+                        jniJsContext = null
+                    }
                     jniDeleteContext(it)
                 }
             } catch (t: Throwable) {
                 val e = DestroyError(t)
                 throw e
+            } finally {
+                jsCommandQueueLock.write {
+                    if (jsCommandQueueHandle != 0L) jniDeleteJsCommandQueue(jsCommandQueueHandle)
+                    jsCommandQueueHandle = 0L
+                }
             }
 
             jsDebuggerExtension?.release()
@@ -251,8 +713,14 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             xhrExtension?.release()
             xhrExtension = null
 
+            fetchExtension?.release()
+            fetchExtension = null
+
+            workerExtension?.release()
+            workerExtension = null
+
             errorListeners.clear()
-            jsDispatcher.close()
+            jsThread.release()
 
             // Releasing -> Released
             if (!state.compareAndSet(State.Releasing.intValue, State.Released.intValue)) {
@@ -261,6 +729,14 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         }
     }
 
+    // Retain the JS thread for a new JsBridge sharing the JS runtime of this instance
+    private fun retainJsThread(): JsThread = startReleaseLock.withLock {
+        if (state.get() == State.Releasing.intValue || state.get() == State.Released.intValue) {
+            throw StartError(null, "Cannot share the JS runtime of a JsBridge in state $currentState")
+        }
+        jsThread.retain()
+    }
+
     fun registerErrorListener(listener: ErrorListener) {
         errorListeners.add(listener)
     }
@@ -275,6 +751,11 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             return
         }
 
+        if (BuildConfig.HAS_DUKTAPE_PERFORMANCE_PROFILE) {
+            Timber.w("Cannot start JS debugger: no debugger support in the Duktape performance profile.")
+            return
+        }
+
         jsDebuggerExtension.activity = activity
 
         launch {
@@ -319,6 +800,61 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         }
     }
 
+    /**
+     * Set a custom module loader which will return the precompiled bytecode of the given module
+     * (see evaluateFileContentToBytecode()), or null to load its content via the (source) module
+     * loader set with setJsModuleLoader().
+     */
+    private var jsModuleBytecodeLoaderFunc: ((moduleName: String) -> ByteArray?)? = null
+    fun setJsModuleBytecodeLoader(func: (moduleName: String) -> ByteArray?) {
+        jsModuleBytecodeLoaderFunc = func
+
+        launch {
+            val jniJsContext = jniJsContextOrThrow()
+            jniEnableModuleLoader(jniJsContext)
+        }
+    }
+
+    /**
+     * Register the content of several modules at once so that they are loaded natively when they
+     * are imported, without any call to the module loaders. The content is either the UTF-8
+     * source code or, if isBytecode is set, the bytecode returned by evaluateFileContentToBytecode().
+     *
+     * Modules which are not registered are still loaded via setJsModuleLoader() and
+     * setJsModuleBytecodeLoader().
+     *
+     * Note: only supported on QuickJS
+     */
+    fun registerJsModules(modules: Map<String, ByteArray>, isBytecode: Boolean = false) {
+        val names = modules.keys.toTypedArray()
+        val contents = names.map { modules.getValue(it) }.toTypedArray()
+
+        launch {
+            val jniJsContext = jniJsContextOrThrow()
+            jniRegisterJsModules(jniJsContext, names, contents, isBytecode)
+            jniEnableModuleLoader(jniJsContext)
+        }
+    }
+
+    /**
+     * Set a custom module name normalizer which will resolve the name of a module imported from
+     * the given base module (e.g. relative paths).
+     *
+     * The results are memoized natively for each (baseModuleName, moduleName) pair so the
+     * normalizer must always return the same name for the same arguments.
+     *
+     * Note: only supported on QuickJS
+     */
+    private var jsModuleNameNormalizerFunc: ((baseModuleName: String, moduleName: String) -> String)? = null
+    fun setJsModuleNameNormalizer(func: (baseModuleName: String, moduleName: String) -> String) {
+        jsModuleNameNormalizerFunc = func
+
+        launch {
+            val jniJsContext = jniJsContextOrThrow()
+            jniEnableModuleNameNormalizer(jniJsContext)
+        }
+    }
+
     /**
      * Evaluate a local JS file which should be bundled as an asset.
      *
@@ -335,14 +871,21 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             val jniJsContext = jniJsContextOrThrow()
 
             try {
-                val (inputStream, jsFileName) = getInputStream(context, filename, useMaxJs)
-                val jsString = inputStream.bufferedReader().use { it.readText() }
-                jniEvaluateFileContent(
-                    jniJsContext,
-                    jsString,
-                    jsFileName,
-                    type == JsFileEvaluationType.Module
-                )
+                val (assetPath, jsFileName) = getAssetPath(context, filename, useMaxJs)
+                measureFirstFileEvaluation {
+                    if (bytecodeCache == null) {
+                        // The UTF-8 asset content is directly given to the JS engine (no Java String)
+                        jniEvaluateAsset(jniJsContext, context.assets, assetPath, jsFileName, type == JsFileEvaluationType.Module)
+                    } else {
+                        val jsString = context.assets.open(assetPath).bufferedReader().use { it.readText() }
+                        evaluateFileContentWithBytecodeCache(
+                            jniJsContext,
+                            jsString,
+                            jsFileName,
+                            type == JsFileEvaluationType.Module
+                        )
+                    }
+                }
                 Timber.d("-> $filename ($jsFileName) has been successfully evaluated!")
             } catch (t: Throwable) {
                 throw JsFileEvaluationError(filename, t)
@@ -392,12 +935,14 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             val jniJsContext = jniJsContextOrThrow()
 
             try {
-                jniEvaluateFileContent(
-                    jniJsContext,
-                    content,
-                    filename,
-                    type == JsFileEvaluationType.Module
-                )
+                measureFirstFileEvaluation {
+                    evaluateFileContentWithBytecodeCache(
+                        jniJsContext,
+                        content,
+                        filename,
+                        type == JsFileEvaluationType.Module
+                    )
+                }
                 Timber.d("-> file content ($filename) has been successfully evaluated!")
             } catch (t: Throwable) {
                 throw JsFileEvaluationError(filename, t)
@@ -434,37 +979,210 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
     }
 
     /**
-     * Evaluate the given JS code without return value.
+     * Evaluate the content of a JavaScript file and return its compiled bytecode.
+     *
+     * The bytecode can be shipped as a precompiled asset and evaluated via evaluateBytecode() (or
+     * returned by a module loader set with setJsModuleBytecodeLoader()) as long as the JS engine
+     * version does not change.
      */
-    fun evaluateUnsync(js: String) {
-        launch {
+    suspend fun evaluateFileContentToBytecode(
+        content: String,
+        filename: String,
+        type: JsFileEvaluationType = JsFileEvaluationType.Global
+    ): ByteArray {
+        return withContext(coroutineContext) {
             val jniJsContext = jniJsContextOrThrow()
 
-            // Only for debug printing purposes:
-            //val shortJs = if (js.length <= 500) js else js.take(500) + "..."
-            //Timber.v("evaluateNoRetVal(\"$shortJs\")")
-
-            try {
-                jniEvaluateString(jniJsContext, js, null, false)
+            val bytecode = try {
+                jniEvaluateFileContent(
+                    jniJsContext,
+                    content,
+                    filename,
+                    type == JsFileEvaluationType.Module,
+                    true
+                ) ?: throw InternalError("Missing bytecode")
             } catch (t: Throwable) {
-                throw t as? JsStringEvaluationError ?: JsStringEvaluationError(js, t)
+                throw JsFileEvaluationError(filename, t)
             }
 
             processPromiseQueue()
+            bytecode
         }
     }
 
     /**
-     * Evaluate the given JS code and return the value as a Deferred
+     * Evaluate a precompiled JS file (see evaluateFileContentToBytecode()) which should be bundled
+     * as an asset.
+     *
+     * The bytecode can be compressed as an LZ4 frame (e.g. "lz4 file.jsbc file.jsbc.lz4"), in
+     * which case it is decompressed natively into an anonymous memory mapping. The asset is read
+     * without any Java byte array: it should be stored uncompressed in the APK (see noCompress)
+     * so that it can be memory-mapped.
      */
-    fun <T : Any?> evaluateAsync(js: String, type: KType?): Deferred<T> = async {
-        evaluate(js, type, false)
-    }
+    suspend fun evaluateLocalBytecodeFile(context: Context, filename: String) {
+        withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+
+            try {
+                jniEvaluateBytecodeAsset(jniJsContext, context.assets, filename, filename)
+                Timber.d("-> bytecode ($filename) has been successfully evaluated!")
+            } catch (t: Throwable) {
+                throw JsFileEvaluationError(filename, t)
+            }
+
+            processPromiseQueue()
+        }
+    }
+
+    /**
+     * Evaluate a precompiled JS file (see evaluateFileContentToBytecode()) which should be bundled
+     * as an asset.
+     */
+    fun evaluateLocalBytecodeFileUnsync(context: Context, filename: String) {
+        launch {
+            evaluateLocalBytecodeFile(context, filename)
+        }
+    }
+
+    /**
+     * Evaluate a precompiled JS file (see evaluateFileContentToBytecode()) which should be bundled
+     * as an asset (blocking version).
+     */
+    fun evaluateLocalBytecodeFileBlocking(context: Context, filename: String) {
+        runBlocking(coroutineContext) {
+            evaluateLocalBytecodeFile(context, filename)
+        }
+    }
+
+    /**
+     * Compile several JavaScript files (file name -> content) to bytecode in parallel on up to
+     * threadCount worker threads, each one using its own JS runtime, and return their bytecode.
+     *
+     * Nothing is evaluated and the JS thread is not blocked during the compilation so that this
+     * can be used to prepare bundles at cold start. The bytecode can then be given to
+     * evaluateBytecode() or registerJsModules() (with JsFileEvaluationType.Module).
+     *
+     * Note: only supported on QuickJS
+     */
+    suspend fun precompileFileContents(
+        contents: Map<String, String>,
+        type: JsFileEvaluationType = JsFileEvaluationType.Global,
+        threadCount: Int = Runtime.getRuntime().availableProcessors()
+    ): Map<String, ByteArray> {
+        val filenames = contents.keys.toTypedArray()
+        val utf8Contents = filenames.map { contents.getValue(it).toByteArray() }.toTypedArray()
+        val errors = arrayOfNulls<String>(filenames.size)
+
+        val bytecodes = withContext(Dispatchers.Default) {
+            jniPrecompileFileContents(filenames, utf8Contents, type == JsFileEvaluationType.Module, threadCount, errors)
+        }
+
+        return filenames.withIndex().associate { (i, filename) ->
+            val bytecode = bytecodes[i] ?: run {
+                // JS exception message followed by the JS stack trace
+                val error = errors[i].orEmpty()
+                val jsException = JsException(null, error.substringBefore('\n'), error.substringAfter('\n', ""), null)
+                throw JsFileEvaluationError(filename, jsException)
+            }
+            filename to bytecode
+        }
+    }
+
+    /**
+     * Evaluate the bytecode returned by evaluateFileContentToBytecode(), optionally compressed as
+     * an LZ4 frame.
+     */
+    suspend fun evaluateBytecode(bytecode: ByteArray, filename: String) {
+        withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+
+            try {
+                jniEvaluateBytecode(jniJsContext, bytecode, filename)
+                Timber.d("-> bytecode ($filename) has been successfully evaluated!")
+            } catch (t: Throwable) {
+                throw JsFileEvaluationError(filename, t)
+            }
+
+            processPromiseQueue()
+        }
+    }
+
+    /**
+     * Evaluate the bytecode returned by evaluateFileContentToBytecode().
+     */
+    fun evaluateBytecodeUnsync(bytecode: ByteArray, filename: String) {
+        launch {
+            evaluateBytecode(bytecode, filename)
+        }
+    }
+
+    /**
+     * Evaluate the bytecode returned by evaluateFileContentToBytecode() (blocking version).
+     */
+    fun evaluateBytecodeBlocking(bytecode: ByteArray, filename: String) {
+        runBlocking(coroutineContext) {
+            evaluateBytecode(bytecode, filename)
+        }
+    }
+
+    // Evaluate the script of a built-in extension (e.g. "js/timers.js"): its bytecode is cached for
+    // the whole process so that it is only parsed by the first JsBridge instance
+    internal fun evaluateBuiltInAssetUnsync(context: Context, assetPath: String) {
+        launch {
+            val jniJsContext = jniJsContextOrThrow()
+
+            try {
+                jniEvaluateBuiltInAsset(jniJsContext, context.assets, assetPath)
+            } catch (t: Throwable) {
+                throw JsFileEvaluationError(assetPath, t)
+            }
+
+            processPromiseQueue()
+        }
+    }
+
+    /**
+     * Evaluate the given JS code without return value.
+     */
+    fun evaluateUnsync(js: String) {
+        launch {
+            val jniJsContext = jniJsContextOrThrow()
+
+            // Only for debug printing purposes:
+            //val shortJs = if (js.length <= 500) js else js.take(500) + "..."
+            //Timber.v("evaluateNoRetVal(\"$shortJs\")")
+
+            try {
+                jniEvaluateString(jniJsContext, js, null, false)
+            } catch (t: Throwable) {
+                throw t as? JsStringEvaluationError ?: JsStringEvaluationError(js, t)
+            }
+
+            processPromiseQueue()
+        }
+    }
+
+    /**
+     * Evaluate the given JS code and return the value as a Deferred
+     */
+    fun <T : Any?> evaluateAsync(js: String, type: KType?): Deferred<T> = async {
+        evaluate(js, type, false)
+    }
 
     inline fun <reified T : Any?> evaluateAsync(js: String): Deferred<T> {
         return evaluateAsync(js, typeOf<T>())
     }
 
+    /**
+     * Evaluate the given JS code and return its value as a Payload (PayloadObject, PayloadArray or
+     * primitive wrapper): the value is converted to a JSON string in the JS thread, which is then
+     * free for the next calls, and the JSON string is parsed natively in the given dispatcher
+     */
+    fun evaluatePayloadAsync(js: String, parsingDispatcher: CoroutineDispatcher = Dispatchers.Default): Deferred<Payload?> = async(parsingDispatcher) {
+        val jsonObjectWrapper: JsonObjectWrapper? = evaluate(js, typeOf<JsonObjectWrapper?>(), true)
+        jsonObjectWrapper?.let { parseJsonPayload(it.jsonString) }
+    }
+
     suspend inline fun <reified T : Any?> evaluate(js: String): T {
         return evaluate(js, typeOf<T>(), true)
     }
@@ -473,6 +1191,11 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         js: String,
         context: CoroutineContext = EmptyCoroutineContext
     ): T {
+        if (isJsThread()) {
+            // Direct call (e.g. from Java code called by JS): no dispatching and no runBlocking
+            return evaluateDirect(js, typeOf<T>(), true)
+        }
+
         return runBlocking(context) {
             if (isMainThread()) {
                 Timber.w("WARNING: evaluating JS code in the main thread! Consider using non-blocking API or evaluating JS code in another thread!")
@@ -485,6 +1208,10 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
     // - runs in the JS thread and block the caller thread until the result has been evaluated!
     // - from Kotlin, it is recommended to use the method with generic parameter, instead!
     fun evaluateBlocking(js: String, javaClass: Class<*>?): Any? {
+        if (isJsThread()) {
+            return evaluateDirect(js, javaClass?.kotlin?.createType(), false)
+        }
+
         return runBlocking {
             if (isMainThread()) {
                 Timber.w("WARNING: evaluating JS code in the main thread! Consider using non-blocking API or evaluating JS code in another thread!")
@@ -500,19 +1227,15 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
     @PublishedApi
     internal suspend fun <T : Any?> evaluate(js: String, type: KType?, awaitJsPromise: Boolean): T {
         //val initialStackTrace = Thread.currentThread().stackTrace
-        val parameter = type?.let { Parameter(type, customClassLoader) }
-
         val doAwaitJsPromise = awaitJsPromise && type?.classifier != Deferred::class
 
-        val ret = withContext(coroutineContext) {
-            val jniJsContext = jniJsContextOrThrow()
-
-            // Only for debug printing purposes:
-            //val shortJs = if (js.length <= 500) js else js.take(500) + "..."
-            //Timber.v("evaluate(\"$shortJs\")")
+        // Non-null scalar results which cannot be a promise to await are directly returned via
+        // dedicated JNI functions, i.e. without any Parameter
+        val scalarClass = if (!doAwaitJsPromise && type?.isMarkedNullable == false) type.classifier else null
 
+        val ret = withContext(coroutineContext) {
             // Exceptions must be directly caught by the caller
-            var ret = jniEvaluateString(jniJsContext, js, parameter, doAwaitJsPromise)
+            var ret = evaluateInJsThread(js, type, scalarClass, doAwaitJsPromise)
 
             if (doAwaitJsPromise && ret is Deferred<*>) {
                 processPromiseQueue()
@@ -527,6 +1250,64 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         return ret as T
     }
 
+    // Same as evaluate() but directly called from the JS thread (without suspending): a returned
+    // JS promise can only be awaited if it has already been settled
+    @PublishedApi
+    internal fun <T : Any?> evaluateDirect(js: String, type: KType?, awaitJsPromise: Boolean): T {
+        checkJsThread()
+
+        val doAwaitJsPromise = awaitJsPromise && type?.classifier != Deferred::class
+        val scalarClass = if (!doAwaitJsPromise && type?.isMarkedNullable == false) type.classifier else null
+
+        // Exceptions must be directly caught by the caller
+        var ret = evaluateInJsThread(js, type, scalarClass, doAwaitJsPromise)
+        processPromiseQueue()
+
+        if (doAwaitJsPromise && ret is Deferred<*>) {
+            ret = getCompletedDirect(ret, "JS promise")
+        }
+
+        @Suppress("UNCHECKED_CAST")
+        return ret as T
+    }
+
+    private fun evaluateInJsThread(js: String, type: KType?, scalarClass: KClassifier?, doAwaitJsPromise: Boolean): Any? {
+        val jniJsContext = jniJsContextOrThrow()
+
+        // Only for debug printing purposes:
+        //val shortJs = if (js.length <= 500) js else js.take(500) + "..."
+        //Timber.v("evaluate(\"$shortJs\")")
+
+        return when (scalarClass) {
+            Int::class -> jniEvaluateInt(jniJsContext, js)
+            Double::class -> jniEvaluateDouble(jniJsContext, js)
+            Boolean::class -> jniEvaluateBoolean(jniJsContext, js)
+            String::class -> jniEvaluateToString(jniJsContext, js)
+            else -> {
+                val parameter = type?.let { evaluateParameters.getOrPut(it) { Parameter(it, customClassLoader) } }
+                if (doAwaitJsPromise) {
+                    // The value of a fulfilled promise is directly returned and a pending promise
+                    // natively completes the given deferred (which is then returned)
+                    jniEvaluateStringAwaited(jniJsContext, js, parameter, CompletableDeferred())
+                } else {
+                    jniEvaluateString(jniJsContext, js, parameter, false)
+                }
+            }
+        }
+    }
+
+    // Return the result of the given deferred without suspending, which is needed for direct calls
+    // from the JS thread: the JS thread cannot wait for a deferred which has not been completed yet
+    @OptIn(ExperimentalCoroutinesApi::class)
+    private fun <T> getCompletedDirect(deferred: Deferred<T>, name: String): T {
+        if (!deferred.isCompleted) {
+            throw IllegalStateException("Cannot wait for a pending $name in a blocking call from the JS thread")
+        }
+
+        // (also throws the exception of a failed deferred)
+        return deferred.getCompleted()
+    }
+
     // Evaluate the given JS value and return the result as a deferred
     @VisibleForTesting(otherwise = VisibleForTesting.PACKAGE_PRIVATE)
     suspend fun <T : Any?> evaluateJsValue(
@@ -538,6 +1319,13 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         return evaluate("$jsValue", type, awaitJsPromise)
     }
 
+    // Same as evaluateJsValue() but directly called from the JS thread (see evaluateDirect())
+    @PublishedApi
+    internal fun <T : Any?> evaluateJsValueDirect(jsValue: JsValue, type: KType?, awaitJsPromise: Boolean): T {
+        jsValue.codeEvaluationDeferred?.let { getCompletedDirect(it, "JS value evaluation") }
+        return evaluateDirect("$jsValue", type, awaitJsPromise)
+    }
+
     // Evaluate the given JS value and return the result as a deferred
     @PublishedApi
     internal fun <T : Any?> evaluateJsValueAsync(jsValue: JsValue, type: KType?): Deferred<T> =
@@ -545,6 +1333,74 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             evaluateJsValue(jsValue, type, true)
         }
 
+    // Native access to a JsValue (via its handle in the native JsValue table or via its global
+    // name) which does not evaluate any generated JS code (see JsValue.get())
+    //
+    // Read and convert the property with the given key (or, if key is null, the element with the
+    // given index) of a JS object
+    internal suspend fun <T : Any?> getJsValueProperty(jsValue: JsValue, key: String?, index: Int, type: KType): T {
+        val parameter = Parameter(type, customClassLoader)
+        jsValue.codeEvaluationDeferred?.await()
+
+        val ret = withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            jniGetJsValueProperty(jniJsContext, jsValue.nativeHandle, jsValue.assignedJsName, key, index, parameter)
+        }
+
+        @Suppress("UNCHECKED_CAST")
+        return ret as T
+    }
+
+    // Convert and assign the property with the given key (or, if key is null, the element with the
+    // given index) of a JS object
+    internal suspend fun setJsValueProperty(jsValue: JsValue, key: String?, index: Int, value: Any?, type: KType) {
+        val parameter = Parameter(type, customClassLoader)
+        jsValue.codeEvaluationDeferred?.await()
+
+        withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            jniSetJsValueProperty(jniJsContext, jsValue.nativeHandle, jsValue.assignedJsName, key, index, value, parameter)
+        }
+    }
+
+    // Call a method of a JS object (the arguments are converted according to their Java class)
+    internal suspend fun <T : Any?> callJsValueMethod(jsValue: JsValue, methodName: String, args: Array<out Any?>, type: KType): T {
+        val parameter = Parameter(type, customClassLoader)
+        jsValue.codeEvaluationDeferred?.await()
+
+        val ret = withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            val ret = jniCallJsValueMethod(jniJsContext, jsValue.nativeHandle, jsValue.assignedJsName, methodName, arrayOf(*args), parameter)
+            processPromiseQueue()
+            ret
+        }
+
+        @Suppress("UNCHECKED_CAST")
+        return ret as T
+    }
+
+    // Result of the JS typeof operator
+    internal suspend fun getJsValueType(jsValue: JsValue): String {
+        jsValue.codeEvaluationDeferred?.await()
+
+        return withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            jniGetJsValueType(jniJsContext, jsValue.nativeHandle, jsValue.assignedJsName)
+        }
+    }
+
+    // Create the JSON value of a JS error stored in the native JsValue table (see JsException)
+    internal fun getJsExceptionJsonValueBlocking(errorValue: JsValue): String? {
+        if (isJsThread()) {
+            return jniJsContext?.let { jniGetJsExceptionJsonValue(it, errorValue.nativeHandle) }
+        }
+
+        jniJsContext ?: return null
+        return runBlocking(coroutineContext) {
+            jniJsContext?.let { jniGetJsExceptionJsonValue(it, errorValue.nativeHandle) }
+        }
+    }
+
     @VisibleForTesting(otherwise = VisibleForTesting.PACKAGE_PRIVATE)
     fun newJsFunctionAsync(
         jsValue: JsValue,
@@ -586,6 +1442,20 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         return registerJavaToJsInterfaceHelper(jsValue, type, check, true)
     }
 
+    // Register many "JS" interfaces called by Java (see registerJavaToJsInterface()) with a single
+    // dispatch to the JS thread and a single JNI call, e.g. at startup.
+    //
+    // Each registration is a pair of (JS value, interface). The returned proxies are in the same
+    // order as the registrations.
+    @VisibleForTesting(otherwise = VisibleForTesting.PACKAGE_PRIVATE)
+    suspend fun registerJavaToJsInterfaces(
+        registrations: List<Pair<JsValue, KClass<out JavaToJsInterface>>>,
+        check: Boolean
+    ): List<JavaToJsInterface> {
+        @Suppress("UNCHECKED_CAST")
+        return registerJavaToJsInterfacesHelper(registrations, check) as List<JavaToJsInterface>
+    }
+
     // Register a "JS" interface called by Java (blocking)
     //
     // When check = false, the proxy object will be directly returned
@@ -604,6 +1474,23 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         }
     }
 
+    // Register a "JS" interface called by Java via the object returned by createStub (typically a
+    // hand-written or generated implementation of the interface calling the given JavaToJsCaller)
+    // instead of a java.lang.reflect.Proxy
+    @VisibleForTesting(otherwise = VisibleForTesting.PACKAGE_PRIVATE)
+    fun <T : JavaToJsInterface> registerJavaToJsStubBlocking(
+        jsValue: JsValue,
+        type: KClass<T>,
+        check: Boolean,
+        context: CoroutineContext?,
+        createStub: (JavaToJsCaller) -> T
+    ): T {
+
+        return runBlocking(context ?: Dispatchers.Unconfined) {
+            registerJavaToJsInterfaceHelper(jsValue, type, check, waitForRegistration = check, createStub = createStub)
+        }
+    }
+
     // Register a Java interface called by JS.
     //
     // All the Java methods of the given interface can be called in JS as follows:
@@ -633,6 +1520,32 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         return jsValue
     }
 
+    // Register many Java interfaces called by JS (see registerJsToJavaInterface()) with a single
+    // dispatch to the JS thread and a single JNI call, e.g. at startup.
+    //
+    // Each registration is a pair of (API interface, object). The returned proxies are in the same
+    // order as the registrations.
+    @VisibleForTesting(otherwise = VisibleForTesting.PACKAGE_PRIVATE)
+    fun registerJsToJavaInterfaces(
+        registrations: List<Pair<KClass<*>, JsToJavaInterface>>
+    ): List<JsToJavaProxy<JsToJavaInterface>> {
+        val jsValues = registrations.map { (kClass, obj) ->
+            val suffix = internalCounter.incrementAndGet()
+            val jsObjectName = "__jsBridge_${kClass.simpleName ?: "unnamed_class"}$suffix"
+            JsToJavaProxy(this, obj, associatedJsName = jsObjectName)
+        }
+
+        runInJsThread {
+            val jniJsContext = jniJsContextOrThrow()
+            registerJsToJavaInterfacesHelper(
+                jniJsContext,
+                registrations.mapIndexed { index, (kClass, obj) -> Triple(jsValues[index], kClass, obj) }
+            )
+        }
+
+        return jsValues
+    }
+
     // Register a JS lambda from a JsValue.
     //
     // Return a new JsValue which can be used for calling the lambda via callJsLambda()
@@ -690,17 +1603,31 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         val suffix = internalCounter.incrementAndGet()
         val lambdaJsValue = JsValue(this, null, associatedJsName = "__jsBridge_jsLambda$suffix")
 
-        val registerBlock = suspend {
+        val registerDirectBlock = {
             val jniJsContext = jniJsContextOrThrow()
 
-            jsValue.codeEvaluationDeferred?.await()
             jniCopyJsValue(jniJsContext, lambdaJsValue.associatedJsName, jsValue.associatedJsName)
-            jniRegisterJsLambda(jniJsContext, lambdaJsValue.associatedJsName, method)
+            lambdaJsValue.bindingHandles.add(
+                jniRegisterJsLambda(jniJsContext, lambdaJsValue.associatedJsName, method)
+            )
             Timber.v("Registered JS lambda ${lambdaJsValue.associatedJsName}")
             lambdaJsValue.hold()
         }
+        val registerBlock = suspend {
+            jsValue.codeEvaluationDeferred?.await()
+            registerDirectBlock()
+        }
 
-        if (waitForRegistration) {
+        if (isJsThread() && jsValue.codeEvaluationDeferred?.isCompleted != false) {
+            // Direct registration (e.g. from Java code called by JS): no dispatching and the
+            // lambda can directly be called
+            jsValue.codeEvaluationDeferred?.let { getCompletedDirect(it, "JS value evaluation") }
+            try {
+                registerDirectBlock()
+            } catch (t: Throwable) {
+                throw t as? JsException ?: JavaToJsFunctionRegistrationError(jsValue.associatedJsName, t)
+            }
+        } else if (waitForRegistration) {
             // Synchronous registration
             withContext(coroutineContext) {
                 registerBlock()
@@ -733,8 +1660,7 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             lambdaJsValue.codeEvaluationDeferred?.await()
 
             // Exceptions must be directly caught by the caller
-            var ret =
-                jniCallJsLambda(jniJsContext, lambdaJsValue.associatedJsName, args, awaitJsPromise)
+            var ret = callRegisteredJsLambda(jniJsContext, lambdaJsValue, args, awaitJsPromise)
 
             if (awaitJsPromise && ret is Deferred<*>) {
                 processPromiseQueue()
@@ -746,6 +1672,64 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         }
     }
 
+    // Call a JS lambda registered via registerJsLambda() once for each given argument array, in a
+    // single native call (if bound) and processing the promise queue only once
+    @PublishedApi
+    internal suspend fun callJsLambdaBatch(
+        lambdaJsValue: JsValue,
+        argsArray: Array<Array<Any?>>,
+        awaitJsPromise: Boolean
+    ): Array<Any?> {
+        return withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+
+            lambdaJsValue.codeEvaluationDeferred?.await()
+
+            // Exceptions must be directly caught by the caller
+            val bindingHandle = lambdaJsValue.bindingHandles.firstOrNull()
+            val rets = if (bindingHandle != null) {
+                jniCallJsLambdaBatch(jniJsContext, bindingHandle, argsArray, awaitJsPromise)
+            } else {
+                Array(argsArray.size) { i ->
+                    jniCallJsLambda(jniJsContext, lambdaJsValue.associatedJsName, argsArray[i], awaitJsPromise)
+                }
+            }
+
+            processPromiseQueue()
+
+            if (awaitJsPromise && rets.any { it is Deferred<*> }) {
+                for (i in rets.indices) {
+                    (rets[i] as? Deferred<*>)?.let { rets[i] = it.await() }
+                }
+                processPromiseQueue()
+            }
+
+            rets
+        }
+    }
+
+    // Same as callJsLambda() but directly called from the JS thread (see evaluateDirect())
+    @PublishedApi
+    internal fun callJsLambdaDirect(
+        lambdaJsValue: JsValue,
+        args: Array<Any?>,
+        awaitJsPromise: Boolean
+    ): Any? {
+        checkJsThread()
+
+        val jniJsContext = jniJsContextOrThrow()
+        lambdaJsValue.codeEvaluationDeferred?.let { getCompletedDirect(it, "JS value evaluation") }
+
+        // Exceptions must be directly caught by the caller
+        var ret = callRegisteredJsLambda(jniJsContext, lambdaJsValue, args, awaitJsPromise)
+        processPromiseQueue()
+
+        if (awaitJsPromise && ret is Deferred<*>) {
+            ret = getCompletedDirect(ret, "JS promise")
+        }
+        return ret
+    }
+
     // Directly call a registered JS lambda. It only works when being called from the JS thread!
     internal fun callJsLambdaUnsafe(
         lambdaJsValue: JsValue,
@@ -755,7 +1739,23 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         checkJsThread()
 
         val jniJsContext = jniJsContextOrThrow()
-        return jniCallJsLambda(jniJsContext, lambdaJsValue.associatedJsName, args, awaitJsPromise)
+        return callRegisteredJsLambda(jniJsContext, lambdaJsValue, args, awaitJsPromise)
+    }
+
+    // Call a JS lambda registered via registerJsLambda(), directly via its native binding if
+    // available
+    private fun callRegisteredJsLambda(
+        jniJsContext: Long,
+        lambdaJsValue: JsValue,
+        args: Array<Any?>,
+        awaitJsPromise: Boolean
+    ): Any? {
+        val bindingHandle = lambdaJsValue.bindingHandles.firstOrNull()
+        return if (bindingHandle != null) {
+            jniCallJsLambdaBinding(jniJsContext, bindingHandle, args, awaitJsPromise)
+        } else {
+            jniCallJsLambda(jniJsContext, lambdaJsValue.associatedJsName, args, awaitJsPromise)
+        }
     }
 
     @VisibleForTesting(otherwise = VisibleForTesting.PACKAGE_PRIVATE)
@@ -809,13 +1809,116 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         }
     }
 
+    /**
+     * Post a call of the given JS function with the given JSON-encoded argument array (e.g.
+     * "[1, \"two\"]") without waiting for its execution and ignoring its return value.
+     *
+     * Posted commands can be sent from any thread without suspending and without any dispatch
+     * per command: a burst of commands is executed in a single JS-thread task and JNI call. They
+     * are executed in the order in which they have been posted. Errors are reported to the error
+     * listeners.
+     */
+    fun postJsFunctionCall(functionName: String, jsonArgs: String? = null) =
+        postJsCommand(JsCommandType.CallFunction, functionName, jsonArgs)
+
+    /**
+     * Post the assignment of the evaluated JS code to the given global JS variable (see
+     * postJsFunctionCall()).
+     */
+    fun postJsValueAssignment(globalName: String, jsCode: String) =
+        postJsCommand(JsCommandType.AssignValue, globalName, jsCode)
+
+    /**
+     * Post the deletion of the given global JS variable (see postJsFunctionCall()).
+     */
+    fun postJsValueDeletion(globalName: String) =
+        postJsCommand(JsCommandType.DeleteValue, globalName, null)
+
+    private fun postJsCommand(type: JsCommandType, globalName: String, payload: String?) {
+        val needsDrain = jsCommandQueueLock.read {
+            val jsCommandQueueHandle = jsCommandQueueHandle
+            if (jsCommandQueueHandle == 0L) null
+            else jniPostJsCommand(jsCommandQueueHandle, type.ordinal, globalName, payload)
+        }
+
+        when (needsDrain) {
+            // Queue not created yet: post the command after the JS context creation
+            null -> launch {
+                if (jsCommandQueueHandle != 0L) postJsCommand(type, globalName, payload)
+            }
+
+            // Only one JS-thread task for all the commands posted until it runs
+            true -> launch {
+                processJsCommands()
+            }
+
+            false -> Unit
+        }
+    }
+
+    private fun processJsCommands() {
+        val jniJsContext = jniJsContext ?: return
+
+        try {
+            jniProcessJsCommands(jniJsContext, jsCommandQueueHandle)
+        } catch (t: Throwable) {
+            throw t as? JsBridgeError ?: JavaToJsCallError("<posted JS commands>", t)
+        } finally {
+            processPromiseQueue()
+        }
+    }
+
+    // Queue the release of a JsValue. Finalizers of many JsValues typically run in bursts, so the
+    // pending releases are collected in a lock-free queue and processed in batches on the JS
+    // thread (one JNI call per batch instead of one per released value).
     internal fun deleteJsValue(jsValue: JsValue) {
-        val globalName = jsValue.associatedJsName
+        val handles = jsValue.bindingHandles.toMutableList()
+        if (jsValue.nativeHandle != 0L) handles.add(jsValue.nativeHandle)
+        val pendingRelease = PendingJsValueRelease(handles, jsValue.assignedJsName)
         val codeEvaluationDeferred = jsValue.codeEvaluationDeferred
 
-        launch {
-            codeEvaluationDeferred?.await()
-            jniJsContext?.let { jniDeleteJsValue(it, globalName) }
+        if (codeEvaluationDeferred != null && !codeEvaluationDeferred.isCompleted) {
+            launch {
+                codeEvaluationDeferred.await()
+                pendingJsValueReleases.add(pendingRelease)
+                processPendingJsValueReleases()
+            }
+            return
+        }
+
+        pendingJsValueReleases.add(pendingRelease)
+        if (isJsValueReleaseDrainScheduled.compareAndSet(false, true)) {
+            launch {
+                isJsValueReleaseDrainScheduled.set(false)
+                processPendingJsValueReleases()
+            }
+        }
+    }
+
+    // Release all the queued JsValues with a single JNI call
+    private fun processPendingJsValueReleases() {
+        checkJsThread()
+
+        if (pendingJsValueReleases.isEmpty()) return
+        val jniJsContext = jniJsContext ?: return
+
+        val handles = mutableListOf<Long>()
+        val globalNames = mutableListOf<String>()
+        while (true) {
+            val pendingRelease = pendingJsValueReleases.poll() ?: break
+            handles.addAll(pendingRelease.handles)
+            pendingRelease.globalName?.let { globalNames.add(it) }
+        }
+
+        if (handles.isEmpty() && globalNames.isEmpty()) return
+        jniReleaseJsValues(jniJsContext, handles.toLongArray(), globalNames.toTypedArray())
+    }
+
+    // Assign a JsValue stored in the native JsValue table to its global JS variable. When called
+    // outside of the JS thread, the assignment is queued before any subsequent JS operation.
+    internal fun copyJsValueHandle(globalNameTo: String, nativeHandle: Long) {
+        runInJsThread {
+            jniJsContext?.let { jniCopyJsValueHandle(it, globalNameTo, nativeHandle) }
         }
     }
 
@@ -828,6 +1931,138 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         }
     }
 
+    /**
+     * Serialize the given JS value (structured clone) into a message which can be read by other
+     * JsBridge instances via receiveMessage() without any JSON round-trip.
+     *
+     * Note: only supported on QuickJS
+     */
+    suspend fun createMessage(jsValue: JsValue): JsMessage {
+        return withContext(coroutineContext) {
+            jsValue.codeEvaluationDeferred?.await()
+            createMessageInJsThread(jsValue)
+        }
+    }
+
+    // Create a message from a JS value which has already been evaluated (e.g. a parameter of a
+    // JS-to-Java call) without suspending
+    internal fun createMessageInJsThread(jsValue: JsValue): JsMessage {
+        val jniJsContext = jniJsContextOrThrow()
+        return JsMessage(jniWriteJsMessage(jniJsContext, jsValue.associatedJsName))
+    }
+
+    /**
+     * Deserialize a message created by any JsBridge instance (see createMessage()) into a new
+     * JsValue of this instance.
+     *
+     * Note: only supported on QuickJS
+     */
+    suspend fun receiveMessage(message: JsMessage): JsValue {
+        val jsValue = JsValue(this)
+
+        withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            jniReadJsMessage(jniJsContext, jsValue.associatedJsName, message.nativeHandle)
+        }
+
+        return jsValue
+    }
+
+    /**
+     * Copy the given JS value into the target JsBridge instance via a native message (see
+     * createMessage()) and return the received JsValue of the target instance.
+     *
+     * Note: only supported on QuickJS
+     */
+    suspend fun postMessage(jsValue: JsValue, target: JsBridge): JsValue {
+        val message = createMessage(jsValue)
+        try {
+            return target.receiveMessage(message)
+        } finally {
+            message.release()
+        }
+    }
+
+    /**
+     * Create a SharedArrayBuffer of the given size whose memory is shared with a direct
+     * ByteBuffer, e.g. to stream high-frequency data between Kotlin and JS without a bridge call
+     * per message (see JsSharedBuffer)
+     *
+     * Note: only supported on QuickJS
+     */
+    suspend fun newJsSharedBuffer(size: Int): JsSharedBuffer {
+        val jsValue = JsValue(this)
+
+        val byteBuffer = withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            jniNewJsSharedBuffer(jniJsContext, jsValue.associatedJsName, size)
+        }
+
+        return JsSharedBuffer(this, jsValue, byteBuffer.order(ByteOrder.nativeOrder()))
+    }
+
+    // Call the onnotify() method of the shared buffer in the JS thread (see JsSharedBuffer.notifyJs())
+    internal fun notifyJsSharedBuffer(sharedBuffer: JsSharedBuffer) {
+        launch {
+            sharedBuffer.onJsNotifyDispatched()
+
+            val jniJsContext = jniJsContextOrThrow()
+            jniNotifyJsSharedBuffer(jniJsContext, sharedBuffer.jsValue.associatedJsName)
+            processPromiseQueue()
+        }
+    }
+
+    /**
+     * Serialize the given JS value graph (e.g. the state of an idle JsBridge) into a snapshot file
+     * which can be restored via readSnapshot(), even by another JsBridge instance after a restart
+     * of the app.
+     *
+     * This allows to hibernate a JsBridge holding a large heap: write a snapshot of its state,
+     * release() it and, when needed again, create a new JsBridge (re-evaluating its code, e.g.
+     * via the bytecode cache) and restore its state from the snapshot.
+     *
+     * Note: only plain data (including object references, Date, RegExp, typed arrays...) can be
+     * serialized, i.e. no functions, no Java objects and no SharedArrayBuffers.
+     * Note: only supported on QuickJS
+     */
+    suspend fun writeSnapshot(jsValue: JsValue, outputFile: File) {
+        val snapshot = withContext(coroutineContext) {
+            jsValue.codeEvaluationDeferred?.await()
+            val jniJsContext = jniJsContextOrThrow()
+            jniWriteJsSnapshot(jniJsContext, jsValue.associatedJsName)
+        }
+
+        withContext(Dispatchers.IO) {
+            // Write into a temporary file first so that a partially written snapshot is never read
+            val tmpFile = File(outputFile.path + ".tmp")
+            tmpFile.writeBytes(snapshot)
+            if (!tmpFile.renameTo(outputFile)) {
+                tmpFile.delete()
+                throw IOException("Cannot write JS snapshot to $outputFile")
+            }
+        }
+    }
+
+    /**
+     * Deserialize a JS snapshot file (see writeSnapshot()) into a new JsValue of this instance.
+     *
+     * Note: a snapshot written by another QuickJS version cannot be read
+     * Note: only supported on QuickJS
+     */
+    suspend fun readSnapshot(inputFile: File): JsValue {
+        val snapshot = withContext(Dispatchers.IO) {
+            inputFile.readBytes()
+        }
+
+        val jsValue = JsValue(this)
+        withContext(coroutineContext) {
+            val jniJsContext = jniJsContextOrThrow()
+            jniReadJsSnapshot(jniJsContext, jsValue.associatedJsName, snapshot)
+        }
+
+        return jsValue
+    }
+
     @PublishedApi
     internal fun convertJavaValueToJs(value: Any?, parameter: Parameter): JsValue {
         val jsValue = JsValue(this)
@@ -840,21 +2075,95 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         return jsValue
     }
 
+    // Parse the UTF-8 JSON contained in the given buffer (from its position to its limit) into
+    // a new JsValue. A direct buffer is directly read by the native side, other buffers are
+    // first copied into a direct buffer.
+    //
+    // Note: the buffer must not be modified until the JsValue has been evaluated
+    internal fun parseJsonBuffer(jsonBuffer: ByteBuffer): JsValue {
+        val directBuffer = if (jsonBuffer.isDirect) {
+            jsonBuffer
+        } else {
+            // Extra zero byte: see JsValue.fromJson(InputStream)
+            ByteBuffer.allocateDirect(jsonBuffer.remaining() + 1).put(jsonBuffer.duplicate()).apply { flip() }
+        }
+        val offset = directBuffer.position()
+        val length = directBuffer.remaining()
+
+        val jsValue = JsValue(this)
+        jsValue.codeEvaluationDeferred = async {
+            val jniJsContext = jniJsContextOrThrow()
+            jniParseJsonBuffer(jniJsContext, jsValue.associatedJsName, directBuffer, offset, length)
+        }
+
+        return jsValue
+    }
+
+    // Create a new JsValue from the given direct buffer (from its position to its limit), either
+    // as an ArrayBuffer or (if asUtf8String is set) as a decoded UTF-8 string
+    //
+    // Note: the buffer must not be modified afterwards as the ArrayBuffer might share its memory
+    internal fun newJsValueFromDirectBuffer(directBuffer: ByteBuffer, asUtf8String: Boolean): JsValue {
+        require(directBuffer.isDirect) { "The buffer must be a direct buffer" }
+        val offset = directBuffer.position()
+        val length = directBuffer.remaining()
+
+        val jsValue = JsValue(this)
+        jsValue.codeEvaluationDeferred = async {
+            val jniJsContext = jniJsContextOrThrow()
+            jniAssignDirectBuffer(jniJsContext, jsValue.associatedJsName, directBuffer, offset, length, asUtf8String)
+        }
+
+        return jsValue
+    }
+
+    // Install the native localStorage persisted in the given file, adding the given items if
+    // their key is not stored yet (see LocalStorageExtension)
+    internal fun enableLocalStorage(file: File, initialItems: Map<String, String>) {
+        checkJsThread()
+
+        val jniJsContext = jniJsContextOrThrow()
+        jniEnableLocalStorage(jniJsContext, file.path, initialItems.keys.toTypedArray(), initialItems.values.toTypedArray())
+    }
+
+    internal fun enableConsole(config: JsBridgeConfig.ConsoleConfig) {
+        checkJsThread()
+
+        val jniJsContext = jniJsContextOrThrow()
+        jniEnableConsole(jniJsContext, config.mode.ordinal, config.minPriority, config.ringBufferSize)
+    }
+
     // Simulate a "Promise" tick. Needs to be manually triggered as we don't use an event loop.
     internal fun processPromiseQueue() {
-        val promiseExtension = promiseExtension ?: return
-
         checkJsThread()
 
-        if (promiseExtension.config.needsPolyfill) {
-            // Manually process promise queue of the polyfill
-            promiseExtension.processPolyfillQueue()
-        } else {
-            // Run pending jobs of the JS engine with built-in promise support
-            jniJsContext?.let { jniProcessPromiseQueue(it) }
+        // Also release the JsValues which have been collected in the meantime
+        processPendingJsValueReleases()
+
+        val promiseExtension = promiseExtension ?: return
+
+        // Run pending jobs of the JS engine
+        val jniJsContext = jniJsContext ?: return
+        val config = promiseExtension.config
+        val hasPendingJobs = jniProcessPromiseQueue(jniJsContext, config.maxJobsPerTick, config.maxTickDurationMs)
+        if (hasPendingJobs && !isPromiseQueueTickScheduled) {
+            // Budget exhausted => continue after the JS-thread tasks which are already queued
+            isPromiseQueueTickScheduled = true
+            launch {
+                isPromiseQueueTickScheduled = false
+                processPromiseQueue()
+            }
         }
     }
 
+    // Return true if some jobs of the JS engine (e.g. promise reactions) are waiting for the next
+    // promise queue tick
+    internal fun hasPendingPromiseJobs(): Boolean {
+        checkJsThread()
+        val jniJsContext = jniJsContext ?: return false
+        return jniIsJobPending(jniJsContext)
+    }
+
     // Called by JsDebuggerExtension
     internal fun cancelDebug() {
         launch {
@@ -881,7 +2190,7 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
 
     // Create the JNI/JS context and return a Deferred which is rejected with a
     // JsBridgeError in case of error
-    private fun createJniJsContext(): Long {
+    private fun createJniJsContext(jsEngineConfig: JsBridgeConfig.JsEngineConfig, jvmConfig: JsBridgeConfig.JvmConfig): Long {
         checkJsThread()
 
         if (!isLibraryLoaded) {
@@ -895,25 +2204,215 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
                 )
                 throw e
             }
-            isLibraryLoaded = true
+            isLibraryLoaded = true
+        }
+
+        val jniJsContext = jniCreateContext(
+            jsEngineConfig.maxStackSize,
+            jsEngineConfig.memoryLimit,
+            jsEngineConfig.gcThreshold,
+            jsEngineConfig.regExpCacheSize,
+            jsEngineConfig.poolAllocator,
+            jsEngineConfig.executionTimeoutMs,
+            jvmConfig.preloadJniCache,
+            sharedRuntimeJsBridge?.let { it.jniJsContext ?: throw InternalError("Cannot share the JS runtime of a JsBridge which has not been started") } ?: 0L
+        )
+
+        if (jniJsContext == 0L) {
+            throw InternalError("Cannot create the JS context (out of memory)!")
+        }
+
+        if (jsEngineConfig.jsThreadNiceValue != null || jsEngineConfig.jsThreadCpuAffinityMask != 0L) {
+            jniSetJsThreadScheduling(
+                jniJsContext,
+                jsEngineConfig.jsThreadNiceValue != null,
+                jsEngineConfig.jsThreadNiceValue ?: 0,
+                jsEngineConfig.jsThreadCpuAffinityMask
+            )
+        }
+
+        jsCommandQueueLock.write {
+            jsCommandQueueHandle = jniNewJsCommandQueue()
+        }
+
+        return jniJsContext
+    }
+
+    // Ask the running JS work to yield at its next safe point (called from any thread when
+    // interactive work is waiting, see JsPriorityDispatcher)
+    private fun requestYield() {
+        jniJsContextLock.read {
+            jniJsContext?.let { jniRequestYield(it) }
+        }
+    }
+
+    // Drop the yield request which has not been consumed by the task it was meant for (JS thread)
+    private fun clearYieldRequest() {
+        jniJsContextLock.read {
+            jniJsContext?.let { jniClearYieldRequest(it) }
+        }
+    }
+
+    // Called in the JS thread after each task of the JS dispatcher
+    private fun onJsTaskExecuted() {
+        if (isRunningIdleGc) {
+            // The idle GC task itself
+            isRunningIdleGc = false
+            return
+        }
+
+        val idleGcDelayMs = config.jsEngineConfig.idleGcDelayMs
+        if (idleGcDelayMs <= 0L || jniJsContext == null || jsExecutor.isShutdown) {
+            return
+        }
+
+        lastJsTaskTimeNs = System.nanoTime()
+        if (idleGcFuture == null) {
+            idleGcFuture = jsExecutor.schedule(::runIdleGc, idleGcDelayMs, TimeUnit.MILLISECONDS)
+        }
+    }
+
+    // Run the GC if no other task has been executed in the JS thread for idleGcDelayMs or wait
+    // for the remaining time otherwise
+    private fun runIdleGc() {
+        isRunningIdleGc = true
+        idleGcFuture = null
+
+        val jniJsContext = jniJsContext ?: return
+        val jsEngineConfig = config.jsEngineConfig
+        val idleMs = TimeUnit.NANOSECONDS.toMillis(System.nanoTime() - lastJsTaskTimeNs)
+        if (idleMs < jsEngineConfig.idleGcDelayMs) {
+            idleGcFuture = jsExecutor.schedule(::runIdleGc, jsEngineConfig.idleGcDelayMs - idleMs, TimeUnit.MILLISECONDS)
+            return
+        }
+
+        try {
+            jniRunIdleGc(jniJsContext, jsEngineConfig.idleGcAllocationThreshold)
+        } catch (t: Throwable) {
+            Timber.w(t, "Idle GC failed")
+        }
+    }
+
+    // Install an extension and measure the time spent by the JS thread on the tasks launched by its
+    // creation (the JS thread runs them sequentially between the two markers)
+    private inline fun <T> installExtension(name: String, create: () -> T): T {
+        var startTime = 0L
+        launch {
+            Trace.beginSection("JsBridge extension $name")
+            startTime = System.nanoTime()
+        }
+
+        try {
+            return create()
+        } finally {
+            launch {
+                val durationNs = System.nanoTime() - startTime
+                Trace.endSection()
+                startupMetrics = startupMetrics.copy(
+                    extensionInstallationNs = startupMetrics.extensionInstallationNs + (name to durationNs)
+                )
+            }
+        }
+    }
+
+    // Measure the given file evaluation if it is the first one
+    private inline fun measureFirstFileEvaluation(evaluate: () -> Unit) {
+        checkJsThread()
+
+        if (startupMetrics.firstFileEvaluationNs >= 0L) {
+            evaluate()
+            return
+        }
+
+        Trace.beginSection("JsBridge first file evaluation")
+        val startTime = System.nanoTime()
+        try {
+            evaluate()
+        } finally {
+            val durationNs = System.nanoTime() - startTime
+            Trace.endSection()
+            startupMetrics = startupMetrics.copy(firstFileEvaluationNs = durationNs)
+        }
+
+        if (config.jsEngineConfig.compactHeapAfterFirstFileEvaluation) {
+            jniJsContext?.let { jniJsContext ->
+                val reclaimedSize = jniCompactHeap(jniJsContext)
+                Timber.d("JS heap compacted after the first file evaluation ($reclaimedSize bytes reclaimed)")
+            }
+        }
+    }
+
+    // Evaluate the given file content via its cached bytecode (if the bytecode cache is enabled
+    // and the same content has already been evaluated), fill the cache otherwise
+    private fun evaluateFileContentWithBytecodeCache(
+        jniJsContext: Long,
+        content: String,
+        filename: String,
+        asModule: Boolean
+    ) {
+        val bytecodeCache = bytecodeCache
+        if (bytecodeCache == null) {
+            jniEvaluateFileContent(jniJsContext, content, filename, asModule, false)
+            return
+        }
+
+        val key = bytecodeCache.getKey(content)
+        bytecodeCache.get(key)?.let { bytecode ->
+            try {
+                jniEvaluateBytecode(jniJsContext, bytecode, filename)
+                return
+            } catch (e: IllegalArgumentException) {
+                // The bytecode could not be read (and nothing has been evaluated) => use the source
+                Timber.w(e, "Ignoring cached bytecode of $filename")
+                bytecodeCache.remove(key)
+            }
         }
 
-        return jniCreateContext()
+        jniEvaluateFileContent(jniJsContext, content, filename, asModule, true)
+            ?.let { bytecodeCache.put(key, it) }
     }
 
+    // Return the module content as a String (source code) or a ByteArray (bytecode)
     @Suppress("UNUSED")  // Called from JNI
-    private fun callJsModuleLoader(moduleName: String): String {
+    private fun callJsModuleLoader(moduleName: String): Any {
+        // Note: it is perfectly fine if the functions throw an exception
+        // (it will be properly caught by JNI and thrown as a JS exception)
+        jsModuleBytecodeLoaderFunc?.invoke(moduleName)?.let { return it }
+
+        val content = jsModuleLoaderFunc?.invoke(moduleName)
+            ?: throw IllegalArgumentException("Cannot load JS module $moduleName: missing module loader")
+
+        val bytecodeCache = bytecodeCache ?: return content
+        val key = bytecodeCache.getKey(content)
+        bytecodeCache.get(key)?.let { return it }
+
+        // The bytecode will be given back via storeJsModuleBytecode() after compilation
+        pendingJsModuleBytecodeKeys[moduleName] = key
+        return content
+    }
+
+    @Suppress("UNUSED")  // Called from JNI
+    private fun callJsModuleNameNormalizer(baseModuleName: String, moduleName: String): String {
         // Note: it is perfectly fine if the function throws an exception
         // (it will be properly caught by JNI and thrown as a JS exception)
-        return jsModuleLoaderFunc!!(moduleName)
+        val normalizer = jsModuleNameNormalizerFunc
+            ?: throw IllegalArgumentException("Cannot normalize JS module $moduleName: missing module name normalizer")
+        return normalizer(baseModuleName, moduleName)
+    }
+
+    @Suppress("UNUSED")  // Called from JNI
+    private fun storeJsModuleBytecode(moduleName: String, bytecode: ByteArray) {
+        val key = pendingJsModuleBytecodeKeys.remove(moduleName) ?: return
+        bytecodeCache?.put(key, bytecode)
     }
 
     @Throws
-    private fun getInputStream(
+    // Return the path of the asset to evaluate and its JS file name
+    private fun getAssetPath(
         context: Context,
         filename: String,
         useMaxJs: Boolean
-    ): Pair<InputStream, String> {
+    ): Pair<String, String> {
         if (filename.contains("""\.max\.js$""".toRegex())) {
             throw Throwable(".max.js file should not be directly set, use .js and set useMaxJs parameter to true instead!")
         }
@@ -923,16 +2422,16 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             try {
                 val maxFilename = filename.replace("""\.js$""".toRegex(), ".max.js")
                 Timber.v("Checking availability of $maxFilename...")
-                val ret = context.assets.open(maxFilename)
+                context.assets.open(maxFilename).close()
                 Timber.d("$maxFilename found and will be used instead of $filename")
-                return Pair(ret, maxFilename.substringAfterLast("/"))
+                return Pair(maxFilename, maxFilename.substringAfterLast("/"))
             } catch (e: FileNotFoundException) {
                 // Ignore error
             }
         }
 
         Timber.d("Reading $filename...")
-        return Pair(context.assets.open(filename), filename.substringAfterLast("/"))
+        return Pair(filename, filename.substringAfterLast("/"))
     }
 
     @Throws(JsToJavaRegistrationError::class)
@@ -944,6 +2443,47 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
     ) {
         checkJsThread()
 
+        val (prototypeName, methods) = resolveJsToJavaInterfaceMethods(type, obj)
+        try {
+            jniRegisterJavaObject(jniJsContext, jsValue.associatedJsName, obj, prototypeName, methods, lazyJavaObjectMethods)
+        } catch (t: Throwable) {
+            throw JsToJavaRegistrationError(type, t)
+        }
+    }
+
+    // Register all the given Java objects with a single JNI call
+    @Throws(JsToJavaRegistrationError::class)
+    private fun registerJsToJavaInterfacesHelper(
+        jniJsContext: Long,
+        registrations: List<Triple<JsValue, KClass<*>, Any>>
+    ) {
+        checkJsThread()
+
+        // The methods are only reflected once per API interface (see resolveJsToJavaInterfaceMethods())
+        val resolvedMethods = registrations.map { (_, type, obj) -> resolveJsToJavaInterfaceMethods(type, obj) }
+
+        try {
+            jniRegisterJavaObjects(
+                jniJsContext,
+                Array(registrations.size) { registrations[it].first.associatedJsName },
+                Array(registrations.size) { registrations[it].third },
+                Array(registrations.size) { resolvedMethods[it].first },
+                Array(registrations.size) { resolvedMethods[it].second },
+                lazyJavaObjectMethods
+            )
+        } catch (t: Throwable) {
+            throw JsToJavaRegistrationError(
+                JsToJavaInterface::class,
+                t,
+                customMessage = "Error while registering ${registrations.size} Java interfaces"
+            )
+        }
+    }
+
+    // Return the prototype name (empty if the methods must not be shared via a JS prototype) and
+    // the methods of the API interface of the given object
+    @Throws(JsToJavaRegistrationError::class)
+    private fun resolveJsToJavaInterfaceMethods(type: KClass<*>, obj: Any): Pair<String, Array<Any>> {
         // Pick up the most "bottom" interface which implements JsToJaveInterface (or android.os.IInterface)
         val apiInterface = findApiInterface(obj::class.java)
             ?: throw JsToJavaRegistrationError(
@@ -958,6 +2498,13 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             )
         }
 
+        // The objects of the same API interface share the same methods (and, with
+        // sharedJavaObjectPrototypes, the same JS prototype on QuickJS)
+        var prototypeName = apiInterface.name
+        jsToJavaInterfaceMethods[prototypeName]?.let { methods ->
+            return Pair(if (sharedJavaObjectPrototypes) prototypeName else "", methods)
+        }
+
         val methods = linkedMapOf<String, Method>()
 
         try {
@@ -979,6 +2526,7 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             // Fallback to Java reflection. This is unfortunately still needed (latest check: 1.3.40)
             // because Kotlin throws an exception when reflecting lambdas (function objects)
             Timber.w("Cannot reflect object of type $type (exception: $t) using Kotlin reflection! Falling back to Java reflection...")
+            prototypeName = ""  // the methods of the given type are neither cached nor shared
 
             for (javaMethod in type.java.methods) {
                 val method = Method(javaMethod, customClassLoader)
@@ -991,16 +2539,11 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             }
         }
 
-        try {
-            jniRegisterJavaObject(
-                jniJsContext,
-                jsValue.associatedJsName,
-                obj,
-                methods.values.toTypedArray()
-            )
-        } catch (t: Throwable) {
-            throw JsToJavaRegistrationError(type, t)
+        val methodArray: Array<Any> = methods.values.toTypedArray()
+        if (prototypeName.isNotEmpty()) {
+            jsToJavaInterfaceMethods[prototypeName] = methodArray
         }
+        return Pair(if (sharedJavaObjectPrototypes) prototypeName else "", methodArray)
     }
 
     private fun findApiInterface(clazz: Class<*>): Class<*>? {
@@ -1016,13 +2559,105 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
     // - If async = true, the proxy object is returned directly (the registration will be
     // done asynchronously)
     // - If async = false, the proxy object is only returned after a successful registration
+    // - If createStub is set, it creates the returned object instead of a java.lang.reflect.Proxy
     @Throws
     private suspend fun <T : Any> registerJavaToJsInterfaceHelper(
         jsValue: JsValue,
         type: KClass<T>,
         check: Boolean,
-        waitForRegistration: Boolean
+        waitForRegistration: Boolean,
+        createStub: ((JavaToJsCaller) -> T)? = null
     ): T {
+        val methods = collectJavaToJsInterfaceMethods(type)
+
+        // The methods are identified by their index in the registered array
+        val caller = JavaToJsCaller(jsValue, type.java.name, methods.map { it.name }, methods.map { it.javaMethod }, methods.map { it.hasPackableParameters })
+
+        val registerBlock = suspend {
+            jsValue.codeEvaluationDeferred?.await()
+            registerJsObjectDirect(jsValue, caller, methods.toTypedArray(), check)
+        }
+
+        if (isJsThread() && jsValue.codeEvaluationDeferred?.isCompleted != false) {
+            // Direct registration (e.g. from Java code called by JS): no dispatching
+            jsValue.codeEvaluationDeferred?.let { getCompletedDirect(it, "JS value evaluation") }
+            try {
+                registerJsObjectDirect(jsValue, caller, methods.toTypedArray(), check)
+            } catch (t: Throwable) {
+                throw t as? JsException ?: JavaToJsInterfaceRegistrationError(type, cause = t)
+            }
+        } else if (waitForRegistration) {
+            // Synchronous registration
+            withContext(coroutineContext) {
+                registerBlock()
+            }
+        } else {
+            // Asynchronous registration
+            launchInJsThread {
+                try {
+                    registerBlock()
+                } catch (t: Throwable) {
+                    throw JavaToJsInterfaceRegistrationError(type, cause = t)
+                }
+            }
+        }
+
+        if (createStub != null) {
+            return createStub(caller)
+        }
+
+        @Suppress("UNCHECKED_CAST")
+        return createJavaToJsProxy(jsValue, type, caller) as T
+    }
+
+    // Register many "JS" interfaces called by Java with a single dispatch to the JS thread and a
+    // single JNI call, e.g. at startup. The returned proxies are in the same order as the
+    // registrations.
+    @Throws
+    private suspend fun registerJavaToJsInterfacesHelper(
+        registrations: List<Pair<JsValue, KClass<*>>>,
+        check: Boolean
+    ): List<Any> {
+        val types = registrations.map { it.second }
+        val methods = types.map { collectJavaToJsInterfaceMethods(it) }
+        val callers = registrations.mapIndexed { index, (jsValue, type) ->
+            JavaToJsCaller(jsValue, type.java.name, methods[index].map { it.name }, methods[index].map { it.javaMethod }, methods[index].map { it.hasPackableParameters })
+        }
+        val jsValues = registrations.map { it.first }
+
+        val registerBlock = suspend {
+            jsValues.forEach { it.codeEvaluationDeferred?.await() }
+            registerJsObjectsDirect(jsValues, callers, methods.map { it.toTypedArray() }, check)
+        }
+
+        if (isJsThread() && jsValues.all { it.codeEvaluationDeferred?.isCompleted != false }) {
+            // Direct registration (e.g. from Java code called by JS): no dispatching
+            jsValues.forEach { jsValue ->
+                jsValue.codeEvaluationDeferred?.let { getCompletedDirect(it, "JS value evaluation") }
+            }
+            try {
+                registerJsObjectsDirect(jsValues, callers, methods.map { it.toTypedArray() }, check)
+            } catch (t: Throwable) {
+                throw t as? JsException ?: JavaToJsInterfaceRegistrationError(
+                    JavaToJsInterface::class,
+                    cause = t,
+                    customMessage = "Error while registering ${registrations.size} JS interfaces"
+                )
+            }
+        } else {
+            withContext(coroutineContext) {
+                registerBlock()
+            }
+        }
+
+        return registrations.mapIndexed { index, (jsValue, type) ->
+            createJavaToJsProxy(jsValue, type, callers[index])
+        }
+    }
+
+    // Collect the methods of a "JS" interface called by Java (and of its super interfaces)
+    @Throws(JavaToJsInterfaceRegistrationError::class)
+    private fun collectJavaToJsInterfaceMethods(type: KClass<*>): Collection<Method> {
         if (!type.java.isInterface) {
             throw JavaToJsInterfaceRegistrationError(
                 type,
@@ -1033,7 +2668,7 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         // Only allow interface directly implementing JsToJavaInterface (or implementing an interface implementing
         // JsToJavaInterface)
         // => Sequence<KClass<*>>
-        val interfaces = generateSequence(type as KClass<*>) { previousClassifier ->
+        val interfaces = generateSequence(type) { previousClassifier ->
             // Single parent interface
             previousClassifier
                 // Type -> Sequence<KType>
@@ -1060,7 +2695,7 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
                 .takeIf { it != JavaToJsInterface::class }
         }
 
-        val methods = interfaces
+        return interfaces
             // Collect all member functions of all interfaces
             // -> Sequence<KFunction<*>>
             .flatMap { it.declaredMemberFunctions.asSequence() }
@@ -1081,66 +2716,86 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
 
             // => Sequence<Method>
             .values
+    }
 
-        if (waitForRegistration) {
-            // Synchronous registration
-            withContext(coroutineContext) {
-                jsValue.codeEvaluationDeferred?.await()
-                jniRegisterJsObject(
-                    jniJsContextOrThrow(),
-                    jsValue.associatedJsName,
-                    methods.toTypedArray(),
-                    check
-                )
-            }
-        } else {
-            // Asynchronous registration
-            launchInJsThread {
-                try {
-                    jsValue.codeEvaluationDeferred?.await()
-                    jniRegisterJsObject(
-                        jniJsContextOrThrow(),
-                        jsValue.associatedJsName,
-                        methods.toTypedArray(),
-                        check
-                    )
-                } catch (t: Throwable) {
-                    throw JavaToJsInterfaceRegistrationError(type, cause = t)
-                }
-            }
-        }
-
-        // Create proxy listener for the JS object
-        val proxyListener = ProxyListener(jsValue, type.java)
-
-        @Suppress("UNCHECKED_CAST")
+    private fun createJavaToJsProxy(jsValue: JsValue, type: KClass<*>, caller: JavaToJsCaller): Any {
         val proxy = Proxy.newProxyInstance(
             customClassLoader ?: type.java.classLoader,
             arrayOf(type.java),
-            proxyListener
-        ) as T
+            ProxyListener(jsValue, caller)
+        )
         Timber.v("Created proxy instance for ${type.java.name}, js value name: $jsValue")
 
         return proxy
     }
 
-    // Call a JS method registered via registerJavaToJsInterface()
+    private fun registerJsObjectDirect(jsValue: JsValue, caller: JavaToJsCaller, methods: Array<Method>, check: Boolean) {
+        val bindingHandle = jniRegisterJsObject(jniJsContextOrThrow(), jsValue.associatedJsName, methods, check)
+        jsValue.bindingHandles.add(bindingHandle)
+        caller.bindingHandle = bindingHandle
+    }
+
+    private fun registerJsObjectsDirect(jsValues: List<JsValue>, callers: List<JavaToJsCaller>, methods: List<Array<Method>>, check: Boolean) {
+        val bindingHandles = jniRegisterJsObjects(
+            jniJsContextOrThrow(),
+            Array(jsValues.size) { jsValues[it].associatedJsName },
+            methods.toTypedArray(),
+            check
+        )
+        bindingHandles.forEachIndexed { index, bindingHandle ->
+            jsValues[index].bindingHandles.add(bindingHandle)
+            callers[index].bindingHandle = bindingHandle
+        }
+    }
+
+    // Call a JS method registered via registerJavaToJsInterface(), directly via its native binding
+    // if available
     @Throws
     private fun callJsMethod(
-        name: String,
-        method: JavaMethod,
+        jsValue: JsValue,
+        bindingHandle: Long,
+        methodIndex: Int,
         args: Array<Any?>,
-        awaitJsPromise: Boolean
+        awaitJsPromise: Boolean,
+        hasPackableArgs: Boolean = false
     ): Any? {
         checkJsThread()
 
         val jniJsContext = jniJsContextOrThrow()
-        val retVal = jniCallJsMethod(jniJsContext, name, method, args, awaitJsPromise)
+        val retVal = if (bindingHandle != 0L && hasPackableArgs) {
+            jniCallJsMethodBindingPacked(jniJsContext, bindingHandle, methodIndex, packJsMethodArgs(args), awaitJsPromise)
+        } else if (bindingHandle != 0L) {
+            jniCallJsMethodBinding(jniJsContext, bindingHandle, methodIndex, args, awaitJsPromise)
+        } else {
+            jniCallJsMethod(jniJsContext, jsValue.associatedJsName, methodIndex, args, awaitJsPromise)
+        }
 
         processPromiseQueue()
         return retVal
     }
 
+    // Pack the (primitive) arguments of a JS method call into a long[] which is read with a single
+    // JNI call: floating-point values are given as the raw bits of a double
+    private fun packJsMethodArgs(args: Array<Any?>): LongArray {
+        return LongArray(args.size) { i ->
+            when (val arg = args[i]) {
+                is Int -> arg.toLong()
+                is Long -> arg
+                is Double -> arg.toRawBits()
+                is Float -> arg.toDouble().toRawBits()
+                is Boolean -> if (arg) 1L else 0L
+                is Short -> arg.toLong()
+                is Byte -> arg.toLong()
+                else -> throw IllegalArgumentException("Cannot pack JS method argument: $arg")
+            }
+        }
+    }
+
+    @Suppress("UNUSED")  // Called from JNI
+    private fun appendConsoleMessage(priority: Int, message: String) {
+        consoleExtension?.config?.appendMessage?.invoke(priority, message)
+    }
+
     @Suppress("UNUSED")  // Called from JNI
     private fun onDebuggerPending() {
         checkJsThread()
@@ -1237,10 +2892,8 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
     }
 
     @Suppress("UNUSED")  // Called from JNI
-    private fun setUpJsPromise(id: String, deferred: Deferred<Any>) {
+    private fun setUpJsPromise(promiseObjectHandle: Long, deferred: Deferred<Any>) {
         launch {
-            val jniJsContext = jniJsContextOrThrow()
-
             var isFulfilled = false
 
             val promiseValue = try {
@@ -1258,8 +2911,41 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
                 t
             }
 
-            jniCompleteJsPromise(jniJsContext, id, isFulfilled, promiseValue)
-            processPromiseQueue()
+            completeJsPromise(promiseObjectHandle, isFulfilled, promiseValue)
+        }
+    }
+
+    // Queue the completion of a JS promise (JS thread only). The promises completed during the
+    // same dispatch (e.g. many network results landing together) are completed via a single JNI
+    // call, followed by a single promise queue drain.
+    private fun completeJsPromise(promiseObjectHandle: Long, isFulfilled: Boolean, value: Any?) {
+        pendingJsPromiseCompletions.add(PendingJsPromiseCompletion(promiseObjectHandle, isFulfilled, value))
+        if (pendingJsPromiseCompletions.size > 1) {
+            // Flush already scheduled
+            return
+        }
+
+        launch {
+            val completions = pendingJsPromiseCompletions.toList()
+            pendingJsPromiseCompletions.clear()
+
+            try {
+                val jniJsContext = jniJsContextOrThrow()
+                if (completions.size == 1) {
+                    val completion = completions[0]
+                    jniCompleteJsPromise(jniJsContext, completion.promiseObjectHandle, completion.isFulfilled, completion.value)
+                } else {
+                    jniCompleteJsPromises(
+                        jniJsContext,
+                        LongArray(completions.size) { completions[it].promiseObjectHandle },
+                        BooleanArray(completions.size) { completions[it].isFulfilled },
+                        Array(completions.size) { completions[it].value }
+                    )
+                }
+            } finally {
+                // Also run the jobs of the promises which have been completed before the error
+                processPromiseQueue()
+            }
         }
     }
 
@@ -1269,6 +2955,11 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         notifyErrorListeners(e)
     }
 
+    @Suppress("UNUSED")  // Called from JNI
+    private fun notifyJsExecutionTimeout(timeoutMs: Long) {
+        notifyErrorListeners(JsExecutionTimeoutError(timeoutMs))
+    }
+
     private fun launchInJsThread(block: suspend () -> Unit) {
         launch {
             block()
@@ -1306,11 +2997,54 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
 
 
     // JNI functions
-    private external fun jniCreateContext(): Long
+    private external fun jniCreateContext(maxStackSize: Long, memoryLimit: Long, gcThreshold: Long, regExpCacheSize: Int, poolAllocator: Boolean, executionTimeoutMs: Long, preloadJniCache: Boolean, sharedRuntimeContext: Long): Long
     private external fun jniStartDebugger(context: Long, port: Int)
     private external fun jniCancelDebug(context: Long)
     private external fun jniDeleteContext(context: Long)
+    private external fun jniRunGc(context: Long)
+    private external fun jniRunIdleGc(context: Long, allocationThreshold: Long)
+    private external fun jniOnMemoryPressure(context: Long, critical: Boolean)
+    private external fun jniSetJsThreadScheduling(context: Long, setNiceValue: Boolean, niceValue: Int, cpuAffinityMask: Long)
+    private external fun jniGetJsHeapSize(context: Long): Long
+    private external fun jniGetMemoryUsage(context: Long): LongArray
+    private external fun jniCompactHeap(context: Long): Long
+    private external fun jniEnableCallTracing(context: Long)
+    private external fun jniGetCallTraceStats(context: Long): Array<Any>
+    private external fun jniResetCallTraceStats(context: Long)
+    private external fun jniGetStartupTimings(context: Long): LongArray
+    private external fun jniStartProfiler(context: Long, samplingIntervalUs: Long)
+    private external fun jniStopProfiler(context: Long): String
+    private external fun jniStartTrafficRecording(context: Long, samplingInterval: Int, maxSizeBytes: Long)
+    private external fun jniStopTrafficRecording(context: Long): ByteArray
+    private external fun jniTakeHeapSnapshot(context: Long): String
+    private external fun jniGetConversionStats(context: Long): LongArray
+    private external fun jniResetConversionStats(context: Long)
+    private external fun jniGetAllocationStats(context: Long): LongArray
     private external fun jniEnableModuleLoader(context: Long)
+    private external fun jniRegisterJsModules(context: Long, names: Array<String>, contents: Array<ByteArray>, isBytecode: Boolean)
+    private external fun jniEnableModuleNameNormalizer(context: Long)
+    private external fun jniEnableTypedArrays(context: Long)
+    private external fun jniEnableLightJavaMethods(context: Long)
+    private external fun jniEnableStringCache(context: Long, entryCount: Int)
+    private external fun jniSetJniGlobalRefLimit(context: Long, limit: Int)
+    private external fun jniEnableConsole(context: Long, mode: Int, minPriority: Int, ringBufferSize: Int)
+    private external fun jniDrainConsoleMessages(context: Long): Array<Any>
+    private external fun jniEnableLocalStorage(context: Long, filePath: String, initialKeys: Array<String>, initialValues: Array<String>)
+    private external fun jniEnableBytecodeCache(context: Long)
+    private external fun jniGetBytecodeVersion(context: Long): String
+    private external fun jniWriteJsMessage(context: Long, globalName: String): Long
+    private external fun jniNewJsSharedBuffer(context: Long, globalName: String, size: Int): ByteBuffer
+    private external fun jniNotifyJsSharedBuffer(context: Long, globalName: String)
+    private external fun jniReadJsMessage(context: Long, globalName: String, messageHandle: Long)
+    private external fun jniWriteJsSnapshot(context: Long, globalName: String): ByteArray
+    private external fun jniReadJsSnapshot(context: Long, globalName: String, snapshot: ByteArray)
+    private external fun jniPrecompileFileContents(
+        fileNames: Array<String>,
+        contents: Array<ByteArray>,
+        asModule: Boolean,
+        threadCount: Int,
+        errors: Array<String?>
+    ): Array<ByteArray?>
     private external fun jniGetCurrentScriptOrModuleName(context: Long, level: Int): String
     private external fun jniEvaluateString(
         context: Long,
@@ -1318,20 +3052,55 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         type: Parameter?,
         awaitJsPromise: Boolean
     ): Any?
+    private external fun jniEvaluateStringAwaited(
+        context: Long,
+        js: String,
+        type: Parameter?,
+        awaitingDeferred: CompletableDeferred<Any?>
+    ): Any?
+
+    private external fun jniEvaluateInt(context: Long, js: String): Int
+    private external fun jniEvaluateDouble(context: Long, js: String): Double
+    private external fun jniEvaluateBoolean(context: Long, js: String): Boolean
+    private external fun jniEvaluateToString(context: Long, js: String): String?
 
     private external fun jniEvaluateFileContent(
         context: Long,
         js: String,
         filename: String,
+        asModule: Boolean,
+        returnBytecode: Boolean
+    ): ByteArray?
+
+    private external fun jniEvaluateAsset(
+        context: Long,
+        assetManager: AssetManager,
+        assetPath: String,
+        filename: String,
         asModule: Boolean
     )
 
+    private external fun jniEvaluateBuiltInAsset(context: Long, assetManager: AssetManager, assetPath: String)
+    private external fun jniEvaluateBytecode(context: Long, bytecode: ByteArray, filename: String)
+    private external fun jniEvaluateBytecodeAsset(context: Long, assetManager: AssetManager, assetPath: String, filename: String)
+
     private external fun jniRegisterJavaLambda(context: Long, name: String, obj: Any, method: Any)
     private external fun jniRegisterJavaObject(
         context: Long,
         name: String,
         obj: Any,
-        methods: Array<Any>
+        prototypeName: String,
+        methods: Array<Any>,
+        lazyMethods: Boolean
+    )
+
+    private external fun jniRegisterJavaObjects(
+        context: Long,
+        names: Array<String>,
+        objects: Array<Any>,
+        prototypeNames: Array<String>,
+        methods: Array<Array<Any>>,
+        lazyMethods: Boolean
     )
 
     private external fun jniRegisterJsObject(
@@ -1339,23 +3108,38 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         name: String,
         methods: Array<out Any>,
         check: Boolean
-    )
+    ): Long
 
-    private external fun jniRegisterJsLambda(context: Long, name: String, method: Any)
+    private external fun jniRegisterJsObjects(
+        context: Long,
+        names: Array<String>,
+        methods: Array<out Array<out Any>>,
+        check: Boolean
+    ): LongArray
+
+    private external fun jniRegisterJsLambda(context: Long, name: String, method: Any): Long
     private external fun jniCallJsMethod(
         context: Long,
         objectName: String,
-        javaMethod: JavaMethod,
-        args: Array<Any?>
+        methodIndex: Int,
+        args: Array<Any?>,
+        awaitJsPromise: Boolean
     ): Any?
 
-    private external fun jniCallJsMethod(
+    private external fun jniCallJsMethodBinding(
         context: Long,
-        objectName: String,
-        javaMethod: JavaMethod,
+        bindingHandle: Long,
+        methodIndex: Int,
         args: Array<Any?>,
         awaitJsPromise: Boolean
     ): Any?
+    private external fun jniCallJsMethodBindingPacked(
+        context: Long,
+        bindingHandle: Long,
+        methodIndex: Int,
+        packedArgs: LongArray,
+        awaitJsPromise: Boolean
+    ): Any?
 
     private external fun jniCallJsLambda(
         context: Long,
@@ -1364,8 +3148,21 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         awaitJsPromise: Boolean
     ): Any?
 
+    private external fun jniCallJsLambdaBinding(
+        context: Long,
+        bindingHandle: Long,
+        args: Array<Any?>,
+        awaitJsPromise: Boolean
+    ): Any?
+
+    private external fun jniCallJsLambdaBatch(
+        context: Long,
+        bindingHandle: Long,
+        argsArray: Array<Array<Any?>>,
+        awaitJsPromise: Boolean
+    ): Array<Any?>
+
     private external fun jniAssignJsValue(context: Long, globalName: String, jsCode: String)
-    private external fun jniDeleteJsValue(context: Long, globalName: String)
     private external fun jniCopyJsValue(context: Long, globalNameTo: String, globalNameFrom: String)
     private external fun jniNewJsFunction(
         context: Long,
@@ -1374,6 +3171,17 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         jsCode: String
     )
 
+    private external fun jniCopyJsValueHandle(context: Long, globalNameTo: String, handle: Long)
+    private external fun jniReleaseJsValues(context: Long, handles: LongArray, globalNames: Array<String>)
+    private external fun jniProcessJsCommands(context: Long, commandQueueHandle: Long)
+    private external fun jniGetJsValueProperty(context: Long, handle: Long, globalName: String?, key: String?, index: Int, type: Parameter): Any?
+    private external fun jniSetJsValueProperty(context: Long, handle: Long, globalName: String?, key: String?, index: Int, value: Any?, type: Parameter)
+    private external fun jniCallJsValueMethod(context: Long, handle: Long, globalName: String?, methodName: String, args: Array<Any?>, type: Parameter): Any?
+    private external fun jniGetJsValueType(context: Long, handle: Long, globalName: String?): String
+    private external fun jniGetJsExceptionJsonValue(context: Long, errorHandle: Long): String?
+
+    private external fun jniParseJsonBuffer(context: Long, globalName: String, buffer: ByteBuffer, offset: Int, length: Int)
+    private external fun jniAssignDirectBuffer(context: Long, globalName: String, buffer: ByteBuffer, offset: Int, length: Int, asUtf8String: Boolean)
     private external fun jniConvertJavaValueToJs(
         context: Long,
         globalName: String,
@@ -1383,12 +3191,20 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
 
     private external fun jniCompleteJsPromise(
         context: Long,
-        id: String,
+        promiseObjectHandle: Long,
         isFulfilled: Boolean,
-        value: Any
+        value: Any?
+    )
+
+    private external fun jniCompleteJsPromises(
+        context: Long,
+        promiseObjectHandles: LongArray,
+        fulfilledFlags: BooleanArray,
+        values: Array<Any?>
     )
 
-    private external fun jniProcessPromiseQueue(context: Long)
+    private external fun jniProcessPromiseQueue(context: Long, maxJobs: Int, timeBudgetMs: Long): Boolean
+    private external fun jniIsJobPending(context: Long): Boolean
 
     @Suppress("UNUSED_PARAMETER")
     private fun handleCoroutineException(context: CoroutineContext, t: Throwable) {
@@ -1399,63 +3215,117 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
         //rootJob.cancelChildren()
     }
 
-    private inner class ProxyListener(
+    /**
+     * Caller of the methods of a JS object registered as a JavaToJsInterface
+     *
+     * It is used by the java.lang.reflect.Proxy instances created by JsValue.createJavaToJsProxy()
+     * and can be used directly by hand-written (or generated) implementations of a
+     * JavaToJsInterface via JsValue.createJavaToJsStub(), which avoids the reflective dispatch of
+     * each call.
+     *
+     * The methods are identified by their index (see methodIndex()), which should be resolved
+     * once when creating the stub.
+     */
+    inner class JavaToJsCaller internal constructor(
         private val jsValue: JsValue,
-        private val type: Class<*>,
-    ) : java.lang.reflect.InvocationHandler {
-        override fun invoke(proxy: Any, method: JavaMethod, args_: Array<Any?>?): Any? {
-            val args = args_ ?: arrayOf()
-            return when {
-                method.name == "hashCode" -> jsValue.hashCode()
-                method.name == "equals" -> jsValue.toString() == args.firstOrNull()?.toString()
-                method.name == "toString" -> jsValue.toString()
+        private val typeName: String,
+        private val methodNames: List<String?>,
+        javaMethods: List<JavaMethod?>,
+        private val methodsWithPackableArgs: List<Boolean>
+    ) {
+        // Native binding of the registered JS object (set in the JS thread on registration)
+        @Volatile
+        internal var bindingHandle = 0L
+
+        // By Java method (i.e. by signature) and by name (only for the names which are not
+        // overloaded)
+        private val javaMethodIndices = javaMethods.withIndex()
+            .mapNotNull { (index, javaMethod) -> javaMethod?.let { it to index } }
+            .toMap()
+        private val methodIndices = methodNames.withIndex()
+            .groupBy({ it.value }, { it.index })
+            .mapNotNull { (name, indices) -> indices.singleOrNull()?.let { name to it } }
+            .toMap()
+
+        // (see Method.hasPackableParameters)
+        private fun hasPackableArgs(methodIndex: Int) = methodsWithPackableArgs.getOrElse(methodIndex) { false }
+
+        /**
+         * Return the index of the given method of the JavaToJsInterface
+         */
+        fun methodIndex(methodName: String): Int {
+            return methodIndices[methodName]
+                ?: throw IllegalArgumentException("$typeName has no (non-overloaded) method called $methodName")
+        }
 
-                // Suspending method
-                args.lastOrNull() is Continuation<*> -> {
-                    @Suppress("UNCHECKED_CAST")
-                    val continuation = args.last() as Continuation<Any?>
-                    val jsArgs = args.copyOfRange(0, args.size - 1)
-                    callJsMethodSuspended(method, jsArgs, continuation)
-                }
+        /**
+         * Return the index of the given method of the JavaToJsInterface
+         */
+        fun methodIndex(javaMethod: JavaMethod): Int {
+            return findMethodIndex(javaMethod)
+                ?: throw IllegalArgumentException("$typeName has no method $javaMethod")
+        }
 
-                // Without return value
-                method.returnType == Unit::class.java ||
-                        method.returnType == Void::class.java ||
-                        method.returnType == Void::class.javaPrimitiveType -> {
-                    callJsMethodWithoutRetVal(method, args)
-                    CompletableDeferred(Unit)
-                }
+        internal fun findMethodIndex(javaMethod: JavaMethod): Int? = javaMethodIndices[javaMethod]
 
-                // Deferred
-                method.returnType.isAssignableFrom(Deferred::class.java) -> callJsMethodAsync(
-                    method,
-                    args
-                )
+        /**
+         * Call a method without return value (non-blocking)
+         */
+        fun call(methodIndex: Int, vararg args: Any?) {
+            @Suppress("UNCHECKED_CAST")
+            callWithoutRetVal(methodIndex, args as Array<Any?>)
+        }
+
+        /**
+         * Call a method and block the current thread until the return value is available
+         */
+        fun callBlocking(methodIndex: Int, vararg args: Any?): Any? {
+            @Suppress("UNCHECKED_CAST")
+            return callBlocking(methodIndex, args as Array<Any?>)
+        }
 
-                else -> callJsMethodBlocking(method, args)
+        /**
+         * Call a method returning a Deferred (mapped to a JS Promise)
+         */
+        fun callAsync(methodIndex: Int, vararg args: Any?): Deferred<Any?> {
+            @Suppress("UNCHECKED_CAST")
+            return callAsync(methodIndex, args as Array<Any?>)
+        }
+
+        /**
+         * Call a suspending method (awaiting the returned JS Promise, if any)
+         */
+        suspend fun callSuspending(methodIndex: Int, vararg args: Any?): Any? {
+            @Suppress("UNCHECKED_CAST")
+            val jsArgs = args as Array<Any?>
+            val retVal = withContext(this@JsBridge.coroutineContext) {
+                Timber.v("Calling (suspend) JS method $typeName::${methodNames[methodIndex]}()...")
+                callJsMethod(jsValue, bindingHandle, methodIndex, jsArgs, true, hasPackableArgs(methodIndex))
             }
+
+            return if (retVal is Deferred<*>) retVal.await() else retVal
         }
 
-        private fun callJsMethodWithoutRetVal(method: JavaMethod, args: Array<Any?>?) {
+        internal fun callWithoutRetVal(methodIndex: Int, args: Array<Any?>) {
             runInJsThread {
                 try {
-                    Timber.v("Calling (void) JS method ${type.name}::${method.name}()...")
-                    callJsMethod(jsValue.associatedJsName, method, args ?: arrayOf(), false)
+                    Timber.v("Calling (void) JS method $typeName::${methodNames.getOrNull(methodIndex)}()...")
+                    callJsMethod(jsValue, bindingHandle, methodIndex, args, false, hasPackableArgs(methodIndex))
                 } catch (t: Throwable) {
-                    throw JavaToJsCallError("${type.name}::${method.name}()", t)
+                    throw JavaToJsCallError("$typeName::${methodNames.getOrNull(methodIndex)}()", t)
                 }
             }
         }
 
-        private fun callJsMethodSuspended(
-            method: JavaMethod,
+        internal fun callSuspended(
+            methodIndex: Int,
             args: Array<Any?>,
             continuation: Continuation<Any?>
         ): Any {
             launch {
                 val retVal = try {
-                    Timber.v("Calling (suspend) JS method ${type.name}::${method.name}()...")
-                    callJsMethod(jsValue.associatedJsName, method, args, true)
+                    Timber.v("Calling (suspend) JS method $typeName::${methodNames.getOrNull(methodIndex)}()...")
+                    callJsMethod(jsValue, bindingHandle, methodIndex, args, true, hasPackableArgs(methodIndex))
                 } catch (t: Throwable) {
                     // Throw JS exception (which must be directly caught by the caller)
                     continuation.resumeWithException(t)
@@ -1478,13 +3348,13 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             return kotlin.coroutines.intrinsics.COROUTINE_SUSPENDED
         }
 
-        private fun callJsMethodAsync(method: JavaMethod, args: Array<Any?>?): Deferred<Any?> {
+        internal fun callAsync(methodIndex: Int, args: Array<Any?>): Deferred<Any?> {
             val deferred = CompletableDeferred<Any?>()
 
             launch {
                 val retVal = try {
-                    Timber.v("Calling (deferred) JS method ${type.name}::${method.name}()...")
-                    callJsMethod(jsValue.associatedJsName, method, args ?: arrayOf(), false)
+                    Timber.v("Calling (deferred) JS method $typeName::${methodNames.getOrNull(methodIndex)}()...")
+                    callJsMethod(jsValue, bindingHandle, methodIndex, args, false, hasPackableArgs(methodIndex))
                 } catch (t: Throwable) {
                     // Reject the deferred with the JS exception (which must be directly caught by the caller)
                     deferred.completeExceptionally(t)
@@ -1506,16 +3376,60 @@ constructor(config: JsBridgeConfig, context: Context) : CoroutineScope {
             return deferred
         }
 
-        private fun callJsMethodBlocking(method: JavaMethod, args: Array<Any?>?): Any? {
+        internal fun callBlocking(methodIndex: Int, args: Array<Any?>): Any? {
+            if (isJsThread()) {
+                // Direct call (e.g. from Java code called by JS): no dispatching and no runBlocking
+                return callJsMethod(jsValue, bindingHandle, methodIndex, args, false, hasPackableArgs(methodIndex))
+            }
+
             if (isMainThread()) {
-                Timber.w("WARNING: executing JS method ${type.name}::${method.name}() in the main thread! Consider using a Deferred or calling the method in another thread!")
+                Timber.w("WARNING: executing JS method $typeName::${methodNames.getOrNull(methodIndex)}() in the main thread! Consider using a Deferred or calling the method in another thread!")
             } else {
-                Timber.v("Calling (blocking) JS method ${type.name}::${method.name}()...")
+                Timber.v("Calling (blocking) JS method $typeName::${methodNames.getOrNull(methodIndex)}()...")
             }
 
             return runBlocking(coroutineContext) {
                 // Exceptions must be directly caught by the caller
-                callJsMethod(jsValue.associatedJsName, method, args ?: arrayOf(), false)
+                callJsMethod(jsValue, bindingHandle, methodIndex, args, false, hasPackableArgs(methodIndex))
+            }
+        }
+    }
+
+    private class ProxyListener(
+        private val jsValue: JsValue,
+        private val caller: JavaToJsCaller
+    ) : java.lang.reflect.InvocationHandler {
+        override fun invoke(proxy: Any, method: JavaMethod, args_: Array<Any?>?): Any? {
+            val args = args_ ?: arrayOf()
+
+            // Index of the method in the array given on registration (-1 for the Object methods)
+            val methodIndex = caller.findMethodIndex(method) ?: -1
+
+            return when {
+                method.name == "hashCode" -> jsValue.hashCode()
+                method.name == "equals" -> jsValue.toString() == args.firstOrNull()?.toString()
+                method.name == "toString" -> jsValue.toString()
+
+                // Suspending method
+                args.lastOrNull() is Continuation<*> -> {
+                    @Suppress("UNCHECKED_CAST")
+                    val continuation = args.last() as Continuation<Any?>
+                    val jsArgs = args.copyOfRange(0, args.size - 1)
+                    caller.callSuspended(methodIndex, jsArgs, continuation)
+                }
+
+                // Without return value
+                method.returnType == Unit::class.java ||
+                        method.returnType == Void::class.java ||
+                        method.returnType == Void::class.javaPrimitiveType -> {
+                    caller.callWithoutRetVal(methodIndex, args)
+                    CompletableDeferred(Unit)
+                }
+
+                // Deferred
+                method.returnType.isAssignableFrom(Deferred::class.java) -> caller.callAsync(methodIndex, args)
+
+                else -> caller.callBlocking(methodIndex, args)
             }
         }
     }
@@ -1,6 +1,7 @@
 package de.prosiebensat1digital.oasisjsbridge
 
 import android.util.Log
+import java.io.File
 import okhttp3.OkHttpClient
 
 class JsBridgeConfig
@@ -13,7 +14,8 @@ private constructor() {
         fun bareConfig() = JsBridgeConfig()
 
         /**
-         * Creates an instance of JsBridgeConfig and enables all extensions.
+         * Creates an instance of JsBridgeConfig and enables all extensions (except fetch which
+         * must be explicitly enabled via fetchConfig, e.g. to keep an existing fetch polyfill).
          * @param localStorageNamespace arbitrary string for separation of local storage between
          * multiple JsBridge instances. If you use the same namespace for multiple instances of
          * JsBridge there might be collisions if identical keys are used to store values.
@@ -33,11 +35,16 @@ private constructor() {
 
     val setTimeoutConfig = SetTimeoutExtensionConfig()
     val xhrConfig = XMLHttpRequestConfig()
+    val fetchConfig = FetchConfig()
     val promiseConfig = PromiseConfig()
     val consoleConfig = ConsoleConfig()
     val jsDebuggerConfig = JsDebuggerConfig()
     val localStorageConfig = LocalStorageConfig()
+    val workerConfig = WorkerConfig()
     val jvmConfig = JvmConfig()
+    val bytecodeCacheConfig = BytecodeCacheConfig()
+    val jsEngineConfig = JsEngineConfig()
+    val callTracingConfig = CallTracingConfig()
 
     class SetTimeoutExtensionConfig {
         var enabled: Boolean = false
@@ -49,9 +56,28 @@ private constructor() {
         var userAgent: String? = null
     }
 
+    class FetchConfig {
+        var enabled: Boolean = false
+
+        // OkHttp client (default: the XHR one) whose connection pool is shared by all requests
+        var okHttpClient: OkHttpClient? = null
+        var userAgent: String? = null
+
+        // Delay after which a response body which has not been consumed via text(), json() or
+        // arrayBuffer() is released with its connection (0: never)
+        var unreadBodyTimeoutMs: Long = 30_000L
+    }
+
     class PromiseConfig {
         var enabled: Boolean = false
-        val needsPolyfill = !BuildConfig.HAS_BUILTIN_PROMISE
+        @Deprecated("Promises are built into both JS engines")
+        val needsPolyfill = false
+
+        // Budget of a promise queue tick (0: no limit). The jobs left when
+        // it is exhausted are processed in a later tick so that long microtask chains do not block
+        // the other tasks of the JS thread.
+        var maxJobsPerTick: Int = 0
+        var maxTickDurationMs: Long = 0
     }
 
     class ConsoleConfig {
@@ -61,6 +87,14 @@ private constructor() {
 
         var enabled: Boolean = false
         var mode: Mode = Mode.AsString
+
+        // Messages with a lower priority (android.util.Log) are dropped before any conversion
+        var minPriority: Int = Log.VERBOSE
+
+        // When > 0, messages are kept in a native ring buffer of the given size (instead of being
+        // given to appendMessage) and must be fetched via JsBridge.drainConsoleMessages()
+        var ringBufferSize: Int = 0
+
         var appendMessage: (priority: Int, message: String) -> Unit = { priority, message ->
             Log.println(priority, "JavaScript", message)
         }
@@ -77,7 +111,139 @@ private constructor() {
         var namespace: String = ""
     }
 
+    class WorkerConfig {
+        // Expose the Web Worker constructor to JS, each Worker running in its own JS thread
+        // Note: only supported on QuickJS
+        var enabled: Boolean = false
+
+        // Return the script of the given Worker URL (default: read the asset with the same path)
+        var scriptLoader: ((url: String) -> String)? = null
+    }
+
     class JvmConfig {
         var customClassLoader: ClassLoader? = null
+
+        // Convert primitive arrays (e.g. IntArray) to JS typed arrays (e.g. Int32Array) by
+        // bulk-copying their content instead of creating JS arrays element by element.
+        // Note: typed arrays from JS are always accepted as primitive arrays.
+        var typedArrays: Boolean = false
+
+        // Size of a cache of the JS strings converted from short Java strings (up to 64 chars)
+        // or 0 to disable it, e.g. for repeated event names or enum-like keys which are then only
+        // converted once and share the same JS string
+        // Note: only supported on QuickJS (Duktape already interns all its strings)
+        var stringCacheSize: Int = 0
+
+        // Bind the methods of Java objects registered to JS (JsToJavaProxy) when they are accessed
+        // for the first time instead of resolving all of them at registration, e.g. for large
+        // interfaces of which only a few methods are used.
+        // Note: an unsupported parameter type is then reported when the method is accessed.
+        var lazyJavaObjectMethods: Boolean = false
+
+        // Bind the methods of Java objects registered to JS (JsToJavaProxy) to Duktape lightfuncs
+        // (tagged values) instead of function objects, e.g. to reduce the heap size and the
+        // finalization work of large interfaces on low-memory devices.
+        // Note: only supported on Duktape and ignored with lazyJavaObjectMethods. A light method
+        // must be called on its object (e.g. obj.method() or method.call(obj)) and has no own
+        // properties.
+        var lightJavaObjectMethods: Boolean = false
+
+        // Define the methods of the Java objects registered to JS (JsToJavaProxy) with the same API
+        // interface on a shared JS prototype instead of binding them to each object, e.g. to
+        // reduce the registration cost and the heap size of many objects of the same interface.
+        // Note: only supported on QuickJS. The methods are then no own properties of the object
+        // (e.g. not returned by Object.keys()) and must be called on their object (e.g.
+        // obj.method() or method.call(obj)).
+        var sharedJavaObjectPrototypes: Boolean = false
+
+        // Load all the Java classes and resolve all the JNI method IDs used by JsBridge when the
+        // context is created instead of when they are first needed, e.g. to avoid these lookups
+        // during the first (time-critical) JS evaluations. The method IDs are shared by all the
+        // JsBridge instances of the process.
+        // Note: most of them are already loaded once per process when the JNI library is loaded.
+        var preloadJniCache: Boolean = false
+
+        // Number of JNI global refs held by the bridge (see JsMemoryUsage.jniGlobalRefCount) which
+        // triggers a JS garbage collection or 0 to disable it, e.g. to release the global refs
+        // of unreachable wrappers of Java objects, lambdas and promise callbacks before the
+        // global reference table of ART (limited to 51200 entries) overflows under load
+        var maxJniGlobalRefs: Int = 0
+    }
+
+    // Note: a JsBridge sharing the JS runtime of another instance (see JsBridge constructor) only
+    // uses its own executionTimeoutMs, the other settings are given by the other instance
+    class JsEngineConfig {
+        // Stack size of the JS thread in bytes or 0 for the default, e.g. to allow a deeper
+        // recursion in JS code (also given to QuickJS as its maximum stack size)
+        var maxStackSize: Long = 0
+
+        // Maximum size of the memory allocated by the JS engine in bytes or 0 for no limit. When
+        // reached, JS code fails with an "out of memory" exception.
+        // Note: on Duktape, only supported with the pool allocator
+        var memoryLimit: Long = 0
+
+        // Allocated memory size in bytes which triggers a garbage collection or 0 for the engine
+        // default (256kB). Higher values lead to less frequent GC pauses.
+        // Note: only supported on QuickJS
+        var gcThreshold: Long = 0
+
+        // Number of compiled RegExp patterns (with their flags) kept by the JS engine or 0 to
+        // disable the cache, e.g. to avoid compiling the same pattern again in code calling
+        // "new RegExp(str)" in a loop. The least recently used pattern is evicted first.
+        // Note: only supported on QuickJS
+        var regExpCacheSize: Int = 0
+
+        // Run the garbage collector when no task (evaluation, call, timer...) has been executed
+        // in the JS thread for the given duration in ms or 0 to only rely on the GC triggered by
+        // the engine, e.g. to move the GC pauses out of the latency-critical calls
+        var idleGcDelayMs: Long = 0
+
+        // With idleGcDelayMs > 0: size in bytes which can be allocated after an idle GC before the
+        // engine triggers a GC itself or 0 for the engine default, e.g. to defer the GC to the
+        // next idle gap while the JS thread is busy
+        // Note: only supported on QuickJS
+        var idleGcAllocationThreshold: Long = 0
+
+        // Serve the many small allocations of the JS engine (objects, shapes, strings...) from
+        // size-class memory pools which are released all at once with the JsBridge instance
+        // instead of using malloc() for each of them. It also keeps track of the JS heap size
+        // (see JsBridge.getJsHeapSize()).
+        var poolAllocator: Boolean = true
+
+        // Compact the property tables of the global object, of the registered objects and of
+        // their prototypes once the first file (e.g. the JS bundle) has been evaluated, assuming
+        // that they rarely change afterwards (see JsBridge.compactHeap())
+        // Note: only supported on Duktape
+        var compactHeapAfterFirstFileEvaluation: Boolean = false
+
+        // Maximum duration in ms of each JS evaluation or call from Java (including the nested
+        // calls from Java code called by JS) or 0 for no limit. A script running longer is
+        // interrupted with an uncatchable error and a JsExecutionTimeoutError is reported.
+        var executionTimeoutMs: Long = 0
+
+        // Nice value of the JS thread (from -20 for the highest priority to 19 for the lowest) or
+        // null to keep the default one, e.g. to keep latency-critical scripts from being
+        // preempted by background work (see also JsBridge.setJsThreadScheduling())
+        var jsThreadNiceValue: Int? = null
+
+        // Mask of the CPUs the JS thread may run on (bit 0: CPU 0, ...) or 0 for all of them,
+        // e.g. to keep the JS thread on the big cores of big.LITTLE devices
+        var jsThreadCpuAffinityMask: Long = 0
+    }
+
+    class CallTracingConfig {
+        // Trace the latency of all bridge calls (JNI entry points, Java methods called from JS,
+        // JS methods called from Java). The calls are emitted as ATrace sections (visible in
+        // Perfetto/systrace) and aggregated into statistics (see JsBridge.getCallTraceStats()).
+        var enabled: Boolean = false
+    }
+
+    class BytecodeCacheConfig {
+        // Store the compiled bytecode of evaluated files and loaded modules on disk so that the
+        // same source code does not need to be parsed again (e.g. on the next app start)
+        var enabled: Boolean = false
+
+        // Cache directory (default: "jsbridge-bytecode" in the code cache directory of the app)
+        var directory: File? = null
     }
 }
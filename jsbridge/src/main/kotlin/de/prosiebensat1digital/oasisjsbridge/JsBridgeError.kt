@@ -72,6 +72,7 @@ sealed class JsBridgeError(message: String? = null, cause: Throwable?): Exceptio
 
     class JsCallbackError(cause: Throwable? = null): JsBridgeError(cause = cause)
     class UnhandledJsPromiseError(jsException: JsException): JsBridgeError("Unhandled Promise error", cause = jsException)
+    class JsExecutionTimeoutError(val timeoutMs: Long): JsBridgeError("JS execution interrupted after $timeoutMs ms", cause = null)
     class XhrError(val query: String, cause: Throwable? = null): JsBridgeError(cause = cause)
 
     class InternalError(cause: Throwable? = null, customMessage: String? = null)
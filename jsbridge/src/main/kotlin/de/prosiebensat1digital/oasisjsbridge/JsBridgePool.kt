@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import android.content.Context
+import kotlinx.coroutines.*
+import timber.log.Timber
+
+/**
+ * Pool of pre-warmed JsBridge instances
+ *
+ * JS heaps cannot be snapshotted, so the pool keeps the given number of JsBridge instances ready
+ * instead: they are started (including their extensions) and set up via the given setUp function
+ * in the background, ahead of their acquisition. Each acquired instance is immediately replaced by
+ * a new one and belongs to the caller, which must release it.
+ *
+ * The setUp function is executed in the JS thread of each instance. Combined with the bytecode
+ * cache (JsBridgeConfig.bytecodeCacheConfig) or precompiled files (evaluateLocalBytecodeFile()), it
+ * avoids parsing the same bootstrap code again for each instance.
+ *
+ * @param config JsBridge configuration shared by all instances
+ * @param context Context needed for local storage extension
+ * @param size number of instances kept ready
+ * @param setUp function called once for each new instance (e.g. to evaluate a bootstrap bundle)
+ */
+class JsBridgePool(
+    private val config: JsBridgeConfig,
+    context: Context,
+    private val size: Int = 1,
+    private val setUp: suspend (JsBridge) -> Unit = {}
+) {
+    private class WarmJsBridge(val jsBridge: JsBridge, val ready: Deferred<Unit>)
+
+    private val appContext = context.applicationContext ?: context
+    private val lock = Any()
+    private val warmJsBridges = ArrayDeque<WarmJsBridge>()
+    private var isReleased = false
+
+    init {
+        require(size >= 0) { "Invalid JsBridgePool size: $size" }
+        fill()
+    }
+
+    /**
+     * Return a started and set up JsBridge instance, waiting for it if it is not ready yet.
+     *
+     * The caller takes ownership of the instance and must release it via JsBridge.release().
+     */
+    suspend fun acquire(): JsBridge {
+        val warmJsBridge = synchronized(lock) {
+            check(!isReleased) { "Cannot acquire a JsBridge from a released JsBridgePool" }
+            warmJsBridges.removeFirstOrNull()
+        } ?: createWarmJsBridge()
+
+        fill()
+
+        try {
+            warmJsBridge.ready.await()
+        } catch (t: Throwable) {
+            warmJsBridge.jsBridge.release()
+            throw t
+        }
+
+        return warmJsBridge.jsBridge
+    }
+
+    /**
+     * Return a started and set up JsBridge instance (blocking version).
+     */
+    fun acquireBlocking(): JsBridge = runBlocking { acquire() }
+
+    /**
+     * Release the instances which have not been acquired yet.
+     */
+    fun release() {
+        val jsBridges = synchronized(lock) {
+            isReleased = true
+            warmJsBridges.map { it.jsBridge }.also { warmJsBridges.clear() }
+        }
+
+        jsBridges.forEach { it.release() }
+    }
+
+    private fun fill() {
+        synchronized(lock) {
+            while (!isReleased && warmJsBridges.size < size) {
+                warmJsBridges.addLast(createWarmJsBridge())
+            }
+        }
+    }
+
+    private fun createWarmJsBridge(): WarmJsBridge {
+        val jsBridge = JsBridge(config, appContext)
+        val ready = jsBridge.async {
+            setUp(jsBridge)
+            Timber.d("Pre-warmed JsBridge is ready")
+        }
+
+        return WarmJsBridge(jsBridge, ready)
+    }
+}
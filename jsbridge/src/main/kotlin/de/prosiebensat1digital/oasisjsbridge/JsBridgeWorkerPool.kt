@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import android.content.Context
+import java.util.concurrent.atomic.AtomicInteger
+import kotlinx.coroutines.*
+import timber.log.Timber
+
+/**
+ * Pool of JsBridge workers running CPU-heavy JS jobs in parallel
+ *
+ * Each JsBridge instance has its own JS thread and JS context, so a single instance cannot use more
+ * than one core. The pool starts the given number of workers (each one with its own JS thread),
+ * sets them up via the given setUp function and dispatches each job to the least-loaded worker.
+ *
+ * The first worker is set up before the other ones: with the bytecode cache enabled
+ * (JsBridgeConfig.bytecodeCacheConfig), the bootstrap code is only compiled once and the other
+ * workers are initialized from the same cached bytecode.
+ *
+ * Note: JS values are bound to the worker which created them, so a job must only use the values
+ * of the JsBridge instance it is given.
+ *
+ * @param config JsBridge configuration shared by all workers
+ * @param context Context needed for local storage extension
+ * @param workerCount number of workers (JS threads)
+ * @param setUp function called once for each worker (e.g. to evaluate a bootstrap bundle)
+ */
+class JsBridgeWorkerPool(
+    config: JsBridgeConfig,
+    context: Context,
+    val workerCount: Int = Runtime.getRuntime().availableProcessors(),
+    setUp: suspend (JsBridge) -> Unit = {}
+) {
+    private class Worker(val jsBridge: JsBridge, val ready: Deferred<Unit>) {
+        val pendingJobCount = AtomicInteger(0)
+    }
+
+    private val workers: List<Worker>
+
+    @Volatile
+    private var isReleased = false
+
+    init {
+        require(workerCount > 0) { "Invalid JsBridgeWorkerPool worker count: $workerCount" }
+
+        val appContext = context.applicationContext ?: context
+        val firstJsBridge = JsBridge(config, appContext)
+        val firstReady = firstJsBridge.async { setUp(firstJsBridge) }
+
+        workers = listOf(Worker(firstJsBridge, firstReady)) + (1 until workerCount).map {
+            val jsBridge = JsBridge(config, appContext)
+            val ready = jsBridge.async {
+                // Wait for the first worker to fill the bytecode cache
+                try {
+                    firstReady.await()
+                } catch (t: Throwable) {
+                    // The error is thrown by the jobs of the first worker
+                }
+                setUp(jsBridge)
+            }
+            Worker(jsBridge, ready)
+        }
+    }
+
+    /**
+     * Run the given job on the least-loaded worker and return its result.
+     *
+     * The job is executed in the JS thread of the worker.
+     */
+    suspend fun <T> run(job: suspend (JsBridge) -> T): T {
+        check(!isReleased) { "Cannot run a job on a released JsBridgeWorkerPool" }
+
+        val worker = workers.minByOrNull { it.pendingJobCount.get() }!!
+        worker.pendingJobCount.incrementAndGet()
+
+        try {
+            worker.ready.await()
+            return withContext(worker.jsBridge.coroutineContext) {
+                job(worker.jsBridge)
+            }
+        } finally {
+            worker.pendingJobCount.decrementAndGet()
+        }
+    }
+
+    /**
+     * Run the given job for each item in parallel on the workers and return the results in the
+     * same order as the items.
+     */
+    suspend fun <T, R> map(items: Iterable<T>, job: suspend (JsBridge, T) -> R): List<R> {
+        return coroutineScope {
+            items.map { item -> async { run { jsBridge -> job(jsBridge, item) } } }.awaitAll()
+        }
+    }
+
+    /**
+     * Release all the workers.
+     */
+    fun release() {
+        isReleased = true
+        workers.forEach { it.jsBridge.release() }
+        Timber.d("JsBridgeWorkerPool released")
+    }
+}
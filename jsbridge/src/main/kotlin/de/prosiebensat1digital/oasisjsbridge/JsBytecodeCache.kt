@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import java.io.File
+import java.nio.ByteBuffer
+import java.security.MessageDigest
+import java.util.zip.CRC32
+import timber.log.Timber
+
+// On-disk cache for the compiled bytecode of JS files and modules
+//
+// Entries are keyed by the hash of the source code and the bytecode version of the JS engine so
+// that updating the engine (or the source) never loads stale bytecode. Each entry starts with a
+// CRC32 checksum as bytecode is not validated by all engines before being executed.
+internal class JsBytecodeCache(private val directory: File, private val bytecodeVersion: String) {
+
+    companion object {
+        private const val FILE_EXTENSION = ".jsbc"
+        private const val CHECKSUM_SIZE = 4
+    }
+
+    fun getKey(source: String): String {
+        val digest = MessageDigest.getInstance("SHA-256")
+        digest.update(bytecodeVersion.toByteArray())
+        digest.update(0)
+        digest.update(source.toByteArray())
+        return digest.digest().joinToString("") { "%02x".format(it) }
+    }
+
+    fun get(key: String): ByteArray? {
+        val file = getFile(key)
+        if (!file.exists()) return null
+
+        val content = try {
+            file.readBytes()
+        } catch (t: Throwable) {
+            Timber.w(t, "Could not read cached JS bytecode from $file")
+            return null
+        }
+
+        if (content.size < CHECKSUM_SIZE) {
+            remove(key)
+            return null
+        }
+
+        val bytecode = content.copyOfRange(CHECKSUM_SIZE, content.size)
+        if (ByteBuffer.wrap(content, 0, CHECKSUM_SIZE).int != checksum(bytecode)) {
+            Timber.w("Ignoring corrupted cached JS bytecode $file")
+            remove(key)
+            return null
+        }
+
+        return bytecode
+    }
+
+    fun put(key: String, bytecode: ByteArray) {
+        val file = getFile(key)
+
+        try {
+            directory.mkdirs()
+
+            // Write into a temporary file first so that a partially written entry is never read
+            val tmpFile = File.createTempFile(key, ".tmp", directory)
+            tmpFile.outputStream().use { outputStream ->
+                outputStream.write(ByteBuffer.allocate(CHECKSUM_SIZE).putInt(checksum(bytecode)).array())
+                outputStream.write(bytecode)
+            }
+
+            if (!tmpFile.renameTo(file)) {
+                tmpFile.delete()
+            }
+        } catch (t: Throwable) {
+            Timber.w(t, "Could not write cached JS bytecode to $file")
+        }
+    }
+
+    fun remove(key: String) {
+        getFile(key).delete()
+    }
+
+    private fun getFile(key: String) = File(directory, key + FILE_EXTENSION)
+
+    private fun checksum(bytecode: ByteArray): Int {
+        return CRC32().apply { update(bytecode) }.value.toInt()
+    }
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import java.util.concurrent.ConcurrentLinkedQueue
+import java.util.concurrent.Executor
+import java.util.concurrent.RejectedExecutionException
+import kotlin.coroutines.CoroutineContext
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.cancel
+
+/**
+ * Priority of the work scheduled on the JS thread, given via the coroutine context of the caller:
+ * the pending tasks with a higher priority run first, the tasks with the same priority run in
+ * order.
+ *
+ * e.g.:
+ * withContext(JsCallPriority.Interactive) { jsBridge.evaluate<String>("getTitle()") }
+ * jsBridge.launch(JsCallPriority.Background) { jsBridge.evaluateFileContent(content, "analytics.js") }
+ *
+ * When interactive work is waiting, the running task is also asked to yield at its next safe point
+ * (i.e. between two promise jobs, the remaining ones being processed after the interactive work).
+ * A running script cannot be preempted, though, so long background scripts should be split into
+ * several calls.
+ *
+ * Note: the unsync and blocking APIs always use the default priority.
+ */
+enum class JsCallPriority : CoroutineContext.Element {
+    Interactive,
+    Default,
+    Background;
+
+    override val key: CoroutineContext.Key<*> get() = Key
+
+    companion object Key : CoroutineContext.Key<JsCallPriority>
+}
+
+// Dispatcher of the (single) JS thread executing the highest-priority pending task first
+//
+// The running task is asked to yield (onYieldRequested) when an interactive task is dispatched.
+// A request which has not been consumed when the task ends is dropped (onYieldRequestExpired)
+// before the next task starts so that the next task does not yield spuriously.
+internal class JsPriorityDispatcher(
+    private val executor: Executor,
+    private val onYieldRequested: () -> Unit,
+    private val onYieldRequestExpired: () -> Unit
+) : CoroutineDispatcher() {
+
+    // One FIFO queue per priority, each task being executed by the next executor runnable
+    private val lanes = Array(JsCallPriority.values().size) { ConcurrentLinkedQueue<Runnable>() }
+
+    // Priority of the task currently running on the JS thread (null: idle)
+    @Volatile
+    private var runningPriority: JsCallPriority? = null
+
+    // Whether a yield has been requested since the last task started
+    @Volatile
+    private var isYieldRequested = false
+
+    override fun dispatch(context: CoroutineContext, block: Runnable) {
+        val priority = context[JsCallPriority] ?: JsCallPriority.Default
+        val lane = lanes[priority.ordinal]
+        lane.add(block)
+
+        try {
+            executor.execute(::runNextTask)
+        } catch (e: RejectedExecutionException) {
+            // Same as the executor dispatcher: the JS thread has been shut down
+            lane.remove(block)
+            context.cancel(CancellationException("The JS thread has been shut down", e))
+            Dispatchers.IO.dispatch(context, block)
+            return
+        }
+
+        if (priority == JsCallPriority.Interactive) {
+            val runningPriority = runningPriority
+            if (runningPriority != null && runningPriority > priority) {
+                isYieldRequested = true
+                onYieldRequested()
+            }
+        }
+    }
+
+    private fun runNextTask() {
+        for (i in lanes.indices) {
+            val block = lanes[i].poll() ?: continue
+
+            // Before setting the running priority: later requests are meant for this task
+            if (isYieldRequested) {
+                isYieldRequested = false
+                onYieldRequestExpired()
+            }
+
+            runningPriority = PRIORITIES[i]
+            try {
+                block.run()
+            } finally {
+                runningPriority = null
+            }
+            return
+        }
+    }
+
+    override fun toString() = "JsPriorityDispatcher"
+
+    private companion object {
+        val PRIORITIES = JsCallPriority.values()
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+/**
+ * Aggregated latency statistics of a traced bridge call (see JsBridgeConfig.callTracingConfig)
+ *
+ * The name is either:
+ * - the JNI entry point, e.g. "jniEvaluateString"
+ * - "JavaMethod <name>" for a Java method called from JS
+ * - "JsMethod <name>" for a JS method called from Java
+ */
+data class JsCallTraceStats(
+    val name: String,
+    val callCount: Long,
+
+    // Whole call
+    val total: PhaseStats,
+
+    // Conversion of the arguments and of the return value between Java and JS
+    val conversion: PhaseStats,
+
+    // Execution of the JS code (JS methods called from Java only)
+    val jsExecution: PhaseStats,
+
+    // Call of the Java method (Java methods called from JS only)
+    val jniUpcall: PhaseStats,
+) {
+    /**
+     * Duration statistics of a call phase in nanoseconds. The percentiles are approximated from a
+     * logarithmic histogram (~20% precision) and are 0 when the phase has never been traced.
+     */
+    data class PhaseStats(
+        val totalDurationNs: Long,
+        val p50Ns: Long,
+        val p90Ns: Long,
+        val p99Ns: Long,
+    )
+
+    internal companion object {
+        // Number of values per call, must match CallTracer::VALUE_COUNT
+        private const val PHASE_COUNT = 4
+        private const val VALUE_COUNT = 1 + PHASE_COUNT * 4
+
+        // Create the statistics from the names and values given by jniGetCallTraceStats()
+        fun fromNativeStats(names: Array<String>, values: LongArray): List<JsCallTraceStats> {
+            return names.mapIndexed { index, name ->
+                val offset = index * VALUE_COUNT
+                fun phaseStats(phaseIndex: Int): PhaseStats {
+                    val phaseOffset = offset + 1 + phaseIndex * 4
+                    return PhaseStats(
+                        totalDurationNs = values[phaseOffset],
+                        p50Ns = values[phaseOffset + 1],
+                        p90Ns = values[phaseOffset + 2],
+                        p99Ns = values[phaseOffset + 3],
+                    )
+                }
+
+                JsCallTraceStats(
+                    name = name,
+                    callCount = values[offset],
+                    total = phaseStats(0),
+                    conversion = phaseStats(1),
+                    jsExecution = phaseStats(2),
+                    jniUpcall = phaseStats(3),
+                )
+            }
+        }
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+/**
+ * Conversion counters of a native type (see JsBridge.getConversionStats())
+ *
+ * Byte counts are estimates of the payload (UTF-8 or UTF-16 string length, JSON length, primitive
+ * array size) and are 0 for the other types.
+ */
+data class JsConversionStats(
+    // Native type id (see JavaTypeId.h) and its name, e.g. "String" or "IntArray"
+    val typeId: Int,
+    val typeName: String,
+
+    val jsToJavaCount: Long,
+    val jsToJavaBytes: Long,
+    val javaToJsCount: Long,
+    val javaToJsBytes: Long,
+) {
+    internal companion object {
+        // Number of values per type given by jniGetConversionStats()
+        private const val VALUE_COUNT = 5
+
+        // Must match JavaTypeId.h
+        private val typeNames = mapOf(
+            1 to "Void", 2 to "BoxedVoid", 3 to "Unit",
+            10 to "Boolean", 11 to "Byte", 12 to "Int", 13 to "Long", 14 to "Float", 15 to "Double", 16 to "Short",
+            20 to "BoxedBoolean", 21 to "BoxedByte", 22 to "BoxedInt", 23 to "BoxedLong", 24 to "BoxedFloat",
+            25 to "BoxedDouble", 26 to "BoxedShort",
+            30 to "String", 31 to "Number", 40 to "Object",
+            50 to "ObjectArray", 51 to "List", 52 to "Map",
+            60 to "BooleanArray", 61 to "ByteArray", 62 to "IntArray", 63 to "LongArray", 64 to "FloatArray",
+            65 to "DoubleArray", 66 to "ShortArray",
+            90 to "DebugString", 100 to "FunctionX", 101 to "JsValue", 102 to "JsonObjectWrapper",
+            103 to "Deferred", 104 to "JavaObjectWrapper", 105 to "JsToJavaProxy", 106 to "Payload",
+            107 to "PayloadObject", 108 to "PayloadArray", 109 to "JsObjectView", 110 to "Serializable",
+        )
+
+        fun fromLongArray(values: LongArray): List<JsConversionStats> {
+            return (0 until values.size / VALUE_COUNT).map { i ->
+                val offset = i * VALUE_COUNT
+                val typeId = values[offset].toInt()
+                JsConversionStats(
+                    typeId = typeId,
+                    typeName = typeNames[typeId] ?: "Unknown",
+                    jsToJavaCount = values[offset + 1],
+                    jsToJavaBytes = values[offset + 2],
+                    javaToJsCount = values[offset + 3],
+                    javaToJsBytes = values[offset + 4],
+                )
+            }
+        }
+    }
+}
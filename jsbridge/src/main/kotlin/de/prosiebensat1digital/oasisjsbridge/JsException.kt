@@ -20,8 +20,25 @@ package de.prosiebensat1digital.oasisjsbridge
 
 import timber.log.Timber
 
+class JsException
 @Suppress("UNUSED")  // Called from JNI
-class JsException(val jsonValue: String? = null, detailedMessage: String, jsStackTrace: String?, cause: Throwable?) : RuntimeException(detailedMessage, cause) {
+internal constructor(
+    initialJsonValue: String?,
+    detailedMessage: String,
+    jsStackTrace: String?,
+    cause: Throwable?,
+    @Transient private val errorValue: JsValue?
+) : RuntimeException(detailedMessage, cause) {
+
+    constructor(jsonValue: String? = null, detailedMessage: String, jsStackTrace: String?, cause: Throwable?)
+            : this(jsonValue, detailedMessage, jsStackTrace, cause, null)
+
+    // The JSON value of errors thrown from JS is only created when read (exceptions used for
+    // control flow are never stringified). It is null if the JS interpreter has been released
+    // in the meantime.
+    val jsonValue: String? by lazy {
+        errorValue?.let { it.jsBridge?.getJsExceptionJsonValueBlocking(it) } ?: initialJsonValue
+    }
 
     init {
         Timber.v("JsException() - detailedMessage = $detailedMessage")
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+/**
+ * Memory statistics of a JsBridge instance (see JsBridge.getMemoryUsage())
+ *
+ * The JS engine values are -1 when they are not available (Duktape only reports the heap size
+ * and only with the pool allocator).
+ */
+data class JsMemoryUsage(
+    // Size in bytes of the memory allocated by the JS engine
+    val heapSize: Long,
+
+    // Number of JS objects, strings and atoms (QuickJS only)
+    val objectCount: Long,
+    val stringCount: Long,
+    val atomCount: Long,
+
+    // Native wrappers of C++ instances held by JS objects (e.g. registered Java objects and
+    // lambdas, Promise callbacks)
+    val cppWrapperCount: Long,
+
+    // JNI global refs to Java objects held by JS values (part of cppWrapperCount)
+    val javaRefCount: Long,
+
+    // JS values referenced by JsValue instances which have not been released yet (including the
+    // JS promises created from pending Deferred instances)
+    val jsValueCount: Long,
+
+    // All the JNI global refs currently held by the bridge (see JvmConfig.maxJniGlobalRefs)
+    val jniGlobalRefCount: Long,
+) {
+    internal companion object {
+        // Order must match jniGetMemoryUsage()
+        fun fromLongArray(values: LongArray) = JsMemoryUsage(
+            heapSize = values[0],
+            objectCount = values[1],
+            stringCount = values[2],
+            atomCount = values[3],
+            cppWrapperCount = values[4],
+            javaRefCount = values[5],
+            jsValueCount = values[6],
+            jniGlobalRefCount = values[7],
+        )
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import java.util.concurrent.atomic.AtomicLong
+
+/**
+ * Structured clone of a JS value which can be read by any JsBridge instance
+ *
+ * The JS value graph (including object references) is serialized into a native buffer without
+ * any JSON or Kotlin string round-trip. SharedArrayBuffers are shared with the receiving
+ * instances instead of being copied.
+ *
+ * A message can be read several times (see JsBridge.receiveMessage()) until it is released.
+ * It is automatically released when garbage-collected.
+ *
+ * Note: only supported on QuickJS
+ */
+class JsMessage internal constructor(nativeHandle: Long) {
+    private val nativeHandleRef = AtomicLong(nativeHandle)
+
+    internal val nativeHandle: Long
+        get() = nativeHandleRef.get().also { check(it != 0L) { "JsMessage has been released" } }
+
+    /**
+     * Release the native buffer of the message.
+     */
+    fun release() {
+        val nativeHandle = nativeHandleRef.getAndSet(0L)
+        if (nativeHandle != 0L) {
+            JsBridge.deleteJsMessage(nativeHandle)
+        }
+    }
+
+    protected fun finalize() {
+        release()
+    }
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+/**
+ * A lazy view of a JS object (or array) returned from JS.
+ *
+ * Unlike JsonObjectWrapper or PayloadObject, the JS object is not converted when it is
+ * transferred to Java: it stays referenced in the JS engine and each property is only converted
+ * when it is read. This is useful to read a few properties out of a large JS object.
+ *
+ * e.g.:
+ * val manifest: JsObjectView = jsBridge.evaluate("getManifest()")
+ * val version: String? = manifest.getString("version")
+ * val firstItemId: Int? = manifest.getObject("items")?.getObject(0)?.getInt("id")
+ *
+ * Notes:
+ * - the properties are read when calling the getters, i.e. the view reflects the current state of
+ * the JS object
+ * - nested objects can be read as JsObjectView (lazy) or as any other supported type (e.g.
+ * PayloadObject or JsonObjectWrapper to convert the whole sub-tree)
+ * - as a JsValue, the JS object is released when the view is garbage-collected (or when calling
+ * release())
+ */
+class JsObjectView
+@Suppress("UNUSED")  // Called from JNI
+private constructor(jsBridge: JsBridge, nativeHandle: Long)
+    : JsValue(jsBridge, jsCode = null, associatedJsName = generateJsGlobalName(), nativeHandle = nativeHandle) {
+
+    suspend fun getString(key: String): String? = get(key)
+    suspend fun getBoolean(key: String): Boolean? = get(key)
+    suspend fun getInt(key: String): Int? = get(key)
+    suspend fun getLong(key: String): Long? = get(key)
+    suspend fun getDouble(key: String): Double? = get(key)
+    suspend fun getObject(key: String): JsObjectView? = get(key)
+
+    suspend fun getString(index: Int): String? = get(index)
+    suspend fun getBoolean(index: Int): Boolean? = get(index)
+    suspend fun getInt(index: Int): Int? = get(index)
+    suspend fun getLong(index: Int): Long? = get(index)
+    suspend fun getDouble(index: Int): Double? = get(index)
+    suspend fun getObject(index: Int): JsObjectView? = get(index)
+
+    /**
+     * Length of a JS array (or "length" property of the JS object)
+     */
+    suspend fun getLength(): Int = get<Int?>("length") ?: 0
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import java.nio.ByteBuffer
+import java.util.concurrent.atomic.AtomicBoolean
+import java.util.concurrent.atomic.AtomicReference
+
+/**
+ * Shared memory channel between Kotlin and JS (see JsBridge.newJsSharedBuffer())
+ *
+ * The direct byteBuffer and the JS SharedArrayBuffer (jsValue) use the same native memory so
+ * that high-frequency data (e.g. sensor samples) can be exchanged with memory writes and the JS
+ * Atomics instead of a bridge call per message. Both sides can signal new data:
+ * - Kotlin -> JS: notifyJs() calls the onnotify() method assigned to the SharedArrayBuffer by JS
+ *   code. Notifications are coalesced: a burst of calls only triggers a single JS call.
+ * - JS -> Kotlin: the native notify() method of the SharedArrayBuffer increments a counter which
+ *   can be awaited by any thread via awaitJsNotify() without involving the JS thread.
+ *
+ * The memory stays allocated until both release() has been called and the SharedArrayBuffer
+ * has been garbage-collected (including its copies posted to other JsBridge instances).
+ *
+ * Note: only supported on QuickJS
+ */
+class JsSharedBuffer internal constructor(
+    private val jsBridge: JsBridge,
+    val jsValue: JsValue,
+    byteBuffer: ByteBuffer
+) {
+    private val byteBufferRef = AtomicReference<ByteBuffer?>(byteBuffer)
+    private val isJsNotifyPending = AtomicBoolean(false)
+
+    /**
+     * Direct buffer (in native byte order, like the JS typed arrays) sharing its memory with the
+     * SharedArrayBuffer. Use the absolute get/put methods when accessing it from several threads.
+     *
+     * Note: must not be used after release()
+     */
+    val byteBuffer: ByteBuffer
+        get() = byteBufferRef.get() ?: throw IllegalStateException("JsSharedBuffer has been released")
+
+    /**
+     * Call the onnotify() method of the SharedArrayBuffer (if any) in the JS thread
+     *
+     * Can be called from any thread. Calls made before the pending notification has been
+     * delivered are merged into it.
+     */
+    fun notifyJs() {
+        if (isJsNotifyPending.compareAndSet(false, true)) {
+            jsBridge.notifyJsSharedBuffer(this)
+        }
+    }
+
+    // Called in the JS thread before calling onnotify() so that the next notifyJs() call
+    // triggers a new one
+    internal fun onJsNotifyDispatched() {
+        isJsNotifyPending.set(false)
+    }
+
+    /**
+     * Block until JS code has called notify() on the SharedArrayBuffer since the given counter
+     * value (or until timeoutMs has elapsed, < 0: no timeout) and return the current counter,
+     * e.g.:
+     *
+     * var notifyCount = 0
+     * while (isActive) {
+     *   notifyCount = sharedBuffer.awaitJsNotify(notifyCount)
+     *   // read the new data
+     * }
+     *
+     * Note: must not be called from the JS thread
+     */
+    fun awaitJsNotify(notifyCount: Int, timeoutMs: Long = -1L): Int {
+        return JsBridge.waitForJsSharedBufferNotify(byteBuffer, notifyCount, timeoutMs)
+    }
+
+    /**
+     * Release the reference of the byteBuffer to the shared memory (the SharedArrayBuffer keeps
+     * its own one)
+     *
+     * Note: must not be called while another thread is blocked in awaitJsNotify()
+     */
+    fun release() {
+        val byteBuffer = byteBufferRef.getAndSet(null) ?: return
+        JsBridge.releaseJsSharedBuffer(byteBuffer)
+    }
+}
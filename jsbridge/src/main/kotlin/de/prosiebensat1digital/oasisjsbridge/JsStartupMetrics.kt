@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+/**
+ * Duration of the startup phases of a JsBridge instance in nanoseconds (see
+ * JsBridge.startupMetrics), also emitted as ATrace sections (visible in Perfetto)
+ *
+ * The values are -1 as long as the corresponding phase has not been completed yet.
+ */
+data class JsStartupMetrics(
+    // Whole native context creation (jniCreateContext)
+    val contextCreationNs: Long = -1L,
+
+    // JS runtime (unless shared with another JsBridge) and context creation
+    val engineCreationNs: Long = -1L,
+
+    // Lookup of the JNI classes and methods (see JsBridgeConfig.jvmConfig.preloadJniCache)
+    val jniCacheCreationNs: Long = -1L,
+
+    // Native bridge setup (utils, exception handler, JsValue table, ...)
+    val bridgeSetupNs: Long = -1L,
+
+    // Time spent by the JS thread installing each enabled extension (e.g. "SetTimeout")
+    val extensionInstallationNs: Map<String, Long> = emptyMap(),
+
+    // First evaluateLocalFile() or evaluateFileContent() call (including the compilation)
+    val firstFileEvaluationNs: Long = -1L,
+) {
+    internal fun withNativeTimings(values: LongArray) = copy(
+        // Order must match jniGetStartupTimings()
+        contextCreationNs = values[0],
+        engineCreationNs = values[1],
+        jniCacheCreationNs = values[2],
+        bridgeSetupNs = values[3],
+    )
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import java.io.File
+
+/**
+ * Bridge traffic recorded by JsBridge.startTrafficRecording(): the timing and the shape
+ * (argument types and sizes) of the recorded calls, without their content
+ *
+ * It can be replayed with synthetic payloads by JsTrafficReplayer.
+ */
+class JsTrafficRecording(
+    // 1 out of samplingInterval outermost calls has been recorded
+    val samplingInterval: Int,
+
+    // True if some calls were dropped because the recording reached its maximum size
+    val isTruncated: Boolean,
+
+    // Sorted by start time (outer calls before the calls nested into them)
+    val calls: List<Call>
+) {
+    // Order must match TrafficRecorder::CallType
+    enum class CallType {
+        EvaluateString,
+        CallJsMethod,
+        CallJsLambda,
+        JavaMethod,
+    }
+
+    // Order must match TrafficRecorder::ValueType
+    enum class ValueType {
+        Undefined,
+        Null,
+        Boolean,
+        Number,
+        String,  // size: length
+        Array,  // size: length
+        ArrayBuffer,  // size: byte length
+        Object,
+        Function,
+    }
+
+    data class Value(val type: ValueType, val size: Int)
+
+    data class Call(
+        val type: CallType,
+        // JS object name (Java to JS calls) or Java method name (JS to Java calls)
+        val name: String,
+        // Number of recorded calls in which this call is nested
+        val depth: Int,
+        val startTimeUs: Long,
+        val durationNs: Long,
+        val arguments: List<Value>
+    )
+
+    companion object {
+        private const val FORMAT_VERSION = 1
+        private const val FLAG_TRUNCATED = 0x01
+        private const val TAG_NAME = 0
+        private const val TAG_CALL = 1
+
+        fun read(file: File) = fromByteArray(file.readBytes())
+
+        // See TrafficRecorder for the binary format
+        fun fromByteArray(bytes: ByteArray): JsTrafficRecording {
+            if (bytes.isEmpty()) {
+                // Recording not started
+                return JsTrafficRecording(1, false, emptyList())
+            }
+
+            val reader = Reader(bytes)
+            if (bytes.size < 6 || String(bytes, 0, 4, Charsets.US_ASCII) != "JSBT") {
+                throw IllegalArgumentException("Not a JsBridge traffic recording")
+            }
+            reader.position = 4
+            val version = reader.readByte()
+            if (version != FORMAT_VERSION) {
+                throw IllegalArgumentException("Unsupported traffic recording version: $version")
+            }
+            val flags = reader.readByte()
+            val samplingInterval = reader.readVarint().toInt()
+
+            val names = mutableMapOf<Int, String>()
+            val calls = mutableListOf<Call>()
+            while (reader.hasMore()) {
+                when (val tag = reader.readByte()) {
+                    TAG_NAME -> {
+                        val nameId = reader.readVarint().toInt()
+                        names[nameId] = reader.readUtf8(reader.readVarint().toInt())
+                    }
+                    TAG_CALL -> {
+                        val callType = CallType.values()[reader.readByte()]
+                        val name = names[reader.readVarint().toInt()].orEmpty()
+                        val depth = reader.readVarint().toInt()
+                        val startTimeUs = reader.readVarint()
+                        val durationNs = reader.readVarint()
+                        val arguments = List(reader.readVarint().toInt()) {
+                            Value(ValueType.values()[reader.readByte()], reader.readVarint().toInt())
+                        }
+                        calls += Call(callType, name, depth, startTimeUs, durationNs, arguments)
+                    }
+                    else -> throw IllegalArgumentException("Invalid traffic recording tag: $tag")
+                }
+            }
+
+            calls.sortWith(compareBy<Call>({ it.startTimeUs }, { it.depth }))
+            return JsTrafficRecording(samplingInterval, (flags and FLAG_TRUNCATED) != 0, calls)
+        }
+    }
+
+    private class Reader(private val bytes: ByteArray) {
+        var position = 0
+
+        fun hasMore() = position < bytes.size
+
+        fun readByte(): Int {
+            if (position >= bytes.size) {
+                throw IllegalArgumentException("Truncated traffic recording")
+            }
+            return bytes[position++].toInt() and 0xff
+        }
+
+        // Unsigned LEB128
+        fun readVarint(): Long {
+            var value = 0L
+            var shift = 0
+            while (true) {
+                val b = readByte()
+                value = value or ((b and 0x7f).toLong() shl shift)
+                if (b and 0x80 == 0) {
+                    return value
+                }
+                shift += 7
+            }
+        }
+
+        fun readUtf8(length: Int): String {
+            if (position + length > bytes.size) {
+                throw IllegalArgumentException("Truncated traffic recording")
+            }
+            return String(bytes, position, length, Charsets.UTF_8).also { position += length }
+        }
+    }
+}
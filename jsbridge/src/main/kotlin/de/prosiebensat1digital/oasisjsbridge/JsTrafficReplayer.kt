@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import de.prosiebensat1digital.oasisjsbridge.JsTrafficRecording.CallType
+import de.prosiebensat1digital.oasisjsbridge.JsTrafficRecording.ValueType
+import kotlinx.coroutines.delay
+
+/**
+ * Replay of a JsTrafficRecording on the given JsBridge with synthetic payloads of the recorded
+ * shape (argument types and sizes), e.g. to reproduce in the lab the bridge load of a production
+ * session
+ *
+ * Each outermost recorded call is replayed as:
+ * - EvaluateString: evaluation of JS code of the recorded size, calling a Java sink method with
+ *   the arguments of the Java methods called from the recorded evaluation
+ * - CallJsMethod, CallJsLambda: call of a JS sink method (via a JavaToJsInterface proxy) with the
+ *   recorded Java arguments, followed by an evaluation calling the Java sink for the Java methods
+ *   called from JS meanwhile
+ * - JavaMethod (e.g. called from a timer or a promise job): evaluation calling the Java sink
+ *
+ * Notes:
+ * - the content-dependent costs (e.g. the JS code executed by an evaluation) are not reproduced
+ * - Java objects, byte arrays and functions given to JS are replayed as wrapped Java objects
+ */
+class JsTrafficReplayer(private val jsBridge: JsBridge) {
+    internal interface JsSink : JavaToJsInterface {
+        fun call(vararg args: Any?)
+    }
+
+    internal interface JavaSink : JsToJavaInterface {
+        fun call(vararg args: Any?)
+    }
+
+    private class ReplayedCall(val call: JsTrafficRecording.Call) {
+        val nestedJavaCalls = mutableListOf<JsTrafficRecording.Call>()
+    }
+
+    // The sink JsValues are held to keep them alive during the replays
+    private var sinkJsValues: List<JsValue> = emptyList()
+    private var jsSink: JsSink? = null
+
+    /**
+     * Replay the given recording (as fast as possible unless preserveTiming is true) and return
+     * its duration in ns, until all the replayed calls have been executed
+     */
+    suspend fun replay(recording: JsTrafficRecording, preserveTiming: Boolean = false): Long {
+        val jsSink = jsSink ?: setUpSinks().also { jsSink = it }
+        val replayedCalls = groupCalls(recording.calls)
+
+        val startTimeNs = System.nanoTime()
+        val firstCallStartTimeUs = replayedCalls.firstOrNull()?.call?.startTimeUs ?: 0L
+        for (replayedCall in replayedCalls) {
+            if (preserveTiming) {
+                val elapsedUs = (System.nanoTime() - startTimeNs) / 1000L
+                val delayMs = (replayedCall.call.startTimeUs - firstCallStartTimeUs - elapsedUs) / 1000L
+                if (delayMs > 0) {
+                    delay(delayMs)
+                }
+            }
+
+            replayCall(jsSink, replayedCall)
+        }
+
+        // Wait until all the calls have been executed
+        jsBridge.evaluate<Unit>("undefined")
+        return System.nanoTime() - startTimeNs
+    }
+
+    private fun setUpSinks(): JsSink {
+        val javaSink: JavaSink = object : JavaSink {
+            override fun call(vararg args: Any?) = Unit
+        }
+        val javaSinkJsValue = JsValue.createJsToJavaProxy(jsBridge, javaSink)
+        javaSinkJsValue.assignToGlobal(JAVA_SINK_NAME)
+
+        val jsSinkJsValue = JsValue(jsBridge, "({ call: function() {} })")
+        sinkJsValues = listOf(javaSinkJsValue, jsSinkJsValue)
+        return jsSinkJsValue.createJavaToJsProxy()
+    }
+
+    // Attach the Java methods called from JS to the outermost call they are nested into
+    private fun groupCalls(calls: List<JsTrafficRecording.Call>): List<ReplayedCall> {
+        val replayedCalls = mutableListOf<ReplayedCall>()
+        for (call in calls) {
+            val outerCall = replayedCalls.lastOrNull()
+            if (call.depth == 0 || outerCall == null) {
+                replayedCalls += ReplayedCall(call)
+            } else if (call.type == CallType.JavaMethod) {
+                outerCall.nestedJavaCalls += call
+            }
+        }
+        return replayedCalls
+    }
+
+    private fun replayCall(jsSink: JsSink, replayedCall: ReplayedCall) {
+        val call = replayedCall.call
+        val javaCallsJs = replayedCall.nestedJavaCalls.joinToString("") { createJavaSinkCall(it.arguments) }
+
+        when (call.type) {
+            CallType.EvaluateString -> {
+                val codeLength = call.arguments.firstOrNull()?.size ?: 0
+                jsBridge.evaluateUnsync(padJs(javaCallsJs, codeLength))
+            }
+            CallType.CallJsMethod, CallType.CallJsLambda -> {
+                jsSink.call(*Array(call.arguments.size) { createJavaValue(call.arguments[it]) })
+                if (javaCallsJs.isNotEmpty()) {
+                    jsBridge.evaluateUnsync(javaCallsJs)
+                }
+            }
+            CallType.JavaMethod -> {
+                jsBridge.evaluateUnsync(createJavaSinkCall(call.arguments) + javaCallsJs)
+            }
+        }
+    }
+
+    private fun createJavaSinkCall(arguments: List<JsTrafficRecording.Value>): String {
+        return arguments.joinToString(", ", "$JAVA_SINK_NAME.call(", ");") { createJsValue(it) }
+    }
+
+    private fun createJsValue(value: JsTrafficRecording.Value): String = when (value.type) {
+        ValueType.Undefined -> "undefined"
+        ValueType.Null -> "null"
+        ValueType.Boolean -> "true"
+        ValueType.Number -> "1.5"
+        ValueType.String -> "'x'.repeat(${value.size})"
+        ValueType.Array -> "new Array(${value.size})"
+        ValueType.ArrayBuffer -> "new ArrayBuffer(${value.size})"
+        ValueType.Object -> "{}"
+        ValueType.Function -> "function() {}"
+    }
+
+    private fun createJavaValue(value: JsTrafficRecording.Value): Any? = when (value.type) {
+        ValueType.Undefined, ValueType.Null -> null
+        ValueType.Boolean -> true
+        ValueType.Number -> 1.5
+        ValueType.String -> "x".repeat(value.size)
+        ValueType.Array -> Array<Any?>(value.size) { 0 }
+        ValueType.ArrayBuffer -> ByteArray(value.size)
+        ValueType.Object, ValueType.Function -> Any()
+    }
+
+    // Pad the JS code with a comment to the given length
+    private fun padJs(js: String, length: Int): String {
+        val paddingLength = length - js.length
+        return when {
+            paddingLength >= 2 -> js + "//" + "x".repeat(paddingLength - 2)
+            paddingLength > 0 -> js + " ".repeat(paddingLength)
+            else -> js
+        }
+    }
+
+    companion object {
+        private const val JAVA_SINK_NAME = "__jsBridgeTrafficReplayJavaSink"
+    }
+}
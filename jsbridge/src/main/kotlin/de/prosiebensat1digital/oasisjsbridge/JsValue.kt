@@ -17,12 +17,23 @@ package de.prosiebensat1digital.oasisjsbridge
 
 import de.prosiebensat1digital.oasisjsbridge.JsBridgeError.*
 import kotlinx.coroutines.*
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.flow
+import timber.log.Timber
+import java.io.InputStream
 import java.lang.ref.WeakReference
+import java.nio.ByteBuffer
+import java.nio.channels.Channels
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.atomic.AtomicBoolean
 import java.util.concurrent.atomic.AtomicInteger
 import kotlin.reflect.typeOf
 import kotlin.coroutines.CoroutineContext
 import kotlin.coroutines.EmptyCoroutineContext
+import kotlin.reflect.KClass
 import kotlin.reflect.KType
+import kotlin.reflect.KTypeProjection
 import kotlin.reflect.full.createType
 
 /**
@@ -34,6 +45,9 @@ import kotlin.reflect.full.createType
  * The corresponding JS variable named "associatedJsName" is only valid during the lifetime of the Java
  * object and you should never explicitly refence it in your JS code.
  *
+ * JS values transferred from JS to Java are stored in a native table and referenced via a handle.
+ * Their global JS variable is only created when "associatedJsName" is accessed (e.g. via toString()).
+ *
  * Note: the initial JS code must be successfully evaluated via JS eval(). It implies that an object
  * or an anonymous function must be surrounded by brackets, e.g.:
  * - `val jsObject = JsValue(jsBridge, "({ a: 1, b: 'two' })")
@@ -43,12 +57,21 @@ open class JsValue
 internal constructor(
     jsBridge: JsBridge,
     jsCode: String?,
-    val associatedJsName: String
+    associatedJsName: String,
+
+    // Handle of the JS value in the native JsValue table (0 if the value is only referenced by
+    // its global JS name). Read from JNI.
+    internal val nativeHandle: Long = 0L
 ) {
     // Create a JsValue without initial value
     internal constructor(jsBridge: JsBridge)
             : this(jsBridge, jsCode = null, associatedJsName = generateJsGlobalName())
 
+    // Create a JsValue stored in the native JsValue table
+    @Suppress("UNUSED")  // Called from JNI
+    private constructor(jsBridge: JsBridge, nativeHandle: Long)
+            : this(jsBridge, jsCode = null, associatedJsName = generateJsGlobalName(), nativeHandle = nativeHandle)
+
     /**
      * Create a JsValue with an initial value (from JS code)
      */
@@ -58,13 +81,139 @@ internal constructor(
     private var jsBridgeRef = WeakReference(jsBridge)
     val jsBridge: JsBridge? get() = jsBridgeRef.get()
 
-    internal var codeEvaluationDeferred: Deferred<Unit>? = jsCode?.let {
+    private val jsName = associatedJsName
+
+    // A JsValue stored in the native JsValue table is only assigned to its global JS variable
+    // when the associated JS name is accessed for the first time
+    private val isNativeHandleCopiedToGlobal = AtomicBoolean(false)
+
+    /**
+     * Name of the global JS variable holding the value
+     */
+    val associatedJsName: String
+        get() {
+            if (nativeHandle != 0L && isNativeHandleCopiedToGlobal.compareAndSet(false, true)) {
+                jsBridge?.copyJsValueHandle(jsName, nativeHandle)
+            }
+            return jsName
+        }
+
+    // Name of the global JS variable if it has already been assigned, null otherwise
+    internal val assignedJsName: String?
+        get() = if (nativeHandle == 0L || isNativeHandleCopiedToGlobal.get()) jsName else null
+
+    // Handles of the native bindings created when registering the value as a JS object or
+    // lambda. They are released together with the JsValue.
+    internal val bindingHandles = CopyOnWriteArrayList<Long>()
+
+        internal var codeEvaluationDeferred: Deferred<Unit>? = jsCode?.let {
         jsBridge.assignJsValueAsync(this@JsValue, jsCode)
     }
 
     companion object {
         private var internalCounter = AtomicInteger(0)
 
+        const val DEFAULT_FLOW_BATCH_SIZE = 64
+
+        // Create a function pulling up to n values from the given (async) iterable or iterator and
+        // returning a promise of the values (fewer than n when the iterator is done). Pulling 0
+        // values closes the iterator.
+        // Note: ES5 syntax (Duktape)
+        private const val JS_CREATE_ITERATOR_PULLER = """function(iterable) {
+              var iterator = iterable;
+              if (typeof Symbol !== "undefined" && Symbol.asyncIterator && typeof iterable[Symbol.asyncIterator] === "function") {
+                iterator = iterable[Symbol.asyncIterator]();
+              } else if (typeof Symbol !== "undefined" && Symbol.iterator && typeof iterable[Symbol.iterator] === "function") {
+                iterator = iterable[Symbol.iterator]();
+              }
+              var values;
+              function pull(n) {
+                while (values.length < n) {
+                  var result = iterator.next();
+                  if (result && typeof result.then === "function") {
+                    return result.then(function(asyncResult) {
+                      if (asyncResult.done) { return values; }
+                      values.push(asyncResult.value);
+                      return pull(n);
+                    });
+                  }
+                  if (result.done) { return values; }
+                  values.push(result.value);
+                }
+                return values;
+              }
+              return function(n) {
+                values = [];
+                if (n === 0) {
+                  var ret = typeof iterator["return"] === "function" ? iterator["return"]() : undefined;
+                  return Promise.resolve(ret).then(function() { return values; });
+                }
+                return new Promise(function(resolve) { resolve(pull(n)); });
+              };
+            }"""
+
+        // Create a JS async iterable whose values are pulled in batches via the given JS-to-Java
+        // pull(count) function (which returns a promise of up to count values, or of no value
+        // when the flow is complete). The next batch is prefetched once half of the buffered
+        // values have been consumed. Pulling 0 values cancels the flow collection.
+        // Note: ES5 syntax (Duktape)
+        private const val JS_CREATE_FLOW_ITERABLE = """function(pull, batchSize) {
+              var buffer = [];
+              var index = 0;
+              var pending = null;
+              var isDone = false;
+              var isClosed = false;
+              var error = null;
+              function fetch() {
+                if (pending === null) {
+                  pending = pull(batchSize).then(function(values) {
+                    pending = null;
+                    if (isClosed) { return; }
+                    if (values.length === 0) { isDone = true; }
+                    buffer = buffer.slice(index).concat(values);
+                    index = 0;
+                  }, function(e) {
+                    pending = null;
+                    isDone = true;
+                    error = e;
+                  });
+                }
+                return pending;
+              }
+              function next() {
+                if (index < buffer.length) {
+                  var value = buffer[index++];
+                  // Prefetch the next batch once half of the buffered values have been consumed
+                  if (!isDone && buffer.length - index <= batchSize / 2) { fetch(); }
+                  return Promise.resolve({ value: value, done: false });
+                }
+                if (error !== null) {
+                  var e = error;
+                  error = null;
+                  return Promise.reject(e);
+                }
+                if (isDone) { return Promise.resolve({ value: undefined, done: true }); }
+                return fetch().then(next);
+              }
+              var iterator = {
+                next: next,
+                "return": function(value) {
+                  if (!isDone) {
+                    isDone = true;
+                    isClosed = true;
+                    buffer = [];
+                    index = 0;
+                    pull(0);
+                  }
+                  return Promise.resolve({ value: value, done: true });
+                }
+              };
+              if (typeof Symbol !== "undefined" && Symbol.asyncIterator) {
+                iterator[Symbol.asyncIterator] = function() { return this; };
+              }
+              return iterator;
+            }"""
+
         /**
          * Create a JsValue which is a JS function as created with JS "new Function(args..., code)", e.g.:
          * val jsValue = JsValue.newFunction(jsBridge, "a", "b", "return a + b;")
@@ -108,6 +257,50 @@ internal constructor(
             return jsBridge.registerJsToJavaInterface(jsToJavaInterface.kotlin, javaObject)
         }
 
+        /**
+         * Create many JsValues which are JS proxies to Java objects, with a single registration
+         * in the JS thread (e.g. at startup).
+         *
+         * Each registration is a pair of (JsToJavaInterface, Java object) and the returned
+         * proxies are in the same order as the registrations.
+         */
+        fun createJsToJavaProxies(jsBridge: JsBridge, registrations: List<Pair<KClass<*>, JsToJavaInterface>>): List<JsToJavaProxy<JsToJavaInterface>> {
+            return jsBridge.registerJsToJavaInterfaces(registrations)
+        }
+
+        /**
+         * Create many Java proxies to JS objects, with a single registration in the JS thread
+         * (e.g. at startup).
+         *
+         * Each registration is a pair of (JS value, JavaToJsInterface) and the returned proxies
+         * are in the same order as the registrations.
+         * -> see JsValue.createJavaToJsProxy(check: Boolean)
+         */
+        suspend fun createJavaToJsProxies(jsBridge: JsBridge, registrations: List<Pair<JsValue, KClass<out JavaToJsInterface>>>, check: Boolean): List<JavaToJsInterface> {
+            return jsBridge.registerJavaToJsInterfaces(registrations, check)
+        }
+
+
+        // Kotlin Flow as JS async iterable
+        // ---
+
+        /**
+         * Create a JsValue which is a JS async iterable (e.g. to be consumed via "for await") of
+         * the values of the given Flow
+         *
+         * Notes:
+         * - the flow is only collected when the iteration starts, outside of the JS thread
+         * - the values are delivered to JS in batches of up to batchSize values (one promise per
+         * batch) and buffered in JS, the next batch being prefetched
+         * - the flow collection is cancelled when the iterator return() method is called (e.g. on
+         * "break" in a "for await" loop) or, if return() is never called, when the iterable has
+         * been garbage-collected by JS and Java
+         */
+        @OptIn(ExperimentalStdlibApi::class)
+        inline fun <reified T> fromFlow(jsBridge: JsBridge, flow: Flow<T>, batchSize: Int = DEFAULT_FLOW_BATCH_SIZE): JsValue {
+            return fromFlowHelper(jsBridge, flow, batchSize, listOf(typeOf<Int>(), typeOf<Deferred<List<T>>>()))
+        }
+
 
         // Proxy Java to JS lambda
         // ---
@@ -182,9 +375,137 @@ internal constructor(
         }
 
 
+        // Parse JSON into a JSValue
+        // ---
+
+        /**
+         * Create a JsValue by parsing the UTF-8 JSON read from the given stream.
+         *
+         * The JSON is read into a native (direct) buffer which is parsed by the JS engine,
+         * without creating any intermediate Java String. This reduces the peak memory usage when
+         * loading large JSON data compared to evaluating a string or using a JsonObjectWrapper.
+         *
+         * Note: the stream is entirely read (and closed) in the calling thread
+         */
+        @JvmStatic
+        fun fromJson(jsBridge: JsBridge, jsonStream: InputStream): JsValue {
+            return jsBridge.parseJsonBuffer(readToDirectBuffer(jsonStream))
+        }
+
+        /**
+         * Create a JsValue by parsing the UTF-8 JSON contained in the given buffer (from its
+         * position to its limit).
+         *
+         * Notes:
+         * - direct buffers are parsed without any copy on the Java side
+         * - the buffer content must not be modified until the JsValue has been evaluated
+         */
+        @JvmStatic
+        fun fromJson(jsBridge: JsBridge, jsonBuffer: ByteBuffer): JsValue {
+            return jsBridge.parseJsonBuffer(jsonBuffer)
+        }
+
+
         // Private
         // ---
 
+        private const val JSON_READ_BUFFER_SIZE = 64 * 1024
+
+        // Read the whole stream into a direct buffer followed by (at least) one zero byte which
+        // allows QuickJS to parse it without any further copy
+        private fun readToDirectBuffer(inputStream: InputStream): ByteBuffer {
+            var buffer = ByteBuffer.allocateDirect(maxOf(inputStream.available() + 1, JSON_READ_BUFFER_SIZE))
+
+            Channels.newChannel(inputStream).use { channel ->
+                while (true) {
+                    if (buffer.remaining() <= 1) {
+                        buffer.flip()
+                        buffer = ByteBuffer.allocateDirect(buffer.capacity() * 2).put(buffer)
+                    }
+
+                    // Keep the last byte for the zero terminator
+                    buffer.limit(buffer.capacity() - 1)
+                    val readCount = channel.read(buffer)
+                    buffer.limit(buffer.capacity())
+                    if (readCount < 0) break
+                }
+            }
+
+            buffer.flip()
+            return buffer
+        }
+
+        @PublishedApi
+        internal fun <T> fromFlowHelper(jsBridge: JsBridge, flow: Flow<T>, batchSize: Int, pullTypes: List<KType>): JsValue {
+            require(batchSize > 0) { "Invalid flow batch size: $batchSize" }
+
+            // Child job of the JsBridge which can be cancelled without affecting the JsBridge
+            val scope = CoroutineScope(jsBridge.coroutineContext + Job(jsBridge.coroutineContext[Job]) + Dispatchers.Default)
+            val channel = Channel<T>(batchSize)
+            val producer = lazy {
+                scope.launch {
+                    try {
+                        flow.collect { channel.send(it) }
+                        channel.close()
+                    } catch (t: Throwable) {
+                        channel.close(t)
+                    }
+                }
+            }
+
+            // Only referenced by the pull function: the producer would otherwise stay suspended
+            // in send() forever if JS drops the iterator without calling return()
+            val scopeGuard = FlowScopeGuard(scope)
+
+            val pull: (Int) -> Deferred<List<T>> = { count ->
+                scopeGuard.hold()
+                if (count == 0) {
+                    if (producer.isInitialized()) {
+                        producer.value.cancel()
+                    }
+                    channel.cancel()
+                    CompletableDeferred(emptyList())
+                } else {
+                    producer.value
+                    scope.async { receiveFlowBatch(channel, count) }
+                }
+            }
+
+            val pullJsValue = jsBridge.registerJsToJavaFunction(pull, pullTypes)
+            val jsValue = JsValue(jsBridge, "($JS_CREATE_FLOW_ITERABLE)($pullJsValue, $batchSize)")
+            pullJsValue.hold()
+
+            return jsValue
+        }
+
+        // Cancel the flow scope when the (JS-to-Java) pull function has been garbage-collected
+        private class FlowScopeGuard(private val scope: CoroutineScope) {
+            fun hold() = Unit
+
+            protected fun finalize() {
+                scope.cancel()
+            }
+        }
+
+        // Wait for the next value and return it together with the values which are already
+        // available (up to count values), or an empty list when the flow is complete
+        private suspend fun <T> receiveFlowBatch(channel: Channel<T>, count: Int): List<T> {
+            val firstResult = channel.receiveCatching()
+            firstResult.exceptionOrNull()?.let { throw it }
+            if (firstResult.isClosed) {
+                return emptyList()
+            }
+
+            val values = ArrayList<T>(count)
+            values.add(firstResult.getOrThrow())
+            while (values.size < count) {
+                val result = channel.tryReceive()
+                if (!result.isSuccess) break
+                values.add(result.getOrThrow())
+            }
+            return values
+        }
+
         @JvmStatic
         protected fun generateJsGlobalName(): String {
             val suffix = internalCounter.incrementAndGet()
@@ -223,7 +544,7 @@ internal constructor(
             return
         }
 
-        //Timber.v("Deleting JsValue $associatedJsName")
+        //Timber.v("Deleting JsValue $jsName")
         jsBridge.deleteJsValue(this)
     }
 
@@ -237,10 +558,10 @@ internal constructor(
 
     override fun equals(other: Any?): Boolean {
         if (other !is JsValue) return false
-        return associatedJsName == other.associatedJsName
+        return jsName == other.jsName
     }
 
-    override fun hashCode(): Int = associatedJsName.hashCode()
+    override fun hashCode(): Int = jsName.hashCode()
 
     fun copyTo(other: JsValue) {
         jsBridge?.copyJsValue(other.associatedJsName, this@JsValue)
@@ -263,6 +584,11 @@ internal constructor(
         val jsBridge = jsBridge
                 ?: throw JsValueEvaluationError(associatedJsName, customMessage = "Cannot evaluate JS value because the JS interpreter has been destroyed")
 
+        if (jsBridge.isJsThread()) {
+            // Direct call (e.g. from Java code called by JS): no dispatching and no runBlocking
+            return jsBridge.evaluateJsValueDirect(this, typeOf<T>(), true)
+        }
+
         return runBlocking(context) {
             jsBridge.evaluateJsValue(this@JsValue, typeOf<T>(), true)
         }
@@ -275,6 +601,10 @@ internal constructor(
         val jsBridge = jsBridge
                 ?: throw JsValueEvaluationError(associatedJsName, customMessage = "Cannot evaluate JS value because the JS interpreter has been destroyed")
 
+        if (jsBridge.isJsThread()) {
+            return jsBridge.evaluateJsValueDirect(this, javaClass?.kotlin?.createType(), false)
+        }
+
         return runBlocking {
             jsBridge.evaluateJsValue(this@JsValue, javaClass?.kotlin?.createType(), false)
         }
@@ -294,6 +624,88 @@ internal constructor(
         return jsBridge.evaluateJsValueAsync(this, typeOf<T>())
     }
 
+    // Native property access
+    //
+    // Unlike evaluate(), these methods do not generate and evaluate any JS code: the JS object is
+    // accessed directly in the JS engine.
+    // ---
+
+    /**
+     * Read and convert the property with the given key
+     */
+    @OptIn(ExperimentalStdlibApi::class)
+    suspend inline fun <reified T: Any?> get(key: String): T {
+        return getJsProperty(key, -1, typeOf<T>())
+    }
+
+    /**
+     * Read and convert the element with the given index (for arrays)
+     */
+    @OptIn(ExperimentalStdlibApi::class)
+    suspend inline fun <reified T: Any?> get(index: Int): T {
+        return getJsProperty(null, index, typeOf<T>())
+    }
+
+    /**
+     * Convert and assign the property with the given key
+     */
+    @OptIn(ExperimentalStdlibApi::class)
+    suspend inline fun <reified T: Any?> set(key: String, value: T) {
+        setJsProperty(key, -1, value, typeOf<T>())
+    }
+
+    /**
+     * Convert and assign the element with the given index (for arrays)
+     */
+    @OptIn(ExperimentalStdlibApi::class)
+    suspend inline fun <reified T: Any?> set(index: Int, value: T) {
+        setJsProperty(null, index, value, typeOf<T>())
+    }
+
+    /**
+     * Call the method with the given name and convert its return value
+     *
+     * Note: the arguments are converted according to their (runtime) Java class
+     */
+    @OptIn(ExperimentalStdlibApi::class)
+    suspend inline fun <reified R: Any?> callMethod(name: String, vararg args: Any?): R {
+        return callJsMethod(name, args, typeOf<R>())
+    }
+
+    /**
+     * Result of the JS typeof operator (e.g. "object", "function", "undefined")
+     */
+    suspend fun typeOf(): String {
+        val jsBridge = jsBridge
+            ?: throw JsValueEvaluationError(associatedJsName, customMessage = "Cannot read JS value type because the JS interpreter has been destroyed")
+
+        return jsBridge.getJsValueType(this)
+    }
+
+    @PublishedApi
+    internal suspend fun <T: Any?> getJsProperty(key: String?, index: Int, type: KType): T {
+        val jsBridge = jsBridge
+            ?: throw JsValueEvaluationError(associatedJsName, customMessage = "Cannot read JS property because the JS interpreter has been destroyed")
+
+        return jsBridge.getJsValueProperty(this, key, index, type)
+    }
+
+    @PublishedApi
+    internal suspend fun setJsProperty(key: String?, index: Int, value: Any?, type: KType) {
+        val jsBridge = jsBridge
+            ?: throw JsValueEvaluationError(associatedJsName, customMessage = "Cannot set JS property because the JS interpreter has been destroyed")
+
+        jsBridge.setJsValueProperty(this, key, index, value, type)
+    }
+
+    @PublishedApi
+    internal suspend fun <R: Any?> callJsMethod(name: String, args: Array<out Any?>, type: KType): R {
+        val jsBridge = jsBridge
+            ?: throw JsValueEvaluationError(associatedJsName, customMessage = "Cannot call JS method because the JS interpreter has been destroyed")
+
+        return jsBridge.callJsValueMethod(this, name, args, type)
+    }
+
     /**
      * Await a JS promise:
      * - if the JS value is a promise, wait until the promise has been resolved (or rejected) and return a new JsValue
@@ -400,6 +812,30 @@ internal constructor(
         return jsBridge.registerJavaToJsInterfaceBlocking(this, javaToJsInterface.kotlin, check, context)
     }
 
+    /**
+     * Create a Java-to-JS stub to a JS object: createStub returns an implementation of the
+     * JavaToJsInterface (e.g. hand-written or generated) which calls the JS methods via the given
+     * JsBridge.JavaToJsCaller. Unlike the proxy objects, the calls do not go through reflection.
+     *
+     * Notes:
+     * - the method indices should be resolved once via JavaToJsCaller.methodIndex()
+     * - when check = true, this method will block the current thread until the object has been
+     * registered or will throw an exception if the JS object does not implement all the methods of
+     * the JavaToJsInterface
+     */
+    @JvmOverloads
+    fun <T: JavaToJsInterface> createJavaToJsStub(
+        javaToJsInterface: Class<T>,
+        check: Boolean = false,
+        context: CoroutineContext? = null,
+        createStub: (JsBridge.JavaToJsCaller) -> T
+    ): T {
+        val jsBridge = jsBridge
+                ?: throw JavaToJsInterfaceRegistrationError(javaToJsInterface.kotlin, customMessage = "Cannot create a Java-to-JS interface stub because the JS interpreter has been destroyed")
+
+        return jsBridge.registerJavaToJsStubBlocking(this, javaToJsInterface.kotlin, check, context, createStub)
+    }
+
 
     // Proxy JS to Java function
     // ---
@@ -720,9 +1156,121 @@ internal constructor(
     }
 
 
+    // Proxy JS to Java batch function
+    //
+    // The returned function calls the JS function once for each given argument (set) in a single
+    // native call, e.g. to evaluate the same JS predicate over many records.
+    // ---
+
+    @OptIn(ExperimentalStdlibApi::class)
+    inline fun <reified T1, reified R> createJavaToJsBatchProxyFunction1(): suspend (List<T1>) -> List<R> {
+        val types = listOf(typeOf<T1>(), typeOf<R>())
+        val functionWithParamArrays = createJavaToJsBatchProxyFunctionHelper<R>(types)
+        return { params ->
+            functionWithParamArrays(Array(params.size) { i -> arrayOf(params[i]) })
+        }
+    }
+
+    @OptIn(ExperimentalStdlibApi::class)
+    inline fun <reified T1, reified T2, reified R> createJavaToJsBatchProxyFunction2(): suspend (List<Pair<T1, T2>>) -> List<R> {
+        val types = listOf(typeOf<T1>(), typeOf<T2>(), typeOf<R>())
+        val functionWithParamArrays = createJavaToJsBatchProxyFunctionHelper<R>(types)
+        return { params ->
+            functionWithParamArrays(Array(params.size) { i -> arrayOf(params[i].first, params[i].second) })
+        }
+    }
+
+    @OptIn(ExperimentalStdlibApi::class)
+    inline fun <reified T1, reified T2, reified T3, reified R> createJavaToJsBatchProxyFunction3(): suspend (List<Triple<T1, T2, T3>>) -> List<R> {
+        val types = listOf(typeOf<T1>(), typeOf<T2>(), typeOf<T3>(), typeOf<R>())
+        val functionWithParamArrays = createJavaToJsBatchProxyFunctionHelper<R>(types)
+        return { params ->
+            functionWithParamArrays(Array(params.size) { i -> arrayOf(params[i].first, params[i].second, params[i].third) })
+        }
+    }
+
+
+    // JS (async) iterator as Kotlin Flow
+    //
+    // The values are pulled from JS in batches: each batch costs a single JS call and a single
+    // promise round-trip and its values are converted with the element type, e.g. to consume a JS
+    // async generator producing many records.
+    // ---
+
+    /**
+     * Consume a JS (async) iterable or iterator (e.g. the object returned by an async generator)
+     * as a Flow
+     *
+     * Notes:
+     * - the JS values are pulled in batches of up to batchSize values when the flow is collected
+     * - the iterator return() method is called when the collection stops early
+     * - as with a JS generator, the flow can only be collected once
+     */
+    @OptIn(ExperimentalStdlibApi::class)
+    inline fun <reified T: Any?> toFlow(batchSize: Int = DEFAULT_FLOW_BATCH_SIZE): Flow<T> {
+        return createFlowHelper(typeOf<T>(), batchSize)
+    }
+
+
     // Internal
     // ---
 
+    @OptIn(ExperimentalStdlibApi::class)
+    @PublishedApi
+    internal fun <T> createFlowHelper(elementType: KType, batchSize: Int): Flow<T> {
+        require(batchSize > 0) { "Invalid flow batch size: $batchSize" }
+
+        return flow {
+            val jsBridge = jsBridge
+                    ?: throw JavaToJsFunctionRegistrationError("<flow>", customMessage = "Cannot create a flow because the JS interpreter has been destroyed")
+
+            // JS function pulling the next values (up to the given count) of the iterator
+            val pullerJsValue = JsValue(jsBridge, "($JS_CREATE_ITERATOR_PULLER)(${this@JsValue})")
+            this@JsValue.hold()
+
+            val listType = List::class.createType(listOf(KTypeProjection.invariant(elementType)))
+            val pull = pullerJsValue.createJavaToJsProxyFunctionAsyncHelper<Any?>(listOf(typeOf<Int>(), listType))
+
+            var isDone = false
+            try {
+                do {
+                    @Suppress("UNCHECKED_CAST")
+                    val values = pull(arrayOf(batchSize)) as List<T>
+                    isDone = values.size < batchSize
+                    values.forEach { emit(it) }
+                } while (!isDone)
+            } finally {
+                if (!isDone) {
+                    // Close the iterator (count = 0)
+                    // (a failure must not hide the original exception)
+                    withContext(NonCancellable) {
+                        runCatching { pull(arrayOf(0)) }
+                                .onFailure { Timber.w(it, "Could not close the JS iterator") }
+                    }
+                }
+                pullerJsValue.release()
+            }
+        }
+    }
+
+    @OptIn(ExperimentalStdlibApi::class)
+    @PublishedApi
+    internal inline fun <reified R> createJavaToJsBatchProxyFunctionHelper(types: List<KType>): suspend (Array<Array<Any?>>) -> List<R> {
+        val awaitJsPromise = types.lastOrNull()?.classifier != Deferred::class
+        val lambdaJsValue = jsBridge?.registerJsLambdaAsync(this, types)
+                ?: throw JavaToJsFunctionRegistrationError("<lambda>", customMessage = "Cannot create a Java-to-JS function proxy because the JS interpreter has been destroyed")
+
+        return { paramArrays ->
+            val jsBridge = jsBridge
+                    ?: throw JavaToJsFunctionRegistrationError("<lambda>", customMessage = "Cannot create a Java-to-JS function proxy because the JS interpreter has been destroyed")
+
+            this.hold()
+
+            @Suppress("UNCHECKED_CAST")
+            jsBridge.callJsLambdaBatch(lambdaJsValue, paramArrays, awaitJsPromise).asList() as List<R>
+        }
+    }
+
     @OptIn(ExperimentalStdlibApi::class)
     @PublishedApi
     internal suspend inline fun <reified R> createJavaToJsProxyFunctionHelper(types: List<KType>, waitForRegistration: Boolean): suspend (Array<Any?>) -> R {
@@ -772,7 +1320,11 @@ internal constructor(
 
             this.hold()
 
-            runBlocking {
+            if (jsBridge.isJsThread()) {
+                // Direct call (e.g. from Java code called by JS): no dispatching and no runBlocking
+                @Suppress("UNCHECKED_CAST")
+                jsBridge.callJsLambdaDirect(lambdaJsValue, params, awaitJsPromise) as R
+            } else runBlocking {
                 @Suppress("UNCHECKED_CAST")
                 jsBridge.callJsLambda(lambdaJsValue, params, awaitJsPromise) as R
             }
@@ -118,6 +118,59 @@ internal class Method {
         this.returnParameter = returnParameter
     }
 
+    // JNI descriptor of the specialized "invoke" method generated by the Kotlin compiler in lambda
+    // classes which takes and returns unboxed primitives, or null if there is nothing to unbox or
+    // if the erased signature cannot be determined
+    //
+    // e.g.: "(ID)V" for (Int, Double) -> Unit
+    @Suppress("UNUSED")  // Called from JNI
+    val unboxedLambdaDescriptor: String?
+        get() {
+            val returnDescriptor = if (returnParameter.javaClass == Unit::class.java && !returnParameter.isNullable()) {
+                "V"
+            } else {
+                returnParameter.jniDescriptor ?: return null
+            }
+
+            val parameterDescriptors = parameters.map { it.jniDescriptor ?: return null }
+            if (returnParameter.javaClass?.isPrimitive != true && parameters.none { it.javaClass?.isPrimitive == true }) {
+                // No primitive => same as the generic (boxed) "invoke" method
+                return null
+            }
+
+            return parameterDescriptors.joinToString("", "(", ")") + returnDescriptor
+        }
+
+    // True if all the parameters are non-null primitives (except char) so that the arguments can
+    // be given to the native side as a single long[] (see JsBridge.packJsMethodArgs())
+    val hasPackableParameters: Boolean by lazy {
+        !isVarArgs && parameters.isNotEmpty() && parameters.all {
+            it.javaClass?.isPrimitive == true && it.javaClass != Char::class.java && !it.isNullable()
+        }
+    }
+
+    // Type signatures (see Parameter.typeSignature) of the return value and of the parameters,
+    // given to the native side in a single JNI call so that already shared types are resolved
+    // without walking through each Parameter. The element type is given for vararg parameters.
+    //
+    // Format: "<varargs flag (0/1)><return signature>\n<parameter 1 signature>\n..." where an
+    // empty signature means that the type cannot be shared
+    //
+    // e.g.: "0java.lang.String\nint\njava.util.List?<java.lang.Integer>" for (Int, List<Int>?) -> String
+    @Suppress("UNUSED")  // Called from JNI
+    val typeSignatures: String by lazy {
+        val parameterSignatures = parameters.mapIndexed { index, parameter ->
+            val signatureParameter = if (isVarArgs && index == parameters.size - 1) parameter.getGenericParameter() else parameter
+            signatureParameter?.typeSignature.orEmpty()
+        }
+
+        buildString {
+            append(if (isVarArgs) '1' else '0')
+            append(returnParameter.typeSignature.orEmpty())
+            parameterSignatures.forEach { append('\n').append(it) }
+        }
+    }
+
     @Suppress("UNUSED")  // Called from JNI
     fun callJavaLambda(obj: Any, args_: Array<Any?>): Any? {
         val func = obj as? Function<*>
@@ -16,6 +16,7 @@
 package de.prosiebensat1digital.oasisjsbridge
 
 import com.google.gson.Gson
+import java.util.concurrent.ConcurrentHashMap
 import kotlin.reflect.*
 import kotlin.reflect.full.memberFunctions
 
@@ -58,6 +59,15 @@ internal open class Parameter private constructor(
     constructor(javaClass: Class<*>, customClassLoader: ClassLoader?) : this(null, null, javaClass, javaClass.name, false, customClassLoader)
     constructor(parentMethod: Method, javaClass: Class<*>, customClassLoader: ClassLoader?) : this(parentMethod, null, javaClass, javaClass.name, false, customClassLoader)
 
+    // Reflection results read by the native side (via ParameterInterface), computed once when the
+    // Parameter is created instead of on each JNI call
+    private val javaName: String? = javaClass?.let {
+        // @Serializable classes are converted by SerializableCodec (see JavaTypeId.cpp)
+        if (isSerializableClass(it)) SERIALIZABLE_JAVA_NAME else it.name
+    }
+    private val nullable: Boolean = kotlinType?.isMarkedNullable == true
+    private val genericParameter: Parameter? by lazy { createGenericParameter() }
+
     @Suppress("UNUSED")  // Called from JNI
     fun getJava(): Class<*>? {
         return javaClass
@@ -65,12 +75,66 @@ internal open class Parameter private constructor(
 
     @Suppress("UNUSED")  // Called from JNI
     fun getJavaName(): String? {
-        return javaClass?.name
+        return javaName
     }
 
     @Suppress("UNUSED")  // Called from JNI
     fun isNullable(): Boolean {
-        return kotlinType?.isMarkedNullable == true
+        return nullable
+    }
+
+    // Signature of the whole parameter type (including nullability and generic parameters) used
+    // to share the native type instances, or null if the type cannot be shared (lambdas)
+    //
+    // e.g.: "java.util.List?<java.lang.String>"
+    @Suppress("UNUSED")  // Called from JNI
+    val typeSignature: String? by lazy {
+        val javaClass = javaClass ?: return@lazy null
+        if (Function::class.java.isAssignableFrom(javaClass)) {
+            // Lambda types hold their own method
+            return@lazy null
+        }
+
+        val javaComponentType = javaClass.componentType
+        val genericSignature = if (javaComponentType?.isPrimitive == true || (kotlinType == null && javaComponentType == null)) {
+            // Already given by the Java name or no generic type information
+            null
+        } else {
+            getGenericParameter()?.let { it.typeSignature ?: return@lazy null }
+        }
+
+        buildString {
+            append(javaClass.name)
+            if (isNullable()) append('?')
+            genericSignature?.let { append('<').append(it).append('>') }
+        }
+    }
+
+    // JNI descriptor of the erased Java type, or null if it is unknown or ambiguous (for nullable
+    // Kotlin primitives which might be mapped to the primitive Java type)
+    //
+    // e.g.: "I" for Int, "[I" for IntArray, "Ljava/lang/String;" for String
+    internal val jniDescriptor: String? by lazy {
+        val javaClass = javaClass ?: return@lazy null
+
+        if (javaClass.isPrimitive) {
+            if (isNullable()) return@lazy null
+
+            return@lazy when (javaClass) {
+                Boolean::class.javaPrimitiveType -> "Z"
+                Byte::class.javaPrimitiveType -> "B"
+                Char::class.javaPrimitiveType -> "C"
+                Short::class.javaPrimitiveType -> "S"
+                Int::class.javaPrimitiveType -> "I"
+                Long::class.javaPrimitiveType -> "J"
+                Float::class.javaPrimitiveType -> "F"
+                Double::class.javaPrimitiveType -> "D"
+                else -> "V"
+            }
+        }
+
+        val internalName = javaClass.name.replace('.', '/')
+        if (javaClass.isArray) internalName else "L$internalName;"
     }
 
     @Suppress("UNUSED")  // Called from JNI
@@ -116,8 +180,13 @@ internal open class Parameter private constructor(
     // e.g.:
     // - if the parameter is a Deferred<String>, return String::class.java
     // - if the parameter is an Array, return the array componet
+    // - if the parameter is a Map<String, Int>, return Int::class.java (the keys are always strings)
     @Suppress("UNUSED")  // Called from JNI
     fun getGenericParameter(): Parameter? {
+        return genericParameter
+    }
+
+    private fun createGenericParameter(): Parameter? {
         val javaComponentType = javaClass?.componentType
         if (javaComponentType?.isPrimitive == true) {
             // Primitives (for arrays) are always given by the Java component type
@@ -133,7 +202,8 @@ internal open class Parameter private constructor(
             }
         } else {
             // Use KType instance to create the (only) generic type
-            kotlinType.arguments.firstOrNull()?.type?.let { genericParameterType ->
+            val genericArguments = if (javaClass == Map::class.java) kotlinType.arguments.drop(1) else kotlinType.arguments
+            genericArguments.firstOrNull()?.type?.let { genericParameterType ->
                 Parameter(genericParameterType, customClassLoader)
             }
         }
@@ -144,7 +214,33 @@ internal open class Parameter private constructor(
 // Private
 // ---
 
+// The (optional) kotlinx.serialization annotation is looked up by name so that kotlinx.serialization
+// is only needed by the apps using it
+private const val SERIALIZABLE_ANNOTATION_NAME = "kotlinx.serialization.Serializable"
+private const val SERIALIZABLE_JAVA_NAME = "de.prosiebensat1digital.oasisjsbridge.SerializableCodec"
+
+private fun isSerializableClass(javaClass: Class<*>): Boolean {
+    if (javaClass.isPrimitive || javaClass.isArray || javaClass.name.startsWith("java.")) {
+        return false
+    }
+
+    return javaClass.annotations.any { it.annotationClass.java.name == SERIALIZABLE_ANNOTATION_NAME }
+}
+
+// Java classes resolved from Kotlin types with the default class loader. Types resolved with a
+// custom class loader are not cached to avoid keeping their classes (and class loader) alive.
+private val javaClassCache = ConcurrentHashMap<KType, Class<*>>()
+
 private fun findJavaClass(kotlinType: KType, customClassLoader: ClassLoader?): Class<*>? {
+    if (customClassLoader != null) {
+        return resolveJavaClass(kotlinType, customClassLoader)
+    }
+
+    javaClassCache[kotlinType]?.let { return it }
+    return resolveJavaClass(kotlinType, null)?.also { javaClassCache.putIfAbsent(kotlinType, it) }
+}
+
+private fun resolveJavaClass(kotlinType: KType, customClassLoader: ClassLoader?): Class<*>? {
     return when (val kotlinClassifier = kotlinType.classifier) {
         is KType -> {
             findJavaClass(kotlinClassifier, customClassLoader)
@@ -15,6 +15,11 @@
  */
 package de.prosiebensat1digital.oasisjsbridge
 
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.Deferred
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.GlobalScope
+import kotlinx.coroutines.async
 import org.json.JSONArray
 import org.json.JSONObject
 import org.json.JSONTokener
@@ -90,6 +95,11 @@ fun JsonObjectWrapper.toPayload() = Payload.fromJsonString(this.jsonString)
 fun JsonObjectWrapper.toPayloadObject() = PayloadObject.fromJsonString(this.jsonString)
 fun JsonObjectWrapper.toPayloadArray() = PayloadArray.fromJsonString(this.jsonString)
 
+// Parse the JSON string in the given dispatcher (natively once the JsBridge library has been
+// loaded), e.g. to keep large results of JS calls off the JS thread
+fun JsonObjectWrapper.toPayloadAsync(dispatcher: CoroutineDispatcher = Dispatchers.Default): Deferred<Payload?> =
+    GlobalScope.async(dispatcher) { JsBridge.parseJsonPayload(jsonString) }
+
 
 // String extensions
 // ---
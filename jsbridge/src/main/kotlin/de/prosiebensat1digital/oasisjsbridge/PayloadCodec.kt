@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+// Compact binary format used to transfer Payload values (Payload, PayloadObject, PayloadArray
+// parameters) between JS and Java without any JSON text encoding/parsing (see java-types/Payload.h)
+//
+// Each value starts with a tag byte:
+// - NULL, FALSE, TRUE: no data
+// - INT: zigzag varint (32-bit)
+// - DOUBLE: 8 bytes (little endian)
+// - LATIN1_STRING, UTF8_STRING: varint byte length + bytes (UTF-8 strings may contain surrogate
+//   pairs encoded separately as in CESU-8, which is the internal format of Duktape)
+// - ARRAY: 4-byte count (little endian) + count values
+// - OBJECT: 4-byte count (little endian) + count * (string key, value)
+// - SHAPED_OBJECT (@Serializable objects, Java -> JS only): varint shape index + values in the shape
+//   order; a new shape index (i.e. the number of shapes of the buffer) is directly followed by the
+//   shape definition: 4-byte count (little endian) + count string keys (see SerializableCodec)
+//
+// JS values which cannot be represented in JSON (undefined, functions, symbols) are skipped in
+// objects and replaced by null in arrays.
+internal object PayloadCodec {
+    const val TAG_NULL: Byte = 0
+    const val TAG_FALSE: Byte = 1
+    const val TAG_TRUE: Byte = 2
+    const val TAG_INT: Byte = 3
+    const val TAG_DOUBLE: Byte = 4
+    const val TAG_LATIN1_STRING: Byte = 5
+    const val TAG_UTF8_STRING: Byte = 6
+    const val TAG_ARRAY: Byte = 7
+    const val TAG_OBJECT: Byte = 8
+    const val TAG_SHAPED_OBJECT: Byte = 9
+
+    private const val INITIAL_BUFFER_SIZE = 4 * 1024
+
+    // Encoding buffer re-used for each conversion of the JS thread
+    private val encodingBuffer = ThreadLocal<ByteBuffer>()
+
+    // Bytes of the Latin-1 strings being decoded (bulk-copied out of the native buffer)
+    private val decodingBytes = ThreadLocal<ByteArray>()
+
+    // Decode the given buffer (which is only valid during the call) into a PayloadObject,
+    // PayloadArray or (if wrapPrimitives is set) a Payload wrapper of a primitive value
+    @JvmStatic
+    @Suppress("UNUSED")  // Called from JNI
+    fun decode(buffer: ByteBuffer, wrapPrimitives: Boolean): Any? {
+        buffer.order(ByteOrder.LITTLE_ENDIAN)
+        val value = decodeValue(buffer)
+
+        if (!wrapPrimitives) {
+            return value
+        }
+
+        return when (value) {
+            null -> PayloadNull()
+            is String -> PayloadString(value)
+            is Boolean -> PayloadBoolean(value)
+            is Number -> PayloadNumber(value)
+            else -> value
+        }
+    }
+
+    // Encode the given Payload (or Payload value) into a direct buffer whose capacity is the
+    // encoded size
+    //
+    // Note: the returned buffer is only valid until the next call
+    @JvmStatic
+    @Suppress("UNUSED")  // Called from JNI
+    fun encode(value: Any?): ByteBuffer = encodeWith { buffer -> encodeValue(buffer, value) }
+
+    // Run the given encoding into the (growing) encoding buffer of the thread and return it as in
+    // encode(). The encoding must be restartable (it is run again after each buffer overflow).
+    internal fun encodeWith(encode: (ByteBuffer) -> Unit): ByteBuffer {
+        var buffer = encodingBuffer.get() ?: newBuffer(INITIAL_BUFFER_SIZE)
+
+        while (true) {
+            buffer.clear()
+            try {
+                encode(buffer)
+                break
+            } catch (e: java.nio.BufferOverflowException) {
+                buffer = newBuffer(buffer.capacity() * 2)
+            }
+        }
+        encodingBuffer.set(buffer)
+
+        buffer.flip()
+        return buffer.slice()
+    }
+
+    private fun newBuffer(capacity: Int) = ByteBuffer.allocateDirect(capacity).order(ByteOrder.LITTLE_ENDIAN)
+
+    private fun decodeValue(buffer: ByteBuffer): Any? {
+        return when (val tag = buffer.get()) {
+            TAG_NULL -> null
+            TAG_FALSE -> false
+            TAG_TRUE -> true
+            TAG_INT -> {
+                val zigzag = readVarint(buffer)
+                (zigzag ushr 1) xor -(zigzag and 1)
+            }
+            TAG_DOUBLE -> buffer.double
+            TAG_LATIN1_STRING, TAG_UTF8_STRING -> decodeString(buffer, tag)
+            TAG_ARRAY -> {
+                val payloadArray = PayloadArray(buffer.int)
+                for (i in payloadArray.array.indices) {
+                    payloadArray.array[i] = decodeValue(buffer)
+                }
+                payloadArray
+            }
+            TAG_OBJECT -> {
+                val count = buffer.int
+                val payloadObject = PayloadObject()
+                repeat(count) {
+                    val key = decodeString(buffer, buffer.get())
+                    payloadObject.values[key] = decodeValue(buffer)
+                }
+                payloadObject
+            }
+            else -> throw IllegalArgumentException("Invalid payload tag: $tag")
+        }
+    }
+
+    internal fun decodeString(buffer: ByteBuffer, tag: Byte): String {
+        val byteLength = readVarint(buffer)
+
+        if (tag == TAG_LATIN1_STRING) {
+            var bytes = decodingBytes.get()
+            if (bytes == null || bytes.size < byteLength) {
+                bytes = ByteArray(maxOf(byteLength, 256))
+                decodingBytes.set(bytes)
+            }
+            buffer.get(bytes, 0, byteLength)
+            return String(bytes, 0, byteLength, Charsets.ISO_8859_1)
+        }
+
+        if (tag != TAG_UTF8_STRING) {
+            throw IllegalArgumentException("Invalid payload string tag: $tag")
+        }
+
+        // UTF-8 (also accepting separately encoded surrogates)
+        val chars = CharArray(byteLength)
+        var charCount = 0
+        val end = buffer.position() + byteLength
+        while (buffer.position() < end) {
+            val b0 = buffer.get().toInt() and 0xFF
+            when {
+                b0 < 0x80 -> chars[charCount++] = b0.toChar()
+                b0 < 0xE0 -> {
+                    val b1 = buffer.get().toInt() and 0x3F
+                    chars[charCount++] = (((b0 and 0x1F) shl 6) or b1).toChar()
+                }
+                b0 < 0xF0 -> {
+                    val b1 = buffer.get().toInt() and 0x3F
+                    val b2 = buffer.get().toInt() and 0x3F
+                    chars[charCount++] = (((b0 and 0x0F) shl 12) or (b1 shl 6) or b2).toChar()
+                }
+                else -> {
+                    val b1 = buffer.get().toInt() and 0x3F
+                    val b2 = buffer.get().toInt() and 0x3F
+                    val b3 = buffer.get().toInt() and 0x3F
+                    val codePoint = ((b0 and 0x07) shl 18) or (b1 shl 12) or (b2 shl 6) or b3
+                    chars[charCount++] = Character.highSurrogate(codePoint)
+                    chars[charCount++] = Character.lowSurrogate(codePoint)
+                }
+            }
+        }
+
+        return String(chars, 0, charCount)
+    }
+
+    private fun encodeValue(buffer: ByteBuffer, value: Any?) {
+        when (value) {
+            null, is PayloadNull -> buffer.put(TAG_NULL)
+            is Boolean -> buffer.put(if (value) TAG_TRUE else TAG_FALSE)
+            is Int, is Short, is Byte -> encodeInt(buffer, (value as Number).toInt())
+            is Long -> {
+                if (value >= Int.MIN_VALUE && value <= Int.MAX_VALUE) {
+                    encodeInt(buffer, value.toInt())
+                } else {
+                    buffer.put(TAG_DOUBLE).putDouble(value.toDouble())
+                }
+            }
+            is Number -> buffer.put(TAG_DOUBLE).putDouble(value.toDouble())
+            is String -> encodeString(buffer, value)
+            is PayloadString -> encodeString(buffer, value.value)
+            is PayloadNumber -> encodeValue(buffer, value.value)
+            is PayloadBoolean -> encodeValue(buffer, value.value)
+            is PayloadArray -> {
+                buffer.put(TAG_ARRAY).putInt(value.array.size)
+                value.array.forEach { encodeValue(buffer, it) }
+            }
+            is PayloadObject -> {
+                buffer.put(TAG_OBJECT).putInt(value.values.size)
+                value.values.forEach { (key, v) ->
+                    encodeString(buffer, key)
+                    encodeValue(buffer, v)
+                }
+            }
+            else -> throw IllegalArgumentException("Cannot encode value of type ${value.javaClass.name} as payload")
+        }
+    }
+
+    internal fun encodeInt(buffer: ByteBuffer, value: Int) {
+        buffer.put(TAG_INT)
+        writeVarint(buffer, (value shl 1) xor (value shr 31))
+    }
+
+    internal fun encodeString(buffer: ByteBuffer, s: String) {
+        if (s.all { it.code < 0x100 }) {
+            buffer.put(TAG_LATIN1_STRING)
+            writeVarint(buffer, s.length)
+            buffer.put(s.toByteArray(Charsets.ISO_8859_1))
+            return
+        }
+
+        // UTF-8 with separately encoded surrogates (CESU-8) which is accepted by both JS engines
+        var byteLength = 0
+        s.forEach { byteLength += if (it.code < 0x80) 1 else if (it.code < 0x800) 2 else 3 }
+
+        buffer.put(TAG_UTF8_STRING)
+        writeVarint(buffer, byteLength)
+        s.forEach {
+            val c = it.code
+            when {
+                c < 0x80 -> buffer.put(c.toByte())
+                c < 0x800 -> buffer.put((0xC0 or (c shr 6)).toByte()).put((0x80 or (c and 0x3F)).toByte())
+                else -> buffer.put((0xE0 or (c shr 12)).toByte())
+                    .put((0x80 or ((c shr 6) and 0x3F)).toByte())
+                    .put((0x80 or (c and 0x3F)).toByte())
+            }
+        }
+    }
+
+    internal fun readVarint(buffer: ByteBuffer): Int {
+        var result = 0
+        var shift = 0
+        while (true) {
+            val b = buffer.get().toInt()
+            result = result or ((b and 0x7F) shl shift)
+            if (b and 0x80 == 0) return result
+            shift += 7
+        }
+    }
+
+    internal fun writeVarint(buffer: ByteBuffer, value: Int) {
+        var v = value
+        while (v and 0x7F.inv() != 0) {
+            buffer.put(((v and 0x7F) or 0x80).toByte())
+            v = v ushr 7
+        }
+        buffer.put(v.toByte())
+    }
+}
@@ -24,7 +24,7 @@ fun payloadObjectOf(vararg values: Pair<String, Any?>) = PayloadObject.fromValue
 
 class PayloadObject: Payload {
 
-    private val values = HashMap<String, Any?>()
+    internal val values = HashMap<String, Any?>()
 
     companion object {
         fun fromValues(vararg values: Pair<String, Any?>): PayloadObject = fromMap(hashMapOf(*values))
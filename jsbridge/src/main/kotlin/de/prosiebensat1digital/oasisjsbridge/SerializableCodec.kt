@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import de.prosiebensat1digital.oasisjsbridge.PayloadCodec.TAG_ARRAY
+import de.prosiebensat1digital.oasisjsbridge.PayloadCodec.TAG_DOUBLE
+import de.prosiebensat1digital.oasisjsbridge.PayloadCodec.TAG_FALSE
+import de.prosiebensat1digital.oasisjsbridge.PayloadCodec.TAG_INT
+import de.prosiebensat1digital.oasisjsbridge.PayloadCodec.TAG_LATIN1_STRING
+import de.prosiebensat1digital.oasisjsbridge.PayloadCodec.TAG_NULL
+import de.prosiebensat1digital.oasisjsbridge.PayloadCodec.TAG_OBJECT
+import de.prosiebensat1digital.oasisjsbridge.PayloadCodec.TAG_SHAPED_OBJECT
+import de.prosiebensat1digital.oasisjsbridge.PayloadCodec.TAG_TRUE
+import de.prosiebensat1digital.oasisjsbridge.PayloadCodec.TAG_UTF8_STRING
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.util.IdentityHashMap
+import java.util.concurrent.ConcurrentHashMap
+import kotlinx.serialization.ExperimentalSerializationApi
+import kotlinx.serialization.KSerializer
+import kotlinx.serialization.SerializationException
+import kotlinx.serialization.descriptors.SerialDescriptor
+import kotlinx.serialization.descriptors.StructureKind
+import kotlinx.serialization.encoding.AbstractDecoder
+import kotlinx.serialization.encoding.AbstractEncoder
+import kotlinx.serialization.encoding.CompositeDecoder
+import kotlinx.serialization.encoding.CompositeEncoder
+import kotlinx.serialization.modules.SerializersModule
+import kotlinx.serialization.serializer
+
+// Conversion of kotlinx.serialization @Serializable classes from/to the Payload binary format (see
+// PayloadCodec and java-types/Serializable.h) without any intermediate Payload or JSON string:
+// - JS -> Java: the values are directly decoded by the serializer of the class (unknown keys are
+//   ignored)
+// - Java -> JS: objects are encoded as shaped objects (see PayloadCodec), i.e. their keys are only
+//   written once per buffer and the JS objects of a class are created with the same property keys
+//
+// The serializer of each class and the encoded keys of each descriptor are only created once.
+//
+// Note: kotlinx.serialization is an optional dependency (which must be provided by the app) and
+// this object is only loaded when a @Serializable class is used as a parameter or return value.
+@OptIn(ExperimentalSerializationApi::class)
+internal object SerializableCodec {
+    private val serializersModule = SerializersModule {}
+
+    private val serializers = ConcurrentHashMap<Class<*>, KSerializer<Any?>>()
+
+    // Shape definitions (4-byte count + keys) of the encoded shaped objects
+    private val encodedShapes = ConcurrentHashMap<SerialDescriptor, ByteArray>()
+
+    // Decode the given buffer (which is only valid during the call) into an instance of the given
+    // @Serializable class
+    @JvmStatic
+    @Suppress("UNUSED")  // Called from JNI
+    fun decode(buffer: ByteBuffer, javaClass: Class<*>): Any? {
+        buffer.order(ByteOrder.LITTLE_ENDIAN)
+        return PayloadDecoder(buffer).decodeSerializableValue(getSerializer(javaClass))
+    }
+
+    // Encode the given instance of a @Serializable class into a direct buffer whose capacity is the
+    // encoded size
+    //
+    // Note: the returned buffer is only valid until the next call (see PayloadCodec.encode())
+    @JvmStatic
+    @Suppress("UNUSED")  // Called from JNI
+    fun encode(value: Any, javaClass: Class<*>): ByteBuffer {
+        val serializer = getSerializer(javaClass)
+        return PayloadCodec.encodeWith { buffer ->
+            PayloadEncoder(buffer, IdentityHashMap()).encodeSerializableValue(serializer, value)
+        }
+    }
+
+    private fun getSerializer(javaClass: Class<*>): KSerializer<Any?> {
+        return serializers.getOrPut(javaClass) {
+            @Suppress("UNCHECKED_CAST")
+            serializer(javaClass) as KSerializer<Any?>
+        }
+    }
+
+    private fun getEncodedShape(descriptor: SerialDescriptor): ByteArray {
+        return encodedShapes.getOrPut(descriptor) {
+            val keys = (0 until descriptor.elementsCount).map { descriptor.getElementName(it) }
+
+            // (tag + varint length + at most 3 bytes per char for each key)
+            val maxSize = 4 + keys.sumOf { 6 + 3 * it.length }
+            val buffer = ByteBuffer.allocate(maxSize).order(ByteOrder.LITTLE_ENDIAN)
+            buffer.putInt(keys.size)
+            keys.forEach { PayloadCodec.encodeString(buffer, it) }
+            buffer.array().copyOf(buffer.position())
+        }
+    }
+
+    private class PayloadEncoder(
+        private val buffer: ByteBuffer,
+        private val shapeIndexes: IdentityHashMap<SerialDescriptor, Int>,
+        private val isMap: Boolean = false,
+        private val shapeDescriptor: SerialDescriptor? = null,
+    ) : AbstractEncoder() {
+        override val serializersModule: SerializersModule get() = SerializableCodec.serializersModule
+
+        private var isMapKey = false
+        private var nextShapeElement = 0
+
+        override fun encodeElement(descriptor: SerialDescriptor, index: Int): Boolean {
+            isMapKey = isMap && index % 2 == 0
+
+            if (shapeDescriptor != null) {
+                // The values of a shaped object must be written in the shape order (and elements
+                // skipped by the serializer are set to null)
+                if (index < nextShapeElement) {
+                    throw SerializationException("Elements of ${descriptor.serialName} must be encoded in order")
+                }
+                while (nextShapeElement < index) {
+                    buffer.put(TAG_NULL)
+                    nextShapeElement++
+                }
+                nextShapeElement++
+            }
+            return true
+        }
+
+        override fun beginStructure(descriptor: SerialDescriptor): CompositeEncoder {
+            if (descriptor.kind == StructureKind.LIST || descriptor.kind == StructureKind.MAP) {
+                throw SerializationException("Cannot encode ${descriptor.serialName} without its size")
+            }
+
+            buffer.put(TAG_SHAPED_OBJECT)
+            val shapeIndex = shapeIndexes[descriptor]
+            if (shapeIndex == null) {
+                // New shape: directly followed by its definition
+                PayloadCodec.writeVarint(buffer, shapeIndexes.size)
+                shapeIndexes[descriptor] = shapeIndexes.size
+                buffer.put(getEncodedShape(descriptor))
+            } else {
+                PayloadCodec.writeVarint(buffer, shapeIndex)
+            }
+
+            return PayloadEncoder(buffer, shapeIndexes, shapeDescriptor = descriptor)
+        }
+
+        override fun beginCollection(descriptor: SerialDescriptor, collectionSize: Int): CompositeEncoder {
+            return when (descriptor.kind) {
+                StructureKind.LIST -> {
+                    buffer.put(TAG_ARRAY).putInt(collectionSize)
+                    PayloadEncoder(buffer, shapeIndexes)
+                }
+                StructureKind.MAP -> {
+                    buffer.put(TAG_OBJECT).putInt(collectionSize)
+                    PayloadEncoder(buffer, shapeIndexes, isMap = true)
+                }
+                else -> beginStructure(descriptor)
+            }
+        }
+
+        override fun endStructure(descriptor: SerialDescriptor) {
+            if (shapeDescriptor != null) {
+                while (nextShapeElement < shapeDescriptor.elementsCount) {
+                    buffer.put(TAG_NULL)
+                    nextShapeElement++
+                }
+            }
+        }
+
+        override fun encodeNull() {
+            buffer.put(TAG_NULL)
+        }
+
+        override fun encodeBoolean(value: Boolean) {
+            if (isMapKey) encodeKey(value) else buffer.put(if (value) TAG_TRUE else TAG_FALSE)
+        }
+
+        override fun encodeByte(value: Byte) = encodeInt(value.toInt())
+        override fun encodeShort(value: Short) = encodeInt(value.toInt())
+
+        override fun encodeInt(value: Int) {
+            if (isMapKey) encodeKey(value) else PayloadCodec.encodeInt(buffer, value)
+        }
+
+        override fun encodeLong(value: Long) {
+            when {
+                isMapKey -> encodeKey(value)
+                value >= Int.MIN_VALUE && value <= Int.MAX_VALUE -> PayloadCodec.encodeInt(buffer, value.toInt())
+                else -> buffer.put(TAG_DOUBLE).putDouble(value.toDouble())
+            }
+        }
+
+        override fun encodeFloat(value: Float) = encodeDouble(value.toDouble())
+
+        override fun encodeDouble(value: Double) {
+            if (isMapKey) encodeKey(value) else buffer.put(TAG_DOUBLE).putDouble(value)
+        }
+
+        override fun encodeChar(value: Char) = encodeString(value.toString())
+        override fun encodeString(value: String) = PayloadCodec.encodeString(buffer, value)
+
+        override fun encodeEnum(enumDescriptor: SerialDescriptor, index: Int) {
+            encodeString(enumDescriptor.getElementName(index))
+        }
+
+        // (JS object keys are always strings)
+        private fun encodeKey(value: Any) = PayloadCodec.encodeString(buffer, value.toString())
+    }
+
+    private class PayloadDecoder(
+        private val buffer: ByteBuffer,
+        private val kind: Kind = Kind.VALUE,
+        private val size: Int = 0,
+    ) : AbstractDecoder() {
+        enum class Kind { VALUE, ARRAY, MAP, OBJECT }
+
+        override val serializersModule: SerializersModule get() = SerializableCodec.serializersModule
+
+        private var index = 0  // next element (ARRAY, MAP) or entry (OBJECT)
+        private var isMapKey = false
+
+        override fun decodeElementIndex(descriptor: SerialDescriptor): Int {
+            return when (kind) {
+                Kind.VALUE -> CompositeDecoder.DECODE_DONE
+                Kind.ARRAY -> if (index < size) index++ else CompositeDecoder.DECODE_DONE
+                Kind.MAP -> {
+                    isMapKey = index % 2 == 0
+                    if (index < 2 * size) index++ else CompositeDecoder.DECODE_DONE
+                }
+                Kind.OBJECT -> decodeObjectElementIndex(descriptor)
+            }
+        }
+
+        private fun decodeObjectElementIndex(descriptor: SerialDescriptor): Int {
+            while (index < size) {
+                index++
+                val key = PayloadCodec.decodeString(buffer, buffer.get())
+                val elementIndex = descriptor.getElementIndex(key)
+                if (elementIndex != CompositeDecoder.UNKNOWN_NAME) {
+                    return elementIndex
+                }
+                skipValue()
+            }
+            return CompositeDecoder.DECODE_DONE
+        }
+
+        override fun decodeCollectionSize(descriptor: SerialDescriptor) = size
+
+        override fun beginStructure(descriptor: SerialDescriptor): CompositeDecoder {
+            return when (descriptor.kind) {
+                StructureKind.LIST -> PayloadDecoder(buffer, Kind.ARRAY, readHeader(TAG_ARRAY, descriptor))
+                StructureKind.MAP -> PayloadDecoder(buffer, Kind.MAP, readHeader(TAG_OBJECT, descriptor))
+                else -> PayloadDecoder(buffer, Kind.OBJECT, readHeader(TAG_OBJECT, descriptor))
+            }
+        }
+
+        override fun decodeNotNullMark() = buffer.get(buffer.position()) != TAG_NULL
+
+        override fun decodeNull(): Nothing? {
+            buffer.get()
+            return null
+        }
+
+        override fun decodeBoolean(): Boolean {
+            if (isMapKey) return decodeString().toBoolean()
+
+            return when (val tag = buffer.get()) {
+                TAG_TRUE -> true
+                TAG_FALSE -> false
+                else -> throw SerializationException("Unexpected payload tag $tag for a boolean")
+            }
+        }
+
+        override fun decodeByte() = if (isMapKey) decodeString().toByte() else decodeLongValue().toByte()
+        override fun decodeShort() = if (isMapKey) decodeString().toShort() else decodeLongValue().toShort()
+        override fun decodeInt() = if (isMapKey) decodeString().toInt() else decodeLongValue().toInt()
+        override fun decodeLong() = if (isMapKey) decodeString().toLong() else decodeLongValue()
+        override fun decodeFloat() = if (isMapKey) decodeString().toFloat() else decodeDoubleValue().toFloat()
+        override fun decodeDouble() = if (isMapKey) decodeString().toDouble() else decodeDoubleValue()
+        override fun decodeChar() = decodeString().single()
+        override fun decodeString() = PayloadCodec.decodeString(buffer, buffer.get())
+
+        override fun decodeEnum(enumDescriptor: SerialDescriptor): Int {
+            val name = decodeString()
+            val index = enumDescriptor.getElementIndex(name)
+            if (index == CompositeDecoder.UNKNOWN_NAME) {
+                throw SerializationException("${enumDescriptor.serialName} does not contain element with name '$name'")
+            }
+            return index
+        }
+
+        private fun readHeader(expectedTag: Byte, descriptor: SerialDescriptor): Int {
+            val tag = buffer.get()
+            if (tag != expectedTag) {
+                throw SerializationException("Unexpected payload tag $tag for ${descriptor.serialName}")
+            }
+            return buffer.int
+        }
+
+        private fun decodeLongValue(): Long {
+            return when (val tag = buffer.get()) {
+                TAG_INT -> decodeIntValue().toLong()
+                TAG_DOUBLE -> buffer.double.toLong()
+                else -> throw SerializationException("Unexpected payload tag $tag for a number")
+            }
+        }
+
+        private fun decodeDoubleValue(): Double {
+            return when (val tag = buffer.get()) {
+                TAG_INT -> decodeIntValue().toDouble()
+                TAG_DOUBLE -> buffer.double
+                else -> throw SerializationException("Unexpected payload tag $tag for a number")
+            }
+        }
+
+        private fun decodeIntValue(): Int {
+            val zigzag = PayloadCodec.readVarint(buffer)
+            return (zigzag ushr 1) xor -(zigzag and 1)
+        }
+
+        private fun skipValue() {
+            when (val tag = buffer.get()) {
+                TAG_NULL, TAG_FALSE, TAG_TRUE -> Unit
+                TAG_INT -> PayloadCodec.readVarint(buffer)
+                TAG_DOUBLE -> buffer.position(buffer.position() + 8)
+                TAG_LATIN1_STRING, TAG_UTF8_STRING -> {
+                    val byteLength = PayloadCodec.readVarint(buffer)
+                    buffer.position(buffer.position() + byteLength)
+                }
+                TAG_ARRAY -> repeat(buffer.int) { skipValue() }
+                TAG_OBJECT -> repeat(buffer.int) {
+                    skipValue()  // key
+                    skipValue()  // value
+                }
+                else -> throw SerializationException("Invalid payload tag: $tag")
+            }
+        }
+    }
+}
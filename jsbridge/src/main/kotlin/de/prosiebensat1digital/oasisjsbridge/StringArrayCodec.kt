@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+// Bulk transfer of String arrays and List<String> values between JS and Java (QuickJS only, see
+// java-types/String.h): the UTF-16 chars of all the strings are packed into a single CharArray
+// together with their lengths (-1 for null), so that the native code only needs one region copy
+// and one call instead of a JNI string allocation or read per element.
+internal object StringArrayCodec {
+    // Create a String[] (or, if asList is set, an ArrayList) from the given packed strings
+    @JvmStatic
+    fun decode(chars: CharArray, lengths: IntArray, asList: Boolean): Any {
+        val strings = arrayOfNulls<String>(lengths.size)
+        var offset = 0
+        for (i in lengths.indices) {
+            val length = lengths[i]
+            if (length >= 0) {
+                strings[i] = String(chars, offset, length)
+                offset += length
+            }
+        }
+
+        return if (asList) ArrayList(strings.asList()) else strings
+    }
+
+    // Pack the given strings (String[] or Object[] of a List<String>) and write their lengths
+    @JvmStatic
+    fun encode(strings: Array<Any?>, lengths: IntArray): CharArray {
+        var totalLength = 0
+        for (i in strings.indices) {
+            val length = (strings[i] as String?)?.length ?: -1
+            lengths[i] = length
+            totalLength += maxOf(length, 0)
+        }
+
+        val chars = CharArray(totalLength)
+        var offset = 0
+        for (element in strings) {
+            val string = element as String? ?: continue
+            string.toCharArray(chars, offset)
+            offset += string.length
+        }
+        return chars
+    }
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge.extensions
+
+import android.content.Context
+import de.prosiebensat1digital.oasisjsbridge.*
+import java.nio.ByteBuffer
+import java.nio.charset.Charset
+import java.util.*
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.atomic.AtomicInteger
+import kotlinx.coroutines.Deferred
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.async
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+import okhttp3.*
+import okhttp3.HttpUrl.Companion.toHttpUrlOrNull
+import okhttp3.MediaType.Companion.toMediaTypeOrNull
+import okhttp3.RequestBody.Companion.toRequestBody
+import timber.log.Timber
+
+// Bodies with a known length up to this size are read with the headers
+private const val MAX_EAGER_BODY_SIZE = 64 * 1024L
+
+// Support for fetch() with Headers and Response (see fetch.js)
+//
+// The OkHttp responses are kept open until their body is consumed: reading it via
+// Response.text(), .json() or .arrayBuffer() streams it into a native buffer which is converted
+// by the JS engine, without any Java String. The fetch() and body promises are directly resolved
+// from Kotlin Deferred values.
+//
+// As many scripts only check the status or the headers, small bodies are directly read so that
+// their connection is released, and unread bodies are released after
+// FetchConfig.unreadBodyTimeoutMs.
+internal class FetchExtension(
+    private val context: Context,
+    private val jsBridge: JsBridge,
+    val config: JsBridgeConfig.FetchConfig,
+    defaultOkHttpClient: OkHttpClient?
+) {
+    private val okHttpClient = config.okHttpClient ?: defaultOkHttpClient ?: OkHttpClient.Builder().build()
+
+    // Bodies which have not been consumed yet
+    private val pendingBodies = ConcurrentHashMap<Int, PendingBody>()
+    private val lastResponseId = AtomicInteger(0)
+
+    private sealed class PendingBody {
+        class Open(val response: Response) : PendingBody()
+        class Buffered(val buffer: ByteBuffer, val charset: Charset?) : PendingBody()
+
+        fun close() {
+            if (this is Open) response.close()
+        }
+    }
+
+    init {
+        JsValue.createJsToJavaProxyFunction5(jsBridge, ::javaFetch)
+            .assignToGlobal("FetchExtension_fetch_java")
+        JsValue.createJsToJavaProxyFunction2(jsBridge, ::javaReadBody)
+            .assignToGlobal("FetchExtension_readBody_java")
+
+        jsBridge.evaluateBuiltInAssetUnsync(context, "js/fetch.js")
+    }
+
+    fun release() {
+        pendingBodies.values.forEach { it.close() }
+        pendingBodies.clear()
+    }
+
+    // Resolved with [responseId, status, statusText, url, rawHeaders, redirected] once the response
+    // headers have been received (the body is read later by javaReadBody())
+    private fun javaFetch(
+        httpMethod: String,
+        url: String,
+        headers: Array<String>,  // [key1, value1, key2, value2, ...]
+        body: String?,
+        binaryBody: ByteArray?
+    ): Deferred<Array<Any>> {
+        Timber.v("javaFetch($httpMethod, $url, ${headers.contentToString()})")
+
+        return jsBridge.async(Dispatchers.IO) {
+            val method = httpMethod.uppercase(Locale.ROOT)
+            val httpUrl = url.toHttpUrlOrNull() ?: throw Throwable("Cannot parse URL: $url")
+
+            val requestHeadersBuilder = Headers.Builder()
+            for (i in 0 until headers.size / 2) {
+                requestHeadersBuilder.add(headers[2 * i], headers[2 * i + 1])
+            }
+            if (requestHeadersBuilder["user-agent"] == null) {
+                config.userAgent?.let { requestHeadersBuilder.add("User-Agent", it) }
+            }
+            val requestHeaders = requestHeadersBuilder.build()
+
+            val mediaType = requestHeaders["content-type"]?.toMediaTypeOrNull()
+            val requestBody = when {
+                binaryBody != null -> binaryBody.toRequestBody(mediaType)
+                body != null -> body.toRequestBody(mediaType)
+                // OkHttp requires a request body for these methods
+                method in listOf("POST", "PUT", "PATCH") -> "".toRequestBody(mediaType)
+                else -> null
+            }
+
+            val request = Request.Builder()
+                .url(httpUrl)
+                .headers(requestHeaders)
+                .method(method, requestBody)
+                .build()
+
+            Timber.d("Performing fetch request ($method $url)...")
+            val response = okHttpClient.newCall(request).execute()
+
+            // Raw response headers ("key: value\r\n" lines with lowercase keys)
+            val rawHeaders = buildString {
+                response.headers.forEach { (key, value) ->
+                    append(key.lowercase(Locale.ROOT)).append(": ").append(value).append("\r\n")
+                }
+            }
+
+            // Empty bodies (responseId 0) are not kept so that the connection is directly released
+            val contentLength = response.body?.contentLength() ?: 0L
+            val responseId = if (method == "HEAD" || contentLength == 0L) {
+                response.close()
+                0
+            } else {
+                val pendingBody = if (contentLength in 1..MAX_EAGER_BODY_SIZE) {
+                    val charset = response.body?.contentType()?.charset()
+                    PendingBody.Buffered(response.use { readResponseBody(it.body) }, charset)
+                } else {
+                    PendingBody.Open(response)
+                }
+                lastResponseId.incrementAndGet().also {
+                    pendingBodies[it] = pendingBody
+                    scheduleUnreadBodyRelease(it)
+                }
+            }
+
+            val redirected = response.priorResponse != null
+            arrayOf<Any>(responseId, response.code, response.message, response.request.url.toString(), rawHeaders, redirected)
+        }
+    }
+
+    private fun scheduleUnreadBodyRelease(responseId: Int) {
+        val timeoutMs = config.unreadBodyTimeoutMs
+        if (timeoutMs <= 0) return
+
+        jsBridge.launch(Dispatchers.IO) {
+            delay(timeoutMs)
+            pendingBodies.remove(responseId)?.let {
+                Timber.d("Releasing unread fetch response body (responseId = $responseId)")
+                it.close()
+            }
+        }
+    }
+
+    // Stream the body of the given response and convert it according to the given type
+    // ("arraybuffer", "json" or "text")
+    private fun javaReadBody(responseId: Int, type: String): Deferred<JsValue> {
+        val pendingBody = pendingBodies.remove(responseId)
+
+        return jsBridge.async(Dispatchers.IO) {
+            pendingBody ?: throw Throwable("The response body is not available anymore (not read within ${config.unreadBodyTimeoutMs} ms)")
+
+            val (bodyBuffer, charset) = when (pendingBody) {
+                is PendingBody.Buffered -> pendingBody.buffer to pendingBody.charset
+                is PendingBody.Open -> {
+                    val response = pendingBody.response
+                    val charset = response.body?.contentType()?.charset()
+                    response.use { readResponseBody(it.body) } to charset
+                }
+            }
+            val jsValue = jsBridge.newJsValueFromResponseBody(bodyBuffer, type, charset)
+            jsValue.codeEvaluationDeferred?.await()
+            jsValue
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge.extensions
+
+import de.prosiebensat1digital.oasisjsbridge.*
+import java.nio.ByteBuffer
+import java.nio.charset.Charset
+import okhttp3.ResponseBody
+
+// Response body helpers shared by the XMLHttpRequest and fetch extensions
+
+private const val READ_BUFFER_SIZE = 16 * 1024
+
+// Read the whole body segment by segment into a direct buffer followed by a zero byte (see
+// JsValue.fromJson()) and call onRead() with the number of bytes loaded so far after each segment
+// Note: the body is not closed
+internal fun readResponseBody(body: ResponseBody?, onRead: ((loaded: Long) -> Unit)? = null): ByteBuffer {
+    body ?: return ByteBuffer.allocateDirect(1).apply { limit(0) }
+
+    val contentLength = body.contentLength()
+    val initialCapacity = if (contentLength >= 0 && contentLength < Int.MAX_VALUE) contentLength.toInt() + 1 else READ_BUFFER_SIZE
+    var buffer = ByteBuffer.allocateDirect(initialCapacity)
+    val source = body.source()
+
+    while (true) {
+        if (buffer.remaining() <= 1) {
+            // Only grow the buffer if there is more data (e.g. unknown or wrong Content-Length)
+            if (source.exhausted()) break
+
+            buffer.flip()
+            buffer = ByteBuffer.allocateDirect(maxOf(buffer.capacity() * 2, READ_BUFFER_SIZE)).put(buffer)
+        }
+
+        // Keep the last byte for the zero terminator
+        buffer.limit(buffer.capacity() - 1)
+        val readCount = source.read(buffer)
+        buffer.limit(buffer.capacity())
+        if (readCount < 0) break
+
+        onRead?.invoke(buffer.position().toLong())
+    }
+
+    buffer.flip()
+    return buffer
+}
+
+// Convert a body read via readResponseBody() into a JsValue without any Java String (unless the
+// text is not encoded in UTF-8):
+// - "arraybuffer": ArrayBuffer (sharing the buffer memory on QuickJS)
+// - "json": parsed JSON
+// - otherwise: decoded string
+//
+// The text is decoded with the charset of its BOM or with the given charset (UTF-8 by default),
+// as ResponseBody.string().
+//
+// Note: the buffer must not be used afterwards
+internal fun JsBridge.newJsValueFromResponseBody(bodyBuffer: ByteBuffer, responseType: String, charset: Charset? = null): JsValue {
+    return when (responseType) {
+        "arraybuffer" -> newJsValueFromDirectBuffer(bodyBuffer, false)
+        "json" -> parseJsonBuffer(toUtf8Body(bodyBuffer, charset))
+        else -> newJsValueFromDirectBuffer(toUtf8Body(bodyBuffer, charset), true)
+    }
+}
+
+// Skip the BOM of the body and return it as it is if it is encoded in UTF-8, otherwise decode it
+// into a new (zero-terminated) UTF-8 direct buffer
+private fun toUtf8Body(bodyBuffer: ByteBuffer, charset: Charset?): ByteBuffer {
+    val bodyCharset = skipBom(bodyBuffer) ?: charset ?: Charsets.UTF_8
+    if (bodyCharset == Charsets.UTF_8) return bodyBuffer
+
+    val utf8Bytes = bodyCharset.decode(bodyBuffer).toString().toByteArray(Charsets.UTF_8)
+    return ByteBuffer.allocateDirect(utf8Bytes.size + 1).put(utf8Bytes).apply { flip() }
+}
+
+// Skip the byte order mark at the position of the buffer (if any) and return its charset
+private fun skipBom(buffer: ByteBuffer): Charset? {
+    fun startsWith(vararg bytes: Int) = buffer.remaining() >= bytes.size
+            && bytes.indices.all { buffer.get(buffer.position() + it) == bytes[it].toByte() }
+
+    // UTF-32LE before UTF-16LE (same first 2 bytes)
+    val (bomCharset, bomSize) = when {
+        startsWith(0xEF, 0xBB, 0xBF) -> Charsets.UTF_8 to 3
+        startsWith(0x00, 0x00, 0xFE, 0xFF) -> Charsets.UTF_32BE to 4
+        startsWith(0xFF, 0xFE, 0x00, 0x00) -> Charsets.UTF_32LE to 4
+        startsWith(0xFE, 0xFF) -> Charsets.UTF_16BE to 2
+        startsWith(0xFF, 0xFE) -> Charsets.UTF_16LE to 2
+        else -> return null
+    }
+
+    buffer.position(buffer.position() + bomSize)
+    return bomCharset
+}
@@ -13,10 +13,13 @@ interface LocalStorageInteface : JsToJavaInterface {
     fun clear()
 }
 
+// SharedPreferences-based storage with JSON keys and values
+// Note: the localStorage extension now uses a native storage (see LocalStorageExtension) which
+// migrates these items
 class LocalStorage(context: Context, namespace: String) : LocalStorageInteface {
 
     private val localStoragePreferences = context.getSharedPreferences(
-        "${namespace.takeIf { it.isNotEmpty() } ?: "default"}.LOCAL_STORAGE_PREFERENCES",
+        preferencesName(namespace.takeIf { it.isNotEmpty() } ?: "default"),
         Context.MODE_PRIVATE
     )
 
@@ -53,4 +56,8 @@ class LocalStorage(context: Context, namespace: String) : LocalStorageInteface {
             commit()
         }
     }
+
+    internal companion object {
+        fun preferencesName(namespace: String) = "$namespace.LOCAL_STORAGE_PREFERENCES"
+    }
 }
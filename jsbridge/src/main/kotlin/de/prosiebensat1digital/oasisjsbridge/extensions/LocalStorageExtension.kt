@@ -18,8 +18,17 @@ package de.prosiebensat1digital.oasisjsbridge.extensions
 import android.content.Context
 import de.prosiebensat1digital.oasisjsbridge.JsBridge
 import de.prosiebensat1digital.oasisjsbridge.JsBridgeConfig
-import de.prosiebensat1digital.oasisjsbridge.JsValue
+import java.io.File
+import kotlinx.coroutines.launch
+import org.json.JSONTokener
+import timber.log.Timber
 
+// Native localStorage: the items are stored as strings in a native hash map which is persisted in
+// an append-only memory-mapped log (one file per namespace). The JS methods are native functions
+// so that accessing an item does not involve any Java call.
+//
+// The items of the former SharedPreferences-based storage (see LocalStorage) are migrated when
+// the log file of the namespace does not exist yet.
 internal class LocalStorageExtension(
     jsBridge: JsBridge,
     config: JsBridgeConfig.LocalStorageConfig,
@@ -27,9 +36,39 @@ internal class LocalStorageExtension(
 ) {
 
     init {
-        val localStorage: LocalStorageInteface = LocalStorage(context, config.namespace)
-        val localStorageJsValue = JsValue.createJsToJavaProxy(jsBridge, localStorage)
-        localStorageJsValue.assignToGlobal("localStorage")
+        val namespace = config.namespace.takeIf { it.isNotEmpty() } ?: "default"
+
+        // JS thread: file I/O
+        jsBridge.launch {
+            val directory = File(context.filesDir, LOCAL_STORAGE_DIRECTORY)
+            val file = File(directory, "$namespace.log")
+            val migratedItems = if (file.exists()) emptyMap() else readPreferencesItems(context, namespace)
+            directory.mkdirs()
+
+            jsBridge.enableLocalStorage(file, migratedItems)
+        }
     }
-}
 
+    // Items of the SharedPreferences storage whose keys and values were stored as JSON
+    private fun readPreferencesItems(context: Context, namespace: String): Map<String, String> {
+        val preferences = context.getSharedPreferences(LocalStorage.preferencesName(namespace), Context.MODE_PRIVATE)
+
+        return preferences.all.mapNotNull { (jsonKey, jsonValue) ->
+            try {
+                val key = JSONTokener(jsonKey).nextValue() as? String ?: return@mapNotNull null
+                val value = (jsonValue as? String)?.let { json ->
+                    // Non-string values are kept as JSON
+                    JSONTokener(json).nextValue() as? String ?: json
+                } ?: return@mapNotNull null
+                key to value
+            } catch (t: Throwable) {
+                Timber.w("Cannot migrate local storage item $jsonKey: $t")
+                null
+            }
+        }.toMap()
+    }
+
+    companion object {
+        private const val LOCAL_STORAGE_DIRECTORY = "jsbridge-localstorage"
+    }
+}
@@ -15,94 +15,50 @@
  */
 package de.prosiebensat1digital.oasisjsbridge.extensions
 
+import android.content.Context
 import de.prosiebensat1digital.oasisjsbridge.*
+import kotlinx.coroutines.Job
 import kotlinx.coroutines.delay
 import kotlinx.coroutines.launch
 import timber.log.Timber
 
 // Support for setTimeout() and setInterval()
-internal class SetTimeoutExtension(private val jsBridge: JsBridge) {
-    private val setTimeoutHelperJs: JsValue
-    private val activeTimers = mutableSetOf<String>()
-    private var timerCounter = 0
+//
+// The timers are managed in JS (see timers.js) which runs all the due callbacks at once: there is
+// a single pending wake-up for the next deadline and the promise queue is processed once per slice.
+internal class SetTimeoutExtension(private val context: Context, private val jsBridge: JsBridge) {
+    private var runDueTimersJs: (() -> Unit)? = null
+    private var wakeUpJob: Job? = null
 
     init {
-        setTimeoutHelperJs = JsValue.createJsToJavaProxyFunction3(jsBridge, ::setTimeoutHelper)
+        JsValue.createJsToJavaProxyFunction1(jsBridge) { runDueTimers: () -> Unit -> runDueTimersJs = runDueTimers }
+            .assignToGlobal("SetTimeoutExtension_init_java")
+        JsValue.createJsToJavaProxyFunction1(jsBridge) { delayMs: Long -> scheduleWakeUp(delayMs) }
+            .assignToGlobal("SetTimeoutExtension_schedule_java")
 
-        // As setTimeout(cb, ms, args...) can also receive arguments passed to the given callback,
-        // we need to convert them to an array and wrap the callback lambda
-        JsValue.newFunction(jsBridge, "cb", "msecs", """
-            // undefined, null and wrong variable type (e.g. string) are valid values for timeout == no delay
-            // "1000" string is converted into a number
-            const TIMEOUT_MAX = 2 ** 31 - 1;
-            msecs *= 1; // Coalesce to number or NaN
-            if (!(msecs >= 1 && msecs <= TIMEOUT_MAX)) {
-                msecs = 0;
-            }
-            var argArray = [].slice.call(arguments, 2);
-            var cbWrapper = function() {
-              cb.apply(null, argArray);
-            };
-            return $setTimeoutHelperJs(cbWrapper, msecs, false);
-        """.trimIndent())
-            .assignToGlobal("setTimeout")
-
-        JsValue.createJsToJavaProxyFunction1(jsBridge) { id: String? -> clearTimeoutHelper(id) }
-            .assignToGlobal("clearTimeout")
-
-        // Same as for setTimeout but with setTimeoutHelper repeat parameter set to true
-        JsValue.newFunction(jsBridge, "cb", "msecs", """
-            // undefined, null and wrong variable type (e.g. string) are valid values for timeout == no delay
-            // "1000" string is converted into a number
-            const TIMEOUT_MAX = 2 ** 31 - 1;
-            msecs *= 1; // Coalesce to number or NaN
-            if (!(msecs >= 1 && msecs <= TIMEOUT_MAX)) {
-                msecs = 0;
-            }
-            var argArray = [].slice.call(arguments, 2);
-            var cbWrapper = function() {
-              cb.apply(null, argArray);
-            };
-            return $setTimeoutHelperJs(cbWrapper, msecs, true);
-        """.trimIndent())
-            .assignToGlobal("setInterval")
-
-        JsValue.createJsToJavaProxyFunction1(jsBridge) { id: String? -> clearTimeoutHelper(id) }
-            .assignToGlobal("clearInterval")
+        jsBridge.evaluateBuiltInAssetUnsync(context, "js/timers.js")
     }
 
-    fun release() = Unit
-
-    private fun setTimeoutHelper(cb: () -> Unit, msecs: Long, repeat: Boolean): String {
-        val id = "timerId${timerCounter++}"
-        activeTimers.add(id)
+    fun release() {
+        wakeUpJob?.cancel()
+        wakeUpJob = null
+        runDueTimersJs = null
+    }
 
-        jsBridge.launch {
-            do {
-                delay(msecs)
+    // Called in the JS thread when the next deadline is earlier than the scheduled one
+    private fun scheduleWakeUp(delayMs: Long) {
+        wakeUpJob?.cancel()
+        wakeUpJob = jsBridge.launch {
+            delay(delayMs)
+            wakeUpJob = null
 
-                if (!activeTimers.contains(id)) {
-                    Timber.d("setTimeoutHelper($msecs, $repeat) - id = $id - callback not executed because the timeout was cancelled!")
-                    return@launch
-                }
-                if (!repeat) {
-                    activeTimers.remove(id)
-                }
-                try {
-                    cb()
-                    jsBridge.processPromiseQueue()
-                } catch (t: Throwable) {
-                    Timber.e("Error while calling setTimeout JS callback: $t")
-                    jsBridge.notifyErrorListeners(JsBridgeError.JsCallbackError(t))
-                }
-            } while (repeat)
+            try {
+                runDueTimersJs?.invoke()
+                jsBridge.processPromiseQueue()
+            } catch (t: Throwable) {
+                Timber.e("Error while calling setTimeout JS callback: $t")
+                jsBridge.notifyErrorListeners(JsBridgeError.JsCallbackError(t))
+            }
         }
-
-        return id
-    }
-
-    private fun clearTimeoutHelper(id: String?) {
-        id?.let { activeTimers.remove(id) }
     }
 }
-
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge.extensions
+
+import android.content.Context
+import de.prosiebensat1digital.oasisjsbridge.*
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.atomic.AtomicInteger
+import kotlinx.coroutines.launch
+import timber.log.Timber
+
+// Support for Web Workers: each Worker runs its script in a sibling JsBridge instance with its own
+// JS thread and JS context. Messages are posted in both directions as native structured clones
+// (see JsBridge.postMessage()) so that they never go through JSON or Kotlin strings.
+//
+// Note: only supported on QuickJS
+internal class WorkerExtension(
+    private val context: Context,
+    private val jsBridge: JsBridge,
+    private val config: JsBridgeConfig.WorkerConfig,
+    private val consoleConfig: JsBridgeConfig.ConsoleConfig
+) {
+    private class Worker(val jsBridge: JsBridge, val onMessage: (JsValue) -> Unit, val onError: (String) -> Unit)
+
+    private val workers = ConcurrentHashMap<String, Worker>()
+    private val workerCounter = AtomicInteger(0)
+
+    init {
+        JsValue.createJsToJavaProxyFunction3(jsBridge, ::createWorker)
+            .assignToGlobal("WorkerExtension_create_java")
+        JsValue.createJsToJavaProxyFunction2(jsBridge) { id: String, data: JsValue -> postMessageToWorker(id, data) }
+            .assignToGlobal("WorkerExtension_postMessage_java")
+        JsValue.createJsToJavaProxyFunction1(jsBridge) { id: String -> terminateWorker(id) }
+            .assignToGlobal("WorkerExtension_terminate_java")
+
+        jsBridge.evaluateBuiltInAssetUnsync(context, "js/worker.js")
+    }
+
+    fun release() {
+        workers.keys.forEach(::terminateWorker)
+    }
+
+    private fun createWorker(url: String, onMessage: (JsValue) -> Unit, onError: (String) -> Unit): String {
+        val id = "worker${workerCounter.incrementAndGet()}"
+
+        val workerJsBridge = JsBridge(createWorkerJsBridgeConfig(), context)
+        val worker = Worker(workerJsBridge, onMessage, onError)
+        workers[id] = worker
+
+        // Worker global scope
+        JsValue.createJsToJavaProxyFunction1(workerJsBridge) { data: JsValue -> postMessageToParent(id, data) }
+            .assignToGlobal("WorkerScope_postMessage_java")
+        JsValue.createJsToJavaProxyFunction0(workerJsBridge) { terminateWorker(id) }
+            .assignToGlobal("WorkerScope_close_java")
+        workerJsBridge.evaluateBuiltInAssetUnsync(context, "js/worker_scope.js")
+
+        // The script is evaluated in the worker thread before any posted message
+        workerJsBridge.launch {
+            try {
+                val script = config.scriptLoader?.invoke(url) ?: readAsset(url)
+                workerJsBridge.evaluateFileContent(script, url)
+            } catch (t: Throwable) {
+                Timber.e(t, "Error while evaluating Worker script $url")
+                notifyError(worker, t)
+            }
+        }
+
+        return id
+    }
+
+    // Called in the parent JS thread
+    private fun postMessageToWorker(id: String, data: JsValue) {
+        val worker = workers[id] ?: return
+        val message = jsBridge.createMessageInJsThread(data)
+
+        worker.jsBridge.launch {
+            try {
+                val workerData = worker.jsBridge.receiveMessage(message)
+                worker.jsBridge.evaluate<Unit>("WorkerScope_dispatchMessage($workerData)")
+                workerData.release()
+            } catch (t: Throwable) {
+                Timber.e(t, "Error while dispatching a message to Worker $id")
+                notifyError(worker, t)
+            } finally {
+                message.release()
+            }
+        }
+    }
+
+    // Called in the worker JS thread
+    private fun postMessageToParent(id: String, data: JsValue) {
+        val worker = workers[id] ?: return
+        val message = worker.jsBridge.createMessageInJsThread(data)
+
+        jsBridge.launch {
+            try {
+                val parentData = jsBridge.receiveMessage(message)
+                worker.onMessage(parentData)
+                jsBridge.processPromiseQueue()
+            } catch (t: Throwable) {
+                Timber.e(t, "Error while dispatching a message from Worker $id")
+                jsBridge.notifyErrorListeners(JsBridgeError.JsCallbackError(t))
+            } finally {
+                message.release()
+            }
+        }
+    }
+
+    private fun terminateWorker(id: String) {
+        val worker = workers.remove(id) ?: return
+        worker.jsBridge.release()
+    }
+
+    private fun notifyError(worker: Worker, t: Throwable) {
+        val errorMessage = (t.cause ?: t).message ?: t.toString()
+        jsBridge.launch {
+            try {
+                worker.onError(errorMessage)
+                jsBridge.processPromiseQueue()
+            } catch (e: Throwable) {
+                jsBridge.notifyErrorListeners(JsBridgeError.JsCallbackError(e))
+            }
+        }
+    }
+
+    // Workers get the basic extensions (without Workers, XHR and local storage)
+    private fun createWorkerJsBridgeConfig() = JsBridgeConfig.bareConfig().apply {
+        setTimeoutConfig.enabled = true
+        promiseConfig.enabled = true
+        consoleConfig.enabled = this@WorkerExtension.consoleConfig.enabled
+        consoleConfig.mode = this@WorkerExtension.consoleConfig.mode
+        consoleConfig.minPriority = this@WorkerExtension.consoleConfig.minPriority
+        consoleConfig.appendMessage = this@WorkerExtension.consoleConfig.appendMessage
+    }
+
+    private fun readAsset(path: String) = context.assets.open(path)
+        .bufferedReader()
+        .use { it.readText() }
+}
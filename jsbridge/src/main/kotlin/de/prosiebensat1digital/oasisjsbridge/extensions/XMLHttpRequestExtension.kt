@@ -20,6 +20,7 @@ import de.prosiebensat1digital.oasisjsbridge.*
 import java.net.SocketTimeoutException
 import java.util.*
 import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicBoolean
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
@@ -38,14 +39,11 @@ internal class XMLHttpRequestExtension(
 
     init {
         // Register XMLHttpRequestJavaHelper_send()
-        JsValue.createJsToJavaProxyFunction6(jsBridge, ::javaSend)
+        JsValue.createJsToJavaProxyFunction9(jsBridge, ::javaSend)
             .assignToGlobal("XMLHttpRequestExtension_send_java")
 
         // Evaluate JS file
-        val jsCode = context.assets.open("js/xhr.js")
-            .bufferedReader()
-            .use { it.readText() }
-        jsBridge.evaluateUnsync(jsCode)
+        jsBridge.evaluateBuiltInAssetUnsync(context, "js/xhr.js")
     }
 
     fun release() {
@@ -55,18 +53,22 @@ internal class XMLHttpRequestExtension(
     private fun javaSend(
         httpMethod: String,
         url: String,
-        headers: JsonObjectWrapper,
+        headers: Array<String>,  // [key1, value1, key2, value2, ...]
         timeoutMs: Long,
         data: String?,
-        cb: (JsonObjectWrapper, String, String) -> Unit
+        responseType: String,
+        headersCb: (Int, String, String) -> Unit,
+        progressCb: (Long, Long) -> Unit,
+        cb: (JsValue?, String) -> Unit
     ) {
-        Timber.v("javaSend($httpMethod, $url, $headers, $timeoutMs)")
+        Timber.v("javaSend($httpMethod, $url, ${headers.contentToString()}, $timeoutMs, $responseType)")
 
         jsBridge.launch(Dispatchers.IO) {
-            // Load URL and evaluate JS string
-            var responseInfo: JsonObjectWrapper? = null
+            val isProgressPending = AtomicBoolean(false)
+
+            // Load URL and convert the response body
+            var responseValue: JsValue? = null
             var errorString: String? = null
-            var responseText: String? = null
             try {
                 // Validate HTTP method
                 when (httpMethod.lowercase(Locale.ROOT)) {
@@ -76,19 +78,9 @@ internal class XMLHttpRequestExtension(
 
                 val requestHeadersBuilder = Headers.Builder()
 
-                // Add each request header (given as [key, value] arrays)
-                val headersPayload = headers.toPayload() as? PayloadArray
-                if (headersPayload != null) {
-                    for (i in 0 until headersPayload.count) {
-                        val keyValue = headersPayload.getArray(i)
-                        val key = keyValue?.getString(0)
-                        val value = keyValue?.getString(1)
-                        if (key != null && value != null) {
-                            requestHeadersBuilder.add(key, value)
-                        } else {
-                            Timber.w("Invalid header keyValue: $keyValue")
-                        }
-                    }
+                // Add each request header
+                for (i in 0 until headers.size / 2) {
+                    requestHeadersBuilder.add(headers[2 * i], headers[2 * i + 1])
                 }
 
                 // Add user agent header if not set
@@ -121,36 +113,30 @@ internal class XMLHttpRequestExtension(
                     .headers(requestHeaders)
                     .method(httpMethod.uppercase(Locale.ROOT), requestBody)
                     .build()
-                val response = okHttpClient
+                okHttpClient
                     .newBuilder()
                     .callTimeout(timeoutMs, TimeUnit.MILLISECONDS)
                     .build()
                     .newCall(request)
                     .execute()
-
-                // Convert header mutlimap (key -> [value1, value2, ...]) into a list of [key, value] arrays
-                val headerKeyValues = response
-                    .headers
-                    .toMultimap()
-                    .flatMap { (key, values) ->
-                        values
-                            .map { value ->
-                                arrayOf(
-                                    key,
-                                    value.replace("""([^\])"""", """$1\"""")
-                                )
+                    .use { response ->
+                        // Raw response headers ("key: value\r\n" lines with lowercase keys) which
+                        // are directly given to JS without any JSON encoding
+                        val rawHeaders = buildString {
+                            response.headers.forEach { (key, value) ->
+                                append(key.lowercase(Locale.ROOT)).append(": ").append(value).append("\r\n")
                             }
-                    }
+                        }
+                        jsBridge.launch { headersCb(response.code, response.message, rawHeaders) }
 
-                responseInfo = JsonObjectWrapper(
-                    "statusCode" to response.code,
-                    "statusText" to response.message,
-                    "responseHeaders" to headerKeyValues.toTypedArray()
-                )
-                responseText = response.body?.string()
+                        val total = response.body?.contentLength() ?: -1L
+                        val bodyBuffer = readResponseBody(response.body) { loaded ->
+                            notifyProgress(loaded, total, progressCb, isProgressPending)
+                        }
+                        responseValue = jsBridge.newJsValueFromResponseBody(bodyBuffer, responseType, response.body?.contentType()?.charset())
+                    }
 
                 Timber.d("Successfully fetched XHR response (query: $url)")
-                Timber.v("-> responseInfo = $responseInfo")
                 Timber.v("-> request headers = $requestHeaders")
             } catch (e: SocketTimeoutException) {
                 Timber.d("XHR timeout ($httpMethod $url): $e")
@@ -160,14 +146,33 @@ internal class XMLHttpRequestExtension(
                 errorString = t.message ?: "unknown XHR error"
             }
 
-            cb(responseInfo ?: JsonObjectWrapper(), responseText ?: "", errorString ?: "")
-
             withContext(jsBridge.coroutineContext) {
+                try {
+                    responseValue?.codeEvaluationDeferred?.await()
+                } catch (t: Throwable) {
+                    Timber.d("XHR response conversion error ($httpMethod $url): $t")
+                    responseValue = null
+                    errorString = if (responseType == "json") "Could not parse JSON response" else (t.message ?: "unknown XHR error")
+                }
+
+                cb(responseValue, errorString ?: "")
                 jsBridge.processPromiseQueue()
             }
         }
     }
 
+    // Post the progress to the JS thread unless the previous notification is still pending
+    private fun notifyProgress(loaded: Long, total: Long, progressCb: (Long, Long) -> Unit, isProgressPending: AtomicBoolean) {
+        if (!isProgressPending.compareAndSet(false, true)) return
+
+        jsBridge.launch {
+            try {
+                progressCb(loaded, total)
+            } finally {
+                isProgressPending.set(false)
+            }
+        }
+    }
 }
 
 
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import org.junit.Test
+import kotlin.test.*
+
+class JsAllocationStatsTest {
+
+    @Test
+    fun testFromLongArray() {
+        val stats = JsAllocationStats.fromLongArray(longArrayOf(100, 20, 30, 4))
+
+        assertEquals(JsAllocationStats(100, 20, 30, 4), stats)
+    }
+
+    @Test
+    fun testFromEmptyLongArray() {
+        assertNull(JsAllocationStats.fromLongArray(longArrayOf()))
+    }
+
+    @Test
+    fun testMinus() {
+        val before = JsAllocationStats(100, 20, 30, 4)
+        val after = JsAllocationStats(150, 20, 42, 5)
+
+        assertEquals(JsAllocationStats(50, 0, 12, 1), after - before)
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import java.io.File
+import java.nio.file.Files
+import org.junit.After
+import org.junit.Test
+import kotlin.test.*
+
+class JsBytecodeCacheTest {
+
+    private val directory: File = Files.createTempDirectory("jsBytecodeCacheTest").toFile()
+
+    @After
+    fun cleanUp() {
+        directory.deleteRecursively()
+    }
+
+    @Test
+    fun testGetAndPut() {
+        val subject = JsBytecodeCache(directory, "engine-1")
+        val key = subject.getKey("var a = 1;")
+
+        assertNull(subject.get(key))
+
+        subject.put(key, byteArrayOf(1, 2, 3))
+        assertContentEquals(byteArrayOf(1, 2, 3), subject.get(key))
+
+        subject.remove(key)
+        assertNull(subject.get(key))
+    }
+
+    @Test
+    fun testKeyDependsOnSourceAndVersion() {
+        val key = JsBytecodeCache(directory, "engine-1").getKey("var a = 1;")
+
+        assertEquals(key, JsBytecodeCache(directory, "engine-1").getKey("var a = 1;"))
+        assertNotEquals(key, JsBytecodeCache(directory, "engine-1").getKey("var a = 2;"))
+        assertNotEquals(key, JsBytecodeCache(directory, "engine-2").getKey("var a = 1;"))
+    }
+
+    @Test
+    fun testCorruptedEntry() {
+        val subject = JsBytecodeCache(directory, "engine-1")
+        val key = subject.getKey("var a = 1;")
+        subject.put(key, byteArrayOf(1, 2, 3))
+
+        val file = directory.listFiles()!!.single()
+        file.writeBytes(file.readBytes().also { it[it.size - 1] = 4 })
+
+        assertNull(subject.get(key))
+        assertFalse(file.exists())
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import org.junit.Test
+import kotlin.test.*
+
+class JsCallTraceStatsTest {
+
+    @Test
+    fun testFromNativeStats() {
+        val values = longArrayOf(
+            // jniEvaluateString: count, then (total, p50, p90, p99) for each phase
+            3, 3000, 1000, 1200, 1200, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            // JsMethod test
+            1, 500, 500, 500, 500, 100, 100, 100, 100, 300, 300, 300, 300, 0, 0, 0, 0,
+        )
+
+        val stats = JsCallTraceStats.fromNativeStats(arrayOf("jniEvaluateString", "JsMethod test"), values)
+
+        assertEquals(2, stats.size)
+        assertEquals("jniEvaluateString", stats[0].name)
+        assertEquals(3, stats[0].callCount)
+        assertEquals(JsCallTraceStats.PhaseStats(3000, 1000, 1200, 1200), stats[0].total)
+        assertEquals(JsCallTraceStats.PhaseStats(0, 0, 0, 0), stats[0].jsExecution)
+
+        assertEquals("JsMethod test", stats[1].name)
+        assertEquals(1, stats[1].callCount)
+        assertEquals(JsCallTraceStats.PhaseStats(100, 100, 100, 100), stats[1].conversion)
+        assertEquals(JsCallTraceStats.PhaseStats(300, 300, 300, 300), stats[1].jsExecution)
+        assertEquals(JsCallTraceStats.PhaseStats(0, 0, 0, 0), stats[1].jniUpcall)
+    }
+
+    @Test
+    fun testFromEmptyNativeStats() {
+        assertTrue(JsCallTraceStats.fromNativeStats(arrayOf(), longArrayOf()).isEmpty())
+    }
+}
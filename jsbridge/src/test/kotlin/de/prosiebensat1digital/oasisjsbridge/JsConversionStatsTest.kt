@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import org.junit.Test
+import kotlin.test.*
+
+class JsConversionStatsTest {
+
+    @Test
+    fun testFromLongArray() {
+        val values = longArrayOf(
+            // id, JS -> Java count and bytes, Java -> JS count and bytes
+            12, 4, 0, 2, 0,
+            30, 1, 5, 3, 42,
+            62, 0, 0, 1, 40,
+        )
+
+        val stats = JsConversionStats.fromLongArray(values)
+
+        assertEquals(3, stats.size)
+        assertEquals(JsConversionStats(12, "Int", 4, 0, 2, 0), stats[0])
+        assertEquals(JsConversionStats(30, "String", 1, 5, 3, 42), stats[1])
+        assertEquals("IntArray", stats[2].typeName)
+        assertEquals(40, stats[2].javaToJsBytes)
+    }
+
+    @Test
+    fun testUnknownTypeId() {
+        val stats = JsConversionStats.fromLongArray(longArrayOf(999, 1, 0, 0, 0))
+        assertEquals("Unknown", stats.single().typeName)
+    }
+
+    @Test
+    fun testFromEmptyLongArray() {
+        assertTrue(JsConversionStats.fromLongArray(longArrayOf()).isEmpty())
+    }
+}
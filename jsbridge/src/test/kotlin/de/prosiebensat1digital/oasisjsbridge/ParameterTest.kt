@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import kotlinx.coroutines.Deferred
+import org.junit.Test
+import kotlin.reflect.typeOf
+import kotlin.test.*
+
+@OptIn(ExperimentalStdlibApi::class)
+class ParameterTest {
+
+    @Test
+    fun testTypeSignature() {
+        assertEquals("java.lang.String", Parameter(typeOf<String>(), null).typeSignature)
+        assertEquals("java.lang.String?", Parameter(typeOf<String?>(), null).typeSignature)
+        assertEquals("[I", Parameter(typeOf<IntArray>(), null).typeSignature)
+        assertEquals("java.util.List<java.lang.String>", Parameter(typeOf<List<String>>(), null).typeSignature)
+        assertEquals("kotlinx.coroutines.Deferred<int?>", Parameter(typeOf<Deferred<Int?>>(), null).typeSignature)
+        assertEquals("[Ljava.lang.Object;<java.lang.Object>", Parameter(Array<Any>::class.java, null).typeSignature)
+    }
+
+    @Test
+    fun testTypeSignatureOfLambdas() {
+        assertNull(Parameter(typeOf<(Int) -> Unit>(), null).typeSignature)
+        assertNull(Parameter(typeOf<List<() -> Unit>>(), null).typeSignature)
+    }
+}
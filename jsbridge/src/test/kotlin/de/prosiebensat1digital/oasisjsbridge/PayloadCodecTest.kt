@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import org.junit.Test
+import kotlin.test.*
+
+class PayloadCodecTest {
+
+    private fun roundTrip(value: Any?, wrapPrimitives: Boolean = false): Any? {
+        val encoded = PayloadCodec.encode(value)
+        return PayloadCodec.decode(encoded, wrapPrimitives)
+    }
+
+    @Test
+    fun testObjectRoundTrip() {
+        val payloadObject = payloadObjectOf(
+            "int" to 42,
+            "negativeInt" to -7,
+            "double" to 1.5,
+            "string" to "testString",
+            "bool" to true,
+            "null" to null,
+            "array" to listOf(1, "two", null, false),
+            "object" to mapOf("subKey" to "subValue"),
+        )
+
+        val decoded = roundTrip(payloadObject)
+
+        assertEquals(payloadObject, decoded)
+    }
+
+    @Test
+    fun testStrings() {
+        val strings = listOf("", "ascii", "Latin-1: äöüß", "UTF-8: €", "Surrogates: 😀")
+        val decoded = roundTrip(PayloadArray.fromCollection(strings)) as PayloadArray
+
+        assertEquals(strings, decoded.toList())
+    }
+
+    @Test
+    fun testLatin1Encoding() {
+        val encoded = PayloadCodec.encode("é")
+
+        assertEquals(PayloadCodec.TAG_LATIN1_STRING, encoded.get(0))
+        assertEquals(3, encoded.capacity())
+    }
+
+    @Test
+    fun testCesu8Decoding() {
+        // U+1F600 encoded as two separate 3-byte surrogates (Duktape format)
+        val bytes = byteArrayOf(
+            PayloadCodec.TAG_UTF8_STRING, 6,
+            0xED.toByte(), 0xA0.toByte(), 0xBD.toByte(),
+            0xED.toByte(), 0xB8.toByte(), 0x80.toByte(),
+        )
+        val buffer = ByteBuffer.wrap(bytes).order(ByteOrder.LITTLE_ENDIAN)
+
+        assertEquals("😀", PayloadCodec.decode(buffer, false))
+    }
+
+    @Test
+    fun testNumbers() {
+        assertEquals(PayloadCodec.TAG_INT, PayloadCodec.encode(123).get(0))
+        assertEquals(PayloadCodec.TAG_INT, PayloadCodec.encode(Int.MIN_VALUE.toLong()).get(0))
+        assertEquals(PayloadCodec.TAG_DOUBLE, PayloadCodec.encode(Int.MAX_VALUE.toLong() + 1).get(0))
+        assertEquals(PayloadCodec.TAG_DOUBLE, PayloadCodec.encode(2.0).get(0))
+
+        assertEquals(Int.MIN_VALUE, roundTrip(Int.MIN_VALUE))
+        assertEquals(Int.MAX_VALUE, roundTrip(Int.MAX_VALUE))
+        assertEquals(-0.5, roundTrip(-0.5))
+    }
+
+    @Test
+    fun testWrapPrimitives() {
+        assertEquals(PayloadString("test"), roundTrip("test", true))
+        assertEquals(PayloadBoolean(true), roundTrip(true, true))
+        assertTrue(roundTrip(null, true) is PayloadNull)
+    }
+
+    @Test
+    fun testLargePayload() {
+        val strings = List(10000) { "string$it" }
+        val decoded = roundTrip(PayloadArray.fromCollection(strings)) as PayloadArray
+
+        assertEquals(strings, decoded.toList())
+    }
+
+    @Test
+    fun testInvalidValue() {
+        assertFailsWith<IllegalArgumentException> {
+            PayloadCodec.encode(Any())
+        }
+    }
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2019 ProSiebenSat1.Digital GmbH.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package de.prosiebensat1digital.oasisjsbridge
+
+import org.junit.Test
+import kotlin.test.*
+
+class StringArrayCodecTest {
+
+    @Test
+    fun testRoundTrip() {
+        val strings = arrayOf<Any?>("a", null, "", "äöü €", "😀", "last")
+        val lengths = IntArray(strings.size)
+
+        val chars = StringArrayCodec.encode(strings, lengths)
+        assertEquals(listOf(1, -1, 0, 5, 2, 4), lengths.toList())
+        assertEquals("aäöü €😀last", String(chars))
+
+        val decodedArray = StringArrayCodec.decode(chars, lengths, false)
+        assertTrue(decodedArray is Array<*>)
+        assertEquals(String::class.java, decodedArray.javaClass.componentType)
+        assertEquals(strings.toList(), decodedArray.toList())
+
+        val decodedList = StringArrayCodec.decode(chars, lengths, true)
+        assertTrue(decodedList is ArrayList<*>)
+        assertEquals(strings.toList(), decodedList)
+    }
+
+    @Test
+    fun testEmpty() {
+        val chars = StringArrayCodec.encode(emptyArray(), IntArray(0))
+        assertEquals(0, chars.size)
+        assertEquals(0, (StringArrayCodec.decode(chars, IntArray(0), false) as Array<*>).size)
+    }
+
+    @Test
+    fun testInvalidElement() {
+        assertFailsWith<ClassCastException> {
+            StringArrayCodec.encode(arrayOf("a", 1), IntArray(2))
+        }
+    }
+}